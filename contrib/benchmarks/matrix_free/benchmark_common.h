@@ -0,0 +1,571 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+#ifndef dealii_benchmarks_matrix_free_common_h
+#define dealii_benchmarks_matrix_free_common_h
+
+// Infrastructure shared by the matrix-free benchmark programs: parsing of
+// the command line, creation of the meshes, set up of the MatrixFree object,
+// dispatch of the run-time parameters to the compile-time polynomial degree
+// and output of the measurements as one JSON object per line.
+
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/function.h>
+#include <deal.II/base/multithread_info.h>
+#include <deal.II/base/mpi.h>
+#include <deal.II/base/quadrature_lib.h>
+#include <deal.II/base/timer.h>
+#include <deal.II/base/utilities.h>
+#include <deal.II/distributed/tria.h>
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/dofs/dof_tools.h>
+#include <deal.II/fe/fe_q.h>
+#include <deal.II/fe/mapping_q_generic.h>
+#include <deal.II/grid/grid_generator.h>
+#include <deal.II/grid/grid_tools.h>
+#include <deal.II/grid/manifold_lib.h>
+#include <deal.II/grid/tria.h>
+#include <deal.II/lac/constraint_matrix.h>
+#include <deal.II/lac/la_parallel_vector.h>
+#include <deal.II/matrix_free/matrix_free.h>
+#include <deal.II/numerics/vector_tools.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+namespace Benchmarks
+{
+  using namespace dealii;
+
+  /**
+   * The parameters of a benchmark run as given on the command line. Each of
+   * the list-valued options takes a comma-separated list, and the benchmark
+   * programs run all combinations of the given values.
+   */
+  struct Parameters
+  {
+    Parameters ()
+      :
+      n_threads (numbers::invalid_unsigned_int),
+      min_dofs (1000000),
+      n_repetitions (10)
+    {
+      dims.push_back(2);
+      dims.push_back(3);
+      for (unsigned int degree=1; degree<=8; ++degree)
+        degrees.push_back(degree);
+      numbers.push_back("float");
+      numbers.push_back("double");
+      meshes.push_back("affine");
+      meshes.push_back("curved");
+    }
+
+    static void print_usage (std::ostream &out,
+                             const std::string &program_name)
+    {
+      out << "Usage: " << program_name << " [options]" << std::endl
+          << "  --dim <list>          dimensions, subset of 2,3 (default: 2,3)" << std::endl
+          << "  --degree <list>       polynomial degrees, subset of 1..8 (default: 1..8)" << std::endl
+          << "  --number <list>       float and/or double (default: float,double)" << std::endl
+          << "  --mesh <list>         cartesian, affine and/or curved (default: affine,curved)" << std::endl
+          << "  --threads <n>         number of threads per MPI rank (default: all)" << std::endl
+          << "  --min-dofs <n>        minimal global problem size (default: 1000000)" << std::endl
+          << "  --repetitions <n>     number of timed runs per case (default: 10)" << std::endl
+          << "  --output <file>       append the results to this file as well" << std::endl;
+    }
+
+    void parse (int argc, char **argv)
+    {
+      for (int i=1; i<argc; ++i)
+        {
+          const std::string option (argv[i]);
+          if (option == "--help" || option == "-h")
+            {
+              print_usage (std::cout, argv[0]);
+              std::exit (0);
+            }
+          AssertThrow (i+1 < argc,
+                       ExcMessage ("Missing value for option " + option));
+          const std::string value (argv[++i]);
+          if (option == "--dim")
+            dims = to_unsigned_list (value);
+          else if (option == "--degree")
+            degrees = to_unsigned_list (value);
+          else if (option == "--number")
+            numbers = Utilities::split_string_list (value);
+          else if (option == "--mesh")
+            meshes = Utilities::split_string_list (value);
+          else if (option == "--threads")
+            n_threads = Utilities::string_to_int (value);
+          else if (option == "--min-dofs")
+            min_dofs = Utilities::string_to_int (value);
+          else if (option == "--repetitions")
+            n_repetitions = Utilities::string_to_int (value);
+          else if (option == "--output")
+            output_file = value;
+          else
+            AssertThrow (false, ExcMessage ("Unknown option " + option +
+                                            ", see --help for the valid options"));
+        }
+
+      for (unsigned int i=0; i<dims.size(); ++i)
+        AssertThrow (dims[i] == 2 || dims[i] == 3,
+                     ExcMessage ("Only dimensions 2 and 3 are supported"));
+      for (unsigned int i=0; i<degrees.size(); ++i)
+        AssertThrow (degrees[i] >= 1 && degrees[i] <= 8,
+                     ExcMessage ("Only degrees between 1 and 8 are compiled"));
+      for (unsigned int i=0; i<numbers.size(); ++i)
+        AssertThrow (numbers[i] == "float" || numbers[i] == "double",
+                     ExcMessage ("Unknown number type " + numbers[i]));
+      for (unsigned int i=0; i<meshes.size(); ++i)
+        AssertThrow (meshes[i] == "cartesian" || meshes[i] == "affine" ||
+                     meshes[i] == "curved",
+                     ExcMessage ("Unknown mesh type " + meshes[i]));
+      AssertThrow (n_repetitions > 0,
+                   ExcMessage ("At least one repetition is needed"));
+    }
+
+    std::vector<unsigned int> dims;
+    std::vector<unsigned int> degrees;
+    std::vector<std::string>  numbers;
+    std::vector<std::string>  meshes;
+    unsigned int              n_threads;
+    types::global_dof_index   min_dofs;
+    unsigned int              n_repetitions;
+    std::string               output_file;
+
+  private:
+    static std::vector<unsigned int> to_unsigned_list (const std::string &value)
+    {
+      const std::vector<int> list =
+        Utilities::string_to_int (Utilities::split_string_list (value));
+      return std::vector<unsigned int> (list.begin(), list.end());
+    }
+  };
+
+
+
+  /**
+   * The communicator all benchmarks run on.
+   */
+  inline MPI_Comm communicator ()
+  {
+#ifdef DEAL_II_WITH_MPI
+    return MPI_COMM_WORLD;
+#else
+    return MPI_COMM_SELF;
+#endif
+  }
+
+
+
+  template <typename Number> const char *number_name ();
+  template <> inline const char *number_name<float> ()
+  {
+    return "float";
+  }
+  template <> inline const char *number_name<double> ()
+  {
+    return "double";
+  }
+
+
+
+  /**
+   * The triangulation type used by the benchmarks: a distributed
+   * triangulation when deal.II was configured with p4est, a serial one
+   * otherwise. The multigrid hierarchy is always built in order to allow
+   * for the transfer benchmarks.
+   */
+  template <int dim>
+  struct TriangulationSelector
+  {
+#ifdef DEAL_II_WITH_P4EST
+    typedef parallel::distributed::Triangulation<dim> type;
+
+    static type *create ()
+    {
+      return new type (communicator(),
+                       Triangulation<dim>::limit_level_difference_at_vertices,
+                       type::construct_multigrid_hierarchy);
+    }
+#else
+    typedef Triangulation<dim> type;
+
+    static type *create ()
+    {
+      return new type (Triangulation<dim>::limit_level_difference_at_vertices);
+    }
+#endif
+  };
+
+
+
+  /**
+   * Affine transformation applied to the unit cube for the mesh type
+   * 'affine', turning the cells into parallelograms or parallelepipeds
+   * whose Jacobian is constant on each cell but not diagonal.
+   */
+  template <int dim>
+  Point<dim> shear_transform (const Point<dim> &p)
+  {
+    Point<dim> q = p;
+    for (unsigned int d=1; d<dim; ++d)
+      q[0] += 0.2 * p[d];
+    q[dim-1] += 0.1 * p[0];
+    return q;
+  }
+
+
+
+  /**
+   * Collection of the mesh, the continuous finite element of degree
+   * fe_degree and the MatrixFree object for one benchmark case. The meshes
+   * are refined globally until the number of degrees of freedom exceeds the
+   * requested minimal size:
+   * <ul>
+   * <li> 'cartesian': a cube of axis-aligned cells,
+   * <li> 'affine': a sheared cube with a constant, non-diagonal Jacobian on
+   * each cell,
+   * <li> 'curved': a shell with a spherical manifold described by a
+   * high-order mapping of the same degree as the finite element, resulting in
+   * different Jacobians at each quadrature point.
+   * </ul>
+   * Homogeneous Dirichlet conditions are imposed on the whole boundary.
+   */
+  template <int dim, typename Number>
+  class BenchmarkSystem
+  {
+  public:
+    BenchmarkSystem (const unsigned int fe_degree,
+                     const std::string &mesh_type,
+                     const Parameters  &parameters,
+                     const bool         setup_level_dofs = false)
+      :
+      manifold (Point<dim>()),
+      triangulation (TriangulationSelector<dim>::create()),
+      mapping (mesh_type == "curved" ? fe_degree : 1),
+      fe (fe_degree),
+      dof_handler (*triangulation)
+    {
+      if (mesh_type == "curved")
+        {
+          GridGenerator::hyper_shell (*triangulation, Point<dim>(), 0.5, 1.,
+                                      dim == 2 ? 8 : 6);
+          triangulation->set_all_manifold_ids (0);
+          triangulation->set_manifold (0, manifold);
+        }
+      else
+        {
+          GridGenerator::hyper_cube (*triangulation, 0., 1.);
+          if (mesh_type == "affine")
+            GridTools::transform (&shear_transform<dim>, *triangulation);
+        }
+
+      // refine until we reach the requested size, estimating the number of
+      // degrees of freedom from the number of cells to avoid distributing
+      // the degrees of freedom on each intermediate mesh
+      while (static_cast<double>(triangulation->n_global_active_cells()) *
+             Utilities::fixed_power<dim>(static_cast<double>(fe_degree)) <
+             static_cast<double>(parameters.min_dofs))
+        triangulation->refine_global (1);
+
+      dof_handler.distribute_dofs (fe);
+      if (setup_level_dofs)
+        dof_handler.distribute_mg_dofs (fe);
+
+      IndexSet locally_relevant_dofs;
+      DoFTools::extract_locally_relevant_dofs (dof_handler,
+                                               locally_relevant_dofs);
+      constraints.reinit (locally_relevant_dofs);
+      DoFTools::make_hanging_node_constraints (dof_handler, constraints);
+      VectorTools::interpolate_boundary_values (mapping, dof_handler, 0,
+                                                ZeroFunction<dim>(),
+                                                constraints);
+      constraints.close ();
+
+      typename MatrixFree<dim,Number>::AdditionalData additional_data;
+      additional_data.tasks_parallel_scheme =
+        MatrixFree<dim,Number>::AdditionalData::partition_partition;
+      additional_data.mapping_update_flags = update_gradients | update_JxW_values;
+      matrix_free.reset (new MatrixFree<dim,Number>());
+      matrix_free->reinit (mapping, dof_handler, constraints,
+                           QGauss<1>(fe_degree+1), additional_data);
+    }
+
+    /**
+     * Number of bytes of the index and geometry data read by a cell loop
+     * over the whole mesh, i.e., the data transferred from main memory in
+     * addition to the vector entries.
+     */
+    std::size_t cell_loop_data_bytes () const
+    {
+      return matrix_free->get_dof_info().memory_consumption() +
+             matrix_free->get_mapping_info().memory_consumption();
+    }
+
+    // the members are destroyed in reverse order, so the manifold needs to
+    // be declared before the triangulation that holds a pointer to it, and
+    // the triangulation before the DoFHandler
+    SphericalManifold<dim>                                     manifold;
+    std_cxx11::shared_ptr<typename TriangulationSelector<dim>::type> triangulation;
+    MappingQGeneric<dim>                                       mapping;
+    FE_Q<dim>                                                  fe;
+    DoFHandler<dim>                                            dof_handler;
+    ConstraintMatrix                                           constraints;
+    std_cxx11::shared_ptr<MatrixFree<dim,Number> >             matrix_free;
+  };
+
+
+
+  /**
+   * Measured run times of one benchmark case. Every entry is the maximum
+   * over all MPI ranks of one repetition.
+   */
+  class Timings
+  {
+  public:
+    Timings ()
+      :
+      running (false)
+    {}
+
+    void start ()
+    {
+      Assert (!running, ExcInternalError());
+#ifdef DEAL_II_WITH_MPI
+      MPI_Barrier (communicator());
+#endif
+      timer.restart ();
+      running = true;
+    }
+
+    void stop ()
+    {
+      Assert (running, ExcInternalError());
+      timer.stop ();
+      running = false;
+      times.push_back (Utilities::MPI::max (timer.wall_time(), communicator()));
+    }
+
+    double min () const
+    {
+      return *std::min_element (times.begin(), times.end());
+    }
+
+    double average () const
+    {
+      double sum = 0;
+      for (unsigned int i=0; i<times.size(); ++i)
+        sum += times[i];
+      return sum / times.size();
+    }
+
+    unsigned int size () const
+    {
+      return times.size();
+    }
+
+  private:
+    Timer               timer;
+    bool                running;
+    std::vector<double> times;
+  };
+
+
+
+  /**
+   * Print the result of one benchmark case as a single line containing a
+   * JSON object to the standard output and, if requested, append it to the
+   * output file. The throughput is computed from the fastest repetition:
+   * @p n_dofs_processed is the number of degrees of freedom one repetition
+   * works on (counting repeated operator applications), and @p n_bytes an
+   * estimate of the data transferred from main memory in one repetition.
+   */
+  inline void print_result (const Parameters  &parameters,
+                            const std::string &benchmark,
+                            const unsigned int dim,
+                            const unsigned int fe_degree,
+                            const std::string &number,
+                            const std::string &mesh_type,
+                            const types::global_dof_index n_dofs,
+                            const double       n_dofs_processed,
+                            const double       n_bytes,
+                            const Timings     &timings)
+  {
+    if (Utilities::MPI::this_mpi_process (communicator()) != 0)
+      return;
+
+    std::ostringstream line;
+    line << std::setprecision (6)
+         << "{\"benchmark\": \"" << benchmark << "\""
+         << ", \"dim\": " << dim
+         << ", \"degree\": " << fe_degree
+         << ", \"number\": \"" << number << "\""
+         << ", \"mesh\": \"" << mesh_type << "\""
+         << ", \"mpi_ranks\": " << Utilities::MPI::n_mpi_processes (communicator())
+         << ", \"threads\": " << MultithreadInfo::n_threads()
+         << ", \"vectorization\": " << (number == "float" ?
+                                        VectorizedArray<float>::n_array_elements :
+                                        VectorizedArray<double>::n_array_elements)
+         << ", \"n_dofs\": " << n_dofs
+         << ", \"repetitions\": " << timings.size()
+         << ", \"time_min\": " << timings.min()
+         << ", \"time_avg\": " << timings.average()
+         << ", \"dofs_per_second\": " << n_dofs_processed / timings.min()
+         << ", \"gbytes_per_second\": " << 1e-9 * n_bytes / timings.min()
+#ifdef DEBUG
+         << ", \"build\": \"debug\""
+#else
+         << ", \"build\": \"release\""
+#endif
+         << "}";
+
+    std::cout << line.str() << std::endl;
+    if (!parameters.output_file.empty())
+      {
+        std::ofstream out (parameters.output_file.c_str(), std::ios::app);
+        AssertThrow (out, ExcMessage ("Could not open " + parameters.output_file));
+        out << line.str() << std::endl;
+      }
+  }
+
+
+
+  /**
+   * Translate the run-time polynomial degree into the template argument of
+   * the benchmark class, which must provide a static function
+   * <code>run(const std::string &mesh_type, const Parameters &)</code>.
+   */
+  template <template <int, int, typename> class Benchmark, int dim, typename Number>
+  void run_degree (const unsigned int fe_degree,
+                   const std::string &mesh_type,
+                   const Parameters  &parameters)
+  {
+    switch (fe_degree)
+      {
+      case 1:
+        Benchmark<dim,1,Number>::run (mesh_type, parameters);
+        break;
+      case 2:
+        Benchmark<dim,2,Number>::run (mesh_type, parameters);
+        break;
+      case 3:
+        Benchmark<dim,3,Number>::run (mesh_type, parameters);
+        break;
+      case 4:
+        Benchmark<dim,4,Number>::run (mesh_type, parameters);
+        break;
+      case 5:
+        Benchmark<dim,5,Number>::run (mesh_type, parameters);
+        break;
+      case 6:
+        Benchmark<dim,6,Number>::run (mesh_type, parameters);
+        break;
+      case 7:
+        Benchmark<dim,7,Number>::run (mesh_type, parameters);
+        break;
+      case 8:
+        Benchmark<dim,8,Number>::run (mesh_type, parameters);
+        break;
+      default:
+        AssertThrow (false, ExcNotImplemented());
+      }
+  }
+
+
+
+  template <template <int, int, typename> class Benchmark>
+  void run_all (const Parameters &parameters)
+  {
+    for (unsigned int d=0; d<parameters.dims.size(); ++d)
+      for (unsigned int n=0; n<parameters.numbers.size(); ++n)
+        for (unsigned int m=0; m<parameters.meshes.size(); ++m)
+          for (unsigned int k=0; k<parameters.degrees.size(); ++k)
+            {
+              const unsigned int degree = parameters.degrees[k];
+              const std::string &mesh_type = parameters.meshes[m];
+              const bool is_float = parameters.numbers[n] == "float";
+              if (parameters.dims[d] == 2 && is_float)
+                run_degree<Benchmark,2,float> (degree, mesh_type, parameters);
+              else if (parameters.dims[d] == 2)
+                run_degree<Benchmark,2,double> (degree, mesh_type, parameters);
+              else if (is_float)
+                run_degree<Benchmark,3,float> (degree, mesh_type, parameters);
+              else
+                run_degree<Benchmark,3,double> (degree, mesh_type, parameters);
+            }
+  }
+
+
+
+  /**
+   * The common main function of the benchmark programs.
+   */
+  template <template <int, int, typename> class Benchmark>
+  int main (int argc, char **argv)
+  {
+    try
+      {
+        Parameters parameters;
+        parameters.parse (argc, argv);
+
+        Utilities::MPI::MPI_InitFinalize mpi_init (argc, argv,
+                                                   parameters.n_threads);
+
+#ifdef DEBUG
+        if (Utilities::MPI::this_mpi_process (communicator()) == 0)
+          std::cerr << "Warning: the benchmarks are compiled in debug mode, "
+                    << "the timings are not representative." << std::endl;
+#endif
+
+        run_all<Benchmark> (parameters);
+      }
+    catch (std::exception &exc)
+      {
+        std::cerr << std::endl << std::endl
+                  << "----------------------------------------------------"
+                  << std::endl;
+        std::cerr << "Exception on processing: " << std::endl
+                  << exc.what() << std::endl
+                  << "Aborting!" << std::endl
+                  << "----------------------------------------------------"
+                  << std::endl;
+        return 1;
+      }
+    catch (...)
+      {
+        std::cerr << std::endl << std::endl
+                  << "----------------------------------------------------"
+                  << std::endl;
+        std::cerr << "Unknown exception!" << std::endl
+                  << "Aborting!" << std::endl
+                  << "----------------------------------------------------"
+                  << std::endl;
+        return 1;
+      }
+
+    return 0;
+  }
+}
+
+#endif
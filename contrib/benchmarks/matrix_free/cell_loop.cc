@@ -0,0 +1,78 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// Throughput of the matrix-vector product with the Laplace operator of
+// MatrixFreeOperators::LaplaceOperator, i.e., a MatrixFree::cell_loop that
+// reads the source vector, runs FEEvaluation::evaluate() and
+// FEEvaluation::integrate() with the gradients on all cells and writes into
+// the destination vector including the exchange of ghost entries.
+
+#include "benchmark_common.h"
+
+#include <deal.II/matrix_free/operators.h>
+
+
+namespace Benchmarks
+{
+  template <int dim, int fe_degree, typename Number>
+  struct CellLoop
+  {
+    static void run (const std::string &mesh_type,
+                     const Parameters  &parameters)
+    {
+      BenchmarkSystem<dim,Number> system (fe_degree, mesh_type, parameters);
+
+      MatrixFreeOperators::LaplaceOperator<dim,fe_degree,fe_degree+1,1,Number> laplace;
+      laplace.initialize (system.matrix_free);
+
+      LinearAlgebra::distributed::Vector<Number> src, dst;
+      laplace.initialize_dof_vector (src);
+      laplace.initialize_dof_vector (dst);
+      for (unsigned int i=0; i<src.local_size(); ++i)
+        src.local_element(i) = (i % 17) * 0.1;
+
+      // warm up caches and the vector exchange before taking the time
+      laplace.vmult (dst, src);
+
+      Timings timings;
+      for (unsigned int t=0; t<parameters.n_repetitions; ++t)
+        {
+          timings.start ();
+          laplace.vmult (dst, src);
+          timings.stop ();
+        }
+
+      // the matrix-vector product reads the source vector, writes the
+      // destination vector (the write also loads the cache lines) and reads
+      // the indices and the geometry of all cells
+      const types::global_dof_index n_dofs = system.dof_handler.n_dofs();
+      const double n_bytes = 3. * n_dofs * sizeof(Number) +
+                             Utilities::MPI::sum (1. * system.cell_loop_data_bytes(),
+                                                  communicator());
+      print_result (parameters, "cell_loop_laplace", dim, fe_degree,
+                    number_name<Number>(), mesh_type, n_dofs, n_dofs,
+                    n_bytes, timings);
+    }
+  };
+}
+
+
+
+int main (int argc, char **argv)
+{
+  return Benchmarks::main<Benchmarks::CellLoop> (argc, argv);
+}
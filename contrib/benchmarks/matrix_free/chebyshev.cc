@@ -0,0 +1,95 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// Throughput of PreconditionChebyshev of degree 5 around a point-Jacobi
+// method on the matrix-free Laplace operator, the typical multigrid smoother
+// of matrix-free solvers. One application consists of five matrix-vector
+// products plus the vector updates of the Chebyshev iteration, and the
+// number of processed degrees of freedom counts each of the matrix-vector
+// products.
+
+#include "benchmark_common.h"
+
+#include <deal.II/lac/precondition.h>
+#include <deal.II/matrix_free/operators.h>
+
+
+namespace Benchmarks
+{
+  template <int dim, int fe_degree, typename Number>
+  struct Chebyshev
+  {
+    static void run (const std::string &mesh_type,
+                     const Parameters  &parameters)
+    {
+      BenchmarkSystem<dim,Number> system (fe_degree, mesh_type, parameters);
+
+      typedef MatrixFreeOperators::LaplaceOperator<dim,fe_degree,fe_degree+1,1,Number> MatrixType;
+      MatrixType laplace;
+      laplace.initialize (system.matrix_free);
+      laplace.compute_diagonal ();
+
+      const unsigned int chebyshev_degree = 5;
+      typedef PreconditionChebyshev<MatrixType,LinearAlgebra::distributed::Vector<Number> > SmootherType;
+      typename SmootherType::AdditionalData smoother_data;
+      smoother_data.degree = chebyshev_degree;
+      smoother_data.smoothing_range = 15.;
+      smoother_data.eig_cg_n_iterations = 10;
+      smoother_data.preconditioner = laplace.get_matrix_diagonal_inverse();
+      SmootherType smoother;
+      smoother.initialize (laplace, smoother_data);
+
+      LinearAlgebra::distributed::Vector<Number> src, dst;
+      laplace.initialize_dof_vector (src);
+      laplace.initialize_dof_vector (dst);
+      for (unsigned int i=0; i<src.local_size(); ++i)
+        src.local_element(i) = (i % 17) * 0.1;
+
+      // the first application also runs the eigenvalue estimation
+      smoother.vmult (dst, src);
+
+      Timings timings;
+      for (unsigned int t=0; t<parameters.n_repetitions; ++t)
+        {
+          timings.start ();
+          smoother.vmult (dst, src);
+          timings.stop ();
+        }
+
+      // each step performs a matrix-vector product with the data access of
+      // the cell_loop benchmark and the Chebyshev update that reads the
+      // right hand side, the diagonal and two vectors and writes one vector
+      const types::global_dof_index n_dofs = system.dof_handler.n_dofs();
+      const double n_bytes_matvec =
+        3. * n_dofs * sizeof(Number) +
+        Utilities::MPI::sum (1. * system.cell_loop_data_bytes(), communicator());
+      const double n_bytes_update = 6. * n_dofs * sizeof(Number);
+      print_result (parameters, "chebyshev_jacobi_laplace", dim, fe_degree,
+                    number_name<Number>(), mesh_type, n_dofs,
+                    1. * chebyshev_degree * n_dofs,
+                    chebyshev_degree * (n_bytes_matvec + n_bytes_update),
+                    timings);
+    }
+  };
+}
+
+
+
+int main (int argc, char **argv)
+{
+  return Benchmarks::main<Benchmarks::Chebyshev> (argc, argv);
+}
@@ -0,0 +1,116 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// Throughput of the cell-local work in FEEvaluation: evaluate() of values
+// and gradients, the Laplace operation at the quadrature points that reads
+// the geometry and integrate() of values and gradients. In contrast to the
+// cell_loop benchmark, the cell-local degrees of freedom are not read from
+// nor written to a global vector, so the numbers measure the sum
+// factorization kernels in isolation. The degrees of freedom are counted per
+// cell, i.e., the degrees of freedom shared between cells are counted several
+// times.
+
+#include "benchmark_common.h"
+
+#include <deal.II/base/aligned_vector.h>
+#include <deal.II/base/parallel.h>
+#include <deal.II/matrix_free/fe_evaluation.h>
+
+
+namespace Benchmarks
+{
+  template <int dim, int fe_degree, typename Number>
+  struct EvaluateIntegrate
+  {
+    static double
+    run_on_cells (const MatrixFree<dim,Number> &matrix_free,
+                  const unsigned int            begin,
+                  const unsigned int            end)
+    {
+      FEEvaluation<dim,fe_degree,fe_degree+1,1,Number> phi (matrix_free);
+      AlignedVector<VectorizedArray<Number> > input (phi.dofs_per_cell);
+      for (unsigned int i=0; i<phi.dofs_per_cell; ++i)
+        input[i] = make_vectorized_array<Number> ((i % 7) * 0.1);
+
+      // sum up a value of each cell to make sure the compiler cannot skip
+      // the computations
+      VectorizedArray<Number> result = VectorizedArray<Number>();
+      for (unsigned int cell=begin; cell<end; ++cell)
+        {
+          phi.reinit (cell);
+          for (unsigned int i=0; i<phi.dofs_per_cell; ++i)
+            phi.begin_dof_values()[i] = input[i];
+          phi.evaluate (true, true);
+          for (unsigned int q=0; q<phi.n_q_points; ++q)
+            {
+              phi.submit_gradient (phi.get_gradient(q), q);
+              phi.submit_value (phi.get_value(q), q);
+            }
+          phi.integrate (true, true);
+          result += phi.begin_dof_values()[cell % phi.dofs_per_cell];
+        }
+
+      return result[0];
+    }
+
+    static void run (const std::string &mesh_type,
+                     const Parameters  &parameters)
+    {
+      BenchmarkSystem<dim,Number> system (fe_degree, mesh_type, parameters);
+      const MatrixFree<dim,Number> &matrix_free = *system.matrix_free;
+      const unsigned int n_macro_cells = matrix_free.n_macro_cells();
+
+      double n_local_dofs = 0;
+      for (unsigned int cell=0; cell<n_macro_cells; ++cell)
+        n_local_dofs += matrix_free.n_components_filled(cell) *
+                        Utilities::fixed_power<dim>(fe_degree+1);
+      const double n_dofs = Utilities::MPI::sum (n_local_dofs, communicator());
+
+      double result = 0;
+      Timings timings;
+      for (unsigned int t=0; t<=parameters.n_repetitions; ++t)
+        {
+          // the first run is not timed to warm up the caches and threads
+          if (t > 0)
+            timings.start ();
+          result += parallel::accumulate_from_subranges<double>
+                    (std_cxx11::bind (&run_on_cells,
+                                      std_cxx11::cref (matrix_free),
+                                      std_cxx11::_1, std_cxx11::_2),
+                     0U, n_macro_cells, 16);
+          if (t > 0)
+            timings.stop ();
+        }
+      AssertThrow (numbers::is_finite (result), ExcNumberNotFinite(result));
+
+      // the only data read from memory is the geometry
+      const double n_bytes =
+        Utilities::MPI::sum (1. * matrix_free.get_mapping_info().memory_consumption(),
+                             communicator());
+      print_result (parameters, "fe_evaluation_evaluate_integrate", dim,
+                    fe_degree, number_name<Number>(), mesh_type,
+                    system.dof_handler.n_dofs(), n_dofs, n_bytes, timings);
+    }
+  };
+}
+
+
+
+int main (int argc, char **argv)
+{
+  return Benchmarks::main<Benchmarks::EvaluateIntegrate> (argc, argv);
+}
@@ -0,0 +1,107 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// Throughput of MGTransferMatrixFree::prolongate() and
+// MGTransferMatrixFree::restrict_and_add() between the finest and the second
+// finest level of a globally refined mesh. The number of degrees of freedom
+// refers to the finer of the two levels.
+
+#include "benchmark_common.h"
+
+#include <deal.II/multigrid/mg_constrained_dofs.h>
+#include <deal.II/multigrid/mg_transfer_matrix_free.h>
+
+
+namespace Benchmarks
+{
+  template <int dim, int fe_degree, typename Number>
+  struct MGTransfer
+  {
+    static void run (const std::string &mesh_type,
+                     const Parameters  &parameters)
+    {
+      BenchmarkSystem<dim,Number> system (fe_degree, mesh_type, parameters,
+                                          true);
+      const DoFHandler<dim> &dof_handler = system.dof_handler;
+      const unsigned int fine_level =
+        system.triangulation->n_global_levels() - 1;
+      AssertThrow (fine_level > 0,
+                   ExcMessage ("The mesh needs at least two levels"));
+
+      MGConstrainedDoFs mg_constrained_dofs;
+      std::set<types::boundary_id> dirichlet_boundary;
+      dirichlet_boundary.insert (0);
+      mg_constrained_dofs.initialize (dof_handler);
+      mg_constrained_dofs.make_zero_boundary_constraints (dof_handler,
+                                                          dirichlet_boundary);
+
+      MGTransferMatrixFree<dim,Number> transfer (mg_constrained_dofs);
+      transfer.build (dof_handler);
+
+      LinearAlgebra::distributed::Vector<Number> coarse, fine;
+      coarse.reinit (dof_handler.locally_owned_mg_dofs(fine_level-1),
+                     communicator());
+      fine.reinit (dof_handler.locally_owned_mg_dofs(fine_level),
+                   communicator());
+      for (unsigned int i=0; i<coarse.local_size(); ++i)
+        coarse.local_element(i) = (i % 13) * 0.1;
+
+      const types::global_dof_index n_fine = dof_handler.n_dofs(fine_level);
+      const types::global_dof_index n_coarse = dof_handler.n_dofs(fine_level-1);
+
+      // prolongation reads the coarse vector and writes the fine vector
+      // (the write also loads the cache lines); the restriction reads the
+      // fine vector and adds into the coarse vector
+      {
+        transfer.prolongate (fine_level, fine, coarse);
+        Timings timings;
+        for (unsigned int t=0; t<parameters.n_repetitions; ++t)
+          {
+            timings.start ();
+            transfer.prolongate (fine_level, fine, coarse);
+            timings.stop ();
+          }
+        print_result (parameters, "mg_transfer_prolongate", dim, fe_degree,
+                      number_name<Number>(), mesh_type, n_fine, n_fine,
+                      (1. * n_coarse + 2. * n_fine) * sizeof(Number),
+                      timings);
+      }
+
+      {
+        transfer.restrict_and_add (fine_level, coarse, fine);
+        Timings timings;
+        for (unsigned int t=0; t<parameters.n_repetitions; ++t)
+          {
+            timings.start ();
+            transfer.restrict_and_add (fine_level, coarse, fine);
+            timings.stop ();
+          }
+        print_result (parameters, "mg_transfer_restrict_and_add", dim,
+                      fe_degree, number_name<Number>(), mesh_type, n_fine,
+                      n_fine, (2. * n_coarse + 1. * n_fine) * sizeof(Number),
+                      timings);
+      }
+    }
+  };
+}
+
+
+
+int main (int argc, char **argv)
+{
+  return Benchmarks::main<Benchmarks::MGTransfer> (argc, argv);
+}
@@ -0,0 +1,399 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// Effect of the placement of memory pages on NUMA systems on the throughput
+// of SparseMatrix::vmult(), SparseMatrixSELL::vmult() and the vector updates
+// of Vector. The matrix is the 27-point stencil on a cube of grid points.
+//
+// The matrix and the vectors are set up twice: once with a single thread,
+// such that all memory is first touched (and hence placed) by the master
+// thread, and once with all threads, where the zeroing of the new memory in
+// SparseMatrix::reinit(), SparseMatrixSELL::reinit() and Vector::reinit()
+// uses the same partitioning into threads as the later compute loops. The
+// operations are then timed with all threads in both cases.
+
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/multithread_info.h>
+#include <deal.II/base/timer.h>
+#include <deal.II/base/utilities.h>
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/sparse_matrix_sell.h>
+#include <deal.II/lac/sparsity_pattern.h>
+#include <deal.II/lac/vector.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+namespace Benchmarks
+{
+  using namespace dealii;
+
+  /**
+   * The parameters of a benchmark run as given on the command line.
+   */
+  struct Parameters
+  {
+    Parameters ()
+      :
+      n_threads (numbers::invalid_unsigned_int),
+      min_rows (2000000),
+      n_repetitions (20)
+    {
+      numbers.push_back("float");
+      numbers.push_back("double");
+    }
+
+    static void print_usage (std::ostream &out,
+                             const std::string &program_name)
+    {
+      out << "Usage: " << program_name << " [options]" << std::endl
+          << "  --number <list>       float and/or double (default: float,double)" << std::endl
+          << "  --threads <n>         number of threads (default: all)" << std::endl
+          << "  --min-rows <n>        minimal number of matrix rows (default: 2000000)" << std::endl
+          << "  --repetitions <n>     number of timed runs per case (default: 20)" << std::endl
+          << "  --output <file>       append the results to this file as well" << std::endl;
+    }
+
+    void parse (int argc, char **argv)
+    {
+      for (int i=1; i<argc; ++i)
+        {
+          const std::string option (argv[i]);
+          if (option == "--help" || option == "-h")
+            {
+              print_usage (std::cout, argv[0]);
+              std::exit (0);
+            }
+          AssertThrow (i+1 < argc,
+                       ExcMessage ("Missing value for option " + option));
+          const std::string value (argv[++i]);
+          if (option == "--number")
+            numbers = Utilities::split_string_list (value);
+          else if (option == "--threads")
+            n_threads = Utilities::string_to_int (value);
+          else if (option == "--min-rows")
+            min_rows = Utilities::string_to_int (value);
+          else if (option == "--repetitions")
+            n_repetitions = Utilities::string_to_int (value);
+          else if (option == "--output")
+            output_file = value;
+          else
+            AssertThrow (false, ExcMessage ("Unknown option " + option +
+                                            ", see --help for the valid options"));
+        }
+
+      for (unsigned int i=0; i<numbers.size(); ++i)
+        AssertThrow (numbers[i] == "float" || numbers[i] == "double",
+                     ExcMessage ("Unknown number type " + numbers[i]));
+      AssertThrow (n_repetitions > 0,
+                   ExcMessage ("At least one repetition is needed"));
+    }
+
+    std::vector<std::string>  numbers;
+    unsigned int              n_threads;
+    types::global_dof_index   min_rows;
+    unsigned int              n_repetitions;
+    std::string               output_file;
+  };
+
+
+
+  template <typename Number> const char *number_name ();
+  template <> inline const char *number_name<float> ()
+  {
+    return "float";
+  }
+  template <> inline const char *number_name<double> ()
+  {
+    return "double";
+  }
+
+
+
+  /**
+   * Run the given operation @p n_repetitions times after one warm-up call
+   * and return the fastest and the average wall time.
+   */
+  template <typename Operation>
+  std::pair<double,double> time_operation (const Operation   &operation,
+                                           const unsigned int n_repetitions)
+  {
+    operation ();
+
+    Timer timer;
+    double min_time = 1e300, sum_time = 0;
+    for (unsigned int t=0; t<n_repetitions; ++t)
+      {
+        timer.restart ();
+        operation ();
+        timer.stop ();
+        min_time = std::min (min_time, timer.wall_time());
+        sum_time += timer.wall_time();
+      }
+    return std::make_pair (min_time, sum_time/n_repetitions);
+  }
+
+
+
+  /**
+   * Print the result of one measurement as a single line containing a JSON
+   * object to the standard output and, if requested, append it to the
+   * output file. @p n_bytes is an estimate of the data transferred from
+   * main memory by one call of the operation.
+   */
+  void print_result (const Parameters               &parameters,
+                     const std::string              &benchmark,
+                     const std::string              &number,
+                     const std::string              &first_touch,
+                     const types::global_dof_index   n_rows,
+                     const std::size_t               n_nonzero,
+                     const double                    n_bytes,
+                     const std::pair<double,double> &times)
+  {
+    std::ostringstream line;
+    line << std::setprecision (6)
+         << "{\"benchmark\": \"" << benchmark << "\""
+         << ", \"number\": \"" << number << "\""
+         << ", \"first_touch\": \"" << first_touch << "\""
+         << ", \"threads\": " << MultithreadInfo::n_threads()
+         << ", \"n_rows\": " << n_rows
+         << ", \"n_nonzero\": " << n_nonzero
+         << ", \"repetitions\": " << parameters.n_repetitions
+         << ", \"time_min\": " << times.first
+         << ", \"time_avg\": " << times.second
+         << ", \"gbytes_per_second\": " << 1e-9 * n_bytes / times.first
+#ifdef DEBUG
+         << ", \"build\": \"debug\""
+#else
+         << ", \"build\": \"release\""
+#endif
+         << "}";
+
+    std::cout << line.str() << std::endl;
+    if (!parameters.output_file.empty())
+      {
+        std::ofstream out (parameters.output_file.c_str(), std::ios::app);
+        AssertThrow (out, ExcMessage ("Could not open " + parameters.output_file));
+        out << line.str() << std::endl;
+      }
+  }
+
+
+
+  /**
+   * Create the sparsity pattern of the 27-point stencil on an n x n x n
+   * cube of grid points numbered lexicographically.
+   */
+  void make_stencil_sparsity (const unsigned int n,
+                              SparsityPattern   &sparsity)
+  {
+    const types::global_dof_index n_rows =
+      static_cast<types::global_dof_index>(n)*n*n;
+    sparsity.reinit (n_rows, n_rows, 27);
+    for (unsigned int k=0; k<n; ++k)
+      for (unsigned int j=0; j<n; ++j)
+        for (unsigned int i=0; i<n; ++i)
+          {
+            const types::global_dof_index row = (static_cast<types::global_dof_index>(k)*n+j)*n+i;
+            for (unsigned int kk=(k>0 ? k-1 : 0); kk<std::min(k+2,n); ++kk)
+              for (unsigned int jj=(j>0 ? j-1 : 0); jj<std::min(j+2,n); ++jj)
+                for (unsigned int ii=(i>0 ? i-1 : 0); ii<std::min(i+2,n); ++ii)
+                  sparsity.add (row, (static_cast<types::global_dof_index>(kk)*n+jj)*n+ii);
+          }
+    sparsity.compress ();
+  }
+
+
+
+  template <typename Number>
+  struct SparseMatrixVmult
+  {
+    SparseMatrixVmult (const SparseMatrix<Number> &matrix,
+                       Vector<Number>             &dst,
+                       const Vector<Number>       &src)
+      : matrix (matrix), dst (dst), src (src) {}
+
+    void operator () () const
+    {
+      matrix.vmult (dst, src);
+    }
+
+    const SparseMatrix<Number> &matrix;
+    Vector<Number>             &dst;
+    const Vector<Number>       &src;
+  };
+
+
+
+  template <typename Number>
+  struct SparseMatrixSELLVmult
+  {
+    SparseMatrixSELLVmult (const SparseMatrixSELL<Number> &matrix,
+                           Vector<Number>                 &dst,
+                           const Vector<Number>           &src)
+      : matrix (matrix), dst (dst), src (src) {}
+
+    void operator () () const
+    {
+      matrix.vmult (dst, src);
+    }
+
+    const SparseMatrixSELL<Number> &matrix;
+    Vector<Number>                 &dst;
+    const Vector<Number>           &src;
+  };
+
+
+
+  template <typename Number>
+  struct VectorUpdate
+  {
+    VectorUpdate (Vector<Number>       &dst,
+                  const Vector<Number> &src)
+      : dst (dst), src (src) {}
+
+    void operator () () const
+    {
+      dst.add (Number(0.1), src);
+    }
+
+    Vector<Number>       &dst;
+    const Vector<Number> &src;
+  };
+
+
+
+  template <typename Number>
+  void run (const SparsityPattern &sparsity,
+            const std::string     &first_touch,
+            const Parameters      &parameters)
+  {
+    // set up the matrices and vectors with the requested number of threads
+    // and then time the operations with all threads
+    if (first_touch == "serial")
+      MultithreadInfo::set_thread_limit (1);
+
+    SparseMatrix<Number> matrix (sparsity);
+    for (types::global_dof_index row=0; row<matrix.m(); ++row)
+      for (typename SparseMatrix<Number>::iterator entry=matrix.begin(row);
+           entry != matrix.end(row); ++entry)
+        entry->value() = entry->column() == row ? 26. : -1.;
+
+    SparseMatrixSELL<Number> matrix_sell (matrix);
+
+    Vector<Number> src, dst;
+    src.reinit (matrix.n(), true);
+    dst.reinit (matrix.m(), true);
+    for (types::global_dof_index i=0; i<src.size(); ++i)
+      src(i) = (i % 17) * 0.1;
+
+    if (first_touch == "serial")
+      MultithreadInfo::set_thread_limit (parameters.n_threads);
+
+    const types::global_dof_index n_rows = matrix.m();
+    const std::size_t n_nonzero = matrix.n_nonzero_elements();
+    const double vector_bytes = 2. * n_rows * sizeof(Number);
+
+    print_result (parameters, "sparse_matrix_vmult", number_name<Number>(),
+                  first_touch, n_rows, n_nonzero,
+                  n_nonzero * (sizeof(Number) + sizeof(unsigned int)) +
+                  (n_rows+1) * sizeof(std::size_t) + vector_bytes,
+                  time_operation (SparseMatrixVmult<Number>(matrix, dst, src),
+                                  parameters.n_repetitions));
+
+    print_result (parameters, "sparse_matrix_sell_vmult", number_name<Number>(),
+                  first_touch, n_rows, n_nonzero,
+                  matrix_sell.n_stored_elements() * (sizeof(Number) + sizeof(unsigned int)) +
+                  vector_bytes,
+                  time_operation (SparseMatrixSELLVmult<Number>(matrix_sell, dst, src),
+                                  parameters.n_repetitions));
+
+    // reads two vectors and writes one
+    print_result (parameters, "vector_add", number_name<Number>(),
+                  first_touch, n_rows, n_nonzero,
+                  1.5 * vector_bytes,
+                  time_operation (VectorUpdate<Number>(dst, src),
+                                  parameters.n_repetitions));
+  }
+}
+
+
+
+int main (int argc, char **argv)
+{
+  using namespace Benchmarks;
+
+  try
+    {
+      Parameters parameters;
+      parameters.parse (argc, argv);
+
+      MultithreadInfo::set_thread_limit (parameters.n_threads);
+
+#ifdef DEBUG
+      std::cerr << "Warning: the benchmarks are compiled in debug mode, "
+                << "the timings are not representative." << std::endl;
+#endif
+
+      unsigned int n = 2;
+      while (static_cast<double>(n)*n*n < static_cast<double>(parameters.min_rows))
+        ++n;
+      SparsityPattern sparsity;
+      make_stencil_sparsity (n, sparsity);
+
+      const char *first_touch[] = { "serial", "parallel" };
+      for (unsigned int i=0; i<parameters.numbers.size(); ++i)
+        for (unsigned int f=0; f<2; ++f)
+          if (parameters.numbers[i] == "float")
+            run<float> (sparsity, first_touch[f], parameters);
+          else
+            run<double> (sparsity, first_touch[f], parameters);
+    }
+  catch (std::exception &exc)
+    {
+      std::cerr << std::endl << std::endl
+                << "----------------------------------------------------"
+                << std::endl;
+      std::cerr << "Exception on processing: " << std::endl
+                << exc.what() << std::endl
+                << "Aborting!" << std::endl
+                << "----------------------------------------------------"
+                << std::endl;
+      return 1;
+    }
+  catch (...)
+    {
+      std::cerr << std::endl << std::endl
+                << "----------------------------------------------------"
+                << std::endl;
+      std::cerr << "Unknown exception!" << std::endl
+                << "Aborting!" << std::endl
+                << "----------------------------------------------------"
+                << std::endl;
+      return 1;
+    }
+
+  return 0;
+}
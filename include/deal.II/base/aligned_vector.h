@@ -124,6 +124,12 @@ public:
    * but does not initialize the newly allocated memory, leaving it in an
    * undefined state.
    *
+   * For trivial types @p T, the new memory is not touched by this function.
+   * On NUMA systems, where memory pages are placed close to the thread that
+   * first writes into them, this allows the caller to initialize the
+   * elements with the same parallel partitioning as used in later compute
+   * loops, see e.g. SparseMatrixSELL::reinit().
+   *
    * @note This method can only be invoked for classes @p T that define a
    * default constructor, @p T(). Otherwise, compilation will fail.
    */
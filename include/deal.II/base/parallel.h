@@ -38,8 +38,6 @@
 #endif
 
 
-//TODO[WB]: allow calling functions to pass along a tbb::affinity_partitioner object to ensure that subsequent calls use the same cache lines
-
 DEAL_II_NAMESPACE_OPEN
 
 namespace parallel
@@ -776,6 +774,77 @@ namespace parallel
 #endif
     };
   }
+
+
+
+  /**
+   * Same as the apply_to_subranges() function above, but the subranges are
+   * assigned to threads through the affinity partitioner stored in the
+   * given @p partitioner object. When several loops are run over the same
+   * range with the same grain size and the same partitioner, TBB replays the
+   * assignment of subranges to threads of the previous loops. This makes
+   * sure that the data touched by one thread stays in the caches of that
+   * thread and, on NUMA systems, that data first touched (and hence
+   * allocated) by one thread in an initialization loop is later accessed by
+   * the same thread, i.e., from the local memory bank.
+   *
+   * The partitioner can be used by one loop at a time only; if it is in use
+   * by another loop (e.g. when the loops are run from different tasks), a
+   * temporary partitioner is used instead.
+   */
+  template <typename RangeType, typename Function>
+  void apply_to_subranges (const RangeType                          &begin,
+                           const typename identity<RangeType>::type &end,
+                           const Function                           &f,
+                           const unsigned int                        grainsize,
+                           internal::TBBPartitioner                 &partitioner)
+  {
+#ifndef DEAL_II_WITH_THREADS
+    (void) partitioner;
+    apply_to_subranges (begin, end, f, grainsize);
+#else
+    std_cxx11::shared_ptr<tbb::affinity_partitioner> affinity =
+      partitioner.acquire_one_partitioner();
+    tbb::parallel_for (tbb::blocked_range<RangeType>
+                       (begin, end, grainsize),
+                       std_cxx11::bind (&internal::apply_to_subranges<RangeType,Function>,
+                                        std_cxx11::_1,
+                                        std_cxx11::cref(f)),
+                       *affinity);
+    partitioner.release_one_partitioner(affinity);
+#endif
+  }
+
+
+
+  /**
+   * Same as the accumulate_from_subranges() function above, but the
+   * subranges are assigned to threads through the affinity partitioner
+   * stored in the given @p partitioner object, see the respective variant
+   * of apply_to_subranges().
+   */
+  template <typename ResultType, typename RangeType, typename Function>
+  ResultType accumulate_from_subranges (const Function                           &f,
+                                        const RangeType                          &begin,
+                                        const typename identity<RangeType>::type &end,
+                                        const unsigned int                        grainsize,
+                                        internal::TBBPartitioner                 &partitioner)
+  {
+#ifndef DEAL_II_WITH_THREADS
+    (void) partitioner;
+    return accumulate_from_subranges<ResultType> (f, begin, end, grainsize);
+#else
+    internal::ReductionOnSubranges<ResultType,Function>
+    reductor (f, std::plus<ResultType>(), 0);
+    std_cxx11::shared_ptr<tbb::affinity_partitioner> affinity =
+      partitioner.acquire_one_partitioner();
+    tbb::parallel_reduce (tbb::blocked_range<RangeType>(begin, end, grainsize),
+                          reductor,
+                          *affinity);
+    partitioner.release_one_partitioner(affinity);
+    return reductor.result;
+#endif
+  }
 }
 
 
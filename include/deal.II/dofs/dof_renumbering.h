@@ -27,6 +27,8 @@
 
 DEAL_II_NAMESPACE_OPEN
 
+template <int dim, typename Number> class MatrixFree;
+
 /**
  * Implementation of a number of renumbering algorithms for the degrees of
  * freedom on a triangulation.
@@ -325,6 +327,19 @@ DEAL_II_NAMESPACE_OPEN
  * </td> </tr> </table>
  *
  *
+ * <h3>Numbering for matrix-free operator evaluation</h3>
+ *
+ * The numberings above are based on the connectivity of the degrees of
+ * freedom, i.e., on the sparsity pattern of a matrix. When the operator is
+ * instead evaluated with the MatrixFree framework, the order in which the
+ * entries of a vector are accessed is given by the batches of cells
+ * processed together through vectorization and by the partition of the
+ * cells among threads. The function DoFRenumbering::matrix_free_data_locality
+ * numbers the degrees of freedom in the order in which the cell loop of a
+ * given MatrixFree object first touches them, such that the vector entries
+ * are streamed mostly linearly through memory.
+ *
+ *
  * <h3>Multigrid DoF numbering</h3>
  *
  * Most of the algorithms listed above also work on multigrid degree of
@@ -1081,6 +1096,63 @@ namespace DoFRenumbering
    * @}
    */
 
+  /**
+   * @name Numberings for matrix-free operator evaluation
+   * @{
+   */
+
+  /**
+   * Renumber the degrees of freedom in the order in which they are first
+   * accessed by the cell loop of the given MatrixFree object, i.e., by going
+   * through the batches of cells in the order chosen by MatrixFree (which
+   * reflects the vectorization over cells and the partition of the cells
+   * among threads), within each batch through the degrees of freedom of the
+   * cells and for each degree of freedom through the cells of the batch. For
+   * discontinuous elements this gives an interleaved storage of the
+   * degrees of freedom of the cells in a batch that MatrixFree accesses with
+   * vectorized loads and stores, and for continuous elements it keeps the
+   * indices accessed by a batch close to each other, which reduces the
+   * number of cache lines transferred from memory in a matrix-vector
+   * product.
+   *
+   * In parallel, only the locally owned degrees of freedom are renumbered,
+   * within the locally owned range. The degrees of freedom that are also
+   * accessed from other processors, i.e., those located on ghost cells or on
+   * locally owned cells with a ghost cell as face neighbor, are numbered as
+   * one contiguous block at the position where the cell loop first touches
+   * one of them. This places the ghost entries of other processors that
+   * refer to this processor next to each other in the ghost range of
+   * LinearAlgebra::distributed::Vector and makes the data exchanged in
+   * LinearAlgebra::distributed::Vector::update_ghost_values() and
+   * LinearAlgebra::distributed::Vector::compress() contiguous.
+   *
+   * The MatrixFree object must have been set up with @p dof_handler (it may
+   * contain further DoFHandler objects) on the active cells. Since the
+   * renumbering invalidates the indices stored in @p matrix_free, the
+   * MatrixFree object needs to be re-initialized after this function, together
+   * with all constraints and vectors based on the old numbering.
+   */
+  template <int dim, typename Number>
+  void
+  matrix_free_data_locality (DoFHandler<dim>              &dof_handler,
+                             const MatrixFree<dim,Number> &matrix_free);
+
+  /**
+   * Compute the renumbering vector needed by the matrix_free_data_locality()
+   * function. Does not perform the renumbering on the @p DoFHandler dofs but
+   * returns the renumbering vector, which has as many entries as there are
+   * locally owned degrees of freedom.
+   */
+  template <int dim, typename Number>
+  void
+  compute_matrix_free_data_locality (std::vector<types::global_dof_index> &new_dof_indices,
+                                     const DoFHandler<dim>                &dof_handler,
+                                     const MatrixFree<dim,Number>         &matrix_free);
+
+  /**
+   * @}
+   */
+
   /**
    * Exception
    *
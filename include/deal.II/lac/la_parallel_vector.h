@@ -652,6 +652,41 @@ namespace LinearAlgebra
                                  const VectorSpaceVector<Number> &V,
                                  const VectorSpaceVector<Number> &W);
 
+      /**
+       * Compute the inner products of this vector with each of the vectors
+       * in @p V, i.e., <tt>result[i] = *this * (*V[i])</tt>. The vector @p
+       * result is resized to the number of vectors.
+       *
+       * The locally owned parts of all inner products are computed in a
+       * single sweep through this vector, working on pieces that fit into
+       * the cache, and are summed up over all processors with a single
+       * global reduction. Computing the inner products one after the other
+       * would load this vector once and need one reduction for each of
+       * them. The results are bitwise identical to the individual inner
+       * products.
+       */
+      void multi_dot (const std::vector<const Vector<Number> *> &V,
+                      std::vector<Number>                       &result) const;
+
+      /**
+       * Local part of multi_dot(), i.e., the inner products of the locally
+       * owned parts without the global reduction. The results are written
+       * into the array @p result, which must have space for one entry per
+       * vector. This allows to sum up the inner products of several vectors
+       * with a single global reduction.
+       */
+      void multi_dot_local (const std::vector<const Vector<Number> *> &V,
+                            Number                                    *result) const;
+
+      /**
+       * Add the linear combination of the vectors in @p V with the
+       * coefficients in @p a to this vector, i.e., <tt>*this += sum_i a[i] *
+       * (*V[i])</tt>, in a single sweep through this vector. The coefficients
+       * must be the same on all processors.
+       */
+      void multi_add (const std::vector<Number>                 &a,
+                      const std::vector<const Vector<Number> *> &V);
+
       /**
        * Return the global size of the vector, equal to the sum of the number of
        * locally owned indices among all processors.
@@ -1503,6 +1503,79 @@ namespace LinearAlgebra
 
 
 
+    template <typename Number>
+    void
+    Vector<Number>::multi_dot_local (const std::vector<const Vector<Number> *> &V,
+                                     Number                                    *result) const
+    {
+      if (V.size() == 0)
+        return;
+
+      const size_type vec_size = partitioner->local_size();
+      std::vector<const Number *> pointers (V.size());
+      for (unsigned int i=0; i<V.size(); ++i)
+        {
+          AssertDimension (vec_size, V[i]->local_size());
+          pointers[i] = V[i]->val;
+        }
+
+      internal::VectorOperations::MultiDot<Number> dot (val, &pointers[0],
+                                                        V.size());
+      internal::VectorOperations::parallel_multi_reduce (dot, vec_size, V.size(),
+                                                         result,
+                                                         thread_loop_partitioner);
+    }
+
+
+
+    template <typename Number>
+    void
+    Vector<Number>::multi_dot (const std::vector<const Vector<Number> *> &V,
+                               std::vector<Number>                       &result) const
+    {
+      result.resize (V.size());
+      if (V.size() == 0)
+        return;
+
+      multi_dot_local (V, &result[0]);
+      if (partitioner->n_mpi_processes() > 1)
+        Utilities::MPI::sum (result, partitioner->get_mpi_communicator(),
+                             result);
+      for (unsigned int i=0; i<result.size(); ++i)
+        AssertIsFinite(result[i]);
+    }
+
+
+
+    template <typename Number>
+    void
+    Vector<Number>::multi_add (const std::vector<Number>                 &a,
+                               const std::vector<const Vector<Number> *> &V)
+    {
+      AssertDimension (a.size(), V.size());
+      if (V.size() == 0)
+        return;
+
+      const size_type vec_size = partitioner->local_size();
+      std::vector<const Number *> pointers (V.size());
+      for (unsigned int i=0; i<V.size(); ++i)
+        {
+          AssertDimension (vec_size, V[i]->local_size());
+          AssertIsFinite(a[i]);
+          pointers[i] = V[i]->val;
+        }
+
+      internal::VectorOperations::MultiAdd<Number> adder (val, &pointers[0],
+                                                          &a[0], V.size());
+      internal::VectorOperations::parallel_for (adder, vec_size,
+                                                thread_loop_partitioner);
+
+      if (vector_is_ghosted)
+        update_ghost_values();
+    }
+
+
+
     template <typename Number>
     inline
     bool
@@ -25,6 +25,7 @@
 #include <deal.II/base/template_constraints.h>
 #include <deal.II/base/thread_management.h>
 #include <deal.II/lac/diagonal_matrix.h>
+#include <deal.II/lac/sparse_level_schedule.h>
 #include <deal.II/lac/solver_cg.h>
 #include <deal.II/lac/vector_memory.h>
 
@@ -552,6 +553,11 @@ public:
  * solver.solve (A, x, b, precondition);
  * @endcode
  *
+ * For a SparseMatrix, the forward and backward sweeps of vmult() and
+ * Tvmult() can be run in parallel with threads by setting
+ * AdditionalData::use_level_schedule, see SparseLevelSchedule. The
+ * functions step() and Tstep() always run sequentially.
+ *
  * @author Guido Kanschat, 2000
  */
 template <typename MatrixType = SparseMatrix<double> >
@@ -559,9 +565,52 @@ class PreconditionSOR : public PreconditionRelaxation<MatrixType>
 {
 public:
   /**
-   * A typedef to the base class AdditionalData.
+   * A typedef to the base class.
    */
-  typedef typename PreconditionRelaxation<MatrixType>::AdditionalData AdditionalData;
+  typedef PreconditionRelaxation<MatrixType> BaseClass;
+
+  /**
+   * Parameters for PreconditionSOR.
+   */
+  class AdditionalData : public BaseClass::AdditionalData
+  {
+  public:
+    /**
+     * Constructor. If @p use_level_schedule is set, the preconditioner
+     * analyzes the sparsity pattern of a SparseMatrix in initialize() and
+     * runs the forward and backward sweeps of vmult() and Tvmult() with
+     * threads, using a SparseLevelSchedule with the given @p schedule_mode.
+     * For other matrix types, the flag is ignored.
+     */
+    AdditionalData (const double                    relaxation = 1.,
+                    const bool                      use_level_schedule = false,
+                    const SparseLevelSchedule::Mode schedule_mode = SparseLevelSchedule::level_scheduled);
+
+    /**
+     * Constructor from the parameters of the base class, using sequential
+     * sweeps.
+     */
+    AdditionalData (const typename BaseClass::AdditionalData &parameters);
+
+    /**
+     * Whether to run the sweeps with threads along a SparseLevelSchedule.
+     */
+    bool use_level_schedule;
+
+    /**
+     * The variant of the schedule, see SparseLevelSchedule::Mode. Note that
+     * only SparseLevelSchedule::level_scheduled gives the same result as the
+     * sequential sweeps.
+     */
+    SparseLevelSchedule::Mode schedule_mode;
+  };
+
+  /**
+   * Initialize matrix and relaxation parameter, and compute the level
+   * schedule if requested by @p parameters.
+   */
+  void initialize (const MatrixType     &A,
+                   const AdditionalData &parameters = AdditionalData());
 
   /**
    * Apply preconditioner.
@@ -586,6 +635,13 @@ public:
    */
   template<class VectorType>
   void Tstep (VectorType &x, const VectorType &rhs) const;
+
+private:
+  /**
+   * The schedule for the parallel sweeps, empty if the sweeps are run
+   * sequentially.
+   */
+  SparseLevelSchedule schedule;
 };
 
 
@@ -615,17 +671,20 @@ public:
  * solver.solve (A, x, b, precondition);
  * @endcode
  *
+ * For a SparseMatrix, the forward and backward sweeps of vmult() and
+ * Tvmult() can be run in parallel with threads by setting
+ * AdditionalData::use_level_schedule, see SparseLevelSchedule. With the
+ * schedule in SparseLevelSchedule::multicolor mode, the preconditioner
+ * corresponds to SSOR on the matrix renumbered by colors, which is still
+ * symmetric and thus suitable for SolverCG. The functions step() and
+ * Tstep() always run sequentially.
+ *
  * @author Guido Kanschat, 2000
  */
 template <typename MatrixType = SparseMatrix<double> >
 class PreconditionSSOR : public PreconditionRelaxation<MatrixType>
 {
 public:
-  /**
-   * A typedef to the base class AdditionalData.
-   */
-  typedef typename PreconditionRelaxation<MatrixType>::AdditionalData AdditionalData;
-
   /**
    * Declare type for container size.
    */
@@ -636,14 +695,51 @@ public:
    */
   typedef PreconditionRelaxation<MatrixType> BaseClass;
 
+  /**
+   * Parameters for PreconditionSSOR.
+   */
+  class AdditionalData : public BaseClass::AdditionalData
+  {
+  public:
+    /**
+     * Constructor. If @p use_level_schedule is set, the preconditioner
+     * analyzes the sparsity pattern of a SparseMatrix in initialize() and
+     * runs the forward and backward sweeps of vmult() and Tvmult() with
+     * threads, using a SparseLevelSchedule with the given @p schedule_mode.
+     * For other matrix types, the flag is ignored.
+     */
+    AdditionalData (const double                    relaxation = 1.,
+                    const bool                      use_level_schedule = false,
+                    const SparseLevelSchedule::Mode schedule_mode = SparseLevelSchedule::level_scheduled);
+
+    /**
+     * Constructor from the parameters of the base class, using sequential
+     * sweeps.
+     */
+    AdditionalData (const typename BaseClass::AdditionalData &parameters);
+
+    /**
+     * Whether to run the sweeps with threads along a SparseLevelSchedule.
+     */
+    bool use_level_schedule;
+
+    /**
+     * The variant of the schedule, see SparseLevelSchedule::Mode. Note that
+     * only SparseLevelSchedule::level_scheduled gives the same result as the
+     * sequential sweeps.
+     */
+    SparseLevelSchedule::Mode schedule_mode;
+  };
 
   /**
    * Initialize matrix and relaxation parameter. The matrix is just stored in
    * the preconditioner object. The relaxation parameter should be larger than
-   * zero and smaller than 2 for numerical reasons. It defaults to 1.
+   * zero and smaller than 2 for numerical reasons. It defaults to 1. If
+   * requested by @p parameters, the level schedule for the parallel sweeps
+   * is computed here.
    */
-  void initialize (const MatrixType &A,
-                   const typename BaseClass::AdditionalData &parameters = typename BaseClass::AdditionalData());
+  void initialize (const MatrixType     &A,
+                   const AdditionalData &parameters = AdditionalData());
 
   /**
    * Apply preconditioner.
@@ -677,6 +773,12 @@ private:
    * the diagonal is located.
    */
   std::vector<std::size_t> pos_right_of_diagonal;
+
+  /**
+   * The schedule for the parallel sweeps, empty if the sweeps are run
+   * sequentially.
+   */
+  SparseLevelSchedule schedule;
 };
 
 
@@ -895,6 +997,15 @@ private:
  * compatibility function that can extract the diagonal in case of a serial
  * computation.
  *
+ * If the vector type is LinearAlgebra::distributed::Vector, the
+ * preconditioner is a DiagonalMatrix, and the matrix provides a function
+ * <code>vmult(dst, src, operation_before, operation_after)</code> with two
+ * function objects that are run on ranges of the locally owned vector
+ * entries (like MatrixFreeOperators::Base::vmult()), the vector updates of
+ * the Chebyshev iteration are run on each range of the matrix-vector product
+ * as soon as it has been finished, while the entries are still in cache,
+ * rather than in a separate sweep through the vectors.
+ *
  * @author Martin Kronbichler, 2009, 2016; extension for full compatibility with
  * LinearOperator class: Jean-Paul Pelteret, 2015
  */
@@ -1426,6 +1537,149 @@ PreconditionJacobi<MatrixType>::Tstep (VectorType &dst, const VectorType &src) c
 
 //---------------------------------------------------------------------------
 
+namespace internal
+{
+  namespace PreconditionRelaxationImplementation
+  {
+    // Apply the SOR and SSOR sweeps of a general matrix, which does not
+    // support a SparseLevelSchedule
+    template <typename MatrixType, typename VectorType>
+    inline void
+    precondition_SOR (const MatrixType          &A,
+                      VectorType                &dst,
+                      const VectorType          &src,
+                      const double               omega,
+                      const SparseLevelSchedule &)
+    {
+      A.precondition_SOR (dst, src, omega);
+    }
+
+
+
+    template <typename MatrixType, typename VectorType>
+    inline void
+    precondition_TSOR (const MatrixType          &A,
+                       VectorType                &dst,
+                       const VectorType          &src,
+                       const double               omega,
+                       const SparseLevelSchedule &)
+    {
+      A.precondition_TSOR (dst, src, omega);
+    }
+
+
+
+    template <typename MatrixType, typename VectorType>
+    inline void
+    precondition_SSOR (const MatrixType               &A,
+                       VectorType                     &dst,
+                       const VectorType               &src,
+                       const double                    omega,
+                       const std::vector<std::size_t> &pos_right_of_diagonal,
+                       const SparseLevelSchedule      &)
+    {
+      A.precondition_SSOR (dst, src, omega, pos_right_of_diagonal);
+    }
+
+
+
+    // For a SparseMatrix, use the parallel sweeps along the schedule if one
+    // has been set up
+    template <typename number, typename somenumber>
+    inline void
+    precondition_SOR (const dealii::SparseMatrix<number> &A,
+                      dealii::Vector<somenumber>         &dst,
+                      const dealii::Vector<somenumber>   &src,
+                      const double                        omega,
+                      const SparseLevelSchedule          &schedule)
+    {
+      if (schedule.empty())
+        A.precondition_SOR (dst, src, omega);
+      else
+        A.precondition_SOR (dst, src, omega, schedule);
+    }
+
+
+
+    template <typename number, typename somenumber>
+    inline void
+    precondition_TSOR (const dealii::SparseMatrix<number> &A,
+                       dealii::Vector<somenumber>         &dst,
+                       const dealii::Vector<somenumber>   &src,
+                       const double                        omega,
+                       const SparseLevelSchedule          &schedule)
+    {
+      if (schedule.empty())
+        A.precondition_TSOR (dst, src, omega);
+      else
+        A.precondition_TSOR (dst, src, omega, schedule);
+    }
+
+
+
+    template <typename number, typename somenumber>
+    inline void
+    precondition_SSOR (const dealii::SparseMatrix<number> &A,
+                       dealii::Vector<somenumber>         &dst,
+                       const dealii::Vector<somenumber>   &src,
+                       const double                        omega,
+                       const std::vector<std::size_t>     &pos_right_of_diagonal,
+                       const SparseLevelSchedule          &schedule)
+    {
+      if (schedule.empty())
+        A.precondition_SSOR (dst, src, omega, pos_right_of_diagonal);
+      else
+        A.precondition_SSOR (dst, src, omega, schedule);
+    }
+  }
+}
+
+
+
+template <typename MatrixType>
+inline
+PreconditionSOR<MatrixType>::AdditionalData::
+AdditionalData (const double                    relaxation,
+                const bool                      use_level_schedule,
+                const SparseLevelSchedule::Mode schedule_mode)
+  :
+  BaseClass::AdditionalData (relaxation),
+  use_level_schedule (use_level_schedule),
+  schedule_mode (schedule_mode)
+{}
+
+
+
+template <typename MatrixType>
+inline
+PreconditionSOR<MatrixType>::AdditionalData::
+AdditionalData (const typename BaseClass::AdditionalData &parameters)
+  :
+  BaseClass::AdditionalData (parameters),
+  use_level_schedule (false),
+  schedule_mode (SparseLevelSchedule::level_scheduled)
+{}
+
+
+
+template <typename MatrixType>
+inline void
+PreconditionSOR<MatrixType>::initialize (const MatrixType     &rA,
+                                         const AdditionalData &parameters)
+{
+  this->BaseClass::initialize (rA, parameters);
+
+  // the level schedule can only be used by a SparseMatrix
+  const SparseMatrix<typename MatrixType::value_type> *mat =
+    dynamic_cast<const SparseMatrix<typename MatrixType::value_type> *>(&*this->A);
+  if (mat != 0 && parameters.use_level_schedule)
+    schedule.reinit (mat->get_sparsity_pattern(), parameters.schedule_mode);
+  else
+    schedule.clear ();
+}
+
+
+
 template <typename MatrixType>
 template<class VectorType>
 inline void
@@ -1438,7 +1692,8 @@ PreconditionSOR<MatrixType>::vmult (VectorType &dst, const VectorType &src) cons
 #endif // DEAL_II_WITH_CXX11
 
   Assert (this->A!=0, ExcNotInitialized());
-  this->A->precondition_SOR (dst, src, this->relaxation);
+  internal::PreconditionRelaxationImplementation::
+  precondition_SOR (*this->A, dst, src, this->relaxation, schedule);
 }
 
 
@@ -1455,7 +1710,8 @@ PreconditionSOR<MatrixType>::Tvmult (VectorType &dst, const VectorType &src) con
 #endif // DEAL_II_WITH_CXX11
 
   Assert (this->A!=0, ExcNotInitialized());
-  this->A->precondition_TSOR (dst, src, this->relaxation);
+  internal::PreconditionRelaxationImplementation::
+  precondition_TSOR (*this->A, dst, src, this->relaxation, schedule);
 }
 
 
@@ -1496,12 +1752,39 @@ PreconditionSOR<MatrixType>::Tstep (VectorType &dst, const VectorType &src) cons
 
 //---------------------------------------------------------------------------
 
+template <typename MatrixType>
+inline
+PreconditionSSOR<MatrixType>::AdditionalData::
+AdditionalData (const double                    relaxation,
+                const bool                      use_level_schedule,
+                const SparseLevelSchedule::Mode schedule_mode)
+  :
+  BaseClass::AdditionalData (relaxation),
+  use_level_schedule (use_level_schedule),
+  schedule_mode (schedule_mode)
+{}
+
+
+
+template <typename MatrixType>
+inline
+PreconditionSSOR<MatrixType>::AdditionalData::
+AdditionalData (const typename BaseClass::AdditionalData &parameters)
+  :
+  BaseClass::AdditionalData (parameters),
+  use_level_schedule (false),
+  schedule_mode (SparseLevelSchedule::level_scheduled)
+{}
+
+
+
 template <typename MatrixType>
 inline void
-PreconditionSSOR<MatrixType>::initialize (const MatrixType                     &rA,
-                                          const typename BaseClass::AdditionalData &parameters)
+PreconditionSSOR<MatrixType>::initialize (const MatrixType     &rA,
+                                          const AdditionalData &parameters)
 {
   this->PreconditionRelaxation<MatrixType>::initialize (rA, parameters);
+  schedule.clear ();
 
   // in case we have a SparseMatrix class, we can extract information about
   // the diagonal.
@@ -1526,6 +1809,9 @@ PreconditionSSOR<MatrixType>::initialize (const MatrixType                     &
               break;
           pos_right_of_diagonal[row] = it - mat->begin();
         }
+
+      if (parameters.use_level_schedule)
+        schedule.reinit (mat->get_sparsity_pattern(), parameters.schedule_mode);
     }
 }
 
@@ -1542,7 +1828,9 @@ PreconditionSSOR<MatrixType>::vmult (VectorType &dst, const VectorType &src) con
 #endif // DEAL_II_WITH_CXX11
 
   Assert (this->A!=0, ExcNotInitialized());
-  this->A->precondition_SSOR (dst, src, this->relaxation, pos_right_of_diagonal);
+  internal::PreconditionRelaxationImplementation::
+  precondition_SSOR (*this->A, dst, src, this->relaxation,
+                     pos_right_of_diagonal, schedule);
 }
 
 
@@ -1559,7 +1847,9 @@ PreconditionSSOR<MatrixType>::Tvmult (VectorType &dst, const VectorType &src) co
 #endif // DEAL_II_WITH_CXX11
 
   Assert (this->A!=0, ExcNotInitialized());
-  this->A->precondition_SSOR (dst, src, this->relaxation, pos_right_of_diagonal);
+  internal::PreconditionRelaxationImplementation::
+  precondition_SSOR (*this->A, dst, src, this->relaxation,
+                     pos_right_of_diagonal, schedule);
 }
 
 
@@ -1893,6 +2183,61 @@ namespace internal
       VectorUpdatesRange<Number>(upd, src.local_size());
     }
 
+    // perform a matrix-vector product followed by the vector updates of the
+    // Chebyshev iteration. In the general case, this simply calls the two
+    // operations after each other.
+    template <typename MatrixType, typename VectorType, typename PreconditionerType,
+              bool use_merged_operations = internal::SolverCG::has_vmult_with_std_functions<MatrixType,VectorType>::value>
+    struct VmultWithVectorUpdates
+    {
+      static void
+      apply (const MatrixType         &matrix,
+             const PreconditionerType &preconditioner,
+             const VectorType         &src,
+             const double              factor1,
+             const double              factor2,
+             VectorType               &update1,
+             VectorType               &update2,
+             VectorType               &update3,
+             VectorType               &dst)
+      {
+        matrix.vmult (update2, dst);
+        vector_updates (src, preconditioner, false, factor1, factor2,
+                        update1, update2, update3, dst);
+      }
+    };
+
+    // selection for a matrix that can run operations on subranges of the
+    // vectors after the matrix-vector product has finished writing into them
+    // (like MatrixFreeOperators::Base), together with a diagonal
+    // preconditioner around a parallel deal.II vector: run the vector
+    // updates on a range as soon as the entries of the matrix-vector product
+    // are final, while they are still in cache
+    template <typename MatrixType, typename Number>
+    struct VmultWithVectorUpdates<MatrixType, LinearAlgebra::distributed::Vector<Number>,
+             DiagonalMatrix<LinearAlgebra::distributed::Vector<Number> >, true>
+    {
+      static void
+      apply (const MatrixType                                                   &matrix,
+             const DiagonalMatrix<LinearAlgebra::distributed::Vector<Number> > &jacobi,
+             const LinearAlgebra::distributed::Vector<Number>                   &src,
+             const double                                                        factor1,
+             const double                                                        factor2,
+             LinearAlgebra::distributed::Vector<Number>                         &update1,
+             LinearAlgebra::distributed::Vector<Number>                         &update2,
+             LinearAlgebra::distributed::Vector<Number>                         &,
+             LinearAlgebra::distributed::Vector<Number>                         &dst)
+      {
+        VectorUpdater<Number> upd(src.begin(), jacobi.get_vector().begin(),
+                                  false, factor1, factor2,
+                                  update1.begin(), update2.begin(), dst.begin());
+        matrix.vmult (update2, dst,
+                      std_cxx11::function<void (const unsigned int, const unsigned int)>(),
+                      std_cxx11::bind(&VectorUpdater<Number>::apply_to_subrange,
+                                      &upd, std_cxx11::_1, std_cxx11::_2));
+      }
+    };
+
     template <typename MatrixType, typename VectorType, typename PreconditionerType>
     inline
     void
@@ -2178,12 +2523,12 @@ PreconditionChebyshev<MatrixType,VectorType,PreconditionerType>
   double rhok  = delta / theta,  sigma = theta / delta;
   for (unsigned int k=0; k<data.degree; ++k)
     {
-      matrix_ptr->vmult (update2, dst);
       const double rhokp = 1./(2.*sigma-rhok);
       const double factor1 = rhokp * rhok, factor2 = 2.*rhokp/delta;
       rhok = rhokp;
-      internal::PreconditionChebyshev::vector_updates
-      (src, *data.preconditioner, false, factor1, factor2, update1, update2, update3, dst);
+      internal::PreconditionChebyshev::VmultWithVectorUpdates
+      <MatrixType,VectorType,PreconditionerType>::apply
+      (*matrix_ptr, *data.preconditioner, src, factor1, factor2, update1, update2, update3, dst);
     }
 }
 
@@ -2260,11 +2605,9 @@ PreconditionChebyshev<MatrixType,VectorType,PreconditionerType>
     estimate_eigenvalues(src);
 
   if (!dst.all_zero())
-    {
-      matrix_ptr->vmult (update2, dst);
-      internal::PreconditionChebyshev::vector_updates
-      (src, *data.preconditioner, false, 0., 1./theta, update1, update2, update3, dst);
-    }
+    internal::PreconditionChebyshev::VmultWithVectorUpdates
+    <MatrixType,VectorType,PreconditionerType>::apply
+    (*matrix_ptr, *data.preconditioner, src, 0., 1./theta, update1, update2, update3, dst);
   else
     internal::PreconditionChebyshev::vector_updates
     (src, *data.preconditioner, true, 0., 1./theta, update1, update2, update3, dst);
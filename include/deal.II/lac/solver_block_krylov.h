@@ -0,0 +1,837 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+#ifndef dealii__solver_block_krylov_h
+#define dealii__solver_block_krylov_h
+
+
+#include <deal.II/base/config.h>
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/logstream.h>
+#include <deal.II/base/template_constraints.h>
+#include <deal.II/lac/full_matrix.h>
+#include <deal.II/lac/householder.h>
+#include <deal.II/lac/solver.h>
+#include <deal.II/lac/solver_control.h>
+#include <deal.II/lac/solver_gmres.h>
+#include <deal.II/lac/vector.h>
+#include <deal.II/lac/vector_memory.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#ifdef DEAL_II_WITH_CXX11
+#  include <type_traits>
+#  include <utility>
+#endif
+
+DEAL_II_NAMESPACE_OPEN
+
+/*!@addtogroup Solvers */
+/*@{*/
+
+/**
+ * Preconditioned block conjugate gradient method for solving a symmetric
+ * positive definite system with several right-hand sides at once. Compared
+ * to solving the systems one after the other with SolverCG, this method
+ * has two advantages:
+ * <ul>
+ * <li> The matrix is applied to all search directions in one pass by
+ * calling its <code>multi_vmult()</code> function, if it has one (like
+ * SparseMatrix and the matrix-free operators derived from
+ * MatrixFreeOperators::Base). Since sparse matrix-vector products are limited
+ * by the memory transfer of the matrix, the product with many vectors costs
+ * only little more than with one. For matrices without such a function,
+ * vmult() is called for each vector.
+ * <li> The search space of each system contains the Krylov spaces of all
+ * right-hand sides, which usually reduces the number of iterations.
+ * </ul>
+ *
+ * The implementation follows the breakdown-free block CG method by Ji and
+ * Li: in each iteration, the block of new search directions is
+ * orthonormalized, and directions that are linearly dependent on the others
+ * (up to AdditionalData::rank_tolerance) are removed from the block. This
+ * happens in particular when the residuals of several systems become
+ * linearly dependent during the iteration, which would make the original
+ * block CG method by O'Leary break down.
+ *
+ * <h3>Convergence and deflation</h3>
+ *
+ * The value passed to the SolverControl object in each iteration is the
+ * largest residual norm of all systems, i.e., the iteration stops once all
+ * systems have converged. A system is removed from the block (deflated)
+ * once its own residual norm falls below the tolerance of the SolverControl
+ * object, or, for a ReductionControl object, below the reduction times its
+ * initial residual norm, whichever is larger. The approximate solution of a
+ * deflated system is not updated any more, and its residual does not
+ * contribute new search directions, which reduces the block size and thus
+ * the work per iteration for the remaining systems.
+ *
+ * The solver works with any vector type. For dealii::Vector and
+ * LinearAlgebra::distributed::Vector, the inner products and linear
+ * combinations of the block vectors are computed by the multi_dot() and
+ * multi_add() functions of the vector class, and all inner products of the
+ * block with another block are summed up in a single global reduction. The
+ * preconditioner must be symmetric and positive definite, and it is applied
+ * through its <code>multi_vmult()</code> function if it has one.
+ *
+ * @code
+ * std::vector<Vector<double> > solutions (n_rhs, Vector<double>(n)),
+ *                              rhs (n_rhs, Vector<double>(n));
+ * ...
+ * SolverControl control (1000, 1e-10);
+ * SolverBlockCG<> solver (control);
+ * solver.solve (sparse_matrix, solutions, rhs, PreconditionIdentity());
+ * @endcode
+ *
+ * @see H. Ji, Y. Li: "A breakdown-free block conjugate gradient method", BIT
+ * Numerical Mathematics 57, 2017, and D.P. O'Leary: "The block conjugate
+ * gradient algorithm and related methods", Linear Algebra Appl. 29, 1980.
+ */
+template <typename VectorType = Vector<double> >
+class SolverBlockCG : public Solver<VectorType>
+{
+public:
+  /**
+   * Standardized data struct to pipe additional data to the solver.
+   */
+  struct AdditionalData
+  {
+    /**
+     * Constructor.
+     */
+    explicit
+    AdditionalData (const double rank_tolerance = 1e-10);
+
+    /**
+     * A new search direction is removed from the block if its norm after
+     * orthogonalization against the other directions of the block is
+     * smaller than this value times its norm before.
+     */
+    double rank_tolerance;
+  };
+
+  /**
+   * Constructor.
+   */
+  SolverBlockCG (SolverControl            &cn,
+                 VectorMemory<VectorType> &mem,
+                 const AdditionalData     &data = AdditionalData());
+
+  /**
+   * Constructor. Use an object of type GrowingVectorMemory as a default to
+   * allocate memory.
+   */
+  SolverBlockCG (SolverControl        &cn,
+                 const AdditionalData &data = AdditionalData());
+
+  /**
+   * Solve the linear systems $Ax_i=b_i$ for all vectors in @p b, with the
+   * content of @p x as initial guesses.
+   */
+  template <typename MatrixType, typename PreconditionerType>
+  void
+  solve (const MatrixType              &A,
+         std::vector<VectorType>       &x,
+         const std::vector<VectorType> &b,
+         const PreconditionerType      &precondition);
+
+protected:
+  /**
+   * Reference to the control object, which is needed to determine when a
+   * single system has converged.
+   */
+  const SolverControl &solver_control;
+
+  /**
+   * Additional parameters.
+   */
+  AdditionalData additional_data;
+};
+
+
+
+/**
+ * Restarted block GMRES method with right preconditioning for solving a
+ * general linear system with several right-hand sides at once. The Krylov
+ * basis is built from the residuals of all systems, and in each iteration
+ * the matrix and the preconditioner are applied to the whole block of new
+ * basis vectors in one pass through their <code>multi_vmult()</code>
+ * functions, if they have one, see SolverBlockCG. Each system is then
+ * solved by minimizing its residual over the whole basis. The iteration
+ * counted by the SolverControl object is one such block step, and the value
+ * passed to it is the largest residual norm of all systems.
+ *
+ * New basis vectors that are linearly dependent on the basis up to
+ * AdditionalData::rank_tolerance are dropped, such that the block size
+ * shrinks when the Krylov spaces of the different right-hand sides overlap.
+ * At each restart, systems whose residual norm has fallen below the
+ * tolerance of the SolverControl object (or, for a ReductionControl object,
+ * below the reduction times their initial residual norm) are removed from
+ * the block, and only the residuals of the remaining systems start the new
+ * basis.
+ *
+ * The basis holds the block of residuals plus
+ * AdditionalData::max_block_steps blocks of new vectors, i.e., up to
+ * <tt>(max_block_steps+1)</tt> times the number of right-hand sides vectors.
+ * Like in SolverGMRES, the basis vectors are orthogonalized by the
+ * classical Gram-Schmidt algorithm with re-orthogonalization, which for
+ * dealii::Vector and LinearAlgebra::distributed::Vector uses their multi_dot()
+ * and multi_add() functions.
+ *
+ * @see Y. Saad: "Iterative methods for sparse linear systems", 2nd edition,
+ * SIAM, 2003, section 6.12.
+ */
+template <typename VectorType = Vector<double> >
+class SolverBlockGMRES : public Solver<VectorType>
+{
+public:
+  /**
+   * Standardized data struct to pipe additional data to the solver.
+   */
+  struct AdditionalData
+  {
+    /**
+     * Constructor. By default, restart after 10 block steps.
+     */
+    explicit
+    AdditionalData (const unsigned int max_block_steps = 10,
+                    const double       rank_tolerance = 1e-10);
+
+    /**
+     * The number of block steps after which the method is restarted.
+     */
+    unsigned int max_block_steps;
+
+    /**
+     * A new basis vector is dropped if its norm after orthogonalization
+     * against the basis is smaller than this value times its norm before.
+     */
+    double rank_tolerance;
+  };
+
+  /**
+   * Constructor.
+   */
+  SolverBlockGMRES (SolverControl            &cn,
+                    VectorMemory<VectorType> &mem,
+                    const AdditionalData     &data = AdditionalData());
+
+  /**
+   * Constructor. Use an object of type GrowingVectorMemory as a default to
+   * allocate memory.
+   */
+  SolverBlockGMRES (SolverControl        &cn,
+                    const AdditionalData &data = AdditionalData());
+
+  /**
+   * Solve the linear systems $Ax_i=b_i$ for all vectors in @p b, with the
+   * content of @p x as initial guesses.
+   */
+  template <typename MatrixType, typename PreconditionerType>
+  void
+  solve (const MatrixType              &A,
+         std::vector<VectorType>       &x,
+         const std::vector<VectorType> &b,
+         const PreconditionerType      &precondition);
+
+protected:
+  /**
+   * Reference to the control object, which is needed to determine when a
+   * single system has converged.
+   */
+  const SolverControl &solver_control;
+
+  /**
+   * Additional parameters.
+   */
+  AdditionalData additional_data;
+};
+
+/*@}*/
+
+/*------------------------- Implementation ----------------------------*/
+
+#ifndef DOXYGEN
+
+namespace internal
+{
+  namespace SolverBlockKrylov
+  {
+#ifdef DEAL_II_WITH_CXX11
+    /**
+     * A type trait whose value is true if the class @p MatrixType has a
+     * member function <code>multi_vmult()</code> that takes vectors of
+     * pointers to @p VectorType, like SparseMatrix::multi_vmult().
+     */
+    template <typename MatrixType, typename VectorType>
+    class has_multi_vmult
+    {
+      template <typename C>
+      static std::false_type test(...);
+
+      template <typename C>
+      static auto test(const std::vector<VectorType *>       *dst,
+                       const std::vector<const VectorType *> *src)
+      -> decltype(std::declval<const C>().multi_vmult(*dst, *src),
+                  std::true_type());
+
+    public:
+      static const bool value =
+        decltype(test<MatrixType>(nullptr, nullptr))::value;
+    };
+#else
+    template <typename MatrixType, typename VectorType>
+    class has_multi_vmult
+    {
+    public:
+      static const bool value = false;
+    };
+#endif
+
+
+
+    template <typename MatrixType, typename VectorType>
+    void
+    multi_vmult (const MatrixType                      &A,
+                 const std::vector<VectorType *>       &dst,
+                 const std::vector<const VectorType *> &src,
+                 internal::bool2type<true>)
+    {
+      A.multi_vmult (dst, src);
+    }
+
+
+
+    template <typename MatrixType, typename VectorType>
+    void
+    multi_vmult (const MatrixType                      &A,
+                 const std::vector<VectorType *>       &dst,
+                 const std::vector<const VectorType *> &src,
+                 internal::bool2type<false>)
+    {
+      for (unsigned int i=0; i<src.size(); ++i)
+        A.vmult (*dst[i], *src[i]);
+    }
+
+
+
+    /**
+     * Apply @p A to all vectors in @p src, using a single call to
+     * <code>A.multi_vmult()</code> if @p A provides this function.
+     */
+    template <typename MatrixType, typename VectorType>
+    void
+    multi_vmult (const MatrixType                      &A,
+                 const std::vector<VectorType *>       &dst,
+                 const std::vector<const VectorType *> &src)
+    {
+      AssertDimension (dst.size(), src.size());
+      multi_vmult (A, dst, src,
+                   internal::bool2type<has_multi_vmult<MatrixType,VectorType>::value>());
+    }
+
+
+
+    /**
+     * The tolerance at which a single system with initial residual norm @p
+     * initial_residual is considered converged by @p control.
+     */
+    inline
+    double
+    column_tolerance (const SolverControl &control,
+                      const double         initial_residual)
+    {
+      double tolerance = control.tolerance();
+      if (const ReductionControl *reduction_control =
+            dynamic_cast<const ReductionControl *>(&control))
+        tolerance = std::max (tolerance,
+                              reduction_control->reduction() * initial_residual);
+      return tolerance;
+    }
+
+
+
+    /**
+     * Orthogonalize @p w against the first @p n_basis (orthonormal) vectors
+     * of @p basis and store the projections in @p h. If the norm of the
+     * orthogonalized vector is larger than @p rank_tolerance times the norm
+     * of the original vector, it is normalized and appended to the basis as
+     * vector number @p n_basis, and its norm is returned. Otherwise, the
+     * vector is considered linearly dependent on the basis and zero is
+     * returned.
+     */
+    template <typename VectorType>
+    double
+    append_to_basis (internal::SolverGMRES::TmpVectors<VectorType> &basis,
+                     const unsigned int                             n_basis,
+                     VectorType                                    &w,
+                     const double                                   rank_tolerance,
+                     dealii::Vector<double>                        &h)
+    {
+      const double initial_norm = w.l2_norm();
+      const double norm = (n_basis > 0 ?
+                           internal::SolverGMRES::classical_gram_schmidt
+                           (basis, n_basis, w, h) :
+                           initial_norm);
+      if (initial_norm == 0. || !(norm > rank_tolerance * initial_norm))
+        return 0.;
+
+      basis(n_basis, w).equ (1./norm, w);
+      return norm;
+    }
+  }
+}
+
+
+
+template <typename VectorType>
+inline
+SolverBlockCG<VectorType>::AdditionalData::
+AdditionalData (const double rank_tolerance)
+  :
+  rank_tolerance (rank_tolerance)
+{}
+
+
+
+template <typename VectorType>
+SolverBlockCG<VectorType>::SolverBlockCG (SolverControl            &cn,
+                                          VectorMemory<VectorType> &mem,
+                                          const AdditionalData     &data)
+  :
+  Solver<VectorType>(cn,mem),
+  solver_control (cn),
+  additional_data (data)
+{}
+
+
+
+template <typename VectorType>
+SolverBlockCG<VectorType>::SolverBlockCG (SolverControl        &cn,
+                                          const AdditionalData &data)
+  :
+  Solver<VectorType>(cn),
+  solver_control (cn),
+  additional_data (data)
+{}
+
+
+
+template <typename VectorType>
+template <typename MatrixType, typename PreconditionerType>
+void
+SolverBlockCG<VectorType>::solve (const MatrixType              &A,
+                                  std::vector<VectorType>       &x,
+                                  const std::vector<VectorType> &b,
+                                  const PreconditionerType      &precondition)
+{
+  AssertDimension (x.size(), b.size());
+  const unsigned int n_rhs = b.size();
+  if (n_rhs == 0)
+    return;
+
+  deallog.push("BlockCG");
+
+  typename internal::SolverGMRES::TmpVectors<VectorType> r (n_rhs, this->memory);
+  typename internal::SolverGMRES::TmpVectors<VectorType> z (n_rhs, this->memory);
+  typename internal::SolverGMRES::TmpVectors<VectorType> p (n_rhs, this->memory);
+  typename internal::SolverGMRES::TmpVectors<VectorType> q (n_rhs, this->memory);
+
+  // compute the initial residuals with one pass through the matrix
+  std::vector<VectorType *> dst (n_rhs);
+  std::vector<const VectorType *> src (n_rhs);
+  for (unsigned int j=0; j<n_rhs; ++j)
+    {
+      dst[j] = &r(j, x[j]);
+      src[j] = &x[j];
+    }
+  internal::SolverBlockKrylov::multi_vmult (A, dst, src);
+
+  std::vector<double> residuals (n_rhs), tolerances (n_rhs);
+  double max_residual = 0.;
+  for (unsigned int j=0; j<n_rhs; ++j)
+    {
+      r[j].sadd (-1., 1., b[j]);
+      residuals[j] = r[j].l2_norm();
+      tolerances[j] = internal::SolverBlockKrylov::column_tolerance (solver_control,
+                      residuals[j]);
+      max_residual = std::max (max_residual, residuals[j]);
+    }
+
+  unsigned int step = 0;
+  SolverControl::State state = this->iteration_status (step, max_residual, x[0]);
+
+  std::vector<unsigned int> active;
+  unsigned int n_directions = 0;
+  FullMatrix<double> products, PtQ_inverse (n_rhs, n_rhs);
+  Vector<double> h (n_rhs);
+  std::vector<const VectorType *> p_vectors, q_vectors, right;
+  std::vector<double> factors;
+  while (state == SolverControl::iterate)
+    {
+      // remove the converged systems from the block
+      active.clear();
+      for (unsigned int j=0; j<n_rhs; ++j)
+        if (residuals[j] > tolerances[j])
+          active.push_back (j);
+      if (active.empty())
+        break;
+      const unsigned int n_active = active.size();
+
+      // apply the preconditioner to the residuals of the active systems
+      dst.resize (n_active);
+      src.resize (n_active);
+      for (unsigned int a=0; a<n_active; ++a)
+        {
+          dst[a] = &z(a, x[0]);
+          src[a] = &r[active[a]];
+        }
+      internal::SolverBlockKrylov::multi_vmult (precondition, dst, src);
+
+      // make the new directions conjugate to the previous ones,
+      // z -= P (P^T A P)^{-1} Q^T z
+      if (n_directions > 0)
+        {
+          right.resize (n_active);
+          for (unsigned int a=0; a<n_active; ++a)
+            right[a] = &z[a];
+          internal::SolverGMRES::inner_products (q_vectors, right, products);
+          factors.resize (n_directions);
+          for (unsigned int a=0; a<n_active; ++a)
+            {
+              for (unsigned int i=0; i<n_directions; ++i)
+                {
+                  double sum = 0.;
+                  for (unsigned int l=0; l<n_directions; ++l)
+                    sum += PtQ_inverse(i,l) * products(l,a);
+                  factors[i] = -sum;
+                }
+              internal::SolverGMRES::add_linear_combination (p_vectors, factors,
+                                                             z[a]);
+            }
+        }
+
+      // orthonormalize the new directions and remove the ones that are
+      // linearly dependent. the conjugacy to the previous directions is not
+      // affected by this
+      n_directions = 0;
+      for (unsigned int a=0; a<n_active; ++a)
+        if (internal::SolverBlockKrylov::append_to_basis (p, n_directions, z[a],
+                                                          additional_data.rank_tolerance,
+                                                          h) > 0.)
+          ++n_directions;
+      if (n_directions == 0)
+        break;
+
+      // compute Q = A P with one pass through the matrix
+      p_vectors.resize (n_directions);
+      q_vectors.resize (n_directions);
+      dst.resize (n_directions);
+      for (unsigned int i=0; i<n_directions; ++i)
+        {
+          p_vectors[i] = &p[i];
+          dst[i] = &q(i, x[0]);
+          q_vectors[i] = dst[i];
+        }
+      internal::SolverBlockKrylov::multi_vmult (A, dst, p_vectors);
+
+      // compute P^T A P and P^T R with a single reduction
+      right = q_vectors;
+      for (unsigned int a=0; a<n_active; ++a)
+        right.push_back (&r[active[a]]);
+      internal::SolverGMRES::inner_products (p_vectors, right, products);
+
+      PtQ_inverse.reinit (n_directions, n_directions);
+      for (unsigned int i=0; i<n_directions; ++i)
+        for (unsigned int l=0; l<n_directions; ++l)
+          PtQ_inverse(i,l) = 0.5 * (products(i,l) + products(l,i));
+      PtQ_inverse.gauss_jordan();
+
+      // update the solutions and residuals of the active systems
+      max_residual = 0.;
+      factors.resize (n_directions);
+      for (unsigned int a=0; a<n_active; ++a)
+        {
+          const unsigned int j = active[a];
+          for (unsigned int i=0; i<n_directions; ++i)
+            {
+              double sum = 0.;
+              for (unsigned int l=0; l<n_directions; ++l)
+                sum += PtQ_inverse(i,l) * products(l,n_directions+a);
+              factors[i] = sum;
+            }
+          internal::SolverGMRES::add_linear_combination (p_vectors, factors,
+                                                         x[j]);
+          for (unsigned int i=0; i<n_directions; ++i)
+            factors[i] = -factors[i];
+          internal::SolverGMRES::add_linear_combination (q_vectors, factors,
+                                                         r[j]);
+          residuals[j] = r[j].l2_norm();
+        }
+      for (unsigned int j=0; j<n_rhs; ++j)
+        max_residual = std::max (max_residual, residuals[j]);
+
+      state = this->iteration_status (++step, max_residual, x[active[0]]);
+    }
+
+  deallog.pop();
+
+  // in case of failure: throw exception
+  if (state != SolverControl::success)
+    AssertThrow(false, SolverControl::NoConvergence (step, max_residual));
+}
+
+
+
+template <typename VectorType>
+inline
+SolverBlockGMRES<VectorType>::AdditionalData::
+AdditionalData (const unsigned int max_block_steps,
+                const double       rank_tolerance)
+  :
+  max_block_steps (max_block_steps),
+  rank_tolerance (rank_tolerance)
+{}
+
+
+
+template <typename VectorType>
+SolverBlockGMRES<VectorType>::SolverBlockGMRES (SolverControl            &cn,
+                                                VectorMemory<VectorType> &mem,
+                                                const AdditionalData     &data)
+  :
+  Solver<VectorType>(cn,mem),
+  solver_control (cn),
+  additional_data (data)
+{}
+
+
+
+template <typename VectorType>
+SolverBlockGMRES<VectorType>::SolverBlockGMRES (SolverControl        &cn,
+                                                const AdditionalData &data)
+  :
+  Solver<VectorType>(cn),
+  solver_control (cn),
+  additional_data (data)
+{}
+
+
+
+template <typename VectorType>
+template <typename MatrixType, typename PreconditionerType>
+void
+SolverBlockGMRES<VectorType>::solve (const MatrixType              &A,
+                                     std::vector<VectorType>       &x,
+                                     const std::vector<VectorType> &b,
+                                     const PreconditionerType      &precondition)
+{
+  AssertDimension (x.size(), b.size());
+  Assert (additional_data.max_block_steps > 0,
+          ExcMessage ("The number of block steps must be at least one."));
+  const unsigned int n_rhs = b.size();
+  if (n_rhs == 0)
+    return;
+
+  deallog.push("BlockGMRES");
+
+  const unsigned int max_basis_size = n_rhs * (additional_data.max_block_steps+1);
+  typename internal::SolverGMRES::TmpVectors<VectorType> basis (max_basis_size,
+      this->memory);
+  typename internal::SolverGMRES::TmpVectors<VectorType> w (n_rhs, this->memory);
+  typename internal::SolverGMRES::TmpVectors<VectorType> z (n_rhs, this->memory);
+
+  std::vector<double> residuals (n_rhs), tolerances (n_rhs);
+  std::vector<unsigned int> active (n_rhs);
+  for (unsigned int j=0; j<n_rhs; ++j)
+    active[j] = j;
+
+  // the Hessenberg matrix of the block Arnoldi process, and the
+  // coefficients of the residuals of the active systems in the basis
+  FullMatrix<double> H, H1, S;
+  Householder<double> house;
+  Vector<double> h (max_basis_size), y, rhs;
+
+  std::vector<VectorType *> dst;
+  std::vector<const VectorType *> src, basis_vectors;
+  std::vector<double> factors;
+
+  unsigned int step = 0;
+  double max_residual = 0.;
+  SolverControl::State state = SolverControl::iterate;
+  while (state == SolverControl::iterate)
+    {
+      // compute the residuals of the systems that have not converged at the
+      // last restart with one pass through the matrix
+      const unsigned int n_candidates = active.size();
+      dst.resize (n_candidates);
+      src.resize (n_candidates);
+      for (unsigned int a=0; a<n_candidates; ++a)
+        {
+          dst[a] = &w(a, x[0]);
+          src[a] = &x[active[a]];
+        }
+      internal::SolverBlockKrylov::multi_vmult (A, dst, src);
+      for (unsigned int a=0; a<n_candidates; ++a)
+        {
+          w[a].sadd (-1., 1., b[active[a]]);
+          residuals[active[a]] = w[a].l2_norm();
+          if (step == 0)
+            tolerances[active[a]] = internal::SolverBlockKrylov::column_tolerance
+                                    (solver_control, residuals[active[a]]);
+        }
+      max_residual = *std::max_element (residuals.begin(), residuals.end());
+
+      // check the residual here as well since we may have obtained the
+      // solution after a restart
+      state = this->iteration_status (step, max_residual, x[0]);
+      if (state != SolverControl::iterate)
+        break;
+
+      // remove the converged systems from the block, and put the residuals
+      // of the remaining ones into the first positions
+      std::vector<unsigned int> new_active;
+      for (unsigned int a=0; a<n_candidates; ++a)
+        if (residuals[active[a]] > tolerances[active[a]])
+          {
+            if (new_active.size() < a)
+              w[new_active.size()] = w[a];
+            new_active.push_back (active[a]);
+          }
+      active.swap (new_active);
+      const unsigned int n_active = active.size();
+      if (n_active == 0)
+        break;
+
+      // orthonormalize the residuals to get the first block of the basis
+      unsigned int n_basis = 0;
+      S.reinit (max_basis_size, n_active);
+      for (unsigned int a=0; a<n_active; ++a)
+        {
+          const double norm =
+            internal::SolverBlockKrylov::append_to_basis (basis, n_basis, w[a],
+                                                          additional_data.rank_tolerance,
+                                                          h);
+          for (unsigned int i=0; i<n_basis; ++i)
+            S(i,a) = h(i);
+          if (norm > 0.)
+            S(n_basis++,a) = norm;
+        }
+
+      H.reinit (max_basis_size, max_basis_size);
+      unsigned int block_begin = 0, block_end = n_basis, n_processed = 0;
+      while (block_end > block_begin)
+        {
+          const unsigned int block_size = block_end - block_begin;
+          if (block_end + block_size > max_basis_size)
+            break;
+
+          // apply the preconditioner and the matrix to the new block of
+          // basis vectors with one pass each
+          dst.resize (block_size);
+          src.resize (block_size);
+          for (unsigned int i=0; i<block_size; ++i)
+            {
+              dst[i] = &z(i, x[0]);
+              src[i] = &basis[block_begin+i];
+            }
+          internal::SolverBlockKrylov::multi_vmult (precondition, dst, src);
+          for (unsigned int i=0; i<block_size; ++i)
+            {
+              src[i] = dst[i];
+              dst[i] = &w[i];
+            }
+          internal::SolverBlockKrylov::multi_vmult (A, dst, src);
+
+          // orthogonalize the images against the basis and add the ones
+          // that are not linearly dependent
+          for (unsigned int i=0; i<block_size; ++i, ++n_processed)
+            {
+              const double norm =
+                internal::SolverBlockKrylov::append_to_basis (basis, n_basis, w[i],
+                                                              additional_data.rank_tolerance,
+                                                              h);
+              for (unsigned int k=0; k<n_basis; ++k)
+                H(k,n_processed) = h(k);
+              if (norm > 0.)
+                H(n_basis++,n_processed) = norm;
+            }
+          block_begin = block_end;
+          block_end = n_basis;
+
+          // solve the least-squares problems of all active systems to get
+          // their residual norms
+          H1.reinit (n_basis, n_processed);
+          H1.fill (H);
+          house.initialize (H1);
+          y.reinit (n_processed);
+          rhs.reinit (n_basis);
+          for (unsigned int a=0; a<n_active; ++a)
+            {
+              for (unsigned int k=0; k<n_basis; ++k)
+                rhs(k) = S(k,a);
+              residuals[active[a]] = house.least_squares (y, rhs);
+            }
+          max_residual = *std::max_element (residuals.begin(), residuals.end());
+
+          state = this->iteration_status (++step, max_residual, x[0]);
+          if (state != SolverControl::iterate)
+            break;
+        }
+
+      // update the solutions by the preconditioned linear combinations of
+      // the basis vectors
+      if (n_processed > 0)
+        {
+          basis_vectors.resize (n_processed);
+          for (unsigned int k=0; k<n_processed; ++k)
+            basis_vectors[k] = &basis[k];
+          rhs.reinit (n_basis);
+          factors.resize (n_processed);
+          dst.resize (n_active);
+          src.resize (n_active);
+          for (unsigned int a=0; a<n_active; ++a)
+            {
+              for (unsigned int k=0; k<n_basis; ++k)
+                rhs(k) = S(k,a);
+              house.least_squares (y, rhs);
+              for (unsigned int k=0; k<n_processed; ++k)
+                factors[k] = y(k);
+              w[a] = 0.;
+              internal::SolverGMRES::add_linear_combination (basis_vectors, factors,
+                                                             w[a]);
+              dst[a] = &z(a, x[0]);
+              src[a] = &w[a];
+            }
+          internal::SolverBlockKrylov::multi_vmult (precondition, dst, src);
+          for (unsigned int a=0; a<n_active; ++a)
+            x[active[a]] += z[a];
+        }
+    }
+
+  deallog.pop();
+
+  // in case of failure: throw exception
+  if (state != SolverControl::success)
+    AssertThrow(false, SolverControl::NoConvergence (step, max_residual));
+}
+
+#endif // DOXYGEN
+
+DEAL_II_NAMESPACE_CLOSE
+
+#endif
@@ -21,6 +21,7 @@
 #include <deal.II/base/config.h>
 #include <deal.II/base/subscriptor.h>
 #include <deal.II/base/logstream.h>
+#include <deal.II/base/mpi.h>
 #include <deal.II/lac/householder.h>
 #include <deal.II/lac/solver.h>
 #include <deal.II/lac/solver_control.h>
@@ -30,10 +31,20 @@
 
 #include <vector>
 #include <cmath>
+#include <complex>
 #include <algorithm>
 
 DEAL_II_NAMESPACE_OPEN
 
+// forward declaration
+namespace LinearAlgebra
+{
+  namespace distributed
+  {
+    template <typename Number> class Vector;
+  }
+}
+
 /*!@addtogroup Solvers */
 /*@{*/
 
@@ -107,6 +118,78 @@ namespace internal
        */
       unsigned int offset;
     };
+
+    /**
+     * Compute the inner products between each of the vectors in @p left and
+     * each of the vectors in @p right and store them in @p result, which is
+     * resized to <tt>left.size() x right.size()</tt>. For dealii::Vector and
+     * LinearAlgebra::distributed::Vector, the inner products with one vector
+     * of @p right are computed by its multi_dot() function in a single sweep
+     * through the vectors. For LinearAlgebra::distributed::Vector, the
+     * inner products with all vectors of @p right are summed up with a
+     * single global reduction. For other vector types, the inner product of
+     * the vector class is called for each pair.
+     */
+    template <typename VectorType>
+    void
+    inner_products (const std::vector<const VectorType *> &left,
+                    const std::vector<const VectorType *> &right,
+                    FullMatrix<double>                    &result);
+
+    /**
+     * Add the linear combination of @p vectors with the coefficients given
+     * by @p factors to @p w. For dealii::Vector and
+     * LinearAlgebra::distributed::Vector, this calls multi_add(), which
+     * works in a single sweep through the vectors.
+     */
+    template <typename VectorType>
+    void
+    add_linear_combination (const std::vector<const VectorType *> &vectors,
+                            const std::vector<double>             &factors,
+                            VectorType                            &w);
+
+    /**
+     * Orthogonalize the vector @p vv against the first @p dim (orthonormal)
+     * vectors of @p orthogonal_vectors by the classical Gram-Schmidt
+     * algorithm with one step of re-orthogonalization. The projections on
+     * all vectors are computed at once by inner_products(), such that each
+     * of the two passes needs only one global reduction; the norm of the
+     * orthogonalized vector is computed within the reduction of the second
+     * pass. The factors used for orthogonalization are stored in @p h. Return
+     * the norm of the orthogonalized vector.
+     */
+    template <typename VectorType>
+    double
+    classical_gram_schmidt (const TmpVectors<VectorType> &orthogonal_vectors,
+                            const unsigned int            dim,
+                            VectorType                   &vv,
+                            dealii::Vector<double>       &h);
+
+    /**
+     * Compute the eigenvalues of the upper left <tt>n x n</tt> block of the
+     * upper Hessenberg matrix @p H by the shifted QR algorithm. This
+     * function does not need LAPACK and is meant for the small matrices of
+     * the Arnoldi process.
+     */
+    void
+    compute_hessenberg_eigenvalues (const FullMatrix<double>            &H,
+                                    const unsigned int                   n,
+                                    std::vector<std::complex<double> > &eigenvalues);
+
+    /**
+     * Select @p n_shifts shifts for the Newton basis of SolverSStepGMRES out
+     * of the given Ritz values by Leja ordering. Complex conjugate pairs of
+     * Ritz values take two consecutive positions, such that the basis can be
+     * computed in real arithmetic: the shift at position @p i is applied as
+     * $v_{i+1} = (A - \text{shift\_real}_i) v_i + \text{shift\_coupling}_i
+     * v_{i-1}$, where the coupling is the square of the imaginary part for
+     * the second entry of a pair and zero otherwise.
+     */
+    void
+    compute_newton_shifts (const std::vector<std::complex<double> > &ritz_values,
+                           const unsigned int                        n_shifts,
+                           std::vector<double>                      &shift_real,
+                           std::vector<double>                      &shift_coupling);
   }
 }
 
@@ -156,6 +239,21 @@ namespace internal
  * class, see the documentation of the Solver base class.
  *
  *
+ * <h3>Orthogonalization</h3>
+ *
+ * By default, each new vector is orthogonalized against the Arnoldi basis by
+ * the modified Gram-Schmidt algorithm, which computes one inner product after
+ * the other. In parallel computations, each of these inner products is a
+ * global reduction, which makes the orthogonalization latency bound for
+ * large bases and many processors. The classical Gram-Schmidt algorithm,
+ * selected by AdditionalData::orthogonalization_strategy, computes the
+ * projections on all basis vectors at once and needs only one reduction for
+ * them. For LinearAlgebra::distributed::Vector, these inner products are
+ * computed in a single sweep through the vectors. Since the classical
+ * algorithm is less stable, the orthogonalization is always done twice. See
+ * also SolverSStepGMRES for a variant that needs even fewer reductions.
+ *
+ *
  * <h3>Observing the progress of linear solver iterations</h3>
  *
  * The solve() function of this class uses the mechanism described in the
@@ -186,17 +284,41 @@ public:
    */
   struct AdditionalData
   {
+    /**
+     * The algorithms available for the orthogonalization of a new vector
+     * against the Arnoldi basis.
+     */
+    enum OrthogonalizationStrategy
+    {
+      /**
+       * The modified Gram-Schmidt algorithm, which computes the projections
+       * on the basis vectors one after the other. This needs one global
+       * reduction per basis vector in parallel computations.
+       */
+      modified_gram_schmidt,
+      /**
+       * The classical Gram-Schmidt algorithm with one step of
+       * re-orthogonalization, which computes the projections on all basis
+       * vectors at once. This needs two global reductions per iteration,
+       * independent of the size of the basis, and twice the vector access
+       * of the modified Gram-Schmidt algorithm without re-orthogonalization.
+       */
+      classical_gram_schmidt
+    };
+
     /**
      * Constructor. By default, set the number of temporary vectors to 30,
      * i.e. do a restart every 28 iterations. Also set preconditioning from
      * left, the residual of the stopping criterion to the default residual,
-     * and re-orthogonalization only if necessary.
+     * re-orthogonalization only if necessary, and the modified Gram-Schmidt
+     * algorithm.
      */
     explicit
     AdditionalData (const unsigned int max_n_tmp_vectors = 30,
                     const bool right_preconditioning = false,
                     const bool use_default_residual = true,
-                    const bool force_re_orthogonalization = false);
+                    const bool force_re_orthogonalization = false,
+                    const OrthogonalizationStrategy orthogonalization_strategy = modified_gram_schmidt);
 
     /**
      * Constructor.
@@ -234,10 +356,17 @@ public:
      * Flag to force re-orthogonalization of orthonormal basis in every step.
      * If set to false, the solver automatically checks for loss of
      * orthogonality every 5 iterations and enables re-orthogonalization only
-     * if necessary.
+     * if necessary. This flag only applies to the modified Gram-Schmidt
+     * algorithm, the classical Gram-Schmidt algorithm always
+     * re-orthogonalizes.
      */
     bool force_re_orthogonalization;
 
+    /**
+     * The algorithm used for the orthogonalization of the Arnoldi basis.
+     */
+    OrthogonalizationStrategy orthogonalization_strategy;
+
     /**
      * Compute all eigenvalues of the Hessenberg matrix generated while
      * solving, i.e., the projected system matrix. This gives an approximation
@@ -468,19 +597,35 @@ public:
   struct AdditionalData
   {
     /**
-     * Constructor. By default, set the maximum basis size to 30.
+     * The algorithms available for the orthogonalization, see
+     * SolverGMRES::AdditionalData::OrthogonalizationStrategy.
+     */
+    typedef typename SolverGMRES<VectorType>::AdditionalData::OrthogonalizationStrategy
+    OrthogonalizationStrategy;
+
+    /**
+     * Constructor. By default, set the maximum basis size to 30 and use the
+     * modified Gram-Schmidt algorithm.
      */
     explicit
     AdditionalData(const unsigned int max_basis_size = 30,
-                   const bool /*use_default_residual*/ = true)
+                   const bool /*use_default_residual*/ = true,
+                   const OrthogonalizationStrategy orthogonalization_strategy =
+                     SolverGMRES<VectorType>::AdditionalData::modified_gram_schmidt)
       :
-      max_basis_size(max_basis_size)
+      max_basis_size(max_basis_size),
+      orthogonalization_strategy(orthogonalization_strategy)
     {}
 
     /**
      * Maximum number of tmp vectors.
      */
     unsigned int    max_basis_size;
+
+    /**
+     * The algorithm used for the orthogonalization of the Arnoldi basis.
+     */
+    OrthogonalizationStrategy orthogonalization_strategy;
   };
 
   /**
@@ -525,6 +670,167 @@ private:
   FullMatrix<double> H1;
 };
 
+/**
+ * Implementation of the s-step variant of the restarted GMRES method with
+ * right preconditioning, also called communication-avoiding GMRES. Instead
+ * of orthogonalizing each new Krylov vector as soon as it has been computed,
+ * the method first computes AdditionalData::s Krylov vectors by repeated
+ * application of the preconditioner and the matrix, and then orthogonalizes
+ * all of them at once:
+ * <ol>
+ * <li> The new vectors are orthogonalized against the previous basis
+ * vectors by the block version of the classical Gram-Schmidt algorithm with
+ * re-orthogonalization, i.e., two times all inner products between the
+ * previous and the new vectors in one global reduction.
+ * <li> The new vectors are orthonormalized among each other by the Cholesky
+ * QR algorithm, applied twice for stability, which needs the matrix of all
+ * inner products between the new vectors in one global reduction.
+ * <li> The columns of the Hessenberg matrix of the Arnoldi process are
+ * reconstructed from the triangular factors of the orthogonalization and the
+ * change of basis between the Krylov vectors and the Arnoldi basis.
+ * </ol>
+ * This amounts to four global reductions for @p s iterations, compared to two
+ * per iteration for SolverGMRES with the classical Gram-Schmidt algorithm and
+ * to as many as the size of the basis for the modified Gram-Schmidt
+ * algorithm. The inner products are computed as described for the classical
+ * Gram-Schmidt algorithm in SolverGMRES.
+ *
+ * The monomial basis $v, Av, A^2v, \ldots$ quickly becomes numerically
+ * linearly dependent. Therefore, the Krylov vectors are computed in the
+ * Newton basis $v_{i+1} = (A - \theta_i I) v_i$ with shifts $\theta_i$ that
+ * are approximations of the eigenvalues of the preconditioned matrix, the
+ * Ritz values. They are computed from the Hessenberg matrix of the first @p s
+ * steps of the first cycle, which are done by the standard Arnoldi process
+ * with the classical Gram-Schmidt algorithm, and put into Leja order. Complex
+ * conjugate pairs of shifts are applied in real arithmetic. The Ritz values
+ * are computed by a QR algorithm on the small Hessenberg matrix, so this
+ * class does not need LAPACK.
+ *
+ * If the Cholesky factorization of a block breaks down because the new
+ * vectors are numerically linearly dependent, e.g. when the Krylov space is
+ * close to invariant, the vectors of this block are recomputed by the
+ * standard Arnoldi process. Larger values of @p s reduce the number of
+ * reductions, but make such breakdowns more likely; values between 4 and 10
+ * are typical.
+ *
+ * Each new Krylov vector counts as one iteration for the SolverControl. The
+ * convergence criterion is the norm of the unpreconditioned residual as
+ * computed from the least-squares problem in the Krylov space, which is
+ * checked after each block for all its vectors. Like for SolverFGMRES, the
+ * basis is discarded after AdditionalData::max_basis_size iterations and the
+ * iteration is restarted from the current approximation.
+ *
+ * @see M. Hoemmen: "Communication-avoiding Krylov subspace methods", PhD
+ * thesis, University of California, Berkeley, 2010, and Z. Bai, D. Hu, L.
+ * Reichel: "A Newton basis GMRES implementation", IMA J. Numer. Anal. 14,
+ * 1994.
+ */
+template <class VectorType = Vector<double> >
+class SolverSStepGMRES : public Solver<VectorType>
+{
+public:
+  /**
+   * Standardized data struct to pipe additional data to the solver.
+   */
+  struct AdditionalData
+  {
+    /**
+     * Constructor. By default, set the maximum basis size to 30 and compute
+     * 5 Krylov vectors per step.
+     */
+    explicit
+    AdditionalData (const unsigned int max_basis_size = 30,
+                    const unsigned int s = 5)
+      :
+      max_basis_size(max_basis_size),
+      s(s)
+    {}
+
+    /**
+     * Maximum size of the Arnoldi basis before a restart.
+     */
+    unsigned int max_basis_size;
+
+    /**
+     * The number of Krylov vectors that are computed before they are
+     * orthogonalized together.
+     */
+    unsigned int s;
+  };
+
+  /**
+   * Constructor.
+   */
+  SolverSStepGMRES (SolverControl            &cn,
+                    VectorMemory<VectorType> &mem,
+                    const AdditionalData     &data=AdditionalData());
+
+  /**
+   * Constructor. Use an object of type GrowingVectorMemory as a default to
+   * allocate memory.
+   */
+  SolverSStepGMRES (SolverControl        &cn,
+                    const AdditionalData &data=AdditionalData());
+
+  /**
+   * Solve the linear system $Ax=b$ for x.
+   */
+  template<typename MatrixType, typename PreconditionerType>
+  void
+  solve (const MatrixType         &A,
+         VectorType               &x,
+         const VectorType         &b,
+         const PreconditionerType &precondition);
+
+private:
+  /**
+   * Compute the basis vector <tt>j+1</tt> by one step of the standard
+   * Arnoldi process with the classical Gram-Schmidt algorithm and store the
+   * new column of the Hessenberg matrix in @p H.
+   */
+  template<typename MatrixType, typename PreconditionerType>
+  void
+  arnoldi_step (const MatrixType                              &A,
+                const PreconditionerType                      &precondition,
+                internal::SolverGMRES::TmpVectors<VectorType> &basis,
+                VectorType                                    &tmp,
+                const unsigned int                             j,
+                FullMatrix<double>                            &H) const;
+
+  /**
+   * Compute the basis vectors <tt>j+1</tt> to <tt>j+block_size</tt> by one
+   * step of the s-step method and store the new columns of the Hessenberg
+   * matrix in @p H. Return false if the orthogonalization broke down, in
+   * which case the basis vectors need to be recomputed.
+   */
+  template<typename MatrixType, typename PreconditionerType>
+  bool
+  s_step (const MatrixType                              &A,
+          const PreconditionerType                      &precondition,
+          internal::SolverGMRES::TmpVectors<VectorType> &basis,
+          VectorType                                    &tmp,
+          const unsigned int                             j,
+          const unsigned int                             block_size,
+          FullMatrix<double>                            &H) const;
+
+  /**
+   * Additional flags.
+   */
+  AdditionalData additional_data;
+
+  /**
+   * The real parts of the shifts of the Newton basis.
+   */
+  std::vector<double> shift_real;
+
+  /**
+   * The coupling to the previous vector in the Newton basis, which is the
+   * square of the imaginary part for the second shift of a complex
+   * conjugate pair and zero otherwise.
+   */
+  std::vector<double> shift_coupling;
+};
+
 /*@}*/
 /* --------------------- Inline and template functions ------------------- */
 
@@ -593,6 +899,34 @@ namespace internal
     }
 
 
+    // Transform the new column of an upper Hessenberg matrix into
+    // triangular structure by applying the previous Givens rotations and a
+    // new one, which is also applied to the right hand side b
+    inline
+    void givens_rotation (dealii::Vector<double> &h,
+                          dealii::Vector<double> &b,
+                          dealii::Vector<double> &ci,
+                          dealii::Vector<double> &si,
+                          const int               col)
+    {
+      for (int i=0 ; i<col ; i++)
+        {
+          const double s = si(i);
+          const double c = ci(i);
+          const double dummy = h(i);
+          h(i)   =  c*dummy + s*h(i+1);
+          h(i+1) = -s*dummy + c*h(i+1);
+        };
+
+      const double r = 1./std::sqrt(h(col)*h(col) + h(col+1)*h(col+1));
+      si(col) = h(col+1) *r;
+      ci(col) = h(col)   *r;
+      h(col)  =  ci(col)*h(col) + si(col)*h(col+1);
+      b(col+1)= -si(col)*b(col);
+      b(col) *=  ci(col);
+    }
+
+
     // A comparator for better printing eigenvalues
     inline
     bool complex_less_pred(const std::complex<double> &x,
@@ -600,6 +934,162 @@ namespace internal
     {
       return x.real() < y.real() || (x.real() == y.real() && x.imag() < y.imag());
     }
+
+
+
+    template <typename VectorType>
+    void
+    inner_products (const std::vector<const VectorType *> &left,
+                    const std::vector<const VectorType *> &right,
+                    FullMatrix<double>                    &result)
+    {
+      result.reinit (left.size(), right.size(), true);
+      for (unsigned int k=0; k<right.size(); ++k)
+        for (unsigned int i=0; i<left.size(); ++i)
+          result(i,k) = *left[i] * *right[k];
+    }
+
+
+
+    template <typename Number>
+    void
+    inner_products (const std::vector<const dealii::Vector<Number> *> &left,
+                    const std::vector<const dealii::Vector<Number> *> &right,
+                    FullMatrix<double>                                &result)
+    {
+      result.reinit (left.size(), right.size(), true);
+      std::vector<Number> products;
+      for (unsigned int k=0; k<right.size(); ++k)
+        {
+          right[k]->multi_dot (left, products);
+          for (unsigned int i=0; i<left.size(); ++i)
+            result(i,k) = products[i];
+        }
+    }
+
+
+
+    template <typename Number>
+    void
+    inner_products (const std::vector<const LinearAlgebra::distributed::Vector<Number> *> &left,
+                    const std::vector<const LinearAlgebra::distributed::Vector<Number> *> &right,
+                    FullMatrix<double>                                                    &result)
+    {
+      result.reinit (left.size(), right.size(), true);
+      if (left.size() == 0 || right.size() == 0)
+        return;
+
+      std::vector<Number> products;
+      if (right.size() == 1)
+        {
+          right[0]->multi_dot (left, products);
+          for (unsigned int i=0; i<left.size(); ++i)
+            result(i,0) = products[i];
+          return;
+        }
+
+      // for several vectors on the right, compute the locally owned parts
+      // of all inner products and sum them up with a single global
+      // reduction
+      std::vector<Number> local_products (left.size()*right.size());
+      for (unsigned int k=0; k<right.size(); ++k)
+        right[k]->multi_dot_local (left, &local_products[k*left.size()]);
+
+      products.resize (local_products.size());
+      Utilities::MPI::sum (local_products, right[0]->get_mpi_communicator(),
+                           products);
+      for (unsigned int k=0; k<right.size(); ++k)
+        for (unsigned int i=0; i<left.size(); ++i)
+          result(i,k) = products[k*left.size()+i];
+    }
+
+
+
+    template <typename VectorType>
+    void
+    add_linear_combination (const std::vector<const VectorType *> &vectors,
+                            const std::vector<double>             &factors,
+                            VectorType                            &w)
+    {
+      AssertDimension (vectors.size(), factors.size());
+      for (unsigned int i=0; i<vectors.size(); ++i)
+        w.add (factors[i], *vectors[i]);
+    }
+
+
+
+    template <typename Number>
+    void
+    add_linear_combination (const std::vector<const dealii::Vector<Number> *> &vectors,
+                            const std::vector<double>                         &factors,
+                            dealii::Vector<Number>                            &w)
+    {
+      w.multi_add (std::vector<Number>(factors.begin(), factors.end()),
+                   vectors);
+    }
+
+
+
+    template <typename Number>
+    void
+    add_linear_combination (const std::vector<const LinearAlgebra::distributed::Vector<Number> *> &vectors,
+                            const std::vector<double>                                             &factors,
+                            LinearAlgebra::distributed::Vector<Number>                            &w)
+    {
+      w.multi_add (std::vector<Number>(factors.begin(), factors.end()),
+                   vectors);
+    }
+
+
+
+    template <typename VectorType>
+    double
+    classical_gram_schmidt (const TmpVectors<VectorType> &orthogonal_vectors,
+                            const unsigned int            dim,
+                            VectorType                   &vv,
+                            dealii::Vector<double>       &h)
+    {
+      Assert (dim > 0, ExcInternalError());
+      std::vector<const VectorType *> vectors (dim);
+      for (unsigned int i=0; i<dim; ++i)
+        vectors[i] = &orthogonal_vectors[i];
+      const std::vector<const VectorType *> right (1, &vv);
+
+      // first pass
+      FullMatrix<double> products;
+      inner_products (vectors, right, products);
+      std::vector<double> factors (dim);
+      for (unsigned int i=0; i<dim; ++i)
+        {
+          h(i) = products(i,0);
+          factors[i] = -products(i,0);
+        }
+      add_linear_combination (vectors, factors, vv);
+
+      // second pass, which also computes the norm of vv before the update.
+      // the norm after the update follows from the Pythagorean theorem
+      // since the vectors are orthonormal
+      vectors.push_back (&vv);
+      inner_products (vectors, right, products);
+      vectors.pop_back ();
+      const double norm_sqr_before = products(dim,0);
+      double norm_sqr = norm_sqr_before;
+      for (unsigned int i=0; i<dim; ++i)
+        {
+          factors[i] = -products(i,0);
+          h(i) += products(i,0);
+          norm_sqr -= products(i,0) * products(i,0);
+        }
+      add_linear_combination (vectors, factors, vv);
+
+      // if the second pass removed a large part of the vector, the
+      // difference above suffers from cancellation, so compute the norm
+      // explicitly in that case
+      if (norm_sqr > 0.5 * norm_sqr_before)
+        return std::sqrt (norm_sqr);
+      else
+        return vv.l2_norm();
+    }
   }
 }
 
@@ -611,12 +1101,14 @@ SolverGMRES<VectorType>::AdditionalData::
 AdditionalData (const unsigned int max_n_tmp_vectors,
                 const bool         right_preconditioning,
                 const bool         use_default_residual,
-                const bool         force_re_orthogonalization)
+                const bool         force_re_orthogonalization,
+                const OrthogonalizationStrategy orthogonalization_strategy)
   :
   max_n_tmp_vectors(max_n_tmp_vectors),
   right_preconditioning(right_preconditioning),
   use_default_residual(use_default_residual),
   force_re_orthogonalization(force_re_orthogonalization),
+  orthogonalization_strategy(orthogonalization_strategy),
   compute_eigenvalues(false)
 {}
 
@@ -635,6 +1127,7 @@ AdditionalData (const unsigned int max_n_tmp_vectors,
   right_preconditioning(right_preconditioning),
   use_default_residual(use_default_residual),
   force_re_orthogonalization(force_re_orthogonalization),
+  orthogonalization_strategy(modified_gram_schmidt),
   compute_eigenvalues(compute_eigenvalues)
 {}
 
@@ -669,21 +1162,7 @@ SolverGMRES<VectorType>::givens_rotation (Vector<double> &h,
                                           Vector<double> &si,
                                           int            col) const
 {
-  for (int i=0 ; i<col ; i++)
-    {
-      const double s = si(i);
-      const double c = ci(i);
-      const double dummy = h(i);
-      h(i)   =  c*dummy + s*h(i+1);
-      h(i+1) = -s*dummy + c*h(i+1);
-    };
-
-  const double r = 1./std::sqrt(h(col)*h(col) + h(col+1)*h(col+1));
-  si(col) = h(col+1) *r;
-  ci(col) = h(col)   *r;
-  h(col)  =  ci(col)*h(col) + si(col)*h(col+1);
-  b(col+1)= -si(col)*b(col);
-  b(col) *=  ci(col);
+  internal::SolverGMRES::givens_rotation (h, b, ci, si, col);
 }
 
 
@@ -976,9 +1455,14 @@ SolverGMRES<VectorType>::solve (const MatrixType         &A,
 
           dim = inner_iteration+1;
 
-          const double s = modified_gram_schmidt(tmp_vectors, dim,
-                                                 accumulated_iterations,
-                                                 vv, h, re_orthogonalize);
+          const double s =
+            (additional_data.orthogonalization_strategy ==
+             AdditionalData::classical_gram_schmidt ?
+             internal::SolverGMRES::classical_gram_schmidt(tmp_vectors, dim,
+                                                           vv, h) :
+             modified_gram_schmidt(tmp_vectors, dim,
+                                   accumulated_iterations,
+                                   vv, h, re_orthogonalize));
           h(inner_iteration+1) = s;
 
           //s=0 is a lucky breakdown, the solver will reach convergence,
@@ -1022,14 +1506,19 @@ SolverGMRES<VectorType>::solve (const MatrixType         &A,
 
               H1.backward(h_,*gamma_);
 
+              std::vector<const VectorType *> vectors (dim);
+              std::vector<double> factors (dim);
+              for (unsigned int i=0; i<dim; ++i)
+                {
+                  vectors[i] = &tmp_vectors[i];
+                  factors[i] = h_(i);
+                }
               if (left_precondition)
-                for (unsigned int i=0 ; i<dim; ++i)
-                  x_->add(h_(i), tmp_vectors[i]);
+                internal::SolverGMRES::add_linear_combination (vectors, factors, *x_);
               else
                 {
                   p = 0.;
-                  for (unsigned int i=0; i<dim; ++i)
-                    p.add(h_(i), tmp_vectors[i]);
+                  internal::SolverGMRES::add_linear_combination (vectors, factors, p);
                   precondition.vmult(*r,p);
                   x_->add(1.,*r);
                 };
@@ -1070,14 +1559,20 @@ SolverGMRES<VectorType>::solve (const MatrixType         &A,
 
       H1.backward(h,gamma);
 
+      // add the linear combination of the basis vectors in a single sweep
+      std::vector<const VectorType *> vectors (dim);
+      std::vector<double> factors (dim);
+      for (unsigned int i=0; i<dim; ++i)
+        {
+          vectors[i] = &tmp_vectors[i];
+          factors[i] = h(i);
+        }
       if (left_precondition)
-        for (unsigned int i=0 ; i<dim; ++i)
-          x.add(h(i), tmp_vectors[i]);
+        internal::SolverGMRES::add_linear_combination (vectors, factors, x);
       else
         {
           p = 0.;
-          for (unsigned int i=0; i<dim; ++i)
-            p.add(h(i), tmp_vectors[i]);
+          internal::SolverGMRES::add_linear_combination (vectors, factors, p);
           precondition.vmult(v,p);
           x.add(1.,v);
         };
@@ -1269,10 +1764,24 @@ SolverFGMRES<VectorType>::solve (const MatrixType         &A,
           A.vmult(*aux, z[j]);
 
           // Gram-Schmidt
-          H(0,j) = *aux * v[0];
-          for (unsigned int i=1; i<=j; ++i)
-            H(i,j) = aux->add_and_dot(-H(i-1,j), v[i-1], v[i]);
-          H(j+1,j) = a = std::sqrt(aux->add_and_dot(-H(j,j), v[j], *aux));
+          if (additional_data.orthogonalization_strategy ==
+              SolverGMRES<VectorType>::AdditionalData::classical_gram_schmidt)
+            {
+              // the inner products and the update of all previous basis
+              // vectors are each done in a single sweep
+              Vector<double> h (j+1);
+              a = internal::SolverGMRES::classical_gram_schmidt (v, j+1, *aux, h);
+              for (unsigned int i=0; i<=j; ++i)
+                H(i,j) = h(i);
+              H(j+1,j) = a;
+            }
+          else
+            {
+              H(0,j) = *aux * v[0];
+              for (unsigned int i=1; i<=j; ++i)
+                H(i,j) = aux->add_and_dot(-H(i-1,j), v[i-1], v[i]);
+              H(j+1,j) = a = std::sqrt(aux->add_and_dot(-H(j,j), v[j], *aux));
+            }
 
           // Compute projected solution
 
@@ -1297,8 +1806,14 @@ SolverFGMRES<VectorType>::solve (const MatrixType         &A,
         }
 
       // Update solution vector
+      std::vector<const VectorType *> vectors (y.size());
+      std::vector<double> factors (y.size());
       for (unsigned int j=0; j<y.size(); ++j)
-        x.add(y(j), z[j]);
+        {
+          vectors[j] = &z[j];
+          factors[j] = y(j);
+        }
+      internal::SolverGMRES::add_linear_combination (vectors, factors, x);
     }
   while (iteration_state == SolverControl::iterate);
 
@@ -1311,6 +1826,340 @@ SolverFGMRES<VectorType>::solve (const MatrixType         &A,
                                                      res));
 }
 
+
+//----------------------------------------------------------------------//
+
+template <class VectorType>
+SolverSStepGMRES<VectorType>::SolverSStepGMRES (SolverControl            &cn,
+                                                VectorMemory<VectorType> &mem,
+                                                const AdditionalData     &data)
+  :
+  Solver<VectorType> (cn, mem),
+  additional_data(data)
+{}
+
+
+
+template <class VectorType>
+SolverSStepGMRES<VectorType>::SolverSStepGMRES (SolverControl        &cn,
+                                                const AdditionalData &data)
+  :
+  Solver<VectorType> (cn),
+  additional_data(data)
+{}
+
+
+
+template<class VectorType>
+template<typename MatrixType, typename PreconditionerType>
+void
+SolverSStepGMRES<VectorType>::arnoldi_step
+(const MatrixType                              &A,
+ const PreconditionerType                      &precondition,
+ internal::SolverGMRES::TmpVectors<VectorType> &basis,
+ VectorType                                    &tmp,
+ const unsigned int                             j,
+ FullMatrix<double>                            &H) const
+{
+  VectorType &vv = basis(j+1, tmp);
+  precondition.vmult(tmp, basis[j]);
+  A.vmult(vv, tmp);
+
+  Vector<double> h(j+1);
+  const double s = internal::SolverGMRES::classical_gram_schmidt(basis, j+1,
+                   vv, h);
+  for (unsigned int i=0; i<=j; ++i)
+    H(i,j) = h(i);
+  H(j+1,j) = s;
+
+  // s=0 is a lucky breakdown, the solver will reach convergence, but we
+  // must not divide by zero here
+  if (s != 0)
+    vv *= 1./s;
+}
+
+
+
+template<class VectorType>
+template<typename MatrixType, typename PreconditionerType>
+bool
+SolverSStepGMRES<VectorType>::s_step
+(const MatrixType                              &A,
+ const PreconditionerType                      &precondition,
+ internal::SolverGMRES::TmpVectors<VectorType> &basis,
+ VectorType                                    &tmp,
+ const unsigned int                             j,
+ const unsigned int                             block_size,
+ FullMatrix<double>                            &H) const
+{
+  Assert (block_size <= shift_real.size(), ExcInternalError());
+  const unsigned int n_old = j+1;
+
+  // generate the Newton basis w_0 = v_j, w_{i+1} = (A M^{-1} - real_i) w_i
+  // + coupling_i w_{i-1}, stored in the basis vectors j+1 to j+block_size
+  for (unsigned int i=0; i<block_size; ++i)
+    {
+      VectorType &w = basis(j+1+i, tmp);
+      precondition.vmult(tmp, basis[j+i]);
+      A.vmult(w, tmp);
+      w.add(-shift_real[i], basis[j+i]);
+      if (shift_coupling[i] != 0.)
+        w.add(shift_coupling[i], basis[j+i-1]);
+    }
+
+  std::vector<const VectorType *> old_vectors (n_old), new_vectors (block_size);
+  for (unsigned int i=0; i<n_old; ++i)
+    old_vectors[i] = &basis[i];
+  for (unsigned int i=0; i<block_size; ++i)
+    new_vectors[i] = &basis[j+1+i];
+
+  // block classical Gram-Schmidt with re-orthogonalization against the
+  // previous basis vectors, accumulating the projections in C
+  FullMatrix<double> C (n_old, block_size), products;
+  std::vector<double> factors (n_old);
+  for (unsigned int pass=0; pass<2; ++pass)
+    {
+      internal::SolverGMRES::inner_products (old_vectors, new_vectors,
+                                             products);
+      for (unsigned int k=0; k<block_size; ++k)
+        {
+          for (unsigned int i=0; i<n_old; ++i)
+            factors[i] = -products(i,k);
+          internal::SolverGMRES::add_linear_combination (old_vectors, factors,
+                                                         basis[j+1+k]);
+        }
+      C.add (1., products);
+    }
+
+  // Cholesky QR, applied twice: factorize the Gram matrix of the new
+  // vectors as R^T R and replace the vectors by W R^{-1}. the triangular
+  // factors of both passes are accumulated in R_new
+  FullMatrix<double> R_new (block_size, block_size), R (block_size, block_size);
+  for (unsigned int i=0; i<block_size; ++i)
+    R_new(i,i) = 1.;
+  for (unsigned int pass=0; pass<2; ++pass)
+    {
+      internal::SolverGMRES::inner_products (new_vectors, new_vectors,
+                                             products);
+      R = 0.;
+      for (unsigned int k=0; k<block_size; ++k)
+        {
+          for (unsigned int i=0; i<=k; ++i)
+            {
+              double sum = products(i,k);
+              for (unsigned int l=0; l<i; ++l)
+                sum -= R(l,i) * R(l,k);
+              if (i < k)
+                R(i,k) = sum / R(i,i);
+              else
+                {
+                  // the new vectors are numerically linearly dependent
+                  if (!(sum > 1e-14 * products(k,k)))
+                    return false;
+                  R(k,k) = std::sqrt(sum);
+                }
+            }
+        }
+
+      for (unsigned int k=0; k<block_size; ++k)
+        {
+          std::vector<const VectorType *> previous (new_vectors.begin(),
+                                                    new_vectors.begin()+k);
+          std::vector<double> coefficients (k);
+          for (unsigned int i=0; i<k; ++i)
+            coefficients[i] = -R(i,k);
+          internal::SolverGMRES::add_linear_combination (previous, coefficients,
+                                                         basis[j+1+k]);
+          basis[j+1+k] *= 1./R(k,k);
+        }
+
+      FullMatrix<double> product (block_size, block_size);
+      R.mmult (product, R_new);
+      R_new = product;
+    }
+
+  // the Newton basis W = [w_0,...,w_block_size] is related to the
+  // orthonormal basis V = [v_0,...,v_{j+block_size}] by W = V T with T
+  // having the unit vector e_j in the first column, and C on top of R_new in
+  // the other columns. the recurrence of the Newton basis reads A M^{-1}
+  // W(:,0:s-1) = W B. with the Arnoldi relation for the previous vectors,
+  // the new columns of the Hessenberg matrix follow as H_new = (T B -
+  // [H_old T_top; 0]) T_bot^{-1}, with T_top the rows 0 to j-1 and T_bot
+  // the rows j to j+s-1 of the first s columns of T
+  const unsigned int n_rows = n_old + block_size;
+  FullMatrix<double> T (n_rows, block_size+1);
+  T(j,0) = 1.;
+  for (unsigned int k=0; k<block_size; ++k)
+    {
+      for (unsigned int i=0; i<n_old; ++i)
+        T(i,k+1) = C(i,k);
+      for (unsigned int i=0; i<=k; ++i)
+        T(n_old+i,k+1) = R_new(i,k);
+    }
+
+  FullMatrix<double> H_new (n_rows, block_size);
+  for (unsigned int k=0; k<block_size; ++k)
+    for (unsigned int i=0; i<n_rows; ++i)
+      {
+        double value = T(i,k+1) + shift_real[k] * T(i,k);
+        if (k > 0)
+          value -= shift_coupling[k] * T(i,k-1);
+        H_new(i,k) = value;
+      }
+  for (unsigned int k=1; k<block_size; ++k)
+    for (unsigned int i=0; i<n_old; ++i)
+      for (unsigned int l=0; l<j; ++l)
+        H_new(i,k) -= H(i,l) * T(l,k);
+
+  for (unsigned int k=0; k<block_size; ++k)
+    {
+      for (unsigned int l=0; l<k; ++l)
+        if (T(j+l,k) != 0.)
+          for (unsigned int i=0; i<n_rows; ++i)
+            H_new(i,k) -= H_new(i,l) * T(j+l,k);
+      const double inverse_diagonal = 1./T(j+k,k);
+      for (unsigned int i=0; i<n_rows; ++i)
+        H_new(i,k) *= inverse_diagonal;
+    }
+
+  // copy the new columns, removing the roundoff below the subdiagonal
+  for (unsigned int k=0; k<block_size; ++k)
+    for (unsigned int i=0; i<=j+k+1; ++i)
+      H(i,j+k) = H_new(i,k);
+
+  return true;
+}
+
+
+
+template<class VectorType>
+template<typename MatrixType, typename PreconditionerType>
+void
+SolverSStepGMRES<VectorType>::solve (const MatrixType         &A,
+                                     VectorType               &x,
+                                     const VectorType         &b,
+                                     const PreconditionerType &precondition)
+{
+  deallog.push("SStepGMRES");
+
+  SolverControl::State iteration_state = SolverControl::iterate;
+
+  const unsigned int basis_size = additional_data.max_basis_size;
+  Assert (basis_size > 0, ExcMessage("The basis size must be positive."));
+  const unsigned int s = std::max(1U, std::min(additional_data.s, basis_size));
+
+  // Generate an object where basis vectors are stored.
+  internal::SolverGMRES::TmpVectors<VectorType> basis (basis_size+1, this->memory);
+  typename VectorMemory<VectorType>::Pointer tmp(this->memory), p(this->memory);
+  tmp->reinit(x);
+  p->reinit(x);
+
+  // the shifts are computed from the first Arnoldi steps of each call
+  shift_real.clear();
+  shift_coupling.clear();
+
+  // number of the present iteration; this number is not reset to zero upon a
+  // restart
+  unsigned int accumulated_iterations = 0;
+
+  // the Hessenberg matrix of the Arnoldi relation and its triangular factor
+  // after Givens rotations
+  FullMatrix<double> H (basis_size+1, basis_size), H_rotated (basis_size+1, basis_size);
+  Vector<double> gamma (basis_size+1), ci (basis_size), si (basis_size),
+         h (basis_size+1), y;
+
+  double res = -std::numeric_limits<double>::max();
+  do
+    {
+      VectorType &v = basis(0, x);
+      A.vmult(v, x);
+      v.sadd(-1., 1., b);
+
+      const double beta = v.l2_norm();
+      res = beta;
+      iteration_state = this->iteration_status(accumulated_iterations, res, x);
+      if (iteration_state != SolverControl::iterate)
+        break;
+
+      v *= 1./beta;
+      H = 0.;
+      H_rotated = 0.;
+      gamma = 0.;
+      gamma(0) = beta;
+
+      unsigned int dim = 0;
+      while (dim < basis_size && iteration_state == SolverControl::iterate)
+        {
+          const unsigned int block_size = std::min(s, basis_size-dim);
+          const bool have_shifts = shift_real.size() > 0;
+          if (!have_shifts ||
+              !s_step(A, precondition, basis, *tmp, dim, block_size, H))
+            for (unsigned int k=0; k<block_size; ++k)
+              arnoldi_step(A, precondition, basis, *tmp, dim+k, H);
+
+          // after the first block of Arnoldi steps, compute the shifts for
+          // the Newton basis from the Ritz values
+          if (!have_shifts)
+            {
+              std::vector<std::complex<double> > ritz_values;
+              internal::SolverGMRES::compute_hessenberg_eigenvalues(H, s, ritz_values);
+              internal::SolverGMRES::compute_newton_shifts(ritz_values, s,
+                                                           shift_real,
+                                                           shift_coupling);
+            }
+
+          // transform the new columns to triangular form and check
+          // convergence for each of them
+          const unsigned int end = dim + block_size;
+          for ( ; dim<end; ++dim)
+            {
+              for (unsigned int i=0; i<=dim+1; ++i)
+                h(i) = H(i,dim);
+              internal::SolverGMRES::givens_rotation(h, gamma, ci, si, dim);
+              for (unsigned int i=0; i<=dim; ++i)
+                H_rotated(i,dim) = h(i);
+
+              res = std::fabs(gamma(dim+1));
+              iteration_state = this->iteration_status(++accumulated_iterations,
+                                                       res, x);
+              if (iteration_state != SolverControl::iterate)
+                {
+                  ++dim;
+                  break;
+                }
+            }
+        }
+
+      // solve the least-squares problem and update the solution vector by
+      // the preconditioned linear combination of the basis vectors
+      y.reinit(dim);
+      FullMatrix<double> H1 (dim+1, dim);
+      for (unsigned int i=0; i<dim+1; ++i)
+        for (unsigned int j=0; j<dim; ++j)
+          H1(i,j) = H_rotated(i,j);
+      H1.backward(y, gamma);
+
+      std::vector<const VectorType *> vectors (dim);
+      std::vector<double> factors (dim);
+      for (unsigned int i=0; i<dim; ++i)
+        {
+          vectors[i] = &basis[i];
+          factors[i] = y(i);
+        }
+      *tmp = 0.;
+      internal::SolverGMRES::add_linear_combination(vectors, factors, *tmp);
+      precondition.vmult(*p, *tmp);
+      x.add(1., *p);
+    }
+  while (iteration_state == SolverControl::iterate);
+
+  deallog.pop();
+
+  // in case of failure: throw exception
+  AssertThrow(iteration_state == SolverControl::success,
+              SolverControl::NoConvergence (accumulated_iterations, res));
+}
+
 #endif // DOXYGEN
 
 DEAL_II_NAMESPACE_CLOSE
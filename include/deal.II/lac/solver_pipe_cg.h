@@ -0,0 +1,864 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+#ifndef dealii__solver_pipe_cg_h
+#define dealii__solver_pipe_cg_h
+
+
+#include <deal.II/base/config.h>
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/logstream.h>
+#include <deal.II/base/mpi.h>
+#include <deal.II/lac/solver.h>
+#include <deal.II/lac/solver_control.h>
+#include <deal.II/lac/vector_memory.h>
+#include <deal.II/lac/vector_operations_internal.h>
+#include <cmath>
+#include <limits>
+
+DEAL_II_NAMESPACE_OPEN
+
+// forward declaration
+namespace LinearAlgebra
+{
+  namespace distributed
+  {
+    template <typename Number> class Vector;
+  }
+}
+
+
+/*!@addtogroup Solvers */
+/*@{*/
+
+/**
+ * Preconditioned conjugate gradient method for symmetric positive definite
+ * matrices with a reduced number of global reductions per iteration. The
+ * standard SolverCG needs two inner products per iteration that depend on
+ * the matrix-vector product and on the preconditioner, respectively, which
+ * amounts to two global synchronization points in parallel computations.
+ * On large numbers of processors, the latency of these reductions, rather
+ * than the matrix-vector product, limits the performance. This class
+ * implements two mathematically equivalent reformulations of the method
+ * that need only one reduction per iteration, selected by
+ * AdditionalData::variant:
+ * <ul>
+ * <li> AdditionalData::single_reduction: The variant by Chronopoulos and
+ * Gear, which computes the two inner products $(r,u)$ and $(Au,u)$ of the
+ * preconditioned residual $u$ in a single reduction after the matrix-vector
+ * product. It keeps two additional vectors compared to SolverCG.
+ * <li> AdditionalData::pipelined: The pipelined variant by Ghysels and
+ * Vanroose, which introduces auxiliary vectors for the results of the
+ * preconditioner and the matrix-vector product such that the reduction of
+ * the inner products of one iteration can run while the preconditioner and
+ * the matrix are applied. It keeps six additional vectors compared to
+ * SolverCG and does one more preconditioner application and matrix-vector
+ * product in total, because the convergence check for the residual of an
+ * iteration completes only after the next product.
+ * </ul>
+ * In both variants, the norm of the unpreconditioned residual used for the
+ * convergence check is computed within the same reduction. Since the
+ * residual is updated by recurrences that are different from the ones of
+ * SolverCG, the iterates differ by roundoff. Especially for the pipelined
+ * variant, the residual computed by the recurrence can deviate from the
+ * true residual $b-Ax$ for very small tolerances.
+ *
+ * For a general vector type, the inner products are computed with the
+ * functions of the vector class, and the reduction in the pipelined variant
+ * does not overlap with other work. For LinearAlgebra::distributed::Vector,
+ * the vector updates of one iteration and the local parts of the inner
+ * products are merged into a single loop over the locally owned entries,
+ * and the global sum of the three inner products is done by one call to
+ * <code>MPI_Iallreduce</code>, which is completed only after the
+ * preconditioner and the matrix-vector product of the pipelined variant.
+ * This requires an MPI library supporting the MPI 3.0 standard; otherwise, a
+ * blocking reduction is used.
+ *
+ * The interface is the same as the one of SolverCG, i.e., the solver works
+ * with the same SolverControl and preconditioner objects:
+ * @code
+ * SolverControl control (1000, 1e-12 * system_rhs.l2_norm());
+ * SolverPipeCG<LinearAlgebra::distributed::Vector<double> > solver (control);
+ * solver.solve (system_matrix, solution, system_rhs, preconditioner);
+ * @endcode
+ * Like for SolverCG, the preconditioner must be symmetric.
+ *
+ * @see P. Ghysels, W. Vanroose: "Hiding global synchronization latency in
+ * the preconditioned Conjugate Gradient algorithm", Parallel Computing 40,
+ * 2014, and A.T. Chronopoulos, C.W. Gear: "s-step iterative methods for
+ * symmetric linear systems", J. Comput. Appl. Math. 25, 1989.
+ */
+template <typename VectorType = Vector<double> >
+class SolverPipeCG : public Solver<VectorType>
+{
+public:
+  /**
+   * Declare type for container size.
+   */
+  typedef types::global_dof_index size_type;
+
+  /**
+   * Standardized data struct to pipe additional data to the solver.
+   */
+  struct AdditionalData
+  {
+    /**
+     * The reformulations of the conjugate gradient method, see the class
+     * documentation.
+     */
+    enum Variant
+    {
+      /**
+       * The pipelined method by Ghysels and Vanroose.
+       */
+      pipelined,
+      /**
+       * The method by Chronopoulos and Gear with a single blocking reduction
+       * per iteration.
+       */
+      single_reduction
+    };
+
+    /**
+     * Constructor. By default, use the pipelined method.
+     */
+    AdditionalData (const Variant variant = pipelined);
+
+    /**
+     * The variant of the method to use.
+     */
+    Variant variant;
+  };
+
+  /**
+   * Constructor.
+   */
+  SolverPipeCG (SolverControl            &cn,
+                VectorMemory<VectorType> &mem,
+                const AdditionalData     &data = AdditionalData());
+
+  /**
+   * Constructor. Use an object of type GrowingVectorMemory as a default to
+   * allocate memory.
+   */
+  SolverPipeCG (SolverControl        &cn,
+                const AdditionalData &data = AdditionalData());
+
+  /**
+   * Solve the linear system $Ax=b$ for x.
+   */
+  template <typename MatrixType, typename PreconditionerType>
+  void
+  solve (const MatrixType         &A,
+         VectorType               &x,
+         const VectorType         &b,
+         const PreconditionerType &precondition);
+
+protected:
+  /**
+   * The iteration of the pipelined variant, starting from the residual @p
+   * r of the initial guess. Return the state of the last iteration and set
+   * @p step and @p res to the number of the last step and its residual
+   * norm.
+   */
+  template <typename MatrixType, typename PreconditionerType>
+  SolverControl::State
+  iterate_pipelined (const MatrixType         &A,
+                     VectorType               &x,
+                     VectorType               &r,
+                     const PreconditionerType &precondition,
+                     unsigned int             &step,
+                     double                   &res);
+
+  /**
+   * The iteration of the single-reduction variant, with the same arguments
+   * as iterate_pipelined().
+   */
+  template <typename MatrixType, typename PreconditionerType>
+  SolverControl::State
+  iterate_single_reduction (const MatrixType         &A,
+                            VectorType               &x,
+                            VectorType               &r,
+                            const PreconditionerType &precondition,
+                            unsigned int             &step,
+                            double                   &res);
+
+  /**
+   * Additional parameters.
+   */
+  AdditionalData additional_data;
+};
+
+/*@}*/
+
+/*------------------------- Implementation ----------------------------*/
+
+#ifndef DOXYGEN
+
+namespace internal
+{
+  namespace SolverPipeCG
+  {
+    /**
+     * The global sum of three numbers over the processors of an MPI
+     * communicator, started by start() and completed by finish(). With an
+     * MPI library supporting MPI 3.0, the sum is computed by a non-blocking
+     * <code>MPI_Iallreduce</code> such that the work done between the two
+     * calls overlaps with the communication. Otherwise, start() does a
+     * blocking reduction.
+     */
+    class NonBlockingSum
+    {
+    public:
+      NonBlockingSum ()
+#ifdef DEAL_II_WITH_MPI
+        :
+        request (MPI_REQUEST_NULL)
+#endif
+      {
+        for (unsigned int k=0; k<3; ++k)
+          local_values[k] = global_values[k] = 0.;
+      }
+
+      ~NonBlockingSum ()
+      {
+        // an exception may leave the reduction unfinished, so wait for it
+        // before the buffers go away
+        double dummy[3];
+        finish (dummy);
+      }
+
+      void start (const double (&values)[3],
+                  const MPI_Comm &mpi_communicator)
+      {
+        for (unsigned int k=0; k<3; ++k)
+          local_values[k] = values[k];
+#if defined(DEAL_II_WITH_MPI) && MPI_VERSION >= 3
+        if (Utilities::MPI::job_supports_mpi())
+          {
+            const int ierr = MPI_Iallreduce (local_values, global_values, 3,
+                                             MPI_DOUBLE, MPI_SUM,
+                                             mpi_communicator, &request);
+            AssertThrowMPI(ierr);
+            return;
+          }
+#endif
+        Utilities::MPI::sum (local_values, mpi_communicator, global_values);
+      }
+
+      void finish (double (&values)[3])
+      {
+#ifdef DEAL_II_WITH_MPI
+        if (request != MPI_REQUEST_NULL)
+          {
+            const int ierr = MPI_Wait (&request, MPI_STATUS_IGNORE);
+            AssertThrowMPI(ierr);
+          }
+#endif
+        for (unsigned int k=0; k<3; ++k)
+          values[k] = global_values[k];
+      }
+
+    private:
+      double local_values[3];
+      double global_values[3];
+#ifdef DEAL_II_WITH_MPI
+      MPI_Request request;
+#endif
+    };
+
+
+
+    /**
+     * The vector operations of the two variants of the solver, together with
+     * the three inner products $\gamma=(r,u)$, $\delta=(w,u)$ and $(r,r)$
+     * needed per iteration, where $u$ is the preconditioned residual and $w
+     * = Au$. This general implementation uses the plain vector interface
+     * and computes the inner products with blocking reductions.
+     */
+    template <typename VectorType>
+    struct Operations
+    {
+      Operations ()
+        :
+        gamma (0.),
+        delta (0.),
+        residual_norm_sqr (0.)
+      {}
+
+      void start_inner_products (const VectorType &r,
+                                 const VectorType &u,
+                                 const VectorType &w)
+      {
+        gamma = r*u;
+        delta = w*u;
+        residual_norm_sqr = r*r;
+      }
+
+      void finish_inner_products ()
+      {}
+
+      /**
+       * Update all vectors of the pipelined variant by one iteration and
+       * start the inner products for the next one.
+       */
+      void update_pipelined (const double alpha,
+                             const double beta,
+                             VectorType &x,
+                             VectorType &r,
+                             VectorType &u,
+                             VectorType &w,
+                             const VectorType &m,
+                             const VectorType &n,
+                             VectorType &z,
+                             VectorType &q,
+                             VectorType &s,
+                             VectorType &p)
+      {
+        z.sadd (beta, 1., n);
+        q.sadd (beta, 1., m);
+        s.sadd (beta, 1., w);
+        p.sadd (beta, 1., u);
+        x.add (alpha, p);
+        u.add (-alpha, q);
+        gamma = r.add_and_dot (-alpha, s, u);
+        delta = w.add_and_dot (-alpha, z, u);
+        residual_norm_sqr = r*r;
+      }
+
+      /**
+       * Update the search directions, the solution and the residual of the
+       * single-reduction variant.
+       */
+      void update_single_reduction (const double alpha,
+                                    const double beta,
+                                    VectorType &x,
+                                    VectorType &r,
+                                    const VectorType &u,
+                                    const VectorType &w,
+                                    VectorType &s,
+                                    VectorType &p)
+      {
+        p.sadd (beta, 1., u);
+        s.sadd (beta, 1., w);
+        x.add (alpha, p);
+        r.add (-alpha, s);
+      }
+
+      double gamma;
+      double delta;
+      double residual_norm_sqr;
+    };
+
+
+
+    /**
+     * The update of all vectors of the pipelined variant by one iteration
+     * together with the local parts of the three inner products (r,u),
+     * (w,u) and (r,r) of the new vectors, to be used with
+     * internal::VectorOperations::parallel_multi_reduce(). The second
+     * constructor sets up an object that only computes the inner products
+     * of the given vectors. The
+     * range is split in the same way as in
+     * internal::VectorOperations::accumulate_recursive() until the pieces fit
+     * into the cache, and the vectors are updated and then summed up piece by
+     * piece, such that the vector entries are loaded from main memory only
+     * once.
+     */
+    template <typename Number>
+    struct PipelinedUpdate
+    {
+      typedef types::global_dof_index size_type;
+
+      PipelinedUpdate (const Number  alpha,
+                       const Number  beta,
+                       Number       *x,
+                       Number       *r,
+                       Number       *u,
+                       Number       *w,
+                       const Number *m,
+                       const Number *n,
+                       Number       *z,
+                       Number       *q,
+                       Number       *s,
+                       Number       *p)
+        :
+        alpha (alpha),
+        beta (beta),
+        x (x), r (r), u (u), w (w), m (m), n (n), z (z), q (q), s (s), p (p),
+        r_in (r), u_in (u), w_in (w),
+        update_vectors (true)
+      {}
+
+      PipelinedUpdate (const Number *r,
+                       const Number *u,
+                       const Number *w)
+        :
+        alpha (Number()),
+        beta (Number()),
+        x (0), r (0), u (0), w (0), m (0), n (0), z (0), q (0), s (0), p (0),
+        r_in (r), u_in (u), w_in (w),
+        update_vectors (false)
+      {}
+
+      void operator() (const size_type first,
+                       const size_type last,
+                       Number         *results) const
+      {
+        const size_type vec_size = last - first;
+        if (vec_size <= VectorOperations::vector_accumulation_recursion_threshold * 32)
+          {
+            if (update_vectors)
+              {
+                DEAL_II_OPENMP_SIMD_PRAGMA
+                for (size_type i=first; i<last; ++i)
+                  {
+                    z[i] = n[i] + beta * z[i];
+                    q[i] = m[i] + beta * q[i];
+                    s[i] = w[i] + beta * s[i];
+                    p[i] = u[i] + beta * p[i];
+                    x[i] += alpha * p[i];
+                    r[i] -= alpha * s[i];
+                    u[i] -= alpha * q[i];
+                    w[i] -= alpha * z[i];
+                  }
+              }
+            VectorOperations::accumulate_recursive
+            (VectorOperations::Dot<Number,Number>(r_in, u_in), first, last, results[0]);
+            VectorOperations::accumulate_recursive
+            (VectorOperations::Dot<Number,Number>(w_in, u_in), first, last, results[1]);
+            VectorOperations::accumulate_recursive
+            (VectorOperations::Norm2<Number,Number>(r_in), first, last, results[2]);
+          }
+        else
+          {
+            const size_type new_size =
+              (vec_size / (VectorOperations::vector_accumulation_recursion_threshold * 32)) *
+              VectorOperations::vector_accumulation_recursion_threshold * 8;
+            Assert (first+3*new_size < last,
+                    ExcInternalError());
+            Number res[9];
+            (*this)(first, first+new_size, results);
+            (*this)(first+new_size, first+2*new_size, res);
+            (*this)(first+2*new_size, first+3*new_size, res+3);
+            (*this)(first+3*new_size, last, res+6);
+            for (unsigned int i=0; i<3; ++i)
+              {
+                results[i] += res[i];
+                res[3+i] += res[6+i];
+                results[i] = results[i] + res[3+i];
+              }
+          }
+      }
+
+      const Number  alpha;
+      const Number  beta;
+      Number       *x;
+      Number       *r;
+      Number       *u;
+      Number       *w;
+      const Number *m;
+      const Number *n;
+      Number       *z;
+      Number       *q;
+      Number       *s;
+      Number       *p;
+      const Number *r_in;
+      const Number *u_in;
+      const Number *w_in;
+      const bool    update_vectors;
+    };
+
+
+
+    /**
+     * The update of the search directions, the solution and the residual of
+     * the single-reduction variant, to be used with
+     * internal::VectorOperations::parallel_for().
+     */
+    template <typename Number>
+    struct SingleReductionUpdate
+    {
+      typedef types::global_dof_index size_type;
+
+      SingleReductionUpdate (const Number  alpha,
+                             const Number  beta,
+                             Number       *x,
+                             Number       *r,
+                             const Number *u,
+                             const Number *w,
+                             Number       *s,
+                             Number       *p)
+        :
+        alpha (alpha),
+        beta (beta),
+        x (x), r (r), u (u), w (w), s (s), p (p)
+      {}
+
+      void operator() (const size_type begin, const size_type end) const
+      {
+        DEAL_II_OPENMP_SIMD_PRAGMA
+        for (size_type i=begin; i<end; ++i)
+          {
+            p[i] = u[i] + beta * p[i];
+            s[i] = w[i] + beta * s[i];
+            x[i] += alpha * p[i];
+            r[i] -= alpha * s[i];
+          }
+      }
+
+      const Number  alpha;
+      const Number  beta;
+      Number       *x;
+      Number       *r;
+      const Number *u;
+      const Number *w;
+      Number       *s;
+      Number       *p;
+    };
+
+
+
+    /**
+     * The vector operations for LinearAlgebra::distributed::Vector, where
+     * all vector updates of one iteration and the local parts of the inner
+     * products are merged into one sweep over the locally owned entries, and
+     * the global sum is done with a non-blocking reduction. The sweeps are
+     * run through internal::VectorOperations::parallel_for() and
+     * internal::VectorOperations::parallel_multi_reduce(), i.e., they are
+     * parallelized with threads and vectorized in the same way as the vector
+     * operations they replace.
+     */
+    template <typename Number>
+    struct Operations<LinearAlgebra::distributed::Vector<Number> >
+    {
+      typedef LinearAlgebra::distributed::Vector<Number> VectorType;
+
+      Operations ()
+        :
+        gamma (0.),
+        delta (0.),
+        residual_norm_sqr (0.),
+        thread_loop_partitioner (new parallel::internal::TBBPartitioner())
+      {}
+
+      void start_inner_products (const VectorType &r,
+                                 const VectorType &u,
+                                 const VectorType &w)
+      {
+        start_sum (PipelinedUpdate<Number>(r.begin(), u.begin(), w.begin()), r);
+      }
+
+      void finish_inner_products ()
+      {
+        double global_sums[3];
+        sum.finish (global_sums);
+        gamma = global_sums[0];
+        delta = global_sums[1];
+        residual_norm_sqr = global_sums[2];
+      }
+
+      void update_pipelined (const double alpha,
+                             const double beta,
+                             VectorType &x,
+                             VectorType &r,
+                             VectorType &u,
+                             VectorType &w,
+                             const VectorType &m,
+                             const VectorType &n,
+                             VectorType &z,
+                             VectorType &q,
+                             VectorType &s,
+                             VectorType &p)
+      {
+        PipelinedUpdate<Number>
+        update (alpha, beta, x.begin(), r.begin(), u.begin(), w.begin(),
+                m.begin(), n.begin(), z.begin(), q.begin(), s.begin(),
+                p.begin());
+        start_sum (update, r);
+      }
+
+      void update_single_reduction (const double alpha,
+                                    const double beta,
+                                    VectorType &x,
+                                    VectorType &r,
+                                    const VectorType &u,
+                                    const VectorType &w,
+                                    VectorType &s,
+                                    VectorType &p)
+      {
+        SingleReductionUpdate<Number>
+        update (alpha, beta, x.begin(), r.begin(), u.begin(), w.begin(),
+                s.begin(), p.begin());
+        VectorOperations::parallel_for (update, r.local_size(),
+                                        thread_loop_partitioner);
+      }
+
+      double gamma;
+      double delta;
+      double residual_norm_sqr;
+
+    private:
+      /**
+       * Run the given update with the local inner products and start the
+       * global sum.
+       */
+      void start_sum (const PipelinedUpdate<Number> &update,
+                      const VectorType              &r)
+      {
+        Number local_sums[3] = {Number(), Number(), Number()};
+        VectorOperations::parallel_multi_reduce (update, r.local_size(), 3,
+                                                 local_sums,
+                                                 thread_loop_partitioner);
+        const double sums[3] = {local_sums[0], local_sums[1], local_sums[2]};
+        sum.start (sums, r.get_mpi_communicator());
+      }
+
+      NonBlockingSum sum;
+      std_cxx11::shared_ptr<parallel::internal::TBBPartitioner> thread_loop_partitioner;
+    };
+  }
+}
+
+
+
+template <typename VectorType>
+inline
+SolverPipeCG<VectorType>::AdditionalData::
+AdditionalData (const Variant variant)
+  :
+  variant (variant)
+{}
+
+
+
+template <typename VectorType>
+SolverPipeCG<VectorType>::SolverPipeCG (SolverControl            &cn,
+                                        VectorMemory<VectorType> &mem,
+                                        const AdditionalData     &data)
+  :
+  Solver<VectorType>(cn,mem),
+  additional_data(data)
+{}
+
+
+
+template <typename VectorType>
+SolverPipeCG<VectorType>::SolverPipeCG (SolverControl        &cn,
+                                        const AdditionalData &data)
+  :
+  Solver<VectorType>(cn),
+  additional_data(data)
+{}
+
+
+
+template <typename VectorType>
+template <typename MatrixType, typename PreconditionerType>
+SolverControl::State
+SolverPipeCG<VectorType>::iterate_pipelined (const MatrixType         &A,
+                                             VectorType               &x,
+                                             VectorType               &r,
+                                             const PreconditionerType &precondition,
+                                             unsigned int             &step,
+                                             double                   &res)
+{
+  typename VectorMemory<VectorType>::Pointer Vu(this->memory), Vw(this->memory),
+           Vm(this->memory), Vn(this->memory), Vz(this->memory), Vq(this->memory),
+           Vs(this->memory), Vp(this->memory);
+  VectorType &u = *Vu;
+  VectorType &w = *Vw;
+  VectorType &m = *Vm;
+  VectorType &n = *Vn;
+  VectorType &z = *Vz;
+  VectorType &q = *Vq;
+  VectorType &s = *Vs;
+  VectorType &p = *Vp;
+  u.reinit (x, true);
+  w.reinit (x, true);
+  m.reinit (x, true);
+  n.reinit (x, true);
+  // the recurrences of the search directions start from zero vectors
+  z.reinit (x);
+  q.reinit (x);
+  s.reinit (x);
+  p.reinit (x);
+
+  internal::SolverPipeCG::Operations<VectorType> operations;
+
+  precondition.vmult (u, r);
+  A.vmult (w, u);
+  operations.start_inner_products (r, u, w);
+
+  SolverControl::State conv = SolverControl::iterate;
+  double alpha = 0., gamma_old = 0.;
+  step = 0;
+  while (true)
+    {
+      // apply the preconditioner and the matrix while the inner products
+      // of this iteration are being reduced
+      precondition.vmult (m, w);
+      A.vmult (n, m);
+      operations.finish_inner_products ();
+
+      if (step > 0)
+        {
+          res = std::sqrt (operations.residual_norm_sqr);
+          conv = this->iteration_status (step, res, x);
+          if (conv != SolverControl::iterate)
+            break;
+        }
+
+      const double gamma = operations.gamma;
+      double beta = 0., denominator = operations.delta;
+      if (step > 0)
+        {
+          Assert (gamma_old != 0., ExcDivideByZero());
+          beta = gamma / gamma_old;
+          denominator -= beta * gamma / alpha;
+        }
+      Assert (denominator != 0., ExcDivideByZero());
+      alpha = gamma / denominator;
+      gamma_old = gamma;
+
+      operations.update_pipelined (alpha, beta, x, r, u, w, m, n, z, q, s, p);
+      ++step;
+    }
+  return conv;
+}
+
+
+
+template <typename VectorType>
+template <typename MatrixType, typename PreconditionerType>
+SolverControl::State
+SolverPipeCG<VectorType>::iterate_single_reduction (const MatrixType         &A,
+                                                    VectorType               &x,
+                                                    VectorType               &r,
+                                                    const PreconditionerType &precondition,
+                                                    unsigned int             &step,
+                                                    double                   &res)
+{
+  typename VectorMemory<VectorType>::Pointer Vu(this->memory), Vw(this->memory),
+           Vs(this->memory), Vp(this->memory);
+  VectorType &u = *Vu;
+  VectorType &w = *Vw;
+  VectorType &s = *Vs;
+  VectorType &p = *Vp;
+  u.reinit (x, true);
+  w.reinit (x, true);
+  // the recurrences of the search directions start from zero vectors
+  s.reinit (x);
+  p.reinit (x);
+
+  internal::SolverPipeCG::Operations<VectorType> operations;
+
+  SolverControl::State conv = SolverControl::iterate;
+  double alpha = 0., gamma_old = 0.;
+  step = 0;
+  while (true)
+    {
+      precondition.vmult (u, r);
+      A.vmult (w, u);
+      operations.start_inner_products (r, u, w);
+      operations.finish_inner_products ();
+
+      if (step > 0)
+        {
+          res = std::sqrt (operations.residual_norm_sqr);
+          conv = this->iteration_status (step, res, x);
+          if (conv != SolverControl::iterate)
+            break;
+        }
+
+      const double gamma = operations.gamma;
+      double beta = 0., denominator = operations.delta;
+      if (step > 0)
+        {
+          Assert (gamma_old != 0., ExcDivideByZero());
+          beta = gamma / gamma_old;
+          denominator -= beta * gamma / alpha;
+        }
+      Assert (denominator != 0., ExcDivideByZero());
+      alpha = gamma / denominator;
+      gamma_old = gamma;
+
+      operations.update_single_reduction (alpha, beta, x, r, u, w, s, p);
+      ++step;
+    }
+  return conv;
+}
+
+
+
+template <typename VectorType>
+template <typename MatrixType, typename PreconditionerType>
+void
+SolverPipeCG<VectorType>::solve (const MatrixType         &A,
+                                 VectorType               &x,
+                                 const VectorType         &b,
+                                 const PreconditionerType &precondition)
+{
+  deallog.push("pipe_cg");
+
+  SolverControl::State conv = SolverControl::iterate;
+  unsigned int step = 0;
+  double res = -std::numeric_limits<double>::max();
+
+  try
+    {
+      typename VectorMemory<VectorType>::Pointer Vr(this->memory);
+      VectorType &r = *Vr;
+      r.reinit (x, true);
+
+      // compute the residual. if the vector is zero, then short-circuit the
+      // full computation
+      if (!x.all_zero())
+        {
+          A.vmult (r, x);
+          r.sadd (-1., 1., b);
+        }
+      else
+        r.equ (1., b);
+      res = r.l2_norm();
+
+      conv = this->iteration_status (0, res, x);
+      if (conv == SolverControl::iterate)
+        {
+          if (additional_data.variant == AdditionalData::pipelined)
+            conv = iterate_pipelined (A, x, r, precondition, step, res);
+          else
+            conv = iterate_single_reduction (A, x, r, precondition, step, res);
+        }
+    }
+  catch (...)
+    {
+      deallog.pop();
+      throw;
+    }
+
+  deallog.pop();
+
+  // in case of failure: throw exception
+  if (conv != SolverControl::success)
+    AssertThrow(false, SolverControl::NoConvergence (step, res));
+  // otherwise exit as normal
+}
+
+#endif // DOXYGEN
+
+DEAL_II_NAMESPACE_CLOSE
+
+#endif
@@ -0,0 +1,360 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+#ifndef dealii__sparse_amg_h
+#define dealii__sparse_amg_h
+
+
+#include <deal.II/base/config.h>
+#include <deal.II/base/subscriptor.h>
+#include <deal.II/base/smartpointer.h>
+#include <deal.II/base/std_cxx11/shared_ptr.h>
+#include <deal.II/lac/exceptions.h>
+#include <deal.II/lac/full_matrix.h>
+#include <deal.II/lac/sparsity_pattern.h>
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/vector.h>
+#include <deal.II/lac/precondition.h>
+
+#include <vector>
+
+DEAL_II_NAMESPACE_OPEN
+
+/*! @addtogroup Preconditioners
+ *@{
+ */
+
+/**
+ * An algebraic multigrid (AMG) preconditioner based on smoothed aggregation
+ * for symmetric positive definite matrices stored as SparseMatrix. Unlike
+ * TrilinosWrappers::PreconditionAMG, this class does not need any external
+ * library and works directly on the SparsityPattern and SparseMatrix classes
+ * of deal.II.
+ *
+ * <h3>Setup of the hierarchy</h3>
+ *
+ * The initialize() function builds a hierarchy of coarser matrices, starting
+ * with the given matrix on level zero, until the matrix on the coarsest
+ * level has at most AdditionalData::max_coarse_size rows or
+ * AdditionalData::max_levels levels have been created. The steps on each
+ * level are the ones of the smoothed aggregation method by Vanek, Mandel and
+ * Brezina:
+ * <ol>
+ * <li> Strength of connection: An off-diagonal entry $a_{ij}$ is a strong
+ * connection if $|a_{ij}| \geq \theta \sqrt{|a_{ii} a_{jj}|}$ with the
+ * threshold $\theta$ given by AdditionalData::aggregation_threshold.
+ * <li> Aggregation: The rows are grouped into disjoint aggregates along the
+ * strong connections. First, each row whose strongly connected neighbors
+ * are all still free forms an aggregate together with these neighbors. Then,
+ * the remaining rows join the aggregate of a strongly connected neighbor
+ * with the strongest connection, and finally the rows left over form new
+ * aggregates with their free strong neighbors. Rows without any strong
+ * connection, like the rows of constrained degrees of freedom that only
+ * contain a diagonal entry, are not aggregated and are handled by the
+ * smoother alone.
+ * <li> Tentative prolongator: The near null space of the operator, given by
+ * AdditionalData::near_null_space or the constant vector by default, is
+ * restricted to the rows of each aggregate and orthonormalized. The
+ * resulting columns form the tentative prolongator $P_0$, and the
+ * coefficients of the orthonormalization form the near null space on the
+ * next coarser level. For elasticity problems, passing the rigid body modes
+ * (three in 2d, six in 3d) as near null space is essential for a good
+ * convergence. Columns that are linearly dependent on the rows of an
+ * aggregate, e.g. for aggregates that are smaller than the number of near
+ * null space vectors, are dropped.
+ * <li> Smoothed prolongator: The prolongator $P = (I - \omega D^{-1} A) P_0$
+ * with $\omega = \frac{4}{3}/\lambda_\text{max}(D^{-1}A)$ by default (see
+ * AdditionalData::prolongator_damping) is computed with
+ * SparseMatrix::mmult().
+ * <li> Galerkin coarse matrix: The matrix on the next coarser level is
+ * $P^T A P$, computed by SparseMatrix::mmult() and SparseMatrix::Tmmult().
+ * </ol>
+ * On each level except the coarsest one, a PreconditionChebyshev smoother
+ * with the inverse diagonal as inner preconditioner is set up. The largest
+ * eigenvalue of $D^{-1}A$ needed for the prolongator smoothing and the
+ * Chebyshev smoother is estimated by a few steps of the Lanczos method in the
+ * setup. On the coarsest level, the matrix is inverted by Gauss-Jordan
+ * elimination if it has at most AdditionalData::max_coarse_size rows,
+ * otherwise the Chebyshev smoother is applied as approximate coarse solver.
+ *
+ * <h3>Application</h3>
+ *
+ * The vmult() function applies one V-cycle with Chebyshev pre- and
+ * post-smoothing, which is a symmetric operator for symmetric matrices such
+ * that the class can be used as preconditioner in SolverCG. The work in the
+ * V-cycle consists of matrix-vector products with SparseMatrix and vector
+ * operations on Vector, which both run in parallel with threads when
+ * deal.II is configured with TBB.
+ *
+ * @code
+ * SparseAMG<double> amg;
+ * SparseAMG<double>::AdditionalData data;
+ * data.near_null_space = rigid_body_modes;
+ * amg.initialize (system_matrix, data);
+ *
+ * solver.solve (system_matrix, solution, system_rhs, amg);
+ * @endcode
+ *
+ * The given matrix is used on the finest level and must therefore live at
+ * least as long as this object is used.
+ *
+ * @note Instantiations for this template are provided for <tt>@<float@> and
+ * @<double@></tt>.
+ */
+template <typename number>
+class SparseAMG : public Subscriptor
+{
+public:
+  /**
+   * Declare type for container size.
+   */
+  typedef types::global_dof_index size_type;
+
+  /**
+   * Parameters for the setup of the multigrid hierarchy.
+   */
+  class AdditionalData
+  {
+  public:
+    /**
+     * Constructor. For the parameters' description, see below.
+     */
+    AdditionalData (const double       aggregation_threshold = 1e-4,
+                    const unsigned int smoother_degree = 2,
+                    const double       smoothing_range = 20.,
+                    const double       prolongator_damping = 4./3.,
+                    const unsigned int max_coarse_size = 500,
+                    const unsigned int max_levels = 20);
+
+    /**
+     * The threshold $\theta$ for the strength of connection between two
+     * rows, see the class documentation. Larger values give smaller
+     * aggregates that follow the strong couplings of anisotropic problems
+     * more closely.
+     */
+    double aggregation_threshold;
+
+    /**
+     * The degree of the Chebyshev polynomial used for the pre- and
+     * post-smoothing on each level, see PreconditionChebyshev.
+     */
+    unsigned int smoother_degree;
+
+    /**
+     * The range of eigenvalues $[\lambda_\text{max}/\text{smoothing\_range},
+     * \lambda_\text{max}]$ targeted by the Chebyshev smoother, see
+     * PreconditionChebyshev::AdditionalData::smoothing_range.
+     */
+    double smoothing_range;
+
+    /**
+     * The damping of the prolongator smoothing relative to the inverse of
+     * the largest eigenvalue of $D^{-1}A$. A value of zero gives the
+     * unsmoothed (plain) aggregation.
+     */
+    double prolongator_damping;
+
+    /**
+     * The maximal size of the matrix on the coarsest level. The coarsening
+     * stops as soon as the matrix has at most this number of rows, and the
+     * coarsest matrix is then inverted as a full matrix.
+     */
+    unsigned int max_coarse_size;
+
+    /**
+     * The maximal number of levels of the hierarchy, including the finest
+     * level.
+     */
+    unsigned int max_levels;
+
+    /**
+     * The vectors spanning the near null space of the matrix, i.e., the
+     * vectors that the smoother can not reduce efficiently, such as the
+     * constant vector for the Laplacian or the rigid body modes for linear
+     * elasticity. Each vector must have as many entries as the matrix has
+     * rows. If empty, the constant vector is used.
+     */
+    std::vector<Vector<number> > near_null_space;
+  };
+
+  /**
+   * Constructor. Call initialize() before using this object.
+   */
+  SparseAMG ();
+
+  /**
+   * Destructor.
+   */
+  ~SparseAMG ();
+
+  /**
+   * Build the multigrid hierarchy for the given matrix. The matrix must be
+   * square and is used as the matrix on the finest level.
+   */
+  void initialize (const SparseMatrix<number> &matrix,
+                   const AdditionalData       &additional_data = AdditionalData());
+
+  /**
+   * Release all memory and return to a state just like after having called
+   * the default constructor.
+   */
+  void clear ();
+
+  /**
+   * Apply one V-cycle to @p src, starting with a zero initial guess.
+   */
+  void vmult (Vector<number>       &dst,
+              const Vector<number> &src) const;
+
+  /**
+   * Apply the transpose of the V-cycle, which is the same as vmult() for
+   * symmetric matrices.
+   */
+  void Tvmult (Vector<number>       &dst,
+               const Vector<number> &src) const;
+
+  /**
+   * Return the dimension of the codomain (or range) space, i.e., the number
+   * of rows of the matrix on the finest level.
+   */
+  size_type m () const;
+
+  /**
+   * Return the dimension of the domain space, i.e., the number of columns of
+   * the matrix on the finest level.
+   */
+  size_type n () const;
+
+  /**
+   * Return the number of levels of the hierarchy, including the finest
+   * level.
+   */
+  unsigned int n_levels () const;
+
+  /**
+   * Return the matrix on the given level, where level zero is the matrix
+   * passed to initialize().
+   */
+  const SparseMatrix<number> &get_matrix (const unsigned int level) const;
+
+  /**
+   * Return the prolongation matrix from level <tt>level+1</tt> to level
+   * @p level.
+   */
+  const SparseMatrix<number> &get_prolongation (const unsigned int level) const;
+
+  /**
+   * Determine an estimate for the memory consumption (in bytes) of this
+   * object.
+   */
+  std::size_t memory_consumption () const;
+
+private:
+  /**
+   * The data stored for each level of the hierarchy.
+   */
+  struct Level
+  {
+    /**
+     * The sparsity pattern of the matrix on this level, unused on the
+     * finest level.
+     */
+    SparsityPattern sparsity;
+
+    /**
+     * The matrix on this level, unused on the finest level.
+     */
+    SparseMatrix<number> matrix;
+
+    /**
+     * The sparsity pattern of the prolongation matrix.
+     */
+    SparsityPattern prolongation_sparsity;
+
+    /**
+     * The prolongation matrix from the next coarser level to this level.
+     */
+    SparseMatrix<number> prolongation;
+
+    /**
+     * The Chebyshev smoother on this level.
+     */
+    PreconditionChebyshev<SparseMatrix<number>,Vector<number> > smoother;
+
+    /**
+     * Vectors for the right hand side, the solution and the residual of the
+     * V-cycle on this level.
+     */
+    Vector<number> rhs;
+    Vector<number> solution;
+    Vector<number> residual;
+  };
+
+  /**
+   * Apply the V-cycle on the given level and the coarser ones.
+   */
+  void v_cycle (const unsigned int    level,
+                Vector<number>       &dst,
+                const Vector<number> &src) const;
+
+  /**
+   * Compute the aggregates of the given matrix and the tentative
+   * prolongator together with the near null space on the next coarser
+   * level. Return the number of rows on the coarser level. If this number
+   * is zero or not smaller than the number of rows of the given matrix, the
+   * output arguments are left untouched.
+   */
+  size_type
+  build_tentative_prolongator (const SparseMatrix<number>         &matrix,
+                               const std::vector<Vector<number> > &null_space,
+                               SparsityPattern                    &sparsity,
+                               SparseMatrix<number>               &prolongator,
+                               std::vector<Vector<number> >       &coarse_null_space) const;
+
+  /**
+   * Estimate the largest eigenvalue of the matrix preconditioned by its
+   * diagonal by a few steps of the Lanczos method, including a safety factor
+   * and bounded from above by Gershgorin's theorem.
+   */
+  static
+  double estimate_max_eigenvalue (const SparseMatrix<number> &matrix);
+
+  /**
+   * The parameters of the hierarchy.
+   */
+  AdditionalData data;
+
+  /**
+   * Pointer to the matrix on the finest level.
+   */
+  SmartPointer<const SparseMatrix<number>,SparseAMG<number> > fine_matrix;
+
+  /**
+   * The levels of the hierarchy.
+   */
+  std::vector<std_cxx11::shared_ptr<Level> > levels;
+
+  /**
+   * The inverse of the matrix on the coarsest level, empty if the coarsest
+   * matrix is too large and the smoother is used instead.
+   */
+  FullMatrix<number> coarse_inverse;
+};
+
+/*@}*/
+
+DEAL_II_NAMESPACE_CLOSE
+
+#endif
@@ -0,0 +1,860 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+#ifndef dealii__sparse_amg_templates_h
+#define dealii__sparse_amg_templates_h
+
+
+
+#include <deal.II/base/config.h>
+#include <deal.II/base/memory_consumption.h>
+#include <deal.II/base/parallel.h>
+#include <deal.II/base/std_cxx11/bind.h>
+#include <deal.II/lac/sparse_amg.h>
+#include <deal.II/lac/dynamic_sparsity_pattern.h>
+
+#include <algorithm>
+#include <cmath>
+
+
+DEAL_II_NAMESPACE_OPEN
+
+
+namespace internal
+{
+  namespace SparseAMG
+  {
+    /**
+     * Minimum number of aggregates handed to a single task when the
+     * aggregates are processed in parallel. Aggregates consist of a few
+     * rows each, so this corresponds to a few hundred rows.
+     */
+    const unsigned int minimum_parallel_grain_size_aggregates = 64;
+
+    /**
+     * Store the absolute value of the diagonal entries of the rows in the
+     * range [begin,end).
+     */
+    template <typename number>
+    void
+    extract_diagonal_on_subrange (const types::global_dof_index begin,
+                                  const types::global_dof_index end,
+                                  const dealii::SparseMatrix<number> &matrix,
+                                  std::vector<double>           &diagonal)
+    {
+      for (types::global_dof_index row=begin; row<end; ++row)
+        diagonal[row] = std::abs (matrix.diag_element(row));
+    }
+
+
+
+    /**
+     * Return whether the off-diagonal entry of the given absolute value in
+     * the given row and column is a strong connection.
+     */
+    inline
+    bool
+    is_strong_connection (const types::global_dof_index row,
+                          const types::global_dof_index column,
+                          const double                  value,
+                          const double                  threshold,
+                          const std::vector<double>    &diagonal)
+    {
+      return (column != row && value != 0. &&
+              value*value >= threshold * diagonal[row] * diagonal[column]);
+    }
+
+
+
+    /**
+     * Count the strong connections of the rows in the range [begin,end)
+     * and store the number for row @p row in <tt>strong_start[row+1]</tt>.
+     */
+    template <typename number>
+    void
+    count_strong_connections_on_subrange (const types::global_dof_index begin,
+                                          const types::global_dof_index end,
+                                          const dealii::SparseMatrix<number> &matrix,
+                                          const std::vector<double>     &diagonal,
+                                          const double                   threshold,
+                                          std::vector<std::size_t>      &strong_start)
+    {
+      for (types::global_dof_index row=begin; row<end; ++row)
+        {
+          std::size_t n_strong = 0;
+          for (typename dealii::SparseMatrix<number>::const_iterator
+               p=matrix.begin(row); p!=matrix.end(row); ++p)
+            if (is_strong_connection (row, p->column(), std::abs (p->value()),
+                                      threshold, diagonal))
+              ++n_strong;
+          strong_start[row+1] = n_strong;
+        }
+    }
+
+
+
+    /**
+     * Write the columns and absolute values of the strong connections of
+     * the rows in the range [begin,end) to the positions given by
+     * @p strong_start.
+     */
+    template <typename number>
+    void
+    fill_strong_connections_on_subrange (const types::global_dof_index begin,
+                                         const types::global_dof_index end,
+                                         const dealii::SparseMatrix<number> &matrix,
+                                         const std::vector<double>     &diagonal,
+                                         const double                   threshold,
+                                         const std::vector<std::size_t> &strong_start,
+                                         std::vector<types::global_dof_index> &strong_columns,
+                                         std::vector<double>           &strong_values)
+    {
+      for (types::global_dof_index row=begin; row<end; ++row)
+        {
+          std::size_t k = strong_start[row];
+          for (typename dealii::SparseMatrix<number>::const_iterator
+               p=matrix.begin(row); p!=matrix.end(row); ++p)
+            {
+              const double value = std::abs (p->value());
+              if (is_strong_connection (row, p->column(), value,
+                                        threshold, diagonal))
+                {
+                  strong_columns[k] = p->column();
+                  strong_values[k] = value;
+                  ++k;
+                }
+            }
+          Assert (k == strong_start[row+1], ExcInternalError());
+        }
+    }
+
+
+
+    /**
+     * Orthonormalize the near null space restricted to the aggregates in
+     * the range [begin,end) by the modified Gram-Schmidt method, see
+     * dealii::SparseAMG::build_tentative_prolongator(). The number of
+     * columns kept for aggregate @p a is stored in
+     * <tt>n_kept[a+1]</tt>.
+     */
+    template <typename number>
+    void
+    orthonormalize_on_subrange (const unsigned int                    begin,
+                                const unsigned int                    end,
+                                const std::vector<dealii::Vector<number> > &null_space,
+                                const std::vector<std::size_t>       &aggregate_start,
+                                const std::vector<types::global_dof_index> &aggregate_rows,
+                                std::vector<double>                  &q_values,
+                                std::vector<double>                  &r_values,
+                                std::vector<types::global_dof_index> &n_kept)
+    {
+      const unsigned int n_vectors = null_space.size();
+      for (unsigned int a=begin; a<end; ++a)
+        {
+          const std::size_t size = aggregate_start[a+1] - aggregate_start[a];
+          double *q = &q_values[0] + aggregate_start[a]*n_vectors;
+          double *r = &r_values[0] + a*n_vectors*n_vectors;
+          unsigned int kept = 0;
+          for (unsigned int c=0; c<n_vectors; ++c)
+            {
+              double *v = q + kept*size;
+              double initial_norm = 0.;
+              for (std::size_t i=0; i<size; ++i)
+                {
+                  v[i] = null_space[c](aggregate_rows[aggregate_start[a]+i]);
+                  initial_norm += v[i]*v[i];
+                }
+              initial_norm = std::sqrt (initial_norm);
+
+              for (unsigned int d=0; d<kept; ++d)
+                {
+                  const double *w = q + d*size;
+                  double product = 0.;
+                  for (std::size_t i=0; i<size; ++i)
+                    product += w[i]*v[i];
+                  for (std::size_t i=0; i<size; ++i)
+                    v[i] -= product*w[i];
+                  r[d*n_vectors+c] = product;
+                }
+
+              double norm = 0.;
+              for (std::size_t i=0; i<size; ++i)
+                norm += v[i]*v[i];
+              norm = std::sqrt (norm);
+              if (norm > 1e-10*initial_norm && norm > 0.)
+                {
+                  for (std::size_t i=0; i<size; ++i)
+                    v[i] /= norm;
+                  r[kept*n_vectors+c] = norm;
+                  ++kept;
+                }
+            }
+          n_kept[a+1] = kept;
+        }
+    }
+
+
+
+    /**
+     * Write the orthonormal columns of the aggregates in the range
+     * [begin,end) into the tentative prolongator and their coefficients
+     * into the near null space of the coarser level. Each row belongs to
+     * at most one aggregate, so different aggregates write to different
+     * rows of the prolongator.
+     */
+    template <typename number>
+    void
+    fill_prolongator_on_subrange (const unsigned int                    begin,
+                                  const unsigned int                    end,
+                                  const std::vector<std::size_t>       &aggregate_start,
+                                  const std::vector<types::global_dof_index> &aggregate_rows,
+                                  const std::vector<types::global_dof_index> &coarse_start,
+                                  const std::vector<double>            &q_values,
+                                  const std::vector<double>            &r_values,
+                                  dealii::SparseMatrix<number>         &prolongator,
+                                  std::vector<dealii::Vector<number> > &coarse_null_space)
+    {
+      const unsigned int n_vectors = coarse_null_space.size();
+      for (unsigned int a=begin; a<end; ++a)
+        {
+          const std::size_t size = aggregate_start[a+1] - aggregate_start[a];
+          const double *q = &q_values[0] + aggregate_start[a]*n_vectors;
+          const double *r = &r_values[0] + a*n_vectors*n_vectors;
+          for (types::global_dof_index d=0; d<coarse_start[a+1]-coarse_start[a]; ++d)
+            {
+              for (std::size_t i=0; i<size; ++i)
+                prolongator.set (aggregate_rows[aggregate_start[a]+i],
+                                 coarse_start[a]+d, q[d*size+i]);
+              for (unsigned int c=0; c<n_vectors; ++c)
+                coarse_null_space[c](coarse_start[a]+d) = r[d*n_vectors+c];
+            }
+        }
+    }
+
+
+
+    /**
+     * Perform the damped Jacobi step P = P_0 - omega D^{-1} A P_0 on the
+     * rows in the range [begin,end), where @p prolongation holds the
+     * product A P_0 on entry.
+     */
+    template <typename number>
+    void
+    smooth_prolongator_on_subrange (const types::global_dof_index begin,
+                                    const types::global_dof_index end,
+                                    const dealii::SparseMatrix<number> &matrix,
+                                    const dealii::SparseMatrix<number> &tentative,
+                                    const double                   omega,
+                                    dealii::SparseMatrix<number>  &prolongation)
+    {
+      for (types::global_dof_index row=begin; row<end; ++row)
+        {
+          const number factor = -omega / matrix.diag_element(row);
+          for (typename dealii::SparseMatrix<number>::iterator
+               p=prolongation.begin(row); p!=prolongation.end(row); ++p)
+            p->value() *= factor;
+          for (typename dealii::SparseMatrix<number>::const_iterator
+               p=tentative.begin(row); p!=tentative.end(row); ++p)
+            prolongation.add (row, p->column(), p->value());
+        }
+    }
+  }
+}
+
+
+
+
+template <typename number>
+SparseAMG<number>::AdditionalData::
+AdditionalData (const double       aggregation_threshold,
+                const unsigned int smoother_degree,
+                const double       smoothing_range,
+                const double       prolongator_damping,
+                const unsigned int max_coarse_size,
+                const unsigned int max_levels)
+  :
+  aggregation_threshold (aggregation_threshold),
+  smoother_degree (smoother_degree),
+  smoothing_range (smoothing_range),
+  prolongator_damping (prolongator_damping),
+  max_coarse_size (max_coarse_size),
+  max_levels (max_levels)
+{}
+
+
+
+template <typename number>
+SparseAMG<number>::SparseAMG ()
+  :
+  fine_matrix (0, typeid(*this).name())
+{}
+
+
+
+template <typename number>
+SparseAMG<number>::~SparseAMG ()
+{
+  clear ();
+}
+
+
+
+template <typename number>
+void
+SparseAMG<number>::clear ()
+{
+  levels.clear ();
+  coarse_inverse.reinit (0, 0);
+  fine_matrix = 0;
+}
+
+
+
+template <typename number>
+void
+SparseAMG<number>::initialize (const SparseMatrix<number> &matrix,
+                               const AdditionalData       &additional_data)
+{
+  Assert (matrix.m() == matrix.n(), ExcNotQuadratic());
+  Assert (additional_data.max_levels > 0,
+          ExcMessage ("The hierarchy needs at least one level."));
+  for (unsigned int c=0; c<additional_data.near_null_space.size(); ++c)
+    AssertDimension (additional_data.near_null_space[c].size(), matrix.m());
+
+  clear ();
+  data = additional_data;
+  fine_matrix = &matrix;
+
+  // the near null space on the finest level is the given one or the
+  // constant vector. we do not need to keep the user's vectors after the
+  // setup
+  std::vector<Vector<number> > null_space;
+  null_space.swap (data.near_null_space);
+  if (null_space.empty())
+    {
+      null_space.resize (1, Vector<number>(matrix.m()));
+      null_space[0] = 1.;
+    }
+
+  levels.push_back (std_cxx11::shared_ptr<Level>(new Level()));
+  for (unsigned int level=0; ; ++level)
+    {
+      Level &this_level = *levels[level];
+      const SparseMatrix<number> &level_matrix = get_matrix (level);
+      this_level.rhs.reinit (level_matrix.m());
+      this_level.solution.reinit (level_matrix.m());
+      this_level.residual.reinit (level_matrix.m());
+
+      const double max_eigenvalue = estimate_max_eigenvalue (level_matrix);
+
+      bool is_coarsest = (level_matrix.m() <= data.max_coarse_size ||
+                          level+1 >= data.max_levels);
+      if (is_coarsest == false)
+        {
+          // without smoothing, the tentative prolongator is directly the
+          // prolongator of this level
+          const bool smooth_prolongator = data.prolongator_damping > 0.;
+          SparsityPattern tentative_sparsity;
+          SparseMatrix<number> tentative;
+          std::vector<Vector<number> > coarse_null_space;
+          const size_type n_coarse =
+            build_tentative_prolongator (level_matrix, null_space,
+                                         smooth_prolongator ?
+                                         tentative_sparsity :
+                                         this_level.prolongation_sparsity,
+                                         smooth_prolongator ?
+                                         tentative :
+                                         this_level.prolongation,
+                                         coarse_null_space);
+
+          if (n_coarse == 0)
+            is_coarsest = true;
+          else
+            {
+              // smooth the tentative prolongator by one damped Jacobi step,
+              // P = P_0 - omega D^{-1} A P_0. Since the matrix contains the
+              // diagonal, the sparsity pattern of A P_0 contains the one of
+              // P_0
+              if (smooth_prolongator)
+                {
+                  this_level.prolongation.reinit (this_level.prolongation_sparsity);
+                  level_matrix.mmult (this_level.prolongation, tentative);
+
+                  const double omega = data.prolongator_damping / max_eigenvalue;
+                  parallel::apply_to_subranges (0U, level_matrix.m(),
+                                                std_cxx11::bind (&internal::SparseAMG::template
+                                                                 smooth_prolongator_on_subrange<number>,
+                                                                 std_cxx11::_1, std_cxx11::_2,
+                                                                 std_cxx11::cref(level_matrix),
+                                                                 std_cxx11::cref(tentative),
+                                                                 omega,
+                                                                 std_cxx11::ref(this_level.prolongation)),
+                                                internal::SparseMatrix::minimum_parallel_grain_size);
+                }
+
+              // compute the Galerkin product P^T A P on the coarser level
+              std_cxx11::shared_ptr<Level> coarse_level (new Level());
+              {
+                SparsityPattern product_sparsity;
+                SparseMatrix<number> product (product_sparsity);
+                level_matrix.mmult (product, this_level.prolongation);
+
+                coarse_level->matrix.reinit (coarse_level->sparsity);
+                this_level.prolongation.Tmmult (coarse_level->matrix, product);
+              }
+              levels.push_back (coarse_level);
+              null_space.swap (coarse_null_space);
+            }
+        }
+
+      // on the coarsest level, invert the matrix if it is small enough and
+      // otherwise use the smoother as an approximate coarse solver
+      if (is_coarsest && level_matrix.m() <= data.max_coarse_size)
+        {
+          coarse_inverse.copy_from (level_matrix);
+          coarse_inverse.gauss_jordan ();
+        }
+      else
+        {
+          typename PreconditionChebyshev<SparseMatrix<number>,Vector<number> >::AdditionalData
+          smoother_data;
+          smoother_data.degree = data.smoother_degree;
+          smoother_data.smoothing_range = data.smoothing_range;
+          smoother_data.eig_cg_n_iterations = 0;
+          smoother_data.max_eigenvalue = max_eigenvalue;
+          this_level.smoother.initialize (level_matrix, smoother_data);
+        }
+
+      if (is_coarsest)
+        break;
+    }
+}
+
+
+
+template <typename number>
+typename SparseAMG<number>::size_type
+SparseAMG<number>::
+build_tentative_prolongator (const SparseMatrix<number>         &matrix,
+                             const std::vector<Vector<number> > &null_space,
+                             SparsityPattern                    &sparsity,
+                             SparseMatrix<number>               &prolongator,
+                             std::vector<Vector<number> >       &coarse_null_space) const
+{
+  const size_type n = matrix.m();
+  const unsigned int n_vectors = null_space.size();
+
+  // collect the strong connections of each row. the rows are independent,
+  // so count them in parallel first and fill them in parallel once the
+  // offsets are known
+  std::vector<std::size_t> strong_start (n+1, 0);
+  std::vector<size_type> strong_columns;
+  std::vector<double> strong_values;
+  {
+    const unsigned int grain_size = internal::SparseMatrix::minimum_parallel_grain_size;
+    std::vector<double> diagonal (n);
+    parallel::apply_to_subranges (0U, n,
+                                  std_cxx11::bind (&internal::SparseAMG::template
+                                                   extract_diagonal_on_subrange<number>,
+                                                   std_cxx11::_1, std_cxx11::_2,
+                                                   std_cxx11::cref(matrix),
+                                                   std_cxx11::ref(diagonal)),
+                                  grain_size);
+
+    const double threshold = data.aggregation_threshold * data.aggregation_threshold;
+    parallel::apply_to_subranges (0U, n,
+                                  std_cxx11::bind (&internal::SparseAMG::template
+                                                   count_strong_connections_on_subrange<number>,
+                                                   std_cxx11::_1, std_cxx11::_2,
+                                                   std_cxx11::cref(matrix),
+                                                   std_cxx11::cref(diagonal),
+                                                   threshold,
+                                                   std_cxx11::ref(strong_start)),
+                                  grain_size);
+    for (size_type row=0; row<n; ++row)
+      strong_start[row+1] += strong_start[row];
+
+    strong_columns.resize (strong_start[n]);
+    strong_values.resize (strong_start[n]);
+    parallel::apply_to_subranges (0U, n,
+                                  std_cxx11::bind (&internal::SparseAMG::template
+                                                   fill_strong_connections_on_subrange<number>,
+                                                   std_cxx11::_1, std_cxx11::_2,
+                                                   std_cxx11::cref(matrix),
+                                                   std_cxx11::cref(diagonal),
+                                                   threshold,
+                                                   std_cxx11::cref(strong_start),
+                                                   std_cxx11::ref(strong_columns),
+                                                   std_cxx11::ref(strong_values)),
+                                  grain_size);
+  }
+
+  // build the aggregates in three phases. rows without strong connections
+  // remain unaggregated
+  std::vector<unsigned int> aggregate (n, numbers::invalid_unsigned_int);
+  unsigned int n_aggregates = 0;
+
+  // phase 1: rows whose strong neighbors are all free form a new aggregate
+  // together with these neighbors
+  for (size_type row=0; row<n; ++row)
+    if (aggregate[row] == numbers::invalid_unsigned_int &&
+        strong_start[row+1] > strong_start[row])
+      {
+        bool all_free = true;
+        for (std::size_t k=strong_start[row]; k<strong_start[row+1]; ++k)
+          if (aggregate[strong_columns[k]] != numbers::invalid_unsigned_int)
+            {
+              all_free = false;
+              break;
+            }
+        if (all_free)
+          {
+            aggregate[row] = n_aggregates;
+            for (std::size_t k=strong_start[row]; k<strong_start[row+1]; ++k)
+              aggregate[strong_columns[k]] = n_aggregates;
+            ++n_aggregates;
+          }
+      }
+
+  // phase 2: the remaining rows join the aggregate of the phase-1 neighbor
+  // with the strongest connection
+  {
+    const std::vector<unsigned int> phase_1_aggregate (aggregate);
+    for (size_type row=0; row<n; ++row)
+      if (aggregate[row] == numbers::invalid_unsigned_int)
+        {
+          double strongest = 0.;
+          for (std::size_t k=strong_start[row]; k<strong_start[row+1]; ++k)
+            if (phase_1_aggregate[strong_columns[k]] != numbers::invalid_unsigned_int &&
+                strong_values[k] > strongest)
+              {
+                strongest = strong_values[k];
+                aggregate[row] = phase_1_aggregate[strong_columns[k]];
+              }
+        }
+  }
+
+  // phase 3: the rows that are still left form new aggregates with their
+  // free strong neighbors
+  for (size_type row=0; row<n; ++row)
+    if (aggregate[row] == numbers::invalid_unsigned_int &&
+        strong_start[row+1] > strong_start[row])
+      {
+        aggregate[row] = n_aggregates;
+        for (std::size_t k=strong_start[row]; k<strong_start[row+1]; ++k)
+          if (aggregate[strong_columns[k]] == numbers::invalid_unsigned_int)
+            aggregate[strong_columns[k]] = n_aggregates;
+        ++n_aggregates;
+      }
+
+  // sort the rows by aggregates
+  std::vector<std::size_t> aggregate_start (n_aggregates+1, 0);
+  for (size_type row=0; row<n; ++row)
+    if (aggregate[row] != numbers::invalid_unsigned_int)
+      ++aggregate_start[aggregate[row]+1];
+  for (unsigned int a=0; a<n_aggregates; ++a)
+    aggregate_start[a+1] += aggregate_start[a];
+  std::vector<size_type> aggregate_rows (aggregate_start[n_aggregates]);
+  {
+    std::vector<std::size_t> position (aggregate_start.begin(),
+                                       aggregate_start.end()-1);
+    for (size_type row=0; row<n; ++row)
+      if (aggregate[row] != numbers::invalid_unsigned_int)
+        aggregate_rows[position[aggregate[row]]++] = row;
+  }
+
+  // orthonormalize the near null space restricted to each aggregate by the
+  // modified Gram-Schmidt method. the orthonormal columns Q are the entries
+  // of the tentative prolongator, stored column by column for each
+  // aggregate, and the coefficients R make up the near null space on the
+  // coarser level. columns that are numerically dependent on the previous
+  // ones are dropped. the aggregates are independent, so this is done in
+  // parallel, storing the number of kept columns of each aggregate first
+  std::vector<double> q_values (aggregate_rows.size()*n_vectors);
+  std::vector<double> r_values (n_aggregates*n_vectors*n_vectors, 0.);
+  std::vector<size_type> coarse_start (n_aggregates+1, 0);
+  parallel::apply_to_subranges (0U, n_aggregates,
+                                std_cxx11::bind (&internal::SparseAMG::template
+                                                 orthonormalize_on_subrange<number>,
+                                                 std_cxx11::_1, std_cxx11::_2,
+                                                 std_cxx11::cref(null_space),
+                                                 std_cxx11::cref(aggregate_start),
+                                                 std_cxx11::cref(aggregate_rows),
+                                                 std_cxx11::ref(q_values),
+                                                 std_cxx11::ref(r_values),
+                                                 std_cxx11::ref(coarse_start)),
+                                internal::SparseAMG::minimum_parallel_grain_size_aggregates);
+  for (unsigned int a=0; a<n_aggregates; ++a)
+    coarse_start[a+1] += coarse_start[a];
+
+  const size_type n_coarse = coarse_start[n_aggregates];
+  if (n_coarse == 0 || n_coarse >= n)
+    return 0;
+
+  DynamicSparsityPattern dsp (n, n_coarse);
+  for (unsigned int a=0; a<n_aggregates; ++a)
+    for (std::size_t i=aggregate_start[a]; i<aggregate_start[a+1]; ++i)
+      for (size_type col=coarse_start[a]; col<coarse_start[a+1]; ++col)
+        dsp.add (aggregate_rows[i], col);
+  sparsity.copy_from (dsp);
+  prolongator.reinit (sparsity);
+
+  coarse_null_space.resize (n_vectors);
+  for (unsigned int c=0; c<n_vectors; ++c)
+    coarse_null_space[c].reinit (n_coarse);
+
+  parallel::apply_to_subranges (0U, n_aggregates,
+                                std_cxx11::bind (&internal::SparseAMG::template
+                                                 fill_prolongator_on_subrange<number>,
+                                                 std_cxx11::_1, std_cxx11::_2,
+                                                 std_cxx11::cref(aggregate_start),
+                                                 std_cxx11::cref(aggregate_rows),
+                                                 std_cxx11::cref(coarse_start),
+                                                 std_cxx11::cref(q_values),
+                                                 std_cxx11::cref(r_values),
+                                                 std_cxx11::ref(prolongator),
+                                                 std_cxx11::ref(coarse_null_space)),
+                                internal::SparseAMG::minimum_parallel_grain_size_aggregates);
+
+  return n_coarse;
+}
+
+
+
+template <typename number>
+double
+SparseAMG<number>::estimate_max_eigenvalue (const SparseMatrix<number> &matrix)
+{
+  const size_type n = matrix.m();
+  if (n == 0)
+    return 1.;
+
+  // bound from Gershgorin's theorem applied to D^{-1} A
+  Vector<number> diagonal (n), diagonal_inverse (n);
+  double gershgorin_bound = 0.;
+  for (size_type row=0; row<n; ++row)
+    {
+      diagonal(row) = matrix.diag_element(row);
+      Assert (diagonal(row) > number(),
+              ExcMessage ("The diagonal entries of the matrix must be positive."));
+      diagonal_inverse(row) = 1./diagonal(row);
+      double row_sum = 0.;
+      for (typename SparseMatrix<number>::const_iterator
+           p=matrix.begin(row); p!=matrix.end(row); ++p)
+        row_sum += std::abs (p->value());
+      gershgorin_bound = std::max (gershgorin_bound,
+                                   row_sum / diagonal(row));
+    }
+
+  // Lanczos iteration on D^{-1} A, which is self-adjoint in the inner
+  // product weighted by D, starting from a vector with all frequencies
+  // present
+  Vector<number> v (n), v_old (n), w (n);
+  for (size_type i=0; i<n; ++i)
+    v(i) = 1. + 0.5*std::sin (1.+i);
+  {
+    double norm = 0.;
+    for (size_type i=0; i<n; ++i)
+      norm += diagonal(i) * v(i) * v(i);
+    v /= std::sqrt (norm);
+  }
+  std::vector<double> alpha, beta (1, 0.);
+  for (unsigned int it=0; it<std::min<size_type>(n, 15); ++it)
+    {
+      matrix.vmult (w, v);
+      alpha.push_back (v * w);
+      w.scale (diagonal_inverse);
+      w.add (-alpha.back(), v, -beta.back(), v_old);
+      double norm = 0.;
+      for (size_type i=0; i<n; ++i)
+        norm += diagonal(i) * w(i) * w(i);
+      norm = std::sqrt (norm);
+      if (norm <= 1e-12 * std::abs(alpha.back()))
+        break;
+      beta.push_back (norm);
+      v_old.swap (v);
+      v.equ (1./norm, w);
+    }
+
+  // the largest eigenvalue of the Lanczos tridiagonal matrix by bisection
+  // on the Sturm sequence, which counts the eigenvalues below a given value
+  const unsigned int n_steps = alpha.size();
+  double lower = alpha[0], upper = alpha[0];
+  for (unsigned int i=0; i<n_steps; ++i)
+    {
+      const double radius = beta[i] + (i+1<n_steps ? beta[i+1] : 0.);
+      lower = std::min (lower, alpha[i] - radius);
+      upper = std::max (upper, alpha[i] + radius);
+    }
+  for (unsigned int it=0; it<60; ++it)
+    {
+      const double x = 0.5 * (lower + upper);
+      unsigned int n_below = 0;
+      double q = 1.;
+      for (unsigned int i=0; i<n_steps; ++i)
+        {
+          q = alpha[i] - x - (i>0 ? beta[i]*beta[i]/q : 0.);
+          if (q == 0.)
+            q = 1e-300;
+          if (q < 0.)
+            ++n_below;
+        }
+      if (n_below == n_steps)
+        upper = x;
+      else
+        lower = x;
+    }
+
+  // the Ritz values approach the largest eigenvalue from below, so include
+  // a safety factor
+  return std::min (1.2*upper, gershgorin_bound);
+}
+
+
+
+template <typename number>
+void
+SparseAMG<number>::v_cycle (const unsigned int    level,
+                            Vector<number>       &dst,
+                            const Vector<number> &src) const
+{
+  Level &this_level = *levels[level];
+  if (level+1 == levels.size())
+    {
+      if (coarse_inverse.m() > 0)
+        coarse_inverse.vmult (dst, src);
+      else
+        this_level.smoother.vmult (dst, src);
+      return;
+    }
+
+  const SparseMatrix<number> &level_matrix = get_matrix (level);
+  Level &coarse_level = *levels[level+1];
+
+  this_level.smoother.vmult (dst, src);
+
+  level_matrix.vmult (this_level.residual, dst);
+  this_level.residual.sadd (-1., 1., src);
+  this_level.prolongation.Tvmult (coarse_level.rhs, this_level.residual);
+
+  v_cycle (level+1, coarse_level.solution, coarse_level.rhs);
+
+  this_level.prolongation.vmult_add (dst, coarse_level.solution);
+  this_level.smoother.step (dst, src);
+}
+
+
+
+template <typename number>
+void
+SparseAMG<number>::vmult (Vector<number>       &dst,
+                          const Vector<number> &src) const
+{
+  Assert (levels.size() > 0, ExcNotInitialized());
+  AssertDimension (dst.size(), m());
+  AssertDimension (src.size(), n());
+
+  v_cycle (0, dst, src);
+}
+
+
+
+template <typename number>
+void
+SparseAMG<number>::Tvmult (Vector<number>       &dst,
+                           const Vector<number> &src) const
+{
+  vmult (dst, src);
+}
+
+
+
+template <typename number>
+typename SparseAMG<number>::size_type
+SparseAMG<number>::m () const
+{
+  Assert (fine_matrix != 0, ExcNotInitialized());
+  return fine_matrix->m();
+}
+
+
+
+template <typename number>
+typename SparseAMG<number>::size_type
+SparseAMG<number>::n () const
+{
+  Assert (fine_matrix != 0, ExcNotInitialized());
+  return fine_matrix->n();
+}
+
+
+
+template <typename number>
+unsigned int
+SparseAMG<number>::n_levels () const
+{
+  return levels.size();
+}
+
+
+
+template <typename number>
+const SparseMatrix<number> &
+SparseAMG<number>::get_matrix (const unsigned int level) const
+{
+  AssertIndexRange (level, levels.size());
+  if (level == 0)
+    return *fine_matrix;
+  else
+    return levels[level]->matrix;
+}
+
+
+
+template <typename number>
+const SparseMatrix<number> &
+SparseAMG<number>::get_prolongation (const unsigned int level) const
+{
+  AssertIndexRange (level+1, levels.size());
+  return levels[level]->prolongation;
+}
+
+
+
+template <typename number>
+std::size_t
+SparseAMG<number>::memory_consumption () const
+{
+  std::size_t memory = sizeof(*this) + coarse_inverse.memory_consumption();
+  for (unsigned int level=0; level<levels.size(); ++level)
+    memory += (sizeof(Level) +
+               levels[level]->sparsity.memory_consumption() +
+               levels[level]->matrix.memory_consumption() +
+               levels[level]->prolongation_sparsity.memory_consumption() +
+               levels[level]->prolongation.memory_consumption() +
+               levels[level]->rhs.memory_consumption() +
+               levels[level]->solution.memory_consumption() +
+               levels[level]->residual.memory_consumption());
+  return memory;
+}
+
+
+
+/*----------------------------   sparse_amg.templates.h     ---------------------------*/
+
+DEAL_II_NAMESPACE_CLOSE
+
+#endif
+/*----------------------------   sparse_amg.templates.h     ---------------------------*/
@@ -18,6 +18,7 @@
 
 #include <deal.II/base/config.h>
 #include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/sparse_level_schedule.h>
 
 #include <cmath>
 
@@ -148,7 +149,8 @@ public:
     AdditionalData (const double strengthen_diagonal=0,
                     const unsigned int extra_off_diagonals=0,
                     const bool use_previous_sparsity=false,
-                    const SparsityPattern *use_this_sparsity=0);
+                    const SparsityPattern *use_this_sparsity=0,
+                    const bool use_level_scheduling=false);
 
     /**
      * <code>strengthen_diag</code> times the sum of absolute row entries is
@@ -191,6 +193,20 @@ public:
      * matrix.
      */
     const SparsityPattern *use_this_sparsity;
+
+    /**
+     * If this flag is true, the initialize() function computes a
+     * SparseLevelSchedule of the sparsity pattern of the decomposition, and
+     * the forward and backward substitutions in <code>vmult()</code> of the
+     * derived classes are run in parallel with threads on the rows of each
+     * level. The result is the same as with the sequential substitutions.
+     * Since the number of levels depends on the numbering of the rows and
+     * the levels are run one after the other, this pays off for matrices
+     * with many rows per level only.
+     *
+     * Per default, this value is false.
+     */
+    bool use_level_scheduling;
   };
 
   /**
@@ -317,6 +333,12 @@ protected:
    */
   void prebuild_lower_bound ();
 
+  /**
+   * The schedule for the parallel forward and backward substitutions. Empty
+   * unless AdditionalData::use_level_scheduling was set in initialize().
+   */
+  SparseLevelSchedule level_schedule;
+
 private:
 
   /**
@@ -410,12 +432,14 @@ SparseLUDecomposition<number>::
 AdditionalData::AdditionalData (const double strengthen_diag,
                                 const unsigned int extra_off_diag,
                                 const bool use_prev_sparsity,
-                                const SparsityPattern *use_this_spars)
+                                const SparsityPattern *use_this_spars,
+                               const bool use_level_sched)
   :
   strengthen_diagonal(strengthen_diag),
   extra_off_diagonals(extra_off_diag),
   use_previous_sparsity(use_prev_sparsity),
-  use_this_sparsity(use_this_spars)
+  use_this_sparsity(use_this_spars),
+  use_level_scheduling(use_level_sched)
 {}
 
 
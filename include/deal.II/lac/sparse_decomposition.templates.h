@@ -49,6 +49,7 @@ void SparseLUDecomposition<number>::clear()
 {
   std::vector<const size_type *> tmp;
   tmp.swap (prebuilt_lower_bound);
+  level_schedule.clear ();
 
   SparseMatrix<number>::clear();
 
@@ -126,6 +127,12 @@ void SparseLUDecomposition<number>::initialize (
     tmp.swap (prebuilt_lower_bound);
   }
   SparseMatrix<number>::reinit (*sparsity_pattern_to_use);
+
+  if (data.use_level_scheduling)
+    level_schedule.reinit (*sparsity_pattern_to_use,
+                           SparseLevelSchedule::level_scheduled);
+  else
+    level_schedule.clear ();
 }
 
 
@@ -228,7 +235,8 @@ std::size_t
 SparseLUDecomposition<number>::memory_consumption () const
 {
   return (SparseMatrix<number>::memory_consumption () +
-          MemoryConsumption::memory_consumption(prebuilt_lower_bound));
+          MemoryConsumption::memory_consumption(prebuilt_lower_bound) +
+          level_schedule.memory_consumption());
 }
 
 
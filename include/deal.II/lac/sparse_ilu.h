@@ -106,6 +106,11 @@ public:
    * Apply the incomplete decomposition, i.e. do one forward-backward step
    * $dst=(LU)^{-1}src$.
    *
+   * If AdditionalData::use_level_scheduling was set in initialize(), the
+   * forward and backward substitutions are run in parallel along the levels
+   * of a SparseLevelSchedule, giving the same result as the sequential
+   * substitutions.
+   *
    * The initialize() function needs to be called before.
    */
   template <typename somenumber>
@@ -154,6 +159,27 @@ public:
                   "that the matrix for which you try to compute a "
                   "decomposition is singular.");
   //@}
+
+private:
+  /**
+   * Perform the forward substitution with the unit lower triangular factor
+   * on the rows given by the range of row indices, which are part of a
+   * level of the SparseLevelSchedule.
+   */
+  template <typename somenumber>
+  void forward_substitution_on_rows (const size_type    *begin_row,
+                                     const size_type    *end_row,
+                                     Vector<somenumber> &dst) const;
+
+  /**
+   * Perform the backward substitution with the upper triangular factor on
+   * the rows given by the range of row indices, which are part of a level of
+   * the SparseLevelSchedule.
+   */
+  template <typename somenumber>
+  void backward_substitution_on_rows (const size_type    *begin_row,
+                                      const size_type    *end_row,
+                                      Vector<somenumber> &dst) const;
 };
 
 /*@}*/
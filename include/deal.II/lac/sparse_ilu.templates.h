@@ -21,6 +21,7 @@
 #include <deal.II/base/config.h>
 #include <deal.II/lac/vector.h>
 #include <deal.II/lac/sparse_ilu.h>
+#include <deal.II/base/std_cxx11/bind.h>
 
 #include <algorithm>
 #include <cmath>
@@ -164,6 +165,20 @@ void SparseILU<number>::vmult (Vector<somenumber>       &dst,
   // perform it at the outset of the
   // loop
   dst = src;
+
+  if (!this->level_schedule.empty())
+    {
+      this->level_schedule.apply_forward
+      (std_cxx11::bind (&SparseILU<number>::template forward_substitution_on_rows<somenumber>,
+                        this, std_cxx11::_1, std_cxx11::_2,
+                        std_cxx11::ref(dst)));
+      this->level_schedule.apply_backward
+      (std_cxx11::bind (&SparseILU<number>::template backward_substitution_on_rows<somenumber>,
+                        this, std_cxx11::_1, std_cxx11::_2,
+                        std_cxx11::ref(dst)));
+      return;
+    }
+
   for (size_type row=0; row<N; ++row)
     {
       // get start of this row. skip the
@@ -211,6 +226,65 @@ void SparseILU<number>::vmult (Vector<somenumber>       &dst,
 }
 
 
+template <typename number>
+template <typename somenumber>
+void SparseILU<number>::forward_substitution_on_rows (const size_type    *begin_row,
+                                                      const size_type    *end_row,
+                                                      Vector<somenumber> &dst) const
+{
+  const std::size_t *const rowstart_indices
+    = this->get_sparsity_pattern().rowstart;
+  const size_type *const column_numbers
+    = this->get_sparsity_pattern().colnums;
+
+  // same operations as in the forward solve of vmult()
+  for (const size_type *row_ptr=begin_row; row_ptr!=end_row; ++row_ptr)
+    {
+      const size_type row = *row_ptr;
+      const size_type *const rowstart = &column_numbers[rowstart_indices[row]+1];
+      const size_type *const first_after_diagonal = this->prebuilt_lower_bound[row];
+
+      somenumber dst_row = dst(row);
+      const number *luval = this->SparseMatrix<number>::val +
+                            (rowstart - column_numbers);
+      for (const size_type *col=rowstart; col!=first_after_diagonal; ++col, ++luval)
+        dst_row -= *luval * dst(*col);
+      dst(row) = dst_row;
+    }
+}
+
+
+
+template <typename number>
+template <typename somenumber>
+void SparseILU<number>::backward_substitution_on_rows (const size_type    *begin_row,
+                                                       const size_type    *end_row,
+                                                       Vector<somenumber> &dst) const
+{
+  const std::size_t *const rowstart_indices
+    = this->get_sparsity_pattern().rowstart;
+  const size_type *const column_numbers
+    = this->get_sparsity_pattern().colnums;
+
+  // same operations as in the backward solve of vmult()
+  for (const size_type *row_ptr=begin_row; row_ptr!=end_row; ++row_ptr)
+    {
+      const size_type row = *row_ptr;
+      const size_type *const rowend = &column_numbers[rowstart_indices[row+1]];
+      const size_type *const first_after_diagonal = this->prebuilt_lower_bound[row];
+
+      somenumber dst_row = dst(row);
+      const number *luval = this->SparseMatrix<number>::val +
+                            (first_after_diagonal - column_numbers);
+      for (const size_type *col=first_after_diagonal; col!=rowend; ++col, ++luval)
+        dst_row -= *luval * dst(*col);
+
+      dst(row) = dst_row * this->diag_element(row);
+    }
+}
+
+
+
 template <typename number>
 template <typename somenumber>
 void SparseILU<number>::Tvmult (Vector<somenumber>       &dst,
@@ -0,0 +1,439 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+#ifndef dealii__sparse_level_schedule_h
+#define dealii__sparse_level_schedule_h
+
+
+#include <deal.II/base/config.h>
+#include <deal.II/base/subscriptor.h>
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/parallel.h>
+#include <deal.II/base/types.h>
+
+#include <vector>
+
+DEAL_II_NAMESPACE_OPEN
+
+class SparsityPattern;
+
+/**
+ * @addtogroup Sparsity
+ * @{
+ */
+
+/**
+ * A schedule for running the forward and backward sweeps of triangular
+ * solves with a sparse matrix, such as the ones in SSOR, SOR, ILU or MIC
+ * preconditioners, in parallel with threads.
+ *
+ * In a forward sweep, row $i$ can only be processed once all rows $j$ with
+ * entries $a_{ij}$ in the lower triangle have been processed, and similarly
+ * for the upper triangle in a backward sweep. This class analyzes the
+ * dependencies given by a square SparsityPattern once and groups the rows
+ * into levels of rows that do not depend on each other. The levels are
+ * processed one after the other, and the rows within a level are
+ * distributed among the available threads by parallel::apply_to_subranges.
+ * Two variants are implemented:
+ * <ul>
+ * <li> <i>Level scheduling</i> (Mode::level_scheduled): The level of a row
+ * is one more than the largest level of the rows in the lower (upper)
+ * triangle it depends on. The sweeps compute exactly the same result as a
+ * sequential sweep through the rows in their natural order, because each
+ * row sees the same values in the same order of summation. On the other
+ * hand, the number of levels depends on the numbering of the matrix rows
+ * and can be large, e.g. proportional to $N^{1/d}$ wavefronts for a
+ * stencil on a structured mesh with $N$ unknowns in $d$ dimensions, which
+ * limits the parallelism to the size of the wavefronts.
+ * <li> <i>Multicoloring</i> (Mode::multicolor): The rows are colored
+ * greedily such that no two rows of the same color are coupled in the
+ * symmetrized sparsity pattern. The sweeps then work on the rows color by
+ * color, and the lower (upper) triangle of a row is defined as the entries
+ * in columns of a smaller (larger) color. This corresponds to the
+ * sequential sweep on the matrix renumbered by colors. The result is not
+ * the same as with the natural order, but it gives a preconditioner of
+ * similar quality with few levels (e.g. two colors for a five-point
+ * stencil) that each contain many rows. If the matrix is symmetric, so is
+ * the SSOR preconditioner based on this ordering.
+ * </ul>
+ *
+ * Since the levels are processed with a synchronization in between, levels
+ * with fewer rows than internal::SparseMatrix::minimum_parallel_grain_size
+ * are not distributed among threads. Consecutive small levels are merged
+ * and run in one sequential sweep.
+ *
+ * The schedule is used by the overloads of SparseMatrix::precondition_SSOR(),
+ * SparseMatrix::precondition_SOR() and SparseMatrix::precondition_TSOR()
+ * that take an object of this class, by PreconditionSSOR and
+ * PreconditionSOR if requested through their AdditionalData, and by
+ * SparseILU and SparseMIC if requested through
+ * SparseLUDecomposition::AdditionalData::use_level_scheduling.
+ */
+class SparseLevelSchedule : public Subscriptor
+{
+public:
+  /**
+   * Declare type for container size.
+   */
+  typedef types::global_dof_index size_type;
+
+  /**
+   * The variants of the schedule, see the class documentation.
+   */
+  enum Mode
+  {
+    /**
+     * Group the rows into levels by the dependencies in the lower and upper
+     * triangle of the matrix. Gives the same result as the sequential sweep.
+     */
+    level_scheduled,
+    /**
+     * Group the rows by a coloring of the sparsity pattern, changing the
+     * order in which the rows are relaxed.
+     */
+    multicolor
+  };
+
+  /**
+   * Constructor. Creates an empty object, which needs to be initialized by
+   * reinit() before it can be used.
+   */
+  SparseLevelSchedule ();
+
+  /**
+   * Constructor. Calls reinit() with the given arguments.
+   */
+  SparseLevelSchedule (const SparsityPattern &sparsity,
+                       const Mode             mode = level_scheduled);
+
+  /**
+   * Analyze the given square sparsity pattern and compute the levels for
+   * the forward and backward sweeps. The sparsity pattern must store the
+   * diagonal entry first in each row, which is the case for square
+   * patterns.
+   */
+  void reinit (const SparsityPattern &sparsity,
+               const Mode             mode = level_scheduled);
+
+  /**
+   * Reset the object to the state after the default constructor.
+   */
+  void clear ();
+
+  /**
+   * Return whether the object is empty, i.e., whether reinit() has not been
+   * called yet.
+   */
+  bool empty () const;
+
+  /**
+   * Return the number of rows of the sparsity pattern the schedule was
+   * computed for.
+   */
+  size_type n_rows () const;
+
+  /**
+   * Return the number of nonzero entries of the sparsity pattern the
+   * schedule was computed for. Used to check that a matrix matches the
+   * schedule.
+   */
+  std::size_t n_nonzero_elements () const;
+
+  /**
+   * Return the variant of the schedule.
+   */
+  Mode get_mode () const;
+
+  /**
+   * Return the number of levels of the forward sweep.
+   */
+  unsigned int n_forward_levels () const;
+
+  /**
+   * Return the number of levels of the backward sweep.
+   */
+  unsigned int n_backward_levels () const;
+
+  /**
+   * Return the rows of the given level of the forward sweep, sorted by
+   * their index.
+   */
+  std::vector<size_type>
+  get_forward_level (const unsigned int level) const;
+
+  /**
+   * Return the rows of the given level of the backward sweep, sorted by
+   * their index.
+   */
+  std::vector<size_type>
+  get_backward_level (const unsigned int level) const;
+
+  /**
+   * For Mode::level_scheduled, return the index within the row (in the
+   * sense of SparsityPatternIterators::Accessor::index()) of the first
+   * entry to the right of the diagonal. The entries with index between one
+   * and this number form the lower triangle, the entries from this number
+   * to the end of the row the upper triangle.
+   */
+  unsigned int first_upper_index (const size_type row) const;
+
+  /**
+   * For Mode::multicolor, return the color of the given row.
+   */
+  unsigned int color (const size_type row) const;
+
+  /**
+   * Return whether the entry in column @p col of row @p row belongs to the
+   * lower triangle in the ordering of the schedule, i.e., <tt>col@<row</tt>
+   * for Mode::level_scheduled and a smaller color of @p col for
+   * Mode::multicolor.
+   */
+  bool is_lower (const size_type row,
+                 const size_type col) const;
+
+  /**
+   * Run a forward sweep. The given function object is called as
+   * <tt>worker(begin,end)</tt> on ranges of pointers into an array of row
+   * indices, and must process the rows in the order given. Calls for rows
+   * of the same level may run concurrently on different threads, whereas
+   * all rows of the previous levels have been processed before.
+   */
+  template <typename Worker>
+  void apply_forward (const Worker &worker) const;
+
+  /**
+   * Run a backward sweep with the same calling convention as
+   * apply_forward().
+   */
+  template <typename Worker>
+  void apply_backward (const Worker &worker) const;
+
+  /**
+   * Determine an estimate for the memory consumption (in bytes) of this
+   * object.
+   */
+  std::size_t memory_consumption () const;
+
+  /**
+   * Exception
+   */
+  DeclExceptionMsg (ExcScheduleMismatch,
+                    "The level schedule was computed for a sparsity pattern "
+                    "different from the one of the matrix.");
+
+private:
+  /**
+   * Run the levels given by @p rows and @p level_starts one after the
+   * other.
+   */
+  template <typename Worker>
+  void apply_levels (const std::vector<size_type>   &rows,
+                     const std::vector<std::size_t> &level_starts,
+                     const Worker                   &worker) const;
+
+  /**
+   * The variant of the schedule.
+   */
+  Mode mode;
+
+  /**
+   * The number of nonzero entries of the sparsity pattern.
+   */
+  std::size_t n_nonzero;
+
+  /**
+   * The rows in the order of the forward sweep, grouped by levels.
+   */
+  std::vector<size_type> forward_rows;
+
+  /**
+   * The start of each forward level in #forward_rows, with one additional
+   * entry for the end of the last level.
+   */
+  std::vector<std::size_t> forward_level_starts;
+
+  /**
+   * The rows in the order of the backward sweep, grouped by levels.
+   */
+  std::vector<size_type> backward_rows;
+
+  /**
+   * The start of each backward level in #backward_rows, with one additional
+   * entry for the end of the last level.
+   */
+  std::vector<std::size_t> backward_level_starts;
+
+  /**
+   * For Mode::level_scheduled the index of the first entry right of the
+   * diagonal in each row, for Mode::multicolor the color of each row.
+   */
+  std::vector<unsigned int> row_data;
+};
+
+/*@}*/
+
+//---------------------------------------------------------------------------
+
+#ifndef DOXYGEN
+
+inline
+bool
+SparseLevelSchedule::empty () const
+{
+  return forward_level_starts.empty();
+}
+
+
+
+inline
+SparseLevelSchedule::size_type
+SparseLevelSchedule::n_rows () const
+{
+  return row_data.size();
+}
+
+
+
+inline
+std::size_t
+SparseLevelSchedule::n_nonzero_elements () const
+{
+  return n_nonzero;
+}
+
+
+
+inline
+SparseLevelSchedule::Mode
+SparseLevelSchedule::get_mode () const
+{
+  return mode;
+}
+
+
+
+inline
+unsigned int
+SparseLevelSchedule::n_forward_levels () const
+{
+  return forward_level_starts.empty() ? 0 : forward_level_starts.size()-1;
+}
+
+
+
+inline
+unsigned int
+SparseLevelSchedule::n_backward_levels () const
+{
+  return backward_level_starts.empty() ? 0 : backward_level_starts.size()-1;
+}
+
+
+
+inline
+unsigned int
+SparseLevelSchedule::first_upper_index (const size_type row) const
+{
+  Assert (mode == level_scheduled, ExcInternalError());
+  AssertIndexRange (row, row_data.size());
+  return row_data[row];
+}
+
+
+
+inline
+unsigned int
+SparseLevelSchedule::color (const size_type row) const
+{
+  Assert (mode == multicolor, ExcInternalError());
+  AssertIndexRange (row, row_data.size());
+  return row_data[row];
+}
+
+
+
+inline
+bool
+SparseLevelSchedule::is_lower (const size_type row,
+                               const size_type col) const
+{
+  if (mode == level_scheduled)
+    return col < row;
+  else
+    return row_data[col] < row_data[row];
+}
+
+
+
+template <typename Worker>
+inline
+void
+SparseLevelSchedule::apply_levels (const std::vector<size_type>   &rows,
+                                   const std::vector<std::size_t> &level_starts,
+                                   const Worker                   &worker) const
+{
+  if (rows.empty())
+    return;
+
+  const size_type *const row_ptr = &rows[0];
+  const std::size_t grain_size = internal::SparseMatrix::minimum_parallel_grain_size;
+
+  // levels that are too small to be split among threads are collected and
+  // processed in one sequential sweep, which is valid since the rows are
+  // stored level by level
+  std::size_t sequential_start = 0;
+  for (unsigned int level=0; level<level_starts.size()-1; ++level)
+    {
+      const std::size_t begin = level_starts[level], end = level_starts[level+1];
+      if (end - begin >= 2*grain_size)
+        {
+          if (sequential_start < begin)
+            worker (row_ptr+sequential_start, row_ptr+begin);
+          parallel::apply_to_subranges (row_ptr+begin, row_ptr+end, worker,
+                                        grain_size);
+          sequential_start = end;
+        }
+    }
+  if (sequential_start < rows.size())
+    worker (row_ptr+sequential_start, row_ptr+rows.size());
+}
+
+
+
+template <typename Worker>
+inline
+void
+SparseLevelSchedule::apply_forward (const Worker &worker) const
+{
+  Assert (!empty(), ExcNotInitialized());
+  apply_levels (forward_rows, forward_level_starts, worker);
+}
+
+
+
+template <typename Worker>
+inline
+void
+SparseLevelSchedule::apply_backward (const Worker &worker) const
+{
+  Assert (!empty(), ExcNotInitialized());
+  apply_levels (backward_rows, backward_level_starts, worker);
+}
+
+#endif // DOXYGEN
+
+DEAL_II_NAMESPACE_CLOSE
+
+#endif
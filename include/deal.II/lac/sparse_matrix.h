@@ -20,6 +20,7 @@
 #include <deal.II/base/config.h>
 #include <deal.II/base/subscriptor.h>
 #include <deal.II/base/smartpointer.h>
+#include <deal.II/base/std_cxx11/shared_ptr.h>
 #include <deal.II/lac/sparsity_pattern.h>
 #include <deal.II/lac/identity_matrix.h>
 #include <deal.II/lac/exceptions.h>
@@ -31,6 +32,7 @@ template <typename number> class Vector;
 template <typename number> class FullMatrix;
 template <typename Matrix> class BlockMatrixBase;
 template <typename number> class SparseILU;
+class SparseLevelSchedule;
 
 #ifdef DEAL_II_WITH_TRILINOS
 namespace TrilinosWrappers
@@ -540,7 +542,8 @@ public:
 #ifdef DEAL_II_WITH_CXX11
   /**
    * Move constructor. Construct a new sparse matrix by transferring the
-   * internal data of the matrix @p m into a new object.
+   * internal data of the matrix @p m into a new object. @p m is left in the
+   * state of a default-constructed matrix.
    *
    * Move construction allows an object to be returned from a function or
    * packed into a tuple even when the class cannot be copy-constructed.
@@ -595,7 +598,8 @@ public:
 #ifdef DEAL_II_WITH_CXX11
   /**
    * Move assignment operator. This operator replaces the present matrix with
-   * @p m by transferring the internal data of @p m.
+   * @p m by transferring the internal data of @p m, and leaves @p m in the
+   * state of a default-constructed matrix.
    *
    * @note This operator is only available if deal.II is configured with C++11
    * support.
@@ -1099,6 +1103,27 @@ public:
   void Tvmult_add (OutVector      &dst,
                    const InVector &src) const;
 
+  /**
+   * Matrix-vector multiplication with several vectors at once: let
+   * <i>dst[i] = M*src[i]</i> for all vectors in @p src, with <i>M</i> being
+   * this matrix. The matrix entries of each row are read once for all
+   * vectors instead of once per vector, which makes this function
+   * considerably faster than calling vmult() for each vector, since the
+   * latter is limited by the memory transfer of the matrix. This is used by
+   * the block Krylov solvers SolverBlockCG and SolverBlockGMRES. The result
+   * for each vector is the same as the one of vmult().
+   *
+   * The vector type must provide raw access to its elements through
+   * <tt>begin()</tt>, like dealii::Vector and (for the serial case)
+   * LinearAlgebra::distributed::Vector. None of the source vectors may
+   * be one of the destination vectors.
+   *
+   * @dealiiOperationIsMultithreaded
+   */
+  template <class VectorType>
+  void multi_vmult (const std::vector<VectorType *>       &dst,
+                    const std::vector<const VectorType *> &src) const;
+
   /**
    * Return the square of the norm of the vector $v$ with respect to the norm
    * induced by this matrix, i.e. $\left(v,Mv\right)$. This is useful, e.g. in
@@ -1176,6 +1201,25 @@ public:
    * that the sparsity pattern of @p C is modified and that this would
    * render invalid <i>all other SparseMatrix objects</i> that happen
    * to <i>also</i> use that sparsity pattern object.
+   *
+   * The product is computed in two phases. The symbolic phase, run only
+   * when the sparsity pattern is rebuilt, determines the column indices of
+   * each row of @p C. The numeric phase then computes the entries of @p C
+   * row by row, accumulating the products of each row through an array
+   * that maps column indices to positions in the row. Both phases work on
+   * independent rows and are run in parallel if deal.II is configured with
+   * threads. When the same product with changed entries but unchanged
+   * sparsity patterns of the factors is computed repeatedly, e.g. for the
+   * Galerkin coarse operators of a multigrid method that are recomputed in
+   * every time step, the sparsity pattern of @p C computed in the first
+   * call acts as a plan for the later calls with @p rebuild_sparsity_pattern
+   * set to @p false, which only run the numeric phase.
+   *
+   * If the sparsity pattern is not rebuilt, the product is added to the
+   * current entries of @p C, so set <tt>C = 0</tt> before such a call to
+   * compute the product alone. Entries of the product that are not part of
+   * the sparsity pattern of @p C are dropped, which is an error in debug
+   * mode.
    */
   template <typename numberB, typename numberC>
   void mmult (SparseMatrix<numberC>       &C,
@@ -1203,6 +1247,17 @@ public:
    * the sparsity pattern stored in <tt>C</tt>. In that case, make sure that
    * it really fits. The default is to rebuild the sparsity pattern.
    *
+   * Like mmult(), this function computes the product in a symbolic and a
+   * numeric phase that run in parallel over the rows of @p C. Calls with
+   * <tt>rebuild_sparsity_pattern</tt> set to @p false only run the numeric
+   * phase, which adds the product to the current entries of @p C and drops
+   * entries that are not part of its sparsity pattern, like mmult().
+   *
+   * @note Both phases work on a transposed copy of this matrix, which is set
+   * up in every call, also when the sparsity pattern of @p C is not rebuilt.
+   * The cost of this copy is proportional to the number of nonzero entries
+   * of this matrix and is not saved by reusing the sparsity pattern of @p C.
+   *
    * @note Rebuilding the sparsity pattern requires changing it. This means
    * that all other matrices that are associated with this sparsity pattern
    * will then have invalid entries.
@@ -1286,6 +1341,44 @@ public:
                           const Vector<somenumber> &src,
                           const number              om = 1.) const;
 
+  /**
+   * Apply SSOR preconditioning to <tt>src</tt> with damping <tt>omega</tt>,
+   * running the forward and backward sweeps with threads in the levels of
+   * the given @p schedule, which must have been computed for the sparsity
+   * pattern of this matrix. For SparseLevelSchedule::level_scheduled, the
+   * result is the same as the one of the other precondition_SSOR() function
+   * with the positions right of the diagonal given. For
+   * SparseLevelSchedule::multicolor, the rows are relaxed in the order of
+   * the colors.
+   */
+  template <typename somenumber>
+  void precondition_SSOR (Vector<somenumber>        &dst,
+                          const Vector<somenumber>  &src,
+                          const number               omega,
+                          const SparseLevelSchedule &schedule) const;
+
+  /**
+   * Apply SOR preconditioning matrix to <tt>src</tt>, running the forward
+   * sweep with threads in the levels of the given @p schedule. See the
+   * precondition_SSOR() function taking a SparseLevelSchedule.
+   */
+  template <typename somenumber>
+  void precondition_SOR (Vector<somenumber>        &dst,
+                         const Vector<somenumber>  &src,
+                         const number               om,
+                         const SparseLevelSchedule &schedule) const;
+
+  /**
+   * Apply transpose SOR preconditioning matrix to <tt>src</tt>, running the
+   * backward sweep with threads in the levels of the given @p schedule. See
+   * the precondition_SSOR() function taking a SparseLevelSchedule.
+   */
+  template <typename somenumber>
+  void precondition_TSOR (Vector<somenumber>        &dst,
+                          const Vector<somenumber>  &src,
+                          const number               om,
+                          const SparseLevelSchedule &schedule) const;
+
   /**
    * Perform SSOR preconditioning in-place.  Apply the preconditioner matrix
    * without copying to a second vector.  <tt>omega</tt> is the relaxation
@@ -1616,6 +1709,15 @@ private:
    */
   std::size_t max_len;
 
+  /**
+   * For parallel loops with TBB, this member variable stores the affinity
+   * information of the loops over the rows of the matrix. The same
+   * partitioner is used for zeroing newly allocated memory in operator=()
+   * and for the matrix-vector products, such that on NUMA systems, the rows
+   * are placed close to the threads that work on them later.
+   */
+  std_cxx11::shared_ptr<parallel::internal::TBBPartitioner> thread_loop_partitioner;
+
   // make all other sparse matrices friends
   template <typename somenumber> friend class SparseMatrix;
   template <typename somenumber> friend class SparseLUDecomposition;
@@ -22,8 +22,10 @@
 #include <deal.II/base/template_constraints.h>
 #include <deal.II/base/parallel.h>
 #include <deal.II/base/thread_management.h>
+#include <deal.II/base/thread_local_storage.h>
 #include <deal.II/base/utilities.h>
 #include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/sparse_level_schedule.h>
 #include <deal.II/lac/trilinos_sparse_matrix.h>
 #include <deal.II/lac/vector.h>
 #include <deal.II/lac/full_matrix.h>
@@ -49,7 +51,8 @@ SparseMatrix<number>::SparseMatrix ()
   :
   cols(0, "SparseMatrix"),
   val(0),
-  max_len(0)
+  max_len(0),
+  thread_loop_partitioner(new parallel::internal::TBBPartitioner())
 {}
 
 
@@ -60,7 +63,8 @@ SparseMatrix<number>::SparseMatrix (const SparseMatrix &m)
   Subscriptor (m),
   cols(0, "SparseMatrix"),
   val(0),
-  max_len(0)
+  max_len(0),
+  thread_loop_partitioner(new parallel::internal::TBBPartitioner())
 {
   Assert (m.cols==0 && m.val==0 && m.max_len==0,
           ExcMessage("This constructor can only be called if the provided argument "
@@ -78,11 +82,13 @@ SparseMatrix<number>::SparseMatrix (SparseMatrix<number> &&m)
   Subscriptor(std::move(m)),
   cols(m.cols),
   val(m.val),
-  max_len(m.max_len)
+  max_len(m.max_len),
+  thread_loop_partitioner(std::move(m.thread_loop_partitioner))
 {
   m.cols = nullptr;
   m.val = nullptr;
   m.max_len = 0;
+  m.thread_loop_partitioner.reset(new parallel::internal::TBBPartitioner());
 }
 #endif
 
@@ -112,10 +118,12 @@ SparseMatrix<number>::operator = (SparseMatrix<number> &&m)
   cols = m.cols;
   val = m.val;
   max_len = m.max_len;
+  thread_loop_partitioner = std::move(m.thread_loop_partitioner);
 
   m.cols = nullptr;
   m.val = nullptr;
   m.max_len = 0;
+  m.thread_loop_partitioner.reset(new parallel::internal::TBBPartitioner());
 
   return *this;
 }
@@ -128,7 +136,8 @@ SparseMatrix<number>::SparseMatrix (const SparsityPattern &c)
   :
   cols(0, "SparseMatrix"),
   val(0),
-  max_len(0)
+  max_len(0),
+  thread_loop_partitioner(new parallel::internal::TBBPartitioner())
 {
   reinit (c);
 }
@@ -141,7 +150,8 @@ SparseMatrix<number>::SparseMatrix (const SparsityPattern &c,
   :
   cols(0, "SparseMatrix"),
   val(0),
-  max_len(0)
+  max_len(0),
+  thread_loop_partitioner(new parallel::internal::TBBPartitioner())
 {
   (void)id;
   Assert (c.n_rows() == id.m(), ExcDimensionMismatch (c.n_rows(), id.m()));
@@ -171,12 +181,18 @@ namespace internal
   {
     typedef types::global_dof_index size_type;
 
+    /**
+     * Set the entries in the rows <tt>[begin_row,end_row)</tt> of a sparse
+     * matrix to zero.
+     */
     template<typename T>
-    void zero_subrange (const size_type begin,
-                        const size_type end,
-                        T *dst)
+    void zero_rows_on_subrange (const size_type    begin_row,
+                                const size_type    end_row,
+                                const std::size_t *rowstart,
+                                T                 *values)
     {
-      std::memset (dst+begin,0,(end-begin)*sizeof(T));
+      std::memset (values+rowstart[begin_row], 0,
+                   (rowstart[end_row]-rowstart[begin_row])*sizeof(T));
     }
   }
 }
@@ -197,20 +213,20 @@ SparseMatrix<number>::operator = (const double d)
   // layout as when doing matrix-vector products, as on some NUMA systems, a
   // memory block is assigned to memory banks where the first access is
   // generated. For sparse matrices, the first operations is usually the
-  // operator=. The grain size is chosen to reflect the number of rows in
-  // minimum_parallel_grain_size, weighted by the number of nonzero entries
-  // per row on average.
+  // operator=. To this end, split the work by rows with the same grain size
+  // and the same affinity partitioner as in vmult(), such that the loop over
+  // the rows of the matrix-vector product hands each range of rows to the
+  // thread that has touched the respective entries first.
   const std::size_t matrix_size = cols->n_nonzero_elements();
-  const size_type grain_size =
-    internal::SparseMatrix::minimum_parallel_grain_size *
-    (cols->n_nonzero_elements()+m()) / m();
-  if (matrix_size>grain_size)
-    parallel::apply_to_subranges (0U, matrix_size,
+  if (m() > internal::SparseMatrix::minimum_parallel_grain_size)
+    parallel::apply_to_subranges (0U, m(),
                                   std_cxx11::bind(&internal::SparseMatrix::template
-                                                  zero_subrange<number>,
+                                                  zero_rows_on_subrange<number>,
                                                   std_cxx11::_1, std_cxx11::_2,
+                                                  cols->rowstart,
                                                   val),
-                                  grain_size);
+                                  internal::SparseMatrix::minimum_parallel_grain_size,
+                                  *thread_loop_partitioner);
   else if (matrix_size > 0)
     std::memset (&val[0], 0, matrix_size*sizeof(number));
 
@@ -260,6 +276,10 @@ SparseMatrix<number>::reinit (const SparsityPattern &sparsity)
         delete[] val;
       val = new number[N];
       max_len = N;
+
+      // the new memory is first touched in the zeroing below, so start over
+      // with the affinity information of the loops
+      thread_loop_partitioner.reset(new parallel::internal::TBBPartitioner());
     }
 
   *this = 0.;
@@ -514,6 +534,59 @@ namespace internal
             *dst_ptr++ = s;
           }
     }
+
+
+
+    /**
+     * Perform the multiplication of the rows in the range
+     * <tt>[begin_row,end_row)</tt> with several vectors at once. The vectors
+     * are processed in groups of eight for each row, such that the entries
+     * of the row are loaded from memory only once and reused from the cache
+     * for the other groups. The entries are summed up in the same order as
+     * in vmult_on_subrange().
+     */
+    template <typename number,
+              typename VectorType>
+    void multi_vmult_on_subrange (const size_type                        begin_row,
+                                  const size_type                        end_row,
+                                  const number                          *values,
+                                  const std::size_t                     *rowstart,
+                                  const size_type                       *colnums,
+                                  const std::vector<const VectorType *> &src,
+                                  const std::vector<VectorType *>       &dst)
+    {
+      typedef typename VectorType::value_type Number;
+      const unsigned int group_size = 8;
+      const unsigned int n_vectors = src.size();
+
+      for (unsigned int v0=0; v0<n_vectors; v0+=group_size)
+        {
+          const unsigned int n_group = std::min(group_size, n_vectors-v0);
+          const Number *src_ptr[group_size];
+          Number *dst_ptr[group_size];
+          for (unsigned int v=0; v<n_group; ++v)
+            {
+              src_ptr[v] = src[v0+v]->begin();
+              dst_ptr[v] = dst[v0+v]->begin();
+            }
+
+          for (size_type row=begin_row; row<end_row; ++row)
+            {
+              Number s[group_size];
+              for (unsigned int v=0; v<n_group; ++v)
+                s[v] = Number();
+              for (std::size_t j=rowstart[row]; j<rowstart[row+1]; ++j)
+                {
+                  const Number    value = Number(values[j]);
+                  const size_type col   = colnums[j];
+                  for (unsigned int v=0; v<n_group; ++v)
+                    s[v] += value * src_ptr[v][col];
+                }
+              for (unsigned int v=0; v<n_group; ++v)
+                dst_ptr[v][row] = s[v];
+            }
+        }
+    }
   }
 }
 
@@ -774,7 +847,8 @@ SparseMatrix<number>::vmult (OutVector &dst,
                                                  std_cxx11::cref(src),
                                                  std_cxx11::ref(dst),
                                                  false),
-                                internal::SparseMatrix::minimum_parallel_grain_size);
+                                internal::SparseMatrix::minimum_parallel_grain_size,
+                                *thread_loop_partitioner);
 }
 
 
@@ -829,7 +903,8 @@ SparseMatrix<number>::vmult_add (OutVector &dst,
                                                  std_cxx11::cref(src),
                                                  std_cxx11::ref(dst),
                                                  true),
-                                internal::SparseMatrix::minimum_parallel_grain_size);
+                                internal::SparseMatrix::minimum_parallel_grain_size,
+                                *thread_loop_partitioner);
 }
 
 
@@ -856,6 +931,43 @@ SparseMatrix<number>::Tvmult_add (OutVector &dst,
 }
 
 
+
+template <typename number>
+template <class VectorType>
+void
+SparseMatrix<number>::multi_vmult (const std::vector<VectorType *>       &dst,
+                                   const std::vector<const VectorType *> &src) const
+{
+  Assert (cols != 0, ExcNotInitialized());
+  Assert (val != 0, ExcNotInitialized());
+  AssertDimension (dst.size(), src.size());
+  for (unsigned int v=0; v<src.size(); ++v)
+    {
+      Assert(m() == dst[v]->size(), ExcDimensionMismatch(m(),dst[v]->size()));
+      Assert(n() == src[v]->size(), ExcDimensionMismatch(n(),src[v]->size()));
+      for (unsigned int w=0; w<src.size(); ++w)
+        Assert (!PointerComparison::equal(src[w], dst[v]),
+                ExcSourceEqualsDestination());
+    }
+
+  if (src.size() == 0)
+    return;
+
+  parallel::apply_to_subranges (0U, m(),
+                                std_cxx11::bind (&internal::SparseMatrix::multi_vmult_on_subrange
+                                                 <number,VectorType>,
+                                                 std_cxx11::_1, std_cxx11::_2,
+                                                 val,
+                                                 cols->rowstart,
+                                                 cols->colnums,
+                                                 std_cxx11::cref(src),
+                                                 std_cxx11::cref(dst)),
+                                internal::SparseMatrix::minimum_parallel_grain_size,
+                                *thread_loop_partitioner);
+}
+
+
+
 namespace internal
 {
   namespace SparseMatrix
@@ -912,7 +1024,8 @@ SparseMatrix<number>::matrix_norm_square (const Vector<somenumber> &v) const
                       val, cols->rowstart, cols->colnums,
                       std_cxx11::cref(v)),
      0, m(),
-     internal::SparseMatrix::minimum_parallel_grain_size);
+     internal::SparseMatrix::minimum_parallel_grain_size,
+     *thread_loop_partitioner);
 }
 
 
@@ -976,7 +1089,155 @@ SparseMatrix<number>::matrix_scalar_product (const Vector<somenumber> &u,
                       std_cxx11::cref(u),
                       std_cxx11::cref(v)),
      0, m(),
-     internal::SparseMatrix::minimum_parallel_grain_size);
+     internal::SparseMatrix::minimum_parallel_grain_size,
+     *thread_loop_partitioner);
+}
+
+
+
+namespace internal
+{
+  namespace SparseMatrix
+  {
+    /**
+     * Symbolic phase of the product <tt>C = L * R</tt> of two sparse
+     * matrices: compute the sorted column indices of the rows
+     * <tt>[begin,end)</tt> of C. The rows of the left factor L and the right
+     * factor R are given by their compressed row storage arrays. The marker
+     * array of each thread records in which row a column of C has been seen
+     * last.
+     */
+    struct ProductPatternOnSubrange
+    {
+      const std::size_t *left_rowstart;
+      const size_type   *left_colnums;
+      const std::size_t *right_rowstart;
+      const size_type   *right_colnums;
+      size_type          n_cols;
+      Threads::ThreadLocalStorage<std::vector<size_type> > *markers;
+      std::vector<std::vector<size_type> >                 *rows;
+
+      void operator() (const size_type begin_row,
+                       const size_type end_row) const
+      {
+        std::vector<size_type> &marker = markers->get();
+        if (marker.size() != n_cols)
+          marker.resize (n_cols, numbers::invalid_size_type);
+
+        for (size_type i=begin_row; i<end_row; ++i)
+          {
+            std::vector<size_type> &row = (*rows)[i];
+            for (std::size_t j=left_rowstart[i]; j<left_rowstart[i+1]; ++j)
+              {
+                const size_type k = left_colnums[j];
+                for (std::size_t l=right_rowstart[k]; l<right_rowstart[k+1]; ++l)
+                  if (marker[right_colnums[l]] != i)
+                    {
+                      marker[right_colnums[l]] = i;
+                      row.push_back (right_colnums[l]);
+                    }
+              }
+            std::sort (row.begin(), row.end());
+          }
+      }
+    };
+
+
+
+    /**
+     * Numeric phase of the product <tt>C += L * diag(V) * R</tt> of two
+     * sparse matrices on the rows <tt>[begin,end)</tt> of C. The products
+     * are added to the entries of a row of C through an array of each thread
+     * that maps the column indices to the positions in the row. Entries of
+     * the product that are not part of the sparsity pattern of C are
+     * dropped, which is an error in debug mode. The scaling vector V is
+     * skipped if it is a null pointer.
+     */
+    template <typename number, typename numberB, typename numberC>
+    struct ProductValuesOnSubrange
+    {
+      const std::size_t *left_rowstart;
+      const size_type   *left_colnums;
+      const number      *left_values;
+      const number      *scaling;
+      const std::size_t *right_rowstart;
+      const size_type   *right_colnums;
+      const numberB     *right_values;
+      const std::size_t *rowstart;
+      const size_type   *colnums;
+      numberC           *values;
+      size_type          n_cols;
+      Threads::ThreadLocalStorage<std::vector<size_type> > *markers;
+
+      void operator() (const size_type begin_row,
+                       const size_type end_row) const
+      {
+        std::vector<size_type> &position = markers->get();
+        if (position.size() != n_cols)
+          position.resize (n_cols, numbers::invalid_size_type);
+
+        for (size_type i=begin_row; i<end_row; ++i)
+          {
+            for (std::size_t p=rowstart[i]; p<rowstart[i+1]; ++p)
+              position[colnums[p]] = p;
+
+            for (std::size_t j=left_rowstart[i]; j<left_rowstart[i+1]; ++j)
+              {
+                const size_type k = left_colnums[j];
+                const numberC left_value = (scaling != 0 ?
+                                            numberC(left_values[j]) * numberC(scaling[k]) :
+                                            numberC(left_values[j]));
+                for (std::size_t l=right_rowstart[k]; l<right_rowstart[k+1]; ++l)
+                  {
+                    const size_type p = position[right_colnums[l]];
+                    if (p != numbers::invalid_size_type)
+                      values[p] += left_value * numberC(right_values[l]);
+                    else
+                      Assert (false,
+                              typename dealii::SparseMatrix<numberC>::ExcInvalidIndex
+                              (i, right_colnums[l]));
+                  }
+              }
+
+            for (std::size_t p=rowstart[i]; p<rowstart[i+1]; ++p)
+              position[colnums[p]] = numbers::invalid_size_type;
+          }
+      }
+    };
+
+
+
+    /**
+     * Compute the sparsity pattern of the product <tt>C = L * R</tt> of two
+     * sparse matrices given by their compressed row storage arrays.
+     */
+    inline
+    void
+    compute_product_pattern (const size_type    n_rows,
+                             const size_type    n_cols,
+                             const std::size_t *left_rowstart,
+                             const size_type   *left_colnums,
+                             const std::size_t *right_rowstart,
+                             const size_type   *right_colnums,
+                             SparsityPattern   &sparsity)
+    {
+      Threads::ThreadLocalStorage<std::vector<size_type> > markers;
+      std::vector<std::vector<size_type> > rows (n_rows);
+
+      ProductPatternOnSubrange worker;
+      worker.left_rowstart = left_rowstart;
+      worker.left_colnums = left_colnums;
+      worker.right_rowstart = right_rowstart;
+      worker.right_colnums = right_colnums;
+      worker.n_cols = n_cols;
+      worker.markers = &markers;
+      worker.rows = &rows;
+      parallel::apply_to_subranges (0U, n_rows, worker,
+                                    internal::SparseMatrix::minimum_parallel_grain_size);
+
+      sparsity.copy_from (n_rows, n_cols, rows.begin(), rows.end());
+    }
+  }
 }
 
 
@@ -1016,39 +1277,11 @@ SparseMatrix<number>::mmult (SparseMatrix<numberC>       &C,
       C.clear();
       sp_C.reinit (0,0,0);
 
-      // create a sparsity pattern for the matrix. we will go through all the
-      // rows in the matrix A, and for each column in a row we add the whole
-      // row of matrix B with that row number. This means that we will insert
-      // a lot of entries to each row, which is best handled by the
-      // DynamicSparsityPattern class.
-      {
-        DynamicSparsityPattern dsp (m(), B.n());
-        for (size_type i = 0; i < dsp.n_rows(); ++i)
-          {
-            const size_type *rows = &sp_A.colnums[sp_A.rowstart[i]];
-            const size_type *const end_rows =
-              &sp_A.colnums[sp_A.rowstart[i+1]];
-            for (; rows != end_rows; ++rows)
-              {
-                const size_type col = *rows;
-                size_type *new_cols = const_cast<size_type *>
-                                      (&sp_B.colnums[sp_B.rowstart[col]]);
-                size_type *end_new_cols = const_cast<size_type *>
-                                          (&sp_B.colnums[sp_B.rowstart[col+1]]);
-
-                // if B has a diagonal, need to add that manually. this way,
-                // we maintain sortedness.
-                if (sp_B.n_rows() == sp_B.n_cols())
-                  {
-                    ++new_cols;
-                    dsp.add(i, col);
-                  }
-
-                dsp.add_entries (i, new_cols, end_new_cols, true);
-              }
-          }
-        sp_C.copy_from (dsp);
-      }
+      // symbolic phase: row i of C contains the union of the rows of B whose
+      // index is a column of row i of A
+      internal::SparseMatrix::compute_product_pattern
+      (m(), B.n(), sp_A.rowstart, sp_A.colnums,
+       sp_B.rowstart, sp_B.colnums, sp_C);
 
       // reinit matrix C from that information
       C.reinit (sp_C);
@@ -1057,52 +1290,23 @@ SparseMatrix<number>::mmult (SparseMatrix<numberC>       &C,
   Assert (C.m() == m(), ExcDimensionMismatch(C.m(), m()));
   Assert (C.n() == B.n(), ExcDimensionMismatch(C.n(), B.n()));
 
-  // create an array that caches some
-  // elements that are going to be written
-  // into the new matrix.
-  unsigned int max_n_cols_B = 0;
-  for (size_type i=0; i<B.m(); ++i)
-    max_n_cols_B = std::max (max_n_cols_B, sp_B.row_length(i));
-  std::vector<numberC> new_entries(max_n_cols_B);
-
-  // now compute the actual entries: a matrix-matrix product involves three
-  // nested loops. One over the rows of A, for each row we then loop over all
-  // the columns, and then we need to multiply each element with all the
-  // elements in that row in B.
-  for (size_type i=0; i<C.m(); ++i)
-    {
-      const size_type *rows = &sp_A.colnums[sp_A.rowstart[i]];
-      const size_type *const end_rows = &sp_A.colnums[sp_A.rowstart[i+1]];
-      for (; rows != end_rows; ++rows)
-        {
-          const number A_val = val[rows-&sp_A.colnums[sp_A.rowstart[0]]];
-          const size_type col = *rows;
-          const size_type *new_cols =
-            (&sp_B.colnums[sp_B.rowstart[col]]);
-
-          // special treatment for diagonal
-          if (sp_B.n_rows() == sp_B.n_cols())
-            {
-              C.add (i, *new_cols,
-                     numberC(A_val) * numberC(B.val[new_cols-&sp_B.colnums[sp_B.rowstart[0]]]) *
-                     numberC(use_vector ? V(col) : 1));
-              ++new_cols;
-            }
-
-          // now the innermost loop that goes over all the elements in row
-          // 'col' of matrix B. Cache the elements, and then write them into C
-          // at once
-          numberC *new_ptr = &new_entries[0];
-          const numberB *B_val_ptr =
-            &B.val[new_cols-&sp_B.colnums[sp_B.rowstart[0]]];
-          const numberB *const end_cols = &B.val[sp_B.rowstart[col+1]];
-          for (; B_val_ptr != end_cols; ++B_val_ptr)
-            *new_ptr++ = numberC(A_val) * numberC(*B_val_ptr) * numberC(use_vector ? V(col) : 1);
-
-          C.add (i, new_ptr-&new_entries[0], new_cols, &new_entries[0],
-                 false, true);
-        }
-    }
+  // numeric phase: compute the entries of C row by row in parallel
+  Threads::ThreadLocalStorage<std::vector<size_type> > markers;
+  internal::SparseMatrix::ProductValuesOnSubrange<number,numberB,numberC> worker;
+  worker.left_rowstart = sp_A.rowstart;
+  worker.left_colnums = sp_A.colnums;
+  worker.left_values = val;
+  worker.scaling = use_vector ? V.begin() : 0;
+  worker.right_rowstart = sp_B.rowstart;
+  worker.right_colnums = sp_B.colnums;
+  worker.right_values = B.val;
+  worker.rowstart = C.cols->rowstart;
+  worker.colnums = C.cols->colnums;
+  worker.values = C.val;
+  worker.n_cols = C.n();
+  worker.markers = &markers;
+  parallel::apply_to_subranges (0U, C.m(), worker,
+                                internal::SparseMatrix::minimum_parallel_grain_size);
 }
 
 
@@ -1125,6 +1329,27 @@ SparseMatrix<number>::Tmmult (SparseMatrix<numberC>       &C,
   const SparsityPattern &sp_A = *cols;
   const SparsityPattern &sp_B = *B.cols;
 
+  // set up the compressed row storage of the transpose of A, with the
+  // entries of each row in ascending order of the rows of A
+  std::vector<std::size_t> transpose_rowstart (n()+1, 0);
+  std::vector<size_type> transpose_colnums (sp_A.rowstart[m()]);
+  std::vector<number> transpose_values (sp_A.rowstart[m()]);
+  for (std::size_t j=0; j<sp_A.rowstart[m()]; ++j)
+    ++transpose_rowstart[sp_A.colnums[j]+1];
+  for (size_type i=0; i<n(); ++i)
+    transpose_rowstart[i+1] += transpose_rowstart[i];
+  {
+    std::vector<std::size_t> next_free (transpose_rowstart.begin(),
+                                        transpose_rowstart.end()-1);
+    for (size_type i=0; i<m(); ++i)
+      for (std::size_t j=sp_A.rowstart[i]; j<sp_A.rowstart[i+1]; ++j)
+        {
+          const std::size_t p = next_free[sp_A.colnums[j]]++;
+          transpose_colnums[p] = i;
+          transpose_values[p] = val[j];
+        }
+  }
+
   // clear previous content of C
   if  (rebuild_sparsity_C == true)
     {
@@ -1143,42 +1368,11 @@ SparseMatrix<number>::Tmmult (SparseMatrix<numberC>       &C,
       C.clear();
       sp_C.reinit (0,0,0);
 
-      // create a sparsity pattern for the matrix. we will go through all the
-      // rows in the matrix A, and for each column in a row we add the whole
-      // row of matrix B with that row number. This means that we will insert
-      // a lot of entries to each row, which is best handled by the
-      // DynamicSparsityPattern class.
-      {
-        DynamicSparsityPattern dsp (n(), B.n());
-        for (size_type i = 0; i < sp_A.n_rows(); ++i)
-          {
-            const size_type *rows =
-              &sp_A.colnums[sp_A.rowstart[i]];
-            const size_type *const end_rows =
-              &sp_A.colnums[sp_A.rowstart[i+1]];
-            // cast away constness to conform with dsp.add_entries interface
-            size_type *new_cols = const_cast<size_type *>
-                                  (&sp_B.colnums[sp_B.rowstart[i]]);
-            size_type *end_new_cols = const_cast<size_type *>
-                                      (&sp_B.colnums[sp_B.rowstart[i+1]]);
-
-            if (sp_B.n_rows() == sp_B.n_cols())
-              ++new_cols;
-
-            for (; rows != end_rows; ++rows)
-              {
-                const size_type row = *rows;
-
-                // if B has a diagonal, need to add that manually. this way,
-                // we maintain sortedness.
-                if (sp_B.n_rows() == sp_B.n_cols())
-                  dsp.add(row, i);
-
-                dsp.add_entries (row, new_cols, end_new_cols, true);
-              }
-          }
-        sp_C.copy_from (dsp);
-      }
+      // symbolic phase: row i of C contains the union of the rows of B whose
+      // index is a row of A with an entry in column i
+      internal::SparseMatrix::compute_product_pattern
+      (n(), B.n(), &transpose_rowstart[0], &transpose_colnums[0],
+       sp_B.rowstart, sp_B.colnums, sp_C);
 
       // reinit matrix C from that information
       C.reinit (sp_C);
@@ -1187,52 +1381,23 @@ SparseMatrix<number>::Tmmult (SparseMatrix<numberC>       &C,
   Assert (C.m() == n(), ExcDimensionMismatch(C.m(), n()));
   Assert (C.n() == B.n(), ExcDimensionMismatch(C.n(), B.n()));
 
-  // create an array that caches some
-  // elements that are going to be written
-  // into the new matrix.
-  unsigned int max_n_cols_B = 0;
-  for (size_type i=0; i<B.m(); ++i)
-    max_n_cols_B = std::max (max_n_cols_B, sp_B.row_length(i));
-  std::vector<numberC> new_entries(max_n_cols_B);
-
-  // now compute the actual entries: a matrix-matrix product involves three
-  // nested loops. One over the rows of A, for each row we then loop over all
-  // the columns, and then we need to multiply each element with all the
-  // elements in that row in B.
-  for (size_type i=0; i<m(); ++i)
-    {
-      const size_type *rows = &sp_A.colnums[sp_A.rowstart[i]];
-      const size_type *const end_rows = &sp_A.colnums[sp_A.rowstart[i+1]];
-      const size_type *new_cols = &sp_B.colnums[sp_B.rowstart[i]];
-      if (sp_B.n_rows() == sp_B.n_cols())
-        ++new_cols;
-
-      const numberB *const end_cols = &B.val[sp_B.rowstart[i+1]];
-
-      for (; rows != end_rows; ++rows)
-        {
-          const size_type row = *rows;
-          const number A_val = val[rows-&sp_A.colnums[sp_A.rowstart[0]]];
-
-          // special treatment for diagonal
-          if (sp_B.n_rows () == sp_B.n_cols())
-            C.add (row, i,
-                   numberC(A_val) * numberC(B.val[new_cols-1-&sp_B.colnums[sp_B.rowstart[0]]]) *
-                   numberC(use_vector ? V(i) : 1));
-
-          // now the innermost loop that goes over all the elements in row
-          // 'col' of matrix B. Cache the elements, and then write them into C
-          // at once
-          numberC *new_ptr = &new_entries[0];
-          const numberB *B_val_ptr =
-            &B.val[new_cols-&sp_B.colnums[sp_B.rowstart[0]]];
-          for (; B_val_ptr != end_cols; ++B_val_ptr)
-            *new_ptr++ = numberC(A_val) * numberC(*B_val_ptr) * numberC(use_vector ? V(i) : 1);
-
-          C.add (row, new_ptr-&new_entries[0], new_cols, &new_entries[0],
-                 false, true);
-        }
-    }
+  // numeric phase: compute the entries of C row by row in parallel
+  Threads::ThreadLocalStorage<std::vector<size_type> > markers;
+  internal::SparseMatrix::ProductValuesOnSubrange<number,numberB,numberC> worker;
+  worker.left_rowstart = &transpose_rowstart[0];
+  worker.left_colnums = &transpose_colnums[0];
+  worker.left_values = &transpose_values[0];
+  worker.scaling = use_vector ? V.begin() : 0;
+  worker.right_rowstart = sp_B.rowstart;
+  worker.right_colnums = sp_B.colnums;
+  worker.right_values = B.val;
+  worker.rowstart = C.cols->rowstart;
+  worker.colnums = C.cols->colnums;
+  worker.values = C.val;
+  worker.n_cols = C.n();
+  worker.markers = &markers;
+  parallel::apply_to_subranges (0U, C.m(), worker,
+                                internal::SparseMatrix::minimum_parallel_grain_size);
 }
 
 
@@ -1364,7 +1529,8 @@ SparseMatrix<number>::residual (Vector<somenumber>       &dst,
                                  std_cxx11::cref(b),
                                  std_cxx11::ref(dst)),
                 0, m(),
-                internal::SparseMatrix::minimum_parallel_grain_size));
+                internal::SparseMatrix::minimum_parallel_grain_size,
+                *thread_loop_partitioner));
 }
 
 
@@ -1599,6 +1765,212 @@ SparseMatrix<number>::precondition_TSOR (Vector<somenumber> &dst,
 }
 
 
+
+namespace internal
+{
+  namespace SparseMatrix
+  {
+    /**
+     * Perform the forward sweep (if the template argument @p forward is true)
+     * or the backward sweep of the SSOR preconditioner on the rows given by
+     * the range of row indices, which are part of a level of the
+     * SparseLevelSchedule. The backward sweep includes the scaling by the
+     * diagonal between the two sweeps. The operations on each row are the
+     * same as in SparseMatrix::precondition_SSOR() with the positions right
+     * of the diagonal given.
+     */
+    template <bool forward,
+              typename number,
+              typename somenumber>
+    void
+    ssor_sweep_on_rows (const size_type                  *begin_row,
+                        const size_type                  *end_row,
+                        const number                     *values,
+                        const std::size_t                *rowstart,
+                        const size_type                  *colnums,
+                        const SparseLevelSchedule        &schedule,
+                        const number                      om,
+                        const dealii::Vector<somenumber> &src,
+                        dealii::Vector<somenumber>       &dst)
+    {
+      const bool level_scheduled =
+        schedule.get_mode() == SparseLevelSchedule::level_scheduled;
+      for (const size_type *row_ptr=begin_row; row_ptr!=end_row; ++row_ptr)
+        {
+          const size_type row = *row_ptr;
+          number s = 0;
+          if (level_scheduled)
+            {
+              const std::size_t first_right_of_diagonal_index =
+                rowstart[row] + schedule.first_upper_index(row);
+              const std::size_t begin = forward ? rowstart[row]+1 :
+                                        first_right_of_diagonal_index;
+              const std::size_t end = forward ? first_right_of_diagonal_index :
+                                      rowstart[row+1];
+              for (std::size_t j=begin; j<end; ++j)
+                s += values[j] * number(dst(colnums[j]));
+            }
+          else
+            for (std::size_t j=rowstart[row]+1; j<rowstart[row+1]; ++j)
+              if (schedule.is_lower(row, colnums[j]) == forward)
+                s += values[j] * number(dst(colnums[j]));
+
+          somenumber &dst_row = dst(row);
+          if (forward)
+            dst_row = src(row);
+          else
+            dst_row *= somenumber(om*(number(2.)-om)) * somenumber(values[rowstart[row]]);
+          dst_row -= s * om;
+          dst_row /= values[rowstart[row]];
+        }
+    }
+
+
+
+    /**
+     * Perform the forward sweep of SOR (if the template argument @p forward
+     * is true) or the backward sweep of transpose SOR in-place on the rows
+     * given by the range of row indices, which are part of a level of the
+     * SparseLevelSchedule. The operations on each row are the same as in
+     * SparseMatrix::SOR() and SparseMatrix::TSOR().
+     */
+    template <bool forward,
+              typename number,
+              typename somenumber>
+    void
+    sor_sweep_on_rows (const size_type            *begin_row,
+                       const size_type            *end_row,
+                       const number               *values,
+                       const std::size_t          *rowstart,
+                       const size_type            *colnums,
+                       const SparseLevelSchedule  &schedule,
+                       const number                om,
+                       dealii::Vector<somenumber> &dst)
+    {
+      const bool level_scheduled =
+        schedule.get_mode() == SparseLevelSchedule::level_scheduled;
+      for (const size_type *row_ptr=begin_row; row_ptr!=end_row; ++row_ptr)
+        {
+          const size_type row = *row_ptr;
+          somenumber s = dst(row);
+          if (level_scheduled)
+            {
+              const std::size_t first_right_of_diagonal_index =
+                rowstart[row] + schedule.first_upper_index(row);
+              const std::size_t begin = forward ? rowstart[row]+1 :
+                                        first_right_of_diagonal_index;
+              const std::size_t end = forward ? first_right_of_diagonal_index :
+                                      rowstart[row+1];
+              for (std::size_t j=begin; j<end; ++j)
+                s -= somenumber(values[j]) * dst(colnums[j]);
+            }
+          else
+            for (std::size_t j=rowstart[row]+1; j<rowstart[row+1]; ++j)
+              if (schedule.is_lower(row, colnums[j]) == forward)
+                s -= somenumber(values[j]) * dst(colnums[j]);
+
+          dst(row) = s * somenumber(om) / somenumber(values[rowstart[row]]);
+        }
+    }
+  }
+}
+
+
+
+template <typename number>
+template <typename somenumber>
+void
+SparseMatrix<number>::precondition_SSOR (Vector<somenumber>        &dst,
+                                         const dealii::Vector<somenumber> &src,
+                                         const number               om,
+                                         const SparseLevelSchedule &schedule) const
+{
+  Assert (cols != 0, ExcNotInitialized());
+  Assert (val != 0, ExcNotInitialized());
+  AssertDimension (m(), n());
+  AssertDimension (dst.size(), n());
+  AssertDimension (src.size(), n());
+  Assert (schedule.n_rows() == m() &&
+          schedule.n_nonzero_elements() == cols->n_nonzero_elements(),
+          SparseLevelSchedule::ExcScheduleMismatch());
+
+  AssertNoZerosOnDiagonal(*this);
+
+  schedule.apply_forward (std_cxx11::bind (&internal::SparseMatrix::ssor_sweep_on_rows
+                                           <true,number,somenumber>,
+                                           std_cxx11::_1, std_cxx11::_2,
+                                           val, cols->rowstart, cols->colnums,
+                                           std_cxx11::cref(schedule), om,
+                                           std_cxx11::cref(src),
+                                           std_cxx11::ref(dst)));
+  schedule.apply_backward (std_cxx11::bind (&internal::SparseMatrix::ssor_sweep_on_rows
+                                            <false,number,somenumber>,
+                                            std_cxx11::_1, std_cxx11::_2,
+                                            val, cols->rowstart, cols->colnums,
+                                            std_cxx11::cref(schedule), om,
+                                            std_cxx11::cref(src),
+                                            std_cxx11::ref(dst)));
+}
+
+
+
+template <typename number>
+template <typename somenumber>
+void
+SparseMatrix<number>::precondition_SOR (Vector<somenumber>        &dst,
+                                        const Vector<somenumber>  &src,
+                                        const number               om,
+                                        const SparseLevelSchedule &schedule) const
+{
+  Assert (cols != 0, ExcNotInitialized());
+  Assert (val != 0, ExcNotInitialized());
+  AssertDimension (m(), n());
+  AssertDimension (dst.size(), n());
+  Assert (schedule.n_rows() == m() &&
+          schedule.n_nonzero_elements() == cols->n_nonzero_elements(),
+          SparseLevelSchedule::ExcScheduleMismatch());
+
+  AssertNoZerosOnDiagonal(*this);
+
+  dst = src;
+  schedule.apply_forward (std_cxx11::bind (&internal::SparseMatrix::sor_sweep_on_rows
+                                           <true,number,somenumber>,
+                                           std_cxx11::_1, std_cxx11::_2,
+                                           val, cols->rowstart, cols->colnums,
+                                           std_cxx11::cref(schedule), om,
+                                           std_cxx11::ref(dst)));
+}
+
+
+
+template <typename number>
+template <typename somenumber>
+void
+SparseMatrix<number>::precondition_TSOR (Vector<somenumber>        &dst,
+                                         const Vector<somenumber>  &src,
+                                         const number               om,
+                                         const SparseLevelSchedule &schedule) const
+{
+  Assert (cols != 0, ExcNotInitialized());
+  Assert (val != 0, ExcNotInitialized());
+  AssertDimension (m(), n());
+  AssertDimension (dst.size(), n());
+  Assert (schedule.n_rows() == m() &&
+          schedule.n_nonzero_elements() == cols->n_nonzero_elements(),
+          SparseLevelSchedule::ExcScheduleMismatch());
+
+  AssertNoZerosOnDiagonal(*this);
+
+  dst = src;
+  schedule.apply_backward (std_cxx11::bind (&internal::SparseMatrix::sor_sweep_on_rows
+                                            <false,number,somenumber>,
+                                            std_cxx11::_1, std_cxx11::_2,
+                                            val, cols->rowstart, cols->colnums,
+                                            std_cxx11::cref(schedule), om,
+                                            std_cxx11::ref(dst)));
+}
+
+
 template <typename number>
 template <typename somenumber>
 void
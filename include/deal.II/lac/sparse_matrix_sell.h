@@ -0,0 +1,454 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+#ifndef dealii__sparse_matrix_sell_h
+#define dealii__sparse_matrix_sell_h
+
+
+#include <deal.II/base/config.h>
+#include <deal.II/base/subscriptor.h>
+#include <deal.II/base/aligned_vector.h>
+#include <deal.II/base/parallel.h>
+#include <deal.II/base/std_cxx11/shared_ptr.h>
+#include <deal.II/base/vectorization.h>
+#include <deal.II/lac/exceptions.h>
+
+#include <vector>
+
+DEAL_II_NAMESPACE_OPEN
+
+template <typename number> class Vector;
+template <typename number> class SparseMatrix;
+class SparsityPattern;
+
+/**
+ * @addtogroup Matrix1
+ * @{
+ */
+
+/**
+ * A sparse matrix stored in the sliced ELLPACK format with sorting of the
+ * rows, also known as SELL-C-$\sigma$ format, for fast matrix-vector
+ * products with SIMD instructions.
+ *
+ * The rows of the matrix are grouped into chunks of
+ * $C$=VectorizedArray<number>::n_array_elements rows. The entries of a chunk
+ * are stored column by column, i.e., the $j$-th entries of the $C$ rows of a
+ * chunk are adjacent in memory, such that the matrix-vector product can work
+ * on the $C$ rows of a chunk with one VectorizedArray<number> operation per
+ * column of the chunk. Each chunk is as long as its longest row, and the
+ * shorter rows are padded by zero entries. In order to keep the padding
+ * small, the rows are sorted by decreasing length within windows of
+ * $\sigma$ consecutive rows before they are grouped into chunks. A window
+ * size $\sigma$ of the order of a few hundred rows keeps the accesses into
+ * the source and destination vectors local while removing most of the
+ * padding for matrices with rows of varying length, such as matrices on
+ * adaptively refined meshes or with constraints. For $\sigma$ equal to $C$,
+ * the rows are not sorted but the chunks adapt to the local row length.
+ *
+ * The matrix is set up from a SparsityPattern or a SparseMatrix with the
+ * same entries, and the values can be changed by set(), add() and
+ * copy_from(). The matrix provides the functions vmult(), Tvmult(),
+ * vmult_add(), Tvmult_add(), precondition_Jacobi(), m(), n() and el(), which
+ * are the interface the linear solvers like SolverCG and preconditioners
+ * like PreconditionJacobi or PreconditionChebyshev expect from a matrix. The
+ * matrix-vector product is parallelized with threads by
+ * parallel::apply_to_subranges like the one of SparseMatrix, and the
+ * entries are first touched with the same partitioning of the chunks onto
+ * threads in reinit().
+ *
+ * Compared to SparseMatrix, this format stores the entries together with
+ * the padding, i.e., n_stored_elements() rather than n_nonzero_elements()
+ * entries, and the element access via el() and set() is slower because the
+ * rows are not stored in their natural order. Thus, the class is intended
+ * for matrices that are assembled once (e.g. with a SparseMatrix) and then
+ * applied many times in an iterative solver or smoother.
+ *
+ * @note Instantiations for this template are provided for <tt>@<float@> and
+ * @<double@></tt>.
+ */
+template <typename number>
+class SparseMatrixSELL : public virtual Subscriptor
+{
+public:
+  /**
+   * Declare type for container size.
+   */
+  typedef types::global_dof_index size_type;
+
+  /**
+   * Type of the matrix entries.
+   */
+  typedef number value_type;
+
+  /**
+   * Number of rows in a chunk, i.e., the number of rows worked on with one
+   * SIMD instruction.
+   */
+  static const unsigned int chunk_size = VectorizedArray<number>::n_array_elements;
+
+  /**
+   * Constructor. Initialize an empty matrix.
+   */
+  SparseMatrixSELL ();
+
+  /**
+   * Constructor. Set up the storage for the entries of the given sparsity
+   * pattern and set all entries to zero. See reinit() for the meaning of
+   * @p sigma.
+   */
+  explicit SparseMatrixSELL (const SparsityPattern &sparsity,
+                             const unsigned int     sigma = 256);
+
+  /**
+   * Constructor. Set up the storage for the sparsity pattern of the given
+   * matrix and copy its entries.
+   */
+  template <typename number2>
+  explicit SparseMatrixSELL (const SparseMatrix<number2> &matrix,
+                             const unsigned int           sigma = 256);
+
+  /**
+   * Set up the storage for the entries of the given sparsity pattern and set
+   * all entries to zero. The rows are sorted by decreasing length within
+   * windows of @p sigma rows, which is rounded up to a multiple of
+   * chunk_size. The sparsity pattern is not referenced after this call.
+   */
+  void reinit (const SparsityPattern &sparsity,
+               const unsigned int     sigma = 256);
+
+  /**
+   * Set up the storage for the sparsity pattern of the given matrix and copy
+   * its entries.
+   */
+  template <typename number2>
+  void reinit (const SparseMatrix<number2> &matrix,
+               const unsigned int           sigma = 256);
+
+  /**
+   * Copy the entries of the given matrix into this object. The matrix must
+   * be based on the sparsity pattern this object was set up with.
+   */
+  template <typename number2>
+  SparseMatrixSELL<number> &
+  copy_from (const SparseMatrix<number2> &matrix);
+
+  /**
+   * Release all memory and return to a state just like after having called
+   * the default constructor.
+   */
+  void clear ();
+
+  /**
+   * Return the number of rows of the matrix.
+   */
+  size_type m () const;
+
+  /**
+   * Return the number of columns of the matrix.
+   */
+  size_type n () const;
+
+  /**
+   * Return the number of entries of the sparsity pattern the matrix was set
+   * up with.
+   */
+  std::size_t n_nonzero_elements () const;
+
+  /**
+   * Return the number of stored entries including the padding of the
+   * chunks.
+   */
+  std::size_t n_stored_elements () const;
+
+  /**
+   * Set the element (<i>i,j</i>) to @p value. Throws an error if the entry
+   * does not exist in the sparsity pattern.
+   */
+  void set (const size_type i,
+            const size_type j,
+            const number    value);
+
+  /**
+   * Add @p value to the element (<i>i,j</i>). Throws an error if the entry
+   * does not exist in the sparsity pattern.
+   */
+  void add (const size_type i,
+            const size_type j,
+            const number    value);
+
+  /**
+   * Multiply the entire matrix by a fixed factor.
+   */
+  SparseMatrixSELL<number> &operator *= (const number factor);
+
+  /**
+   * Return the value of the entry (<i>i,j</i>), or zero if the entry does
+   * not exist in the sparsity pattern. This function walks through the
+   * stored entries of row <i>i</i> and is therefore slow.
+   */
+  number el (const size_type i,
+             const size_type j) const;
+
+  /**
+   * Return the main diagonal element in the <i>i</i>th row.
+   */
+  number diag_element (const size_type i) const;
+
+  /**
+   * Matrix-vector multiplication: let <i>dst = M*src</i> with <i>M</i>
+   * being this matrix.
+   *
+   * The product of each chunk of rows runs on VectorizedArray<number> and
+   * reads the entries of the source vector with a gather operation, which
+   * makes use of the gather instructions of AVX-512 for vectors with entries
+   * of the same type as the matrix.
+   */
+  template <class OutVector, class InVector>
+  void vmult (OutVector      &dst,
+              const InVector &src) const;
+
+  /**
+   * Matrix-vector multiplication: let <i>dst = M<sup>T</sup>*src</i> with
+   * <i>M</i> being this matrix. This function does the same as vmult() but
+   * takes the transposed matrix.
+   */
+  template <class OutVector, class InVector>
+  void Tvmult (OutVector      &dst,
+               const InVector &src) const;
+
+  /**
+   * Adding matrix-vector multiplication. Add <i>M*src</i> on <i>dst</i>
+   * with <i>M</i> being this matrix.
+   */
+  template <class OutVector, class InVector>
+  void vmult_add (OutVector      &dst,
+                  const InVector &src) const;
+
+  /**
+   * Adding matrix-vector multiplication. Add <i>M<sup>T</sup>*src</i> to
+   * <i>dst</i> with <i>M</i> being this matrix.
+   */
+  template <class OutVector, class InVector>
+  void Tvmult_add (OutVector      &dst,
+                   const InVector &src) const;
+
+  /**
+   * Apply the Jacobi preconditioner, which multiplies every element of the
+   * <tt>src</tt> vector by the inverse of the respective diagonal element
+   * and multiplies the result with the relaxation factor <tt>omega</tt>.
+   */
+  template <typename somenumber>
+  void precondition_Jacobi (Vector<somenumber>       &dst,
+                            const Vector<somenumber> &src,
+                            const number              omega = 1.) const;
+
+  /**
+   * Return the row of the original matrix that is stored in position
+   * <tt>i</tt> of the sorted rows.
+   */
+  size_type get_row_of_sorted_index (const size_type i) const;
+
+  /**
+   * Determine an estimate for the memory consumption (in bytes) of this
+   * object.
+   */
+  std::size_t memory_consumption () const;
+
+  /**
+   * @addtogroup Exceptions
+   * @{
+   */
+
+  /**
+   * Exception
+   */
+  DeclException2 (ExcInvalidIndex,
+                  int, int,
+                  << "You are trying to access the matrix entry with index <"
+                  << arg1 << ',' << arg2
+                  << ">, but this entry does not exist in the sparsity pattern "
+                  "of this matrix.");
+
+  /**
+   * Exception
+   */
+  DeclExceptionMsg (ExcDifferentSparsityPatterns,
+                    "When copying a sparse matrix into a SparseMatrixSELL, "
+                    "the matrix must be based on the same sparsity pattern "
+                    "the SparseMatrixSELL object was set up with.");
+
+  /**
+   * Exception
+   */
+  DeclException0 (ExcSourceEqualsDestination);
+  //@}
+
+private:
+  /**
+   * Return the position of entry (<i>i,j</i>) in the arrays #values and
+   * #column_indices, or numbers::invalid_size_type if the entry is not
+   * stored.
+   */
+  std::size_t get_entry_index (const size_type i,
+                               const size_type j) const;
+
+  /**
+   * Number of rows of the matrix.
+   */
+  size_type n_rows;
+
+  /**
+   * Number of columns of the matrix.
+   */
+  size_type n_cols;
+
+  /**
+   * Number of entries of the sparsity pattern, not counting the padding.
+   */
+  std::size_t n_nonzero;
+
+  /**
+   * The row of the original matrix stored in each position of the sorted
+   * rows. The array is filled up to a multiple of chunk_size by
+   * numbers::invalid_dof_index for the unused rows of the last chunk.
+   */
+  std::vector<size_type> row_of_sorted_index;
+
+  /**
+   * The position within the sorted rows for each row of the original
+   * matrix, i.e., the inverse of #row_of_sorted_index.
+   */
+  std::vector<size_type> sorted_index_of_row;
+
+  /**
+   * The number of entries (without padding) of the rows in the sorted
+   * order.
+   */
+  std::vector<unsigned int> row_lengths;
+
+  /**
+   * The start of each chunk in #values, i.e., the index of the first column
+   * of the chunk. The column <tt>j</tt> of chunk <tt>c</tt> is stored in
+   * <tt>values[chunk_starts[c]+j]</tt>, where the lanes of the vectorized
+   * array hold the rows of the chunk.
+   */
+  std::vector<std::size_t> chunk_starts;
+
+  /**
+   * The entries of the matrix, grouped into columns of the chunks.
+   */
+  AlignedVector<VectorizedArray<number> > values;
+
+  /**
+   * The column indices of the entries in #values, with chunk_size indices
+   * per entry of #values. Padded entries repeat the last valid column of the
+   * row such that they touch no additional cache lines in the source vector.
+   */
+  AlignedVector<unsigned int> column_indices;
+
+  /**
+   * The position of the diagonal entry of each row in the sorted order in
+   * the array #column_indices, or numbers::invalid_size_type if the row has
+   * no diagonal entry.
+   */
+  std::vector<std::size_t> diagonal_indices;
+
+  /**
+   * For parallel loops with TBB, this member variable stores the affinity
+   * information of the loops over the chunks. The same partitioner is used
+   * for the first touch of #values and #column_indices in reinit() and for
+   * the matrix-vector products, such that on NUMA systems, the chunks are
+   * placed close to the threads that work on them later.
+   */
+  std_cxx11::shared_ptr<parallel::internal::TBBPartitioner> thread_loop_partitioner;
+};
+
+/**
+ * @}
+ */
+
+#ifndef DOXYGEN
+/*---------------------- Inline functions -----------------------------------*/
+
+
+
+template <typename number>
+inline
+typename SparseMatrixSELL<number>::size_type
+SparseMatrixSELL<number>::m () const
+{
+  return n_rows;
+}
+
+
+
+template <typename number>
+inline
+typename SparseMatrixSELL<number>::size_type
+SparseMatrixSELL<number>::n () const
+{
+  return n_cols;
+}
+
+
+
+template <typename number>
+inline
+std::size_t
+SparseMatrixSELL<number>::n_nonzero_elements () const
+{
+  return n_nonzero;
+}
+
+
+
+template <typename number>
+inline
+std::size_t
+SparseMatrixSELL<number>::n_stored_elements () const
+{
+  return values.size() * chunk_size;
+}
+
+
+
+template <typename number>
+inline
+typename SparseMatrixSELL<number>::size_type
+SparseMatrixSELL<number>::get_row_of_sorted_index (const size_type i) const
+{
+  AssertIndexRange (i, n_rows);
+  return row_of_sorted_index[i];
+}
+
+
+
+template <typename number>
+inline
+number
+SparseMatrixSELL<number>::diag_element (const size_type i) const
+{
+  AssertIndexRange (i, n_rows);
+  const std::size_t index = diagonal_indices[sorted_index_of_row[i]];
+  Assert (index != numbers::invalid_size_type, ExcInvalidIndex(i,i));
+  return values[index/chunk_size][index%chunk_size];
+}
+
+#endif // DOXYGEN
+
+DEAL_II_NAMESPACE_CLOSE
+
+#endif
@@ -0,0 +1,582 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+#ifndef dealii__sparse_matrix_sell_templates_h
+#define dealii__sparse_matrix_sell_templates_h
+
+
+#include <deal.II/base/memory_consumption.h>
+#include <deal.II/base/parallel.h>
+#include <deal.II/base/template_constraints.h>
+#include <deal.II/lac/sparse_matrix_sell.h>
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/sparsity_pattern.h>
+#include <deal.II/lac/vector.h>
+
+#include <algorithm>
+#include <cstring>
+
+DEAL_II_NAMESPACE_OPEN
+
+
+namespace internal
+{
+  namespace SparseMatrixSELLImplementation
+  {
+    typedef types::global_dof_index size_type;
+
+    /**
+     * Comparator sorting rows by decreasing length. Rows of the same length
+     * keep their order when used with std::stable_sort.
+     */
+    struct RowLengthComparator
+    {
+      RowLengthComparator (const SparsityPattern &sparsity)
+        :
+        sparsity (sparsity)
+      {}
+
+      bool operator () (const size_type row1,
+                        const size_type row2) const
+      {
+        return sparsity.row_length(row1) > sparsity.row_length(row2);
+      }
+
+      const SparsityPattern &sparsity;
+    };
+
+    /**
+     * Read the entries of the source vector at the given column indices
+     * into a vectorized array.
+     */
+    template <typename number, typename InVector>
+    inline
+    void
+    gather_entries (const InVector          &src,
+                    const unsigned int      *indices,
+                    VectorizedArray<number> &result)
+    {
+      for (unsigned int v=0; v<VectorizedArray<number>::n_array_elements; ++v)
+        result[v] = src(indices[v]);
+    }
+
+    /**
+     * Specialization for a vector holding entries of the same type as the
+     * matrix, which uses the gather operation of VectorizedArray.
+     */
+    template <typename number>
+    inline
+    void
+    gather_entries (const dealii::Vector<number> &src,
+                    const unsigned int           *indices,
+                    VectorizedArray<number>      &result)
+    {
+      result.gather (src.begin(), indices);
+    }
+
+    /**
+     * Perform a vmult on the chunks in the half-open range [begin_chunk,
+     * end_chunk). The rows of different chunks are distinct, so several
+     * ranges can run in parallel.
+     */
+    template <typename number,
+              typename InVector,
+              typename OutVector>
+    void vmult_on_subrange (const size_type                begin_chunk,
+                            const size_type                end_chunk,
+                            const VectorizedArray<number> *values,
+                            const std::size_t             *chunk_starts,
+                            const unsigned int            *column_indices,
+                            const size_type               *row_of_sorted_index,
+                            const InVector                &src,
+                            OutVector                     &dst,
+                            const bool                     add)
+    {
+      const unsigned int chunk_size = VectorizedArray<number>::n_array_elements;
+      for (size_type chunk=begin_chunk; chunk<end_chunk; ++chunk)
+        {
+          VectorizedArray<number> sum = VectorizedArray<number>();
+          for (std::size_t k=chunk_starts[chunk]; k<chunk_starts[chunk+1]; ++k)
+            {
+              VectorizedArray<number> src_entries;
+              gather_entries (src, column_indices+k*chunk_size, src_entries);
+              sum += values[k] * src_entries;
+            }
+
+          for (unsigned int v=0; v<chunk_size; ++v)
+            {
+              const size_type row = row_of_sorted_index[chunk*chunk_size+v];
+              if (row == numbers::invalid_dof_index)
+                break;
+              if (add)
+                dst(row) += typename OutVector::value_type(sum[v]);
+              else
+                dst(row) = typename OutVector::value_type(sum[v]);
+            }
+        }
+    }
+  }
+}
+
+
+
+namespace internal
+{
+  namespace SparseMatrixSELLImplementation
+  {
+    /**
+     * Set the entries and the column indices of the chunks
+     * <tt>[begin_chunk,end_chunk)</tt> to zero.
+     */
+    template <typename number>
+    void
+    zero_chunks_on_subrange (const size_type          begin_chunk,
+                             const size_type          end_chunk,
+                             const std::size_t       *chunk_starts,
+                             VectorizedArray<number> *values,
+                             unsigned int            *column_indices)
+    {
+      const std::size_t begin = chunk_starts[begin_chunk];
+      const std::size_t end = chunk_starts[end_chunk];
+      for (std::size_t k=begin; k<end; ++k)
+        values[k] = number();
+      std::memset (column_indices+begin*VectorizedArray<number>::n_array_elements, 0,
+                   (end-begin)*VectorizedArray<number>::n_array_elements*sizeof(unsigned int));
+    }
+  }
+}
+
+
+
+template <typename number>
+SparseMatrixSELL<number>::SparseMatrixSELL ()
+  :
+  n_rows (0),
+  n_cols (0),
+  n_nonzero (0),
+  thread_loop_partitioner (new parallel::internal::TBBPartitioner())
+{}
+
+
+
+template <typename number>
+SparseMatrixSELL<number>::SparseMatrixSELL (const SparsityPattern &sparsity,
+                                            const unsigned int     sigma)
+  :
+  n_rows (0),
+  n_cols (0),
+  n_nonzero (0),
+  thread_loop_partitioner (new parallel::internal::TBBPartitioner())
+{
+  reinit (sparsity, sigma);
+}
+
+
+
+template <typename number>
+template <typename number2>
+SparseMatrixSELL<number>::SparseMatrixSELL (const SparseMatrix<number2> &matrix,
+                                            const unsigned int           sigma)
+  :
+  n_rows (0),
+  n_cols (0),
+  n_nonzero (0),
+  thread_loop_partitioner (new parallel::internal::TBBPartitioner())
+{
+  reinit (matrix, sigma);
+}
+
+
+
+template <typename number>
+void
+SparseMatrixSELL<number>::reinit (const SparsityPattern &sparsity,
+                                  const unsigned int     sigma)
+{
+  Assert (sparsity.is_compressed(), SparsityPattern::ExcNotCompressed());
+  Assert (sparsity.n_cols() < static_cast<size_type>(numbers::invalid_unsigned_int),
+          ExcMessage ("The column indices must fit into unsigned int"));
+
+  n_rows = sparsity.n_rows();
+  n_cols = sparsity.n_cols();
+  n_nonzero = sparsity.n_nonzero_elements();
+
+  // sort the rows by decreasing length within windows of sigma rows
+  const size_type window_size =
+    std::max (1U, (sigma+chunk_size-1)/chunk_size) * chunk_size;
+  const size_type n_chunks = (n_rows+chunk_size-1)/chunk_size;
+  row_of_sorted_index.resize (n_chunks*chunk_size);
+  for (size_type i=0; i<n_rows; ++i)
+    row_of_sorted_index[i] = i;
+  for (size_type i=n_rows; i<row_of_sorted_index.size(); ++i)
+    row_of_sorted_index[i] = numbers::invalid_dof_index;
+  if (window_size > chunk_size)
+    for (size_type start=0; start<n_rows; start+=window_size)
+      std::stable_sort (row_of_sorted_index.begin()+start,
+                        row_of_sorted_index.begin()+std::min(start+window_size,
+                                                             n_rows),
+                        internal::SparseMatrixSELLImplementation::RowLengthComparator(sparsity));
+
+  sorted_index_of_row.resize (n_rows);
+  row_lengths.resize (row_of_sorted_index.size());
+  for (size_type i=0; i<row_of_sorted_index.size(); ++i)
+    if (row_of_sorted_index[i] != numbers::invalid_dof_index)
+      {
+        sorted_index_of_row[row_of_sorted_index[i]] = i;
+        row_lengths[i] = sparsity.row_length(row_of_sorted_index[i]);
+      }
+    else
+      row_lengths[i] = 0;
+
+  // each chunk is as long as its longest row
+  chunk_starts.resize (n_chunks+1);
+  chunk_starts[0] = 0;
+  for (size_type chunk=0; chunk<n_chunks; ++chunk)
+    {
+      unsigned int max_length = 0;
+      for (unsigned int v=0; v<chunk_size; ++v)
+        max_length = std::max (max_length, row_lengths[chunk*chunk_size+v]);
+      chunk_starts[chunk+1] = chunk_starts[chunk] + max_length;
+    }
+
+  // zero the entries and the column indices in parallel with the same
+  // partitioning of the chunks as in vmult(). On NUMA systems, the memory
+  // pages are placed close to the thread that first touches them, so the
+  // matrix-vector products then access local memory. resize_fast() does not
+  // touch the memory for the trivial types at hand
+  values.resize_fast (chunk_starts.back());
+  column_indices.resize_fast (chunk_starts.back()*chunk_size);
+  thread_loop_partitioner.reset(new parallel::internal::TBBPartitioner());
+  if (n_chunks > 0)
+    parallel::apply_to_subranges (size_type(0), n_chunks,
+                                  std_cxx11::bind (&internal::SparseMatrixSELLImplementation::zero_chunks_on_subrange
+                                                   <number>,
+                                                   std_cxx11::_1, std_cxx11::_2,
+                                                   &chunk_starts[0],
+                                                   values.begin(),
+                                                   column_indices.begin()),
+                                  internal::SparseMatrix::minimum_parallel_grain_size/chunk_size+1,
+                                  *thread_loop_partitioner);
+
+  // fill the column indices in the same order as in the sparsity pattern
+  // such that the entries can be copied row by row from a SparseMatrix
+  diagonal_indices.resize (row_of_sorted_index.size());
+  for (size_type i=0; i<row_of_sorted_index.size(); ++i)
+    {
+      const size_type row = row_of_sorted_index[i];
+      const size_type chunk = i/chunk_size;
+      const unsigned int lane = i%chunk_size;
+      diagonal_indices[i] = numbers::invalid_size_type;
+      unsigned int last_column = 0;
+      for (std::size_t k=chunk_starts[chunk]; k<chunk_starts[chunk+1]; ++k)
+        {
+          const unsigned int j = k-chunk_starts[chunk];
+          if (j < row_lengths[i])
+            {
+              last_column = sparsity.column_number(row, j);
+              if (last_column == row)
+                diagonal_indices[i] = k*chunk_size+lane;
+            }
+          column_indices[k*chunk_size+lane] = last_column;
+        }
+    }
+}
+
+
+
+template <typename number>
+template <typename number2>
+void
+SparseMatrixSELL<number>::reinit (const SparseMatrix<number2> &matrix,
+                                  const unsigned int           sigma)
+{
+  reinit (matrix.get_sparsity_pattern(), sigma);
+  copy_from (matrix);
+}
+
+
+
+template <typename number>
+template <typename number2>
+SparseMatrixSELL<number> &
+SparseMatrixSELL<number>::copy_from (const SparseMatrix<number2> &matrix)
+{
+  AssertDimension (matrix.m(), m());
+  AssertDimension (matrix.n(), n());
+  Assert (matrix.n_nonzero_elements() == n_nonzero_elements(),
+          ExcDifferentSparsityPatterns());
+
+  for (size_type row=0; row<n_rows; ++row)
+    {
+      const size_type i = sorted_index_of_row[row];
+      const size_type chunk = i/chunk_size;
+      const unsigned int lane = i%chunk_size;
+      std::size_t k = chunk_starts[chunk];
+      for (typename SparseMatrix<number2>::const_iterator
+           entry = matrix.begin(row); entry != matrix.end(row); ++entry, ++k)
+        {
+          Assert (k < chunk_starts[chunk]+row_lengths[i] &&
+                  entry->column() == column_indices[k*chunk_size+lane],
+                  ExcDifferentSparsityPatterns());
+          values[k][lane] = entry->value();
+        }
+    }
+
+  return *this;
+}
+
+
+
+template <typename number>
+void
+SparseMatrixSELL<number>::clear ()
+{
+  n_rows = 0;
+  n_cols = 0;
+  n_nonzero = 0;
+  row_of_sorted_index.clear();
+  sorted_index_of_row.clear();
+  row_lengths.clear();
+  chunk_starts.clear();
+  values.clear();
+  column_indices.clear();
+  diagonal_indices.clear();
+}
+
+
+
+template <typename number>
+std::size_t
+SparseMatrixSELL<number>::get_entry_index (const size_type i,
+                                           const size_type j) const
+{
+  AssertIndexRange (i, n_rows);
+  AssertIndexRange (j, n_cols);
+
+  const size_type sorted_index = sorted_index_of_row[i];
+  const std::size_t chunk_start = chunk_starts[sorted_index/chunk_size];
+  const unsigned int lane = sorted_index%chunk_size;
+  for (unsigned int k=0; k<row_lengths[sorted_index]; ++k)
+    if (column_indices[(chunk_start+k)*chunk_size+lane] == j)
+      return (chunk_start+k)*chunk_size+lane;
+  return numbers::invalid_size_type;
+}
+
+
+
+template <typename number>
+void
+SparseMatrixSELL<number>::set (const size_type i,
+                               const size_type j,
+                               const number    value)
+{
+  const std::size_t index = get_entry_index (i, j);
+  Assert (index != numbers::invalid_size_type || value == number(),
+          ExcInvalidIndex(i, j));
+  if (index != numbers::invalid_size_type)
+    values[index/chunk_size][index%chunk_size] = value;
+}
+
+
+
+template <typename number>
+void
+SparseMatrixSELL<number>::add (const size_type i,
+                               const size_type j,
+                               const number    value)
+{
+  if (value == number())
+    return;
+
+  const std::size_t index = get_entry_index (i, j);
+  Assert (index != numbers::invalid_size_type, ExcInvalidIndex(i, j));
+  if (index != numbers::invalid_size_type)
+    values[index/chunk_size][index%chunk_size] += value;
+}
+
+
+
+template <typename number>
+SparseMatrixSELL<number> &
+SparseMatrixSELL<number>::operator *= (const number factor)
+{
+  const VectorizedArray<number> factor_vectorized =
+    make_vectorized_array (factor);
+  for (std::size_t k=0; k<values.size(); ++k)
+    values[k] *= factor_vectorized;
+  return *this;
+}
+
+
+
+template <typename number>
+number
+SparseMatrixSELL<number>::el (const size_type i,
+                              const size_type j) const
+{
+  const std::size_t index = get_entry_index (i, j);
+  if (index != numbers::invalid_size_type)
+    return values[index/chunk_size][index%chunk_size];
+  else
+    return number();
+}
+
+
+
+template <typename number>
+template <class OutVector, class InVector>
+void
+SparseMatrixSELL<number>::vmult (OutVector      &dst,
+                                 const InVector &src) const
+{
+  Assert (m() == dst.size(), ExcDimensionMismatch(m(),dst.size()));
+  Assert (n() == src.size(), ExcDimensionMismatch(n(),src.size()));
+  Assert (!PointerComparison::equal(&src, &dst), ExcSourceEqualsDestination());
+
+  if (n_rows == 0)
+    return;
+
+  parallel::apply_to_subranges (size_type(0), size_type(chunk_starts.size()-1),
+                                std_cxx11::bind (&internal::SparseMatrixSELLImplementation::vmult_on_subrange
+                                                 <number,InVector,OutVector>,
+                                                 std_cxx11::_1, std_cxx11::_2,
+                                                 values.begin(),
+                                                 &chunk_starts[0],
+                                                 column_indices.empty() ? 0 : &column_indices[0],
+                                                 &row_of_sorted_index[0],
+                                                 std_cxx11::cref(src),
+                                                 std_cxx11::ref(dst),
+                                                 false),
+                                internal::SparseMatrix::minimum_parallel_grain_size/chunk_size+1,
+                                *thread_loop_partitioner);
+}
+
+
+
+template <typename number>
+template <class OutVector, class InVector>
+void
+SparseMatrixSELL<number>::vmult_add (OutVector      &dst,
+                                     const InVector &src) const
+{
+  Assert (m() == dst.size(), ExcDimensionMismatch(m(),dst.size()));
+  Assert (n() == src.size(), ExcDimensionMismatch(n(),src.size()));
+  Assert (!PointerComparison::equal(&src, &dst), ExcSourceEqualsDestination());
+
+  if (n_rows == 0)
+    return;
+
+  parallel::apply_to_subranges (size_type(0), size_type(chunk_starts.size()-1),
+                                std_cxx11::bind (&internal::SparseMatrixSELLImplementation::vmult_on_subrange
+                                                 <number,InVector,OutVector>,
+                                                 std_cxx11::_1, std_cxx11::_2,
+                                                 values.begin(),
+                                                 &chunk_starts[0],
+                                                 column_indices.empty() ? 0 : &column_indices[0],
+                                                 &row_of_sorted_index[0],
+                                                 std_cxx11::cref(src),
+                                                 std_cxx11::ref(dst),
+                                                 true),
+                                internal::SparseMatrix::minimum_parallel_grain_size/chunk_size+1,
+                                *thread_loop_partitioner);
+}
+
+
+
+template <typename number>
+template <class OutVector, class InVector>
+void
+SparseMatrixSELL<number>::Tvmult (OutVector      &dst,
+                                  const InVector &src) const
+{
+  Assert (n() == dst.size(), ExcDimensionMismatch(n(),dst.size()));
+  Assert (m() == src.size(), ExcDimensionMismatch(m(),src.size()));
+  Assert (!PointerComparison::equal(&src, &dst), ExcSourceEqualsDestination());
+
+  dst = 0;
+  Tvmult_add (dst, src);
+}
+
+
+
+template <typename number>
+template <class OutVector, class InVector>
+void
+SparseMatrixSELL<number>::Tvmult_add (OutVector      &dst,
+                                      const InVector &src) const
+{
+  Assert (n() == dst.size(), ExcDimensionMismatch(n(),dst.size()));
+  Assert (m() == src.size(), ExcDimensionMismatch(m(),src.size()));
+  Assert (!PointerComparison::equal(&src, &dst), ExcSourceEqualsDestination());
+
+  // the entries of a chunk are multiplied by the source entries of the rows
+  // of the chunk with vectorized arrays, and the products are added into the
+  // destination one by one since several of them can go to the same column
+  for (size_type chunk=0; chunk+1<chunk_starts.size(); ++chunk)
+    {
+      VectorizedArray<number> src_entries = VectorizedArray<number>();
+      for (unsigned int v=0; v<chunk_size; ++v)
+        {
+          const size_type row = row_of_sorted_index[chunk*chunk_size+v];
+          if (row != numbers::invalid_dof_index)
+            src_entries[v] = src(row);
+        }
+      for (std::size_t k=chunk_starts[chunk]; k<chunk_starts[chunk+1]; ++k)
+        {
+          const VectorizedArray<number> product = values[k] * src_entries;
+          for (unsigned int v=0; v<chunk_size; ++v)
+            dst(column_indices[k*chunk_size+v]) +=
+              typename OutVector::value_type(product[v]);
+        }
+    }
+}
+
+
+
+template <typename number>
+template <typename somenumber>
+void
+SparseMatrixSELL<number>::precondition_Jacobi (Vector<somenumber>       &dst,
+                                               const Vector<somenumber> &src,
+                                               const number              omega) const
+{
+  AssertDimension (m(), n());
+  AssertDimension (dst.size(), n());
+  AssertDimension (src.size(), n());
+
+  for (size_type i=0; i<n_rows; ++i)
+    dst(i) = omega * src(i) / diag_element(i);
+}
+
+
+
+template <typename number>
+std::size_t
+SparseMatrixSELL<number>::memory_consumption () const
+{
+  return (sizeof(*this) +
+          MemoryConsumption::memory_consumption (row_of_sorted_index) +
+          MemoryConsumption::memory_consumption (sorted_index_of_row) +
+          MemoryConsumption::memory_consumption (row_lengths) +
+          MemoryConsumption::memory_consumption (chunk_starts) +
+          values.memory_consumption() +
+          column_indices.memory_consumption() +
+          MemoryConsumption::memory_consumption (diagonal_indices));
+}
+
+
+DEAL_II_NAMESPACE_CLOSE
+
+#endif
@@ -102,6 +102,11 @@ public:
    * Apply the incomplete decomposition, i.e. do one forward-backward step
    * $dst=(LU)^{-1}src$.
    *
+   * If AdditionalData::use_level_scheduling was set in initialize(), the
+   * forward and backward substitutions are run in parallel along the levels
+   * of a SparseLevelSchedule, giving the same result as the sequential
+   * substitutions.
+   *
    * Call @p initialize before calling this function.
    */
   template <typename somenumber>
@@ -172,6 +177,25 @@ private:
    * Compute the row-th "inner sum".
    */
   number get_rowsum (const size_type row) const;
+
+  /**
+   * Perform the forward substitution on the rows given by the range of row
+   * indices, which are part of a level of the SparseLevelSchedule.
+   */
+  template <typename somenumber>
+  void forward_substitution_on_rows (const size_type    *begin_row,
+                                     const size_type    *end_row,
+                                     Vector<somenumber> &dst) const;
+
+  /**
+   * Perform the scaling by the diagonal and the backward substitution on the
+   * rows given by the range of row indices, which are part of a level of the
+   * SparseLevelSchedule.
+   */
+  template <typename somenumber>
+  void backward_substitution_on_rows (const size_type    *begin_row,
+                                      const size_type    *end_row,
+                                      Vector<somenumber> &dst) const;
 };
 
 /*@}*/
@@ -18,6 +18,7 @@
 
 
 #include <deal.II/base/memory_consumption.h>
+#include <deal.II/base/std_cxx11/bind.h>
 #include <deal.II/lac/sparse_mic.h>
 #include <deal.II/lac/vector.h>
 
@@ -152,6 +153,22 @@ SparseMIC<number>::vmult (Vector<somenumber>       &dst,
   //
   // Solve (X-L)X{-1}(X-U) x = b in 3 steps:
   dst = src;
+
+  // with a level schedule, the scaling v = Xu is done row by row right
+  // before the backward substitution of that row
+  if (!this->level_schedule.empty())
+    {
+      this->level_schedule.apply_forward
+      (std_cxx11::bind (&SparseMIC<number>::template forward_substitution_on_rows<somenumber>,
+                        this, std_cxx11::_1, std_cxx11::_2,
+                        std_cxx11::ref(dst)));
+      this->level_schedule.apply_backward
+      (std_cxx11::bind (&SparseMIC<number>::template backward_substitution_on_rows<somenumber>,
+                        this, std_cxx11::_1, std_cxx11::_2,
+                        std_cxx11::ref(dst)));
+      return;
+    }
+
   for (size_type row=0; row<N; ++row)
     {
       // Now: (X-L)u = b
@@ -187,6 +204,53 @@ SparseMIC<number>::vmult (Vector<somenumber>       &dst,
 }
 
 
+template <typename number>
+template <typename somenumber>
+void
+SparseMIC<number>::forward_substitution_on_rows (const size_type    *begin_row,
+                                                 const size_type    *end_row,
+                                                 Vector<somenumber> &dst) const
+{
+  for (const size_type *row_ptr=begin_row; row_ptr!=end_row; ++row_ptr)
+    {
+      const size_type row = *row_ptr;
+      for (typename SparseMatrix<number>::const_iterator
+           p = this->begin(row)+1;
+           (p != this->end(row)) && (p->column() < row);
+           ++p)
+        dst(row) -= p->value() * dst(p->column());
+
+      dst(row) *= inv_diag[row];
+    }
+}
+
+
+
+template <typename number>
+template <typename somenumber>
+void
+SparseMIC<number>::backward_substitution_on_rows (const size_type    *begin_row,
+                                                  const size_type    *end_row,
+                                                  Vector<somenumber> &dst) const
+{
+  for (const size_type *row_ptr=begin_row; row_ptr!=end_row; ++row_ptr)
+    {
+      const size_type row = *row_ptr;
+      dst(row) *= diag[row];
+
+      for (typename SparseMatrix<number>::const_iterator
+           p = this->begin(row)+1;
+           p != this->end(row);
+           ++p)
+        if (p->column() > row)
+          dst(row) -= p->value() * dst(p->column());
+
+      dst(row) *= inv_diag[row];
+    }
+}
+
+
+
 // Exists for full compatibility with the LinearOperator class
 template <typename number>
 template <typename somenumber>
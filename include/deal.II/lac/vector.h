@@ -311,7 +311,10 @@ public:
    * standard library containers.
    *
    * If @p omit_zeroing_entries is false, the vector is filled by zeros.
-   * Otherwise, the elements are left an unspecified state.
+   * Otherwise, the elements are left an unspecified state. Newly allocated
+   * memory is always zeroed, though, in order to place it (on NUMA systems)
+   * close to the threads that work on the respective part of the vector in
+   * later vector operations.
    *
    * This function is virtual in order to allow for derived classes to handle
    * memory separately.
@@ -558,6 +561,36 @@ public:
                       const Vector<Number> &V,
                       const Vector<Number> &W);
 
+  /**
+   * Compute the inner products of this vector with each of the vectors in
+   * @p V, i.e., <tt>result[i] = *this * (*V[i])</tt>. The vector @p result
+   * is resized to the number of vectors.
+   *
+   * Computing the inner products one after the other loads this vector once
+   * for each of them. This function instead works on pieces of the vectors
+   * that fit into the cache and computes all inner products on one piece
+   * before moving on to the next one, such that this vector is loaded only
+   * once. This is the operation needed for the orthogonalization against
+   * many vectors, e.g. in GMRES.
+   *
+   * @dealiiOperationIsMultithreaded The algorithm uses pairwise summation
+   * with the same order of summation as operator*(), which gives results
+   * that are bitwise identical to the individual inner products.
+   */
+  void multi_dot (const std::vector<const Vector<Number> *> &V,
+                  std::vector<Number>                       &result) const;
+
+  /**
+   * Add the linear combination of the vectors in @p V with the coefficients
+   * in @p a to this vector, i.e., <tt>*this += sum_i a[i] * (*V[i])</tt>.
+   * Like multi_dot(), this function works on pieces of the vectors that fit
+   * into the cache, such that this vector is loaded and stored only once.
+   *
+   * @dealiiOperationIsMultithreaded
+   */
+  void multi_add (const std::vector<Number>                 &a,
+                  const std::vector<const Vector<Number> *> &V);
+
   //@}
 
 
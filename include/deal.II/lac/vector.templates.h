@@ -72,6 +72,7 @@ Vector<Number>::Vector (Vector<Number> &&v)
   v.vec_size = 0;
   v.max_vec_size = 0;
   v.val = nullptr;
+  v.thread_loop_partitioner.reset(new parallel::internal::TBBPartitioner());
 }
 #endif
 
@@ -247,6 +248,7 @@ Vector<Number>::operator= (Vector<Number> &&v)
   v.vec_size = 0;
   v.max_vec_size = 0;
   v.val = nullptr;
+  v.thread_loop_partitioner.reset(new parallel::internal::TBBPartitioner());
 
   return *this;
 }
@@ -286,11 +288,13 @@ void Vector<Number>::reinit (const size_type n,
       return;
     };
 
+  bool new_memory = false;
   if (n>max_vec_size)
     {
       if (val) deallocate();
       max_vec_size = n;
       allocate();
+      new_memory = true;
     };
 
   if (vec_size != n)
@@ -303,7 +307,12 @@ void Vector<Number>::reinit (const size_type n,
         thread_loop_partitioner.reset(new parallel::internal::TBBPartitioner());
     }
 
-  if (omit_zeroing_entries == false)
+  // freshly allocated memory is always zeroed through the partitioner of the
+  // vector operations. On NUMA systems, memory pages are placed close to the
+  // thread that first touches them, so this makes sure that the later vector
+  // operations work on local memory, rather than on memory placed by the
+  // (possibly serial) code that happens to write into the vector first
+  if (omit_zeroing_entries == false || new_memory == true)
     *this = Number();
 }
 
@@ -324,14 +333,19 @@ void Vector<Number>::reinit (const Vector<Number2> &v,
       return;
     };
 
+  bool new_memory = false;
   if (v.vec_size>max_vec_size)
     {
       if (val) deallocate();
       max_vec_size = v.vec_size;
       allocate();
+      new_memory = true;
     };
   vec_size = v.vec_size;
-  if (omit_zeroing_entries == false)
+
+  // first touch of new memory with the partitioner shared with v, see the
+  // other reinit() function
+  if (omit_zeroing_entries == false || new_memory == true)
     *this = Number();
 }
 
@@ -623,6 +637,61 @@ Vector<Number>::add_and_dot (const Number          a,
 
 
 
+template <typename Number>
+void
+Vector<Number>::multi_dot (const std::vector<const Vector<Number> *> &V,
+                           std::vector<Number>                       &result) const
+{
+  Assert (vec_size!=0, ExcEmptyObject());
+
+  result.resize (V.size());
+  if (V.size() == 0)
+    return;
+
+  std::vector<const Number *> pointers (V.size());
+  for (unsigned int i=0; i<V.size(); ++i)
+    {
+      AssertDimension (vec_size, V[i]->size());
+      pointers[i] = V[i]->val;
+    }
+
+  internal::VectorOperations::MultiDot<Number> dot (val, &pointers[0], V.size());
+  internal::VectorOperations::parallel_multi_reduce (dot, vec_size, V.size(),
+                                                     &result[0],
+                                                     thread_loop_partitioner);
+  for (unsigned int i=0; i<result.size(); ++i)
+    AssertIsFinite(result[i]);
+}
+
+
+
+template <typename Number>
+void
+Vector<Number>::multi_add (const std::vector<Number>                 &a,
+                           const std::vector<const Vector<Number> *> &V)
+{
+  Assert (vec_size!=0, ExcEmptyObject());
+  AssertDimension (a.size(), V.size());
+
+  if (V.size() == 0)
+    return;
+
+  std::vector<const Number *> pointers (V.size());
+  for (unsigned int i=0; i<V.size(); ++i)
+    {
+      AssertDimension (vec_size, V[i]->size());
+      AssertIsFinite(a[i]);
+      pointers[i] = V[i]->val;
+    }
+
+  internal::VectorOperations::MultiAdd<Number> adder (val, &pointers[0], &a[0],
+                                                      V.size());
+  internal::VectorOperations::parallel_for (adder, vec_size,
+                                            thread_loop_partitioner);
+}
+
+
+
 template <typename Number>
 Vector<Number> &Vector<Number>::operator += (const Vector<Number> &v)
 {
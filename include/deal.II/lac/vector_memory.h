@@ -1,6 +1,6 @@
 // ---------------------------------------------------------------------
 //
-// Copyright (C) 1998 - 2016 by the deal.II authors
+// Copyright (C) 1998 - 2017 by the deal.II authors
 //
 // This file is part of the deal.II library.
 //
@@ -21,9 +21,18 @@
 #include <deal.II/base/smartpointer.h>
 #include <deal.II/base/logstream.h>
 #include <deal.II/base/thread_management.h>
+#include <deal.II/base/thread_local_storage.h>
 #include <deal.II/lac/vector.h>
 
+#ifdef DEAL_II_WITH_THREADS
+#  include <tbb/atomic.h>
+#  include <tbb/concurrent_queue.h>
+#  include <tbb/concurrent_unordered_map.h>
+#endif
+
 #include <vector>
+#include <set>
+#include <map>
 #include <iostream>
 
 DEAL_II_NAMESPACE_OPEN
@@ -230,6 +239,33 @@ public:
  * Nevertheless, the since they are reused, this should be of no concern.
  * Additionally, the destructor of the Pool warns about memory leaks.
  *
+ * <h3>Thread-local pools</h3>
+ *
+ * The pool keeps a separate list of unused vectors for each thread, and
+ * alloc() and free() only access the list of the calling thread. They
+ * therefore do not need to acquire a lock, and solvers running concurrently
+ * on different threads (e.g., inner solvers within WorkStream tasks or
+ * within a block preconditioner applied in parallel) do not serialize on the
+ * pool. A vector may be freed on another thread than the one that allocated
+ * it. It is then put into a lock-free queue of the pool that created it, and
+ * that pool takes it back once it runs out of unused vectors.
+ *
+ * Within the list of each thread, unused vectors are sorted into buckets by
+ * their size class, i.e., the number of binary digits of their size at the
+ * time they were returned. Since alloc() does not know the size the caller
+ * is going to request, it returns a vector from the bucket of the vector
+ * that was returned last on the calling thread, and otherwise the largest
+ * vector available. This way, an inner solver working on small vectors (say,
+ * on a coarse level) does not take the large vectors of an outer solver and
+ * force them to be reallocated, and vice versa.
+ *
+ * The function get_statistics() returns the number of allocations that were
+ * served from the pool and the ones that had to create a new vector, as well
+ * as the memory held by unused vectors. Since it accesses the pools of all
+ * threads, it must not be called while other threads allocate or free
+ * vectors of the same type. The same holds for release_unused_memory() and
+ * memory_consumption().
+ *
  * @author Guido Kanschat, 1999, 2007
  */
 template<typename VectorType = dealii::Vector<double> >
@@ -243,7 +279,8 @@ public:
 
   /**
    * Constructor.  The argument allows to preallocate a certain number of
-   * vectors. The default is not to do this.
+   * vectors in the pool of the calling thread, when the first object of this
+   * type is constructed on it. The default is not to do this.
    */
   GrowingVectorMemory (const size_type initial_size = 0,
                        const bool log_statistics = false);
@@ -270,54 +307,205 @@ public:
    * by the instance that called alloc() to get a pointer to it.
    *
    * For the present class, this means retaining the vector for later reuse by
-   * the alloc() method.
+   * the alloc() method. A vector freed on another thread than the one that
+   * allocated it is handed back to the pool of the allocating thread.
    */
   virtual void free (const VectorType *const);
 
   /**
-   * Release all vectors that are not currently in use.
+   * Release all vectors that are not currently in use. This function must
+   * not be called while other threads allocate or free vectors of this type.
    */
   static void release_unused_memory ();
 
   /**
-   * Memory consumed by this class and all currently allocated vectors.
+   * Memory consumed by this class and all vectors that are currently unused
+   * in the pool. The memory of the vectors in use is not known to the pool.
    */
   virtual std::size_t memory_consumption() const;
 
+  /**
+   * Statistics of the memory pool of the present vector type, summed over
+   * the pools of all threads.
+   */
+  struct Statistics
+  {
+    /**
+     * Constructor. Sets all numbers to zero.
+     */
+    Statistics ();
+
+    /**
+     * Number of calls to alloc() that returned an unused vector from the
+     * pool.
+     */
+    std::size_t n_hits;
+
+    /**
+     * Number of calls to alloc() that had to create a new vector.
+     */
+    std::size_t n_misses;
+
+    /**
+     * Number of vectors currently owned by the pool, whether in use or not.
+     */
+    std::size_t n_vectors;
+
+    /**
+     * Memory in bytes currently held by the unused vectors.
+     */
+    std::size_t unused_bytes;
+
+    /**
+     * The largest memory in bytes held by unused vectors so far, summed over
+     * the threads.
+     */
+    std::size_t peak_unused_bytes;
+  };
+
+  /**
+   * Return the statistics of the memory pool for the present vector type.
+   * This function must not be called while other threads allocate or free
+   * vectors of this type.
+   */
+  static Statistics get_statistics ();
+
 private:
   /**
-   * Type to enter into the array. First component will be a flag telling
-   * whether the vector is used, second the vector itself.
+   * Type to enter into the lists of unused vectors. The first component is
+   * the vector, the second one its memory consumption at the time it was
+   * returned to the pool.
+   */
+  typedef std::pair<VectorType *, std::size_t> entry_type;
+
+  /**
+   * The unused vectors and the statistics of the pool of one thread.
    */
-  typedef std::pair<bool, VectorType *> entry_type;
+  struct ThreadPool
+  {
+    /**
+     * Constructor creating an empty pool.
+     */
+    ThreadPool ();
+
+    /**
+     * Destructor. Deletes all unused vectors.
+     */
+    ~ThreadPool ();
+
+    /**
+     * Return an unused vector, or a null pointer if there is none. If the
+     * buckets are empty, the vectors handed back by other threads are moved
+     * into them first.
+     */
+    VectorType *pop ();
+
+    /**
+     * Create a new vector owned by this pool and record this pool as its
+     * owner.
+     */
+    VectorType *create ();
+
+    /**
+     * Add an unused vector to the bucket of its size class.
+     */
+    void push (VectorType *v);
+
+    /**
+     * Delete all unused vectors, including the ones handed back by other
+     * threads.
+     */
+    void clear ();
+
+    /**
+     * The unused vectors, sorted by the number of binary digits of their
+     * size.
+     */
+    std::vector<std::vector<entry_type> > buckets;
+
+#ifdef DEAL_II_WITH_THREADS
+    /**
+     * Vectors of this pool that were freed on other threads. Other threads
+     * push to this queue without locking, and the thread of this pool moves
+     * them to the buckets once it runs out of unused vectors.
+     */
+    tbb::concurrent_queue<VectorType *> returned_vectors;
+#endif
+
+    /**
+     * The size class of the vector returned last to this pool.
+     */
+    unsigned int last_size_class;
+
+    /**
+     * A flag indicating whether the vectors requested by the first
+     * constructor on this thread have been preallocated.
+     */
+    bool initialized;
+
+    /**
+     * Statistics of this pool, see the Statistics class.
+     */
+    std::size_t n_hits;
+    std::size_t n_misses;
+    std::size_t n_created;
+    std::size_t n_deleted;
+    std::size_t unused_bytes;
+    std::size_t peak_unused_bytes;
+
+  private:
+    /**
+     * The pool owns its vectors, so it must not be copied.
+     */
+    ThreadPool (const ThreadPool &);
+    ThreadPool &operator = (const ThreadPool &);
+  };
 
   /**
    * The class providing the actual storage for the memory pool.
    *
    * This is where the actual storage for GrowingVectorMemory is provided.
    * Only one of these pools is used for each vector type, thus allocating all
-   * vectors from the same storage.
+   * vectors from the same storage. It consists of one ThreadPool object for
+   * each thread that used it.
    *
    * @author Guido Kanschat, 2007
    */
   struct Pool
   {
     /**
-     * Standard constructor creating an empty pool
+     * Return pointers to the pools of all threads that have used the pool
+     * so far. This function must not be called while other threads use the
+     * pool for the first time.
      */
-    Pool();
+    std::vector<ThreadPool *> get_thread_pools ();
+
     /**
-     * Destructor. Frees memory and warns about memory leaks
+     * Remove a vector that is going to be deleted from the map of owners.
+     * This function must not be called while other threads allocate or
+     * free vectors.
      */
-    ~Pool();
+    void erase_owner (const VectorType *v);
+
+#ifdef DEAL_II_WITH_THREADS
+    typedef tbb::concurrent_unordered_map<const VectorType *, ThreadPool *> owner_map_type;
+#else
+    typedef std::map<const VectorType *, ThreadPool *> owner_map_type;
+#endif
+
     /**
-     * Create data vector; does nothing after first initialization
+     * The pool of the thread that created each vector. Entries are added
+     * by ThreadPool::create() and looked up by free() on any thread, both
+     * without locking. It is declared before the pools of the threads such
+     * that it is still available when their destructors delete the unused
+     * vectors.
      */
-    void initialize(const size_type size);
+    owner_map_type owners;
+
     /**
-     * Pointer to the storage object
+     * The pools of the individual threads.
      */
-    std::vector<entry_type> *data;
+    Threads::ThreadLocalStorage<ThreadPool> thread_pools;
   };
 
   /**
@@ -325,25 +513,43 @@ private:
    */
   static Pool pool;
 
+#ifdef DEAL_II_WITH_THREADS
   /**
    * Overall number of allocations. Only used for bookkeeping and to generate
    * output at the end of an object's lifetime.
    */
-  size_type total_alloc;
+  tbb::atomic<size_type> total_alloc;
   /**
    * Number of vectors currently allocated in this object; used for detecting
    * memory leaks.
    */
+  tbb::atomic<size_type> current_alloc;
+#else
+  size_type total_alloc;
   size_type current_alloc;
+#endif
 
   /**
    * A flag controlling the logging of statistics by the destructor.
    */
   bool log_statistics;
 
+#ifdef DEBUG
+  /**
+   * The vectors currently handed out by this object, used to check that
+   * free() is only called on vectors allocated here and only once.
+   */
+  std::set<const VectorType *> allocated_vectors;
+
+  /**
+   * Mutex protecting the set of allocated vectors.
+   */
+  Threads::Mutex allocated_vectors_mutex;
+#endif
+
   /**
-   * Mutex to synchronise access to internal data of this object from multiple
-   * threads.
+   * Mutex to synchronise the functions that access the pools of all
+   * threads, i.e., get_statistics() and release_unused_memory().
    */
   static Threads::Mutex mutex;
 };
@@ -1,6 +1,6 @@
 // ---------------------------------------------------------------------
 //
-// Copyright (C) 2007 - 2015 by the deal.II authors
+// Copyright (C) 2007 - 2017 by the deal.II authors
 //
 // This file is part of the deal.II library.
 //
@@ -19,77 +19,237 @@
 
 #include <deal.II/lac/vector_memory.h>
 
+#include <algorithm>
+
 DEAL_II_NAMESPACE_OPEN
 
 
+namespace internal
+{
+  namespace GrowingVectorMemory
+  {
+    /**
+     * Return the size class of a vector, i.e., the number of binary digits
+     * of its size.
+     */
+    template <typename VectorType>
+    inline
+    unsigned int
+    size_class (const VectorType &v)
+    {
+      unsigned int result = 0;
+      for (types::global_dof_index size = v.size(); size > 0; size >>= 1)
+        ++result;
+      return result;
+    }
+  }
+}
+
+
+
 template <typename VectorType>
 typename GrowingVectorMemory<VectorType>::Pool GrowingVectorMemory<VectorType>::pool;
 
 template <typename VectorType>
 Threads::Mutex GrowingVectorMemory<VectorType>::mutex;
 
+
+
+template <typename VectorType>
+inline
+GrowingVectorMemory<VectorType>::Statistics::Statistics ()
+  :
+  n_hits (0),
+  n_misses (0),
+  n_vectors (0),
+  unused_bytes (0),
+  peak_unused_bytes (0)
+{}
+
+
+
 template <typename VectorType>
 inline
-GrowingVectorMemory<VectorType>::Pool::Pool()
+GrowingVectorMemory<VectorType>::ThreadPool::ThreadPool ()
   :
-  data(0)
+  last_size_class (0),
+  initialized (false),
+  n_hits (0),
+  n_misses (0),
+  n_created (0),
+  n_deleted (0),
+  unused_bytes (0),
+  peak_unused_bytes (0)
 {}
 
 
 
 template <typename VectorType>
 inline
-GrowingVectorMemory<VectorType>::Pool::~Pool()
+GrowingVectorMemory<VectorType>::ThreadPool::~ThreadPool ()
+{
+  // delete all unused vectors. vectors still in use at this point are
+  // memory leaks that the GrowingVectorMemory objects have warned about
+  clear ();
+}
+
+
+
+template <typename VectorType>
+inline
+VectorType *
+GrowingVectorMemory<VectorType>::ThreadPool::pop ()
 {
-  // Nothing to do if memory was unused.
-  if (data == 0) return;
-
-  // First, delete all remaining
-  // vectors. Actually, there should
-  // be none, if there is no memory
-  // leak
-  for (typename std::vector<entry_type>::iterator i=data->begin();
-       i != data->end();
-       ++i)
+  // prefer the size class of the vector returned last, and otherwise take
+  // the largest vector, which can be reinitialized to a smaller size
+  // without reallocating memory
+  unsigned int bucket = last_size_class;
+  if (bucket >= buckets.size() || buckets[bucket].empty())
     {
-      delete i->second;
+      bucket = numbers::invalid_unsigned_int;
+      for (unsigned int b=buckets.size(); b>0; --b)
+        if (buckets[b-1].empty() == false)
+          {
+            bucket = b-1;
+            break;
+          }
+      if (bucket == numbers::invalid_unsigned_int)
+        {
+#ifdef DEAL_II_WITH_THREADS
+          // take over the vectors freed on other threads, if any
+          VectorType *returned = 0;
+          if (returned_vectors.try_pop (returned))
+            {
+              VectorType *v = 0;
+              while (returned_vectors.try_pop (v))
+                push (v);
+              return returned;
+            }
+#endif
+          return 0;
+        }
     }
-  delete data;
+
+  const entry_type entry = buckets[bucket].back();
+  buckets[bucket].pop_back();
+  unused_bytes -= entry.second;
+  return entry.first;
+}
+
+
+
+template <typename VectorType>
+inline
+void
+GrowingVectorMemory<VectorType>::ThreadPool::push (VectorType *v)
+{
+  const unsigned int bucket = internal::GrowingVectorMemory::size_class (*v);
+  if (bucket >= buckets.size())
+    buckets.resize (bucket+1);
+
+  const entry_type entry (v, v->memory_consumption());
+  buckets[bucket].push_back (entry);
+  last_size_class = bucket;
+  unused_bytes += entry.second;
+  peak_unused_bytes = std::max (peak_unused_bytes, unused_bytes);
+}
+
+
+
+template <typename VectorType>
+inline
+VectorType *
+GrowingVectorMemory<VectorType>::ThreadPool::create ()
+{
+  VectorType *v = new VectorType;
+  GrowingVectorMemory<VectorType>::pool.owners.insert (std::make_pair (v, this));
+  ++n_created;
+  return v;
 }
 
 
+
 template <typename VectorType>
 inline
 void
-GrowingVectorMemory<VectorType>::Pool::initialize(const size_type size)
+GrowingVectorMemory<VectorType>::ThreadPool::clear ()
 {
-  if (data == 0)
+#ifdef DEAL_II_WITH_THREADS
+  VectorType *v = 0;
+  while (returned_vectors.try_pop (v))
     {
-      data = new std::vector<entry_type>(size);
+      GrowingVectorMemory<VectorType>::pool.erase_owner (v);
+      delete v;
+      ++n_deleted;
+    }
+#endif
 
-      for (typename std::vector<entry_type>::iterator i= data->begin();
-           i != data->end();
-           ++i)
+  for (unsigned int b=0; b<buckets.size(); ++b)
+    {
+      for (unsigned int i=0; i<buckets[b].size(); ++i)
         {
-          i->first = false;
-          i->second = new VectorType;
+          GrowingVectorMemory<VectorType>::pool.erase_owner (buckets[b][i].first);
+          delete buckets[b][i].first;
         }
+      n_deleted += buckets[b].size();
     }
+  buckets.clear();
+  unused_bytes = 0;
+}
+
+
+
+template <typename VectorType>
+inline
+std::vector<typename GrowingVectorMemory<VectorType>::ThreadPool *>
+GrowingVectorMemory<VectorType>::Pool::get_thread_pools ()
+{
+  std::vector<ThreadPool *> result;
+#ifdef DEAL_II_WITH_THREADS
+  for (typename tbb::enumerable_thread_specific<ThreadPool>::iterator
+       p = thread_pools.get_implementation().begin();
+       p != thread_pools.get_implementation().end(); ++p)
+    result.push_back (&*p);
+#else
+  result.push_back (&thread_pools.get_implementation());
+#endif
+  return result;
+}
+
+
+
+template <typename VectorType>
+inline
+void
+GrowingVectorMemory<VectorType>::Pool::erase_owner (const VectorType *v)
+{
+#ifdef DEAL_II_WITH_THREADS
+  owners.unsafe_erase (v);
+#else
+  owners.erase (v);
+#endif
 }
 
 
+
 template <typename VectorType>
 inline
 GrowingVectorMemory<VectorType>::GrowingVectorMemory (const size_type initial_size,
                                                       const bool log_statistics)
 
   :
-  total_alloc(0),
-  current_alloc(0),
   log_statistics(log_statistics)
 {
-  Threads::Mutex::ScopedLock lock(mutex);
-  pool.initialize(initial_size);
+  total_alloc = 0;
+  current_alloc = 0;
+
+  ThreadPool &thread_pool = pool.thread_pools.get();
+  if (thread_pool.initialized == false)
+    {
+      for (size_type i=0; i<initial_size; ++i)
+        thread_pool.push (thread_pool.create());
+      thread_pool.initialized = true;
+    }
 }
 
 
@@ -104,7 +264,7 @@ GrowingVectorMemory<VectorType>::~GrowingVectorMemory()
       deallog << "GrowingVectorMemory:Overall allocated vectors: "
               << total_alloc << std::endl;
       deallog << "GrowingVectorMemory:Maximum allocated vectors: "
-              << pool.data->size() << std::endl;
+              << get_statistics().n_vectors << std::endl;
     }
 }
 
@@ -115,27 +275,28 @@ inline
 VectorType *
 GrowingVectorMemory<VectorType>::alloc ()
 {
-  Threads::Mutex::ScopedLock lock(mutex);
   ++total_alloc;
   ++current_alloc;
-  // see if there is a free vector
-  // available in our list
-  for (typename std::vector<entry_type>::iterator i=pool.data->begin();
-       i != pool.data->end(); ++i)
+
+  // see if there is a free vector available in the list of the current
+  // thread, otherwise allocate a new one
+  ThreadPool &thread_pool = pool.thread_pools.get();
+  VectorType *v = thread_pool.pop();
+  if (v != 0)
+    ++thread_pool.n_hits;
+  else
     {
-      if (i->first == false)
-        {
-          i->first = true;
-          return (i->second);
-        }
+      v = thread_pool.create();
+      ++thread_pool.n_misses;
     }
 
-  // no free vector found, so let's
-  // just allocate a new one
-  const entry_type t (true, new VectorType);
-  pool.data->push_back(t);
-
-  return t.second;
+#ifdef DEBUG
+  {
+    Threads::Mutex::ScopedLock lock(allocated_vectors_mutex);
+    allocated_vectors.insert (v);
+  }
+#endif
+  return v;
 }
 
 
@@ -145,18 +306,40 @@ inline
 void
 GrowingVectorMemory<VectorType>::free(const VectorType *const v)
 {
-  Threads::Mutex::ScopedLock lock(mutex);
-  for (typename std::vector<entry_type>::iterator i=pool.data->begin();
-       i != pool.data->end(); ++i)
+  Assert(current_alloc > 0,
+         typename VectorMemory<VectorType>::ExcNotAllocatedHere());
+#ifdef DEBUG
+  {
+    // the vector must have been handed out by this object and must not have
+    // been freed already
+    Threads::Mutex::ScopedLock lock(allocated_vectors_mutex);
+    Assert(allocated_vectors.erase (v) == 1,
+           typename VectorMemory<VectorType>::ExcNotAllocatedHere());
+  }
+#endif
+  --current_alloc;
+
+  // look up the pool that created the vector. if it belongs to another
+  // thread, hand the vector back through the queue of that pool, such that
+  // vectors allocated on one thread and freed on another one are reused
+  // rather than piling up in the pool of the freeing thread
+  const typename Pool::owner_map_type::const_iterator
+  owner = pool.owners.find (v);
+  Assert(owner != pool.owners.end(),
+         typename VectorMemory<VectorType>::ExcNotAllocatedHere());
+
+  ThreadPool &thread_pool = pool.thread_pools.get();
+  VectorType *vector = const_cast<VectorType *>(v);
+  if (owner->second == &thread_pool)
+    thread_pool.push (vector);
+  else
     {
-      if (v == (i->second))
-        {
-          i->first = false;
-          --current_alloc;
-          return;
-        }
+#ifdef DEAL_II_WITH_THREADS
+      owner->second->returned_vectors.push (vector);
+#else
+      Assert(false, ExcInternalError());
+#endif
     }
-  Assert(false, typename VectorMemory<VectorType>::ExcNotAllocatedHere());
 }
 
 
@@ -168,21 +351,32 @@ GrowingVectorMemory<VectorType>::release_unused_memory ()
 {
   Threads::Mutex::ScopedLock lock(mutex);
 
-  std::vector<entry_type> new_data;
+  const std::vector<ThreadPool *> thread_pools = pool.get_thread_pools();
+  for (unsigned int p=0; p<thread_pools.size(); ++p)
+    thread_pools[p]->clear();
+}
 
-  if (pool.data != 0)
+
+
+template<typename VectorType>
+inline
+typename GrowingVectorMemory<VectorType>::Statistics
+GrowingVectorMemory<VectorType>::get_statistics ()
+{
+  Threads::Mutex::ScopedLock lock(mutex);
+
+  Statistics statistics;
+  const std::vector<ThreadPool *> thread_pools = pool.get_thread_pools();
+  for (unsigned int p=0; p<thread_pools.size(); ++p)
     {
-      const typename std::vector<entry_type>::const_iterator
-      end = pool.data->end();
-      for (typename std::vector<entry_type>::const_iterator
-           i = pool.data->begin(); i != end ; ++i)
-        if (i->first == false)
-          delete i->second;
-        else
-          new_data.push_back (*i);
-
-      *pool.data = new_data;
+      statistics.n_hits += thread_pools[p]->n_hits;
+      statistics.n_misses += thread_pools[p]->n_misses;
+      statistics.n_vectors += thread_pools[p]->n_created;
+      statistics.n_vectors -= thread_pools[p]->n_deleted;
+      statistics.unused_bytes += thread_pools[p]->unused_bytes;
+      statistics.peak_unused_bytes += thread_pools[p]->peak_unused_bytes;
     }
+  return statistics;
 }
 
 
@@ -192,16 +386,7 @@ inline
 std::size_t
 GrowingVectorMemory<VectorType>::memory_consumption () const
 {
-  Threads::Mutex::ScopedLock lock(mutex);
-
-  std::size_t result = sizeof (*this);
-  const typename std::vector<entry_type>::const_iterator
-  end = pool.data->end();
-  for (typename std::vector<entry_type>::const_iterator
-       i = pool.data->begin(); i != end ; ++i)
-    result += sizeof (*i) + i->second->memory_consumption();
-
-  return result;
+  return sizeof (*this) + get_statistics().unused_bytes;
 }
 
 
@@ -23,6 +23,7 @@
 #include <deal.II/base/vectorization.h>
 
 #include <cstdio>
+#include <vector>
 
 DEAL_II_NAMESPACE_OPEN
 
@@ -902,6 +903,24 @@ namespace internal
      */
     const unsigned int vector_accumulation_recursion_threshold = 128;
 
+    // declare the inner working routines defined below, such that they are
+    // found also for operations defined outside this namespace
+    template <typename Operation, typename ResultType>
+    void
+    accumulate_regular(const Operation &op,
+                       size_type       &n_chunks,
+                       size_type       &index,
+                       ResultType (&outer_results)[vector_accumulation_recursion_threshold],
+                       internal::bool2type<false>);
+
+    template <typename Operation, typename Number>
+    void
+    accumulate_regular(const Operation &op,
+                       size_type       &n_chunks,
+                       size_type       &index,
+                       Number (&outer_results)[vector_accumulation_recursion_threshold],
+                       internal::bool2type<true>);
+
     template <typename Operation, typename ResultType>
     void accumulate_recursive (const Operation   &op,
                                const size_type    first,
@@ -1273,6 +1292,252 @@ namespace internal
       (void)partitioner;
 #endif
     }
+
+
+
+    // Block operations between one vector and several other vectors. The
+    // plain approach of calling the single-vector operations one after the
+    // other loads the first vector once for each of the other vectors. The
+    // functors below instead go through the vectors in pieces that fit into
+    // the cache and apply all operations to one piece before moving on to
+    // the next one, such that the first vector is only loaded once from main
+    // memory.
+
+    /**
+     * The inner products of the vector @p X with @p n_vectors vectors Y[i]
+     * on the range [first,last), added to @p results. The range is split in
+     * the same way as in accumulate_recursive() until the pieces fit into the
+     * cache, and the results of the pieces are summed up pairwise in the same
+     * order as there. Therefore, each result is bitwise identical to the one
+     * of the individual inner product.
+     */
+    template <typename Number>
+    struct MultiDot
+    {
+      MultiDot(const Number        *X,
+               const Number *const *Y,
+               const unsigned int   n_vectors)
+        :
+        X(X),
+        Y(Y),
+        n_vectors(n_vectors)
+      {}
+
+      void operator() (const size_type first,
+                       const size_type last,
+                       Number         *results) const
+      {
+        const size_type vec_size = last - first;
+        if (vec_size <= vector_accumulation_recursion_threshold * 32)
+          {
+            for (unsigned int i=0; i<n_vectors; ++i)
+              {
+                Number sum;
+                accumulate_recursive(Dot<Number,Number>(X, Y[i]), first, last,
+                                     sum);
+                results[i] = sum;
+              }
+          }
+        else
+          {
+            const size_type new_size =
+              (vec_size / (vector_accumulation_recursion_threshold * 32)) *
+              vector_accumulation_recursion_threshold * 8;
+            Assert (first+3*new_size < last,
+                    ExcInternalError());
+            std::vector<Number> r (3*n_vectors);
+            (*this)(first, first+new_size, results);
+            (*this)(first+new_size, first+2*new_size, &r[0]);
+            (*this)(first+2*new_size, first+3*new_size, &r[n_vectors]);
+            (*this)(first+3*new_size, last, &r[2*n_vectors]);
+            for (unsigned int i=0; i<n_vectors; ++i)
+              {
+                results[i] += r[i];
+                r[n_vectors+i] += r[2*n_vectors+i];
+                results[i] = results[i] + r[n_vectors+i];
+              }
+          }
+      }
+
+      const Number        *X;
+      const Number *const *Y;
+      const unsigned int   n_vectors;
+    };
+
+    /**
+     * The update X += sum_i a[i] V[i] for @p n_vectors vectors V[i], to be
+     * used with parallel_for(). The vectors are processed in groups of four
+     * on pieces of X that stay in the cache.
+     */
+    template <typename Number>
+    struct MultiAdd
+    {
+      static const unsigned int block_size = 1024;
+
+      MultiAdd(Number              *X,
+               const Number *const *V,
+               const Number        *a,
+               const unsigned int   n_vectors)
+        :
+        X(X),
+        V(V),
+        a(a),
+        n_vectors(n_vectors)
+      {}
+
+      void operator() (const size_type begin, const size_type end) const
+      {
+        for (size_type block_begin=begin; block_begin<end;
+             block_begin+=block_size)
+          {
+            const size_type block_end = std::min(block_begin+block_size, end);
+            unsigned int v=0;
+            for ( ; v+4<=n_vectors; v+=4)
+              {
+                const Number a0 = a[v], a1 = a[v+1], a2 = a[v+2], a3 = a[v+3];
+                const Number *V0 = V[v], *V1 = V[v+1], *V2 = V[v+2],
+                              *V3 = V[v+3];
+                DEAL_II_OPENMP_SIMD_PRAGMA
+                for (size_type i=block_begin; i<block_end; ++i)
+                  X[i] += a0 * V0[i] + a1 * V1[i] + a2 * V2[i] + a3 * V3[i];
+              }
+            for ( ; v<n_vectors; ++v)
+              {
+                const Number a0 = a[v];
+                const Number *V0 = V[v];
+                DEAL_II_OPENMP_SIMD_PRAGMA
+                for (size_type i=block_begin; i<block_end; ++i)
+                  X[i] += a0 * V0[i];
+              }
+          }
+      }
+
+      Number              *X;
+      const Number *const *V;
+      const Number        *a;
+      const unsigned int   n_vectors;
+    };
+
+
+
+#ifdef DEAL_II_WITH_THREADS
+    /**
+     * The equivalent of TBBReduceFunctor for operations that compute several
+     * results at once, like MultiDot. The layout of the chunks is the same as
+     * in TBBReduceFunctor, such that the results are the same as for the
+     * individual reductions.
+     */
+    template <typename Operation, typename ResultType>
+    struct TBBMultiReduceFunctor
+    {
+      TBBMultiReduceFunctor(const Operation   &op,
+                            const size_type    vec_size,
+                            const unsigned int n_results)
+        :
+        op(op),
+        vec_size(vec_size),
+        n_results(n_results)
+      {
+        const unsigned int gs = internal::Vector::minimum_parallel_grain_size;
+        n_chunks = std::min(static_cast<size_type>(4*MultithreadInfo::n_threads()),
+                            vec_size / gs);
+        chunk_size = vec_size / n_chunks;
+        if (chunk_size > 512)
+          chunk_size = ((chunk_size + 511)/512)*512;
+        n_chunks = (vec_size + chunk_size - 1) / chunk_size;
+        AssertIndexRange((n_chunks-1)*chunk_size, vec_size);
+        AssertIndexRange(vec_size, n_chunks*chunk_size+1);
+
+        // allocate an even number of chunks, access to the new last element
+        // is needed in do_sum(). TBB works on copies of this object, so the
+        // results are written through a pointer to the storage of the
+        // original object
+        chunk_results.resize(2*((n_chunks+1)/2)*n_results);
+        results_ptr = &chunk_results[0];
+      }
+
+      void operator() (const tbb::blocked_range<size_type> &range) const
+      {
+        for (size_type i = range.begin(); i < range.end(); ++i)
+          op(i*chunk_size, std::min((i+1)*chunk_size, vec_size),
+             &results_ptr[i*n_results]);
+      }
+
+      void do_sum(ResultType *results) const
+      {
+        while (n_chunks > 1)
+          {
+            if (n_chunks % 2 == 1)
+              {
+                for (unsigned int r=0; r<n_results; ++r)
+                  results_ptr[n_chunks*n_results+r] = ResultType();
+                ++n_chunks;
+              }
+            for (size_type i=0; i<n_chunks; i+=2)
+              for (unsigned int r=0; r<n_results; ++r)
+                results_ptr[(i/2)*n_results+r] = results_ptr[i*n_results+r] +
+                                                 results_ptr[(i+1)*n_results+r];
+            n_chunks /= 2;
+          }
+        for (unsigned int r=0; r<n_results; ++r)
+          results[r] = results_ptr[r];
+      }
+
+      const Operation &op;
+      const size_type vec_size;
+      const unsigned int n_results;
+
+      mutable unsigned int n_chunks;
+      size_type chunk_size;
+      std::vector<ResultType> chunk_results;
+      // points to the data of chunk_results of the original object
+      ResultType *results_ptr;
+    };
+#endif
+
+
+
+    /**
+     * The general caller for operations that compute @p n_results
+     * reductions at once in parallel, like MultiDot. The results are
+     * written into the array @p results.
+     */
+    template <typename Operation, typename ResultType>
+    void parallel_multi_reduce (const Operation    &op,
+                                const size_type     vec_size,
+                                const unsigned int  n_results,
+                                ResultType         *results,
+                                std_cxx11::shared_ptr<parallel::internal::TBBPartitioner> &partitioner)
+    {
+      if (n_results == 0)
+        return;
+#ifdef DEAL_II_WITH_THREADS
+      if (vec_size >= 4*internal::Vector::minimum_parallel_grain_size &&
+          MultithreadInfo::n_threads() > 1)
+        {
+          Assert(partitioner.get() != NULL,
+                 ExcInternalError("Unexpected initialization of Vector that does "
+                                  "not set the TBB partitioner to a usable state."));
+          std_cxx11::shared_ptr<tbb::affinity_partitioner> tbb_partitioner =
+            partitioner->acquire_one_partitioner();
+
+          TBBMultiReduceFunctor<Operation,ResultType> generic_functor(op, vec_size,
+                                                                      n_results);
+          tbb::parallel_for (tbb::blocked_range<size_type> (0,
+                                                            generic_functor.n_chunks,
+                                                            1),
+                             generic_functor,
+                             *tbb_partitioner);
+          partitioner->release_one_partitioner(tbb_partitioner);
+          generic_functor.do_sum(results);
+        }
+      else
+        op(0,vec_size,results);
+#else
+      op(0,vec_size,results);
+      (void)partitioner;
+#endif
+    }
   }
 }
 
@@ -59,6 +59,40 @@ namespace internal
      */
     struct DoFInfo
     {
+      /**
+       * The formats in which the indices of the degrees of freedom of a macro
+       * cell can be stored.
+       */
+      enum IndexStorageVariants
+      {
+        /**
+         * The indices of all lanes are stored in the @p dof_indices field,
+         * including the indices needed to resolve constraints. This is the
+         * general case that must be used for cells with constraints and for
+         * macro cells where not all lanes are filled.
+         */
+        full,
+        /**
+         * The degrees of freedom of the macro cell occupy one contiguous
+         * range in the vector with the lanes running fastest, i.e., the
+         * degree of freedom @p i of lane @p v sits at position
+         * <tt>dof_indices_contiguous[cell*vectorization_length+v] +
+         * i*vectorization_length</tt>. The entries can be accessed by vector
+         * loads and stores without any transformation. No indices are stored
+         * in @p dof_indices.
+         */
+        interleaved,
+        /**
+         * The degrees of freedom of each lane occupy a contiguous range in
+         * the vector, i.e., the degree of freedom @p i of lane @p v sits at
+         * position <tt>dof_indices_contiguous[cell*vectorization_length+v] +
+         * i</tt>. The entries can be accessed by loads of full vectors from
+         * each range followed by an in-register transpose. No indices are
+         * stored in @p dof_indices.
+         */
+        contiguous
+      };
+
       /**
        * Default empty constructor.
        */
@@ -123,6 +157,15 @@ namespace internal
        */
       const unsigned int *end_indices_plain (const unsigned int row) const;
 
+      /**
+       * Return the MPI-local index of the degree of freedom @p i of the cell
+       * in lane @p lane of the macro cell @p row for a macro cell stored in
+       * the interleaved or contiguous format, see IndexStorageVariants.
+       */
+      unsigned int compressed_dof_index (const unsigned int row,
+                                         const unsigned int lane,
+                                         const unsigned int i) const;
+
       /**
        * Return the FE index for a given finite element degree. If not in hp
        * mode, this function always returns index 0. If an index is not found
@@ -156,6 +199,16 @@ namespace internal
                              ConstraintValues<double> &constraint_values,
                              bool                            &cell_at_boundary);
 
+      /**
+       * Reads the indices of a cell located on a remote processor that is
+       * adjacent to a locally owned cell through a face, as needed for face
+       * integrals. The indices are appended to @p dof_indices_ghost_cells in
+       * lexicographic order without resolving constraints. Ghost indices get
+       * a temporary number in the same way as in @p read_dof_indices.
+       */
+      void read_dof_indices_ghost_cell (const std::vector<types::global_dof_index> &local_indices,
+                                        const std::vector<unsigned int> &lexicographic_inv);
+
       /**
        * This method assigns the correct indices to ghost indices from the
        * temporary numbering employed by the @p read_dof_indices function. The
@@ -256,6 +309,22 @@ namespace internal
                                              std::vector<unsigned int> &irregular_cells,
                                              const bool                 hp_bool);
 
+      /**
+       * Set up the dependency graph of the task graph scheme from the
+       * connectivity between the chunks of cells computed in
+       * make_thread_graph_partition_color(). The argument @p block_order
+       * holds the chunk in the connectivity graph for each position in the
+       * loop. Each edge of the graph is oriented from the chunk that comes
+       * first in the loop to the later one, which makes the graph acyclic
+       * and ensures that no two chunks accessing the same vector entries run
+       * at the same time.
+       */
+      void
+      make_task_graph (const DynamicSparsityPattern    &connectivity,
+                       const std::vector<unsigned int> &block_order,
+                       const SizeInfo                  &size_info,
+                       TaskInfo                        &task_info) const;
+
       /**
        * This function computes the connectivity of the currently stored
        * indices and fills the structure into a sparsity pattern. The
@@ -272,8 +341,45 @@ namespace internal
 
       /**
        * Renumbers the degrees of freedom to give good access for this class.
+       * Since the new numbering changes the ranges of vector entries
+       * accessed by the cells, the lists of compute_cell_loop_pre_post_lists()
+       * are recomputed with the given @p size_info.
+       */
+      void renumber_dofs (std::vector<types::global_dof_index> &renumbering,
+                          const SizeInfo                       &size_info);
+
+      /**
+       * Determines the storage format of the indices of each macro cell, see
+       * IndexStorageVariants, and removes the indices of the macro cells
+       * that can be represented by the start indices of the lanes from the
+       * @p dof_indices field. This is the case for macro cells without
+       * constraints where the degrees of freedom of each cell are
+       * contiguous in the vector, as for discontinuous elements, or where the
+       * degrees of freedom of all lanes are interleaved in one contiguous
+       * range, as it results from a numbering of the degrees of freedom in
+       * the order they are accessed by the cell loop. Must be called after
+       * reorder_cells().
+       */
+      void compress_indices (const unsigned int vectorization_length);
+
+      /**
+       * Reverts the effect of compress_indices() by storing the indices of
+       * all macro cells in the @p dof_indices field.
+       */
+      void uncompress_indices ();
+
+      /**
+       * Splits the macro cells into chunks for the serial cell loop and
+       * determines, for ranges of the locally owned degrees of freedom,
+       * the chunk in which each range is accessed for the first and for the
+       * last time. This information is stored in the fields @p
+       * cell_loop_chunks, @p cell_loop_pre_list_index, @p cell_loop_pre_list,
+       * @p cell_loop_post_list_index, and @p cell_loop_post_list and is used
+       * by the variant of MatrixFree::cell_loop() that runs operations on
+       * vector entries before and after the loop. Must be called after
+       * reorder_cells().
        */
-      void renumber_dofs (std::vector<types::global_dof_index> &renumbering);
+      void compute_cell_loop_pre_post_lists (const SizeInfo &size_info);
 
       /**
        * Return the memory consumption in bytes of this class.
@@ -337,6 +443,28 @@ namespace internal
        */
       std::vector<std::pair<unsigned short,unsigned short> > constraint_indicator;
 
+      /**
+       * Stores the storage format of the indices of each macro cell as one
+       * of the values of IndexStorageVariants. Empty if compress_indices()
+       * has not been called, in which case all macro cells use the @p full
+       * format.
+       */
+      std::vector<unsigned char> index_storage_variants;
+
+      /**
+       * Stores the index of the first degree of freedom of each lane for the
+       * macro cells stored in the interleaved or contiguous format, with
+       * @p vectorization_length entries per macro cell. The entries of macro
+       * cells in the full format are invalid.
+       */
+      std::vector<unsigned int> dof_indices_contiguous;
+
+      /**
+       * Stores the number of lanes in a macro cell that was used for setting
+       * up the compressed index storage.
+       */
+      unsigned int vectorization_length;
+
       /**
        * This stores the parallel partitioning that can be used to set up
        * vectors. The partitioner includes the description of the local range
@@ -367,6 +495,16 @@ namespace internal
        */
       std::vector<unsigned int> plain_dof_indices;
 
+      /**
+       * Stores the indices of the degrees of freedom on cells owned by remote
+       * processors that are adjacent to locally owned cells through a face,
+       * in the MPI-local index space. The indices of each cell are stored in
+       * lexicographic order with <tt>dofs_per_cell[0]</tt> entries per cell
+       * and constraints are not resolved. Only filled when MatrixFree is set
+       * up for face integrals.
+       */
+      std::vector<unsigned int> dof_indices_ghost_cells;
+
       /**
        * Stores the dimension of the underlying DoFHandler. Since the indices
        * are not templated, this is the variable that makes the dimension
@@ -419,6 +557,51 @@ namespace internal
        * partitioner.
        */
       std::vector<types::global_dof_index> ghost_dofs;
+
+      /**
+       * The subdivision of the macro cells into chunks for the variant of
+       * MatrixFree::cell_loop() with operations before and after the loop,
+       * given by the start of each chunk plus the end of the last one. The
+       * chunks do not straddle the start and end of the cells with ghost
+       * degrees of freedom, in order to allow for the overlap of
+       * communication and computation.
+       */
+      std::vector<unsigned int> cell_loop_chunks;
+
+      /**
+       * Index into @p cell_loop_pre_list. The ranges stored between
+       * <tt>cell_loop_pre_list_index[0]</tt> and
+       * <tt>cell_loop_pre_list_index[1]</tt> must be processed before the
+       * loop starts (including the exchange of ghost data), and the ranges
+       * between <tt>cell_loop_pre_list_index[c+1]</tt> and
+       * <tt>cell_loop_pre_list_index[c+2]</tt> just before chunk @p c of @p
+       * cell_loop_chunks is processed.
+       */
+      std::vector<unsigned int> cell_loop_pre_list_index;
+
+      /**
+       * Ranges of locally owned degrees of freedom, <tt>[first,
+       * second)</tt>, that are accessed for the first time by the cells in
+       * the respective chunk, see @p cell_loop_pre_list_index.
+       */
+      std::vector<std::pair<unsigned int,unsigned int> > cell_loop_pre_list;
+
+      /**
+       * Index into @p cell_loop_post_list. The ranges stored between
+       * <tt>cell_loop_post_list_index[c]</tt> and
+       * <tt>cell_loop_post_list_index[c+1]</tt> can be processed after
+       * chunk @p c of @p cell_loop_chunks is done. The last entry collects
+       * the ranges to be processed after the loop has finished (including the
+       * compress operation).
+       */
+      std::vector<unsigned int> cell_loop_post_list_index;
+
+      /**
+       * Ranges of locally owned degrees of freedom, <tt>[first,
+       * second)</tt>, that are accessed for the last time by the cells in
+       * the respective chunk, see @p cell_loop_post_list_index.
+       */
+      std::vector<std::pair<unsigned int,unsigned int> > cell_loop_post_list;
     };
 
 
@@ -460,6 +643,23 @@ namespace internal
 
 
 
+    inline
+    unsigned int
+    DoFInfo::compressed_dof_index (const unsigned int row,
+                                   const unsigned int lane,
+                                   const unsigned int i) const
+    {
+      AssertIndexRange (row, index_storage_variants.size());
+      AssertIndexRange (lane, vectorization_length);
+      Assert (index_storage_variants[row] != full, ExcInternalError());
+      const unsigned int start =
+        dof_indices_contiguous[row*vectorization_length+lane];
+      return index_storage_variants[row] == interleaved ?
+             start + i*vectorization_length : start + i;
+    }
+
+
+
     inline
     const std::pair<unsigned short,unsigned short> *
     DoFInfo::begin_indicators (const unsigned int row) const
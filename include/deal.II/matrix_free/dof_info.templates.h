@@ -135,10 +135,14 @@ namespace internal
       row_starts (dof_info_in.row_starts),
       dof_indices (dof_info_in.dof_indices),
       constraint_indicator (dof_info_in.constraint_indicator),
+      index_storage_variants (dof_info_in.index_storage_variants),
+      dof_indices_contiguous (dof_info_in.dof_indices_contiguous),
+      vectorization_length (dof_info_in.vectorization_length),
       vector_partitioner (dof_info_in.vector_partitioner),
       constrained_dofs (dof_info_in.constrained_dofs),
       row_starts_plain_indices (dof_info_in.row_starts_plain_indices),
       plain_dof_indices (dof_info_in.plain_dof_indices),
+      dof_indices_ghost_cells (dof_info_in.dof_indices_ghost_cells),
       dimension (dof_info_in.dimension),
       n_components (dof_info_in.n_components),
       dofs_per_cell (dof_info_in.dofs_per_cell),
@@ -147,7 +151,12 @@ namespace internal
       cell_active_fe_index (dof_info_in.cell_active_fe_index),
       max_fe_index (dof_info_in.max_fe_index),
       fe_index_conversion (dof_info_in.fe_index_conversion),
-      ghost_dofs (dof_info_in.ghost_dofs)
+      ghost_dofs (dof_info_in.ghost_dofs),
+      cell_loop_chunks (dof_info_in.cell_loop_chunks),
+      cell_loop_pre_list_index (dof_info_in.cell_loop_pre_list_index),
+      cell_loop_pre_list (dof_info_in.cell_loop_pre_list),
+      cell_loop_post_list_index (dof_info_in.cell_loop_post_list_index),
+      cell_loop_post_list (dof_info_in.cell_loop_post_list)
     {}
 
 
@@ -158,6 +167,9 @@ namespace internal
       row_starts.clear();
       dof_indices.clear();
       constraint_indicator.clear();
+      index_storage_variants.clear();
+      dof_indices_contiguous.clear();
+      vectorization_length = 1;
       vector_partitioner.reset();
       ghost_dofs.clear();
       dofs_per_cell.clear();
@@ -166,10 +178,16 @@ namespace internal
       n_components = 0;
       row_starts_plain_indices.clear();
       plain_dof_indices.clear();
+      dof_indices_ghost_cells.clear();
       store_plain_indices = false;
       cell_active_fe_index.clear();
       max_fe_index = 0;
       fe_index_conversion.clear();
+      cell_loop_chunks.clear();
+      cell_loop_pre_list_index.clear();
+      cell_loop_pre_list.clear();
+      cell_loop_post_list_index.clear();
+      cell_loop_post_list.clear();
     }
 
 
@@ -329,6 +347,32 @@ no_constraint:
 
 
 
+    void
+    DoFInfo::read_dof_indices_ghost_cell (const std::vector<types::global_dof_index> &local_indices,
+                                          const std::vector<unsigned int> &lexicographic_inv)
+    {
+      Assert (vector_partitioner.get() !=0, ExcInternalError());
+      const types::global_dof_index first_owned = vector_partitioner->local_range().first;
+      const types::global_dof_index last_owned  = vector_partitioner->local_range().second;
+      const unsigned int n_owned = last_owned - first_owned;
+      AssertDimension (local_indices.size(), dofs_per_cell[0]);
+      for (unsigned int i=0; i<local_indices.size(); ++i)
+        {
+          const types::global_dof_index current_dof =
+            local_indices[lexicographic_inv[i]];
+          if (current_dof < first_owned || current_dof >= last_owned)
+            {
+              ghost_dofs.push_back(current_dof);
+              dof_indices_ghost_cells.push_back(n_owned + ghost_dofs.size() - 1);
+            }
+          else
+            dof_indices_ghost_cells.push_back
+            (static_cast<unsigned int>(current_dof - first_owned));
+        }
+    }
+
+
+
     void
     DoFInfo::assign_ghosts (const std::vector<unsigned int> &boundary_cells)
     {
@@ -424,6 +468,14 @@ no_constraint:
                     }
                 }
             }
+
+          // finally the indices on ghost cells adjacent to owned cells
+          // through faces
+          for (std::vector<unsigned int>::iterator
+               dof = dof_indices_ghost_cells.begin();
+               dof != dof_indices_ghost_cells.end(); ++dof)
+            if (*dof >= n_owned)
+              *dof = n_owned + ghost_numbering[*dof - n_owned];
         }
 
       std::vector<types::global_dof_index> empty;
@@ -1140,6 +1192,65 @@ no_constraint:
                                     (task_info.odds+task_info.evens+1)%2;
       task_info.n_workers = task_info.partition_color_blocks_data.size()-1-
                             task_info.n_blocked_workers;
+
+      if (task_info.use_task_graph == true)
+        make_task_graph (connectivity, partition_color_list, size_info,
+                         task_info);
+    }
+
+
+
+    void
+    DoFInfo::make_task_graph (const DynamicSparsityPattern    &connectivity,
+                              const std::vector<unsigned int> &block_order,
+                              const SizeInfo                  &size_info,
+                              TaskInfo                        &task_info) const
+    {
+      const unsigned int n_blocks = task_info.n_blocks;
+      AssertDimension (block_order.size(), n_blocks);
+      std::vector<unsigned int> position (n_blocks);
+      for (unsigned int i=0; i<n_blocks; ++i)
+        position[block_order[i]] = i;
+
+      // the successors of a chunk are all neighbors that come later in the
+      // loop, sorted to visit them in the loop order
+      task_info.task_graph_n_predecessors.clear();
+      task_info.task_graph_n_predecessors.resize (n_blocks, 0);
+      task_info.task_graph_successors_row_index.resize (n_blocks+1);
+      task_info.task_graph_successors_row_index[0] = 0;
+      task_info.task_graph_successors.clear();
+      std::vector<unsigned int> successors;
+      for (unsigned int block=0; block<n_blocks; ++block)
+        {
+          successors.clear();
+          for (DynamicSparsityPattern::iterator
+               neighbor = connectivity.begin(block_order[block]),
+               end = connectivity.end(block_order[block]);
+               neighbor != end; ++neighbor)
+            if (position[neighbor->column()] > block)
+              successors.push_back (position[neighbor->column()]);
+          std::sort (successors.begin(), successors.end());
+          for (unsigned int i=0; i<successors.size(); ++i)
+            ++task_info.task_graph_n_predecessors[successors[i]];
+          task_info.task_graph_successors.insert
+          (task_info.task_graph_successors.end(), successors.begin(),
+           successors.end());
+          task_info.task_graph_successors_row_index[block+1] =
+            task_info.task_graph_successors.size();
+        }
+
+      // the chunks in the first partition of the partition-color scheme are
+      // the ones with cells that touch ghosted vector entries
+      if (size_info.boundary_cells_end > size_info.boundary_cells_start &&
+          task_info.use_coloring_only == false)
+        task_info.task_graph_n_boundary_blocks =
+          task_info.partition_color_blocks_data
+          [task_info.partition_color_blocks_row_index[1]];
+      else
+        task_info.task_graph_n_boundary_blocks = 0;
+      AssertIndexRange (task_info.task_graph_n_boundary_blocks, n_blocks+1);
+
+      task_info.compute_task_graph_statistics ();
     }
 
 
@@ -1873,8 +1984,15 @@ not_connect:
 
 
 
-    void DoFInfo::renumber_dofs (std::vector<types::global_dof_index> &renumbering)
+    void DoFInfo::renumber_dofs (std::vector<types::global_dof_index> &renumbering,
+                                 const SizeInfo                       &size_info)
     {
+      // the renumbering works on the explicit indices, so expand the
+      // compressed storage before and compress again afterwards
+      const bool indices_were_compressed = !index_storage_variants.empty();
+      if (indices_were_compressed)
+        uncompress_indices();
+
       // first renumber all locally owned degrees of freedom
       AssertDimension (vector_partitioner->local_size(),
                        vector_partitioner->size());
@@ -1918,6 +2036,250 @@ not_connect:
         renumbering[i] = vector_partitioner->local_to_global(renumbering[i]);
 
       AssertDimension (counter, renumbering.size());
+
+      // the ranges accessed by the cells have changed, so the lists for the
+      // operations before and after the cell loop must be set up again
+      // (from the uncompressed indices)
+      compute_cell_loop_pre_post_lists (size_info);
+
+      if (indices_were_compressed)
+        compress_indices (vectorization_length);
+    }
+
+
+
+    void
+    DoFInfo::compress_indices (const unsigned int vectorization_length)
+    {
+      if (!index_storage_variants.empty())
+        uncompress_indices();
+
+      this->vectorization_length = vectorization_length;
+      const unsigned int n_macro_cells = row_starts.size() - 1;
+      index_storage_variants.resize (n_macro_cells, full);
+      dof_indices_contiguous.resize (n_macro_cells*vectorization_length,
+                                     numbers::invalid_unsigned_int);
+
+      std::vector<unsigned int> new_dof_indices;
+      new_dof_indices.reserve (dof_indices.size());
+      std::vector<unsigned int> new_row_starts (n_macro_cells+1);
+      std::vector<unsigned int> sorted_starts (vectorization_length);
+      for (unsigned int cell=0; cell<n_macro_cells; ++cell)
+        {
+          new_row_starts[cell] = new_dof_indices.size();
+          const unsigned int *indices = begin_indices(cell);
+          const unsigned int n_entries = row_length_indices(cell);
+
+          // only macro cells with all lanes filled and without constraints
+          // can be compressed
+          if (row_starts[cell][2] == 0 && row_length_indicators(cell) == 0 &&
+              n_entries > 0 && n_entries % vectorization_length == 0)
+            {
+              const unsigned int n_dofs = n_entries / vectorization_length;
+
+              bool is_interleaved = true;
+              for (unsigned int i=1; i<n_entries; ++i)
+                if (indices[i] != indices[0] + i)
+                  {
+                    is_interleaved = false;
+                    break;
+                  }
+
+              // for the contiguous case, the ranges of the lanes must not
+              // overlap because the vectorized write operations do not
+              // handle multiple contributions to the same entry
+              bool is_contiguous = !is_interleaved;
+              for (unsigned int v=0; v<vectorization_length && is_contiguous; ++v)
+                for (unsigned int i=1; i<n_dofs; ++i)
+                  if (indices[i*vectorization_length+v] != indices[v] + i)
+                    {
+                      is_contiguous = false;
+                      break;
+                    }
+              if (is_contiguous)
+                {
+                  for (unsigned int v=0; v<vectorization_length; ++v)
+                    sorted_starts[v] = indices[v];
+                  std::sort (sorted_starts.begin(), sorted_starts.end());
+                  for (unsigned int v=1; v<vectorization_length; ++v)
+                    if (sorted_starts[v] < sorted_starts[v-1] + n_dofs)
+                      is_contiguous = false;
+                }
+
+              if (is_interleaved || is_contiguous)
+                {
+                  index_storage_variants[cell] = is_interleaved ? interleaved :
+                                                 contiguous;
+                  for (unsigned int v=0; v<vectorization_length; ++v)
+                    dof_indices_contiguous[cell*vectorization_length+v] =
+                      indices[v];
+                  continue;
+                }
+            }
+
+          new_dof_indices.insert (new_dof_indices.end(), indices,
+                                  indices+n_entries);
+        }
+      new_row_starts[n_macro_cells] = new_dof_indices.size();
+
+      for (unsigned int cell=0; cell<=n_macro_cells; ++cell)
+        row_starts[cell][0] = new_row_starts[cell];
+      dof_indices.swap (new_dof_indices);
+      std::vector<unsigned int> (dof_indices).swap (dof_indices);
+    }
+
+
+
+    void
+    DoFInfo::uncompress_indices ()
+    {
+      if (index_storage_variants.empty())
+        return;
+
+      const unsigned int n_macro_cells = row_starts.size() - 1;
+      AssertDimension (index_storage_variants.size(), n_macro_cells);
+      std::vector<unsigned int> new_dof_indices;
+      std::vector<unsigned int> new_row_starts (n_macro_cells+1);
+      for (unsigned int cell=0; cell<n_macro_cells; ++cell)
+        {
+          new_row_starts[cell] = new_dof_indices.size();
+          if (index_storage_variants[cell] == full)
+            new_dof_indices.insert (new_dof_indices.end(), begin_indices(cell),
+                                    end_indices(cell));
+          else
+            {
+              const unsigned int n_dofs =
+                dofs_per_cell[cell_active_fe_index.empty() ? 0 :
+                              cell_active_fe_index[cell]];
+              for (unsigned int i=0; i<n_dofs; ++i)
+                for (unsigned int v=0; v<vectorization_length; ++v)
+                  new_dof_indices.push_back (compressed_dof_index(cell, v, i));
+            }
+        }
+      new_row_starts[n_macro_cells] = new_dof_indices.size();
+
+      for (unsigned int cell=0; cell<=n_macro_cells; ++cell)
+        row_starts[cell][0] = new_row_starts[cell];
+      dof_indices.swap (new_dof_indices);
+      index_storage_variants.clear();
+      dof_indices_contiguous.clear();
+    }
+
+
+
+    void
+    DoFInfo::compute_cell_loop_pre_post_lists (const SizeInfo &size_info)
+    {
+      Assert (vector_partitioner.get() != 0, ExcNotInitialized());
+      const unsigned int n_owned = vector_partitioner->local_size();
+
+      // the operations before and after the loop are run on blocks of
+      // degrees of freedom rather than individual entries in order to keep
+      // the lists short
+      const unsigned int dof_block_size = 64;
+      const unsigned int n_dof_blocks =
+        (n_owned + dof_block_size - 1) / dof_block_size;
+
+      // split the cells into chunks that touch around 8000 vector entries,
+      // without straddling the boundaries of the cells with ghosts where the
+      // loop waits for the data exchange
+      const unsigned int n_macro_cells = size_info.n_macro_cells;
+      const unsigned int entries_per_macro_cell =
+        n_macro_cells > 0 ? std::max(1U, row_length_indices(0)) : 1U;
+      const unsigned int chunk_size =
+        std::max(1U, 8192U / entries_per_macro_cell);
+      const unsigned int boundaries[3] = {size_info.boundary_cells_start,
+                                          size_info.boundary_cells_end,
+                                          n_macro_cells
+                                         };
+      cell_loop_chunks.clear();
+      cell_loop_chunks.push_back(0);
+      for (unsigned int b=0; b<3; ++b)
+        while (cell_loop_chunks.back() < boundaries[b])
+          cell_loop_chunks.push_back(std::min(cell_loop_chunks.back() + chunk_size,
+                                              boundaries[b]));
+      const unsigned int n_chunks = cell_loop_chunks.size() - 1;
+
+      // find the first and last chunk that accesses each block of degrees of
+      // freedom. Blocks not touched by any cell get the slot before and
+      // after the loop
+      std::vector<unsigned int> first_access (n_dof_blocks,
+                                              numbers::invalid_unsigned_int);
+      std::vector<unsigned int> last_access (n_dof_blocks,
+                                             numbers::invalid_unsigned_int);
+      for (unsigned int chunk=0; chunk<n_chunks; ++chunk)
+        for (unsigned int cell=cell_loop_chunks[chunk];
+             cell<cell_loop_chunks[chunk+1]; ++cell)
+          for (const unsigned int *dof = begin_indices(cell);
+               dof != end_indices(cell); ++dof)
+            if (*dof < n_owned)
+              {
+                const unsigned int block = *dof / dof_block_size;
+                if (first_access[block] == numbers::invalid_unsigned_int)
+                  first_access[block] = chunk;
+                last_access[block] = chunk;
+              }
+
+      // entries that are sent to other processors must be ready before the
+      // ghost exchange starts and receive contributions from other
+      // processors in the compress step, so they are processed before and
+      // after the loop
+      const std::vector<std::pair<unsigned int,unsigned int> > &import_indices =
+        vector_partitioner->import_indices();
+      for (unsigned int i=0; i<import_indices.size(); ++i)
+        for (unsigned int block=import_indices[i].first/dof_block_size;
+             block<(import_indices[i].second+dof_block_size-1)/dof_block_size;
+             ++block)
+          {
+            first_access[block] = numbers::invalid_unsigned_int;
+            last_access[block] = numbers::invalid_unsigned_int;
+          }
+
+      // collect the blocks into ranges for each slot. The slot zero in the
+      // pre list is before the loop, slot c+1 before chunk c. Slot c in the
+      // post list is after chunk c and slot n_chunks after the loop.
+      std::vector<std::vector<std::pair<unsigned int,unsigned int> > >
+      pre_ranges (n_chunks+1), post_ranges (n_chunks+1);
+      for (unsigned int block=0; block<n_dof_blocks; ++block)
+        {
+          const std::pair<unsigned int,unsigned int>
+          range (block*dof_block_size,
+                 std::min((block+1)*dof_block_size, n_owned));
+          const unsigned int pre_slot =
+            first_access[block] == numbers::invalid_unsigned_int ?
+            0 : first_access[block]+1;
+          const unsigned int post_slot =
+            last_access[block] == numbers::invalid_unsigned_int ?
+            n_chunks : last_access[block];
+          if (!pre_ranges[pre_slot].empty() &&
+              pre_ranges[pre_slot].back().second == range.first)
+            pre_ranges[pre_slot].back().second = range.second;
+          else
+            pre_ranges[pre_slot].push_back(range);
+          if (!post_ranges[post_slot].empty() &&
+              post_ranges[post_slot].back().second == range.first)
+            post_ranges[post_slot].back().second = range.second;
+          else
+            post_ranges[post_slot].push_back(range);
+        }
+
+      cell_loop_pre_list_index.resize(n_chunks+2);
+      cell_loop_post_list_index.resize(n_chunks+2);
+      cell_loop_pre_list.clear();
+      cell_loop_post_list.clear();
+      cell_loop_pre_list_index[0] = 0;
+      cell_loop_post_list_index[0] = 0;
+      for (unsigned int slot=0; slot<=n_chunks; ++slot)
+        {
+          cell_loop_pre_list.insert(cell_loop_pre_list.end(),
+                                    pre_ranges[slot].begin(),
+                                    pre_ranges[slot].end());
+          cell_loop_pre_list_index[slot+1] = cell_loop_pre_list.size();
+          cell_loop_post_list.insert(cell_loop_post_list.end(),
+                                     post_ranges[slot].begin(),
+                                     post_ranges[slot].end());
+          cell_loop_post_list_index[slot+1] = cell_loop_post_list.size();
+        }
     }
 
 
@@ -1928,10 +2290,18 @@ not_connect:
       std::size_t memory = sizeof(*this);
       memory += (row_starts.capacity()*sizeof(std_cxx11::array<unsigned int,3>));
       memory += MemoryConsumption::memory_consumption (dof_indices);
+      memory += MemoryConsumption::memory_consumption (index_storage_variants);
+      memory += MemoryConsumption::memory_consumption (dof_indices_contiguous);
       memory += MemoryConsumption::memory_consumption (row_starts_plain_indices);
       memory += MemoryConsumption::memory_consumption (plain_dof_indices);
+      memory += MemoryConsumption::memory_consumption (dof_indices_ghost_cells);
       memory += MemoryConsumption::memory_consumption (constraint_indicator);
       memory += MemoryConsumption::memory_consumption (*vector_partitioner);
+      memory += MemoryConsumption::memory_consumption (cell_loop_chunks);
+      memory += MemoryConsumption::memory_consumption (cell_loop_pre_list_index);
+      memory += MemoryConsumption::memory_consumption (cell_loop_pre_list);
+      memory += MemoryConsumption::memory_consumption (cell_loop_post_list_index);
+      memory += MemoryConsumption::memory_consumption (cell_loop_post_list);
       return memory;
     }
 
@@ -1947,7 +2317,9 @@ not_connect:
       (out, (row_starts.capacity()*sizeof(std_cxx11::array<unsigned int, 3>)));
       out << "       Memory dof indices:           ";
       size_info.print_memory_statistics
-      (out, MemoryConsumption::memory_consumption (dof_indices));
+      (out, MemoryConsumption::memory_consumption (dof_indices)+
+       MemoryConsumption::memory_consumption (index_storage_variants)+
+       MemoryConsumption::memory_consumption (dof_indices_contiguous));
       out << "       Memory constraint indicators: ";
       size_info.print_memory_statistics
       (out, MemoryConsumption::memory_consumption (constraint_indicator));
@@ -1972,6 +2344,18 @@ not_connect:
       for (unsigned int row=0 ; row<n_rows ; ++row)
         {
           out << "Entries row " << row << ": ";
+          if (!index_storage_variants.empty() &&
+              index_storage_variants[row] != full)
+            {
+              const unsigned int n_dofs =
+                dofs_per_cell[cell_active_fe_index.empty() ? 0 :
+                              cell_active_fe_index[row]];
+              for (unsigned int i=0; i<n_dofs; ++i)
+                for (unsigned int v=0; v<vectorization_length; ++v)
+                  out << compressed_dof_index(row, v, i) << " ";
+              out << std::endl;
+              continue;
+            }
           const unsigned int *glob_indices = begin_indices(row),
                               *end_row = end_indices(row);
           unsigned int index = 0;
@@ -0,0 +1,211 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+#ifndef dealii__matrix_free_face_info_h
+#define dealii__matrix_free_face_info_h
+
+
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/memory_consumption.h>
+#include <deal.II/base/types.h>
+
+#include <vector>
+
+
+DEAL_II_NAMESPACE_OPEN
+
+
+namespace internal
+{
+  namespace MatrixFreeFunctions
+  {
+    /**
+     * Data type for information about the batches built for vectorization of
+     * face integrals. The setup of the batches for faces is independent of
+     * the cells, and thus, we must store the relation to the cell indexing
+     * for accessing the degrees of freedom.
+     *
+     * Interior faces are stored by the two adjacent cells, which we label as
+     * "interior" and "exterior" side of the face. Vectorized face integrals
+     * need to extract the values from the vectorized cell arrays on the two
+     * sides. The cells are identified by the index <tt>macro_cell *
+     * vectorization_width + lane</tt> into the cell numbering of MatrixFree,
+     * i.e., the index of the cell in MatrixFree::get_cell_iterator() if
+     * split into macro cell and lane. Cells that are located on a remote
+     * processor (ghost cells) are numbered starting at
+     * <tt>n_macro_cells*vectorization_width</tt>. Lanes of the face batch
+     * that are not filled are marked by numbers::invalid_unsigned_int.
+     *
+     * Boundary faces only fill the @p cells_interior field.
+     *
+     * On faces with hanging nodes, the finer of the two cells is always
+     * placed on the interior side, and the coarser cell on the exterior side
+     * only sees the part of its face given by @p subface_index.
+     */
+    template <int vectorization_width>
+    struct FaceToCellTopology
+    {
+      /**
+       * Indices of the cells on the logical "interior" side of the faces in
+       * the current batch, i.e., the side from which the normal vector points
+       * outwards.
+       */
+      unsigned int cells_interior[vectorization_width];
+
+      /**
+       * Indices of the cells on the logical "exterior" side of the faces in
+       * the current batch, i.e., the side the normal vector points into.
+       */
+      unsigned int cells_exterior[vectorization_width];
+
+      /**
+       * Index of the face between 0 and GeometryInfo::faces_per_cell within
+       * the cells on the "interior" side of the faces.
+       */
+      unsigned char interior_face_no;
+
+      /**
+       * Index of the face between 0 and GeometryInfo::faces_per_cell within
+       * the cells on the "exterior" side of the faces. For a boundary face,
+       * this data field is not used.
+       */
+      unsigned char exterior_face_no;
+
+      /**
+       * For boundary faces, the boundary id of all faces in the batch.
+       */
+      types::boundary_id boundary_id;
+
+      /**
+       * For faces with hanging nodes, the position of the face of the
+       * interior cells within the face of the (coarser) exterior cells. Bit
+       * zero refers to the first tangential direction of the face and bit
+       * one to the second one, with the tangential directions enumerated in
+       * increasing order of the coordinate directions as in FEFaceEvaluation.
+       * A set bit denotes the upper half of the face in that direction. For
+       * regular faces, this field is numbers::invalid_unsigned_int.
+       */
+      unsigned int subface_index;
+
+      /**
+       * Return the memory consumption of the present data structure.
+       */
+      std::size_t memory_consumption() const
+      {
+        return sizeof(*this);
+      }
+    };
+
+
+
+    /**
+     * A data structure that holds the connectivity between the faces and the
+     * cells of a MatrixFree object. The faces are stored in three groups:
+     * First come the interior faces whose adjacent cells are owned by the
+     * current processor and do not touch any ghost degrees of freedom, then
+     * the interior faces that need data from remote processors (a ghost cell
+     * on the exterior side or a cell with ghost degrees of freedom), and
+     * finally the faces at the boundary of the domain. This ordering allows
+     * the loops over faces to overlap the import of ghost data with work on
+     * the first group.
+     */
+    template <int vectorization_width>
+    struct FaceInfo
+    {
+      /**
+       * Constructor.
+       */
+      FaceInfo ();
+
+      /**
+       * Clear all data fields to be in a state similar to after having
+       * called the default constructor.
+       */
+      void clear();
+
+      /**
+       * Return the memory consumption of the present data structure.
+       */
+      std::size_t memory_consumption() const;
+
+      /**
+       * Vectorized storage of the faces, linking to the adjacent cells in the
+       * vectorized cell storage.
+       */
+      std::vector<FaceToCellTopology<vectorization_width> > faces;
+
+      /**
+       * The number of batches of interior faces that can be processed
+       * without access to data from remote processors.
+       */
+      unsigned int n_inner_face_batches;
+
+      /**
+       * The number of batches of interior faces that need data from remote
+       * processors. They are placed after the first @p n_inner_face_batches
+       * entries in @p faces.
+       */
+      unsigned int n_ghost_inner_face_batches;
+
+      /**
+       * The number of batches of faces at the boundary of the domain. They
+       * are placed at the end of the @p faces field.
+       */
+      unsigned int n_boundary_face_batches;
+    };
+
+
+
+    /* ------------------- inline functions ----------------------------- */
+
+    template <int vectorization_width>
+    inline
+    FaceInfo<vectorization_width>::FaceInfo ()
+      :
+      n_inner_face_batches (0),
+      n_ghost_inner_face_batches (0),
+      n_boundary_face_batches (0)
+    {}
+
+
+
+    template <int vectorization_width>
+    inline
+    void
+    FaceInfo<vectorization_width>::clear ()
+    {
+      faces.clear();
+      n_inner_face_batches = 0;
+      n_ghost_inner_face_batches = 0;
+      n_boundary_face_batches = 0;
+    }
+
+
+
+    template <int vectorization_width>
+    inline
+    std::size_t
+    FaceInfo<vectorization_width>::memory_consumption () const
+    {
+      return sizeof(*this) + MemoryConsumption::memory_consumption(faces);
+    }
+
+  } // end of namespace MatrixFreeFunctions
+} // end of namespace internal
+
+DEAL_II_NAMESPACE_CLOSE
+
+#endif
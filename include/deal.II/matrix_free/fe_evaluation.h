@@ -34,6 +34,7 @@ DEAL_II_NAMESPACE_OPEN
 
 
 // forward declarations
+template <typename> class Vector;
 namespace LinearAlgebra
 {
   namespace distributed
@@ -48,6 +49,8 @@ namespace internal
 
 template <int dim, int fe_degree, int n_q_points_1d = fe_degree+1,
           int n_components_ = 1, typename Number = double > class FEEvaluation;
+template <int dim, int fe_degree, int n_q_points_1d = fe_degree+1,
+          int n_components_ = 1, typename Number = double > class FEFaceEvaluation;
 
 
 /**
@@ -97,6 +100,26 @@ public:
    */
   void reinit (const unsigned int cell);
 
+  /**
+   * Initializes the operation pointer to the cell the object @p other has
+   * last been initialized to by the reinit() function taking a cell index.
+   * Rather than looking up the geometry data in the MappingInfo object
+   * again, the pointers to the geometry of @p other are shared. This is
+   * meant for systems where several FEEvaluation objects on different
+   * DoFHandler objects of the same MatrixFree object, such as the velocity
+   * and pressure of a Taylor-Hood discretization, work on the same batch of
+   * cells within one cell_loop. If the Jacobians are computed on the fly
+   * (see MatrixFree::AdditionalData::compute_jacobians_on_the_fly), they
+   * are only computed once for @p other, and this object points into the
+   * storage of @p other. In that case, this object can only be used as
+   * long as @p other is not re-initialized or destroyed.
+   *
+   * Both objects must be based on the same MatrixFree object and the same
+   * quadrature formula.
+   */
+  template <int n_components_other>
+  void reinit (const FEEvaluationBase<dim,n_components_other,Number> &other);
+
   /**
    * Initialize the data to the current cell using a TriaIterator object as
    * usual in FEValues. The argument is either of type
@@ -816,6 +839,25 @@ protected:
    */
   const Tensor<1,(dim>1?dim*(dim-1)/2:1),Tensor<1,dim,VectorizedArray<Number> > > * jacobian_grad_upper;
 
+  /**
+   * Storage for the inverse Jacobians on a general cell in case the
+   * MatrixFree object was set up with
+   * MatrixFree::AdditionalData::compute_jacobians_on_the_fly. The pointer
+   * @p jacobian then points into this field.
+   */
+  AlignedVector<Tensor<2,dim,VectorizedArray<Number> > > jacobians_on_the_fly;
+
+  /**
+   * Storage for the JxW values on a general cell in case the Jacobians are
+   * computed on the fly, pointed to by @p J_value.
+   */
+  AlignedVector<VectorizedArray<Number> > JxW_values_on_the_fly;
+
+  /**
+   * Scratch data for computing the Jacobians on the fly.
+   */
+  AlignedVector<VectorizedArray<Number> > scratch_data_on_the_fly;
+
   /**
    * After a call to reinit(), stores the number of the cell we are currently
    * working with.
@@ -1407,6 +1449,96 @@ protected:
 
 
 
+namespace internal
+{
+  /**
+   * A helper class that provides the sizes of the tensor-product data
+   * fields of FEEvaluation, i.e., the number of quadrature points and the
+   * number of degrees of freedom in the full tensor product. For a
+   * polynomial degree given as template argument, the sizes are compile-time
+   * constants.
+   */
+  template <int dim, int fe_degree, int n_q_points_1d>
+  struct FEEvaluationSizes
+  {
+    static const unsigned int n_q_points = Utilities::fixed_int_power<n_q_points_1d,dim>::value;
+    static const unsigned int tensor_dofs_per_cell = Utilities::fixed_int_power<fe_degree+1,dim>::value;
+
+    template <typename Number>
+    FEEvaluationSizes (const MatrixFreeFunctions::ShapeInfo<Number> &)
+    {}
+  };
+
+  template <int dim, int fe_degree, int n_q_points_1d>
+  const unsigned int FEEvaluationSizes<dim,fe_degree,n_q_points_1d>::n_q_points;
+
+  template <int dim, int fe_degree, int n_q_points_1d>
+  const unsigned int FEEvaluationSizes<dim,fe_degree,n_q_points_1d>::tensor_dofs_per_cell;
+
+  /**
+   * Specialization for the case <tt>fe_degree == -1</tt> where the
+   * polynomial degree and the number of quadrature points are only known at
+   * run time. The sizes are taken from the ShapeInfo object the FEEvaluation
+   * object is initialized with.
+   */
+  template <int dim, int n_q_points_1d>
+  struct FEEvaluationSizes<dim,-1,n_q_points_1d>
+  {
+    template <typename Number>
+    FEEvaluationSizes (const MatrixFreeFunctions::ShapeInfo<Number> &shape_info)
+      :
+      n_q_points (shape_info.n_q_points),
+      tensor_dofs_per_cell (Utilities::fixed_power<dim>(shape_info.fe_degree+1))
+    {}
+
+    const unsigned int n_q_points;
+    const unsigned int tensor_dofs_per_cell;
+  };
+
+  /**
+   * Evaluation and integration routines for FEEvaluation objects with
+   * polynomial degree selected at run time, i.e., <tt>fe_degree ==
+   * -1</tt>. The functions are compiled into the library. For the polynomial
+   * degrees 1 to 8 with <tt>n_q_points_1d = fe_degree+1</tt>, they dispatch
+   * to the same templated kernels that FEEvaluation uses for the respective
+   * template arguments. For other degrees and quadrature formulas, a generic
+   * implementation of the tensor product kernels with loop bounds given at
+   * run time is used.
+   *
+   * The arguments are the same as for FEEvaluationImpl, except for the
+   * number of components which is passed as an argument, and an array @p
+   * scratch_data of at least <tt>2 * max(n_dofs_1d, n_q_points_1d)^dim</tt>
+   * entries that the generic implementation uses for intermediate results.
+   */
+  template <int dim, typename Number>
+  struct FEEvaluationImplAnyDegree
+  {
+    static
+    void evaluate (const MatrixFreeFunctions::ShapeInfo<Number> &shape_info,
+                   const unsigned int       n_components,
+                   VectorizedArray<Number> *values_dofs[],
+                   VectorizedArray<Number> *values_quad[],
+                   VectorizedArray<Number> *gradients_quad[][dim],
+                   VectorizedArray<Number> *hessians_quad[][(dim*(dim+1))/2],
+                   VectorizedArray<Number> *scratch_data,
+                   const bool               evaluate_val,
+                   const bool               evaluate_grad,
+                   const bool               evaluate_lapl);
+
+    static
+    void integrate (const MatrixFreeFunctions::ShapeInfo<Number> &shape_info,
+                    const unsigned int       n_components,
+                    VectorizedArray<Number> *values_dofs[],
+                    VectorizedArray<Number> *values_quad[],
+                    VectorizedArray<Number> *gradients_quad[][dim],
+                    VectorizedArray<Number> *scratch_data,
+                    const bool               integrate_val,
+                    const bool               integrate_grad);
+  };
+}
+
+
+
 /**
  * The class that provides all functions necessary to evaluate functions at
  * quadrature points and cell integrations. In functionality, this class is
@@ -1626,10 +1758,10 @@ protected:
  * This class contains specialized evaluation routines for elements based on
  * tensor-product quadrature formulas and tensor-product-like shape functions,
  * including standard FE_Q or FE_DGQ elements and quadrature points symmetric
- * around 0.5 (like Gauss quadrature), FE_DGP elements based on truncated
- * tensor products as well as the faster case of Gauss-Lobatto elements with
- * Gauss-Lobatto quadrature which give diagonal mass matrices and quicker
- * evaluation internally. The main benefit of this class is the evaluation of
+ * around 0.5 (like Gauss quadrature), FE_DGP and FE_DGPMonomial elements
+ * based on truncated tensor products as well as the faster case of
+ * Gauss-Lobatto elements with Gauss-Lobatto quadrature which give diagonal
+ * mass matrices and quicker evaluation internally. The main benefit of this class is the evaluation of
  * all shape functions in all quadrature or integration over all shape
  * functions in <code>dim (fe_degree+1)<sup>dim+1</sup> </code> operations
  * instead of the slower <code> (fe_degree+1)<sup>2*dim</sup></code>
@@ -1808,10 +1940,33 @@ protected:
  * parallelism) are set, then the order is going to be the same because the
  * algorithm is deterministic.
  *
+ * <h3>Polynomial degree selected at run time</h3>
+ *
+ * The template arguments @p fe_degree and @p n_q_points_1d allow the
+ * compiler to unroll the loops of the sum factorization kernels, which is
+ * essential for performance. On the other hand, they force user code to be
+ * templated on the polynomial degree and instantiated for every degree that
+ * is to be supported at run time. As an alternative, the class can be used
+ * with <tt>fe_degree = -1</tt>, e.g. as <tt>FEEvaluation<dim,-1></tt>, in
+ * which case the polynomial degree and the number of quadrature points are
+ * taken from the finite element and quadrature formula stored in the
+ * MatrixFree object. The template argument @p n_q_points_1d is then ignored.
+ * In this mode, the evaluate() and integrate() calls are forwarded to
+ * precompiled kernels in the library: For polynomial degrees between 1 and 8
+ * with <tt>fe_degree+1</tt> quadrature points in 1D, the same templated
+ * kernels as for the respective fixed template arguments are used. For other
+ * combinations, a generic implementation with loop bounds given at run time
+ * is selected, which is considerably slower. The sizes @p n_q_points and @p
+ * tensor_dofs_per_cell are no compile-time constants in this mode, and the
+ * internal data fields are allocated on the heap when constructing the
+ * object. The run-time mode does not support hp adaptivity, i.e., different
+ * elements on different cells.
+ *
  * @tparam dim Dimension in which this class is to be used
  *
  * @tparam fe_degree Degree of the tensor product finite element with
- * fe_degree+1 degrees of freedom per coordinate direction
+ * fe_degree+1 degrees of freedom per coordinate direction, or -1 for
+ * selecting the degree at run time
  *
  * @tparam n_q_points_1d Number of points in the quadrature formula in 1D,
  * defaults to fe_degree+1
@@ -1828,17 +1983,19 @@ protected:
  */
 template <int dim, int fe_degree, int n_q_points_1d, int n_components_,
           typename Number >
-class FEEvaluation : public FEEvaluationAccess<dim,n_components_,Number>
+class FEEvaluation : public FEEvaluationAccess<dim,n_components_,Number>,
+  public internal::FEEvaluationSizes<dim,fe_degree,n_q_points_1d>
 {
 public:
   typedef FEEvaluationAccess<dim,n_components_,Number> BaseClass;
+  typedef internal::FEEvaluationSizes<dim,fe_degree,n_q_points_1d> SizesClass;
   typedef Number                            number_type;
   typedef typename BaseClass::value_type    value_type;
   typedef typename BaseClass::gradient_type gradient_type;
   static const unsigned int dimension     = dim;
   static const unsigned int n_components  = n_components_;
-  static const unsigned int n_q_points    = Utilities::fixed_int_power<n_q_points_1d,dim>::value;
-  static const unsigned int tensor_dofs_per_cell = Utilities::fixed_int_power<fe_degree+1,dim>::value;
+  using SizesClass::n_q_points;
+  using SizesClass::tensor_dofs_per_cell;
 
   /**
    * Constructor. Takes all data stored in MatrixFree. If applied to problems
@@ -1997,9 +2154,21 @@ public:
 
 private:
   /**
-   * Internally stored variables for the different data fields.
+   * Internally stored variables for the different data fields. In case the
+   * polynomial degree is selected at run time, the array only contains a
+   * single dummy entry per component and the data is stored in
+   * runtime_data_array instead.
+   */
+  VectorizedArray<Number> my_data_array[n_components*(Utilities::fixed_int_power<fe_degree+1,dim>::value+1+
+                                                      (dim*dim+2*dim+1)*
+                                                      Utilities::fixed_int_power<fe_degree==-1 ? 0 : n_q_points_1d,dim>::value)];
+
+  /**
+   * Storage for the data fields if the polynomial degree is selected at run
+   * time, including scratch space for the generic evaluation routines. Empty
+   * otherwise.
    */
-  VectorizedArray<Number> my_data_array[n_components*(tensor_dofs_per_cell+1+(dim*dim+2*dim+1)*n_q_points)];
+  AlignedVector<VectorizedArray<Number> > runtime_data_array;
 
   /**
    * Checks if the template arguments regarding degree of the element
@@ -2012,6 +2181,19 @@ private:
    */
   void set_data_pointers();
 
+  /**
+   * Select the evaluate and integrate functions for the element type of the
+   * current element with the polynomial degree given as template argument.
+   */
+  void set_function_pointers(const internal::bool2type<false>);
+
+  /**
+   * Version of set_function_pointers() for the polynomial degree selected at
+   * run time where the precompiled functions of FEEvaluationImplAnyDegree
+   * are called directly from evaluate() and integrate().
+   */
+  void set_function_pointers(const internal::bool2type<true>);
+
   /**
    * Function pointer for the evaluate function
    */
@@ -2036,6 +2218,227 @@ private:
 };
 
 
+/**
+ * The class that provides all functions necessary to evaluate functions at
+ * quadrature points on faces and to integrate them, in analogy to what
+ * FEEvaluation does for cells. The class is designed for face integrals as
+ * they appear in discontinuous Galerkin methods, where the solution from
+ * both sides of a face is combined into a numerical flux. One object of
+ * this class is associated with one of the two sides of a face: The
+ * "interior" side is the side from which the normal vector points outwards,
+ * and the "exterior" side is the cell on the other side of the face. The
+ * class is used within the face operations of MatrixFree::loop(), where the
+ * argument passed to reinit() is the index of a batch of faces.
+ *
+ * The evaluation on faces uses the tensor product structure of the shape
+ * functions: First, the values and normal derivatives of the cell degrees of
+ * freedom are interpolated to the face by one-dimensional kernels in normal
+ * direction. Then, the resulting polynomials on the face are evaluated by
+ * sum factorization in the <tt>dim-1</tt> tangential directions. The
+ * integration performs the transpose operations.
+ *
+ * The derived quantities at quadrature points, such as get_value() or
+ * get_gradient(), are inherited from FEEvaluationAccess and refer to the
+ * cell on the side selected at construction. In addition, the class provides
+ * access to the normal vector and the normal derivative.
+ *
+ * On faces with hanging nodes, the finer cell is always on the interior
+ * side. The exterior side evaluates the coarser cell on the part of its face
+ * adjacent to the finer cell.
+ *
+ * Face integrals are currently restricted to meshes where the two cells
+ * adjacent to a face have matching orientation and where hanging nodes stem
+ * from isotropic refinement, and to elements with full tensor product shape
+ * functions (i.e., not FE_DGP or FE_Q_DG0).
+ *
+ * @tparam dim Dimension in which this class is to be used
+ *
+ * @tparam fe_degree Degree of the tensor product finite element with
+ * fe_degree+1 degrees of freedom per coordinate direction
+ *
+ * @tparam n_q_points_1d Number of points in the quadrature formula in 1D,
+ * defaults to fe_degree+1
+ *
+ * @tparam n_components Number of vector components. Defaults to 1.
+ *
+ * @tparam Number Number format, usually @p double or @p float. Defaults to @p
+ * double
+ */
+template <int dim, int fe_degree, int n_q_points_1d, int n_components_,
+          typename Number >
+class FEFaceEvaluation : public FEEvaluationAccess<dim,n_components_,Number>
+{
+public:
+  typedef FEEvaluationAccess<dim,n_components_,Number> BaseClass;
+  typedef Number                            number_type;
+  typedef typename BaseClass::value_type    value_type;
+  typedef typename BaseClass::gradient_type gradient_type;
+  static const unsigned int dimension     = dim;
+  static const unsigned int n_components  = n_components_;
+  static const unsigned int n_q_points    = Utilities::fixed_int_power<n_q_points_1d,dim-1>::value;
+  static const unsigned int tensor_dofs_per_cell = Utilities::fixed_int_power<fe_degree+1,dim>::value;
+
+  /**
+   * Constructor. Takes all data stored in MatrixFree. The argument @p
+   * is_interior_face selects which of the two cells adjacent to a face is
+   * represented by this object. The arguments @p fe_no and @p quad_no select
+   * the DoFHandler and quadrature formula in case several have been given to
+   * the MatrixFree object. The face quadrature formula is the tensor product
+   * of the one-dimensional formula @p quad_no in the <tt>dim-1</tt>
+   * tangential directions.
+   */
+  FEFaceEvaluation (const MatrixFree<dim,Number> &matrix_free,
+                    const bool                    is_interior_face = true,
+                    const unsigned int            fe_no   = 0,
+                    const unsigned int            quad_no = 0);
+
+  /**
+   * Initializes the operation pointer to the current batch of faces. The
+   * index runs between zero and MatrixFree::n_inner_face_batches() for
+   * interior faces and between MatrixFree::n_inner_face_batches() and
+   * MatrixFree::n_inner_face_batches() +
+   * MatrixFree::n_boundary_face_batches() for boundary faces. On boundary
+   * faces, only objects representing the interior side may be used.
+   */
+  void reinit (const unsigned int face_batch_number);
+
+  /**
+   * Reads the values of the degrees of freedom of the cells adjacent to the
+   * current batch of faces on the side selected at construction from the
+   * given vector. For cells located on remote processors, the vector must
+   * have its ghost values updated, which is done automatically within
+   * MatrixFree::loop(). Constraints on the cells are resolved as in
+   * FEEvaluationBase::read_dof_values(), except for cells on remote
+   * processors where the plain indices are used.
+   *
+   * If the given vector template class is a block vector (determined
+   * through the template function 'IsBlockVector<VectorType>::value', which
+   * checks for vectors derived from dealii::BlockVectorBase), this function
+   * reads @p n_components blocks from the block vector starting at the index
+   * @p first_index. For non-block vectors, @p first_index is ignored.
+   */
+  template <typename VectorType>
+  void read_dof_values (const VectorType &src,
+                        const unsigned int first_index = 0);
+
+  /**
+   * Takes the values of the degrees of freedom stored internally and sums
+   * them into the vector @p dst, in analogy to
+   * FEEvaluationBase::distribute_local_to_global(). Contributions to cells
+   * on remote processors are placed into the ghost entries of @p dst and
+   * need to be sent to the owner by a compress() operation, which is done
+   * automatically within MatrixFree::loop().
+   */
+  template <typename VectorType>
+  void distribute_local_to_global (VectorType        &dst,
+                                   const unsigned int first_index = 0) const;
+
+  /**
+   * Evaluates the function values and/or the gradients of the FE function
+   * given at the DoF values in the input vector at the quadrature points on
+   * the face. The gradient contains both the tangential and the normal
+   * components.
+   */
+  void evaluate (const bool evaluate_val,
+                 const bool evaluate_grad);
+
+  /**
+   * This function takes the values and/or gradients that are stored on
+   * quadrature points of the face, tests them by all the basis
+   * functions/gradients of the cell and performs the face integration. Note
+   * that the result overwrites the degrees of freedom of the cell.
+   */
+  void integrate (const bool integrate_val,
+                  const bool integrate_grad);
+
+  /**
+   * Return the q-th quadrature point on the face stored in MappingInfo.
+   * Requires update_quadrature_points in the face flags of
+   * MatrixFree::AdditionalData.
+   */
+  Point<dim,VectorizedArray<Number> >
+  quadrature_point (const unsigned int q_point) const;
+
+  /**
+   * Return the unit normal vector at the given quadrature point. The normal
+   * vector points from the interior to the exterior side of the face for
+   * both objects adjacent to a face.
+   */
+  Tensor<1,dim,VectorizedArray<Number> >
+  get_normal_vector (const unsigned int q_point) const;
+
+  /**
+   * Return the derivative of the finite element function in direction of
+   * the normal vector returned by get_normal_vector() at the given
+   * quadrature point.
+   */
+  value_type get_normal_derivative (const unsigned int q_point) const;
+
+  /**
+   * Write a contribution that is tested by the derivative of the test
+   * function in direction of the normal vector at the given quadrature
+   * point. This function sets the gradient data at the quadrature point,
+   * overwriting data previously submitted by submit_gradient().
+   */
+  void submit_normal_derivative (const value_type   grad_in,
+                                 const unsigned int q_point);
+
+  /**
+   * Return the boundary id of the faces in the current batch. For interior
+   * faces, numbers::internal_face_boundary_id is returned.
+   */
+  types::boundary_id boundary_id () const;
+
+  /**
+   * The number of scalar degrees of freedom on the cell.
+   */
+  const unsigned int dofs_per_cell;
+
+private:
+  /**
+   * Internally stored variables for the different data fields.
+   */
+  VectorizedArray<Number> my_data_array[n_components*(tensor_dofs_per_cell+(dim+1)*n_q_points)];
+
+  /**
+   * Runs the given vector operation on the degrees of freedom of all cells
+   * adjacent to the current batch of faces, processing one lane at a time.
+   */
+  template<typename VectorType, typename VectorOperation>
+  void read_write_operation_face (const VectorOperation &operation,
+                                  VectorType            *vectors[]) const;
+
+  /**
+   * Set the pointers of the base class to my_data_array.
+   */
+  void set_data_pointers();
+
+  /**
+   * Stores whether the present object represents the interior or exterior
+   * side of faces.
+   */
+  const bool is_interior_face;
+
+  /**
+   * The face index within the cells of the current batch of faces.
+   */
+  unsigned int face_no;
+
+  /**
+   * The position of the current batch of faces within the faces of the
+   * cells on the exterior side of faces with hanging nodes, see
+   * FaceToCellTopology::subface_index. Set to numbers::invalid_unsigned_int
+   * for regular faces and on the interior side.
+   */
+  unsigned int subface_index;
+
+  /**
+   * A pointer to the normal vectors of the current batch of faces.
+   */
+  const Tensor<1,dim,VectorizedArray<Number> > *normal_vectors;
+};
+
+
 
 namespace internal
 {
@@ -2370,6 +2773,20 @@ FEEvaluationBase<dim,n_components_,Number>::reinit (const unsigned int cell_in)
       jacobian  = &mapping_info->affine_data[cell_data_number].first;
       J_value   = &mapping_info->affine_data[cell_data_number].second;
     }
+  else if (mapping_info->jacobians_on_the_fly == true)
+    {
+      const unsigned int n_q_points =
+        mapping_info->mapping_data_gen[quad_no].n_q_points[active_quad_index];
+      jacobians_on_the_fly.resize(n_q_points);
+      JxW_values_on_the_fly.resize(n_q_points);
+      mapping_info->compute_jacobians_on_the_fly(cell_data_number, quad_no,
+                                                 active_quad_index,
+                                                 scratch_data_on_the_fly,
+                                                 jacobians_on_the_fly.begin(),
+                                                 JxW_values_on_the_fly.begin());
+      jacobian = jacobians_on_the_fly.begin();
+      J_value = JxW_values_on_the_fly.begin();
+    }
   else
     {
       const unsigned int rowstart = mapping_info->
@@ -2408,6 +2825,47 @@ FEEvaluationBase<dim,n_components_,Number>::reinit (const unsigned int cell_in)
 
 
 
+template <int dim, int n_components_, typename Number>
+template <int n_components_other>
+inline
+void
+FEEvaluationBase<dim,n_components_,Number>
+::reinit (const FEEvaluationBase<dim,n_components_other,Number> &other)
+{
+  Assert (mapped_geometry == 0 && other.mapped_geometry == 0,
+          ExcMessage("FEEvaluation was initialized without a matrix-free object."
+                     " Sharing the geometry is not possible"));
+  Assert (matrix_info == other.matrix_info,
+          ExcMessage("The two FEEvaluation objects must be based on the same "
+                     "MatrixFree object"));
+  Assert (quad_no == other.quad_no && active_quad_index == other.active_quad_index,
+          ExcMessage("The two FEEvaluation objects must use the same "
+                     "quadrature formula"));
+  Assert (other.cell != numbers::invalid_unsigned_int, ExcNotInitialized());
+  AssertIndexRange (other.cell, dof_info->row_starts.size()-1);
+  AssertDimension (((dof_info->cell_active_fe_index.size() > 0) ?
+                    dof_info->cell_active_fe_index[other.cell] : 0),
+                   active_fe_index);
+  cell                = other.cell;
+  cell_type           = other.cell_type;
+  cell_data_number    = other.cell_data_number;
+  quadrature_points   = other.quadrature_points;
+  cartesian_data      = other.cartesian_data;
+  jacobian            = other.jacobian;
+  J_value             = other.J_value;
+  jacobian_grad       = other.jacobian_grad;
+  jacobian_grad_upper = other.jacobian_grad_upper;
+
+#ifdef DEBUG
+  dof_values_initialized      = false;
+  values_quad_initialized     = false;
+  gradients_quad_initialized  = false;
+  hessians_quad_initialized   = false;
+#endif
+}
+
+
+
 template <int dim, int n_components_, typename Number>
 template <typename DoFHandlerType, bool level_dof_access>
 inline
@@ -2577,6 +3035,41 @@ namespace internal
 
 
 
+  // pointer to the vector entries in the MPI-local index space used by
+  // DoFInfo for vectors that store them contiguously with the same number
+  // type as FEEvaluation, as needed for the vectorized access of the
+  // compressed index storage. The null pointer for all other vectors selects
+  // the access through vector_access.
+  template <typename Number, typename VectorType>
+  inline
+  Number *
+  vector_data_pointer (VectorType &)
+  {
+    return 0;
+  }
+
+
+
+  template <typename Number>
+  inline
+  Number *
+  vector_data_pointer (dealii::Vector<Number> &vec)
+  {
+    return vec.begin();
+  }
+
+
+
+  template <typename Number>
+  inline
+  Number *
+  vector_data_pointer (LinearAlgebra::distributed::Vector<Number> &vec)
+  {
+    return vec.begin();
+  }
+
+
+
   // this is to make sure that the parallel partitioning in the
   // LinearAlgebra::distributed::Vector is really the same as stored in
   // MatrixFree
@@ -2651,6 +3144,24 @@ namespace internal
     {
       res = Number();
     }
+
+    // vector entries stored with the lanes running fastest
+    void process_dofs_vectorized (const unsigned int       n_entries,
+                                  Number                  *vec_ptr,
+                                  VectorizedArray<Number> *res) const
+    {
+      for (unsigned int i=0; i<n_entries; ++i)
+        res[i].load(vec_ptr + i*VectorizedArray<Number>::n_array_elements);
+    }
+
+    // vector entries of each lane in a contiguous range
+    void process_dofs_vectorized_transpose (const unsigned int       n_entries,
+                                            Number                  *vec_ptr,
+                                            const unsigned int      *offsets,
+                                            VectorizedArray<Number> *res) const
+    {
+      vectorized_load_and_transpose (n_entries, vec_ptr, offsets, res);
+    }
   };
 
   // A class to use the same code to read from and write to vector
@@ -2696,6 +3207,27 @@ namespace internal
     void process_empty (Number &) const
     {
     }
+
+    void process_dofs_vectorized (const unsigned int       n_entries,
+                                  Number                  *vec_ptr,
+                                  VectorizedArray<Number> *res) const
+    {
+      for (unsigned int i=0; i<n_entries; ++i)
+        {
+          VectorizedArray<Number> tmp;
+          tmp.load(vec_ptr + i*VectorizedArray<Number>::n_array_elements);
+          tmp += res[i];
+          tmp.store(vec_ptr + i*VectorizedArray<Number>::n_array_elements);
+        }
+    }
+
+    void process_dofs_vectorized_transpose (const unsigned int       n_entries,
+                                            Number                  *vec_ptr,
+                                            const unsigned int      *offsets,
+                                            VectorizedArray<Number> *res) const
+    {
+      vectorized_transpose_and_store (true, n_entries, res, offsets, vec_ptr);
+    }
   };
 
 
@@ -2740,6 +3272,22 @@ namespace internal
     void process_empty (Number &) const
     {
     }
+
+    void process_dofs_vectorized (const unsigned int       n_entries,
+                                  Number                  *vec_ptr,
+                                  VectorizedArray<Number> *res) const
+    {
+      for (unsigned int i=0; i<n_entries; ++i)
+        res[i].store(vec_ptr + i*VectorizedArray<Number>::n_array_elements);
+    }
+
+    void process_dofs_vectorized_transpose (const unsigned int       n_entries,
+                                            Number                  *vec_ptr,
+                                            const unsigned int      *offsets,
+                                            VectorizedArray<Number> *res) const
+    {
+      vectorized_transpose_and_store (false, n_entries, res, offsets, vec_ptr);
+    }
   };
 
   // allows to select between block vectors and non-block vectors, which
@@ -2816,6 +3364,50 @@ FEEvaluationBase<dim,n_components_,Number>
           ExcNotInitialized());
   Assert (cell != numbers::invalid_unsigned_int, ExcNotInitialized());
 
+  // Case 2: the degrees of freedom of the cells in the macro cell are
+  // contiguous in the vector and only the start indices of the lanes are
+  // stored. There are no constraints on such cells, so access the vector
+  // entries directly by vector loads and stores, possibly combined with a
+  // transpose, rather than entry by entry
+  if (!dof_info->index_storage_variants.empty() &&
+      dof_info->index_storage_variants[cell] !=
+      internal::MatrixFreeFunctions::DoFInfo::full)
+    {
+      const unsigned int n_lanes = VectorizedArray<Number>::n_array_elements;
+      AssertDimension (dof_info->vectorization_length, n_lanes);
+      const bool interleaved = dof_info->index_storage_variants[cell] ==
+                               internal::MatrixFreeFunctions::DoFInfo::interleaved;
+      const unsigned int *offsets =
+        &dof_info->dof_indices_contiguous[cell*n_lanes];
+
+      // for vector-valued elements in one vector, the components follow
+      // each other both in the vector and in values_dofs
+      const unsigned int n_vectors = n_fe_components == 1 ? n_components : 1;
+      const unsigned int n_entries = n_fe_components == 1 ?
+                                     this->data->dofs_per_cell :
+                                     this->data->dofs_per_cell * n_components;
+      for (unsigned int comp=0; comp<n_vectors; ++comp)
+        {
+          internal::check_vector_compatibility (*src[comp], *dof_info);
+          VectorizedArray<Number> *local_data = values_dofs[comp];
+          Number *vector_data =
+            internal::vector_data_pointer<Number> (*src[comp]);
+          if (vector_data != 0 && interleaved)
+            operation.process_dofs_vectorized (n_entries, vector_data+offsets[0],
+                                               local_data);
+          else if (vector_data != 0)
+            operation.process_dofs_vectorized_transpose (n_entries, vector_data,
+                                                         offsets, local_data);
+          else
+            for (unsigned int i=0; i<n_entries; ++i)
+              for (unsigned int v=0; v<n_lanes; ++v)
+                operation.process_dof (interleaved ? offsets[v]+i*n_lanes :
+                                       offsets[v]+i, *src[comp],
+                                       local_data[i][v]);
+        }
+      return;
+    }
+
   // loop over all local dofs. ind_local holds local number on cell, index
   // iterates over the elements of index_local_to_global and dof_indices
   // points to the global indices stored in index_local_to_global
@@ -3436,6 +4028,17 @@ FEEvaluationBase<dim,n_components_,Number>
   Assert (cell != numbers::invalid_unsigned_int, ExcNotInitialized());
   Assert (dof_info->store_plain_indices == true, ExcNotInitialized());
 
+  // cells with compressed index storage have no constraints, so the plain
+  // values are the same as the ones read with constraints
+  if (!dof_info->index_storage_variants.empty() &&
+      dof_info->index_storage_variants[cell] !=
+      internal::MatrixFreeFunctions::DoFInfo::full)
+    {
+      internal::VectorReader<Number> reader;
+      read_write_operation (reader, src);
+      return;
+    }
+
   // loop over all local dofs. ind_local holds local number on cell, index
   // iterates over the elements of index_local_to_global and dof_indices
   // points to the global indices stored in index_local_to_global
@@ -6180,7 +6783,153 @@ namespace internal
 
 
 
-  // This struct performs the evaluation of function values, gradients and
+  // This struct performs the evaluation of function values and gradients for
+  // symmetric tensor-product elements with as many quadrature points as there
+  // are degrees of freedom per direction. The values are first interpolated
+  // to the quadrature points, and the gradients are then computed from the
+  // values at the quadrature points by the derivative matrix of the Lagrange
+  // polynomials in the quadrature points (collocation derivative). This
+  // needs 2*dim one-dimensional sweeps as compared to dim*(dim+3)/2 sweeps in
+  // the general evaluation path. The integration performs the transpose
+  // operations.
+  template <int dim, int fe_degree, int n_components, typename Number>
+  struct FEEvaluationImplTransformToCollocation
+  {
+    static
+    void evaluate (const MatrixFreeFunctions::ShapeInfo<Number> &shape_info,
+                   VectorizedArray<Number> *values_dofs[],
+                   VectorizedArray<Number> *values_quad[],
+                   VectorizedArray<Number> *gradients_quad[][dim]);
+
+    static
+    void integrate (const MatrixFreeFunctions::ShapeInfo<Number> &shape_info,
+                    VectorizedArray<Number> *values_dofs[],
+                    VectorizedArray<Number> *values_quad[],
+                    VectorizedArray<Number> *gradients_quad[][dim],
+                    const bool               integrate_val);
+  };
+
+
+
+  template <int dim, int fe_degree, int n_components, typename Number>
+  inline
+  void
+  FEEvaluationImplTransformToCollocation<dim,fe_degree,n_components,Number>
+  ::evaluate (const MatrixFreeFunctions::ShapeInfo<Number> &shape_info,
+              VectorizedArray<Number> *values_dofs[],
+              VectorizedArray<Number> *values_quad[],
+              VectorizedArray<Number> *gradients_quad[][dim])
+  {
+    typedef EvaluatorTensorProduct<evaluate_evenodd, dim, fe_degree, fe_degree+1,
+            VectorizedArray<Number> > Eval;
+    Eval eval (shape_info.shape_val_evenodd,
+               shape_info.shape_gra_collocation_evenodd,
+               shape_info.shape_hes_evenodd);
+
+    const unsigned int d1 = dim>1?1:0;
+    const unsigned int d2 = dim>2?2:0;
+
+    for (unsigned int c=0; c<n_components; c++)
+      {
+        VectorizedArray<Number> temp1[Eval::dofs_per_cell];
+        VectorizedArray<Number> temp2[Eval::dofs_per_cell];
+
+        // interpolate to the quadrature points
+        switch (dim)
+          {
+          case 1:
+            eval.template values<0,true,false> (values_dofs[c], values_quad[c]);
+            break;
+          case 2:
+            eval.template values<0,true,false> (values_dofs[c], temp1);
+            eval.template values<1,true,false> (temp1, values_quad[c]);
+            break;
+          case 3:
+            eval.template values<0,true,false> (values_dofs[c], temp1);
+            eval.template values<1,true,false> (temp1, temp2);
+            eval.template values<2,true,false> (temp2, values_quad[c]);
+            break;
+          default:
+            AssertThrow(false, ExcNotImplemented());
+          }
+
+        // apply the collocation derivative in each direction
+        eval.template gradients<0,true,false> (values_quad[c],
+                                               gradients_quad[c][0]);
+        if (dim > 1)
+          eval.template gradients<d1,true,false> (values_quad[c],
+                                                  gradients_quad[c][d1]);
+        if (dim > 2)
+          eval.template gradients<d2,true,false> (values_quad[c],
+                                                  gradients_quad[c][d2]);
+      }
+  }
+
+
+
+  template <int dim, int fe_degree, int n_components, typename Number>
+  inline
+  void
+  FEEvaluationImplTransformToCollocation<dim,fe_degree,n_components,Number>
+  ::integrate (const MatrixFreeFunctions::ShapeInfo<Number> &shape_info,
+               VectorizedArray<Number> *values_dofs[],
+               VectorizedArray<Number> *values_quad[],
+               VectorizedArray<Number> *gradients_quad[][dim],
+               const bool               integrate_val)
+  {
+    typedef EvaluatorTensorProduct<evaluate_evenodd, dim, fe_degree, fe_degree+1,
+            VectorizedArray<Number> > Eval;
+    Eval eval (shape_info.shape_val_evenodd,
+               shape_info.shape_gra_collocation_evenodd,
+               shape_info.shape_hes_evenodd);
+
+    const unsigned int d1 = dim>1?1:0;
+    const unsigned int d2 = dim>2?2:0;
+
+    for (unsigned int c=0; c<n_components; c++)
+      {
+        VectorizedArray<Number> temp1[Eval::dofs_per_cell];
+        VectorizedArray<Number> temp2[Eval::dofs_per_cell];
+
+        // sum the values and the gradients multiplied by the transpose of the
+        // collocation derivative in the quadrature points
+        if (integrate_val == true)
+          {
+            for (unsigned int q=0; q<Eval::n_q_points; ++q)
+              temp1[q] = values_quad[c][q];
+            eval.template gradients<0,false,true> (gradients_quad[c][0], temp1);
+          }
+        else
+          eval.template gradients<0,false,false> (gradients_quad[c][0], temp1);
+        if (dim > 1)
+          eval.template gradients<d1,false,true> (gradients_quad[c][d1], temp1);
+        if (dim > 2)
+          eval.template gradients<d2,false,true> (gradients_quad[c][d2], temp1);
+
+        // apply the transpose of the interpolation to the quadrature points
+        switch (dim)
+          {
+          case 1:
+            eval.template values<0,false,false> (temp1, values_dofs[c]);
+            break;
+          case 2:
+            eval.template values<0,false,false> (temp1, temp2);
+            eval.template values<1,false,false> (temp2, values_dofs[c]);
+            break;
+          case 3:
+            eval.template values<0,false,false> (temp1, temp2);
+            eval.template values<1,false,false> (temp2, temp1);
+            eval.template values<2,false,false> (temp1, values_dofs[c]);
+            break;
+          default:
+            AssertThrow(false, ExcNotImplemented());
+          }
+      }
+  }
+
+
+
+  // This struct performs the evaluation of function values, gradients and
   // Hessians for tensor-product finite elements. The operation is used for
   // both the symmetric and non-symmetric case, which use different apply
   // functions 'values', 'gradients' in the individual coordinate
@@ -6234,6 +6983,30 @@ namespace internal
 
     const EvaluatorVariant variant =
       EvaluatorSelector<type,(fe_degree+n_q_points_1d>4)>::variant;
+
+    // for symmetric elements with fe_degree+1 quadrature points per
+    // direction, compute the gradients from the values at the quadrature
+    // points by the collocation derivative
+    if (variant == evaluate_evenodd && n_q_points_1d == fe_degree+1 &&
+        type != MatrixFreeFunctions::truncated_tensor &&
+        evaluate_grad == true && evaluate_lapl == false &&
+        shape_info.shape_gra_collocation_evenodd.size() > 0)
+      {
+        FEEvaluationImplTransformToCollocation<dim,fe_degree,n_components,Number>
+        ::evaluate(shape_info, values_dofs_actual, values_quad, gradients_quad);
+
+        // FE_Q_DG0: add the constant to the values after the computation of
+        // the gradients, it does not contribute to the latter
+        if (type == MatrixFreeFunctions::tensor_symmetric_plus_dg0)
+          {
+            const unsigned int dofs_per_cell =
+              Utilities::fixed_int_power<fe_degree+1,dim>::value;
+            for (unsigned int c=0; c<n_components; ++c)
+              for (unsigned int q=0; q<Utilities::fixed_int_power<n_q_points_1d,dim>::value; ++q)
+                values_quad[c][q] += values_dofs_actual[c][dofs_per_cell];
+          }
+        return;
+      }
     typedef EvaluatorTensorProduct<variant, dim, fe_degree, n_q_points_1d,
             VectorizedArray<Number> > Eval;
     Eval eval (variant == evaluate_evenodd ? shape_info.shape_val_evenodd :
@@ -6435,6 +7208,32 @@ namespace internal
   {
     const EvaluatorVariant variant =
       EvaluatorSelector<type,(fe_degree+n_q_points_1d>4)>::variant;
+
+    // transpose of the collocation evaluation of gradients
+    if (variant == evaluate_evenodd && n_q_points_1d == fe_degree+1 &&
+        type != MatrixFreeFunctions::truncated_tensor &&
+        integrate_grad == true &&
+        shape_info.shape_gra_collocation_evenodd.size() > 0)
+      {
+        FEEvaluationImplTransformToCollocation<dim,fe_degree,n_components,Number>
+        ::integrate(shape_info, values_dofs_actual, values_quad, gradients_quad,
+                    integrate_val);
+
+        // FE_Q_DG0: only the values contribute to the constant
+        if (type == MatrixFreeFunctions::tensor_symmetric_plus_dg0)
+          {
+            const unsigned int dofs_per_cell =
+              Utilities::fixed_int_power<fe_degree+1,dim>::value;
+            for (unsigned int c=0; c<n_components; ++c)
+              {
+                values_dofs_actual[c][dofs_per_cell] = VectorizedArray<Number>();
+                if (integrate_val == true)
+                  for (unsigned int q=0; q<Utilities::fixed_int_power<n_q_points_1d,dim>::value; ++q)
+                    values_dofs_actual[c][dofs_per_cell] += values_quad[c][q];
+              }
+          }
+        return;
+      }
     typedef EvaluatorTensorProduct<variant, dim, fe_degree, n_q_points_1d,
             VectorizedArray<Number> > Eval;
     Eval eval (variant == evaluate_evenodd ? shape_info.shape_val_evenodd :
@@ -6831,6 +7630,272 @@ namespace internal
       }
   }
 
+
+
+  /**
+   * This struct performs the evaluation of function values and gradients on
+   * faces of tensor product elements. The values and the normal derivatives
+   * of the cell polynomial are first interpolated to the face by a
+   * one-dimensional contraction in the direction normal to the face, and
+   * then evaluated in the <tt>dim-1</tt> tangential directions by sum
+   * factorization. The integration performs the transpose operations, with
+   * the result overwriting the cell degrees of freedom. If @p subface_index
+   * is different from numbers::invalid_unsigned_int, the tangential
+   * evaluation is done on the part of the face given by the encoding of
+   * FaceToCellTopology::subface_index.
+   */
+  template <int dim, int fe_degree, int n_q_points_1d, int n_components,
+            typename Number>
+  struct FEFaceEvaluationImpl
+  {
+    static const unsigned int n_dofs_1d = fe_degree+1;
+    static const unsigned int dofs_per_face = Utilities::fixed_int_power<fe_degree+1,dim-1>::value;
+    static const unsigned int n_q_points = Utilities::fixed_int_power<n_q_points_1d,dim-1>::value;
+
+    static
+    void evaluate (const MatrixFreeFunctions::ShapeInfo<Number> &shape_info,
+                   VectorizedArray<Number> *values_dofs[],
+                   VectorizedArray<Number> *values_quad[],
+                   VectorizedArray<Number> *gradients_quad[][dim],
+                   const unsigned int       face_no,
+                   const unsigned int       subface_index,
+                   const bool               evaluate_val,
+                   const bool               evaluate_grad);
+
+    static
+    void integrate (const MatrixFreeFunctions::ShapeInfo<Number> &shape_info,
+                    VectorizedArray<Number> *values_dofs[],
+                    VectorizedArray<Number> *values_quad[],
+                    VectorizedArray<Number> *gradients_quad[][dim],
+                    const unsigned int       face_no,
+                    const unsigned int       subface_index,
+                    const bool               integrate_val,
+                    const bool               integrate_grad);
+  };
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, int n_components,
+            typename Number>
+  inline
+  void
+  FEFaceEvaluationImpl<dim,fe_degree,n_q_points_1d,n_components,Number>
+  ::evaluate (const MatrixFreeFunctions::ShapeInfo<Number> &shape_info,
+              VectorizedArray<Number> *values_dofs[],
+              VectorizedArray<Number> *values_quad[],
+              VectorizedArray<Number> *gradients_quad[][dim],
+              const unsigned int       face_no,
+              const unsigned int       subface_index,
+              const bool               evaluate_val,
+              const bool               evaluate_grad)
+  {
+    if (evaluate_val == false && evaluate_grad == false)
+      return;
+
+    // on subfaces, the two tangential directions use the shape functions
+    // on the respective half of the unit interval
+    typedef EvaluatorTensorProduct<evaluate_general,(dim>1?dim-1:1),fe_degree,
+            n_q_points_1d,VectorizedArray<Number> > Eval;
+    const Eval eval0 =
+      subface_index == numbers::invalid_unsigned_int ?
+      Eval (shape_info.shape_values, shape_info.shape_gradients,
+            shape_info.shape_hessians) :
+      Eval (shape_info.values_within_subface[subface_index%2],
+            shape_info.gradients_within_subface[subface_index%2],
+            shape_info.shape_hessians);
+    const Eval eval1 =
+      subface_index == numbers::invalid_unsigned_int ?
+      Eval (shape_info.shape_values, shape_info.shape_gradients,
+            shape_info.shape_hessians) :
+      Eval (shape_info.values_within_subface[subface_index/2],
+            shape_info.gradients_within_subface[subface_index/2],
+            shape_info.shape_hessians);
+
+    const unsigned int direction = face_no/2;
+    const unsigned int side      = face_no%2;
+    const unsigned int stride    = direction == 0 ? 1 : direction == 1 ?
+                                   n_dofs_1d : n_dofs_1d*n_dofs_1d;
+
+    // tangential directions of the face in increasing order
+    const unsigned int tangent_0 = direction == 0 ? 1 : 0;
+    const unsigned int tangent_1 = direction == 2 ? 1 : 2;
+
+    VectorizedArray<Number> values_face[dofs_per_face];
+    VectorizedArray<Number> normal_face[dofs_per_face];
+    VectorizedArray<Number> temp[dim>2 ? n_dofs_1d*n_q_points_1d : 1];
+
+    for (unsigned int c=0; c<n_components; ++c)
+      {
+        // interpolate the cell polynomial and its normal derivative to the
+        // face
+        for (unsigned int i=0; i<dofs_per_face; ++i)
+          {
+            const VectorizedArray<Number> *in =
+              values_dofs[c] + (i%stride) + (i/stride)*stride*n_dofs_1d;
+            VectorizedArray<Number> val = in[0] * shape_info.face_value[side][0];
+            VectorizedArray<Number> grad = in[0] * shape_info.face_gradient[side][0];
+            for (unsigned int k=1; k<n_dofs_1d; ++k)
+              {
+                val += in[k*stride] * shape_info.face_value[side][k];
+                grad += in[k*stride] * shape_info.face_gradient[side][k];
+              }
+            values_face[i] = val;
+            normal_face[i] = grad;
+          }
+
+        // evaluate in the tangential directions
+        if (dim == 1)
+          {
+            values_quad[c][0] = values_face[0];
+            gradients_quad[c][0][0] = normal_face[0];
+          }
+        else if (dim == 2)
+          {
+            if (evaluate_val == true)
+              eval0.template values<0,true,false>(values_face, values_quad[c]);
+            if (evaluate_grad == true)
+              {
+                eval0.template gradients<0,true,false>(values_face,
+                                                      gradients_quad[c][tangent_0]);
+                eval0.template values<0,true,false>(normal_face,
+                                                   gradients_quad[c][direction]);
+              }
+          }
+        else if (dim == 3)
+          {
+            if (evaluate_grad == true)
+              {
+                eval0.template gradients<0,true,false>(values_face, temp);
+                eval1.template values<1,true,false>(temp, gradients_quad[c][tangent_0]);
+                eval0.template values<0,true,false>(normal_face, temp);
+                eval1.template values<1,true,false>(temp, gradients_quad[c][direction]);
+              }
+            eval0.template values<0,true,false>(values_face, temp);
+            if (evaluate_grad == true)
+              eval1.template gradients<1,true,false>(temp, gradients_quad[c][tangent_1]);
+            if (evaluate_val == true)
+              eval1.template values<1,true,false>(temp, values_quad[c]);
+          }
+        else
+          Assert (false, ExcNotImplemented());
+      }
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, int n_components,
+            typename Number>
+  inline
+  void
+  FEFaceEvaluationImpl<dim,fe_degree,n_q_points_1d,n_components,Number>
+  ::integrate (const MatrixFreeFunctions::ShapeInfo<Number> &shape_info,
+               VectorizedArray<Number> *values_dofs[],
+               VectorizedArray<Number> *values_quad[],
+               VectorizedArray<Number> *gradients_quad[][dim],
+               const unsigned int       face_no,
+               const unsigned int       subface_index,
+               const bool               integrate_val,
+               const bool               integrate_grad)
+  {
+    typedef EvaluatorTensorProduct<evaluate_general,(dim>1?dim-1:1),fe_degree,
+            n_q_points_1d,VectorizedArray<Number> > Eval;
+    const Eval eval0 =
+      subface_index == numbers::invalid_unsigned_int ?
+      Eval (shape_info.shape_values, shape_info.shape_gradients,
+            shape_info.shape_hessians) :
+      Eval (shape_info.values_within_subface[subface_index%2],
+            shape_info.gradients_within_subface[subface_index%2],
+            shape_info.shape_hessians);
+    const Eval eval1 =
+      subface_index == numbers::invalid_unsigned_int ?
+      Eval (shape_info.shape_values, shape_info.shape_gradients,
+            shape_info.shape_hessians) :
+      Eval (shape_info.values_within_subface[subface_index/2],
+            shape_info.gradients_within_subface[subface_index/2],
+            shape_info.shape_hessians);
+
+    const unsigned int direction = face_no/2;
+    const unsigned int side      = face_no%2;
+    const unsigned int stride    = direction == 0 ? 1 : direction == 1 ?
+                                   n_dofs_1d : n_dofs_1d*n_dofs_1d;
+    const unsigned int tangent_0 = direction == 0 ? 1 : 0;
+    const unsigned int tangent_1 = direction == 2 ? 1 : 2;
+
+    VectorizedArray<Number> values_face[dofs_per_face];
+    VectorizedArray<Number> normal_face[dofs_per_face];
+    VectorizedArray<Number> temp[dim>2 ? n_dofs_1d*n_q_points_1d : 1];
+
+    for (unsigned int c=0; c<n_components; ++c)
+      {
+        // test by the tangential part of the shape functions, always
+        // proceeding from the lowest to the highest direction as required
+        // by the tensor product kernels
+        for (unsigned int i=0; i<dofs_per_face; ++i)
+          {
+            values_face[i] = VectorizedArray<Number>();
+            normal_face[i] = VectorizedArray<Number>();
+          }
+        if (dim == 1)
+          {
+            if (integrate_val == true)
+              values_face[0] = values_quad[c][0];
+            if (integrate_grad == true)
+              normal_face[0] = gradients_quad[c][0][0];
+          }
+        else if (dim == 2)
+          {
+            if (integrate_val == true)
+              eval0.template values<0,false,false>(values_quad[c], values_face);
+            if (integrate_grad == true)
+              {
+                eval0.template gradients<0,false,true>(gradients_quad[c][tangent_0],
+                                                      values_face);
+                eval0.template values<0,false,false>(gradients_quad[c][direction],
+                                                    normal_face);
+              }
+          }
+        else if (dim == 3)
+          {
+            if (integrate_val == true)
+              {
+                eval0.template values<0,false,false>(values_quad[c], temp);
+                if (integrate_grad == true)
+                  eval0.template gradients<0,false,true>(gradients_quad[c][tangent_0],
+                                                        temp);
+                eval1.template values<1,false,false>(temp, values_face);
+              }
+            else if (integrate_grad == true)
+              {
+                eval0.template gradients<0,false,false>(gradients_quad[c][tangent_0],
+                                                       temp);
+                eval1.template values<1,false,false>(temp, values_face);
+              }
+            if (integrate_grad == true)
+              {
+                eval0.template values<0,false,false>(gradients_quad[c][tangent_1],
+                                                    temp);
+                eval1.template gradients<1,false,true>(temp, values_face);
+                eval0.template values<0,false,false>(gradients_quad[c][direction],
+                                                    temp);
+                eval1.template values<1,false,false>(temp, normal_face);
+              }
+          }
+        else
+          Assert (false, ExcNotImplemented());
+
+        // expand from the face to the cell by the transpose of the
+        // interpolation in normal direction
+        for (unsigned int i=0; i<dofs_per_face; ++i)
+          {
+            VectorizedArray<Number> *out =
+              values_dofs[c] + (i%stride) + (i/stride)*stride*n_dofs_1d;
+            for (unsigned int k=0; k<n_dofs_1d; ++k)
+              out[k*stride] = values_face[i] * shape_info.face_value[side][k] +
+                              normal_face[i] * shape_info.face_gradient[side][k];
+          }
+      }
+  }
+
 } // end of namespace internal
 
 
@@ -6846,7 +7911,12 @@ FEEvaluation<dim,fe_degree,n_q_points_1d,n_components_,Number>
                 const unsigned int fe_no,
                 const unsigned int quad_no)
   :
-  BaseClass (data_in, fe_no, quad_no, fe_degree, n_q_points),
+  BaseClass (data_in, fe_no, quad_no,
+             fe_degree == -1 ? data_in.get_shape_info(fe_no, quad_no).fe_degree :
+             fe_degree,
+             fe_degree == -1 ? data_in.get_shape_info(fe_no, quad_no).n_q_points :
+             Utilities::fixed_int_power<n_q_points_1d,dim>::value),
+  SizesClass (*this->data),
   dofs_per_cell (this->data->dofs_per_cell)
 {
   check_template_arguments(fe_no);
@@ -6868,6 +7938,7 @@ FEEvaluation<dim,fe_degree,n_q_points_1d,n_components_,Number>
   BaseClass (mapping, fe, quadrature, update_flags,
              first_selected_component,
              static_cast<FEEvaluationBase<dim,1,Number>*>(0)),
+  SizesClass (*this->data),
   dofs_per_cell (this->data->dofs_per_cell)
 {
   check_template_arguments(numbers::invalid_unsigned_int);
@@ -6888,6 +7959,7 @@ FEEvaluation<dim,fe_degree,n_q_points_1d,n_components_,Number>
   BaseClass (StaticMappingQ1<dim>::mapping, fe, quadrature, update_flags,
              first_selected_component,
              static_cast<FEEvaluationBase<dim,1,Number>*>(0)),
+  SizesClass (*this->data),
   dofs_per_cell (this->data->dofs_per_cell)
 {
   check_template_arguments(numbers::invalid_unsigned_int);
@@ -6909,6 +7981,7 @@ FEEvaluation<dim,fe_degree,n_q_points_1d,n_components_,Number>
              fe, other.mapped_geometry->get_quadrature(),
              other.mapped_geometry->get_fe_values().get_update_flags(),
              first_selected_component, &other),
+  SizesClass (*this->data),
   dofs_per_cell (this->data->dofs_per_cell)
 {
   check_template_arguments(numbers::invalid_unsigned_int);
@@ -6924,6 +7997,7 @@ FEEvaluation<dim,fe_degree,n_q_points_1d,n_components_,Number>
 ::FEEvaluation (const FEEvaluation &other)
   :
   BaseClass (other),
+  SizesClass (other),
   dofs_per_cell (this->data->dofs_per_cell)
 {
   set_data_pointers();
@@ -6939,6 +8013,7 @@ FEEvaluation<dim,fe_degree,n_q_points_1d,n_components_,Number>
 ::operator= (const FEEvaluation &other)
 {
   this->FEEvaluationAccess<dim,n_components_,Number>::operator=(other);
+  AssertDimension (n_q_points, other.n_q_points);
   set_data_pointers();
   return *this;
 }
@@ -6955,23 +8030,61 @@ FEEvaluation<dim,fe_degree,n_q_points_1d,n_components_,Number>
   AssertIndexRange(this->data->dofs_per_cell, tensor_dofs_per_cell+2);
   const unsigned int desired_dofs_per_cell = this->data->dofs_per_cell;
 
+  // for the polynomial degree selected at run time, allocate the data
+  // fields plus scratch data for the generic evaluation kernels
+  VectorizedArray<Number> *data_array = my_data_array;
+  if (fe_degree == -1)
+    {
+      const unsigned int n_dofs_1d = this->data->fe_degree+1;
+      const unsigned int n_max_1d = std::max(n_dofs_1d, this->data->n_q_points_1d);
+      runtime_data_array.resize_fast(n_components*(desired_dofs_per_cell+
+                                                   (dim*dim+2*dim+1)*n_q_points)
+                                     + 2*Utilities::fixed_power<dim>(n_max_1d));
+      data_array = runtime_data_array.begin();
+    }
+
   // set the pointers to the correct position in the data array
   for (unsigned int c=0; c<n_components_; ++c)
     {
-      this->values_dofs[c] = &my_data_array[c*desired_dofs_per_cell];
-      this->values_quad[c] = &my_data_array[n_components*desired_dofs_per_cell+c*n_q_points];
+      this->values_dofs[c] = &data_array[c*desired_dofs_per_cell];
+      this->values_quad[c] = &data_array[n_components*desired_dofs_per_cell+c*n_q_points];
       for (unsigned int d=0; d<dim; ++d)
-        this->gradients_quad[c][d] = &my_data_array[n_components*(desired_dofs_per_cell+
-                                                                  n_q_points)
-                                                    +
-                                                    (c*dim+d)*n_q_points];
+        this->gradients_quad[c][d] = &data_array[n_components*(desired_dofs_per_cell+
+                                                               n_q_points)
+                                                 +
+                                                 (c*dim+d)*n_q_points];
       for (unsigned int d=0; d<(dim*dim+dim)/2; ++d)
-        this->hessians_quad[c][d] = &my_data_array[n_components*((dim+1)*n_q_points+
-                                                                 desired_dofs_per_cell)
-                                                   +
-                                                   (c*(dim*dim+dim)+d)*n_q_points];
+        this->hessians_quad[c][d] = &data_array[n_components*((dim+1)*n_q_points+
+                                                              desired_dofs_per_cell)
+                                                +
+                                                (c*(dim*dim+dim)+d)*n_q_points];
     }
 
+  set_function_pointers(internal::bool2type<fe_degree==-1>());
+}
+
+
+
+template <int dim, int fe_degree,  int n_q_points_1d, int n_components_,
+          typename Number>
+inline
+void
+FEEvaluation<dim,fe_degree,n_q_points_1d,n_components_,Number>
+::set_function_pointers(const internal::bool2type<true>)
+{
+  evaluate_funct = 0;
+  integrate_funct = 0;
+}
+
+
+
+template <int dim, int fe_degree,  int n_q_points_1d, int n_components_,
+          typename Number>
+inline
+void
+FEEvaluation<dim,fe_degree,n_q_points_1d,n_components_,Number>
+::set_function_pointers(const internal::bool2type<false>)
+{
   switch (this->data->element_type)
     {
     case internal::MatrixFreeFunctions::tensor_symmetric:
@@ -7032,7 +8145,6 @@ FEEvaluation<dim,fe_degree,n_q_points_1d,n_components_,Number>
     default:
       AssertThrow(false, ExcNotImplemented());
     }
-
 }
 
 
@@ -7045,6 +8157,19 @@ FEEvaluation<dim,fe_degree,n_q_points_1d,n_components_,Number>
 ::check_template_arguments(const unsigned int fe_no)
 {
   (void)fe_no;
+
+  // for the polynomial degree selected at run time, the sizes are taken
+  // from the underlying ShapeInfo object, so there is nothing to check
+  // except that we do not run into an hp situation
+  if (fe_degree == -1)
+    {
+      AssertThrow (fe_no == numbers::invalid_unsigned_int ||
+                   this->dof_info->fe_index_conversion.size() <= 1,
+                   ExcMessage("FEEvaluation with fe_degree=-1 does not "
+                              "support hp adaptivity."));
+      return;
+    }
+
 #ifdef DEBUG
   // print error message when the dimensions do not match. Propose a possible
   // fix
@@ -7184,19 +8309,21 @@ FEEvaluation<dim,fe_degree,n_q_points_1d,n_components_,Number>
   // value from that
   if (this->cell_type == internal::MatrixFreeFunctions::cartesian)
     {
+      const unsigned int n_q_1d = fe_degree == -1 ? this->data->n_q_points_1d :
+                                  n_q_points_1d;
       Point<dim,VectorizedArray<Number> > point;
       switch (dim)
         {
         case 1:
           return this->quadrature_points[q];
         case 2:
-          point[0] = this->quadrature_points[q%n_q_points_1d][0];
-          point[1] = this->quadrature_points[q/n_q_points_1d][1];
+          point[0] = this->quadrature_points[q%n_q_1d][0];
+          point[1] = this->quadrature_points[q/n_q_1d][1];
           return point;
         case 3:
-          point[0] = this->quadrature_points[q%n_q_points_1d][0];
-          point[1] = this->quadrature_points[(q/n_q_points_1d)%n_q_points_1d][1];
-          point[2] = this->quadrature_points[q/(n_q_points_1d*n_q_points_1d)][2];
+          point[0] = this->quadrature_points[q%n_q_1d][0];
+          point[1] = this->quadrature_points[(q/n_q_1d)%n_q_1d][1];
+          point[2] = this->quadrature_points[q/(n_q_1d*n_q_1d)][2];
           return point;
         default:
           Assert (false, ExcNotImplemented());
@@ -7226,9 +8353,17 @@ FEEvaluation<dim,fe_degree,n_q_points_1d,n_components_,Number>
 
   // Select algorithm matching the element type at run time (the function
   // pointer is easy to predict, so negligible in cost)
-  evaluate_funct (*this->data, &this->values_dofs[0],
-                  this->values_quad, this->gradients_quad, this->hessians_quad,
-                  evaluate_val, evaluate_grad, evaluate_lapl);
+  if (fe_degree == -1)
+    internal::FEEvaluationImplAnyDegree<dim,Number>::
+    evaluate (*this->data, n_components, &this->values_dofs[0],
+              this->values_quad, this->gradients_quad, this->hessians_quad,
+              runtime_data_array.begin() +
+              n_components*(dofs_per_cell+(dim*dim+2*dim+1)*n_q_points),
+              evaluate_val, evaluate_grad, evaluate_lapl);
+  else
+    evaluate_funct (*this->data, &this->values_dofs[0],
+                    this->values_quad, this->gradients_quad, this->hessians_quad,
+                    evaluate_val, evaluate_grad, evaluate_lapl);
 
 #ifdef DEBUG
   if (evaluate_val == true)
@@ -7260,8 +8395,15 @@ FEEvaluation<dim,fe_degree,n_q_points_1d,n_components_,Number>
 
   // Select algorithm matching the element type at run time (the function
   // pointer is easy to predict, so negligible in cost)
-  integrate_funct (*this->data, this->values_dofs, this->values_quad,
-                   this->gradients_quad, integrate_val, integrate_grad);
+  if (fe_degree == -1)
+    internal::FEEvaluationImplAnyDegree<dim,Number>::
+    integrate (*this->data, n_components, this->values_dofs, this->values_quad,
+               this->gradients_quad, runtime_data_array.begin() +
+               n_components*(dofs_per_cell+(dim*dim+2*dim+1)*n_q_points),
+               integrate_val, integrate_grad);
+  else
+    integrate_funct (*this->data, this->values_dofs, this->values_quad,
+                     this->gradients_quad, integrate_val, integrate_grad);
 
 #ifdef DEBUG
   this->dof_values_initialized = true;
@@ -7270,6 +8412,496 @@ FEEvaluation<dim,fe_degree,n_q_points_1d,n_components_,Number>
 
 
 
+
+
+
+/*------------------------- FEFaceEvaluation --------------------------------*/
+
+
+template <int dim, int fe_degree,  int n_q_points_1d, int n_components_,
+          typename Number>
+inline
+FEFaceEvaluation<dim,fe_degree,n_q_points_1d,n_components_,Number>
+::FEFaceEvaluation (const MatrixFree<dim,Number> &data_in,
+                    const bool                    is_interior_face,
+                    const unsigned int            fe_no,
+                    const unsigned int            quad_no)
+  :
+  BaseClass (data_in, fe_no, quad_no, fe_degree,
+             Utilities::fixed_int_power<n_q_points_1d,dim>::value),
+  dofs_per_cell (this->data->dofs_per_cell),
+  is_interior_face (is_interior_face),
+  face_no (numbers::invalid_unsigned_int),
+  subface_index (numbers::invalid_unsigned_int),
+  normal_vectors (0)
+{
+  AssertThrow (this->data->element_type != internal::MatrixFreeFunctions::truncated_tensor &&
+               this->data->element_type != internal::MatrixFreeFunctions::tensor_symmetric_plus_dg0,
+               ExcMessage("FEFaceEvaluation is only implemented for elements "
+                          "with full tensor product shape functions"));
+  Assert (this->data->fe_degree == fe_degree &&
+          this->data->dofs_per_cell == tensor_dofs_per_cell,
+          ExcMessage("Wrong template argument fe_degree in FEFaceEvaluation"));
+  AssertIndexRange (quad_no, this->mapping_info->face_data.size());
+  AssertDimension (this->mapping_info->face_data[quad_no].n_q_points, n_q_points);
+  set_data_pointers();
+}
+
+
+
+template <int dim, int fe_degree,  int n_q_points_1d, int n_components_,
+          typename Number>
+inline
+void
+FEFaceEvaluation<dim,fe_degree,n_q_points_1d,n_components_,Number>
+::set_data_pointers()
+{
+  for (unsigned int c=0; c<n_components_; ++c)
+    {
+      this->values_dofs[c] = &my_data_array[c*tensor_dofs_per_cell];
+      this->values_quad[c] = &my_data_array[n_components*tensor_dofs_per_cell+c*n_q_points];
+      for (unsigned int d=0; d<dim; ++d)
+        this->gradients_quad[c][d] = &my_data_array[n_components*(tensor_dofs_per_cell+
+                                                                  n_q_points)
+                                                    +
+                                                    (c*dim+d)*n_q_points];
+    }
+}
+
+
+
+template <int dim, int fe_degree,  int n_q_points_1d, int n_components_,
+          typename Number>
+inline
+void
+FEFaceEvaluation<dim,fe_degree,n_q_points_1d,n_components_,Number>
+::reinit (const unsigned int face_batch_number)
+{
+  Assert (this->mapping_info->face_data.size() > this->quad_no &&
+          this->mapping_info->face_data[this->quad_no].JxW_values.size() > 0,
+          ExcMessage("Face data has not been initialized in MatrixFree. Set "
+                     "AdditionalData::mapping_update_flags_inner_faces or "
+                     "AdditionalData::mapping_update_flags_boundary_faces."));
+  AssertIndexRange (face_batch_number,
+                    this->matrix_info->n_inner_face_batches() +
+                    this->matrix_info->n_boundary_face_batches());
+  Assert (is_interior_face == true ||
+          face_batch_number < this->matrix_info->n_inner_face_batches(),
+          ExcMessage("Boundary faces do not have an exterior side"));
+
+  this->cell = face_batch_number;
+  this->cell_type = internal::MatrixFreeFunctions::general;
+
+  const internal::MatrixFreeFunctions::FaceToCellTopology<VectorizedArray<Number>::n_array_elements> &face =
+    this->matrix_info->get_face_info(face_batch_number);
+  face_no = is_interior_face ? face.interior_face_no : face.exterior_face_no;
+  subface_index = is_interior_face ? numbers::invalid_unsigned_int :
+                  face.subface_index;
+
+  const typename internal::MatrixFreeFunctions::MappingInfo<dim,Number>::FaceMappingInfo &
+  face_data = this->mapping_info->face_data[this->quad_no];
+  const unsigned int offset = face_batch_number * n_q_points;
+  this->J_value        = &face_data.JxW_values[offset];
+  this->jacobian       = &face_data.jacobians[is_interior_face ? 0 : 1][offset];
+  normal_vectors       = &face_data.normal_vectors[offset];
+  if (face_data.quadrature_points.size() > 0)
+    this->quadrature_points = &face_data.quadrature_points[offset];
+
+#ifdef DEBUG
+  this->dof_values_initialized      = false;
+  this->values_quad_initialized     = false;
+  this->gradients_quad_initialized  = false;
+  this->hessians_quad_initialized   = false;
+#endif
+}
+
+
+
+template <int dim, int fe_degree,  int n_q_points_1d, int n_components_,
+          typename Number>
+template<typename VectorType, typename VectorOperation>
+inline
+void
+FEFaceEvaluation<dim,fe_degree,n_q_points_1d,n_components_,Number>
+::read_write_operation_face (const VectorOperation &operation,
+                             VectorType            *vectors[]) const
+{
+  Assert (this->cell != numbers::invalid_unsigned_int, ExcNotInitialized());
+  const unsigned int n_lanes = VectorizedArray<Number>::n_array_elements;
+  const internal::MatrixFreeFunctions::FaceToCellTopology<n_lanes> &face =
+    this->matrix_info->get_face_info(this->cell);
+  const unsigned int *cells = is_interior_face ? face.cells_interior :
+                              face.cells_exterior;
+  const unsigned int n_local_cells = this->matrix_info->n_macro_cells()*n_lanes;
+
+  // For vector-valued elements, all components sit in one vector with the
+  // degrees of freedom of the first component first, then the second, and
+  // so on. Otherwise, each component is read from a separate vector.
+  const bool single_vector = this->n_fe_components > 1;
+  Assert (this->n_fe_components == 1 || this->n_fe_components == n_components_,
+          ExcNotImplemented());
+  const unsigned int n_vectors = single_vector ? 1 : n_components;
+  for (unsigned int comp=0; comp<n_vectors; ++comp)
+    internal::check_vector_compatibility (*vectors[comp], *this->dof_info);
+  const unsigned int n_dofs = this->dof_info->dofs_per_cell[0];
+  AssertDimension (n_dofs, tensor_dofs_per_cell * this->n_fe_components);
+
+  for (unsigned int v=0; v<n_lanes; ++v)
+    {
+      const unsigned int cell_index = cells[v];
+      if (cell_index == numbers::invalid_unsigned_int)
+        {
+          for (unsigned int comp=0; comp<n_components; ++comp)
+            for (unsigned int i=0; i<tensor_dofs_per_cell; ++i)
+              operation.process_empty (this->values_dofs[comp][i][v]);
+          continue;
+        }
+
+      // cells on remote processors: use the plain indices
+      if (cell_index >= n_local_cells)
+        {
+          const unsigned int *dof_indices =
+            &this->dof_info->dof_indices_ghost_cells[(cell_index-n_local_cells)*n_dofs];
+          for (unsigned int i=0; i<n_dofs; ++i)
+            for (unsigned int comp=0; comp<n_vectors; ++comp)
+              operation.process_dof (dof_indices[i], *vectors[comp],
+                                     this->values_dofs[single_vector ? i/tensor_dofs_per_cell : comp]
+                                     [single_vector ? i%tensor_dofs_per_cell : i][v]);
+          continue;
+        }
+
+      // locally owned cells: the indices are stored interleaved for the
+      // lanes of the macro cell, with only the filled lanes present
+      const unsigned int macro_cell = cell_index / n_lanes;
+      const unsigned int lane = cell_index % n_lanes;
+      const unsigned int n_filled = this->dof_info->row_starts[macro_cell][2] > 0 ?
+                                    this->dof_info->row_starts[macro_cell][2] :
+                                    n_lanes;
+
+      // compressed index storage: the indices follow from the start index
+      // of the lane
+      if (!this->dof_info->index_storage_variants.empty() &&
+          this->dof_info->index_storage_variants[macro_cell] !=
+          internal::MatrixFreeFunctions::DoFInfo::full)
+        {
+          for (unsigned int i=0; i<n_dofs; ++i)
+            for (unsigned int comp=0; comp<n_vectors; ++comp)
+              operation.process_dof (this->dof_info->compressed_dof_index(macro_cell, lane, i),
+                                     *vectors[comp],
+                                     this->values_dofs[single_vector ? i/tensor_dofs_per_cell : comp]
+                                     [single_vector ? i%tensor_dofs_per_cell : i][v]);
+          continue;
+        }
+
+      const unsigned int *dof_indices = this->dof_info->begin_indices(macro_cell);
+      const std::pair<unsigned short,unsigned short> *indicators =
+        this->dof_info->begin_indicators(macro_cell);
+      const std::pair<unsigned short,unsigned short> *indicators_end =
+        this->dof_info->end_indicators(macro_cell);
+
+      // no constraints: direct access to the indices of the current lane
+      if (indicators == indicators_end)
+        {
+          for (unsigned int i=0; i<n_dofs; ++i)
+            for (unsigned int comp=0; comp<n_vectors; ++comp)
+              operation.process_dof (dof_indices[i*n_filled+lane], *vectors[comp],
+                                     this->values_dofs[single_vector ? i/tensor_dofs_per_cell : comp]
+                                     [single_vector ? i%tensor_dofs_per_cell : i][v]);
+          continue;
+        }
+
+      // with constraints, walk through the entries of all lanes and pick the
+      // ones of the current lane
+      unsigned int position = 0;
+      for ( ; indicators != indicators_end; ++indicators)
+        {
+          for (unsigned int j=0; j<indicators->first; ++j, ++position, ++dof_indices)
+            if (position % n_filled == lane)
+              {
+                const unsigned int i = position / n_filled;
+                for (unsigned int comp=0; comp<n_vectors; ++comp)
+                  operation.process_dof (*dof_indices, *vectors[comp],
+                                         this->values_dofs[single_vector ? i/tensor_dofs_per_cell : comp]
+                                         [single_vector ? i%tensor_dofs_per_cell : i][v]);
+              }
+
+          const Number *data_val =
+            this->matrix_info->constraint_pool_begin(indicators->second);
+          const Number *end_pool =
+            this->matrix_info->constraint_pool_end(indicators->second);
+          if (position % n_filled == lane)
+            {
+              const unsigned int i = position / n_filled;
+              for (unsigned int comp=0; comp<n_vectors; ++comp)
+                {
+                  Number &local_value =
+                    this->values_dofs[single_vector ? i/tensor_dofs_per_cell : comp]
+                    [single_vector ? i%tensor_dofs_per_cell : i][v];
+                  Number value;
+                  operation.pre_constraints (local_value, value);
+                  for (unsigned int k=0; k<static_cast<unsigned int>(end_pool-data_val); ++k)
+                    operation.process_constraint (dof_indices[k], data_val[k],
+                                                  *vectors[comp], value);
+                  operation.post_constraints (value, local_value);
+                }
+            }
+          dof_indices += end_pool - data_val;
+          ++position;
+        }
+      for ( ; position < n_dofs*n_filled; ++position, ++dof_indices)
+        if (position % n_filled == lane)
+          {
+            const unsigned int i = position / n_filled;
+            for (unsigned int comp=0; comp<n_vectors; ++comp)
+              operation.process_dof (*dof_indices, *vectors[comp],
+                                     this->values_dofs[single_vector ? i/tensor_dofs_per_cell : comp]
+                                     [single_vector ? i%tensor_dofs_per_cell : i][v]);
+          }
+      Assert (dof_indices == this->dof_info->end_indices(macro_cell),
+              ExcInternalError());
+    }
+}
+
+
+
+template <int dim, int fe_degree,  int n_q_points_1d, int n_components_,
+          typename Number>
+template<typename VectorType>
+inline
+void
+FEFaceEvaluation<dim,fe_degree,n_q_points_1d,n_components_,Number>
+::read_dof_values (const VectorType &src,
+                   const unsigned int first_index)
+{
+  typename internal::BlockVectorSelector<VectorType,
+           IsBlockVector<VectorType>::value>::BaseVectorType *src_data[n_components];
+  for (unsigned int d=0; d<n_components; ++d)
+    src_data[d] = internal::BlockVectorSelector<VectorType, IsBlockVector<VectorType>::value>::get_vector_component(const_cast<VectorType &>(src), d+first_index);
+
+  internal::VectorReader<Number> reader;
+  read_write_operation_face (reader, src_data);
+
+#ifdef DEBUG
+  this->dof_values_initialized = true;
+#endif
+}
+
+
+
+template <int dim, int fe_degree,  int n_q_points_1d, int n_components_,
+          typename Number>
+template<typename VectorType>
+inline
+void
+FEFaceEvaluation<dim,fe_degree,n_q_points_1d,n_components_,Number>
+::distribute_local_to_global (VectorType        &dst,
+                              const unsigned int first_index) const
+{
+  Assert (this->dof_values_initialized==true,
+          internal::ExcAccessToUninitializedField());
+
+  typename internal::BlockVectorSelector<VectorType,
+           IsBlockVector<VectorType>::value>::BaseVectorType *dst_data[n_components];
+  for (unsigned int d=0; d<n_components; ++d)
+    dst_data[d] = internal::BlockVectorSelector<VectorType, IsBlockVector<VectorType>::value>::get_vector_component(dst, d+first_index);
+
+  internal::VectorDistributorLocalToGlobal<Number> distributor;
+  read_write_operation_face (distributor, dst_data);
+}
+
+
+
+template <int dim, int fe_degree,  int n_q_points_1d, int n_components_,
+          typename Number>
+inline
+void
+FEFaceEvaluation<dim,fe_degree,n_q_points_1d,n_components_,Number>
+::evaluate (const bool evaluate_val,
+            const bool evaluate_grad)
+{
+  Assert (this->dof_values_initialized == true,
+          internal::ExcAccessToUninitializedField());
+  Assert (face_no != numbers::invalid_unsigned_int, ExcNotInitialized());
+
+  internal::FEFaceEvaluationImpl<dim,fe_degree,n_q_points_1d,n_components_,Number>
+  ::evaluate (*this->data, &this->values_dofs[0], this->values_quad,
+              this->gradients_quad, face_no, subface_index,
+              evaluate_val, evaluate_grad);
+
+#ifdef DEBUG
+  if (evaluate_val == true)
+    this->values_quad_initialized = true;
+  if (evaluate_grad == true)
+    this->gradients_quad_initialized = true;
+#endif
+}
+
+
+
+template <int dim, int fe_degree,  int n_q_points_1d, int n_components_,
+          typename Number>
+inline
+void
+FEFaceEvaluation<dim,fe_degree,n_q_points_1d,n_components_,Number>
+::integrate (const bool integrate_val,
+             const bool integrate_grad)
+{
+  if (integrate_val == true)
+    Assert (this->values_quad_submitted == true,
+            internal::ExcAccessToUninitializedField());
+  if (integrate_grad == true)
+    Assert (this->gradients_quad_submitted == true,
+            internal::ExcAccessToUninitializedField());
+  Assert (face_no != numbers::invalid_unsigned_int, ExcNotInitialized());
+
+  internal::FEFaceEvaluationImpl<dim,fe_degree,n_q_points_1d,n_components_,Number>
+  ::integrate (*this->data, this->values_dofs, this->values_quad,
+               this->gradients_quad, face_no, subface_index,
+               integrate_val, integrate_grad);
+
+#ifdef DEBUG
+  this->dof_values_initialized = true;
+#endif
+}
+
+
+
+template <int dim, int fe_degree,  int n_q_points_1d, int n_components_,
+          typename Number>
+inline
+Point<dim,VectorizedArray<Number> >
+FEFaceEvaluation<dim,fe_degree,n_q_points_1d,n_components_,Number>
+::quadrature_point (const unsigned int q) const
+{
+  Assert (this->quadrature_points != 0, ExcNotInitialized());
+  AssertIndexRange (q, n_q_points);
+  return this->quadrature_points[q];
+}
+
+
+
+template <int dim, int fe_degree,  int n_q_points_1d, int n_components_,
+          typename Number>
+inline
+Tensor<1,dim,VectorizedArray<Number> >
+FEFaceEvaluation<dim,fe_degree,n_q_points_1d,n_components_,Number>
+::get_normal_vector (const unsigned int q) const
+{
+  Assert (normal_vectors != 0, ExcNotInitialized());
+  AssertIndexRange (q, n_q_points);
+  return normal_vectors[q];
+}
+
+
+
+namespace internal
+{
+  // helper functions to access the components of the value_type of
+  // FEEvaluationAccess, which is a plain VectorizedArray for scalar fields
+  // and a Tensor for vector-valued ones
+  template <typename Number>
+  inline
+  VectorizedArray<Number> &
+  face_value_component (VectorizedArray<Number> &value,
+                        const unsigned int)
+  {
+    return value;
+  }
+
+  template <int n_components, typename Number>
+  inline
+  VectorizedArray<Number> &
+  face_value_component (Tensor<1,n_components,VectorizedArray<Number> > &value,
+                        const unsigned int component)
+  {
+    return value[component];
+  }
+}
+
+
+
+template <int dim, int fe_degree,  int n_q_points_1d, int n_components_,
+          typename Number>
+inline
+typename FEFaceEvaluation<dim,fe_degree,n_q_points_1d,n_components_,Number>::value_type
+FEFaceEvaluation<dim,fe_degree,n_q_points_1d,n_components_,Number>
+::get_normal_derivative (const unsigned int q) const
+{
+  Assert (this->gradients_quad_initialized==true,
+          internal::ExcAccessToUninitializedField());
+  AssertIndexRange (q, n_q_points);
+
+  // compute the normal vector times the inverse transpose Jacobian first,
+  // which can then be contracted with the reference gradient
+  const Tensor<2,dim,VectorizedArray<Number> > &jac = this->jacobian[q];
+  VectorizedArray<Number> normal_jac[dim];
+  for (unsigned int e=0; e<dim; ++e)
+    {
+      normal_jac[e] = normal_vectors[q][0] * jac[0][e];
+      for (unsigned int d=1; d<dim; ++d)
+        normal_jac[e] += normal_vectors[q][d] * jac[d][e];
+    }
+
+  value_type result;
+  for (unsigned int c=0; c<n_components; ++c)
+    {
+      VectorizedArray<Number> &res = internal::face_value_component(result, c);
+      res = normal_jac[0] * this->gradients_quad[c][0][q];
+      for (unsigned int e=1; e<dim; ++e)
+        res += normal_jac[e] * this->gradients_quad[c][e][q];
+    }
+  return result;
+}
+
+
+
+template <int dim, int fe_degree,  int n_q_points_1d, int n_components_,
+          typename Number>
+inline
+void
+FEFaceEvaluation<dim,fe_degree,n_q_points_1d,n_components_,Number>
+::submit_normal_derivative (const value_type   grad_in,
+                            const unsigned int q)
+{
+  AssertIndexRange (q, n_q_points);
+#ifdef DEBUG
+  this->gradients_quad_submitted = true;
+#endif
+
+  const Tensor<2,dim,VectorizedArray<Number> > &jac = this->jacobian[q];
+  VectorizedArray<Number> normal_jac[dim];
+  for (unsigned int e=0; e<dim; ++e)
+    {
+      normal_jac[e] = normal_vectors[q][0] * jac[0][e];
+      for (unsigned int d=1; d<dim; ++d)
+        normal_jac[e] += normal_vectors[q][d] * jac[d][e];
+      normal_jac[e] *= this->J_value[q];
+    }
+
+  value_type value = grad_in;
+  for (unsigned int c=0; c<n_components; ++c)
+    {
+      const VectorizedArray<Number> val = internal::face_value_component(value, c);
+      for (unsigned int e=0; e<dim; ++e)
+        this->gradients_quad[c][e][q] = normal_jac[e] * val;
+    }
+}
+
+
+
+template <int dim, int fe_degree,  int n_q_points_1d, int n_components_,
+          typename Number>
+inline
+types::boundary_id
+FEFaceEvaluation<dim,fe_degree,n_q_points_1d,n_components_,Number>
+::boundary_id () const
+{
+  Assert (this->cell != numbers::invalid_unsigned_int, ExcNotInitialized());
+  return this->matrix_info->get_face_info(this->cell).boundary_id;
+}
+
+
+
 #endif  // ifndef DOXYGEN
 
 
@@ -1,6 +1,6 @@
 // ---------------------------------------------------------------------
 //
-// Copyright (C) 2011 - 2016 by the deal.II authors
+// Copyright (C) 2011 - 2017 by the deal.II authors
 //
 // This file is part of the deal.II library.
 //
@@ -55,6 +55,31 @@ namespace internal
        */
       std::size_t memory_consumption () const;
 
+      /**
+       * Return the range of macro cells of the given chunk of cells in the
+       * order of the parallel loop, taking into account the position of the
+       * chunk of size block_size_last.
+       */
+      std::pair<unsigned int,unsigned int>
+      get_block_range (const unsigned int block) const;
+
+      /**
+       * Compute the critical path and the number of chunks at each level of
+       * the task graph and store them in the statistics fields below. Called
+       * after the successor lists of the task graph have been set up.
+       */
+      void compute_task_graph_statistics ();
+
+      /**
+       * Print statistics on the load balance of the task graph, i.e., the
+       * number of chunks and dependencies, the length of the critical path
+       * in macro cells, the resulting average parallelism, and the minimal,
+       * average and maximal number of chunks that can run concurrently at
+       * each level of the graph. Prints nothing if the task graph scheme is
+       * not in use.
+       */
+      void print_task_graph_statistics (std::ostream &out) const;
+
       unsigned int block_size;
       unsigned int n_blocks;
       unsigned int block_size_last;
@@ -62,6 +87,13 @@ namespace internal
       bool use_multithreading;
       bool use_partition_partition;
       bool use_coloring_only;
+      bool use_task_graph;
+
+      /**
+       * Whether the loops should overlap the exchange of ghost data with
+       * computations on cells that do not touch ghost degrees of freedom.
+       */
+      bool overlap_communication_computation;
 
       std::vector<unsigned int> partition_color_blocks_row_index;
       std::vector<unsigned int> partition_color_blocks_data;
@@ -74,6 +106,32 @@ namespace internal
       std::vector<unsigned int> partition_odds;
       std::vector<unsigned int> partition_n_blocked_workers;
       std::vector<unsigned int> partition_n_workers;
+
+      /**
+       * The dependencies of the task graph scheme, with the chunks numbered
+       * in the order of the loop: For each chunk, the number of chunks that
+       * need to be completed before the chunk can start, and the successors
+       * of each chunk stored in compressed row format.
+       */
+      std::vector<unsigned int> task_graph_n_predecessors;
+      std::vector<unsigned int> task_graph_successors_row_index;
+      std::vector<unsigned int> task_graph_successors;
+
+      /**
+       * The number of chunks at the beginning of the loop that contain cells
+       * touching ghost entries of vectors. These chunks need to wait for the
+       * import of ghost values and must be done before the export of the
+       * ghost contributions can start.
+       */
+      unsigned int task_graph_n_boundary_blocks;
+
+      /**
+       * Statistics on the task graph: the number of macro cells along the
+       * critical path and the number of levels of the graph, where the level
+       * of a chunk is the length of the longest chain of predecessors.
+       */
+      unsigned int task_graph_critical_path;
+      std::vector<unsigned int> task_graph_blocks_per_level;
     };
 
 
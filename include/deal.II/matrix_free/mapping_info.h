@@ -25,6 +25,7 @@
 #include <deal.II/fe/fe.h>
 #include <deal.II/fe/mapping.h>
 #include <deal.II/matrix_free/helper_functions.h>
+#include <deal.II/matrix_free/face_info.h>
 
 #include <memory>
 
@@ -75,13 +76,33 @@ namespace internal
        * for different kinds of iterators, e.g. standard DoFHandler,
        * multigrid, etc.)  on a fixed Triangulation. In addition, a mapping
        * and several quadrature formulas are given.
+       *
+       * If @p compute_jacobians_on_the_fly is set, the Jacobian data of
+       * general cells is not stored but only the support points of the
+       * mapping, see compute_jacobians_on_the_fly().
        */
       void initialize (const dealii::Triangulation<dim>                &tria,
                        const std::vector<std::pair<unsigned int,unsigned int> > &cells,
                        const std::vector<unsigned int>         &active_fe_index,
                        const Mapping<dim>                      &mapping,
                        const std::vector<dealii::hp::QCollection<1> >  &quad,
-                       const UpdateFlags                        update_flags);
+                       const UpdateFlags                        update_flags,
+                       const bool                               compute_jacobians_on_the_fly = false);
+
+      /**
+       * Compute the geometry information on the faces given by @p face_info,
+       * with the cells specified by level and index in @p cells as for the
+       * initialize() function. The data is computed for the first quadrature
+       * formula of each entry in @p quad, i.e., the hp case is not supported
+       * for faces. Must be called after initialize() because the latter
+       * clears all data.
+       */
+      void initialize_faces (const dealii::Triangulation<dim>                &tria,
+                             const std::vector<std::pair<unsigned int,unsigned int> > &cells,
+                             const FaceInfo<VectorizedArray<Number>::n_array_elements> &face_info,
+                             const Mapping<dim>                      &mapping,
+                             const std::vector<dealii::hp::QCollection<1> >  &quad,
+                             const UpdateFlags                        update_flags_faces);
 
       /**
        * Helper function to determine which update flags must be set in the
@@ -102,6 +123,26 @@ namespace internal
        */
       unsigned int get_cell_data_index (const unsigned int cell_chunk_no) const;
 
+      /**
+       * Compute the inverse Jacobians (in the transposed format of
+       * MappingInfoDependent::jacobians) and the JxW values on all
+       * quadrature points of the general cell with index @p cell_data_index
+       * (as returned by get_cell_data_index()) for the quadrature formula @p
+       * quad_no with hp index @p active_quad_index. The data is interpolated
+       * from the positions in mapping_support_points by sum factorization. The
+       * output arrays must hold as many entries as there are quadrature
+       * points, and @p scratch is resized as necessary. Only available if
+       * the data has been initialized with @p compute_jacobians_on_the_fly
+       * set.
+       */
+      void compute_jacobians_on_the_fly
+      (const unsigned int                          cell_data_index,
+       const unsigned int                          quad_no,
+       const unsigned int                          active_quad_index,
+       AlignedVector<VectorizedArray<Number> >    &scratch,
+       Tensor<2,dim,VectorizedArray<Number> >     *inverse_jacobians,
+       VectorizedArray<Number>                    *JxW_values) const;
+
       /**
        * Clear all data fields in this class.
        */
@@ -222,6 +263,23 @@ namespace internal
          */
         AlignedVector<Point<dim,VectorizedArray<Number> > > quadrature_points;
 
+        /**
+         * The values of the 1D Lagrange polynomials through the support
+         * points of the mapping (see MappingInfo::mapping_support_points)
+         * evaluated in the points of the 1D quadrature formula, for each hp
+         * quadrature index. The value of polynomial @p i in point @p q is
+         * stored at position <code>q*(mapping_degree+1)+i</code>. Only
+         * filled if the Jacobians are computed on the fly.
+         */
+        std::vector<AlignedVector<VectorizedArray<Number> > > mapping_shape_values;
+
+        /**
+         * The derivatives of the 1D Lagrange polynomials through the support
+         * points of the mapping, in the same format as @p
+         * mapping_shape_values.
+         */
+        std::vector<AlignedVector<VectorizedArray<Number> > > mapping_shape_gradients;
+
         /**
          * The dim-dimensional quadrature formula underlying the problem
          * (constructed from a 1D tensor product quadrature formula).
@@ -289,6 +347,64 @@ namespace internal
        */
       std::vector<MappingInfoDependent> mapping_data_gen;
 
+      /**
+       * Definition of a structure that stores the geometry data on faces for
+       * a given quadrature formula. All faces are treated as general, i.e.,
+       * the data is stored on every quadrature point of every face batch in
+       * the order given by FaceInfo::faces, with the quadrature point index
+       * running fastest.
+       */
+      struct FaceMappingInfo
+      {
+        /**
+         * The number of quadrature points on a face.
+         */
+        unsigned int n_q_points;
+
+        /**
+         * The (dim-1)-dimensional quadrature formula on faces, constructed
+         * from a 1D quadrature formula by a tensor product.
+         */
+        Quadrature<dim-1> quadrature;
+
+        /**
+         * The surface element times the quadrature weight on each quadrature
+         * point of the faces.
+         */
+        AlignedVector<VectorizedArray<Number> > JxW_values;
+
+        /**
+         * The unit normal vector on each quadrature point of the faces. The
+         * normal points out of the cell on the "interior" side of the face.
+         */
+        AlignedVector<Tensor<1,dim,VectorizedArray<Number> > > normal_vectors;
+
+        /**
+         * The inverse Jacobian transformation (in the same transposed format
+         * as MappingInfoDependent::jacobians) of the cells adjacent to the
+         * face, evaluated on the quadrature points of the face. The first
+         * entry refers to the cell on the "interior" side, the second to the
+         * "exterior" side. The latter is only filled for interior faces.
+         */
+        AlignedVector<Tensor<2,dim,VectorizedArray<Number> > > jacobians[2];
+
+        /**
+         * The quadrature points in real coordinates. Only filled if
+         * update_quadrature_points was requested for faces.
+         */
+        AlignedVector<Point<dim,VectorizedArray<Number> > > quadrature_points;
+
+        /**
+         * Return the memory consumption in bytes.
+         */
+        std::size_t memory_consumption () const;
+      };
+
+      /**
+       * Contains the data on faces for each quadrature formula.
+       */
+      std::vector<FaceMappingInfo> face_data;
+
       /**
        * Stores whether JxW values have been initialized
        */
@@ -304,6 +420,31 @@ namespace internal
        */
       bool quadrature_points_initialized;
 
+      /**
+       * Stores whether the inverse Jacobians and JxW values of general cells
+       * are computed on the fly from mapping_support_points rather than
+       * being stored in MappingInfoDependent.
+       */
+      bool jacobians_on_the_fly;
+
+      /**
+       * The polynomial degree of the mapping, i.e., there are
+       * <tt>mapping_degree+1</tt> support points in each direction. Only set
+       * if @p jacobians_on_the_fly is true.
+       */
+      unsigned int mapping_degree;
+
+      /**
+       * The positions of the support points of the mapping on the general
+       * cells, placed in the tensor product of the Gauss-Lobatto points of
+       * <tt>mapping_degree+1</tt> points in lexicographic ordering. The data
+       * of the general cell with index get_cell_data_index() starts at
+       * position <code>get_cell_data_index(cell) *
+       * Utilities::fixed_power<dim>(mapping_degree+1)</code>. Only filled if
+       * @p jacobians_on_the_fly is true.
+       */
+      AlignedVector<Point<dim,VectorizedArray<Number> > > mapping_support_points;
+
       /**
        * Internal temporary data used for the initialization.
        */
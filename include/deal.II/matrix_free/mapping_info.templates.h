@@ -18,9 +18,12 @@
 
 #include <deal.II/base/utilities.h>
 #include <deal.II/base/memory_consumption.h>
+#include <deal.II/base/polynomial.h>
+#include <deal.II/base/quadrature_lib.h>
 #include <deal.II/fe/fe_nothing.h>
 #include <deal.II/fe/fe_values.h>
 #include <deal.II/fe/mapping_q1.h>
+#include <deal.II/fe/mapping_q.h>
 
 #include <deal.II/matrix_free/mapping_info.h>
 
@@ -39,7 +42,9 @@ namespace internal
       :
       JxW_values_initialized (false),
       second_derivatives_initialized (false),
-      quadrature_points_initialized (false)
+      quadrature_points_initialized (false),
+      jacobians_on_the_fly (false),
+      mapping_degree (0)
     {}
 
 
@@ -51,7 +56,11 @@ namespace internal
       JxW_values_initialized = false;
       quadrature_points_initialized = false;
       second_derivatives_initialized = false;
+      jacobians_on_the_fly = false;
+      mapping_degree = 0;
+      mapping_support_points.clear();
       mapping_data_gen.clear();
+      face_data.clear();
       cell_type.clear();
       cartesian_data.clear();
       affine_data.clear();
@@ -121,6 +130,75 @@ namespace internal
           return 1;
         else return tria.begin()->diameter();
       }
+
+
+
+      // apply the matrix with n_rows x n_columns entries stored row-wise in
+      // 'matrix' along the given direction of the tensor-product data 'in'
+      // with 'n_columns' entries in that direction, writing 'n_rows' entries
+      // in that direction to 'out'. The data before the direction has
+      // 'stride' entries and the data after 'n_blocks' entries.
+      template <typename Number>
+      void apply_matrix_1d (const VectorizedArray<Number> *matrix,
+                            const unsigned int             n_rows,
+                            const unsigned int             n_columns,
+                            const unsigned int             stride,
+                            const unsigned int             n_blocks,
+                            const VectorizedArray<Number> *in,
+                            VectorizedArray<Number>       *out)
+      {
+        for (unsigned int b=0; b<n_blocks; ++b)
+          {
+            for (unsigned int s=0; s<stride; ++s)
+              for (unsigned int r=0; r<n_rows; ++r)
+                {
+                  VectorizedArray<Number> sum = matrix[r*n_columns] * in[s];
+                  for (unsigned int c=1; c<n_columns; ++c)
+                    sum += matrix[r*n_columns+c] * in[c*stride+s];
+                  out[r*stride+s] = sum;
+                }
+            in += stride*n_columns;
+            out += stride*n_rows;
+          }
+      }
+
+
+
+      // Place the points of the tensor product formula 'quad_1d' on the face
+      // 'face_no' of the unit cell. As opposed to QProjector, we always
+      // enumerate the tangential directions of the face in increasing order
+      // of the coordinate directions, which is the order in which
+      // FEFaceEvaluation evaluates the tensor product on the face. If
+      // 'subface_index' is a valid number, the points are placed on the
+      // subface encoded as in FaceToCellTopology::subface_index instead.
+      template <int dim>
+      std::vector<Point<dim> >
+      get_face_points (const Quadrature<1> &quad_1d,
+                       const unsigned int   face_no,
+                       const unsigned int   subface_index)
+      {
+        const unsigned int n_q_points_1d = quad_1d.size();
+        const unsigned int n_q_points =
+          dim > 1 ? Utilities::fixed_power<dim-1>(n_q_points_1d) : 1;
+        std::vector<Point<dim> > points (n_q_points);
+        for (unsigned int q=0; q<n_q_points; ++q)
+          {
+            unsigned int index = q;
+            for (unsigned int d=0, t=0; d<dim; ++d)
+              if (d == face_no/2)
+                points[q][d] = face_no%2;
+              else
+                {
+                  points[q][d] = quad_1d.point(index%n_q_points_1d)[0];
+                  index /= n_q_points_1d;
+                  if (subface_index != numbers::invalid_unsigned_int)
+                    points[q][d] = 0.5 * (points[q][d] +
+                                          ((subface_index >> t) & 1));
+                  ++t;
+                }
+          }
+        return points;
+      }
     }
 
 
@@ -133,7 +211,8 @@ namespace internal
      const std::vector<unsigned int>                          &active_fe_index,
      const Mapping<dim>                                       &mapping,
      const std::vector<dealii::hp::QCollection<1> >           &quad,
-     const UpdateFlags                                         update_flags_input)
+     const UpdateFlags                                         update_flags_input,
+     const bool                                                compute_jacobians_on_the_fly)
     {
       clear();
       const unsigned int n_quads = quad.size();
@@ -158,6 +237,42 @@ namespace internal
       if (update_flags & update_quadrature_points)
         quadrature_points_initialized = true;
 
+      // when computing the Jacobians on the fly, we only store the support
+      // points of the mapping on general cells, placed at the Gauss-Lobatto
+      // points which are the support points of MappingQGeneric
+      jacobians_on_the_fly = compute_jacobians_on_the_fly;
+      std_cxx11::shared_ptr<dealii::FEValues<dim> > fe_values_support_points;
+      std::vector<Polynomials::Polynomial<double> > mapping_polynomials;
+      if (jacobians_on_the_fly)
+        {
+          AssertThrow ((update_flags_input & update_hessians) == 0 &&
+                       (update_flags_input & update_jacobian_grads) == 0,
+                       ExcMessage("Second derivatives are not supported when "
+                                  "computing the Jacobians on the fly"));
+          second_derivatives_initialized = false;
+
+          if (const MappingQGeneric<dim> *mapping_q_generic =
+                dynamic_cast<const MappingQGeneric<dim> *>(&mapping))
+            mapping_degree = mapping_q_generic->get_degree();
+          else if (const MappingQ<dim> *mapping_q =
+                     dynamic_cast<const MappingQ<dim> *>(&mapping))
+            mapping_degree = mapping_q->get_degree();
+          else
+            AssertThrow (false,
+                         ExcMessage("Computing the Jacobians on the fly is only "
+                                    "supported for MappingQGeneric and MappingQ"));
+
+          const QGaussLobatto<1> support_points_1d (mapping_degree+1);
+          mapping_polynomials =
+            Polynomials::generate_complete_Lagrange_basis(support_points_1d.get_points());
+          fe_values_support_points.reset
+          (new dealii::FEValues<dim> (mapping, dummy_fe,
+                                      Quadrature<dim>(support_points_1d),
+                                      update_quadrature_points));
+        }
+      const unsigned int n_mapping_points =
+        jacobians_on_the_fly ? Utilities::fixed_power<dim>(mapping_degree+1) : 0;
+
       // when we make comparisons about the size of Jacobians we need to know
       // the approximate size of typical entries in Jacobians. We need to fix
       // the Jacobian size once and for all. We choose the diameter of the
@@ -185,6 +300,11 @@ namespace internal
               step_size_cartesian (n_hp_quads);
           if (n_hp_quads > 1)
             current_data.quad_index_conversion.resize(n_hp_quads);
+          if (jacobians_on_the_fly)
+            {
+              current_data.mapping_shape_values.resize (n_hp_quads);
+              current_data.mapping_shape_gradients.resize (n_hp_quads);
+            }
           for (unsigned int q=0; q<n_hp_quads; ++q)
             {
               n_q_points_1d[q] = quad[my_q][q].size();
@@ -208,6 +328,28 @@ namespace internal
               if (n_hp_quads > 1)
                 current_data.quad_index_conversion[q] = n_q_points;
 
+              // evaluate the 1D polynomials of the mapping in the quadrature
+              // points
+              if (jacobians_on_the_fly)
+                {
+                  const unsigned int n_mapping_points_1d = mapping_degree+1;
+                  current_data.mapping_shape_values[q].resize
+                  (n_q_points_1d[q]*n_mapping_points_1d);
+                  current_data.mapping_shape_gradients[q].resize
+                  (n_q_points_1d[q]*n_mapping_points_1d);
+                  std::vector<double> values(2);
+                  for (unsigned int i=0; i<n_q_points_1d[q]; ++i)
+                    for (unsigned int j=0; j<n_mapping_points_1d; ++j)
+                      {
+                        mapping_polynomials[j].value(quad[my_q][q].point(i)[0],
+                                                     values);
+                        current_data.mapping_shape_values[q][i*n_mapping_points_1d+j] =
+                          values[0];
+                        current_data.mapping_shape_gradients[q][i*n_mapping_points_1d+j] =
+                          values[1];
+                      }
+                }
+
               // To walk on the diagonal for lexicographic ordering, we have
               // to jump one index ahead in each direction. For direction 0,
               // this is just the next point, for direction 1, it means adding
@@ -381,7 +523,27 @@ namespace internal
                     {
                       Assert (most_general_type == general, ExcInternalError());
                       insert_position = current_data.rowstart_jacobians.size();
-                      if (current_data.rowstart_jacobians.size() == 0)
+
+                      // store the support points of the mapping in the
+                      // lexicographic order of the Gauss-Lobatto points
+                      if (jacobians_on_the_fly)
+                        {
+                          const unsigned int old_size = mapping_support_points.size();
+                          AssertDimension (old_size, insert_position*n_mapping_points);
+                          mapping_support_points.resize (old_size+n_mapping_points);
+                          for (unsigned int j=0; j<vectorization_length; ++j)
+                            {
+                              typename dealii::Triangulation<dim>::cell_iterator
+                              cell_it (&tria, cells[cell*vectorization_length+j].first,
+                                       cells[cell*vectorization_length+j].second);
+                              fe_values_support_points->reinit(cell_it);
+                              for (unsigned int i=0; i<n_mapping_points; ++i)
+                                for (unsigned int d=0; d<dim; ++d)
+                                  mapping_support_points[old_size+i][d][j] =
+                                    fe_values_support_points->quadrature_point(i)[d];
+                            }
+                        }
+                      else if (current_data.rowstart_jacobians.size() == 0)
                         {
                           unsigned int reserve_size = (n_macro_cells-cell+1)/2;
                           current_data.rowstart_jacobians.reserve
@@ -423,7 +585,11 @@ namespace internal
                       AssertDimension (previous_size,
                                        current_data.jacobians_grad_upper.size());
                     }
-                  for (unsigned int q=0; q<n_q_points; ++q)
+                  // when computing the Jacobians on the fly, the support points
+                  // stored above are all we need
+                  const unsigned int n_q_points_stored =
+                    jacobians_on_the_fly ? 0 : n_q_points;
+                  for (unsigned int q=0; q<n_q_points_stored; ++q)
                     {
                       Tensor<2,dim,VectorizedArray<Number> > &jac = data.general_jac[q];
                       Tensor<3,dim,VectorizedArray<Number> > &jacobian_grad = data.general_jac_grad[q];
@@ -823,6 +989,301 @@ namespace internal
 
 
 
+    template <int dim, typename Number>
+    void
+    MappingInfo<dim,Number>::initialize_faces
+    (const dealii::Triangulation<dim>                          &tria,
+     const std::vector<std::pair<unsigned int,unsigned int> >  &cells,
+     const FaceInfo<VectorizedArray<Number>::n_array_elements> &face_info,
+     const Mapping<dim>                                        &mapping,
+     const std::vector<dealii::hp::QCollection<1> >            &quad,
+     const UpdateFlags                                          update_flags_faces)
+    {
+      const unsigned int vectorization_length =
+        VectorizedArray<Number>::n_array_elements;
+      const unsigned int n_faces = face_info.faces.size();
+      const unsigned int n_inner_faces = face_info.n_inner_face_batches +
+                                         face_info.n_ghost_inner_face_batches;
+      const double jacobian_size = internal::get_jacobian_size(tria);
+
+      face_data.clear();
+      face_data.resize (quad.size());
+
+      FE_Nothing<dim> dummy_fe;
+      const UpdateFlags update_flags_feval =
+        update_jacobians |
+        ((update_flags_faces & update_quadrature_points) || n_inner_faces > 0 ?
+         update_quadrature_points : update_default);
+
+      for (unsigned int my_q=0; my_q<quad.size(); ++my_q)
+        {
+          FaceMappingInfo &current_data = face_data[my_q];
+          AssertDimension (quad[my_q].size(), 1);
+          const Quadrature<1> &quad_1d = quad[my_q][0];
+          const unsigned int n_q_points_1d = quad_1d.size();
+          const unsigned int n_q_points =
+            dim > 1 ? Utilities::fixed_power<dim-1>(n_q_points_1d) : 1;
+          current_data.n_q_points = n_q_points;
+          current_data.quadrature = Quadrature<dim-1>(quad_1d);
+          AssertDimension (current_data.quadrature.size(), n_q_points);
+
+          if (n_faces == 0)
+            continue;
+
+          // Place the quadrature points on each of the faces of the unit
+          // cell. The evaluators for the subfaces seen from the coarser side
+          // of faces with hanging nodes are only created when needed
+          std::vector<std_cxx11::shared_ptr<dealii::FEValues<dim> > >
+          fe_values (GeometryInfo<dim>::faces_per_cell);
+          for (unsigned int f=0; f<GeometryInfo<dim>::faces_per_cell; ++f)
+            fe_values[f].reset (new dealii::FEValues<dim>
+                                (mapping, dummy_fe,
+                                 Quadrature<dim>(internal::get_face_points<dim>
+                                                 (quad_1d, f,
+                                                  numbers::invalid_unsigned_int)),
+                                 update_flags_feval));
+          std::vector<std_cxx11::shared_ptr<dealii::FEValues<dim> > >
+          fe_values_subface (GeometryInfo<dim>::faces_per_cell *
+                             GeometryInfo<dim>::max_children_per_face);
+
+          current_data.JxW_values.resize (n_faces*n_q_points);
+          current_data.normal_vectors.resize (n_faces*n_q_points);
+          current_data.jacobians[0].resize (n_faces*n_q_points);
+          current_data.jacobians[1].resize (n_inner_faces*n_q_points);
+          if (update_flags_faces & update_quadrature_points)
+            current_data.quadrature_points.resize (n_faces*n_q_points);
+
+          for (unsigned int face=0; face<n_faces; ++face)
+            {
+              const FaceToCellTopology<vectorization_length> &face_top =
+                face_info.faces[face];
+              const unsigned int offset = face*n_q_points;
+              for (unsigned int v=0; v<vectorization_length; ++v)
+                {
+                  // fill up empty lanes with the data of the first lane in
+                  // order to avoid divisions by zero in user code
+                  if (face_top.cells_interior[v] == numbers::invalid_unsigned_int)
+                    {
+                      Assert (v > 0, ExcInternalError());
+                      for (unsigned int q=0; q<n_q_points; ++q)
+                        {
+                          current_data.JxW_values[offset+q][v] =
+                            current_data.JxW_values[offset+q][0];
+                          for (unsigned int d=0; d<dim; ++d)
+                            {
+                              current_data.normal_vectors[offset+q][d][v] =
+                                current_data.normal_vectors[offset+q][d][0];
+                              for (unsigned int e=0; e<dim; ++e)
+                                {
+                                  current_data.jacobians[0][offset+q][d][e][v] =
+                                    current_data.jacobians[0][offset+q][d][e][0];
+                                  if (face < n_inner_faces)
+                                    current_data.jacobians[1][offset+q][d][e][v] =
+                                      current_data.jacobians[1][offset+q][d][e][0];
+                                }
+                              if (current_data.quadrature_points.size() > 0)
+                                current_data.quadrature_points[offset+q][d][v] =
+                                  current_data.quadrature_points[offset+q][d][0];
+                            }
+                        }
+                      continue;
+                    }
+
+                  AssertIndexRange (face_top.cells_interior[v], cells.size());
+                  typename dealii::Triangulation<dim>::cell_iterator
+                  cell_it (&tria, cells[face_top.cells_interior[v]].first,
+                           cells[face_top.cells_interior[v]].second);
+                  const unsigned int face_no = face_top.interior_face_no;
+                  dealii::FEValues<dim> &fe_val = *fe_values[face_no];
+                  fe_val.reinit (cell_it);
+
+                  // the normal vector on the reference cell points into the
+                  // coordinate direction of the face, transformed to real
+                  // space by the inverse transpose of the Jacobian
+                  const double normal_sign = (face_no%2 == 0) ? -1. : 1.;
+                  for (unsigned int q=0; q<n_q_points; ++q)
+                    {
+                      const Tensor<2,dim> inv_jac =
+                        Tensor<2,dim>(fe_val.jacobian(q).covariant_form());
+                      Tensor<1,dim> normal;
+                      for (unsigned int d=0; d<dim; ++d)
+                        normal[d] = normal_sign * inv_jac[d][face_no/2];
+                      const double normal_length = normal.norm();
+                      current_data.JxW_values[offset+q][v] =
+                        std::abs(fe_val.jacobian(q).determinant()) *
+                        normal_length * current_data.quadrature.weight(q);
+                      for (unsigned int d=0; d<dim; ++d)
+                        {
+                          current_data.normal_vectors[offset+q][d][v] =
+                            normal[d] / normal_length;
+                          for (unsigned int e=0; e<dim; ++e)
+                            current_data.jacobians[0][offset+q][d][e][v] =
+                              inv_jac[d][e];
+                          if (current_data.quadrature_points.size() > 0)
+                            current_data.quadrature_points[offset+q][d][v] =
+                              fe_val.quadrature_point(q)[d];
+                        }
+                    }
+
+                  if (face >= n_inner_faces)
+                    continue;
+
+                  // for the exterior side, we also need the inverse Jacobian
+                  // on the cell behind the face. Ghost cells are not part of
+                  // the cells field, so access them via the neighbor
+                  std::vector<Point<dim> > interior_points
+                  (fe_val.get_quadrature_points());
+                  typename dealii::Triangulation<dim>::cell_iterator
+                  neighbor = cell_it->neighbor(face_no);
+                  Assert (face_top.cells_exterior[v] >= cells.size() ||
+                          (static_cast<unsigned int>(neighbor->level()) ==
+                           cells[face_top.cells_exterior[v]].first &&
+                           static_cast<unsigned int>(neighbor->index()) ==
+                           cells[face_top.cells_exterior[v]].second),
+                          ExcInternalError());
+                  dealii::FEValues<dim> *fe_val_ext =
+                    fe_values[face_top.exterior_face_no].get();
+                  if (face_top.subface_index != numbers::invalid_unsigned_int)
+                    {
+                      AssertIndexRange (face_top.subface_index,
+                                        GeometryInfo<dim>::max_children_per_face);
+                      std_cxx11::shared_ptr<dealii::FEValues<dim> > &fe_val_sub =
+                        fe_values_subface[face_top.exterior_face_no *
+                                          GeometryInfo<dim>::max_children_per_face +
+                                          face_top.subface_index];
+                      if (fe_val_sub.get() == 0)
+                        fe_val_sub.reset (new dealii::FEValues<dim>
+                                          (mapping, dummy_fe,
+                                           Quadrature<dim>(internal::get_face_points<dim>
+                                                           (quad_1d,
+                                                            face_top.exterior_face_no,
+                                                            face_top.subface_index)),
+                                           update_flags_feval));
+                      fe_val_ext = fe_val_sub.get();
+                    }
+                  fe_val_ext->reinit (neighbor);
+                  for (unsigned int q=0; q<n_q_points; ++q)
+                    {
+                      AssertThrow (interior_points[q].distance
+                                   (fe_val_ext->quadrature_point(q)) <
+                                   1e-8 * jacobian_size,
+                                   ExcMessage("The quadrature points on the two "
+                                              "sides of a face do not match. "
+                                              "Faces where the two adjacent "
+                                              "cells have different "
+                                              "orientation are not supported "
+                                              "in MatrixFree."));
+                      const Tensor<2,dim> inv_jac =
+                        Tensor<2,dim>(fe_val_ext->jacobian(q).covariant_form());
+                      for (unsigned int d=0; d<dim; ++d)
+                        for (unsigned int e=0; e<dim; ++e)
+                          current_data.jacobians[1][offset+q][d][e][v] =
+                            inv_jac[d][e];
+                    }
+                }
+            }
+        }
+    }
+
+
+
+    template <int dim, typename Number>
+    void
+    MappingInfo<dim,Number>::compute_jacobians_on_the_fly
+    (const unsigned int                          cell_data_index,
+     const unsigned int                          quad_no,
+     const unsigned int                          active_quad_index,
+     AlignedVector<VectorizedArray<Number> >    &scratch,
+     Tensor<2,dim,VectorizedArray<Number> >     *inverse_jacobians,
+     VectorizedArray<Number>                    *JxW_values) const
+    {
+      Assert (jacobians_on_the_fly == true, ExcNotInitialized());
+      AssertIndexRange (quad_no, mapping_data_gen.size());
+      const MappingInfoDependent &current_data = mapping_data_gen[quad_no];
+      AssertIndexRange (active_quad_index, current_data.mapping_shape_values.size());
+
+      const unsigned int n_points_1d = mapping_degree+1;
+      const unsigned int n_points = Utilities::fixed_power<dim>(n_points_1d);
+      const unsigned int n_q_points = current_data.n_q_points[active_quad_index];
+      const unsigned int n_q_points_1d =
+        current_data.mapping_shape_values[active_quad_index].size()/n_points_1d;
+      const unsigned int n_max_1d = std::max(n_points_1d, n_q_points_1d);
+      const unsigned int n_max = Utilities::fixed_power<dim>(n_max_1d);
+      AssertIndexRange ((cell_data_index+1)*n_points-1, mapping_support_points.size());
+
+      // scratch layout: the coordinates of the support points component by
+      // component, two temporary arrays for the sum factorization, and the
+      // derivatives of all components in all directions
+      scratch.resize (dim*(n_points+2*n_max+dim*n_q_points));
+      VectorizedArray<Number> *points = scratch.begin();
+      VectorizedArray<Number> *tmp[2] = {points + dim*n_points,
+                                         points + dim*(n_points+n_max)
+                                        };
+      VectorizedArray<Number> *derivatives = points + dim*(n_points+2*n_max);
+
+      const Point<dim,VectorizedArray<Number> > *support_points =
+        &mapping_support_points[cell_data_index*n_points];
+      for (unsigned int c=0; c<dim; ++c)
+        for (unsigned int i=0; i<n_points; ++i)
+          points[c*n_points+i] = support_points[i][c];
+
+      // compute the derivative in direction e of all components by applying
+      // the gradient matrix in direction e and the value matrix in the other
+      // directions, treating the components as an additional outer direction
+      for (unsigned int e=0; e<dim; ++e)
+        {
+          const VectorizedArray<Number> *in = points;
+          unsigned int stride = 1;
+          unsigned int n_blocks = dim*Utilities::fixed_power<dim-1>(n_points_1d);
+          for (unsigned int d=0; d<dim; ++d)
+            {
+              VectorizedArray<Number> *out = (d == dim-1) ?
+                                             derivatives + e*dim*n_q_points :
+                                             tmp[d%2];
+              internal::apply_matrix_1d (d == e ?
+                                         current_data.mapping_shape_gradients[active_quad_index].begin() :
+                                         current_data.mapping_shape_values[active_quad_index].begin(),
+                                         n_q_points_1d, n_points_1d, stride, n_blocks,
+                                         in, out);
+              stride *= n_q_points_1d;
+              n_blocks /= n_points_1d;
+              in = out;
+            }
+        }
+
+      // the Jacobian holds the derivative of component c in direction e in
+      // entry [c][e]; store its transposed inverse as done for the stored
+      // Jacobians
+      const VectorizedArray<Number> *weights =
+        current_data.quadrature_weights[active_quad_index].begin();
+      for (unsigned int q=0; q<n_q_points; ++q)
+        {
+          Tensor<2,dim,VectorizedArray<Number> > jac;
+          for (unsigned int c=0; c<dim; ++c)
+            for (unsigned int e=0; e<dim; ++e)
+              jac[c][e] = derivatives[(e*dim+c)*n_q_points+q];
+          JxW_values[q] = determinant(jac) * weights[q];
+          inverse_jacobians[q] = transpose(invert(jac));
+        }
+    }
+
+
+
+    template <int dim, typename Number>
+    std::size_t MappingInfo<dim,Number>::FaceMappingInfo::memory_consumption() const
+    {
+      std::size_t
+      memory = MemoryConsumption::memory_consumption (JxW_values);
+      memory += MemoryConsumption::memory_consumption (normal_vectors);
+      memory += MemoryConsumption::memory_consumption (jacobians[0]);
+      memory += MemoryConsumption::memory_consumption (jacobians[1]);
+      memory += MemoryConsumption::memory_consumption (quadrature_points);
+      memory += MemoryConsumption::memory_consumption (quadrature);
+      return memory;
+    }
+
+
+
     template <int dim, typename Number>
     std::size_t MappingInfo<dim,Number>::MappingInfoDependent::memory_consumption() const
     {
@@ -833,6 +1294,8 @@ namespace internal
       memory += MemoryConsumption::memory_consumption (jacobians_grad_upper);
       memory += MemoryConsumption::memory_consumption (rowstart_q_points);
       memory += MemoryConsumption::memory_consumption (quadrature_points);
+      memory += MemoryConsumption::memory_consumption (mapping_shape_values);
+      memory += MemoryConsumption::memory_consumption (mapping_shape_gradients);
       memory += MemoryConsumption::memory_consumption (quadrature);
       memory += MemoryConsumption::memory_consumption (face_quadrature);
       memory += MemoryConsumption::memory_consumption (quadrature_weights);
@@ -849,8 +1312,10 @@ namespace internal
     {
       std::size_t
       memory= MemoryConsumption::memory_consumption (mapping_data_gen);
+      memory += MemoryConsumption::memory_consumption (face_data);
       memory += MemoryConsumption::memory_consumption (affine_data);
       memory += MemoryConsumption::memory_consumption (cartesian_data);
+      memory += MemoryConsumption::memory_consumption (mapping_support_points);
       memory += MemoryConsumption::memory_consumption (cell_type);
       memory += sizeof (*this);
       return memory;
@@ -917,6 +1382,12 @@ namespace internal
       size_info.print_memory_statistics
       (out, MemoryConsumption::memory_consumption (affine_data) +
        MemoryConsumption::memory_consumption (cartesian_data));
+      if (jacobians_on_the_fly)
+        {
+          out << "    Memory mapping support points:   ";
+          size_info.print_memory_statistics
+          (out, MemoryConsumption::memory_consumption (mapping_support_points));
+        }
       for (unsigned int j=0; j<mapping_data_gen.size(); ++j)
         {
           out << "    Data component " << j << std::endl;
@@ -36,6 +36,7 @@
 #include <deal.II/matrix_free/shape_info.h>
 #include <deal.II/matrix_free/dof_info.h>
 #include <deal.II/matrix_free/mapping_info.h>
+#include <deal.II/matrix_free/face_info.h>
 
 #ifdef DEAL_II_WITH_THREADS
 #include <tbb/task.h>
@@ -127,13 +128,17 @@ public:
    * class should also allow for access to vectors without resolving
    * constraints.
    *
-   * The last two parameters allow the user to disable some of the
-   * initialization processes. For example, if only the scheduling that avoids
+   * The parameters @p initialize_indices and @p initialize_mapping allow the
+   * user to disable some of the initialization processes. For example, if only the scheduling that avoids
    * touching the same vector/matrix indices simultaneously is to be found,
    * the mapping needs not be initialized. Likewise, if the mapping has
    * changed from one iteration to the next but the topology has not (like
    * when using a deforming mesh with MappingQEulerian), it suffices to
    * initialize the mapping only.
+   *
+   * The last parameter @p overlap_communication_computation selects whether
+   * the loops overlap the MPI data exchange with computations on cells that
+   * do not touch ghost degrees of freedom.
    */
   struct AdditionalData
   {
@@ -160,7 +165,13 @@ public:
        * Use the traditional coloring algorithm: this is like
        * TasksParallelScheme::partition_color, but only uses one partition.
        */
-      color
+      color,
+      /**
+       * Run the chunks of cells as a dependency graph of tasks: each chunk
+       * starts as soon as all chunks it shares degrees of freedom with and
+       * that precede it in the loop order are done.
+       */
+      task_graph
     };
 
     // avoid warning about use of deprecated variables
@@ -175,15 +186,20 @@ public:
                     const unsigned int level_mg_handler = numbers::invalid_unsigned_int,
                     const bool                store_plain_indices = true,
                     const bool                initialize_indices = true,
-                    const bool                initialize_mapping = true)
+                    const bool                initialize_mapping = true,
+                    const bool                overlap_communication_computation = true)
       :
       tasks_parallel_scheme (tasks_parallel_scheme),
       tasks_block_size      (tasks_block_size),
       mapping_update_flags  (mapping_update_flags),
+      mapping_update_flags_boundary_faces (update_default),
+      mapping_update_flags_inner_faces (update_default),
       level_mg_handler      (level_mg_handler),
       store_plain_indices   (store_plain_indices),
       initialize_indices    (initialize_indices),
-      initialize_mapping    (initialize_mapping)
+      initialize_mapping    (initialize_mapping),
+      overlap_communication_computation (overlap_communication_computation),
+      compute_jacobians_on_the_fly (false)
     {};
 
     /**
@@ -205,10 +221,14 @@ public:
       tasks_parallel_scheme (tasks_parallel_scheme),
       tasks_block_size      (tasks_block_size),
       mapping_update_flags  (mapping_update_flags),
+      mapping_update_flags_boundary_faces (update_default),
+      mapping_update_flags_inner_faces (update_default),
       level_mg_handler      (level_mg_handler),
       store_plain_indices   (store_plain_indices),
       initialize_indices    (initialize_indices),
-      initialize_mapping    (initialize_mapping)
+      initialize_mapping    (initialize_mapping),
+      overlap_communication_computation (true),
+      compute_jacobians_on_the_fly (false)
     {} DEAL_II_DEPRECATED
 
     /**
@@ -223,7 +243,7 @@ public:
     MPI_Comm            mpi_communicator DEAL_II_DEPRECATED;
 
     /**
-     * Set the scheme for task parallelism. There are four options available.
+     * Set the scheme for task parallelism. There are five options available.
      * If set to @p none, the operator application is done in serial without
      * shared memory parallelism. If this class is used together with MPI and
      * MPI is also used for parallelism within the nodes, this flag should be
@@ -249,6 +269,21 @@ public:
      * hanging nodes, there are quite many colors (50 or more in 3D), which
      * might degrade parallel performance (bad cache behavior, many
      * synchronization points).
+     *
+     * The fourth option @p task_graph uses the same chunks and the same order
+     * of chunks as @p partition_color, but replaces the synchronization
+     * between the partitions and colors by a dependency graph between the
+     * chunks: Two chunks that access the same vector entries are connected
+     * by an edge pointing from the chunk that comes first in the order of
+     * the loop to the later one. The chunks are then scheduled by the work
+     * stealing of the task scheduler, and every chunk starts as soon as all
+     * its predecessors are done, without any global synchronization point.
+     * This avoids idle threads at the end of each color or partition, which
+     * becomes important on machines with many cores. Information on the
+     * graph, such as the length of the critical path and the average
+     * parallelism, can be printed by
+     * internal::MatrixFreeFunctions::TaskInfo::print_task_graph_statistics()
+     * on the object returned by MatrixFree::get_task_info().
      */
     TasksParallelScheme tasks_parallel_scheme;
 
@@ -276,6 +311,39 @@ public:
      */
     UpdateFlags         mapping_update_flags;
 
+    /**
+     * This flag determines the mapping data on boundary faces to be
+     * cached. Note that MatrixFree uses a separate loop layout for face
+     * integrals in order to effectively vectorize also in the case of hanging
+     * nodes (which require different subface settings on the two sides) or
+     * some cells in the batch of a VectorizedArray of cells that are adjacent
+     * to the boundary and others that are not.
+     *
+     * If set to a value different from update_default (the default), the
+     * face information is explicitly built. Currently, MatrixFree supports to
+     * cache the following data on faces: inverse Jacobians, Jacobian
+     * determinants (JxW), quadrature points, and normal vectors. The inverse
+     * Jacobians, JxW values, and normal vectors are always computed when face
+     * data is requested. Quadrature points need to be requested by
+     * update_quadrature_points.
+     */
+    UpdateFlags         mapping_update_flags_boundary_faces;
+
+    /**
+     * This flag determines the mapping data on interior faces to be
+     * cached. If set to a value different from update_default (the default),
+     * the interior faces are collected into batches for use with
+     * FEFaceEvaluation and MatrixFree::loop(). See the description of @p
+     * mapping_update_flags_boundary_faces for the data that is stored.
+     *
+     * Face integrals are currently only supported for meshes where the two
+     * cells adjacent to a face have matching orientation of the face and
+     * where hanging nodes stem from isotropic refinement, and for the
+     * DoFHandler case (not hp::DoFHandler). Faces with hanging nodes are
+     * placed such that the finer cell is on the interior side.
+     */
+    UpdateFlags         mapping_update_flags_inner_faces;
+
     /**
      * This option can be used to define whether we work on a certain level of
      * the mesh, and not the active cells. If set to invalid_unsigned_int
@@ -311,6 +379,50 @@ public:
      * independent cells should be computed).
      */
     bool                initialize_mapping;
+
+    /**
+     * Option to control whether the loops cell_loop() and loop() should
+     * overlap the exchange of ghost values and the compress operation of
+     * LinearAlgebra::distributed::Vector with computations. If set to true
+     * (the default), the cells are split into a set that does not touch
+     * degrees of freedom owned by other processors and a set that does. The
+     * former is processed while the messages started by
+     * update_ghost_values_start() and compress_start() are in flight, and
+     * only the latter waits for the data exchange to complete. If set to
+     * false, the import of ghost values is completed before the first cell
+     * is visited and the compress operation is started only after the last
+     * cell, with all cells processed in one sweep. This can be useful for
+     * measuring the benefit of the overlap or for MPI implementations that
+     * do not make progress on non-blocking messages in the background.
+     */
+    bool                overlap_communication_computation;
+
+    /**
+     * Option to control how the geometry of cells with a non-constant
+     * Jacobian (e.g. curved cells described by a higher order MappingQGeneric)
+     * is represented. If set to false (the default), the inverse Jacobian and
+     * the Jacobian determinant times the quadrature weight (JxW) are
+     * precomputed and stored for every quadrature point of those cells. For
+     * high-order mappings in 3D, this data is often larger than the solution
+     * vectors and the operator evaluation becomes limited by the memory
+     * bandwidth for loading the geometry.
+     *
+     * If set to true, only the positions of the $(p+1)^d$ support points of
+     * the mapping of degree $p$ are stored per cell, and FEEvaluation::reinit()
+     * recomputes the inverse Jacobians and JxW values in the quadrature points
+     * by sum factorization, in the same way as the gradients of the solution
+     * are computed. This trades the memory transfer of $d^2+1$ numbers per
+     * quadrature point for additional arithmetic operations. Cells detected
+     * as Cartesian or affine are not affected by this option, as their
+     * geometry is stored in compressed form anyway, and neither are face
+     * data and quadrature points.
+     *
+     * This option requires the mapping to be a MappingQGeneric or MappingQ,
+     * whose degree determines the interpolation of the geometry. Second
+     * derivatives (update_hessians in @p mapping_update_flags) are not
+     * supported in this mode.
+     */
+    bool                compute_jacobians_on_the_fly;
   };
 
   DEAL_II_ENABLE_EXTRA_DIAGNOSTICS
@@ -479,6 +591,14 @@ public:
    * a pointer to an object in this place if it has an <code>operator()</code>
    * with the correct set of arguments since such a pointer can be converted
    * to the function object.
+   *
+   * For vectors of type LinearAlgebra::distributed::Vector, the import of
+   * ghost values is started before the loop and finished only before the
+   * first cell that accesses ghost degrees of freedom is visited. Likewise,
+   * the compress operation is started as soon as the last such cell has been
+   * processed, and the remaining cells are done while the data is sent. This
+   * behavior can be switched off by
+   * AdditionalData::overlap_communication_computation.
    */
   template <typename OutVector, typename InVector>
   void cell_loop (const std_cxx11::function<void (const MatrixFree<dim,Number> &,
@@ -521,6 +641,187 @@ public:
                   OutVector      &dst,
                   const InVector &src) const;
 
+  /**
+   * This variant of cell_loop() additionally takes two function objects
+   * that are run on the locally owned vector entries, with the signature
+   * <code>operation (const unsigned int begin, const unsigned int
+   * end)</code> for the half-open range <tt>[begin, end)</tt> of the
+   * MPI-local indices of the vector. The function @p operation_before_loop
+   * is called on each entry of the locally owned range exactly once, just
+   * before the first cell that touches one of the entries in the range is
+   * processed. Similarly, @p operation_after_loop is called once for each
+   * entry right after the last cell that writes into it has been processed.
+   * This allows to merge vector updates that a solver performs before and
+   * after the operator evaluation into the cell loop while the data is
+   * still in the caches, rather than streaming the vectors once more through
+   * main memory. The index ranges are computed based on the indices of the
+   * DoFHandler with index @p dof_handler_index_pre_post, and both @p src and
+   * @p dst must be based on this DoFHandler.
+   *
+   * Entries that are sent to or received from other MPI processes are
+   * processed before the ghost data exchange is started and after the
+   * compress operation has finished, respectively, as are entries that are
+   * not touched by any cell. Thus, the operation before the loop may modify
+   * @p src, provided that its ghost values are not set on entry to this
+   * function, and the operation after the loop may modify both @p src and
+   * @p dst in the given range. Empty function objects are ignored.
+   *
+   * The ranges are only interleaved with the cell work when the loop is run
+   * without threads (AdditionalData::tasks_parallel_scheme set to @p none or
+   * a single thread). Otherwise, both operations are called on the whole
+   * locally owned range before and after the loop, respectively.
+   */
+  template <typename OutVector, typename InVector>
+  void cell_loop (const std_cxx11::function<void (const MatrixFree<dim,Number> &,
+                                                  OutVector &,
+                                                  const InVector &,
+                                                  const std::pair<unsigned int,
+                                                  unsigned int> &)> &cell_operation,
+                  OutVector      &dst,
+                  const InVector &src,
+                  const std_cxx11::function<void (const unsigned int,
+                                                  const unsigned int)> &operation_before_loop,
+                  const std_cxx11::function<void (const unsigned int,
+                                                  const unsigned int)> &operation_after_loop,
+                  const unsigned int dof_handler_index_pre_post = 0) const;
+
+  /**
+   * Same as the previous function, but with a pointer to a member function
+   * of class @p CLASS for the cell operation.
+   */
+  template <typename CLASS, typename OutVector, typename InVector>
+  void cell_loop (void (CLASS::*function_pointer)(const MatrixFree &,
+                                                  OutVector &,
+                                                  const InVector &,
+                                                  const std::pair<unsigned int,
+                                                  unsigned int> &)const,
+                  const CLASS    *owning_class,
+                  OutVector      &dst,
+                  const InVector &src,
+                  const std_cxx11::function<void (const unsigned int,
+                                                  const unsigned int)> &operation_before_loop,
+                  const std_cxx11::function<void (const unsigned int,
+                                                  const unsigned int)> &operation_after_loop,
+                  const unsigned int dof_handler_index_pre_post = 0) const;
+
+  /**
+   * Same as above, but for class member functions which are non-const.
+   */
+  template <typename CLASS, typename OutVector, typename InVector>
+  void cell_loop (void (CLASS::*function_pointer)(const MatrixFree &,
+                                                  OutVector &,
+                                                  const InVector &,
+                                                  const std::pair<unsigned int,
+                                                  unsigned int> &),
+                  CLASS          *owning_class,
+                  OutVector      &dst,
+                  const InVector &src,
+                  const std_cxx11::function<void (const unsigned int,
+                                                  const unsigned int)> &operation_before_loop,
+                  const std_cxx11::function<void (const unsigned int,
+                                                  const unsigned int)> &operation_after_loop,
+                  const unsigned int dof_handler_index_pre_post = 0) const;
+
+  /**
+   * This method runs a loop over all cells (in parallel) and performs the
+   * MPI data exchange on the source vector and destination vector. As
+   * opposed to the other variants that only runs a function on cells, this
+   * method also takes as arguments a function for the interior faces and
+   * for the boundary faces, respectively. The three function objects all
+   * have the signature <code>operation (const MatrixFree<dim,Number> &,
+   * OutVector &, InVector &, std::pair<unsigned int,unsigned int>
+   * &)</code>. For the cell operation, the last argument is a range of
+   * macro cells as in cell_loop(). For the face operations, it is a range of
+   * face batches that are passed to FEFaceEvaluation::reinit(). The interior
+   * faces are numbered from zero to n_inner_face_batches() (exclusive),
+   * whereas the boundary faces come after them, i.e., the ranges lie between
+   * n_inner_face_batches() and n_inner_face_batches() +
+   * n_boundary_face_batches() (exclusive).
+   *
+   * The face operations are only called if the MatrixFree object has been
+   * set up with face data, i.e., with
+   * AdditionalData::mapping_update_flags_inner_faces or
+   * AdditionalData::mapping_update_flags_boundary_faces set to a value
+   * different from update_default.
+   *
+   * The work on cells and faces that do not need ghost data is overlapped
+   * with the import of ghost values of the source vector. Note that this
+   * loop is currently run in serial, i.e., the setting of
+   * AdditionalData::tasks_parallel_scheme is ignored, because cells and
+   * faces write into the same vector entries.
+   */
+  template <typename OutVector, typename InVector>
+  void loop (const std_cxx11::function<void (const MatrixFree<dim,Number> &,
+                                             OutVector &,
+                                             const InVector &,
+                                             const std::pair<unsigned int,
+                                             unsigned int> &)> &cell_operation,
+             const std_cxx11::function<void (const MatrixFree<dim,Number> &,
+                                             OutVector &,
+                                             const InVector &,
+                                             const std::pair<unsigned int,
+                                             unsigned int> &)> &face_operation,
+             const std_cxx11::function<void (const MatrixFree<dim,Number> &,
+                                             OutVector &,
+                                             const InVector &,
+                                             const std::pair<unsigned int,
+                                             unsigned int> &)> &boundary_operation,
+             OutVector      &dst,
+             const InVector &src) const;
+
+  /**
+   * This is the second variant to run the loop over all cells, interior
+   * faces, and boundary faces, now providing three function pointers to
+   * member functions of class @p CLASS with the signature <code>operation
+   * (const MatrixFree<dim,Number> &, OutVector &, InVector &,
+   * std::pair<unsigned int,unsigned int>&)const</code>. This method obviates
+   * the need to call std_cxx11::bind to bind the class into the given
+   * function in case the local function needs to access data in the class
+   * (i.e., it is a non-static member function).
+   */
+  template <typename CLASS, typename OutVector, typename InVector>
+  void loop (void (CLASS::*cell_operation)(const MatrixFree &,
+                                           OutVector &,
+                                           const InVector &,
+                                           const std::pair<unsigned int,
+                                           unsigned int> &)const,
+             void (CLASS::*face_operation)(const MatrixFree &,
+                                           OutVector &,
+                                           const InVector &,
+                                           const std::pair<unsigned int,
+                                           unsigned int> &)const,
+             void (CLASS::*boundary_operation)(const MatrixFree &,
+                                               OutVector &,
+                                               const InVector &,
+                                               const std::pair<unsigned int,
+                                               unsigned int> &)const,
+             const CLASS    *owning_class,
+             OutVector      &dst,
+             const InVector &src) const;
+
+  /**
+   * Same as above, but for class member functions which are non-const.
+   */
+  template <typename CLASS, typename OutVector, typename InVector>
+  void loop (void (CLASS::*cell_operation)(const MatrixFree &,
+                                           OutVector &,
+                                           const InVector &,
+                                           const std::pair<unsigned int,
+                                           unsigned int> &),
+             void (CLASS::*face_operation)(const MatrixFree &,
+                                           OutVector &,
+                                           const InVector &,
+                                           const std::pair<unsigned int,
+                                           unsigned int> &),
+             void (CLASS::*boundary_operation)(const MatrixFree &,
+                                               OutVector &,
+                                               const InVector &,
+                                               const std::pair<unsigned int,
+                                               unsigned int> &),
+             CLASS          *owning_class,
+             OutVector      &dst,
+             const InVector &src) const;
+
   /**
    * In the hp adaptive case, a subrange of cells as computed during the cell
    * loop might contain elements of different degrees. Use this function to
@@ -678,6 +979,30 @@ public:
    */
   unsigned int n_macro_cells () const;
 
+  /**
+   * Return the number of batches of interior faces, i.e., the faces whose
+   * two adjacent cells are both present in the mesh, including those to
+   * cells on remote processors. The face range in the face operation of
+   * loop() runs from zero to this number. Returns zero if the class has not
+   * been set up for face integrals.
+   */
+  unsigned int n_inner_face_batches () const;
+
+  /**
+   * Return the number of batches of faces at the boundary of the domain.
+   * The boundary faces are numbered after the interior faces, i.e., the
+   * range in the boundary operation of loop() runs from
+   * n_inner_face_batches() to n_inner_face_batches() +
+   * n_boundary_face_batches().
+   */
+  unsigned int n_boundary_face_batches () const;
+
+  /**
+   * Return the boundary id of the faces in the given batch of boundary
+   * faces. All faces in a batch share the same boundary id.
+   */
+  types::boundary_id get_boundary_id (const unsigned int face_batch_number) const;
+
   /**
    * In case this structure was built based on a DoFHandler, this returns the
    * DoFHandler.
@@ -685,6 +1010,14 @@ public:
   const DoFHandler<dim> &
   get_dof_handler (const unsigned int fe_component = 0) const;
 
+  /**
+   * In case this structure was built for a level of a multigrid hierarchy
+   * (see AdditionalData::level_mg_handler), return that level, otherwise
+   * return numbers::invalid_unsigned_int.
+   */
+  unsigned int
+  get_level_mg_handler () const;
+
   /**
    * This returns the cell iterator in deal.II speak to a given cell in the
    * renumbering of this structure.
@@ -846,6 +1179,13 @@ public:
   const internal::MatrixFreeFunctions::DoFInfo &
   get_dof_info (const unsigned int fe_component = 0) const;
 
+  /**
+   * Return the connectivity between the face batch with the given index and
+   * the cells adjacent to it.
+   */
+  const internal::MatrixFreeFunctions::FaceToCellTopology<VectorizedArray<Number>::n_array_elements> &
+  get_face_info (const unsigned int face_batch_number) const;
+
   /**
    * Return the number of weights in the constraint pool.
    */
@@ -908,7 +1248,20 @@ private:
    */
   void
   initialize_indices (const std::vector<const ConstraintMatrix *> &constraint,
-                      const std::vector<IndexSet> &locally_owned_set);
+                      const std::vector<IndexSet> &locally_owned_set,
+                      const AdditionalData        &additional_data);
+
+  /**
+   * Collects the interior and boundary faces of the locally owned cells into
+   * batches for vectorized face integrals and fills the @p face_info
+   * structure. The vector @p ghost_cells contains the level and index of the
+   * cells on remote processors adjacent to locally owned cells, in the same
+   * order as their indices have been stored in
+   * DoFInfo::dof_indices_ghost_cells.
+   */
+  void
+  initialize_face_info (const AdditionalData &additional_data,
+                        const std::vector<std::pair<unsigned int,unsigned int> > &ghost_cells);
 
   /**
    * Initializes the DoFHandlers based on a DoFHandler<dim> argument.
@@ -984,6 +1337,11 @@ private:
    */
   internal::MatrixFreeFunctions::MappingInfo<dim,Number> mapping_info;
 
+  /**
+   * Holds the connectivity between faces and cells used for face integrals.
+   */
+  internal::MatrixFreeFunctions::FaceInfo<VectorizedArray<Number>::n_array_elements> face_info;
+
   /**
    * Contains shape value information on the unit cell.
    */
@@ -1115,6 +1473,51 @@ MatrixFree<dim,Number>::n_macro_cells () const
 
 
 
+template <int dim, typename Number>
+inline
+unsigned int
+MatrixFree<dim,Number>::n_inner_face_batches () const
+{
+  return face_info.n_inner_face_batches + face_info.n_ghost_inner_face_batches;
+}
+
+
+
+template <int dim, typename Number>
+inline
+unsigned int
+MatrixFree<dim,Number>::n_boundary_face_batches () const
+{
+  return face_info.n_boundary_face_batches;
+}
+
+
+
+template <int dim, typename Number>
+inline
+types::boundary_id
+MatrixFree<dim,Number>::get_boundary_id (const unsigned int face_batch_number) const
+{
+  Assert (face_batch_number >= n_inner_face_batches() &&
+          face_batch_number < n_inner_face_batches() + n_boundary_face_batches(),
+          ExcIndexRange (face_batch_number, n_inner_face_batches(),
+                         n_inner_face_batches() + n_boundary_face_batches()));
+  return face_info.faces[face_batch_number].boundary_id;
+}
+
+
+
+template <int dim, typename Number>
+inline
+const internal::MatrixFreeFunctions::FaceToCellTopology<VectorizedArray<Number>::n_array_elements> &
+MatrixFree<dim,Number>::get_face_info (const unsigned int face_batch_number) const
+{
+  AssertIndexRange (face_batch_number, face_info.faces.size());
+  return face_info.faces[face_batch_number];
+}
+
+
+
 template <int dim, typename Number>
 inline
 unsigned int
@@ -1256,7 +1659,7 @@ MatrixFree<dim,Number>::renumber_dofs (std::vector<types::global_dof_index> &ren
                                        const unsigned int vector_component)
 {
   AssertIndexRange(vector_component, dof_info.size());
-  dof_info[vector_component].renumber_dofs (renumbering);
+  dof_info[vector_component].renumber_dofs (renumbering, size_info);
 }
 
 
@@ -1284,6 +1687,16 @@ MatrixFree<dim,Number>::get_dof_handler (const unsigned int dof_index) const
 
 
 
+template <int dim, typename Number>
+inline
+unsigned int
+MatrixFree<dim,Number>::get_level_mg_handler () const
+{
+  return dof_handlers.level;
+}
+
+
+
 template <int dim, typename Number>
 inline
 typename DoFHandler<dim>::cell_iterator
@@ -2253,23 +2666,113 @@ namespace internal
   } // end of namespace color
 
 
+
+  // This defines the TBB data structures for the task graph variant: every
+  // chunk of cells is one task whose reference count holds the number of
+  // chunks that still need to be completed before it can start. Two
+  // additional tasks finish the import of ghost values before the chunks
+  // with ghost access, and start the export of ghost contributions after
+  // them.
+
+  namespace task_graph
+  {
+    template<typename Worker, typename OutVector, typename InVector>
+    class BlockWork : public tbb::task
+    {
+    public:
+      BlockWork (const Worker                                  &worker_in,
+                 const unsigned int                             node_in,
+                 const internal::MatrixFreeFunctions::TaskInfo &task_info_in,
+                 const std::vector<tbb::task *>                &nodes_in,
+                 OutVector                                     &dst_in,
+                 const InVector                                &src_in,
+                 const bool                                     overlap_in)
+        :
+        worker (worker_in),
+        node (node_in),
+        task_info (task_info_in),
+        nodes (nodes_in),
+        dst (dst_in),
+        src (src_in),
+        overlap (overlap_in)
+      {};
+
+      tbb::task *execute ()
+      {
+        const unsigned int n_blocks = task_info.n_blocks;
+        const unsigned int n_boundary = task_info.task_graph_n_boundary_blocks;
+        tbb::task *next = NULL;
+        if (node < n_blocks)
+          {
+            worker (task_info.get_block_range(node));
+            for (unsigned int i=task_info.task_graph_successors_row_index[node];
+                 i<task_info.task_graph_successors_row_index[node+1]; ++i)
+              release (nodes[task_info.task_graph_successors[i]], next);
+            if (node < n_boundary)
+              release (nodes[n_blocks+1], next);
+          }
+        else if (node == n_blocks)
+          {
+            if (overlap)
+              internal::update_ghost_values_finish(src);
+            for (unsigned int block=0; block<n_boundary; ++block)
+              release (nodes[block], next);
+          }
+        else if (overlap)
+          internal::compress_start(dst);
+
+        // continue with one of the released tasks on this thread (which
+        // typically works on data that is still in cache), and leave the
+        // others for stealing
+        return next;
+      }
+
+    private:
+      void release (tbb::task *successor,
+                    tbb::task *&next)
+      {
+        if (successor->decrement_ref_count() == 0)
+          {
+            if (next != NULL)
+              spawn (*next);
+            next = successor;
+          }
+      }
+
+      const Worker      &worker;
+      const unsigned int node;
+      const internal::MatrixFreeFunctions::TaskInfo &task_info;
+      const std::vector<tbb::task *> &nodes;
+      OutVector         &dst;
+      const InVector    &src;
+      const bool         overlap;
+    };
+
+  } // end of namespace task_graph
+
+
+
   template<typename VectorStruct>
   class MPIComDistribute : public tbb::task
   {
   public:
-    MPIComDistribute (const VectorStruct  &src_in)
+    MPIComDistribute (const VectorStruct  &src_in,
+                      const bool           do_exchange = true)
       :
-      src(src_in)
+      src(src_in),
+      do_exchange(do_exchange)
     {};
 
     tbb::task *execute ()
     {
-      internal::update_ghost_values_finish(src);
+      if (do_exchange)
+        internal::update_ghost_values_finish(src);
       return 0;
     }
 
   private:
     const VectorStruct &src;
+    const bool do_exchange;
   };
 
 
@@ -2278,19 +2781,23 @@ namespace internal
   class MPIComCompress : public tbb::task
   {
   public:
-    MPIComCompress (VectorStruct        &dst_in)
+    MPIComCompress (VectorStruct        &dst_in,
+                    const bool           do_exchange = true)
       :
-      dst(dst_in)
+      dst(dst_in),
+      do_exchange(do_exchange)
     {};
 
     tbb::task *execute ()
     {
-      internal::compress_start(dst);
+      if (do_exchange)
+        internal::compress_start(dst);
       return 0;
     }
 
   private:
     VectorStruct &dst;
+    const bool do_exchange;
   };
 
 #endif // DEAL_II_WITH_THREADS
@@ -2312,8 +2819,13 @@ MatrixFree<dim, Number>::cell_loop
  OutVector       &dst,
  const InVector  &src) const
 {
-  // in any case, need to start the ghost import at the beginning
+  // in any case, need to start the ghost import at the beginning. If we do
+  // not overlap communication and computation, also wait for the import to
+  // complete before any cell is visited
+  const bool overlap = task_info.overlap_communication_computation;
   bool ghosts_were_not_set = internal::update_ghost_values_start (src);
+  if (overlap == false)
+    internal::update_ghost_values_finish(src);
 
 #ifdef DEAL_II_WITH_THREADS
 
@@ -2333,7 +2845,37 @@ MatrixFree<dim, Number>::cell_loop
                                            std_cxx11::cref(src),
                                            std_cxx11::_1);
 
-      if (task_info.use_partition_partition == true)
+      if (task_info.use_task_graph == true)
+        {
+          // one task per chunk of cells, plus one task for finishing the
+          // import of ghosts and one for starting the export of ghost
+          // contributions
+          typedef internal::task_graph::BlockWork<Worker,OutVector,InVector> BlockWork;
+          const unsigned int n_blocks = task_info.n_blocks;
+          const unsigned int n_boundary = task_info.task_graph_n_boundary_blocks;
+          tbb::empty_task *root = new( tbb::task::allocate_root() )
+          tbb::empty_task;
+          root->set_ref_count(n_blocks+3);
+          std::vector<tbb::task *> nodes(n_blocks+2);
+          tbb::task_list ready;
+          for (unsigned int node=0; node<n_blocks+2; ++node)
+            {
+              nodes[node] = new(root->allocate_child())
+              BlockWork(func, node, task_info, nodes, dst, src, overlap);
+              unsigned int n_predecessors = 0;
+              if (node < n_blocks)
+                n_predecessors = task_info.task_graph_n_predecessors[node] +
+                                 (node < n_boundary ? 1 : 0);
+              else if (node == n_blocks+1)
+                n_predecessors = n_boundary;
+              nodes[node]->set_ref_count(n_predecessors);
+              if (n_predecessors == 0)
+                ready.push_back(*nodes[node]);
+            }
+          root->spawn_and_wait_for_all(ready);
+          root->destroy(*root);
+        }
+      else if (task_info.use_partition_partition == true)
         {
           tbb::empty_task *root = new( tbb::task::allocate_root() )
           tbb::empty_task;
@@ -2348,7 +2890,7 @@ MatrixFree<dim, Number>::cell_loop
           blocked_worker(n_blocked_workers);
           internal::MPIComCompress<OutVector> *worker_compr =
             new(root->allocate_child())
-          internal::MPIComCompress<OutVector>(dst);
+          internal::MPIComCompress<OutVector>(dst, overlap);
           worker_compr->set_ref_count(1);
           for (unsigned int j=0; j<evens; j++)
             {
@@ -2373,7 +2915,7 @@ MatrixFree<dim, Number>::cell_loop
                   worker[j]->set_ref_count(2);
                   internal::MPIComDistribute<InVector> *worker_dist =
                     new (worker[j]->allocate_child())
-                  internal::MPIComDistribute<InVector>(src);
+                  internal::MPIComDistribute<InVector>(src, overlap);
                   worker_dist->spawn(*worker_dist);
                 }
               if (j<evens-1)
@@ -2423,7 +2965,7 @@ MatrixFree<dim, Number>::cell_loop
               unsigned int spawn_index =  0;
               int spawn_index_child = -2;
               internal::MPIComCompress<OutVector> *worker_compr = new(root->allocate_child())
-              internal::MPIComCompress<OutVector>(dst);
+              internal::MPIComCompress<OutVector>(dst, overlap);
               worker_compr->set_ref_count(1);
               for (unsigned int part=0;
                    part<task_info.partition_color_blocks_row_index.size()-1; part++)
@@ -2461,7 +3003,7 @@ MatrixFree<dim, Number>::cell_loop
                     {
                       internal::MPIComDistribute<InVector> *worker_dist =
                         new (worker[worker_index]->allocate_child())
-                      internal::MPIComDistribute<InVector>(src);
+                      internal::MPIComDistribute<InVector>(src, overlap);
                       worker_dist->spawn(*worker_dist);
                       worker_index++;
                     }
@@ -2520,7 +3062,8 @@ MatrixFree<dim, Number>::cell_loop
           else
             {
               Assert(evens==1,ExcInternalError());
-              internal::update_ghost_values_finish(src);
+              if (overlap)
+                internal::update_ghost_values_finish(src);
 
               for (unsigned int color=0;
                    color < task_info.partition_color_blocks_row_index[1];
@@ -2533,7 +3076,8 @@ MatrixFree<dim, Number>::cell_loop
                                (func,task_info));
                 }
 
-              internal::compress_start(dst);
+              if (overlap)
+                internal::compress_start(dst);
             }
         }
     }
@@ -2543,37 +3087,46 @@ MatrixFree<dim, Number>::cell_loop
     {
       std::pair<unsigned int,unsigned int> cell_range;
 
-      // First operate on cells where no ghost data is needed (inner cells)
+      // First operate on cells where no ghost data is needed (inner cells).
+      // If communication is not overlapped, the ghost data is already
+      // present and we go through all cells in one sweep
       {
         cell_range.first = 0;
-        cell_range.second = size_info.boundary_cells_start;
+        cell_range.second = overlap ? size_info.boundary_cells_start :
+                            size_info.n_macro_cells;
         cell_operation (*this, dst, src, cell_range);
       }
 
-      // before starting operations on cells that contain ghost nodes (outer
-      // cells), wait for the MPI commands to finish
-      internal::update_ghost_values_finish(src);
-
-      // For the outer cells, do the same procedure as for inner cells.
-      if (size_info.boundary_cells_end > size_info.boundary_cells_start)
+      if (overlap == true)
         {
-          cell_range.first = size_info.boundary_cells_start;
-          cell_range.second = size_info.boundary_cells_end;
-          cell_operation (*this, dst, src, cell_range);
-        }
+          // before starting operations on cells that contain ghost nodes
+          // (outer cells), wait for the MPI commands to finish
+          internal::update_ghost_values_finish(src);
 
-      internal::compress_start(dst);
+          // For the outer cells, do the same procedure as for inner cells.
+          if (size_info.boundary_cells_end > size_info.boundary_cells_start)
+            {
+              cell_range.first = size_info.boundary_cells_start;
+              cell_range.second = size_info.boundary_cells_end;
+              cell_operation (*this, dst, src, cell_range);
+            }
 
-      // Finally operate on cells where no ghost data is needed (inner cells)
-      if (size_info.n_macro_cells > size_info.boundary_cells_end)
-        {
-          cell_range.first = size_info.boundary_cells_end;
-          cell_range.second = size_info.n_macro_cells;
-          cell_operation (*this, dst, src, cell_range);
+          internal::compress_start(dst);
+
+          // Finally operate on cells where no ghost data is needed (inner
+          // cells)
+          if (size_info.n_macro_cells > size_info.boundary_cells_end)
+            {
+              cell_range.first = size_info.boundary_cells_end;
+              cell_range.second = size_info.n_macro_cells;
+              cell_operation (*this, dst, src, cell_range);
+            }
         }
     }
 
   // In every case, we need to finish transfers at the very end
+  if (overlap == false)
+    internal::compress_start(dst);
   internal::compress_finish(dst);
   internal::reset_ghost_values(src, ghosts_were_not_set);
 }
@@ -2643,6 +3196,375 @@ MatrixFree<dim,Number>::cell_loop
 }
 
 
+
+namespace internal
+{
+  // runs the given operation on the ranges of vector entries stored for the
+  // given slot in the lists of DoFInfo for cell_loop() with operations
+  // before and after the loop
+  inline
+  void
+  apply_operation_to_ranges (const std_cxx11::function<void (const unsigned int,
+                                                             const unsigned int)> &operation,
+                             const std::vector<unsigned int> &list_index,
+                             const std::vector<std::pair<unsigned int,unsigned int> > &list,
+                             const unsigned int slot)
+  {
+    if (operation)
+      for (unsigned int i=list_index[slot]; i<list_index[slot+1]; ++i)
+        operation(list[i].first, list[i].second);
+  }
+}
+
+
+
+template <int dim, typename Number>
+template <typename OutVector, typename InVector>
+inline
+void
+MatrixFree<dim, Number>::cell_loop
+(const std_cxx11::function<void (const MatrixFree<dim,Number> &,
+                                 OutVector &,
+                                 const InVector &,
+                                 const std::pair<unsigned int,
+                                 unsigned int> &)> &cell_operation,
+ OutVector       &dst,
+ const InVector  &src,
+ const std_cxx11::function<void (const unsigned int,
+                                 const unsigned int)> &operation_before_loop,
+ const std_cxx11::function<void (const unsigned int,
+                                 const unsigned int)> &operation_after_loop,
+ const unsigned int dof_handler_index_pre_post) const
+{
+  AssertIndexRange (dof_handler_index_pre_post, dof_info.size());
+  const internal::MatrixFreeFunctions::DoFInfo &info =
+    dof_info[dof_handler_index_pre_post];
+
+  // with threads, the order in which the cells are processed is not known
+  // beforehand, so simply run the operations on the whole range before and
+  // after the loop. The same applies if the lists have not been set up.
+  if (task_info.use_multithreading == true || info.cell_loop_chunks.empty())
+    {
+      const unsigned int local_size = info.vector_partitioner->local_size();
+      if (operation_before_loop && local_size > 0)
+        operation_before_loop (0, local_size);
+      cell_loop (cell_operation, dst, src);
+      if (operation_after_loop && local_size > 0)
+        operation_after_loop (0, local_size);
+      return;
+    }
+
+  // the entries that are sent to other processors must be prepared before
+  // the ghost exchange starts
+  internal::apply_operation_to_ranges (operation_before_loop,
+                                       info.cell_loop_pre_list_index,
+                                       info.cell_loop_pre_list, 0);
+
+  const bool overlap = task_info.overlap_communication_computation;
+  bool ghosts_were_not_set = internal::update_ghost_values_start (src);
+  bool ghosts_are_imported = false, compress_is_started = false;
+  if (overlap == false)
+    {
+      internal::update_ghost_values_finish(src);
+      ghosts_are_imported = true;
+    }
+
+  // go through the chunks of cells. the chunks are aligned with the cells
+  // that access ghost entries, so we can wait for the ghost exchange and
+  // start the compress operation at the right places
+  const unsigned int n_chunks = info.cell_loop_chunks.size() - 1;
+  for (unsigned int chunk=0; chunk<n_chunks; ++chunk)
+    {
+      const std::pair<unsigned int,unsigned int>
+      cell_range (info.cell_loop_chunks[chunk], info.cell_loop_chunks[chunk+1]);
+      if (ghosts_are_imported == false &&
+          cell_range.first >= size_info.boundary_cells_start)
+        {
+          internal::update_ghost_values_finish(src);
+          ghosts_are_imported = true;
+        }
+      if (overlap == true && compress_is_started == false &&
+          cell_range.first >= size_info.boundary_cells_end)
+        {
+          internal::compress_start(dst);
+          compress_is_started = true;
+        }
+
+      internal::apply_operation_to_ranges (operation_before_loop,
+                                           info.cell_loop_pre_list_index,
+                                           info.cell_loop_pre_list, chunk+1);
+      cell_operation (*this, dst, src, cell_range);
+      internal::apply_operation_to_ranges (operation_after_loop,
+                                           info.cell_loop_post_list_index,
+                                           info.cell_loop_post_list, chunk);
+    }
+
+  if (ghosts_are_imported == false)
+    internal::update_ghost_values_finish(src);
+  if (compress_is_started == false)
+    internal::compress_start(dst);
+  internal::compress_finish(dst);
+  internal::reset_ghost_values(src, ghosts_were_not_set);
+
+  // finally, the entries that have received data from other processors
+  // are ready
+  internal::apply_operation_to_ranges (operation_after_loop,
+                                       info.cell_loop_post_list_index,
+                                       info.cell_loop_post_list, n_chunks);
+}
+
+
+
+template <int dim, typename Number>
+template <typename CLASS, typename OutVector, typename InVector>
+inline
+void
+MatrixFree<dim,Number>::cell_loop
+(void (CLASS::*function_pointer)(const MatrixFree<dim,Number> &,
+                                 OutVector &,
+                                 const InVector &,
+                                 const std::pair<unsigned int,
+                                 unsigned int> &)const,
+ const CLASS    *owning_class,
+ OutVector      &dst,
+ const InVector &src,
+ const std_cxx11::function<void (const unsigned int,
+                                 const unsigned int)> &operation_before_loop,
+ const std_cxx11::function<void (const unsigned int,
+                                 const unsigned int)> &operation_after_loop,
+ const unsigned int dof_handler_index_pre_post) const
+{
+  std_cxx11::function<void (const MatrixFree<dim,Number> &,
+                            OutVector &,
+                            const InVector &,
+                            const std::pair<unsigned int,
+                            unsigned int> &)>
+  function = std_cxx11::bind<void>(function_pointer,
+                                   owning_class,
+                                   std_cxx11::_1,
+                                   std_cxx11::_2,
+                                   std_cxx11::_3,
+                                   std_cxx11::_4);
+  cell_loop (function, dst, src, operation_before_loop, operation_after_loop,
+             dof_handler_index_pre_post);
+}
+
+
+
+template <int dim, typename Number>
+template <typename CLASS, typename OutVector, typename InVector>
+inline
+void
+MatrixFree<dim,Number>::cell_loop
+(void(CLASS::*function_pointer)(const MatrixFree<dim,Number> &,
+                                OutVector &,
+                                const InVector &,
+                                const std::pair<unsigned int,
+                                unsigned int> &),
+ CLASS          *owning_class,
+ OutVector      &dst,
+ const InVector &src,
+ const std_cxx11::function<void (const unsigned int,
+                                 const unsigned int)> &operation_before_loop,
+ const std_cxx11::function<void (const unsigned int,
+                                 const unsigned int)> &operation_after_loop,
+ const unsigned int dof_handler_index_pre_post) const
+{
+  std_cxx11::function<void (const MatrixFree<dim,Number> &,
+                            OutVector &,
+                            const InVector &,
+                            const std::pair<unsigned int,
+                            unsigned int> &)>
+  function = std_cxx11::bind<void>(function_pointer,
+                                   owning_class,
+                                   std_cxx11::_1,
+                                   std_cxx11::_2,
+                                   std_cxx11::_3,
+                                   std_cxx11::_4);
+  cell_loop (function, dst, src, operation_before_loop, operation_after_loop,
+             dof_handler_index_pre_post);
+}
+
+
+
+template <int dim, typename Number>
+template <typename OutVector, typename InVector>
+inline
+void
+MatrixFree<dim, Number>::loop
+(const std_cxx11::function<void (const MatrixFree<dim,Number> &,
+                                 OutVector &,
+                                 const InVector &,
+                                 const std::pair<unsigned int,
+                                 unsigned int> &)> &cell_operation,
+ const std_cxx11::function<void (const MatrixFree<dim,Number> &,
+                                 OutVector &,
+                                 const InVector &,
+                                 const std::pair<unsigned int,
+                                 unsigned int> &)> &face_operation,
+ const std_cxx11::function<void (const MatrixFree<dim,Number> &,
+                                 OutVector &,
+                                 const InVector &,
+                                 const std::pair<unsigned int,
+                                 unsigned int> &)> &boundary_operation,
+ OutVector      &dst,
+ const InVector &src) const
+{
+  // the cells are split into three groups as in cell_loop(): the cells
+  // before boundary_cells_start do not touch ghosts, the cells in
+  // [boundary_cells_start, boundary_cells_end) do, and the remaining cells
+  // again do not. The faces are split into interior faces that only touch
+  // locally owned cells without ghosts, interior faces that need ghost data,
+  // and boundary faces. Work that does not need ghost data is placed
+  // between the start and finish of the data exchange.
+  // If communication is not overlapped with computations, the ghost import
+  // is completed right away and the compress operation is only started
+  // after all work has been done.
+  const bool overlap = task_info.overlap_communication_computation;
+  bool ghosts_were_not_set = internal::update_ghost_values_start (src);
+  if (overlap == false)
+    internal::update_ghost_values_finish(src);
+
+  std::pair<unsigned int,unsigned int> range;
+  if (size_info.boundary_cells_start > 0)
+    {
+      range.first = 0;
+      range.second = size_info.boundary_cells_start;
+      cell_operation (*this, dst, src, range);
+    }
+  if (face_info.n_inner_face_batches > 0)
+    {
+      range.first = 0;
+      range.second = face_info.n_inner_face_batches;
+      face_operation (*this, dst, src, range);
+    }
+
+  if (overlap == true)
+    internal::update_ghost_values_finish(src);
+
+  if (size_info.boundary_cells_end > size_info.boundary_cells_start)
+    {
+      range.first = size_info.boundary_cells_start;
+      range.second = size_info.boundary_cells_end;
+      cell_operation (*this, dst, src, range);
+    }
+  if (face_info.n_ghost_inner_face_batches > 0)
+    {
+      range.first = face_info.n_inner_face_batches;
+      range.second = range.first + face_info.n_ghost_inner_face_batches;
+      face_operation (*this, dst, src, range);
+    }
+  if (face_info.n_boundary_face_batches > 0)
+    {
+      range.first = face_info.n_inner_face_batches +
+                    face_info.n_ghost_inner_face_batches;
+      range.second = range.first + face_info.n_boundary_face_batches;
+      boundary_operation (*this, dst, src, range);
+    }
+
+  if (overlap == true)
+    internal::compress_start(dst);
+
+  if (size_info.n_macro_cells > size_info.boundary_cells_end)
+    {
+      range.first = size_info.boundary_cells_end;
+      range.second = size_info.n_macro_cells;
+      cell_operation (*this, dst, src, range);
+    }
+
+  if (overlap == false)
+    internal::compress_start(dst);
+  internal::compress_finish(dst);
+  internal::reset_ghost_values(src, ghosts_were_not_set);
+}
+
+
+
+template <int dim, typename Number>
+template <typename CLASS, typename OutVector, typename InVector>
+inline
+void
+MatrixFree<dim,Number>::loop
+(void (CLASS::*cell_operation)(const MatrixFree<dim,Number> &,
+                               OutVector &,
+                               const InVector &,
+                               const std::pair<unsigned int,
+                               unsigned int> &)const,
+ void (CLASS::*face_operation)(const MatrixFree<dim,Number> &,
+                               OutVector &,
+                               const InVector &,
+                               const std::pair<unsigned int,
+                               unsigned int> &)const,
+ void (CLASS::*boundary_operation)(const MatrixFree<dim,Number> &,
+                                   OutVector &,
+                                   const InVector &,
+                                   const std::pair<unsigned int,
+                                   unsigned int> &)const,
+ const CLASS    *owning_class,
+ OutVector      &dst,
+ const InVector &src) const
+{
+  typedef std_cxx11::function<void (const MatrixFree<dim,Number> &,
+                                    OutVector &,
+                                    const InVector &,
+                                    const std::pair<unsigned int,
+                                    unsigned int> &)> function_type;
+  function_type cell_function =
+    std_cxx11::bind<void>(cell_operation, owning_class, std_cxx11::_1,
+                          std_cxx11::_2, std_cxx11::_3, std_cxx11::_4);
+  function_type face_function =
+    std_cxx11::bind<void>(face_operation, owning_class, std_cxx11::_1,
+                          std_cxx11::_2, std_cxx11::_3, std_cxx11::_4);
+  function_type boundary_function =
+    std_cxx11::bind<void>(boundary_operation, owning_class, std_cxx11::_1,
+                          std_cxx11::_2, std_cxx11::_3, std_cxx11::_4);
+  loop (cell_function, face_function, boundary_function, dst, src);
+}
+
+
+
+template <int dim, typename Number>
+template <typename CLASS, typename OutVector, typename InVector>
+inline
+void
+MatrixFree<dim,Number>::loop
+(void (CLASS::*cell_operation)(const MatrixFree<dim,Number> &,
+                               OutVector &,
+                               const InVector &,
+                               const std::pair<unsigned int,
+                               unsigned int> &),
+ void (CLASS::*face_operation)(const MatrixFree<dim,Number> &,
+                               OutVector &,
+                               const InVector &,
+                               const std::pair<unsigned int,
+                               unsigned int> &),
+ void (CLASS::*boundary_operation)(const MatrixFree<dim,Number> &,
+                                   OutVector &,
+                                   const InVector &,
+                                   const std::pair<unsigned int,
+                                   unsigned int> &),
+ CLASS          *owning_class,
+ OutVector      &dst,
+ const InVector &src) const
+{
+  typedef std_cxx11::function<void (const MatrixFree<dim,Number> &,
+                                    OutVector &,
+                                    const InVector &,
+                                    const std::pair<unsigned int,
+                                    unsigned int> &)> function_type;
+  function_type cell_function =
+    std_cxx11::bind<void>(cell_operation, owning_class, std_cxx11::_1,
+                          std_cxx11::_2, std_cxx11::_3, std_cxx11::_4);
+  function_type face_function =
+    std_cxx11::bind<void>(face_operation, owning_class, std_cxx11::_1,
+                          std_cxx11::_2, std_cxx11::_3, std_cxx11::_4);
+  function_type boundary_function =
+    std_cxx11::bind<void>(boundary_operation, owning_class, std_cxx11::_1,
+                          std_cxx11::_2, std_cxx11::_3, std_cxx11::_4);
+  loop (cell_function, face_function, boundary_function, dst, src);
+}
+
+
 #endif  // ifndef DOXYGEN
 
 
@@ -22,6 +22,7 @@
 #include <deal.II/base/tensor_product_polynomials.h>
 #include <deal.II/base/polynomials_piecewise.h>
 #include <deal.II/base/mpi.h>
+#include <deal.II/base/std_cxx11/array.h>
 #include <deal.II/dofs/dof_accessor.h>
 #include <deal.II/fe/fe_poly.h>
 #include <deal.II/hp/q_collection.h>
@@ -32,6 +33,9 @@
 #include <deal.II/matrix_free/mapping_info.templates.h>
 #include <deal.II/matrix_free/dof_info.templates.h>
 
+#include <map>
+#include <set>
+
 
 DEAL_II_NAMESPACE_OPEN
 
@@ -64,6 +68,7 @@ copy_from (const MatrixFree<dim,Number> &v)
   constraint_pool_data = v.constraint_pool_data;
   constraint_pool_row_index = v.constraint_pool_row_index;
   mapping_info = v.mapping_info;
+  face_info = v.face_info;
   shape_info = v.shape_info;
   cell_level_index = v.cell_level_index;
   task_info = v.task_info;
@@ -144,16 +149,21 @@ internal_reinit(const Mapping<dim>                          &mapping,
           task_info.use_coloring_only =
             (additional_data.tasks_parallel_scheme ==
              AdditionalData::color ? true : false);
+          task_info.use_task_graph =
+            (additional_data.tasks_parallel_scheme ==
+             AdditionalData::task_graph ? true : false);
         }
       else
 #endif
         task_info.use_multithreading = false;
+      task_info.overlap_communication_computation =
+        additional_data.overlap_communication_computation;
 
       // set dof_indices together with constraint_indicator and
       // constraint_pool_data. It also reorders the way cells are gone through
       // (to separate cells with overlap to other processors from others
       // without).
-      initialize_indices (constraint, locally_owned_set);
+      initialize_indices (constraint, locally_owned_set, additional_data);
     }
 
   // initialize bare structures
@@ -192,7 +202,13 @@ internal_reinit(const Mapping<dim>                          &mapping,
     {
       mapping_info.initialize (dof_handler[0]->get_triangulation(), cell_level_index,
                                dof_info[0].cell_active_fe_index, mapping, quad,
-                               additional_data.mapping_update_flags);
+                               additional_data.mapping_update_flags,
+                               additional_data.compute_jacobians_on_the_fly);
+      if (face_info.faces.size() > 0)
+        mapping_info.initialize_faces (dof_handler[0]->get_triangulation(),
+                                       cell_level_index, face_info, mapping, quad,
+                                       additional_data.mapping_update_flags_inner_faces |
+                                       additional_data.mapping_update_flags_boundary_faces);
 
       mapping_is_initialized = true;
     }
@@ -278,16 +294,21 @@ internal_reinit(const Mapping<dim>                            &mapping,
           task_info.use_coloring_only =
             (additional_data.tasks_parallel_scheme ==
              AdditionalData::color ? true : false);
+          task_info.use_task_graph =
+            (additional_data.tasks_parallel_scheme ==
+             AdditionalData::task_graph ? true : false);
         }
       else
 #endif
         task_info.use_multithreading = false;
+      task_info.overlap_communication_computation =
+        additional_data.overlap_communication_computation;
 
       // set dof_indices together with constraint_indicator and
       // constraint_pool_data. It also reorders the way cells are gone through
       // (to separate cells with overlap to other processors from others
       // without).
-      initialize_indices (constraint, locally_owned_set);
+      initialize_indices (constraint, locally_owned_set, additional_data);
     }
 
   // initialize bare structures
@@ -324,7 +345,8 @@ internal_reinit(const Mapping<dim>                            &mapping,
     {
       mapping_info.initialize (dof_handler[0]->get_triangulation(), cell_level_index,
                                dof_info[0].cell_active_fe_index, mapping, quad,
-                               additional_data.mapping_update_flags);
+                               additional_data.mapping_update_flags,
+                               additional_data.compute_jacobians_on_the_fly);
 
       mapping_is_initialized = true;
     }
@@ -355,6 +377,8 @@ MatrixFree<dim, Number>::is_supported(const FiniteElement<dim, spacedim> &fe)
     return true;
   if (dynamic_cast<const FE_DGP<dim, spacedim>*>(fe_ptr)!=0)
     return true;
+  if (dynamic_cast<const FE_DGPMonomial<dim>*>(fe_ptr)!=0)
+    return true;
   if (dynamic_cast<const FE_Q_DG0<dim, spacedim>*>(fe_ptr)!=0)
     return true;
 
@@ -493,7 +517,8 @@ initialize_dof_handlers (const std::vector<const hp::DoFHandler<dim>*> &dof_hand
 template <int dim, typename Number>
 void MatrixFree<dim,Number>::initialize_indices
 (const std::vector<const ConstraintMatrix *> &constraint,
- const std::vector<IndexSet>                 &locally_owned_set)
+ const std::vector<IndexSet>                 &locally_owned_set,
+ const AdditionalData                        &additional_data)
 {
   const unsigned int n_fe = dof_handlers.n_dof_handlers;
   const unsigned int n_active_cells = cell_level_index.size();
@@ -656,6 +681,62 @@ void MatrixFree<dim,Number>::initialize_indices
         boundary_cells.push_back(counter);
     }
 
+  // for face integrals, we also need the indices on the cells of remote
+  // processors adjacent to the locally owned cells. We only collect them
+  // here and do not resolve constraints on them, but the indices must be
+  // known before the ghost indices are assigned.
+  std::vector<std::pair<unsigned int,unsigned int> > ghost_cells;
+  if (additional_data.mapping_update_flags_inner_faces != update_default)
+    {
+      AssertThrow (dof_handlers.active_dof_handler == DoFHandlers::usual,
+                   ExcMessage("Face integrals are only implemented for "
+                              "DoFHandler, not for hp::DoFHandler"));
+      const Triangulation<dim> &tria =
+        dof_handlers.dof_handler[0]->get_triangulation();
+      std::set<std::pair<unsigned int,unsigned int> > ghost_cells_found;
+      for (unsigned int counter = 0; counter < n_active_cells; ++counter)
+        {
+          typename Triangulation<dim>::cell_iterator
+          cell (&tria, cell_level_index[counter].first,
+                cell_level_index[counter].second);
+          for (unsigned int f=0; f<GeometryInfo<dim>::faces_per_cell; ++f)
+            if (cell->at_boundary(f) == false)
+              {
+                typename Triangulation<dim>::cell_iterator
+                neighbor = cell->neighbor(f);
+                const bool is_remote =
+                  dof_handlers.level == numbers::invalid_unsigned_int ?
+                  (neighbor->active() && !neighbor->is_locally_owned()) :
+                  (neighbor->level() == cell->level() &&
+                   neighbor->level_subdomain_id() != cell->level_subdomain_id());
+                if (is_remote == false)
+                  continue;
+                const std::pair<unsigned int,unsigned int>
+                neighbor_index (neighbor->level(), neighbor->index());
+                if (ghost_cells_found.insert(neighbor_index).second == true)
+                  ghost_cells.push_back(neighbor_index);
+              }
+        }
+
+      for (unsigned int no=0; no<n_fe; ++no)
+        {
+          const DoFHandler<dim> *dofh = dof_handlers.dof_handler[no];
+          local_dof_indices.resize (dof_info[no].dofs_per_cell[0]);
+          for (unsigned int i=0; i<ghost_cells.size(); ++i)
+            {
+              typename DoFHandler<dim>::cell_iterator
+              cell_it (&dofh->get_triangulation(), ghost_cells[i].first,
+                       ghost_cells[i].second, dofh);
+              if (dof_handlers.level == numbers::invalid_unsigned_int)
+                cell_it->get_dof_indices(local_dof_indices);
+              else
+                cell_it->get_mg_dof_indices(local_dof_indices);
+              dof_info[no].read_dof_indices_ghost_cell
+              (local_dof_indices, shape_info(no,0,0,0).lexicographic_numbering);
+            }
+        }
+    }
+
   const unsigned int vectorization_length =
     VectorizedArray<Number>::n_array_elements;
   std::vector<unsigned int> irregular_cells;
@@ -759,20 +840,253 @@ void MatrixFree<dim,Number>::initialize_indices
     }
   AssertDimension(constraint_pool_data.size(), length);
   for (unsigned int no=0; no<n_fe; ++no)
-    dof_info[no].reorder_cells(size_info, renumbering,
-                               constraint_pool_row_index,
-                               irregular_cells, vectorization_length);
+    {
+      dof_info[no].reorder_cells(size_info, renumbering,
+                                 constraint_pool_row_index,
+                                 irregular_cells, vectorization_length);
+      dof_info[no].compute_cell_loop_pre_post_lists(size_info);
+      dof_info[no].compress_indices(vectorization_length);
+    }
+
+  if (additional_data.mapping_update_flags_inner_faces != update_default ||
+      additional_data.mapping_update_flags_boundary_faces != update_default)
+    initialize_face_info (additional_data, ghost_cells);
 
   indices_are_initialized = true;
 }
 
 
 
+template <int dim, typename Number>
+void MatrixFree<dim,Number>::initialize_face_info
+(const AdditionalData                                     &additional_data,
+ const std::vector<std::pair<unsigned int,unsigned int> > &ghost_cells)
+{
+  const unsigned int vectorization_length =
+    VectorizedArray<Number>::n_array_elements;
+  const bool build_inner_faces =
+    additional_data.mapping_update_flags_inner_faces != update_default;
+  const bool build_boundary_faces =
+    additional_data.mapping_update_flags_boundary_faces != update_default;
+  const bool is_level = dof_handlers.level != numbers::invalid_unsigned_int;
+  AssertThrow (dof_handlers.active_dof_handler == DoFHandlers::usual,
+               ExcMessage("Face integrals are only implemented for "
+                          "DoFHandler, not for hp::DoFHandler"));
+  const Triangulation<dim> &tria =
+    dof_handlers.dof_handler[0]->get_triangulation();
+
+  // find the position of each locally owned cell and each ghost cell in the
+  // numbering used by FaceToCellTopology
+  std::map<std::pair<unsigned int,unsigned int>, unsigned int> cell_position;
+  for (unsigned int i=0; i<size_info.n_macro_cells; ++i)
+    {
+      const unsigned int n_filled = dof_info[0].row_starts[i][2] > 0 ?
+                                    dof_info[0].row_starts[i][2] :
+                                    vectorization_length;
+      for (unsigned int v=0; v<n_filled; ++v)
+        cell_position[cell_level_index[i*vectorization_length+v]] =
+          i*vectorization_length+v;
+    }
+  const unsigned int n_local_positions =
+    size_info.n_macro_cells*vectorization_length;
+  for (unsigned int i=0; i<ghost_cells.size(); ++i)
+    cell_position[ghost_cells[i]] = n_local_positions + i;
+
+  // collect the faces into groups with the same face numbers on both
+  // sides and the same subface index (the same boundary id for boundary
+  // faces), such that the faces in a batch of vectorized faces all have the
+  // same orientation relative to the cells
+  typedef std::map<std_cxx11::array<unsigned int,3>,
+          std::vector<std::pair<unsigned int,unsigned int> > > InnerFaceMap;
+  InnerFaceMap inner_faces, ghost_inner_faces;
+  std::map<std::pair<unsigned int,types::boundary_id>,
+      std::vector<unsigned int> > boundary_faces;
+  for (unsigned int i=0; i<size_info.n_macro_cells; ++i)
+    {
+      const unsigned int n_filled = dof_info[0].row_starts[i][2] > 0 ?
+                                    dof_info[0].row_starts[i][2] :
+                                    vectorization_length;
+      const bool cell_has_ghosts = i >= size_info.boundary_cells_start &&
+                                   i < size_info.boundary_cells_end;
+      for (unsigned int v=0; v<n_filled; ++v)
+        {
+          const unsigned int position = i*vectorization_length+v;
+          typename Triangulation<dim>::cell_iterator
+          cell (&tria, cell_level_index[position].first,
+                cell_level_index[position].second);
+          for (unsigned int f=0; f<GeometryInfo<dim>::faces_per_cell; ++f)
+            {
+              if (cell->at_boundary(f))
+                {
+                  if (build_boundary_faces)
+                    boundary_faces[std::make_pair(f, cell->face(f)->boundary_id())]
+                    .push_back(position);
+                  continue;
+                }
+              if (build_inner_faces == false)
+                continue;
+
+              typename Triangulation<dim>::cell_iterator
+              neighbor = cell->neighbor(f);
+
+              // faces with hanging nodes are visited from the finer cell
+              // only, which becomes the interior side of the face
+              if (is_level == false && neighbor->has_children())
+                continue;
+              const bool is_hanging = is_level == false &&
+                                      neighbor->level() < cell->level();
+              Assert (is_hanging || neighbor->level() == cell->level(),
+                      ExcInternalError());
+
+              typename std::map<std::pair<unsigned int,unsigned int>,
+                       unsigned int>::const_iterator
+                       it = cell_position.find(std::make_pair(neighbor->level(),
+                                                              neighbor->index()));
+              Assert (it != cell_position.end(), ExcInternalError());
+              const unsigned int neighbor_position = it->second;
+              std_cxx11::array<unsigned int,3> face_key;
+              face_key[0] = f;
+              face_key[1] = numbers::invalid_unsigned_int;
+              face_key[2] = numbers::invalid_unsigned_int;
+              if (is_hanging)
+                {
+                  AssertThrow (cell->parent()->refinement_case() ==
+                               RefinementCase<dim>::isotropic_refinement,
+                               ExcMessage("Face integrals in MatrixFree are "
+                                          "only implemented for isotropic "
+                                          "refinement"));
+                  face_key[1] = cell->neighbor_of_coarser_neighbor(f).first;
+
+                  // the position of the cell within its parent gives the
+                  // position of the face within the face of the coarser
+                  // neighbor, assuming matching orientation of the two cells
+                  // (which is checked by MappingInfo::initialize_faces())
+                  unsigned int child = 0;
+                  while (cell->parent()->child(child) != cell)
+                    ++child;
+                  const unsigned int direction = f/2;
+                  face_key[2] = 0;
+                  for (unsigned int d=0, t=0; d<dim; ++d)
+                    if (d != direction)
+                      face_key[2] |= ((child >> d) & 1) << t++;
+                }
+              else
+                face_key[1] = cell->neighbor_of_neighbor(f);
+
+              if (is_hanging)
+                {
+                  // the finer cell is locally owned, so the face is always
+                  // computed here, also when the coarser cell is a ghost
+                  const unsigned int neighbor_macro =
+                    neighbor_position / vectorization_length;
+                  const bool neighbor_has_ghosts =
+                    neighbor_position >= n_local_positions ||
+                    (neighbor_macro >= size_info.boundary_cells_start &&
+                     neighbor_macro < size_info.boundary_cells_end);
+                  if (cell_has_ghosts || neighbor_has_ghosts)
+                    ghost_inner_faces[face_key].push_back
+                    (std::make_pair(position, neighbor_position));
+                  else
+                    inner_faces[face_key].push_back
+                    (std::make_pair(position, neighbor_position));
+                }
+              else if (neighbor_position >= n_local_positions)
+                {
+                  // faces between a locally owned cell and a ghost cell are
+                  // computed on the processor with the lower subdomain id,
+                  // the other side is filled by the compress() operation
+                  const types::subdomain_id my_subdomain = is_level ?
+                                                           cell->level_subdomain_id() :
+                                                           cell->subdomain_id();
+                  const types::subdomain_id neighbor_subdomain = is_level ?
+                                                                 neighbor->level_subdomain_id() :
+                                                                 neighbor->subdomain_id();
+                  if (my_subdomain < neighbor_subdomain)
+                    ghost_inner_faces[face_key].push_back
+                    (std::make_pair(position, neighbor_position));
+                }
+              else if (position < neighbor_position)
+                {
+                  const unsigned int neighbor_macro =
+                    neighbor_position / vectorization_length;
+                  const bool neighbor_has_ghosts =
+                    neighbor_macro >= size_info.boundary_cells_start &&
+                    neighbor_macro < size_info.boundary_cells_end;
+                  if (cell_has_ghosts || neighbor_has_ghosts)
+                    ghost_inner_faces[face_key].push_back
+                    (std::make_pair(position, neighbor_position));
+                  else
+                    inner_faces[face_key].push_back
+                    (std::make_pair(position, neighbor_position));
+                }
+            }
+        }
+    }
+
+  // fill the batches of faces
+  face_info.clear();
+  internal::MatrixFreeFunctions::FaceToCellTopology<vectorization_length> face;
+  InnerFaceMap *inner_face_maps[2] = {&inner_faces, &ghost_inner_faces};
+  for (unsigned int type=0; type<2; ++type)
+    {
+      const unsigned int n_faces_before = face_info.faces.size();
+      for (typename InnerFaceMap::const_iterator it = inner_face_maps[type]->begin();
+           it != inner_face_maps[type]->end(); ++it)
+        for (unsigned int j=0; j<it->second.size(); j+=vectorization_length)
+          {
+            face.interior_face_no = it->first[0];
+            face.exterior_face_no = it->first[1];
+            face.subface_index = it->first[2];
+            face.boundary_id = numbers::internal_face_boundary_id;
+            for (unsigned int v=0; v<vectorization_length; ++v)
+              if (j+v < it->second.size())
+                {
+                  face.cells_interior[v] = it->second[j+v].first;
+                  face.cells_exterior[v] = it->second[j+v].second;
+                }
+              else
+                {
+                  face.cells_interior[v] = numbers::invalid_unsigned_int;
+                  face.cells_exterior[v] = numbers::invalid_unsigned_int;
+                }
+            face_info.faces.push_back(face);
+          }
+      if (type == 0)
+        face_info.n_inner_face_batches = face_info.faces.size() - n_faces_before;
+      else
+        face_info.n_ghost_inner_face_batches = face_info.faces.size() - n_faces_before;
+    }
+
+  const unsigned int n_faces_before = face_info.faces.size();
+  for (typename std::map<std::pair<unsigned int,types::boundary_id>,
+       std::vector<unsigned int> >::const_iterator it = boundary_faces.begin();
+       it != boundary_faces.end(); ++it)
+    for (unsigned int j=0; j<it->second.size(); j+=vectorization_length)
+      {
+        face.interior_face_no = it->first.first;
+        face.exterior_face_no = it->first.first;
+        face.subface_index = numbers::invalid_unsigned_int;
+        face.boundary_id = it->first.second;
+        for (unsigned int v=0; v<vectorization_length; ++v)
+          {
+            face.cells_interior[v] = j+v < it->second.size() ?
+                                     it->second[j+v] :
+                                     numbers::invalid_unsigned_int;
+            face.cells_exterior[v] = numbers::invalid_unsigned_int;
+          }
+        face_info.faces.push_back(face);
+      }
+  face_info.n_boundary_face_batches = face_info.faces.size() - n_faces_before;
+}
+
+
+
 template <int dim, typename Number>
 void MatrixFree<dim,Number>::clear()
 {
   dof_info.clear();
   mapping_info.clear();
+  face_info.clear();
   cell_level_index.clear();
   size_info.clear();
   task_info.clear();
@@ -795,6 +1109,7 @@ std::size_t MatrixFree<dim,Number>::memory_consumption () const
   memory += MemoryConsumption::memory_consumption (task_info);
   memory += sizeof(*this);
   memory += mapping_info.memory_consumption();
+  memory += face_info.memory_consumption();
   return memory;
 }
 
@@ -867,6 +1182,8 @@ namespace internal
       use_multithreading = false;
       use_partition_partition = false;
       use_coloring_only = false;
+      use_task_graph = false;
+      overlap_communication_computation = true;
       partition_color_blocks_row_index.clear();
       partition_color_blocks_data.clear();
       evens = 0;
@@ -877,6 +1194,12 @@ namespace internal
       partition_odds.clear();
       partition_n_blocked_workers.clear();
       partition_n_workers.clear();
+      task_graph_n_predecessors.clear();
+      task_graph_successors_row_index.clear();
+      task_graph_successors.clear();
+      task_graph_n_boundary_blocks = 0;
+      task_graph_critical_path = 0;
+      task_graph_blocks_per_level.clear();
     }
 
 
@@ -890,7 +1213,102 @@ namespace internal
               MemoryConsumption::memory_consumption (partition_evens) +
               MemoryConsumption::memory_consumption (partition_odds) +
               MemoryConsumption::memory_consumption (partition_n_blocked_workers) +
-              MemoryConsumption::memory_consumption (partition_n_workers));
+              MemoryConsumption::memory_consumption (partition_n_workers) +
+              MemoryConsumption::memory_consumption (task_graph_n_predecessors) +
+              MemoryConsumption::memory_consumption (task_graph_successors_row_index) +
+              MemoryConsumption::memory_consumption (task_graph_successors) +
+              MemoryConsumption::memory_consumption (task_graph_blocks_per_level));
+    }
+
+
+
+    std::pair<unsigned int,unsigned int>
+    TaskInfo::get_block_range (const unsigned int block) const
+    {
+      AssertIndexRange (block, n_blocks);
+      std::pair<unsigned int,unsigned int> cell_range;
+      if (position_short_block < block)
+        {
+          cell_range.first = (block-1)*block_size + block_size_last;
+          cell_range.second = cell_range.first + block_size;
+        }
+      else
+        {
+          cell_range.first = block*block_size;
+          cell_range.second = cell_range.first +
+                              ((block == position_short_block) ?
+                               block_size_last : block_size);
+        }
+      return cell_range;
+    }
+
+
+
+    void
+    TaskInfo::compute_task_graph_statistics ()
+    {
+      AssertDimension (task_graph_n_predecessors.size(), n_blocks);
+      AssertDimension (task_graph_successors_row_index.size(), n_blocks+1);
+
+      // the successors of a chunk always come later in the loop order, so
+      // going through the chunks in ascending order visits all predecessors
+      // of a chunk before the chunk itself
+      std::vector<unsigned int> start_cell (n_blocks, 0), level (n_blocks, 0);
+      task_graph_critical_path = 0;
+      task_graph_blocks_per_level.clear();
+      for (unsigned int block=0; block<n_blocks; ++block)
+        {
+          const std::pair<unsigned int,unsigned int> range =
+            get_block_range (block);
+          const unsigned int end_cell = start_cell[block] + range.second -
+                                        range.first;
+          task_graph_critical_path = std::max (task_graph_critical_path,
+                                               end_cell);
+          if (level[block] >= task_graph_blocks_per_level.size())
+            task_graph_blocks_per_level.resize (level[block]+1, 0);
+          ++task_graph_blocks_per_level[level[block]];
+          for (unsigned int i=task_graph_successors_row_index[block];
+               i<task_graph_successors_row_index[block+1]; ++i)
+            {
+              const unsigned int successor = task_graph_successors[i];
+              Assert (successor > block, ExcInternalError());
+              start_cell[successor] = std::max (start_cell[successor], end_cell);
+              level[successor] = std::max (level[successor], level[block]+1);
+            }
+        }
+    }
+
+
+
+    void
+    TaskInfo::print_task_graph_statistics (std::ostream &out) const
+    {
+      if (use_task_graph == false || task_graph_blocks_per_level.empty())
+        return;
+
+      unsigned int n_macro_cells = 0;
+      for (unsigned int block=0; block<n_blocks; ++block)
+        n_macro_cells += get_block_range(block).second -
+                         get_block_range(block).first;
+      const unsigned int n_levels = task_graph_blocks_per_level.size();
+      const unsigned int min_blocks =
+        *std::min_element (task_graph_blocks_per_level.begin(),
+                           task_graph_blocks_per_level.end());
+      const unsigned int max_blocks =
+        *std::max_element (task_graph_blocks_per_level.begin(),
+                           task_graph_blocks_per_level.end());
+
+      out << "Task graph: " << n_blocks << " chunks of " << block_size
+          << " macro cells, " << task_graph_successors.size()
+          << " dependencies, " << task_graph_n_boundary_blocks
+          << " chunks with ghost access" << std::endl;
+      out << "  critical path: " << task_graph_critical_path << " of "
+          << n_macro_cells << " macro cells, average parallelism: "
+          << static_cast<double>(n_macro_cells) /
+          std::max (1U, task_graph_critical_path) << std::endl;
+      out << "  levels: " << n_levels << ", chunks per level min/avg/max: "
+          << min_blocks << "/" << static_cast<double>(n_blocks) / n_levels
+          << "/" << max_blocks << std::endl;
     }
 
 
@@ -23,7 +23,9 @@
 #include <deal.II/base/subscriptor.h>
 
 #include <deal.II/lac/diagonal_matrix.h>
+#include <deal.II/lac/full_matrix.h>
 #include <deal.II/lac/la_parallel_vector.h>
+#include <deal.II/lac/la_parallel_block_vector.h>
 #include <deal.II/lac/vector_view.h>
 #include <deal.II/multigrid/mg_constrained_dofs.h>
 #include <deal.II/matrix_free/matrix_free.h>
@@ -33,6 +35,85 @@
 DEAL_II_NAMESPACE_OPEN
 
 
+namespace internal
+{
+  namespace MatrixFreeOperators
+  {
+    /**
+     * Initialize the vector @p vec with the partitioner of the DoFHandler
+     * with index @p dof_handler_index in @p data, unless the vector is
+     * already compatible with it. Shared by MatrixFreeOperators::Base and
+     * the blocks of MatrixFreeOperators::BlockBase.
+     */
+    template <int dim, typename Number>
+    void
+    initialize_dof_vector (const dealii::MatrixFree<dim,Number>       &data,
+                           const unsigned int                          dof_handler_index,
+                           LinearAlgebra::distributed::Vector<Number> &vec)
+    {
+      if (!vec.partitioners_are_compatible(*data.get_dof_info(dof_handler_index).vector_partitioner))
+        data.initialize_dof_vector(vec, dof_handler_index);
+      Assert(vec.partitioners_are_globally_compatible(*data.get_dof_info(dof_handler_index).vector_partitioner),
+             ExcInternalError());
+    }
+
+
+
+    /**
+     * Check whether the vector @p vec uses the given @p partitioner and, if
+     * not, reset it to that partitioner while keeping the locally owned
+     * values. This makes vectors with a different ghost range usable in the
+     * cell loops of MatrixFree, which needs the ghost entries of the
+     * partitioner it was set up with.
+     */
+    template <typename Number>
+    void
+    adjust_ghost_range_if_necessary
+    (const std_cxx11::shared_ptr<const Utilities::MPI::Partitioner> &partitioner,
+     const LinearAlgebra::distributed::Vector<Number>               &vec)
+    {
+      // If both vectors use the same partitioner -> done
+      if (vec.get_partitioner().get() == partitioner.get())
+        return;
+
+      // If not, assert that the local ranges are the same and reset to the
+      // current partitioner
+      Assert(vec.get_partitioner()->local_size() ==
+             partitioner->local_size(),
+             ExcMessage("The vector passed to the vmult() function does not have "
+                        "the correct size for compatibility with MatrixFree."));
+
+      // copy the vector content to a temporary vector so that it does not get
+      // lost
+      VectorView<Number> view_src_in(vec.local_size(), vec.begin());
+      dealii::Vector<Number> copy_vec = view_src_in;
+      const_cast<LinearAlgebra::distributed::Vector<Number> &>(vec).
+      reinit(partitioner);
+      VectorView<Number> view_src_out(vec.local_size(), vec.begin());
+      static_cast<dealii::Vector<Number>&>(view_src_out) = copy_vec;
+    }
+
+
+
+    /**
+     * Add the entries of @p src at the constrained degrees of freedom given
+     * in MPI-local numbering to @p dst, i.e., apply the identity operator on
+     * these entries as done by the matrix-free operators.
+     */
+    template <typename Number>
+    void
+    add_constrained_entries (const std::vector<unsigned int>                  &constrained_dofs,
+                             LinearAlgebra::distributed::Vector<Number>       &dst,
+                             const LinearAlgebra::distributed::Vector<Number> &src)
+    {
+      for (unsigned int i=0; i<constrained_dofs.size(); ++i)
+        dst.local_element(constrained_dofs[i]) += src.local_element(constrained_dofs[i]);
+    }
+  }
+}
+
+
+
 namespace MatrixFreeOperators
 {
   /**
@@ -116,6 +197,41 @@ namespace MatrixFreeOperators
     void vmult (LinearAlgebra::distributed::Vector<Number> &dst,
                 const LinearAlgebra::distributed::Vector<Number> &src) const;
 
+    /**
+     * Matrix-vector multiplication that additionally runs the two function
+     * objects @p operation_before_matrix_vector_product and @p
+     * operation_after_matrix_vector_product on ranges <tt>[begin, end)</tt>
+     * of the locally owned vector entries. The former is called right before
+     * the entries of @p src and @p dst in the range are accessed for the
+     * first time, and the latter right after the final values of @p dst in
+     * the range have been computed. This allows solvers to merge their
+     * vector updates into the operator evaluation, see
+     * MatrixFree::cell_loop() for details. Both function objects are called
+     * exactly once for each locally owned entry. Empty function objects are
+     * ignored.
+     *
+     * The operation before the product may modify @p src in the given range
+     * (but no other vector that is read by the operator), and the operation
+     * after the product may modify both @p src and @p dst in the given range.
+     */
+    void vmult (LinearAlgebra::distributed::Vector<Number> &dst,
+                const LinearAlgebra::distributed::Vector<Number> &src,
+                const std_cxx11::function<void (const unsigned int,
+                                                const unsigned int)> &operation_before_matrix_vector_product,
+                const std_cxx11::function<void (const unsigned int,
+                                                const unsigned int)> &operation_after_matrix_vector_product) const;
+
+    /**
+     * Matrix-vector multiplication with several vectors at once, i.e.,
+     * <tt>*dst[i] = A * (*src[i])</tt> for all vectors. If the derived class
+     * implements multi_apply_add(), all vectors are processed in a single
+     * loop over the cells, such that the data of each cell (indices, mapping
+     * data, coefficients) is loaded from memory only once. This is used by
+     * the block Krylov solvers SolverBlockCG and SolverBlockGMRES.
+     */
+    void multi_vmult (const std::vector<LinearAlgebra::distributed::Vector<Number> *>       &dst,
+                      const std::vector<const LinearAlgebra::distributed::Vector<Number> *> &src) const;
+
     /**
      * Transpose matrix-vector multiplication.
      */
@@ -202,6 +318,40 @@ namespace MatrixFreeOperators
     virtual void Tapply_add(LinearAlgebra::distributed::Vector<Number> &dst,
                             const LinearAlgebra::distributed::Vector<Number> &src) const;
 
+    /**
+     * Apply operator to each of the vectors in @p src and add the result
+     * into the respective vector of @p dst. Derived classes should implement
+     * this function by passing the vectors to MatrixFree::cell_loop(), which
+     * accepts vectors of pointers to vectors, and working on all vectors
+     * within the cell operation.
+     *
+     * Default implementation is to call apply_add() for each vector.
+     */
+    virtual void
+    multi_apply_add (const std::vector<LinearAlgebra::distributed::Vector<Number> *>       &dst,
+                     const std::vector<const LinearAlgebra::distributed::Vector<Number> *> &src) const;
+
+    /**
+     * Apply operator to @p src and add result in @p dst, running the two
+     * function objects on ranges of the locally owned vector entries before
+     * they are first accessed and after they have been last written to,
+     * respectively. Derived classes should implement this function by
+     * passing the two function objects to the respective variant of
+     * MatrixFree::cell_loop().
+     *
+     * Default implementation is to call @p operation_before_loop on the
+     * whole locally owned range, then apply_add(), and finally @p
+     * operation_after_loop on the whole locally owned range.
+     */
+    virtual void
+    apply_add_with_loop_operations
+    (LinearAlgebra::distributed::Vector<Number>       &dst,
+     const LinearAlgebra::distributed::Vector<Number> &src,
+     const std_cxx11::function<void (const unsigned int,
+                                     const unsigned int)> &operation_before_loop,
+     const std_cxx11::function<void (const unsigned int,
+                                     const unsigned int)> &operation_after_loop) const;
+
     /**
      * MatrixFree object to be used with this operator.
      */
@@ -247,6 +397,222 @@ namespace MatrixFreeOperators
      * indices with the correct local indices.
      */
     void adjust_ghost_range_if_necessary(const LinearAlgebra::distributed::Vector<Number> &vec) const;
+
+    /**
+     * The block-Jacobi preconditioner adjusts the ghost range of the vectors
+     * in the same way as this class.
+     */
+    template <int, int, int, typename> friend class BlockJacobiFastDiagonalization;
+
+    /**
+     * Operation run on a range of vector entries before the cell loop in
+     * vmult() with function objects: calls the user's @p operation, sets
+     * the range of @p dst to zero, and applies the zero constraints on the
+     * refinement edge to @p src.
+     */
+    void run_operation_before_loop
+    (const std_cxx11::function<void (const unsigned int,
+                                     const unsigned int)> &operation,
+     LinearAlgebra::distributed::Vector<Number>       &dst,
+     const LinearAlgebra::distributed::Vector<Number> &src,
+     const unsigned int                                begin,
+     const unsigned int                                end) const;
+
+    /**
+     * Operation run on a range of vector entries after the cell loop in
+     * vmult() with function objects: sets the constrained entries of @p dst,
+     * resets the values of @p src on the refinement edge, and calls the
+     * user's @p operation.
+     */
+    void run_operation_after_loop
+    (const std_cxx11::function<void (const unsigned int,
+                                     const unsigned int)> &operation,
+     LinearAlgebra::distributed::Vector<Number>       &dst,
+     const LinearAlgebra::distributed::Vector<Number> &src,
+     const unsigned int                                begin,
+     const unsigned int                                end) const;
+  };
+
+
+
+  /**
+   * Abstract base class for matrix-free operators acting on block vectors,
+   * such as the Stokes or Navier-Stokes equations discretized with
+   * Taylor-Hood elements, where each block of the vector is associated with
+   * a different DoFHandler of the same MatrixFree object. This class
+   * provides the same interface as Base, with the vectors replaced by
+   * LinearAlgebra::distributed::BlockVector, so that the operator can be
+   * used with the iterative solvers and preconditioners of the library.
+   *
+   * A derived class has to implement apply_add(), which is typically done
+   * by a single MatrixFree::cell_loop() on the block vectors. Within the cell
+   * function, one FEEvaluation object per block is reinitialized on the same
+   * cell batch. The geometry information can be shared between the
+   * evaluators by initializing all but the first with the reinit() function
+   * taking another FEEvaluation object, e.g.
+   * @code
+   * FEEvaluation<dim,2,3,dim> velocity (data, 0);
+   * FEEvaluation<dim,1,3,1>   pressure (data, 1);
+   * for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+   *   {
+   *     velocity.reinit (cell);
+   *     pressure.reinit (velocity);
+   *     velocity.read_dof_values (src.block(0));
+   *     pressure.read_dof_values (src.block(1));
+   *     ...
+   *   }
+   * @endcode
+   *
+   * Constrained degrees of freedom of each block are treated as in Base,
+   * i.e., the operator acts as identity on them. The blocks can be mapped to
+   * a subset of the DoFHandler objects in MatrixFree with the @p
+   * selected_blocks argument of initialize().
+   */
+  template <int dim, typename Number = double>
+  class BlockBase : public Subscriptor
+  {
+  public:
+    /**
+     * Number typedef.
+     */
+    typedef Number value_type;
+
+    /**
+     * size_type needed for preconditioner classes.
+     */
+    typedef typename LinearAlgebra::distributed::BlockVector<Number>::size_type size_type;
+
+    /**
+     * Default constructor.
+     */
+    BlockBase ();
+
+    /**
+     * Virtual destructor.
+     */
+    virtual ~BlockBase();
+
+    /**
+     * Release all memory and return to a state just like after having called
+     * the default constructor.
+     */
+    virtual void clear();
+
+    /**
+     * Initialize the operator. Block @p b of the vectors is associated with
+     * the DoFHandler with index <tt>selected_blocks[b]</tt> in @p data. If
+     * @p selected_blocks is empty, one block per DoFHandler of @p data is
+     * used in the order of the DoFHandler objects.
+     */
+    void initialize (std_cxx11::shared_ptr<const MatrixFree<dim,Number> > data,
+                     const std::vector<unsigned int> &selected_blocks = std::vector<unsigned int>());
+
+    /**
+     * Return the dimension of the codomain (or range) space.
+     */
+    size_type m () const;
+
+    /**
+     * Return the dimension of the domain space.
+     */
+    size_type n () const;
+
+    /**
+     * Return the number of blocks of the vectors this operator acts on.
+     */
+    unsigned int n_blocks () const;
+
+    /**
+     * Matrix-vector multiplication.
+     */
+    void vmult (LinearAlgebra::distributed::BlockVector<Number> &dst,
+                const LinearAlgebra::distributed::BlockVector<Number> &src) const;
+
+    /**
+     * Transpose matrix-vector multiplication.
+     */
+    void Tvmult (LinearAlgebra::distributed::BlockVector<Number> &dst,
+                 const LinearAlgebra::distributed::BlockVector<Number> &src) const;
+
+    /**
+     * Adding Matrix-vector multiplication.
+     */
+    void vmult_add (LinearAlgebra::distributed::BlockVector<Number> &dst,
+                    const LinearAlgebra::distributed::BlockVector<Number> &src) const;
+
+    /**
+     * Adding transpose matrix-vector multiplication.
+     */
+    void Tvmult_add (LinearAlgebra::distributed::BlockVector<Number> &dst,
+                     const LinearAlgebra::distributed::BlockVector<Number> &src) const;
+
+    /**
+     * Determine an estimate for the memory consumption (in bytes) of this object.
+     */
+    virtual std::size_t memory_consumption () const;
+
+    /**
+     * Initialize the block vector @p vec with one block per selected
+     * DoFHandler, using MatrixFree::initialize_dof_vector() on each block.
+     */
+    void initialize_dof_vector (LinearAlgebra::distributed::BlockVector<Number> &vec) const;
+
+    /**
+     * Get read access to the MatrixFree object stored with this operator.
+     */
+    std_cxx11::shared_ptr<const MatrixFree<dim,Number> >
+    get_matrix_free () const;
+
+    /**
+     * Return the indices of the DoFHandler objects in MatrixFree the blocks
+     * are associated with.
+     */
+    const std::vector<unsigned int> &
+    get_selected_blocks () const;
+
+  protected:
+
+    /**
+     * Apply operator to @p src and add result in @p dst.
+     */
+    virtual void apply_add(LinearAlgebra::distributed::BlockVector<Number> &dst,
+                           const LinearAlgebra::distributed::BlockVector<Number> &src) const = 0;
+
+    /**
+     * Apply transpose operator to @p src and add result in @p dst.
+     *
+     * Default implementation is to call apply_add().
+     */
+    virtual void Tapply_add(LinearAlgebra::distributed::BlockVector<Number> &dst,
+                            const LinearAlgebra::distributed::BlockVector<Number> &src) const;
+
+    /**
+     * MatrixFree object to be used with this operator.
+     */
+    std_cxx11::shared_ptr<const MatrixFree<dim,Number> > data;
+
+    /**
+     * The indices of the DoFHandler objects in MatrixFree the blocks are
+     * associated with.
+     */
+    std::vector<unsigned int> selected_blocks;
+
+  private:
+
+    /**
+     * Function which implements vmult_add (@p transpose = false) and
+     * Tvmult_add (@p transpose = true).
+     */
+    void mult_add (LinearAlgebra::distributed::BlockVector<Number> &dst,
+                   const LinearAlgebra::distributed::BlockVector<Number> &src,
+                   const bool transpose) const;
+
+    /**
+     * Adjust the ghost range of all blocks of the vector to the storage
+     * requirements of the respective DoFHandler in the underlying MatrixFree
+     * class, see Base::adjust_ghost_range_if_necessary().
+     */
+    void adjust_ghost_range_if_necessary(const LinearAlgebra::distributed::BlockVector<Number> &vec) const;
   };
 
 
@@ -396,6 +762,279 @@ namespace MatrixFreeOperators
 
 
 
+  /**
+   * This class implements the action of the inverse of a cell-local
+   * operator with tensor product structure on an element with
+   * <tt>(fe_degree+1)^dim</tt> degrees of freedom, as for the DGQ elements,
+   * using the fast diagonalization method. The cell-local operator is the
+   * diagonal block of a symmetric interior penalty discretization of the
+   * operator $-\nabla \cdot \nabla + c$ on an axis-parallel box cell with
+   * extents $h_1,\ldots,h_d$:
+   * @f{align*}{
+   * A = c\, h_1\cdots h_d\, M\otimes\cdots\otimes M + \sum_{d=1}^{\text{dim}}
+   * \left(\prod_{e\neq d} h_e\right) \frac{1}{h_d}\, M \otimes \cdots \otimes
+   * K \otimes \cdots \otimes M,
+   * @f}
+   * where $M$ is the 1D mass matrix and $K$ is the 1D Laplace matrix on the
+   * unit interval including the face terms
+   * $-\frac 12 (\partial_n u\, v + u\, \partial_n v) + \sigma u v$ on both
+   * end points, with the penalty parameter $\sigma=\tau/h_d$ on the faces
+   * orthogonal to direction $d$. These face terms are the contributions of
+   * a cell to the diagonal block on interior faces; on boundary faces, the
+   * diagonal block of the operator is only approximated.
+   *
+   * In the setup, the generalized eigenvalue problem $K s_i = \lambda_i M
+   * s_i$ is solved with the eigenvectors normalized as $S^T M S = I$. The
+   * inverse of the cell operator is then given by
+   * @f{align*}{
+   * A^{-1} = (S\otimes \cdots \otimes S)\, \Lambda^{-1}\,
+   * (S^T\otimes \cdots \otimes S^T),
+   * @f}
+   * where $\Lambda$ is a diagonal matrix with entries
+   * $h_1\cdots h_d(c + \sum_d \lambda_{i_d}/h_d^2)$. The application of
+   * the inverse is done with the tensor product kernels of FEEvaluation at
+   * a cost of $\mathcal O(k^{d+1})$ operations per cell. Both the 1D mass
+   * and Laplace matrices are computed with the 1D shape functions and the
+   * quadrature formula stored in MatrixFree, so the inverse is exact for
+   * operators that integrate with the same quadrature formula.
+   *
+   * For cells that are not axis-parallel boxes, the extents of the cell in
+   * the coordinate directions are used, giving an approximate inverse.
+   */
+  template <int dim, int fe_degree, int n_components = 1, typename Number = double>
+  class CellwiseFastDiagonalization
+  {
+  public:
+    /**
+     * Empty constructor. The object must be initialized with reinit()
+     * before use.
+     */
+    CellwiseFastDiagonalization ();
+
+    /**
+     * Constructor. Calls reinit() with the given arguments.
+     */
+    CellwiseFastDiagonalization (const MatrixFree<dim,Number> &matrix_free,
+                                 const double                  penalty_factor,
+                                 const double                  mass_coefficient = 0.,
+                                 const unsigned int            dof_no = 0,
+                                 const unsigned int            quad_no = 0);
+
+    /**
+     * Compute the 1D mass and Laplace matrices on the unit interval with the
+     * shape information of the finite element with index @p dof_no and the
+     * quadrature formula with index @p quad_no in @p matrix_free and solve
+     * the generalized eigenvalue problem. The penalty parameter on the unit
+     * interval is given by @p penalty_factor, i.e., $\tau$ in the class
+     * documentation, and the coefficient of the mass term by @p
+     * mass_coefficient.
+     */
+    void reinit (const MatrixFree<dim,Number> &matrix_free,
+                 const double                  penalty_factor,
+                 const double                  mass_coefficient = 0.,
+                 const unsigned int            dof_no = 0,
+                 const unsigned int            quad_no = 0);
+
+    /**
+     * Return the extents of the cells in the cell batch @p macro_cell of
+     * @p matrix_free in the coordinate directions. Unfilled lanes of the
+     * batch get the extents of the first cell.
+     */
+    static Tensor<1,dim,VectorizedArray<Number> >
+    compute_cell_extent (const MatrixFree<dim,Number> &matrix_free,
+                         const unsigned int            macro_cell,
+                         const unsigned int            dof_no = 0);
+
+    /**
+     * Applies the inverse of the cell operator on a cell batch with the
+     * given @p cell_extent on an input array, multiplied by the factor @p
+     * scaling. It is assumed that the passed input and output arrays are of
+     * correct size, namely <tt>(fe_degree+1)^dim * n_actual_components</tt>
+     * long. The input and output arrays may be the same.
+     */
+    void apply (const Tensor<1,dim,VectorizedArray<Number> > &cell_extent,
+                const Number                                   scaling,
+                const unsigned int                             n_actual_components,
+                const VectorizedArray<Number>                 *in_array,
+                VectorizedArray<Number>                       *out_array) const;
+
+    /**
+     * Return the eigenvalues of the 1D generalized eigenvalue problem on the
+     * unit interval.
+     */
+    const std::vector<Number> &
+    get_eigenvalues () const;
+
+  private:
+    /**
+     * The eigenvectors of the 1D generalized eigenvalue problem, with the
+     * value of eigenvector @p j in the node @p i stored at position
+     * <code>i*(fe_degree+1)+j</code>, which is the layout expected by
+     * internal::EvaluatorTensorProduct.
+     */
+    AlignedVector<VectorizedArray<Number> > eigenvectors;
+
+    /**
+     * The eigenvalues of the 1D generalized eigenvalue problem.
+     */
+    std::vector<Number> eigenvalues;
+
+    /**
+     * The coefficient of the mass term.
+     */
+    Number mass_coefficient;
+
+    /**
+     * Compute the eigenvalues and eigenvectors of the symmetric matrix @p
+     * matrix by the cyclic Jacobi method. On exit, @p matrix holds the
+     * eigenvectors in its columns.
+     */
+    static void compute_symmetric_eigenvalues (FullMatrix<double>  &matrix,
+                                               std::vector<double> &eigenvalues);
+  };
+
+
+
+  /**
+   * A block-Jacobi preconditioner for matrix-free discontinuous Galerkin
+   * discretizations of (reaction-)diffusion problems, where the cell blocks
+   * are inverted with the fast diagonalization method implemented in
+   * CellwiseFastDiagonalization. The vmult() operation computes
+   * $dst = \omega P^{-1} src$ with the relaxation parameter $\omega$ and
+   * the block-diagonal matrix $P$ of cell operators. It runs through all
+   * cells of the MatrixFree object of the operator given to initialize(),
+   * reading the cell values with FEEvaluation, applying the inverse of the
+   * cell operator and writing the results back.
+   *
+   * The interface of this class is compatible with MGSmootherPrecondition,
+   * e.g.
+   * @code
+   * typedef MatrixFreeOperators::BlockJacobiFastDiagonalization<dim,fe_degree,1,float> SmootherType;
+   * MGSmootherPrecondition<LevelMatrixType,SmootherType,
+   *                        LinearAlgebra::distributed::Vector<float> > mg_smoother(3);
+   * mg_smoother.initialize(mg_matrices,
+   *                        SmootherType::AdditionalData(0.7, penalty_factor));
+   * @endcode
+   *
+   * The cell-wise inverse is only exact on the diagonal blocks of interior
+   * cells of axis-parallel meshes when the penalty parameter and the mass
+   * coefficient match the ones of the operator, see the documentation of
+   * CellwiseFastDiagonalization. For other meshes and for non-symmetric
+   * operators, such as convection-diffusion, it provides the block-Jacobi
+   * method of an approximate (symmetric) operator.
+   */
+  template <int dim, int fe_degree, int n_components = 1, typename Number = double>
+  class BlockJacobiFastDiagonalization : public Subscriptor
+  {
+  public:
+    /**
+     * Parameters for the block-Jacobi method.
+     */
+    struct AdditionalData
+    {
+      /**
+       * Constructor. A negative @p penalty_factor selects the default value
+       * $(k+1)^2$ for the polynomial degree $k$.
+       */
+      AdditionalData (const double       relaxation = 1.,
+                      const double       penalty_factor = -1.,
+                      const double       mass_coefficient = 0.,
+                      const unsigned int dof_no = 0,
+                      const unsigned int quad_no = 0);
+
+      /**
+       * The relaxation parameter $\omega$.
+       */
+      double relaxation;
+
+      /**
+       * The penalty factor $\tau$ on the unit interval, see
+       * CellwiseFastDiagonalization.
+       */
+      double penalty_factor;
+
+      /**
+       * The coefficient $c$ of the mass term in the cell operator.
+       */
+      double mass_coefficient;
+
+      /**
+       * The index of the DoFHandler in the MatrixFree object.
+       */
+      unsigned int dof_no;
+
+      /**
+       * The index of the quadrature formula in the MatrixFree object.
+       */
+      unsigned int quad_no;
+    };
+
+    /**
+     * Initialize the preconditioner with the MatrixFree object of the
+     * operator @p matrix. This computes the 1D eigendecompositions and the
+     * extents of all cells.
+     */
+    void initialize (const Base<dim,Number>  &matrix,
+                     const AdditionalData    &additional_data = AdditionalData());
+
+    /**
+     * Release all memory and return to a state just like after having called
+     * the default constructor.
+     */
+    void clear ();
+
+    /**
+     * Apply the preconditioner, i.e., set @p dst to $\omega P^{-1} src$.
+     */
+    void vmult (LinearAlgebra::distributed::Vector<Number>       &dst,
+                const LinearAlgebra::distributed::Vector<Number> &src) const;
+
+    /**
+     * Apply the transpose preconditioner. Since the cell operators are
+     * symmetric, this is the same as vmult().
+     */
+    void Tvmult (LinearAlgebra::distributed::Vector<Number>       &dst,
+                 const LinearAlgebra::distributed::Vector<Number> &src) const;
+
+    /**
+     * Determine an estimate for the memory consumption (in bytes) of this
+     * object.
+     */
+    std::size_t memory_consumption () const;
+
+  private:
+    /**
+     * Apply the inverse of the cell operators on a range of cells.
+     */
+    void local_apply (const MatrixFree<dim,Number>                     &data,
+                      LinearAlgebra::distributed::Vector<Number>       &dst,
+                      const LinearAlgebra::distributed::Vector<Number> &src,
+                      const std::pair<unsigned int,unsigned int>       &cell_range) const;
+
+    /**
+     * Pointer to the operator, used to adjust the ghost range of vectors.
+     */
+    SmartPointer<const Base<dim,Number> > matrix;
+
+    /**
+     * The inverse of the cell operators.
+     */
+    CellwiseFastDiagonalization<dim,fe_degree,n_components,Number> cell_inverse;
+
+    /**
+     * The extents of all cell batches, see
+     * CellwiseFastDiagonalization::compute_cell_extent().
+     */
+    AlignedVector<Tensor<1,dim,VectorizedArray<Number> > > cell_extents;
+
+    /**
+     * Parameters handed to initialize().
+     */
+    AdditionalData additional_data;
+  };
+
+
+
   /**
    * This class implements the operation of the action of a mass matrix.
    *
@@ -434,6 +1073,27 @@ namespace MatrixFreeOperators
     virtual void apply_add (LinearAlgebra::distributed::Vector<Number>       &dst,
                             const LinearAlgebra::distributed::Vector<Number> &src) const;
 
+    /**
+     * Same as apply_add(), but running the given operations on ranges of
+     * vector entries as part of the cell loop.
+     */
+    virtual void
+    apply_add_with_loop_operations
+    (LinearAlgebra::distributed::Vector<Number>       &dst,
+     const LinearAlgebra::distributed::Vector<Number> &src,
+     const std_cxx11::function<void (const unsigned int,
+                                     const unsigned int)> &operation_before_loop,
+     const std_cxx11::function<void (const unsigned int,
+                                     const unsigned int)> &operation_after_loop) const;
+
+    /**
+     * Same as apply_add(), but for several vectors at once, which are all
+     * processed within a single loop over the cells.
+     */
+    virtual void
+    multi_apply_add (const std::vector<LinearAlgebra::distributed::Vector<Number> *>       &dst,
+                     const std::vector<const LinearAlgebra::distributed::Vector<Number> *> &src) const;
+
     /**
      * For this operator, there is just a cell contribution.
      */
@@ -441,6 +1101,14 @@ namespace MatrixFreeOperators
                            LinearAlgebra::distributed::Vector<Number>       &dst,
                            const LinearAlgebra::distributed::Vector<Number> &src,
                            const std::pair<unsigned int,unsigned int>  &cell_range) const;
+
+    /**
+     * Cell operation of multi_apply_add().
+     */
+    void local_multi_apply_cell (const MatrixFree<dim,Number>                                         &data,
+                                 std::vector<LinearAlgebra::distributed::Vector<Number> *>             &dst,
+                                 const std::vector<const LinearAlgebra::distributed::Vector<Number> *> &src,
+                                 const std::pair<unsigned int,unsigned int>                            &cell_range) const;
   };
 
 
@@ -543,6 +1211,27 @@ namespace MatrixFreeOperators
     virtual void apply_add (LinearAlgebra::distributed::Vector<Number>       &dst,
                             const LinearAlgebra::distributed::Vector<Number> &src) const;
 
+    /**
+     * Same as apply_add(), but running the given operations on ranges of
+     * vector entries as part of the cell loop.
+     */
+    virtual void
+    apply_add_with_loop_operations
+    (LinearAlgebra::distributed::Vector<Number>       &dst,
+     const LinearAlgebra::distributed::Vector<Number> &src,
+     const std_cxx11::function<void (const unsigned int,
+                                     const unsigned int)> &operation_before_loop,
+     const std_cxx11::function<void (const unsigned int,
+                                     const unsigned int)> &operation_after_loop) const;
+
+    /**
+     * Same as apply_add(), but for several vectors at once, which are all
+     * processed within a single loop over the cells.
+     */
+    virtual void
+    multi_apply_add (const std::vector<LinearAlgebra::distributed::Vector<Number> *>       &dst,
+                     const std::vector<const LinearAlgebra::distributed::Vector<Number> *> &src) const;
+
     /**
      * Applies the Laplace operator on a cell.
      */
@@ -551,6 +1240,14 @@ namespace MatrixFreeOperators
                            const LinearAlgebra::distributed::Vector<Number> &src,
                            const std::pair<unsigned int,unsigned int>  &cell_range) const;
 
+    /**
+     * Applies the Laplace operator on a cell for several vectors.
+     */
+    void local_multi_apply_cell (const MatrixFree<dim,Number>                                         &data,
+                                 std::vector<LinearAlgebra::distributed::Vector<Number> *>             &dst,
+                                 const std::vector<const LinearAlgebra::distributed::Vector<Number> *> &src,
+                                 const std::pair<unsigned int,unsigned int>                            &cell_range) const;
+
     /**
      * Apply diagonal part of the Laplace operator on a cell.
      */
@@ -686,6 +1383,427 @@ namespace MatrixFreeOperators
       }
   }
 
+  template <int dim, int fe_degree, int n_components, typename Number>
+  inline
+  CellwiseFastDiagonalization<dim,fe_degree,n_components,Number>
+  ::CellwiseFastDiagonalization ()
+    :
+    mass_coefficient (0.)
+  {}
+
+
+
+  template <int dim, int fe_degree, int n_components, typename Number>
+  inline
+  CellwiseFastDiagonalization<dim,fe_degree,n_components,Number>
+  ::CellwiseFastDiagonalization (const MatrixFree<dim,Number> &matrix_free,
+                                 const double                  penalty_factor,
+                                 const double                  mass_coefficient,
+                                 const unsigned int            dof_no,
+                                 const unsigned int            quad_no)
+  {
+    reinit (matrix_free, penalty_factor, mass_coefficient, dof_no, quad_no);
+  }
+
+
+
+  template <int dim, int fe_degree, int n_components, typename Number>
+  inline
+  void
+  CellwiseFastDiagonalization<dim,fe_degree,n_components,Number>
+  ::reinit (const MatrixFree<dim,Number> &matrix_free,
+            const double                  penalty_factor,
+            const double                  mass_coefficient_in,
+            const unsigned int            dof_no,
+            const unsigned int            quad_no)
+  {
+    const internal::MatrixFreeFunctions::ShapeInfo<Number> &shape_info =
+      matrix_free.get_shape_info(dof_no, quad_no);
+    const unsigned int n_dofs_1d = fe_degree+1;
+    const unsigned int n_q_points_1d = shape_info.n_q_points_1d;
+    AssertDimension (shape_info.fe_degree, fe_degree);
+    Assert (n_q_points_1d >= n_dofs_1d,
+            ExcMessage("The fast diagonalization needs at least fe_degree+1 "
+                       "quadrature points per direction to get an invertible "
+                       "mass matrix"));
+
+    // The dim-dimensional quadrature formula is a tensor product, so the
+    // first n_q_points_1d points run along the first coordinate direction
+    // with weights w_q * w_0^(dim-1). Since the 1D weights sum up to one, we
+    // can extract the 1D weights by normalization.
+    const Quadrature<dim> &quadrature = matrix_free.get_quadrature(quad_no);
+    std::vector<double> weights_1d (n_q_points_1d);
+    double weight_sum = 0;
+    for (unsigned int q=0; q<n_q_points_1d; ++q)
+      weight_sum += quadrature.weight(q);
+    for (unsigned int q=0; q<n_q_points_1d; ++q)
+      weights_1d[q] = quadrature.weight(q) / weight_sum;
+
+    // assemble the 1D mass and Laplace matrices on the unit interval,
+    // including the face terms of the symmetric interior penalty method on
+    // both end points with outer normal -1 (in zero) and +1 (in one)
+    FullMatrix<double> mass_matrix (n_dofs_1d, n_dofs_1d),
+               laplace_matrix (n_dofs_1d, n_dofs_1d);
+    for (unsigned int i=0; i<n_dofs_1d; ++i)
+      for (unsigned int j=0; j<n_dofs_1d; ++j)
+        {
+          double sum_mass = 0, sum_laplace = 0;
+          for (unsigned int q=0; q<n_q_points_1d; ++q)
+            {
+              sum_mass += weights_1d[q] *
+                          shape_info.shape_values_number[i*n_q_points_1d+q] *
+                          shape_info.shape_values_number[j*n_q_points_1d+q];
+              sum_laplace += weights_1d[q] *
+                             shape_info.shape_gradient_number[i*n_q_points_1d+q] *
+                             shape_info.shape_gradient_number[j*n_q_points_1d+q];
+            }
+          for (unsigned int side=0; side<2; ++side)
+            {
+              const double normal = side == 0 ? -1. : 1.;
+              sum_laplace += - 0.5 * normal *
+                             (shape_info.face_gradient[side][i] *
+                              shape_info.face_value[side][j] +
+                              shape_info.face_value[side][i] *
+                              shape_info.face_gradient[side][j])
+                             + penalty_factor *
+                             shape_info.face_value[side][i] *
+                             shape_info.face_value[side][j];
+            }
+          mass_matrix(i,j) = sum_mass;
+          laplace_matrix(i,j) = sum_laplace;
+        }
+
+    // transform the generalized eigenvalue problem K s = lambda M s to a
+    // standard one with the Cholesky factor M = L L^T, i.e., solve
+    // L^{-1} K L^{-T} q = lambda q and set s = L^{-T} q
+    FullMatrix<double> cholesky_factor (n_dofs_1d, n_dofs_1d),
+               inverse_cholesky (n_dofs_1d, n_dofs_1d),
+               tmp (n_dofs_1d, n_dofs_1d),
+               transformed_matrix (n_dofs_1d, n_dofs_1d);
+    cholesky_factor.cholesky (mass_matrix);
+    inverse_cholesky.invert (cholesky_factor);
+    inverse_cholesky.mmult (tmp, laplace_matrix);
+    tmp.mTmult (transformed_matrix, inverse_cholesky);
+
+    std::vector<double> eigenvalues_double;
+    compute_symmetric_eigenvalues (transformed_matrix, eigenvalues_double);
+    inverse_cholesky.Tmmult (tmp, transformed_matrix);
+
+    eigenvalues.resize (n_dofs_1d);
+    eigenvectors.resize (n_dofs_1d*n_dofs_1d);
+    for (unsigned int i=0; i<n_dofs_1d; ++i)
+      {
+        eigenvalues[i] = eigenvalues_double[i];
+        for (unsigned int j=0; j<n_dofs_1d; ++j)
+          eigenvectors[i*n_dofs_1d+j] = tmp(i,j);
+      }
+    mass_coefficient = mass_coefficient_in;
+  }
+
+
+
+  template <int dim, int fe_degree, int n_components, typename Number>
+  inline
+  void
+  CellwiseFastDiagonalization<dim,fe_degree,n_components,Number>
+  ::compute_symmetric_eigenvalues (FullMatrix<double>  &matrix,
+                                   std::vector<double> &eigenvalues)
+  {
+    const unsigned int n = matrix.m();
+    AssertDimension (n, matrix.n());
+    FullMatrix<double> vectors (n, n);
+    for (unsigned int i=0; i<n; ++i)
+      vectors(i,i) = 1.;
+
+    // cyclic Jacobi method: annihilate the off-diagonal entries by plane
+    // rotations until they are small relative to the diagonal entries. For
+    // the small matrices of the 1D problems, this converges in a few sweeps.
+    for (unsigned int sweep=0; sweep<50; ++sweep)
+      {
+        double off_diagonal = 0, diagonal = 0;
+        for (unsigned int i=0; i<n; ++i)
+          {
+            diagonal += matrix(i,i) * matrix(i,i);
+            for (unsigned int j=i+1; j<n; ++j)
+              off_diagonal += matrix(i,j) * matrix(i,j);
+          }
+        if (off_diagonal <= 1e-30 * diagonal)
+          break;
+
+        for (unsigned int p=0; p<n; ++p)
+          for (unsigned int q=p+1; q<n; ++q)
+            {
+              if (matrix(p,q) == 0.)
+                continue;
+              const double theta = (matrix(q,q) - matrix(p,p)) / (2. * matrix(p,q));
+              const double t = (theta >= 0 ? 1. : -1.) /
+                               (std::abs(theta) + std::sqrt(theta*theta + 1.));
+              const double c = 1./std::sqrt(t*t + 1.);
+              const double s = t * c;
+              for (unsigned int k=0; k<n; ++k)
+                {
+                  const double a_kp = matrix(k,p), a_kq = matrix(k,q);
+                  matrix(k,p) = c * a_kp - s * a_kq;
+                  matrix(k,q) = s * a_kp + c * a_kq;
+                }
+              for (unsigned int k=0; k<n; ++k)
+                {
+                  const double a_pk = matrix(p,k), a_qk = matrix(q,k);
+                  matrix(p,k) = c * a_pk - s * a_qk;
+                  matrix(q,k) = s * a_pk + c * a_qk;
+                }
+              for (unsigned int k=0; k<n; ++k)
+                {
+                  const double v_kp = vectors(k,p), v_kq = vectors(k,q);
+                  vectors(k,p) = c * v_kp - s * v_kq;
+                  vectors(k,q) = s * v_kp + c * v_kq;
+                }
+            }
+      }
+
+    eigenvalues.resize (n);
+    for (unsigned int i=0; i<n; ++i)
+      eigenvalues[i] = matrix(i,i);
+    matrix = vectors;
+  }
+
+
+
+  template <int dim, int fe_degree, int n_components, typename Number>
+  inline
+  Tensor<1,dim,VectorizedArray<Number> >
+  CellwiseFastDiagonalization<dim,fe_degree,n_components,Number>
+  ::compute_cell_extent (const MatrixFree<dim,Number> &matrix_free,
+                         const unsigned int            macro_cell,
+                         const unsigned int            dof_no)
+  {
+    Tensor<1,dim,VectorizedArray<Number> > cell_extent;
+    for (unsigned int v=0; v<VectorizedArray<Number>::n_array_elements; ++v)
+      {
+        const unsigned int lane = v < matrix_free.n_components_filled(macro_cell)
+                                  ? v : 0;
+        const typename DoFHandler<dim>::cell_iterator cell =
+          matrix_free.get_cell_iterator(macro_cell, lane, dof_no);
+        for (unsigned int d=0; d<dim; ++d)
+          cell_extent[d][v] = cell->extent_in_direction(d);
+      }
+    return cell_extent;
+  }
+
+
+
+  template <int dim, int fe_degree, int n_components, typename Number>
+  inline
+  const std::vector<Number> &
+  CellwiseFastDiagonalization<dim,fe_degree,n_components,Number>
+  ::get_eigenvalues () const
+  {
+    return eigenvalues;
+  }
+
+
+
+  template <int dim, int fe_degree, int n_components, typename Number>
+  inline
+  void
+  CellwiseFastDiagonalization<dim,fe_degree,n_components,Number>
+  ::apply (const Tensor<1,dim,VectorizedArray<Number> > &cell_extent,
+           const Number                                   scaling,
+           const unsigned int                             n_actual_components,
+           const VectorizedArray<Number>                 *in_array,
+           VectorizedArray<Number>                       *out_array) const
+  {
+    const unsigned int n_dofs_1d = fe_degree+1;
+    const unsigned int dofs_per_cell = Utilities::fixed_int_power<fe_degree+1,dim>::value;
+    Assert (eigenvalues.size() == n_dofs_1d, ExcNotInitialized());
+
+    internal::EvaluatorTensorProduct<internal::evaluate_general,dim,fe_degree,
+             fe_degree+1, VectorizedArray<Number> >
+             evaluator(eigenvectors, eigenvectors, eigenvectors);
+
+    // compute the inverse of the diagonal matrix in the eigenbasis,
+    // h_1...h_d (c + sum_d lambda_{i_d} / h_d^2)
+    VectorizedArray<Number> volume = make_vectorized_array<Number>(1.);
+    VectorizedArray<Number> inverse_h_squared[dim];
+    for (unsigned int d=0; d<dim; ++d)
+      {
+        volume *= cell_extent[d];
+        inverse_h_squared[d] = 1./(cell_extent[d]*cell_extent[d]);
+      }
+    VectorizedArray<Number> inverse_eigenvalues[dofs_per_cell];
+    for (unsigned int i=0; i<dofs_per_cell; ++i)
+      {
+        VectorizedArray<Number> eigenvalue = make_vectorized_array(mass_coefficient);
+        for (unsigned int d=0, stride=1; d<dim; ++d, stride*=n_dofs_1d)
+          eigenvalue += eigenvalues[(i/stride)%n_dofs_1d] * inverse_h_squared[d];
+        inverse_eigenvalues[i] = scaling / (volume * eigenvalue);
+      }
+
+    VectorizedArray<Number> temp_data_field[dofs_per_cell];
+    for (unsigned int c=0; c<n_actual_components; ++c)
+      {
+        const VectorizedArray<Number> *in = in_array+c*dofs_per_cell;
+        VectorizedArray<Number> *out = out_array+c*dofs_per_cell;
+
+        // transform to the eigenbasis with S^T in all directions, scale by
+        // the inverse eigenvalues and transform back with S. The input array
+        // is only read in the first step, so it may coincide with the output
+        if (dim == 1)
+          {
+            evaluator.template values<0,true,false> (in, temp_data_field);
+            for (unsigned int i=0; i<dofs_per_cell; ++i)
+              temp_data_field[i] *= inverse_eigenvalues[i];
+            evaluator.template values<0,false,false> (temp_data_field, out);
+          }
+        else if (dim == 2)
+          {
+            evaluator.template values<0,true,false> (in, temp_data_field);
+            evaluator.template values<1,true,false> (temp_data_field, out);
+            for (unsigned int i=0; i<dofs_per_cell; ++i)
+              out[i] *= inverse_eigenvalues[i];
+            evaluator.template values<1,false,false> (out, temp_data_field);
+            evaluator.template values<0,false,false> (temp_data_field, out);
+          }
+        else if (dim == 3)
+          {
+            evaluator.template values<0,true,false> (in, temp_data_field);
+            evaluator.template values<1,true,false> (temp_data_field, out);
+            evaluator.template values<2,true,false> (out, temp_data_field);
+            for (unsigned int i=0; i<dofs_per_cell; ++i)
+              temp_data_field[i] *= inverse_eigenvalues[i];
+            evaluator.template values<2,false,false> (temp_data_field, out);
+            evaluator.template values<1,false,false> (out, temp_data_field);
+            evaluator.template values<0,false,false> (temp_data_field, out);
+          }
+        else
+          Assert (false, ExcNotImplemented());
+      }
+  }
+
+
+
+  template <int dim, int fe_degree, int n_components, typename Number>
+  inline
+  BlockJacobiFastDiagonalization<dim,fe_degree,n_components,Number>::AdditionalData
+  ::AdditionalData (const double       relaxation,
+                    const double       penalty_factor,
+                    const double       mass_coefficient,
+                    const unsigned int dof_no,
+                    const unsigned int quad_no)
+    :
+    relaxation (relaxation),
+    penalty_factor (penalty_factor),
+    mass_coefficient (mass_coefficient),
+    dof_no (dof_no),
+    quad_no (quad_no)
+  {}
+
+
+
+  template <int dim, int fe_degree, int n_components, typename Number>
+  inline
+  void
+  BlockJacobiFastDiagonalization<dim,fe_degree,n_components,Number>
+  ::initialize (const Base<dim,Number> &matrix_in,
+                const AdditionalData   &additional_data_in)
+  {
+    matrix = &matrix_in;
+    additional_data = additional_data_in;
+    if (additional_data.penalty_factor < 0)
+      additional_data.penalty_factor = (fe_degree+1)*(fe_degree+1);
+
+    const MatrixFree<dim,Number> &matrix_free = *matrix->get_matrix_free();
+    cell_inverse.reinit (matrix_free, additional_data.penalty_factor,
+                         additional_data.mass_coefficient,
+                         additional_data.dof_no, additional_data.quad_no);
+    cell_extents.resize (matrix_free.n_macro_cells());
+    for (unsigned int cell=0; cell<matrix_free.n_macro_cells(); ++cell)
+      cell_extents[cell] =
+        CellwiseFastDiagonalization<dim,fe_degree,n_components,Number>::
+        compute_cell_extent (matrix_free, cell, additional_data.dof_no);
+  }
+
+
+
+  template <int dim, int fe_degree, int n_components, typename Number>
+  inline
+  void
+  BlockJacobiFastDiagonalization<dim,fe_degree,n_components,Number>
+  ::clear ()
+  {
+    matrix = 0;
+    cell_inverse = CellwiseFastDiagonalization<dim,fe_degree,n_components,Number>();
+    cell_extents.clear();
+  }
+
+
+
+  template <int dim, int fe_degree, int n_components, typename Number>
+  inline
+  void
+  BlockJacobiFastDiagonalization<dim,fe_degree,n_components,Number>
+  ::vmult (LinearAlgebra::distributed::Vector<Number>       &dst,
+           const LinearAlgebra::distributed::Vector<Number> &src) const
+  {
+    Assert (matrix != 0, ExcNotInitialized());
+    matrix->adjust_ghost_range_if_necessary(src);
+    matrix->adjust_ghost_range_if_necessary(dst);
+    dst = 0;
+    matrix->get_matrix_free()->cell_loop (&BlockJacobiFastDiagonalization::local_apply,
+                                          this, dst, src);
+  }
+
+
+
+  template <int dim, int fe_degree, int n_components, typename Number>
+  inline
+  void
+  BlockJacobiFastDiagonalization<dim,fe_degree,n_components,Number>
+  ::Tvmult (LinearAlgebra::distributed::Vector<Number>       &dst,
+            const LinearAlgebra::distributed::Vector<Number> &src) const
+  {
+    vmult (dst, src);
+  }
+
+
+
+  template <int dim, int fe_degree, int n_components, typename Number>
+  inline
+  std::size_t
+  BlockJacobiFastDiagonalization<dim,fe_degree,n_components,Number>
+  ::memory_consumption () const
+  {
+    return sizeof(*this) + MemoryConsumption::memory_consumption(cell_extents);
+  }
+
+
+
+  template <int dim, int fe_degree, int n_components, typename Number>
+  inline
+  void
+  BlockJacobiFastDiagonalization<dim,fe_degree,n_components,Number>
+  ::local_apply (const MatrixFree<dim,Number>                     &data,
+                 LinearAlgebra::distributed::Vector<Number>       &dst,
+                 const LinearAlgebra::distributed::Vector<Number> &src,
+                 const std::pair<unsigned int,unsigned int>       &cell_range) const
+  {
+    // only read and write the cell values, so the sizes can be selected at
+    // run time
+    FEEvaluation<dim,-1,0,n_components,Number>
+    phi (data, additional_data.dof_no, additional_data.quad_no);
+    for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+      {
+        phi.reinit (cell);
+        phi.read_dof_values (src);
+        cell_inverse.apply (cell_extents[cell], additional_data.relaxation,
+                            n_components, phi.begin_dof_values(),
+                            phi.begin_dof_values());
+        phi.distribute_local_to_global (dst);
+      }
+  }
+
+
+
   //----------------- Base operator -----------------------------
   template <int dim, typename Number>
   Base<dim,Number>::~Base ()
@@ -754,10 +1872,7 @@ namespace MatrixFreeOperators
   {
     Assert(data.get() != NULL,
            ExcNotInitialized());
-    if (!vec.partitioners_are_compatible(*data->get_dof_info(0).vector_partitioner))
-      data->initialize_dof_vector(vec);
-    Assert(vec.partitioners_are_globally_compatible(*data->get_dof_info(0).vector_partitioner),
-           ExcInternalError());
+    internal::MatrixFreeOperators::initialize_dof_vector(*data, 0, vec);
   }
 
 
@@ -832,6 +1947,109 @@ namespace MatrixFreeOperators
 
 
 
+  template <int dim, typename Number>
+  void
+  Base<dim,Number>::
+  vmult (LinearAlgebra::distributed::Vector<Number>       &dst,
+         const LinearAlgebra::distributed::Vector<Number> &src,
+         const std_cxx11::function<void (const unsigned int,
+                                         const unsigned int)> &operation_before_matrix_vector_product,
+         const std_cxx11::function<void (const unsigned int,
+                                         const unsigned int)> &operation_after_matrix_vector_product) const
+  {
+    adjust_ghost_range_if_necessary(src);
+    adjust_ghost_range_if_necessary(dst);
+
+    // the locally owned entries of dst are set to zero range by range right
+    // before the cell loop accesses them, but the ghost entries the cell
+    // loop adds into must be zero from the start
+    dst.zero_out_ghosts();
+
+    apply_add_with_loop_operations
+    (dst, src,
+     std_cxx11::bind (&Base<dim,Number>::run_operation_before_loop, this,
+                      std_cxx11::cref(operation_before_matrix_vector_product),
+                      std_cxx11::ref(dst), std_cxx11::cref(src),
+                      std_cxx11::_1, std_cxx11::_2),
+     std_cxx11::bind (&Base<dim,Number>::run_operation_after_loop, this,
+                      std_cxx11::cref(operation_after_matrix_vector_product),
+                      std_cxx11::ref(dst), std_cxx11::cref(src),
+                      std_cxx11::_1, std_cxx11::_2));
+  }
+
+
+
+  template <int dim, typename Number>
+  void
+  Base<dim,Number>::
+  run_operation_before_loop
+  (const std_cxx11::function<void (const unsigned int,
+                                   const unsigned int)> &operation,
+   LinearAlgebra::distributed::Vector<Number>       &dst,
+   const LinearAlgebra::distributed::Vector<Number> &src,
+   const unsigned int                                begin,
+   const unsigned int                                end) const
+  {
+    if (operation)
+      operation(begin, end);
+
+    Number *dst_ptr = dst.begin();
+    for (unsigned int i=begin; i<end; ++i)
+      dst_ptr[i] = Number();
+
+    // set zero Dirichlet values on the input vector and remember the src
+    // values because we need to reset them after the loop
+    for (std::vector<unsigned int>::const_iterator
+         it = std::lower_bound(edge_constrained_indices.begin(),
+                               edge_constrained_indices.end(), begin);
+         it != edge_constrained_indices.end() && *it < end; ++it)
+      {
+        const unsigned int i = it - edge_constrained_indices.begin();
+        edge_constrained_values[i] =
+          std::pair<Number,Number>(src.local_element(*it), Number());
+        const_cast<LinearAlgebra::distributed::Vector<Number>&>(src).local_element(*it) = 0.;
+      }
+  }
+
+
+
+  template <int dim, typename Number>
+  void
+  Base<dim,Number>::
+  run_operation_after_loop
+  (const std_cxx11::function<void (const unsigned int,
+                                   const unsigned int)> &operation,
+   LinearAlgebra::distributed::Vector<Number>       &dst,
+   const LinearAlgebra::distributed::Vector<Number> &src,
+   const unsigned int                                begin,
+   const unsigned int                                end) const
+  {
+    const std::vector<unsigned int> &
+    constrained_dofs = data->get_constrained_dofs();
+    for (std::vector<unsigned int>::const_iterator
+         it = std::lower_bound(constrained_dofs.begin(),
+                               constrained_dofs.end(), begin);
+         it != constrained_dofs.end() && *it < end; ++it)
+      dst.local_element(*it) += src.local_element(*it);
+
+    // reset edge constrained values, multiply by unit matrix and add into
+    // destination
+    for (std::vector<unsigned int>::const_iterator
+         it = std::lower_bound(edge_constrained_indices.begin(),
+                               edge_constrained_indices.end(), begin);
+         it != edge_constrained_indices.end() && *it < end; ++it)
+      {
+        const unsigned int i = it - edge_constrained_indices.begin();
+        const_cast<LinearAlgebra::distributed::Vector<Number>&>(src).local_element(*it) = edge_constrained_values[i].first;
+        dst.local_element(*it) = edge_constrained_values[i].first;
+      }
+
+    if (operation)
+      operation(begin, end);
+  }
+
+
+
   template <int dim, typename Number>
   void
   Base<dim,Number>::vmult_add (LinearAlgebra::distributed::Vector<Number> &dst,
@@ -854,28 +2072,57 @@ namespace MatrixFreeOperators
 
   template <int dim, typename Number>
   void
-  Base<dim,Number>::adjust_ghost_range_if_necessary(const LinearAlgebra::distributed::Vector<Number> &src) const
+  Base<dim,Number>::
+  multi_vmult (const std::vector<LinearAlgebra::distributed::Vector<Number> *>       &dst,
+               const std::vector<const LinearAlgebra::distributed::Vector<Number> *> &src) const
   {
-    // If both vectors use the same partitioner -> done
-    if (src.get_partitioner().get() ==
-        data->get_dof_info(0).vector_partitioner.get())
-      return;
+    AssertDimension (dst.size(), src.size());
+    const unsigned int n_vectors = src.size();
+    const unsigned int n_edge = edge_constrained_indices.size();
+
+    // set zero Dirichlet values on the input vectors and remember the src
+    // values because we need to reset them at the end. the member
+    // edge_constrained_values only has space for one vector
+    std::vector<Number> edge_values (n_vectors*n_edge);
+    for (unsigned int v=0; v<n_vectors; ++v)
+      {
+        adjust_ghost_range_if_necessary(*src[v]);
+        adjust_ghost_range_if_necessary(*dst[v]);
+        *dst[v] = Number(0.);
+        for (unsigned int i=0; i<n_edge; ++i)
+          {
+            edge_values[v*n_edge+i] = src[v]->local_element(edge_constrained_indices[i]);
+            const_cast<LinearAlgebra::distributed::Vector<Number>&>(*src[v]).local_element(edge_constrained_indices[i]) = 0.;
+          }
+      }
+
+    multi_apply_add (dst, src);
+
+    const std::vector<unsigned int> &
+    constrained_dofs = data->get_constrained_dofs();
+    for (unsigned int v=0; v<n_vectors; ++v)
+      {
+        for (unsigned int i=0; i<constrained_dofs.size(); ++i)
+          dst[v]->local_element(constrained_dofs[i]) += src[v]->local_element(constrained_dofs[i]);
+
+        // reset edge constrained values, multiply by unit matrix and add into
+        // destination
+        for (unsigned int i=0; i<n_edge; ++i)
+          {
+            const_cast<LinearAlgebra::distributed::Vector<Number>&>(*src[v]).local_element(edge_constrained_indices[i]) = edge_values[v*n_edge+i];
+            dst[v]->local_element(edge_constrained_indices[i]) = edge_values[v*n_edge+i];
+          }
+      }
+  }
 
-    // If not, assert that the local ranges are the same and reset to the
-    // current partitioner
-    Assert(src.get_partitioner()->local_size() ==
-           data->get_dof_info(0).vector_partitioner->local_size(),
-           ExcMessage("The vector passed to the vmult() function does not have "
-                      "the correct size for compatibility with MatrixFree."));
 
-    // copy the vector content to a temporary vector so that it does not get
-    // lost
-    VectorView<Number> view_src_in(src.local_size(), src.begin());
-    Vector<Number> copy_vec = view_src_in;
-    const_cast<LinearAlgebra::distributed::Vector<Number> &>(src).
-    reinit(data->get_dof_info(0).vector_partitioner);
-    VectorView<Number> view_src_out(src.local_size(), src.begin());
-    static_cast<Vector<Number>&>(view_src_out) = copy_vec;
+
+  template <int dim, typename Number>
+  void
+  Base<dim,Number>::adjust_ghost_range_if_necessary(const LinearAlgebra::distributed::Vector<Number> &src) const
+  {
+    internal::MatrixFreeOperators::adjust_ghost_range_if_necessary
+    (data->get_dof_info(0).vector_partitioner, src);
   }
 
 
@@ -904,10 +2151,8 @@ namespace MatrixFreeOperators
     else
       apply_add(dst,src);
 
-    const std::vector<unsigned int> &
-    constrained_dofs = data->get_constrained_dofs();
-    for (unsigned int i=0; i<constrained_dofs.size(); ++i)
-      dst.local_element(constrained_dofs[i]) += src.local_element(constrained_dofs[i]);
+    internal::MatrixFreeOperators::add_constrained_entries
+    (data->get_constrained_dofs(), dst, src);
 
     // reset edge constrained values, multiply by unit matrix and add into
     // destination
@@ -1047,6 +2292,40 @@ namespace MatrixFreeOperators
 
 
 
+  template <int dim, typename Number>
+  void
+  Base<dim,Number>::
+  multi_apply_add (const std::vector<LinearAlgebra::distributed::Vector<Number> *>       &dst,
+                   const std::vector<const LinearAlgebra::distributed::Vector<Number> *> &src) const
+  {
+    AssertDimension (dst.size(), src.size());
+    for (unsigned int v=0; v<src.size(); ++v)
+      apply_add(*dst[v], *src[v]);
+  }
+
+
+
+  template <int dim, typename Number>
+  void
+  Base<dim,Number>::
+  apply_add_with_loop_operations
+  (LinearAlgebra::distributed::Vector<Number>       &dst,
+   const LinearAlgebra::distributed::Vector<Number> &src,
+   const std_cxx11::function<void (const unsigned int,
+                                   const unsigned int)> &operation_before_loop,
+   const std_cxx11::function<void (const unsigned int,
+                                   const unsigned int)> &operation_after_loop) const
+  {
+    const unsigned int local_size = dst.local_size();
+    if (operation_before_loop && local_size > 0)
+      operation_before_loop(0, local_size);
+    apply_add(dst,src);
+    if (operation_after_loop && local_size > 0)
+      operation_after_loop(0, local_size);
+  }
+
+
+
   template <int dim, typename Number>
   void
   Base<dim,Number>::precondition_Jacobi(LinearAlgebra::distributed::Vector<Number> &dst,
@@ -1061,6 +2340,213 @@ namespace MatrixFreeOperators
 
 
 
+  //----------------- BlockBase operator ---------------------------
+  template <int dim, typename Number>
+  BlockBase<dim,Number>::BlockBase ()
+    :
+    Subscriptor()
+  {
+  }
+
+
+
+  template <int dim, typename Number>
+  BlockBase<dim,Number>::~BlockBase ()
+  {
+  }
+
+
+
+  template <int dim, typename Number>
+  void
+  BlockBase<dim,Number>::clear ()
+  {
+    data.reset();
+    selected_blocks.clear();
+  }
+
+
+
+  template <int dim, typename Number>
+  void
+  BlockBase<dim,Number>::
+  initialize (std_cxx11::shared_ptr<const MatrixFree<dim,Number> > data_,
+              const std::vector<unsigned int> &selected_blocks_)
+  {
+    data = data_;
+    selected_blocks = selected_blocks_;
+    if (selected_blocks.empty())
+      for (unsigned int i=0; i<data->n_components(); ++i)
+        selected_blocks.push_back(i);
+    for (unsigned int b=0; b<selected_blocks.size(); ++b)
+      AssertIndexRange (selected_blocks[b], data->n_components());
+  }
+
+
+
+  template <int dim, typename Number>
+  typename BlockBase<dim,Number>::size_type
+  BlockBase<dim,Number>::m () const
+  {
+    Assert(data.get() != NULL,
+           ExcNotInitialized());
+    size_type total_size = 0;
+    for (unsigned int b=0; b<selected_blocks.size(); ++b)
+      total_size += data->get_dof_info(selected_blocks[b]).vector_partitioner->size();
+    return total_size;
+  }
+
+
+
+  template <int dim, typename Number>
+  typename BlockBase<dim,Number>::size_type
+  BlockBase<dim,Number>::n () const
+  {
+    return m();
+  }
+
+
+
+  template <int dim, typename Number>
+  unsigned int
+  BlockBase<dim,Number>::n_blocks () const
+  {
+    return selected_blocks.size();
+  }
+
+
+
+  template <int dim, typename Number>
+  void
+  BlockBase<dim,Number>::
+  initialize_dof_vector (LinearAlgebra::distributed::BlockVector<Number> &vec) const
+  {
+    Assert(data.get() != NULL,
+           ExcNotInitialized());
+    vec.reinit(selected_blocks.size());
+    for (unsigned int b=0; b<selected_blocks.size(); ++b)
+      internal::MatrixFreeOperators::initialize_dof_vector
+      (*data, selected_blocks[b], vec.block(b));
+    vec.collect_sizes();
+  }
+
+
+
+  template <int dim, typename Number>
+  void
+  BlockBase<dim,Number>::vmult (LinearAlgebra::distributed::BlockVector<Number>       &dst,
+                                const LinearAlgebra::distributed::BlockVector<Number> &src) const
+  {
+    dst = Number(0.);
+    vmult_add (dst, src);
+  }
+
+
+
+  template <int dim, typename Number>
+  void
+  BlockBase<dim,Number>::Tvmult (LinearAlgebra::distributed::BlockVector<Number>       &dst,
+                                 const LinearAlgebra::distributed::BlockVector<Number> &src) const
+  {
+    dst = Number(0.);
+    Tvmult_add (dst, src);
+  }
+
+
+
+  template <int dim, typename Number>
+  void
+  BlockBase<dim,Number>::vmult_add (LinearAlgebra::distributed::BlockVector<Number>       &dst,
+                                    const LinearAlgebra::distributed::BlockVector<Number> &src) const
+  {
+    mult_add (dst, src, false);
+  }
+
+
+
+  template <int dim, typename Number>
+  void
+  BlockBase<dim,Number>::Tvmult_add (LinearAlgebra::distributed::BlockVector<Number>       &dst,
+                                     const LinearAlgebra::distributed::BlockVector<Number> &src) const
+  {
+    mult_add (dst, src, true);
+  }
+
+
+
+  template <int dim, typename Number>
+  void
+  BlockBase<dim,Number>::
+  adjust_ghost_range_if_necessary(const LinearAlgebra::distributed::BlockVector<Number> &src) const
+  {
+    AssertDimension (src.n_blocks(), selected_blocks.size());
+    for (unsigned int b=0; b<src.n_blocks(); ++b)
+      internal::MatrixFreeOperators::adjust_ghost_range_if_necessary
+      (data->get_dof_info(selected_blocks[b]).vector_partitioner, src.block(b));
+  }
+
+
+
+  template <int dim, typename Number>
+  void
+  BlockBase<dim,Number>::mult_add (LinearAlgebra::distributed::BlockVector<Number> &dst,
+                                   const LinearAlgebra::distributed::BlockVector<Number> &src,
+                                   const bool transpose) const
+  {
+    adjust_ghost_range_if_necessary(src);
+    adjust_ghost_range_if_necessary(dst);
+
+    if (transpose)
+      Tapply_add(dst,src);
+    else
+      apply_add(dst,src);
+
+    // the operator acts as identity on the constrained degrees of freedom
+    // of each block
+    for (unsigned int b=0; b<selected_blocks.size(); ++b)
+      internal::MatrixFreeOperators::add_constrained_entries
+      (data->get_constrained_dofs(selected_blocks[b]), dst.block(b), src.block(b));
+  }
+
+
+
+  template <int dim, typename Number>
+  std::size_t
+  BlockBase<dim,Number>::memory_consumption () const
+  {
+    return sizeof(*this) + MemoryConsumption::memory_consumption(selected_blocks);
+  }
+
+
+
+  template <int dim, typename Number>
+  std_cxx11::shared_ptr<const MatrixFree<dim,Number> >
+  BlockBase<dim,Number>::get_matrix_free() const
+  {
+    return data;
+  }
+
+
+
+  template <int dim, typename Number>
+  const std::vector<unsigned int> &
+  BlockBase<dim,Number>::get_selected_blocks() const
+  {
+    return selected_blocks;
+  }
+
+
+
+  template <int dim, typename Number>
+  void
+  BlockBase<dim,Number>::Tapply_add(LinearAlgebra::distributed::BlockVector<Number> &dst,
+                                    const LinearAlgebra::distributed::BlockVector<Number> &src) const
+  {
+    apply_add(dst,src);
+  }
+
+
+
   //------------------------- MGInterfaceOperator ------------------------------
 
   template <typename OperatorType>
@@ -1186,6 +2672,38 @@ namespace MatrixFreeOperators
 
 
 
+  template <int dim, int fe_degree, int n_q_points_1d, int n_components, typename Number>
+  void
+  MassOperator<dim, fe_degree, n_q_points_1d, n_components, Number>::
+  multi_apply_add (const std::vector<LinearAlgebra::distributed::Vector<Number> *>       &dst,
+                   const std::vector<const LinearAlgebra::distributed::Vector<Number> *> &src) const
+  {
+    std::vector<LinearAlgebra::distributed::Vector<Number> *> dst_vectors (dst);
+    Base<dim, Number>::data->cell_loop (&MassOperator::local_multi_apply_cell,
+                                        this, dst_vectors, src);
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, int n_components, typename Number>
+  void
+  MassOperator<dim, fe_degree, n_q_points_1d, n_components, Number>::
+  apply_add_with_loop_operations
+  (LinearAlgebra::distributed::Vector<Number>       &dst,
+   const LinearAlgebra::distributed::Vector<Number> &src,
+   const std_cxx11::function<void (const unsigned int,
+                                   const unsigned int)> &operation_before_loop,
+   const std_cxx11::function<void (const unsigned int,
+                                   const unsigned int)> &operation_after_loop) const
+  {
+    Base<dim, Number>::data->cell_loop (&MassOperator::local_apply_cell,
+                                        this, dst, src,
+                                        operation_before_loop,
+                                        operation_after_loop);
+  }
+
+
+
   template <int dim, int fe_degree, int n_q_points_1d, int n_components, typename Number>
   void
   MassOperator<dim, fe_degree, n_q_points_1d, n_components, Number>::
@@ -1208,6 +2726,32 @@ namespace MatrixFreeOperators
   }
 
 
+
+  template <int dim, int fe_degree, int n_q_points_1d, int n_components, typename Number>
+  void
+  MassOperator<dim, fe_degree, n_q_points_1d, n_components, Number>::
+  local_multi_apply_cell (const MatrixFree<dim,Number>                                         &data,
+                          std::vector<LinearAlgebra::distributed::Vector<Number> *>             &dst,
+                          const std::vector<const LinearAlgebra::distributed::Vector<Number> *> &src,
+                          const std::pair<unsigned int,unsigned int>                            &cell_range) const
+  {
+    FEEvaluation<dim, fe_degree, n_q_points_1d, n_components, Number> phi(data);
+    for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+      {
+        phi.reinit (cell);
+        for (unsigned int v=0; v<src.size(); ++v)
+          {
+            phi.read_dof_values(*src[v]);
+            phi.evaluate (true,false,false);
+            for (unsigned int q=0; q<phi.n_q_points; ++q)
+              phi.submit_value (phi.get_value(q), q);
+            phi.integrate (true,false);
+            phi.distribute_local_to_global (*dst[v]);
+          }
+      }
+  }
+
+
   //-----------------------------LaplaceOperator----------------------------------
 
   template <int dim, int fe_degree, int n_q_points_1d, int n_components, typename Number>
@@ -1291,6 +2835,38 @@ namespace MatrixFreeOperators
                                         this, dst, src);
   }
 
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, int n_components, typename Number>
+  void
+  LaplaceOperator<dim, fe_degree, n_q_points_1d, n_components, Number>::
+  multi_apply_add (const std::vector<LinearAlgebra::distributed::Vector<Number> *>       &dst,
+                   const std::vector<const LinearAlgebra::distributed::Vector<Number> *> &src) const
+  {
+    std::vector<LinearAlgebra::distributed::Vector<Number> *> dst_vectors (dst);
+    Base<dim, Number>::data->cell_loop (&LaplaceOperator::local_multi_apply_cell,
+                                        this, dst_vectors, src);
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, int n_components, typename Number>
+  void
+  LaplaceOperator<dim, fe_degree, n_q_points_1d, n_components, Number>::
+  apply_add_with_loop_operations
+  (LinearAlgebra::distributed::Vector<Number>       &dst,
+   const LinearAlgebra::distributed::Vector<Number> &src,
+   const std_cxx11::function<void (const unsigned int,
+                                   const unsigned int)> &operation_before_loop,
+   const std_cxx11::function<void (const unsigned int,
+                                   const unsigned int)> &operation_after_loop) const
+  {
+    Base<dim, Number>::data->cell_loop (&LaplaceOperator::local_apply_cell,
+                                        this, dst, src,
+                                        operation_before_loop,
+                                        operation_after_loop);
+  }
+
   namespace
   {
     template<typename Number>
@@ -1355,6 +2931,29 @@ namespace MatrixFreeOperators
   }
 
 
+
+  template <int dim, int fe_degree, int n_q_points_1d, int n_components, typename Number>
+  void
+  LaplaceOperator<dim, fe_degree, n_q_points_1d, n_components, Number>::
+  local_multi_apply_cell (const MatrixFree<dim,Number>                                         &data,
+                          std::vector<LinearAlgebra::distributed::Vector<Number> *>             &dst,
+                          const std::vector<const LinearAlgebra::distributed::Vector<Number> *> &src,
+                          const std::pair<unsigned int,unsigned int>                            &cell_range) const
+  {
+    FEEvaluation<dim,fe_degree,n_q_points_1d,n_components,Number> phi (data);
+    for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+      {
+        phi.reinit (cell);
+        for (unsigned int v=0; v<src.size(); ++v)
+          {
+            phi.read_dof_values(*src[v]);
+            do_operation_on_cell(phi,cell);
+            phi.distribute_local_to_global (*dst[v]);
+          }
+      }
+  }
+
+
   template <int dim, int fe_degree, int n_q_points_1d, int n_components, typename Number>
   void
   LaplaceOperator<dim, fe_degree, n_q_points_1d, n_components, Number>::
@@ -144,6 +144,22 @@ namespace internal
        */
       AlignedVector<VectorizedArray<Number> > shape_hes_evenodd;
 
+      /**
+       * Stores the derivatives of the one-dimensional Lagrange polynomials
+       * with nodes in the quadrature points, evaluated in the quadrature
+       * points, in the even-odd format of shape_gra_evenodd. This is the
+       * collocation derivative matrix that computes the gradients at the
+       * quadrature points from the values at the quadrature points. It is
+       * only filled for symmetric elements with as many quadrature points as
+       * there are degrees of freedom per direction, i.e., <tt>n_q_points_1d
+       * == fe_degree+1</tt>, and empty otherwise. FEEvaluation uses it to
+       * evaluate gradients by first interpolating to the quadrature points
+       * and then applying one derivative per direction, which saves
+       * operations compared to the evaluation of the gradients directly from
+       * the degrees of freedom.
+       */
+      AlignedVector<VectorizedArray<Number> > shape_gra_collocation_evenodd;
+
       /**
        * Stores the indices from cell DoFs to face DoFs. The rows go through
        * the <tt>2*dim</tt> faces, and the columns the DoFs on the faces.
@@ -168,6 +184,23 @@ namespace internal
        */
       std::vector<Number>    subface_value[2];
 
+      /**
+       * Stores the shape values of the 1D finite element in vectorized
+       * format, evaluated on the 1D quadrature points mapped to the lower
+       * half (index 0) and the upper half (index 1) of the unit interval.
+       * Used by FEFaceEvaluation on the coarser side of faces with hanging
+       * nodes. The layout is the same as for @p shape_values.
+       */
+      AlignedVector<VectorizedArray<Number> > values_within_subface[2];
+
+      /**
+       * Stores the shape gradients of the 1D finite element in vectorized
+       * format on the same points as @p values_within_subface. The
+       * derivatives are taken with respect to the coordinate of the full
+       * unit interval.
+       */
+      AlignedVector<VectorizedArray<Number> > gradients_within_subface[2];
+
       /**
        * Non-vectorized version of shape values. Needed when evaluating face
        * info.
@@ -200,6 +233,11 @@ namespace internal
        */
       unsigned int n_q_points;
 
+      /**
+       * Stores the number of quadrature points in one dimension.
+       */
+      unsigned int n_q_points_1d;
+
       /**
        * Stores the number of DoFs per cell in @p dim dimensions.
        */
@@ -223,10 +261,23 @@ namespace internal
 
       /**
        * Check whether symmetric 1D basis functions are such that the shape
-       * values form a diagonal matrix, which allows to use specialized
-       * algorithms that save some operations.
+       * values form a diagonal matrix, i.e., the nodes of the basis
+       * functions coincide with the quadrature points (collocation), which
+       * allows to use specialized algorithms that save some operations. This
+       * is the case for Lagrange polynomials in the Gauss-Lobatto points
+       * combined with a Gauss-Lobatto quadrature, but also for other
+       * combinations of nodal points and quadrature formulas like Lagrange
+       * polynomials in the Gauss points together with a Gauss quadrature.
        */
       bool check_1d_shapes_gausslobatto();
+
+      /**
+       * Fill the field shape_gra_collocation_evenodd with the derivatives of
+       * the Lagrange polynomials in the points of the given quadrature
+       * formula in case the number of quadrature points equals the number of
+       * 1D degrees of freedom and the points are symmetric.
+       */
+      void compute_1d_collocation_gradients(const Quadrature<1> &quad);
     };
 
 
@@ -24,6 +24,7 @@
 #include <deal.II/base/polynomials_piecewise.h>
 #include <deal.II/fe/fe_poly.h>
 #include <deal.II/fe/fe_dgp.h>
+#include <deal.II/fe/fe_dgp_monomial.h>
 #include <deal.II/fe/fe_q_dg0.h>
 
 #include <deal.II/matrix_free/shape_info.h>
@@ -45,6 +46,7 @@ namespace internal
       element_type (tensor_general),
       fe_degree (numbers::invalid_unsigned_int),
       n_q_points (0),
+      n_q_points_1d (0),
       dofs_per_cell (0),
       n_q_points_face (0),
       dofs_per_face (0)
@@ -88,6 +90,9 @@ namespace internal
 
         const FE_DGP<dim> *fe_dgp = dynamic_cast<const FE_DGP<dim>*>(fe);
 
+        const FE_DGPMonomial<dim> *fe_dgp_monomial =
+          dynamic_cast<const FE_DGPMonomial<dim>*>(fe);
+
         const FE_Q_DG0<dim> *fe_q_dg0 = dynamic_cast<const FE_Q_DG0<dim>*>(fe);
 
         element_type = tensor_general;
@@ -102,6 +107,32 @@ namespace internal
               scalar_lexicographic[i] = i;
             element_type = truncated_tensor;
           }
+        else if (fe_dgp_monomial != 0)
+          {
+            // the monomials x^i y^j z^k with i+j+k <= degree are a truncated
+            // tensor product of the 1D monomials like the Legendre
+            // polynomials of FE_DGP, but the element sorts them by their
+            // total degree. Translate the exponents of each shape function
+            // into the position in the truncated lexicographic order used by
+            // the evaluation kernels, with the x direction running fastest
+            const PolynomialsP<dim> poly_space (fe_degree);
+            AssertDimension (poly_space.n(), fe_dgp_monomial->dofs_per_cell);
+            scalar_lexicographic.resize(fe_dgp_monomial->dofs_per_cell);
+            for (unsigned int i=0; i<fe_dgp_monomial->dofs_per_cell; ++i)
+              {
+                unsigned int degrees[dim];
+                poly_space.directional_degrees (i, degrees);
+                unsigned int index = 0;
+                for (int d=dim-1; d>0; --d)
+                  for (unsigned int j=0; j<degrees[d]; ++j)
+                    index += (d == 2 ?
+                              (n_dofs_1d-j)*(n_dofs_1d-j+1)/2 :
+                              n_dofs_1d-j-(dim>2 ? degrees[2] : 0));
+                index += degrees[0];
+                scalar_lexicographic[index] = i;
+              }
+            element_type = truncated_tensor;
+          }
         else if (fe_q_dg0 != 0)
           {
             scalar_lexicographic = fe_q_dg0->get_poly_space_numbering_inverse();
@@ -154,6 +185,7 @@ namespace internal
       }
 
       n_q_points      = Utilities::fixed_power<dim>(n_q_points_1d);
+      this->n_q_points_1d = n_q_points_1d;
       dofs_per_cell   = fe->dofs_per_cell;
       n_q_points_face = dim>1?Utilities::fixed_power<dim-1>(n_q_points_1d):1;
       dofs_per_face   = fe->dofs_per_face;
@@ -169,6 +201,11 @@ namespace internal
       this->face_value[1].resize(n_dofs_1d);
       this->face_gradient[1].resize(n_dofs_1d);
       this->subface_value[1].resize(array_size);
+      for (unsigned int i=0; i<2; ++i)
+        {
+          this->values_within_subface[i].resize_fast (array_size);
+          this->gradients_within_subface[i].resize_fast (array_size);
+        }
       this->shape_values_number.resize (array_size);
       this->shape_gradient_number.resize (array_size);
 
@@ -195,8 +232,16 @@ namespace internal
                 fe->shape_grad_grad(my_i,q_point)[0][0];
               q_point[0] *= 0.5;
               subface_value[0][i*n_q_points_1d+q] = fe->shape_value(my_i,q_point);
+              values_within_subface[0][i*n_q_points_1d+q] =
+                subface_value[0][i*n_q_points_1d+q];
+              gradients_within_subface[0][i*n_q_points_1d+q] =
+                fe->shape_grad(my_i,q_point)[0];
               q_point[0] += 0.5;
               subface_value[1][i*n_q_points_1d+q] = fe->shape_value(my_i,q_point);
+              values_within_subface[1][i*n_q_points_1d+q] =
+                subface_value[1][i*n_q_points_1d+q];
+              gradients_within_subface[1][i*n_q_points_1d+q] =
+                fe->shape_grad(my_i,q_point)[0];
             }
           Point<dim> q_point;
           this->face_value[0][i] = fe->shape_value(my_i,q_point);
@@ -217,6 +262,14 @@ namespace internal
       else if (element_type == tensor_symmetric_plus_dg0)
         check_1d_shapes_symmetric(n_q_points_1d);
 
+      if (element_type == tensor_symmetric ||
+          element_type == tensor_symmetric_plus_dg0)
+        compute_1d_collocation_gradients(quad);
+      else if (element_type == tensor_gausslobatto)
+        shape_gra_collocation_evenodd = shape_gra_evenodd;
+      else
+        shape_gra_collocation_evenodd.clear();
+
       // face information
       unsigned int n_faces = GeometryInfo<dim>::faces_per_cell;
       this->face_indices.reinit(n_faces, this->dofs_per_face);
@@ -367,9 +420,10 @@ namespace internal
 
       const double zero_tol =
         types_are_equal<Number,double>::value==true?1e-10:1e-7;
-      // check: - identity operation for shape values
-      //        - zero diagonal at interior points for gradients
-      //        - gradient equal to unity at element boundary
+      // check identity operation for shape values. The gradients need not be
+      // checked because the collocation evaluation takes them from
+      // shape_gra_evenodd, which holds the derivatives of the nodal basis in
+      // the quadrature points for any set of symmetric points
       const unsigned int n_points_1d = fe_degree+1;
       for (unsigned int i=0; i<n_points_1d; ++i)
         for (unsigned int j=0; j<n_points_1d; ++j)
@@ -384,18 +438,62 @@ namespace internal
                                          j][0]-1.)>zero_tol)
                 return false;
             }
-      for (unsigned int i=1; i<n_points_1d-1; ++i)
-        if (std::fabs(shape_gradients[i*n_points_1d+i][0])>zero_tol)
-          return false;
-      if (std::fabs(shape_gradients[n_points_1d-1][0]-
-                    (n_points_1d%2==0 ? -1. : 1.)) > zero_tol)
-        return false;
 
       return true;
     }
 
 
 
+    template <typename Number>
+    void
+    ShapeInfo<Number>::compute_1d_collocation_gradients(const Quadrature<1> &quad)
+    {
+      shape_gra_collocation_evenodd.clear();
+
+      const unsigned int n_points_1d = quad.size();
+      if (n_points_1d != fe_degree+1 || n_points_1d < 2)
+        return;
+
+      // the even-odd decomposition needs points that are symmetric around
+      // the center of the unit interval
+      for (unsigned int q=0; q<n_points_1d/2; ++q)
+        if (std::fabs(quad.point(q)[0] + quad.point(n_points_1d-1-q)[0] - 1.)
+            > 1e-12)
+          return;
+
+      // derivatives of the Lagrange polynomials in the quadrature points,
+      // evaluated in the quadrature points
+      const std::vector<Polynomials::Polynomial<double> > lagrange =
+        Polynomials::generate_complete_Lagrange_basis(quad.get_points());
+      std::vector<double> derivatives(n_points_1d*n_points_1d);
+      std::vector<double> values(2);
+      for (unsigned int i=0; i<n_points_1d; ++i)
+        for (unsigned int q=0; q<n_points_1d; ++q)
+          {
+            lagrange[i].value(quad.point(q)[0], values);
+            derivatives[i*n_points_1d+q] = values[1];
+          }
+
+      const unsigned int stride = (n_points_1d+1)/2;
+      shape_gra_collocation_evenodd.resize(n_points_1d*stride);
+      for (unsigned int i=0; i<n_points_1d/2; ++i)
+        for (unsigned int q=0; q<stride; ++q)
+          {
+            shape_gra_collocation_evenodd[i*stride+q] =
+              Number(0.5 * (derivatives[i*n_points_1d+q] +
+                            derivatives[i*n_points_1d+n_points_1d-1-q]));
+            shape_gra_collocation_evenodd[(n_points_1d-1-i)*stride+q] =
+              Number(0.5 * (derivatives[i*n_points_1d+q] -
+                            derivatives[i*n_points_1d+n_points_1d-1-q]));
+          }
+      if (n_points_1d % 2 == 1)
+        for (unsigned int q=0; q<stride; ++q)
+          shape_gra_collocation_evenodd[(n_points_1d/2)*stride+q] =
+            Number(derivatives[(n_points_1d/2)*n_points_1d+q]);
+    }
+
+
+
     template <typename Number>
     std::size_t
     ShapeInfo<Number>::memory_consumption () const
@@ -407,11 +505,14 @@ namespace internal
       memory += MemoryConsumption::memory_consumption(shape_val_evenodd);
       memory += MemoryConsumption::memory_consumption(shape_gra_evenodd);
       memory += MemoryConsumption::memory_consumption(shape_hes_evenodd);
+      memory += MemoryConsumption::memory_consumption(shape_gra_collocation_evenodd);
       memory += face_indices.memory_consumption();
       for (unsigned int i=0; i<2; ++i)
         {
           memory += MemoryConsumption::memory_consumption(face_value[i]);
           memory += MemoryConsumption::memory_consumption(face_gradient[i]);
+          memory += MemoryConsumption::memory_consumption(values_within_subface[i]);
+          memory += MemoryConsumption::memory_consumption(gradients_within_subface[i]);
         }
       memory += MemoryConsumption::memory_consumption(shape_values_number);
       memory += MemoryConsumption::memory_consumption(shape_gradient_number);
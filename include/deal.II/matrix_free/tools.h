@@ -0,0 +1,342 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+#ifndef dealii__matrix_free_tools_h
+#define dealii__matrix_free_tools_h
+
+
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/std_cxx11/function.h>
+#include <deal.II/base/vectorization.h>
+#include <deal.II/lac/constraint_matrix.h>
+#include <deal.II/lac/full_matrix.h>
+#include <deal.II/lac/la_parallel_vector.h>
+#include <deal.II/matrix_free/matrix_free.h>
+#include <deal.II/matrix_free/fe_evaluation.h>
+
+#include <algorithm>
+#include <vector>
+
+
+DEAL_II_NAMESPACE_OPEN
+
+
+/**
+ * A namespace with utility functions that derive other representations of
+ * an operator from its matrix-free cell kernel.
+ *
+ * The cell kernel is passed as a function object that takes an FEEvaluation
+ * object as its only argument. When the function object is called, the
+ * FEEvaluation object has been initialized for the current macro cell and
+ * its degrees of freedom values (FEEvaluation::begin_dof_values()) have been
+ * filled. The function object must apply the local operator, i.e., call
+ * FEEvaluation::evaluate(), do the work at the quadrature points, and call
+ * FEEvaluation::integrate(), leaving the result in the degrees of freedom
+ * values. It must neither read from nor write to global vectors. A typical
+ * kernel for the Laplacian looks as follows:
+ * @code
+ * template <int dim, int fe_degree>
+ * void local_laplace (FEEvaluation<dim,fe_degree> &phi)
+ * {
+ *   phi.evaluate (false, true);
+ *   for (unsigned int q=0; q<phi.n_q_points; ++q)
+ *     phi.submit_gradient (phi.get_gradient(q), q);
+ *   phi.integrate (false, true);
+ * }
+ * @endcode
+ *
+ * The functions below apply the kernel to all unit vectors of the local
+ * degrees of freedom of a cell. The unit vectors are processed for all
+ * cells in a macro cell at once, making use of the vectorization in the same
+ * way as the matrix-vector product. The resulting cell matrices are then
+ * combined with the constraints stored in a ConstraintMatrix object,
+ * including hanging node constraints, in the same way as for matrices
+ * assembled with FEValues. Thus, the work is proportional to the number of
+ * degrees of freedom per cell times the cost of the matrix-vector product.
+ *
+ * Since the template arguments of FEEvaluation cannot be deduced from a
+ * function object, they need to be specified explicitly when calling the
+ * functions, e.g.
+ * @code
+ * MatrixFreeTools::compute_diagonal<dim,fe_degree,fe_degree+1,1,double>
+ *   (matrix_free, constraints, diagonal, &local_laplace<dim,fe_degree>);
+ * @endcode
+ *
+ * The functions work on MatrixFree objects set up for an active mesh as
+ * well as on a level of a multigrid hierarchy. They loop over the cells
+ * without threads because the assembly into the result is not thread-safe.
+ */
+namespace MatrixFreeTools
+{
+  /**
+   * Compute the diagonal of the operator defined by the cell kernel @p
+   * local_vmult and store it in @p diagonal.
+   *
+   * The diagonal is the one of the operator with the constraints from @p
+   * constraints applied, i.e., entries of degrees of freedom that receive
+   * contributions from constrained degrees of freedom through hanging node
+   * constraints contain the exact diagonal of the condensed matrix. The
+   * constraints must be the same as the ones used for setting up @p
+   * matrix_free (with the constraints for the locally relevant degrees of
+   * freedom in parallel). For the constrained degrees of freedom, the value
+   * one is set, in agreement with the convention of
+   * MatrixFreeOperators::Base::vmult().
+   *
+   * The vector @p diagonal is initialized with
+   * MatrixFree::initialize_dof_vector() for the given @p dof_no. On return,
+   * its ghost values are not set.
+   */
+  template <int dim, int fe_degree, int n_q_points_1d, int n_components, typename Number>
+  void
+  compute_diagonal
+  (const MatrixFree<dim,Number>                          &matrix_free,
+   const ConstraintMatrix                                &constraints,
+   LinearAlgebra::distributed::Vector<Number>            &diagonal,
+   const std_cxx11::function<void (FEEvaluation<dim,fe_degree,n_q_points_1d,n_components,Number> &)> &local_vmult,
+   const unsigned int                                     dof_no = 0,
+   const unsigned int                                     quad_no = 0);
+
+  /**
+   * Compute the matrix of the operator defined by the cell kernel @p
+   * local_vmult and add it into @p matrix, using
+   * ConstraintMatrix::distribute_local_to_global() with the constraints in
+   * @p constraints to resolve the constrained degrees of freedom. The matrix
+   * must have been initialized with a sparsity pattern that can hold the
+   * entries, e.g., as created by DoFTools::make_sparsity_pattern() with the
+   * same constraints (or the variant for levels in multigrid), and it is
+   * not zeroed by this function. This function calls
+   * <code>matrix.compress(VectorOperation::add)</code> at the end and can
+   * thus be used with SparseMatrix as well as with
+   * TrilinosWrappers::SparseMatrix.
+   *
+   * For matrices on a level of a multigrid hierarchy, the indices of the
+   * level are used.
+   */
+  template <int dim, int fe_degree, int n_q_points_1d, int n_components, typename Number, typename MatrixType>
+  void
+  compute_matrix
+  (const MatrixFree<dim,Number>                          &matrix_free,
+   const ConstraintMatrix                                &constraints,
+   MatrixType                                            &matrix,
+   const std_cxx11::function<void (FEEvaluation<dim,fe_degree,n_q_points_1d,n_components,Number> &)> &local_vmult,
+   const unsigned int                                     dof_no = 0,
+   const unsigned int                                     quad_no = 0);
+
+} // end of namespace MatrixFreeTools
+
+
+
+/* ------------------------- inline functions --------------------------- */
+
+#ifndef DOXYGEN
+
+namespace internal
+{
+  namespace MatrixFreeTools
+  {
+    // compute the cell matrices of all cells in the current macro cell by
+    // applying the kernel to the unit vectors, storing the entries row-wise
+    // in cell_matrix
+    template <int dim, int fe_degree, int n_q_points_1d, int n_components, typename Number>
+    void
+    compute_cell_matrix
+    (FEEvaluation<dim,fe_degree,n_q_points_1d,n_components,Number> &phi,
+     const std_cxx11::function<void (FEEvaluation<dim,fe_degree,n_q_points_1d,n_components,Number> &)> &local_vmult,
+     std::vector<VectorizedArray<Number> >                         &cell_matrix)
+    {
+      const unsigned int dofs_per_cell = phi.dofs_per_cell;
+      cell_matrix.resize(dofs_per_cell * dofs_per_cell);
+      for (unsigned int j=0; j<dofs_per_cell; ++j)
+        {
+          for (unsigned int i=0; i<dofs_per_cell; ++i)
+            phi.begin_dof_values()[i] = VectorizedArray<Number>();
+          phi.begin_dof_values()[j] = make_vectorized_array<Number>(1.);
+
+          local_vmult(phi);
+
+          for (unsigned int i=0; i<dofs_per_cell; ++i)
+            cell_matrix[i*dofs_per_cell+j] = phi.begin_dof_values()[i];
+        }
+    }
+
+
+
+    // get the global indices of the degrees of freedom of the given cell in
+    // the order used by FEEvaluation
+    template <int dim, typename Number>
+    void
+    get_dof_indices (const ::dealii::MatrixFree<dim,Number>                      &matrix_free,
+                     const unsigned int                                           macro_cell,
+                     const unsigned int                                           lane,
+                     const unsigned int                                           dof_no,
+                     const internal::MatrixFreeFunctions::ShapeInfo<Number>       &shape_info,
+                     std::vector<types::global_dof_index>                         &cell_dof_indices,
+                     std::vector<types::global_dof_index>                         &dof_indices)
+    {
+      const typename DoFHandler<dim>::cell_iterator cell =
+        matrix_free.get_cell_iterator(macro_cell, lane, dof_no);
+      cell_dof_indices.resize(cell->get_fe().dofs_per_cell);
+      if (matrix_free.get_level_mg_handler() != numbers::invalid_unsigned_int)
+        cell->get_mg_dof_indices(cell_dof_indices);
+      else
+        cell->get_dof_indices(cell_dof_indices);
+
+      const std::vector<unsigned int> &lexicographic =
+        shape_info.lexicographic_numbering;
+      dof_indices.resize(lexicographic.size());
+      for (unsigned int i=0; i<lexicographic.size(); ++i)
+        dof_indices[i] = cell_dof_indices[lexicographic[i]];
+    }
+  }
+}
+
+
+
+namespace MatrixFreeTools
+{
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, int n_components, typename Number>
+  void
+  compute_diagonal
+  (const MatrixFree<dim,Number>                          &matrix_free,
+   const ConstraintMatrix                                &constraints,
+   LinearAlgebra::distributed::Vector<Number>            &diagonal,
+   const std_cxx11::function<void (FEEvaluation<dim,fe_degree,n_q_points_1d,n_components,Number> &)> &local_vmult,
+   const unsigned int                                     dof_no,
+   const unsigned int                                     quad_no)
+  {
+    matrix_free.initialize_dof_vector(diagonal, dof_no);
+
+    FEEvaluation<dim,fe_degree,n_q_points_1d,n_components,Number>
+    phi (matrix_free, dof_no, quad_no);
+    const unsigned int dofs_per_cell = phi.dofs_per_cell;
+    const internal::MatrixFreeFunctions::ShapeInfo<Number> &shape_info =
+      matrix_free.get_shape_info(dof_no, quad_no);
+    AssertDimension(shape_info.lexicographic_numbering.size(), dofs_per_cell);
+
+    std::vector<VectorizedArray<Number> > cell_matrix;
+    std::vector<types::global_dof_index> cell_dof_indices, dof_indices;
+
+    // list of the global indices the local degrees of freedom contribute to
+    // after resolving the constraints, given as triplets of global index,
+    // local index and weight
+    std::vector<std::pair<types::global_dof_index,
+        std::pair<unsigned int,double> > > targets;
+
+    for (unsigned int cell=0; cell<matrix_free.n_macro_cells(); ++cell)
+      {
+        phi.reinit(cell);
+        internal::MatrixFreeTools::compute_cell_matrix(phi, local_vmult, cell_matrix);
+
+        for (unsigned int v=0; v<matrix_free.n_components_filled(cell); ++v)
+          {
+            internal::MatrixFreeTools::get_dof_indices(matrix_free, cell, v, dof_no, shape_info,
+                                      cell_dof_indices, dof_indices);
+
+            targets.clear();
+            for (unsigned int i=0; i<dofs_per_cell; ++i)
+              if (constraints.is_constrained(dof_indices[i]) == false)
+                targets.push_back(std::make_pair(dof_indices[i],
+                                                 std::make_pair(i, 1.)));
+              else
+                {
+                  const std::vector<std::pair<types::global_dof_index,double> > *
+                  entries = constraints.get_constraint_entries(dof_indices[i]);
+                  for (unsigned int e=0; e<entries->size(); ++e)
+                    targets.push_back(std::make_pair((*entries)[e].first,
+                                                     std::make_pair(i, (*entries)[e].second)));
+                }
+            std::sort(targets.begin(), targets.end());
+
+            // the diagonal entry of a global index is the sum over all pairs
+            // of local degrees of freedom that contribute to it
+            for (unsigned int begin=0; begin<targets.size(); )
+              {
+                unsigned int end = begin+1;
+                while (end < targets.size() &&
+                       targets[end].first == targets[begin].first)
+                  ++end;
+                double sum = 0;
+                for (unsigned int a=begin; a<end; ++a)
+                  for (unsigned int b=begin; b<end; ++b)
+                    sum += targets[a].second.second * targets[b].second.second *
+                           cell_matrix[targets[a].second.first*dofs_per_cell+
+                                       targets[b].second.first][v];
+                diagonal(targets[begin].first) += sum;
+                begin = end;
+              }
+          }
+      }
+    diagonal.compress(VectorOperation::add);
+
+    const std::vector<unsigned int> &constrained_dofs =
+      matrix_free.get_constrained_dofs(dof_no);
+    for (unsigned int i=0; i<constrained_dofs.size(); ++i)
+      diagonal.local_element(constrained_dofs[i]) = 1.;
+  }
+
+
+
+  template <int dim, int fe_degree, int n_q_points_1d, int n_components, typename Number, typename MatrixType>
+  void
+  compute_matrix
+  (const MatrixFree<dim,Number>                          &matrix_free,
+   const ConstraintMatrix                                &constraints,
+   MatrixType                                            &matrix,
+   const std_cxx11::function<void (FEEvaluation<dim,fe_degree,n_q_points_1d,n_components,Number> &)> &local_vmult,
+   const unsigned int                                     dof_no,
+   const unsigned int                                     quad_no)
+  {
+    FEEvaluation<dim,fe_degree,n_q_points_1d,n_components,Number>
+    phi (matrix_free, dof_no, quad_no);
+    const unsigned int dofs_per_cell = phi.dofs_per_cell;
+    const internal::MatrixFreeFunctions::ShapeInfo<Number> &shape_info =
+      matrix_free.get_shape_info(dof_no, quad_no);
+    AssertDimension(shape_info.lexicographic_numbering.size(), dofs_per_cell);
+
+    std::vector<VectorizedArray<Number> > cell_matrix;
+    std::vector<types::global_dof_index> cell_dof_indices, dof_indices;
+    FullMatrix<typename MatrixType::value_type> local_matrix(dofs_per_cell,
+                                                             dofs_per_cell);
+
+    for (unsigned int cell=0; cell<matrix_free.n_macro_cells(); ++cell)
+      {
+        phi.reinit(cell);
+        internal::MatrixFreeTools::compute_cell_matrix(phi, local_vmult, cell_matrix);
+
+        for (unsigned int v=0; v<matrix_free.n_components_filled(cell); ++v)
+          {
+            internal::MatrixFreeTools::get_dof_indices(matrix_free, cell, v, dof_no, shape_info,
+                                      cell_dof_indices, dof_indices);
+            for (unsigned int i=0; i<dofs_per_cell; ++i)
+              for (unsigned int j=0; j<dofs_per_cell; ++j)
+                local_matrix(i,j) = cell_matrix[i*dofs_per_cell+j][v];
+            constraints.distribute_local_to_global(local_matrix, dof_indices,
+                                                   matrix);
+          }
+      }
+    matrix.compress(VectorOperation::add);
+  }
+
+} // end of namespace MatrixFreeTools
+
+#endif // DOXYGEN
+
+
+DEAL_II_NAMESPACE_CLOSE
+
+#endif
@@ -45,6 +45,29 @@ DEAL_II_NAMESPACE_OPEN
  * of one of these elements. Systems with different elements or other elements
  * are currently not implemented.
  *
+ * <h3>Mixed-precision multigrid</h3>
+ *
+ * The multigrid V-cycle with matrix-free level operators is usually limited
+ * by the memory bandwidth, so running it in single precision (@p Number =
+ * float) almost halves its cost. Since multigrid is used as a
+ * preconditioner, the lower accuracy of the level operations does not
+ * affect the final accuracy of the outer solver that works on vectors of
+ * type LinearAlgebra::distributed::Vector<double>. The conversion between
+ * the two precisions happens automatically at the boundary of the
+ * preconditioner: The functions copy_to_mg(), copy_from_mg() and
+ * copy_from_mg_add() of the base class accept global vectors with a
+ * different number type than the level vectors, and so does
+ * interpolate_to_mg() of this class. Thus, a typical setup combines a
+ * MatrixFree<dim,float> object for each level (held via a
+ * std_cxx11::shared_ptr by the level operators stored in an MGLevelObject),
+ * level smoothers such as PreconditionChebyshev working on
+ * LinearAlgebra::distributed::Vector<float>, an object of type
+ * MGTransferMatrixFree<dim,float>, and a
+ * <tt>PreconditionMG<dim, LinearAlgebra::distributed::Vector<float>,
+ * MGTransferMatrixFree<dim,float> ></tt> that is passed to a solver like
+ * SolverCG working on LinearAlgebra::distributed::Vector<double>. See the
+ * step-37 tutorial program for a complete example.
+ *
  * @author Martin Kronbichler
  * @date 2016
  */
@@ -124,6 +147,30 @@ public:
                                  LinearAlgebra::distributed::Vector<Number>       &dst,
                                  const LinearAlgebra::distributed::Vector<Number> &src) const;
 
+  /**
+   * Interpolate the fine-mesh field @p src to each multigrid level in @p
+   * dst. First, the values on the active cells of all levels are set by
+   * copy_to_mg(). Then, the values on cells that are refined are computed by
+   * interpolation from their children, using the restriction matrices of
+   * the finite element, going from the finest to the coarsest level. As
+   * opposed to restrict_and_add(), this operation maps a field (e.g. the
+   * current solution of a nonlinear problem) rather than a residual to the
+   * coarser levels, which is needed to set up level operators that depend on
+   * the solution.
+   *
+   * The number type of @p src can differ from the one of the level vectors,
+   * which allows to interpolate a solution computed in double precision to
+   * level vectors in single precision.
+   *
+   * The vector @p src must not contain values violating the hanging node
+   * constraints, i.e., ConstraintMatrix::distribute() must have been called
+   * on the vector.
+   */
+  template <typename Number2>
+  void interpolate_to_mg (const DoFHandler<dim>                                      &mg_dof,
+                          MGLevelObject<LinearAlgebra::distributed::Vector<Number> > &dst,
+                          const LinearAlgebra::distributed::Vector<Number2>          &src) const;
+
   /**
    * Finite element does not provide prolongation matrices.
    */
@@ -39,6 +39,8 @@
 
 #include <deal.II/multigrid/mg_tools.h>
 
+#include <deal.II/matrix_free/matrix_free.h>
+
 #include <deal.II/distributed/tria.h>
 
 #include <boost/config.hpp>
@@ -1947,6 +1949,145 @@ namespace DoFRenumbering
             ExcInternalError());
   }
 
+
+
+  template <int dim, typename Number>
+  void
+  matrix_free_data_locality (DoFHandler<dim>              &dof_handler,
+                             const MatrixFree<dim,Number> &matrix_free)
+  {
+    std::vector<types::global_dof_index>
+    renumbering (dof_handler.locally_owned_dofs().n_elements(),
+                 numbers::invalid_dof_index);
+    compute_matrix_free_data_locality (renumbering, dof_handler, matrix_free);
+
+    dof_handler.renumber_dofs (renumbering);
+  }
+
+
+
+  template <int dim, typename Number>
+  void
+  compute_matrix_free_data_locality (std::vector<types::global_dof_index> &new_dof_indices,
+                                     const DoFHandler<dim>                &dof_handler,
+                                     const MatrixFree<dim,Number>         &matrix_free)
+  {
+    Assert (matrix_free.get_level_mg_handler() == numbers::invalid_unsigned_int,
+            ExcMessage ("The renumbering is only implemented for MatrixFree "
+                        "objects on the active cells"));
+
+    // find the DoFHandler within the MatrixFree object
+    unsigned int dof_index = numbers::invalid_unsigned_int;
+    for (unsigned int i=0; i<matrix_free.n_components(); ++i)
+      if (&matrix_free.get_dof_handler(i) == &dof_handler)
+        {
+          dof_index = i;
+          break;
+        }
+    AssertThrow (dof_index != numbers::invalid_unsigned_int,
+                 ExcMessage ("The given DoFHandler is not used by the MatrixFree "
+                             "object"));
+
+    const IndexSet &locally_owned = dof_handler.locally_owned_dofs();
+    const types::global_dof_index n_owned_dofs = locally_owned.n_elements();
+    AssertDimension (new_dof_indices.size(), n_owned_dofs);
+
+    // mark the locally owned degrees of freedom that are also accessed by
+    // other processors: those on ghost cells (shared with the neighbor for
+    // continuous elements) and those on locally owned cells that have a
+    // ghost cell as face neighbor (read by the neighbor in face integrals)
+    std::vector<bool> dof_is_shared (n_owned_dofs, false);
+    std::vector<types::global_dof_index> dof_indices;
+    for (typename DoFHandler<dim>::active_cell_iterator
+         cell = dof_handler.begin_active(); cell != dof_handler.end(); ++cell)
+      {
+        bool cell_is_shared = cell->is_ghost();
+        if (cell->is_locally_owned())
+          for (unsigned int f=0; f<GeometryInfo<dim>::faces_per_cell; ++f)
+            if (cell->at_boundary(f) == false)
+              {
+                if (cell->neighbor(f)->has_children() == false)
+                  cell_is_shared |= cell->neighbor(f)->is_ghost();
+                else
+                  for (unsigned int sf=0; sf<cell->face(f)->n_children(); ++sf)
+                    cell_is_shared |=
+                      cell->neighbor_child_on_subface(f,sf)->is_ghost();
+              }
+        if (cell_is_shared == false)
+          continue;
+
+        dof_indices.resize (cell->get_fe().dofs_per_cell);
+        cell->get_dof_indices (dof_indices);
+        for (unsigned int i=0; i<dof_indices.size(); ++i)
+          if (locally_owned.is_element (dof_indices[i]))
+            dof_is_shared[locally_owned.index_within_set(dof_indices[i])] = true;
+      }
+
+    // go through the cell batches in the order of the MatrixFree loop and
+    // record the first access to each locally owned degree of freedom. For
+    // each index of the cell, go through all cells of the batch, which is
+    // the order of the vectorized access
+    std::vector<types::global_dof_index> touch_order;
+    touch_order.reserve (n_owned_dofs);
+    std::vector<bool> touched (n_owned_dofs, false);
+    std::vector<std::vector<types::global_dof_index> > batch_dof_indices;
+    for (unsigned int cell=0; cell<matrix_free.n_macro_cells(); ++cell)
+      {
+        const unsigned int n_filled = matrix_free.n_components_filled(cell);
+        batch_dof_indices.resize (n_filled);
+        unsigned int max_dofs_per_cell = 0;
+        for (unsigned int v=0; v<n_filled; ++v)
+          {
+            const typename DoFHandler<dim>::active_cell_iterator dof_cell =
+              matrix_free.get_cell_iterator (cell, v, dof_index);
+            batch_dof_indices[v].resize (dof_cell->get_fe().dofs_per_cell);
+            dof_cell->get_dof_indices (batch_dof_indices[v]);
+            max_dofs_per_cell = std::max (max_dofs_per_cell,
+                                          dof_cell->get_fe().dofs_per_cell);
+          }
+        for (unsigned int i=0; i<max_dofs_per_cell; ++i)
+          for (unsigned int v=0; v<n_filled; ++v)
+            if (i < batch_dof_indices[v].size() &&
+                locally_owned.is_element (batch_dof_indices[v][i]))
+              {
+                const types::global_dof_index index =
+                  locally_owned.index_within_set (batch_dof_indices[v][i]);
+                if (touched[index] == false)
+                  {
+                    touched[index] = true;
+                    touch_order.push_back (index);
+                  }
+              }
+      }
+
+    // degrees of freedom not accessed by the cell loop keep their relative
+    // order at the end
+    for (types::global_dof_index i=0; i<n_owned_dofs; ++i)
+      if (touched[i] == false)
+        touch_order.push_back (i);
+    AssertDimension (touch_order.size(), n_owned_dofs);
+
+    // assign the new numbers, inserting the shared degrees of freedom as one
+    // block at the position of the first access to one of them
+    types::global_dof_index next_free_index = 0;
+    bool shared_dofs_numbered = false;
+    for (types::global_dof_index i=0; i<n_owned_dofs; ++i)
+      {
+        const types::global_dof_index index = touch_order[i];
+        if (dof_is_shared[index] == false)
+          new_dof_indices[index] = locally_owned.nth_index_in_set(next_free_index++);
+        else if (shared_dofs_numbered == false)
+          {
+            for (types::global_dof_index j=i; j<n_owned_dofs; ++j)
+              if (dof_is_shared[touch_order[j]])
+                new_dof_indices[touch_order[j]] =
+                  locally_owned.nth_index_in_set(next_free_index++);
+            shared_dofs_numbered = true;
+          }
+      }
+    AssertDimension (next_free_index, n_owned_dofs);
+  }
+
 } // namespace DoFRenumbering
 
 
@@ -0,0 +1,225 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+#include <deal.II/lac/solver_gmres.h>
+
+#include <cmath>
+#include <limits>
+
+DEAL_II_NAMESPACE_OPEN
+
+namespace internal
+{
+  namespace SolverGMRES
+  {
+    void
+    compute_hessenberg_eigenvalues (const FullMatrix<double>            &H,
+                                    const unsigned int                   n,
+                                    std::vector<std::complex<double> > &eigenvalues)
+    {
+      typedef std::complex<double> Complex;
+
+      Assert (H.m() >= n && H.n() >= n, ExcIndexRange(n, 0, std::min(H.m(), H.n())+1));
+      eigenvalues.resize (n);
+      if (n == 0)
+        return;
+
+      // copy the upper Hessenberg part of the matrix, stored row-wise
+      std::vector<Complex> T (n*n, Complex());
+      for (unsigned int i=0; i<n; ++i)
+        for (unsigned int j=(i>0 ? i-1 : 0); j<n; ++j)
+          T[i*n+j] = H(i,j);
+
+      const double eps = std::numeric_limits<double>::epsilon();
+      std::vector<double> c (n);
+      std::vector<Complex> s (n);
+
+      // the active block is [lo,hi). in each step, either the last
+      // eigenvalue of the active block is split off or a QR step with the
+      // Wilkinson shift is done. the number of steps per eigenvalue is
+      // limited; if the iteration stagnates, the diagonal entries are taken
+      // as approximations, which is good enough for the purpose of shifts
+      unsigned int hi = n;
+      unsigned int iterations = 0;
+      while (hi > 0)
+        {
+          unsigned int lo = hi-1;
+          while (lo > 0 &&
+                 std::abs(T[lo*n+lo-1]) >
+                 eps * (std::abs(T[lo*n+lo]) + std::abs(T[(lo-1)*n+lo-1])))
+            --lo;
+          if (lo > 0)
+            T[lo*n+lo-1] = 0.;
+
+          if (lo == hi-1 || iterations == 30*n)
+            {
+              eigenvalues[hi-1] = T[(hi-1)*n+hi-1];
+              --hi;
+              iterations = 0;
+              continue;
+            }
+
+          // the eigenvalue of the trailing 2x2 block closer to its last
+          // diagonal entry, with an exceptional shift from time to time to
+          // break cycles
+          const Complex a = T[(hi-2)*n+hi-2], b = T[(hi-2)*n+hi-1],
+                        d = T[(hi-1)*n+hi-2], e = T[(hi-1)*n+hi-1];
+          Complex mu;
+          if (iterations % 10 == 9)
+            mu = e + 0.75 * std::abs(d);
+          else
+            {
+              const Complex mean = 0.5 * (a + e);
+              const Complex root = std::sqrt(0.25 * (a-e) * (a-e) + b * d);
+              mu = (std::abs(mean+root-e) < std::abs(mean-root-e) ?
+                    mean+root : mean-root);
+            }
+          ++iterations;
+
+          // QR factorization of the shifted active block by Givens rotations
+          // acting on rows k and k+1, followed by the multiplication of R
+          // by Q from the right
+          for (unsigned int k=lo; k<hi; ++k)
+            T[k*n+k] -= mu;
+          for (unsigned int k=lo; k<hi-1; ++k)
+            {
+              const Complex x = T[k*n+k], y = T[(k+1)*n+k];
+              const double r = std::sqrt(std::norm(x) + std::norm(y));
+              if (r == 0.)
+                {
+                  c[k] = 1.;
+                  s[k] = 0.;
+                  continue;
+                }
+              if (std::abs(x) == 0.)
+                {
+                  c[k] = 0.;
+                  s[k] = std::conj(y) / std::abs(y);
+                }
+              else
+                {
+                  c[k] = std::abs(x) / r;
+                  s[k] = x / std::abs(x) * std::conj(y) / r;
+                }
+              for (unsigned int j=k; j<hi; ++j)
+                {
+                  const Complex t1 = T[k*n+j], t2 = T[(k+1)*n+j];
+                  T[k*n+j]     = c[k] * t1 + s[k] * t2;
+                  T[(k+1)*n+j] = -std::conj(s[k]) * t1 + c[k] * t2;
+                }
+            }
+          for (unsigned int k=lo; k<hi-1; ++k)
+            for (unsigned int i=lo; i<std::min(k+2,hi); ++i)
+              {
+                const Complex t1 = T[i*n+k], t2 = T[i*n+k+1];
+                T[i*n+k]   = c[k] * t1 + std::conj(s[k]) * t2;
+                T[i*n+k+1] = -s[k] * t1 + c[k] * t2;
+              }
+          for (unsigned int k=lo; k<hi; ++k)
+            T[k*n+k] += mu;
+        }
+    }
+
+
+
+    void
+    compute_newton_shifts (const std::vector<std::complex<double> > &ritz_values,
+                           const unsigned int                        n_shifts,
+                           std::vector<double>                      &shift_real,
+                           std::vector<double>                      &shift_coupling)
+    {
+      shift_real.assign (n_shifts, 0.);
+      shift_coupling.assign (n_shifts, 0.);
+
+      double scale = 0.;
+      for (unsigned int i=0; i<ritz_values.size(); ++i)
+        scale = std::max (scale, std::abs(ritz_values[i]));
+      if (scale == 0.)
+        return;
+
+      // collect the candidates: real values and one representative with
+      // positive imaginary part of each complex conjugate pair. the Ritz
+      // values of a real matrix come out of the QR algorithm only
+      // approximately in pairs, so values with a tiny imaginary part are
+      // taken as real and values with negative imaginary part are dropped
+      std::vector<std::complex<double> > candidates;
+      for (unsigned int i=0; i<ritz_values.size(); ++i)
+        if (std::abs(ritz_values[i].imag()) <= 1e-10 * scale)
+          candidates.push_back (std::complex<double>(ritz_values[i].real(), 0.));
+        else if (ritz_values[i].imag() > 0)
+          candidates.push_back (ritz_values[i]);
+      if (candidates.size() == 0)
+        return;
+
+      // Leja ordering: start with the candidate of largest modulus and then
+      // take the candidate that maximizes the product of the distances to
+      // all shifts selected so far, including the conjugates of complex
+      // shifts. once all candidates are used, start over again
+      std::vector<bool> used (candidates.size(), false);
+      std::vector<std::complex<double> > selected;
+      unsigned int position = 0;
+      while (position < n_shifts)
+        {
+          if (selected.size() == candidates.size())
+            {
+              std::fill (used.begin(), used.end(), false);
+              selected.clear();
+            }
+
+          unsigned int best = numbers::invalid_unsigned_int;
+          double best_value = -std::numeric_limits<double>::max();
+          for (unsigned int c=0; c<candidates.size(); ++c)
+            if (used[c] == false)
+              {
+                double value = 0.;
+                if (selected.size() == 0)
+                  value = std::abs(candidates[c]);
+                else
+                  for (unsigned int i=0; i<selected.size(); ++i)
+                    {
+                      value += std::log (std::abs(candidates[c] - selected[i]) +
+                                         1e-300);
+                      if (selected[i].imag() != 0.)
+                        value += std::log (std::abs(candidates[c] -
+                                                    std::conj(selected[i])) +
+                                           1e-300);
+                    }
+                if (best == numbers::invalid_unsigned_int || value > best_value)
+                  {
+                    best = c;
+                    best_value = value;
+                  }
+              }
+          used[best] = true;
+          selected.push_back (candidates[best]);
+
+          // a complex conjugate pair takes two positions, unless there is
+          // only one position left, where only the real part is used
+          const std::complex<double> shift = candidates[best];
+          shift_real[position] = shift.real();
+          if (shift.imag() != 0. && position+1 < n_shifts)
+            {
+              shift_real[position+1] = shift.real();
+              shift_coupling[position+1] = shift.imag() * shift.imag();
+              position += 2;
+            }
+          else
+            ++position;
+        }
+    }
+  }
+}
+
+DEAL_II_NAMESPACE_CLOSE
@@ -0,0 +1,236 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+#include <deal.II/lac/sparse_level_schedule.h>
+#include <deal.II/lac/sparsity_pattern.h>
+#include <deal.II/base/memory_consumption.h>
+
+#include <algorithm>
+
+DEAL_II_NAMESPACE_OPEN
+
+
+namespace
+{
+  /**
+   * Sort the rows by the given level of each row by a counting sort, such
+   * that the rows within each level are in ascending order.
+   */
+  void
+  sort_rows_by_level (const std::vector<unsigned int>               &level,
+                      const unsigned int                               n_levels,
+                      std::vector<SparseLevelSchedule::size_type>      &rows,
+                      std::vector<std::size_t>                        &level_starts)
+  {
+    level_starts.clear();
+    level_starts.resize (n_levels+1, 0);
+    for (std::size_t row=0; row<level.size(); ++row)
+      ++level_starts[level[row]+1];
+    for (unsigned int l=0; l<n_levels; ++l)
+      level_starts[l+1] += level_starts[l];
+
+    std::vector<std::size_t> position (level_starts.begin(), level_starts.end()-1);
+    rows.resize (level.size());
+    for (std::size_t row=0; row<level.size(); ++row)
+      rows[position[level[row]]++] = row;
+  }
+}
+
+
+
+SparseLevelSchedule::SparseLevelSchedule ()
+  :
+  mode (level_scheduled),
+  n_nonzero (0)
+{}
+
+
+
+SparseLevelSchedule::SparseLevelSchedule (const SparsityPattern &sparsity,
+                                          const Mode             mode)
+  :
+  mode (mode),
+  n_nonzero (0)
+{
+  reinit (sparsity, mode);
+}
+
+
+
+void
+SparseLevelSchedule::reinit (const SparsityPattern &sparsity,
+                             const Mode             mode)
+{
+  Assert (sparsity.n_rows() == sparsity.n_cols(),
+          ExcDimensionMismatch (sparsity.n_rows(), sparsity.n_cols()));
+  Assert (sparsity.is_compressed(), SparsityPattern::ExcNotCompressed());
+
+  this->mode = mode;
+  n_nonzero = sparsity.n_nonzero_elements();
+
+  const size_type n = sparsity.n_rows();
+  row_data.resize (n);
+
+  std::vector<unsigned int> forward_level (n, 0), backward_level (n, 0);
+  unsigned int n_forward = n > 0 ? 1 : 0, n_backward = n_forward;
+
+  if (mode == level_scheduled)
+    {
+      // the level of a row is one more than the maximum level of the rows
+      // it depends on in the lower (forward sweep) or upper (backward sweep)
+      // triangle. the first entry in each row is the diagonal
+      for (size_type row=0; row<n; ++row)
+        {
+          const unsigned int row_length = sparsity.row_length(row);
+          Assert (row_length > 0 && sparsity.column_number(row,0) == row,
+                  ExcMessage ("The diagonal entry must be the first entry "
+                              "in each row."));
+          unsigned int k=1;
+          for ( ; k<row_length; ++k)
+            {
+              const size_type col = sparsity.column_number(row, k);
+              if (col > row)
+                break;
+              forward_level[row] = std::max (forward_level[row],
+                                             forward_level[col]+1);
+            }
+          row_data[row] = k;
+          n_forward = std::max (n_forward, forward_level[row]+1);
+        }
+
+      for (size_type row=n; row>0; )
+        {
+          --row;
+          const unsigned int row_length = sparsity.row_length(row);
+          for (unsigned int k=row_data[row]; k<row_length; ++k)
+            {
+              const size_type col = sparsity.column_number(row, k);
+              backward_level[row] = std::max (backward_level[row],
+                                              backward_level[col]+1);
+            }
+          n_backward = std::max (n_backward, backward_level[row]+1);
+        }
+    }
+  else
+    {
+      // collect the entries of the transpose pattern in order to color the
+      // symmetrized graph
+      std::vector<std::size_t> transpose_starts (n+1, 0);
+      for (size_type row=0; row<n; ++row)
+        for (unsigned int k=1; k<sparsity.row_length(row); ++k)
+          ++transpose_starts[sparsity.column_number(row, k)+1];
+      for (size_type row=0; row<n; ++row)
+        transpose_starts[row+1] += transpose_starts[row];
+      std::vector<size_type> transpose_rows (transpose_starts[n]);
+      {
+        std::vector<std::size_t> position (transpose_starts.begin(),
+                                           transpose_starts.end()-1);
+        for (size_type row=0; row<n; ++row)
+          for (unsigned int k=1; k<sparsity.row_length(row); ++k)
+            transpose_rows[position[sparsity.column_number(row, k)]++] = row;
+      }
+
+      // greedy coloring in the order of the rows: pick the smallest color
+      // not used by any neighbor that has already been colored
+      std::vector<size_type> color_used_by (1, numbers::invalid_size_type);
+      unsigned int n_colors = n > 0 ? 1 : 0;
+      for (size_type row=0; row<n; ++row)
+        {
+          for (unsigned int k=1; k<sparsity.row_length(row); ++k)
+            {
+              const size_type col = sparsity.column_number(row, k);
+              if (col < row)
+                color_used_by[row_data[col]] = row;
+            }
+          for (std::size_t k=transpose_starts[row]; k<transpose_starts[row+1]; ++k)
+            if (transpose_rows[k] < row)
+              color_used_by[row_data[transpose_rows[k]]] = row;
+
+          unsigned int c=0;
+          while (c<n_colors && color_used_by[c] == row)
+            ++c;
+          if (c == n_colors)
+            {
+              ++n_colors;
+              color_used_by.push_back (numbers::invalid_size_type);
+            }
+          row_data[row] = c;
+        }
+
+      // the forward sweep goes through the colors in ascending order, the
+      // backward sweep in descending order
+      for (size_type row=0; row<n; ++row)
+        {
+          forward_level[row] = row_data[row];
+          backward_level[row] = n_colors - 1 - row_data[row];
+        }
+      n_forward = n_colors;
+      n_backward = n_colors;
+    }
+
+  sort_rows_by_level (forward_level, n_forward, forward_rows,
+                      forward_level_starts);
+  sort_rows_by_level (backward_level, n_backward, backward_rows,
+                      backward_level_starts);
+}
+
+
+
+void
+SparseLevelSchedule::clear ()
+{
+  mode = level_scheduled;
+  n_nonzero = 0;
+  std::vector<size_type>().swap (forward_rows);
+  std::vector<std::size_t>().swap (forward_level_starts);
+  std::vector<size_type>().swap (backward_rows);
+  std::vector<std::size_t>().swap (backward_level_starts);
+  std::vector<unsigned int>().swap (row_data);
+}
+
+
+
+std::vector<SparseLevelSchedule::size_type>
+SparseLevelSchedule::get_forward_level (const unsigned int level) const
+{
+  AssertIndexRange (level, n_forward_levels());
+  return std::vector<size_type> (forward_rows.begin()+forward_level_starts[level],
+                                 forward_rows.begin()+forward_level_starts[level+1]);
+}
+
+
+
+std::vector<SparseLevelSchedule::size_type>
+SparseLevelSchedule::get_backward_level (const unsigned int level) const
+{
+  AssertIndexRange (level, n_backward_levels());
+  return std::vector<size_type> (backward_rows.begin()+backward_level_starts[level],
+                                 backward_rows.begin()+backward_level_starts[level+1]);
+}
+
+
+
+std::size_t
+SparseLevelSchedule::memory_consumption () const
+{
+  return (sizeof(*this) +
+          MemoryConsumption::memory_consumption (forward_rows) +
+          MemoryConsumption::memory_consumption (forward_level_starts) +
+          MemoryConsumption::memory_consumption (backward_rows) +
+          MemoryConsumption::memory_consumption (backward_level_starts) +
+          MemoryConsumption::memory_consumption (row_data));
+}
+
+DEAL_II_NAMESPACE_CLOSE
@@ -0,0 +1,520 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+#include <deal.II/matrix_free/fe_evaluation.h>
+
+#include <algorithm>
+
+DEAL_II_NAMESPACE_OPEN
+
+
+namespace internal
+{
+  namespace
+  {
+    // The highest polynomial degree for which the templated kernels are
+    // precompiled. Degrees above this value (and degree zero) use the
+    // generic kernels with run-time loop bounds.
+    const int max_precompiled_degree = 8;
+
+
+
+    // Generic version of EvaluatorTensorProduct<evaluate_general>::apply()
+    // with loop bounds given at run time. The layout of the shape data is
+    // the same, i.e., shape_data[dof*n_q_points_1d+q].
+    template <int dim, typename Number>
+    void
+    apply_1d_any_degree (const Number       *shape_data,
+                         const unsigned int  n_dofs_1d,
+                         const unsigned int  n_q_points_1d,
+                         const unsigned int  direction,
+                         const bool          dof_to_quad,
+                         const bool          add,
+                         const Number       *in,
+                         Number             *out)
+    {
+      AssertIndexRange (direction, dim);
+      const unsigned int mm = dof_to_quad ? n_dofs_1d : n_q_points_1d,
+                         nn = dof_to_quad ? n_q_points_1d : n_dofs_1d;
+
+      const unsigned int n_blocks1 = (dim > 1 ? (direction > 0 ? nn : mm) : 1);
+      const unsigned int n_blocks2 = (dim > 2 ? (direction > 1 ? nn : mm) : 1);
+      unsigned int stride = 1;
+      for (unsigned int d=0; d<direction; ++d)
+        stride *= nn;
+
+      for (unsigned int i2=0; i2<n_blocks2; ++i2)
+        {
+          for (unsigned int i1=0; i1<n_blocks1; ++i1)
+            {
+              for (unsigned int col=0; col<nn; ++col)
+                {
+                  Number res0 = (dof_to_quad ? shape_data[col] :
+                                 shape_data[col*n_q_points_1d]) * in[0];
+                  for (unsigned int ind=1; ind<mm; ++ind)
+                    res0 += (dof_to_quad ? shape_data[ind*n_q_points_1d+col] :
+                             shape_data[col*n_q_points_1d+ind]) * in[stride*ind];
+                  if (add == false)
+                    out[stride*col]  = res0;
+                  else
+                    out[stride*col] += res0;
+                }
+
+              // same increments as in the templated version
+              if (direction == 0)
+                {
+                  in += mm;
+                  out += nn;
+                }
+              else
+                {
+                  ++in;
+                  ++out;
+                }
+            }
+          if (direction == 1)
+            {
+              in += nn*(mm-1);
+              out += nn*(nn-1);
+            }
+        }
+    }
+
+
+
+    // Applies the one-dimensional kernels given by shape_data[d] in all
+    // coordinate directions, using scratch_data for the intermediate
+    // results. Only the last direction adds into the output if requested.
+    template <int dim, typename Number>
+    void
+    apply_tensor_product_any_degree (const Number *const shape_data[],
+                                     const unsigned int  n_dofs_1d,
+                                     const unsigned int  n_q_points_1d,
+                                     const bool          dof_to_quad,
+                                     const bool          add,
+                                     const Number       *in,
+                                     Number             *out,
+                                     Number             *scratch_data)
+    {
+      const unsigned int n_max =
+        Utilities::fixed_power<dim>(std::max(n_dofs_1d, n_q_points_1d));
+      const Number *my_in = in;
+      for (unsigned int d=0; d<dim; ++d)
+        {
+          Number *my_out = (d == dim-1) ? out : scratch_data + (d%2)*n_max;
+          apply_1d_any_degree<dim> (shape_data[d], n_dofs_1d, n_q_points_1d,
+                                    d, dof_to_quad, add && (d == dim-1),
+                                    my_in, my_out);
+          my_in = my_out;
+        }
+    }
+
+
+
+    template <int dim, typename Number>
+    void
+    evaluate_generic (const MatrixFreeFunctions::ShapeInfo<Number> &shape_info,
+                      const unsigned int       n_components,
+                      VectorizedArray<Number> *values_dofs[],
+                      VectorizedArray<Number> *values_quad[],
+                      VectorizedArray<Number> *gradients_quad[][dim],
+                      VectorizedArray<Number> *hessians_quad[][(dim*(dim+1))/2],
+                      VectorizedArray<Number> *scratch_data,
+                      const bool               evaluate_val,
+                      const bool               evaluate_grad,
+                      const bool               evaluate_lapl)
+    {
+      AssertThrow (shape_info.element_type != MatrixFreeFunctions::truncated_tensor,
+                   ExcNotImplemented());
+
+      const unsigned int n_dofs_1d = shape_info.fe_degree+1;
+      const unsigned int n_q_points_1d = shape_info.n_q_points_1d;
+      const VectorizedArray<Number> *values = shape_info.shape_values.begin();
+      const VectorizedArray<Number> *gradients = shape_info.shape_gradients.begin();
+      const VectorizedArray<Number> *hessians = shape_info.shape_hessians.begin();
+      const VectorizedArray<Number> *shape_data[dim];
+
+      for (unsigned int c=0; c<n_components; ++c)
+        {
+          if (evaluate_val == true)
+            {
+              for (unsigned int e=0; e<dim; ++e)
+                shape_data[e] = values;
+              apply_tensor_product_any_degree<dim> (shape_data, n_dofs_1d,
+                                                    n_q_points_1d, true, false,
+                                                    values_dofs[c], values_quad[c],
+                                                    scratch_data);
+            }
+          if (evaluate_grad == true)
+            for (unsigned int d=0; d<dim; ++d)
+              {
+                for (unsigned int e=0; e<dim; ++e)
+                  shape_data[e] = (e == d) ? gradients : values;
+                apply_tensor_product_any_degree<dim> (shape_data, n_dofs_1d,
+                                                      n_q_points_1d, true, false,
+                                                      values_dofs[c],
+                                                      gradients_quad[c][d],
+                                                      scratch_data);
+              }
+          if (evaluate_lapl == true)
+            {
+              // diagonal entries first, then the off-diagonal ones in the
+              // order xy, xz, yz
+              for (unsigned int d=0; d<dim; ++d)
+                {
+                  for (unsigned int e=0; e<dim; ++e)
+                    shape_data[e] = (e == d) ? hessians : values;
+                  apply_tensor_product_any_degree<dim> (shape_data, n_dofs_1d,
+                                                        n_q_points_1d, true, false,
+                                                        values_dofs[c],
+                                                        hessians_quad[c][d],
+                                                        scratch_data);
+                }
+              unsigned int count = dim;
+              for (unsigned int d=0; d<dim; ++d)
+                for (unsigned int e=d+1; e<dim; ++e, ++count)
+                  {
+                    for (unsigned int f=0; f<dim; ++f)
+                      shape_data[f] = (f == d || f == e) ? gradients : values;
+                    apply_tensor_product_any_degree<dim> (shape_data, n_dofs_1d,
+                                                          n_q_points_1d, true, false,
+                                                          values_dofs[c],
+                                                          hessians_quad[c][count],
+                                                          scratch_data);
+                  }
+            }
+        }
+
+      // case additional dof for FE_Q_DG0: add values; gradients and second
+      // derivatives evaluate to zero
+      if (shape_info.element_type == MatrixFreeFunctions::tensor_symmetric_plus_dg0 &&
+          evaluate_val)
+        {
+          const unsigned int dofs_tensor = Utilities::fixed_power<dim>(n_dofs_1d);
+          for (unsigned int c=0; c<n_components; ++c)
+            for (unsigned int q=0; q<shape_info.n_q_points; ++q)
+              values_quad[c][q] += values_dofs[c][dofs_tensor];
+        }
+    }
+
+
+
+    template <int dim, typename Number>
+    void
+    integrate_generic (const MatrixFreeFunctions::ShapeInfo<Number> &shape_info,
+                       const unsigned int       n_components,
+                       VectorizedArray<Number> *values_dofs[],
+                       VectorizedArray<Number> *values_quad[],
+                       VectorizedArray<Number> *gradients_quad[][dim],
+                       VectorizedArray<Number> *scratch_data,
+                       const bool               integrate_val,
+                       const bool               integrate_grad)
+    {
+      AssertThrow (shape_info.element_type != MatrixFreeFunctions::truncated_tensor,
+                   ExcNotImplemented());
+
+      const unsigned int n_dofs_1d = shape_info.fe_degree+1;
+      const unsigned int n_q_points_1d = shape_info.n_q_points_1d;
+      const unsigned int dofs_tensor = Utilities::fixed_power<dim>(n_dofs_1d);
+      const VectorizedArray<Number> *values = shape_info.shape_values.begin();
+      const VectorizedArray<Number> *gradients = shape_info.shape_gradients.begin();
+      const VectorizedArray<Number> *shape_data[dim];
+
+      for (unsigned int c=0; c<n_components; ++c)
+        {
+          if (integrate_val == true)
+            {
+              for (unsigned int e=0; e<dim; ++e)
+                shape_data[e] = values;
+              apply_tensor_product_any_degree<dim> (shape_data, n_dofs_1d,
+                                                    n_q_points_1d, false, false,
+                                                    values_quad[c], values_dofs[c],
+                                                    scratch_data);
+            }
+          if (integrate_grad == true)
+            for (unsigned int d=0; d<dim; ++d)
+              {
+                for (unsigned int e=0; e<dim; ++e)
+                  shape_data[e] = (e == d) ? gradients : values;
+                apply_tensor_product_any_degree<dim> (shape_data, n_dofs_1d,
+                                                      n_q_points_1d, false,
+                                                      integrate_val || d>0,
+                                                      gradients_quad[c][d],
+                                                      values_dofs[c],
+                                                      scratch_data);
+              }
+          if (integrate_val == false && integrate_grad == false)
+            for (unsigned int i=0; i<dofs_tensor; ++i)
+              values_dofs[c][i] = VectorizedArray<Number>();
+        }
+
+      // case FE_Q_DG0: add values, gradients and second derivatives are zero
+      if (shape_info.element_type == MatrixFreeFunctions::tensor_symmetric_plus_dg0)
+        {
+          if (integrate_val)
+            for (unsigned int c=0; c<n_components; ++c)
+              {
+                values_dofs[c][dofs_tensor] = values_quad[c][0];
+                for (unsigned int q=1; q<shape_info.n_q_points; ++q)
+                  values_dofs[c][dofs_tensor] += values_quad[c][q];
+              }
+          else
+            for (unsigned int c=0; c<n_components; ++c)
+              values_dofs[c][dofs_tensor] = VectorizedArray<Number>();
+        }
+    }
+
+
+
+    // Runs the templated kernels of FEEvaluationImpl for the given element
+    // type, one component at a time
+    template <MatrixFreeFunctions::ElementType type, int dim, int degree,
+              typename Number>
+    void
+    evaluate_precompiled (const MatrixFreeFunctions::ShapeInfo<Number> &shape_info,
+                          const unsigned int       n_components,
+                          VectorizedArray<Number> *values_dofs[],
+                          VectorizedArray<Number> *values_quad[],
+                          VectorizedArray<Number> *gradients_quad[][dim],
+                          VectorizedArray<Number> *hessians_quad[][(dim*(dim+1))/2],
+                          const bool               evaluate_val,
+                          const bool               evaluate_grad,
+                          const bool               evaluate_lapl)
+    {
+      for (unsigned int c=0; c<n_components; ++c)
+        FEEvaluationImpl<type,dim,degree,degree+1,1,Number>
+        ::evaluate (shape_info, &values_dofs[c], &values_quad[c],
+                    &gradients_quad[c], &hessians_quad[c],
+                    evaluate_val, evaluate_grad, evaluate_lapl);
+    }
+
+
+
+    template <MatrixFreeFunctions::ElementType type, int dim, int degree,
+              typename Number>
+    void
+    integrate_precompiled (const MatrixFreeFunctions::ShapeInfo<Number> &shape_info,
+                           const unsigned int       n_components,
+                           VectorizedArray<Number> *values_dofs[],
+                           VectorizedArray<Number> *values_quad[],
+                           VectorizedArray<Number> *gradients_quad[][dim],
+                           const bool               integrate_val,
+                           const bool               integrate_grad)
+    {
+      for (unsigned int c=0; c<n_components; ++c)
+        FEEvaluationImpl<type,dim,degree,degree+1,1,Number>
+        ::integrate (shape_info, &values_dofs[c], &values_quad[c],
+                     &gradients_quad[c], integrate_val, integrate_grad);
+    }
+
+
+
+    // Selects the precompiled kernels for the polynomial degree stored in
+    // the shape info by recursion over the degree. Returns false if no
+    // precompiled kernel is available.
+    template <int degree, int dim, typename Number>
+    struct PrecompiledSelector
+    {
+      static bool
+      evaluate (const MatrixFreeFunctions::ShapeInfo<Number> &shape_info,
+                const unsigned int       n_components,
+                VectorizedArray<Number> *values_dofs[],
+                VectorizedArray<Number> *values_quad[],
+                VectorizedArray<Number> *gradients_quad[][dim],
+                VectorizedArray<Number> *hessians_quad[][(dim*(dim+1))/2],
+                const bool               evaluate_val,
+                const bool               evaluate_grad,
+                const bool               evaluate_lapl)
+      {
+        if (shape_info.fe_degree != degree)
+          return PrecompiledSelector<degree+1,dim,Number>
+                 ::evaluate (shape_info, n_components, values_dofs, values_quad,
+                             gradients_quad, hessians_quad, evaluate_val,
+                             evaluate_grad, evaluate_lapl);
+        if (shape_info.n_q_points_1d != degree+1)
+          return false;
+
+        switch (shape_info.element_type)
+          {
+          case MatrixFreeFunctions::tensor_symmetric:
+            evaluate_precompiled<MatrixFreeFunctions::tensor_symmetric,dim,degree>
+            (shape_info, n_components, values_dofs, values_quad, gradients_quad,
+             hessians_quad, evaluate_val, evaluate_grad, evaluate_lapl);
+            break;
+          case MatrixFreeFunctions::tensor_symmetric_plus_dg0:
+            evaluate_precompiled<MatrixFreeFunctions::tensor_symmetric_plus_dg0,dim,degree>
+            (shape_info, n_components, values_dofs, values_quad, gradients_quad,
+             hessians_quad, evaluate_val, evaluate_grad, evaluate_lapl);
+            break;
+          case MatrixFreeFunctions::tensor_general:
+            evaluate_precompiled<MatrixFreeFunctions::tensor_general,dim,degree>
+            (shape_info, n_components, values_dofs, values_quad, gradients_quad,
+             hessians_quad, evaluate_val, evaluate_grad, evaluate_lapl);
+            break;
+          case MatrixFreeFunctions::tensor_gausslobatto:
+            evaluate_precompiled<MatrixFreeFunctions::tensor_gausslobatto,dim,degree>
+            (shape_info, n_components, values_dofs, values_quad, gradients_quad,
+             hessians_quad, evaluate_val, evaluate_grad, evaluate_lapl);
+            break;
+          case MatrixFreeFunctions::truncated_tensor:
+            evaluate_precompiled<MatrixFreeFunctions::truncated_tensor,dim,degree>
+            (shape_info, n_components, values_dofs, values_quad, gradients_quad,
+             hessians_quad, evaluate_val, evaluate_grad, evaluate_lapl);
+            break;
+          default:
+            AssertThrow(false, ExcNotImplemented());
+          }
+        return true;
+      }
+
+      static bool
+      integrate (const MatrixFreeFunctions::ShapeInfo<Number> &shape_info,
+                 const unsigned int       n_components,
+                 VectorizedArray<Number> *values_dofs[],
+                 VectorizedArray<Number> *values_quad[],
+                 VectorizedArray<Number> *gradients_quad[][dim],
+                 const bool               integrate_val,
+                 const bool               integrate_grad)
+      {
+        if (shape_info.fe_degree != degree)
+          return PrecompiledSelector<degree+1,dim,Number>
+                 ::integrate (shape_info, n_components, values_dofs, values_quad,
+                              gradients_quad, integrate_val, integrate_grad);
+        if (shape_info.n_q_points_1d != degree+1)
+          return false;
+
+        switch (shape_info.element_type)
+          {
+          case MatrixFreeFunctions::tensor_symmetric:
+            integrate_precompiled<MatrixFreeFunctions::tensor_symmetric,dim,degree>
+            (shape_info, n_components, values_dofs, values_quad, gradients_quad,
+             integrate_val, integrate_grad);
+            break;
+          case MatrixFreeFunctions::tensor_symmetric_plus_dg0:
+            integrate_precompiled<MatrixFreeFunctions::tensor_symmetric_plus_dg0,dim,degree>
+            (shape_info, n_components, values_dofs, values_quad, gradients_quad,
+             integrate_val, integrate_grad);
+            break;
+          case MatrixFreeFunctions::tensor_general:
+            integrate_precompiled<MatrixFreeFunctions::tensor_general,dim,degree>
+            (shape_info, n_components, values_dofs, values_quad, gradients_quad,
+             integrate_val, integrate_grad);
+            break;
+          case MatrixFreeFunctions::tensor_gausslobatto:
+            integrate_precompiled<MatrixFreeFunctions::tensor_gausslobatto,dim,degree>
+            (shape_info, n_components, values_dofs, values_quad, gradients_quad,
+             integrate_val, integrate_grad);
+            break;
+          case MatrixFreeFunctions::truncated_tensor:
+            integrate_precompiled<MatrixFreeFunctions::truncated_tensor,dim,degree>
+            (shape_info, n_components, values_dofs, values_quad, gradients_quad,
+             integrate_val, integrate_grad);
+            break;
+          default:
+            AssertThrow(false, ExcNotImplemented());
+          }
+        return true;
+      }
+    };
+
+
+
+    // end of recursion
+    template <int dim, typename Number>
+    struct PrecompiledSelector<max_precompiled_degree+1,dim,Number>
+    {
+      static bool
+      evaluate (const MatrixFreeFunctions::ShapeInfo<Number> &,
+                const unsigned int,
+                VectorizedArray<Number> *[],
+                VectorizedArray<Number> *[],
+                VectorizedArray<Number> *[][dim],
+                VectorizedArray<Number> *[][(dim*(dim+1))/2],
+                const bool,
+                const bool,
+                const bool)
+      {
+        return false;
+      }
+
+      static bool
+      integrate (const MatrixFreeFunctions::ShapeInfo<Number> &,
+                 const unsigned int,
+                 VectorizedArray<Number> *[],
+                 VectorizedArray<Number> *[],
+                 VectorizedArray<Number> *[][dim],
+                 const bool,
+                 const bool)
+      {
+        return false;
+      }
+    };
+  }
+
+
+
+  template <int dim, typename Number>
+  void
+  FEEvaluationImplAnyDegree<dim,Number>
+  ::evaluate (const MatrixFreeFunctions::ShapeInfo<Number> &shape_info,
+              const unsigned int       n_components,
+              VectorizedArray<Number> *values_dofs[],
+              VectorizedArray<Number> *values_quad[],
+              VectorizedArray<Number> *gradients_quad[][dim],
+              VectorizedArray<Number> *hessians_quad[][(dim*(dim+1))/2],
+              VectorizedArray<Number> *scratch_data,
+              const bool               evaluate_val,
+              const bool               evaluate_grad,
+              const bool               evaluate_lapl)
+  {
+    if (evaluate_val == false && evaluate_grad == false && evaluate_lapl == false)
+      return;
+
+    if (PrecompiledSelector<1,dim,Number>::evaluate
+        (shape_info, n_components, values_dofs, values_quad, gradients_quad,
+         hessians_quad, evaluate_val, evaluate_grad, evaluate_lapl) == false)
+      evaluate_generic<dim> (shape_info, n_components, values_dofs, values_quad,
+                             gradients_quad, hessians_quad, scratch_data,
+                             evaluate_val, evaluate_grad, evaluate_lapl);
+  }
+
+
+
+  template <int dim, typename Number>
+  void
+  FEEvaluationImplAnyDegree<dim,Number>
+  ::integrate (const MatrixFreeFunctions::ShapeInfo<Number> &shape_info,
+               const unsigned int       n_components,
+               VectorizedArray<Number> *values_dofs[],
+               VectorizedArray<Number> *values_quad[],
+               VectorizedArray<Number> *gradients_quad[][dim],
+               VectorizedArray<Number> *scratch_data,
+               const bool               integrate_val,
+               const bool               integrate_grad)
+  {
+    if (PrecompiledSelector<1,dim,Number>::integrate
+        (shape_info, n_components, values_dofs, values_quad, gradients_quad,
+         integrate_val, integrate_grad) == false)
+      integrate_generic<dim> (shape_info, n_components, values_dofs, values_quad,
+                              gradients_quad, scratch_data, integrate_val,
+                              integrate_grad);
+  }
+}
+
+
+#include "fe_evaluation_any_degree.inst"
+
+DEAL_II_NAMESPACE_CLOSE
@@ -18,6 +18,8 @@
 #include <deal.II/base/function.h>
 
 #include <deal.II/lac/la_parallel_vector.h>
+#include <deal.II/lac/full_matrix.h>
+#include <deal.II/lac/vector.h>
 #include <deal.II/grid/tria.h>
 #include <deal.II/grid/tria_iterator.h>
 #include <deal.II/dofs/dof_tools.h>
@@ -524,6 +526,70 @@ void MGTransferMatrixFree<dim,Number>
 
 
 
+template <int dim, typename Number>
+template <typename Number2>
+void
+MGTransferMatrixFree<dim,Number>::interpolate_to_mg
+(const DoFHandler<dim>                                      &mg_dof,
+ MGLevelObject<LinearAlgebra::distributed::Vector<Number> > &dst,
+ const LinearAlgebra::distributed::Vector<Number2>          &src) const
+{
+  // set the values on the active cells of all levels
+  this->copy_to_mg(mg_dof, dst, src);
+
+  const FiniteElement<dim> &fe = mg_dof.get_fe();
+  const types::subdomain_id my_subdomain =
+    mg_dof.get_triangulation().locally_owned_subdomain();
+  const unsigned int dofs_per_cell = fe.dofs_per_cell;
+  std::vector<types::global_dof_index> dof_indices (dofs_per_cell);
+  Vector<double> dof_values_fine (dofs_per_cell);
+  Vector<double> dof_values_coarse (dofs_per_cell);
+  Vector<double> tmp (dofs_per_cell);
+
+  // go from the finest to the coarsest level and interpolate the values of
+  // refined cells from their children
+  for (unsigned int level=dst.max_level(); level>dst.min_level(); --level)
+    {
+      LinearAlgebra::distributed::Vector<Number> &ghosted_fine =
+        this->ghosted_level_vector[level];
+      LinearAlgebra::distributed::Vector<Number> &ghosted_coarse =
+        this->ghosted_level_vector[level-1];
+      ghosted_fine = dst[level];
+      ghosted_fine.update_ghost_values();
+      ghosted_coarse = dst[level-1];
+
+      for (typename DoFHandler<dim>::cell_iterator cell=mg_dof.begin(level-1);
+           cell!=mg_dof.end(level-1); ++cell)
+        if (cell->has_children() &&
+            (my_subdomain == numbers::invalid_subdomain_id ||
+             cell->level_subdomain_id() == my_subdomain))
+          {
+            dof_values_coarse = 0;
+            for (unsigned int child=0; child<cell->n_children(); ++child)
+              {
+                cell->child(child)->get_mg_dof_indices(dof_indices);
+                for (unsigned int i=0; i<dofs_per_cell; ++i)
+                  dof_values_fine(i) = ghosted_fine(dof_indices[i]);
+                fe.get_restriction_matrix(child, cell->refinement_case())
+                .vmult (tmp, dof_values_fine);
+                for (unsigned int i=0; i<dofs_per_cell; ++i)
+                  if (fe.restriction_is_additive(i))
+                    dof_values_coarse(i) += tmp(i);
+                  else if (tmp(i) != 0.)
+                    dof_values_coarse(i) = tmp(i);
+              }
+            cell->get_mg_dof_indices(dof_indices);
+            for (unsigned int i=0; i<dofs_per_cell; ++i)
+              ghosted_coarse(dof_indices[i]) = dof_values_coarse(i);
+          }
+
+      ghosted_coarse.compress(VectorOperation::insert);
+      dst[level-1] = ghosted_coarse;
+    }
+}
+
+
+
 template <int dim, typename Number>
 std::size_t
 MGTransferMatrixFree<dim,Number>::memory_consumption() const
@@ -0,0 +1,123 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// tests SolverBlockCG on the five-point stencil with several right-hand
+// sides: all residuals must be below the tolerance and the block method
+// needs fewer iterations than SolverCG. The last set of right-hand sides is
+// linearly dependent and contains a system whose initial guess is already
+// the solution, which must be deflated without breakdown
+
+#include "../tests.h"
+#include "../testmatrix.h"
+#include <deal.II/base/logstream.h>
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/dynamic_sparsity_pattern.h>
+#include <deal.II/lac/vector.h>
+#include <deal.II/lac/solver_control.h>
+#include <deal.II/lac/solver_cg.h>
+#include <deal.II/lac/solver_block_krylov.h>
+#include <deal.II/lac/precondition.h>
+
+#include <fstream>
+#include <iomanip>
+
+
+template <typename PreconditionerType>
+void
+check (const SparseMatrix<double>         &A,
+       const std::vector<Vector<double> > &rhs,
+       const PreconditionerType           &preconditioner)
+{
+  const double tolerance = 1e-10;
+  SolverControl control (1000, tolerance);
+  SolverCG<> solver_cg (control);
+  unsigned int max_steps_cg = 0;
+  std::vector<Vector<double> > reference (rhs.size(), Vector<double>(A.m()));
+  const unsigned int previous_depth = deallog.depth_file(0);
+  for (unsigned int j=0; j<rhs.size(); ++j)
+    {
+      solver_cg.solve (A, reference[j], rhs[j], preconditioner);
+      max_steps_cg = std::max (max_steps_cg, control.last_step());
+    }
+  deallog.depth_file(previous_depth);
+
+  std::vector<Vector<double> > sol (rhs.size(), Vector<double>(A.m()));
+  sol.back() = reference.back();
+  SolverBlockCG<> solver (control);
+  solver.solve (A, sol, rhs, preconditioner);
+  deallog << "Fewer iterations than CG: "
+          << (control.last_step() < max_steps_cg) << std::endl;
+
+  bool converged = true, close = true;
+  Vector<double> residual (A.m());
+  for (unsigned int j=0; j<rhs.size(); ++j)
+    {
+      A.residual (residual, sol[j], rhs[j]);
+      if (residual.l2_norm() > 1.01*tolerance)
+        converged = false;
+      sol[j] -= reference[j];
+      if (sol[j].linfty_norm() > 1e-6*(reference[j].linfty_norm()+1e-10))
+        close = false;
+    }
+  deallog << "All residuals below tolerance: " << converged << std::endl;
+  deallog << "Difference to CG solutions: " << close << std::endl;
+}
+
+
+
+int main()
+{
+  std::ofstream logfile("output");
+  deallog << std::setprecision(4);
+  deallog.attach(logfile);
+  deallog.threshold_double(1.e-10);
+
+  const unsigned int size = 33;
+  const unsigned int dim = (size-1)*(size-1);
+
+  FDMatrix testproblem(size, size);
+  DynamicSparsityPattern dsp (dim, dim);
+  testproblem.five_point_structure (dsp);
+  SparsityPattern structure;
+  structure.copy_from (dsp);
+  SparseMatrix<double> A (structure);
+  testproblem.five_point (A);
+
+  std::vector<Vector<double> > rhs (4, Vector<double>(dim));
+  for (unsigned int i=0; i<dim; ++i)
+    {
+      rhs[0](i) = 1.;
+      rhs[1](i) = (i%(size-1)) * 0.1;
+      rhs[2](i) = Testing::rand()/static_cast<double>(RAND_MAX);
+      rhs[3](i) = std::sin(0.01*i);
+    }
+  std::vector<Vector<double> > rhs_dependent (rhs);
+  rhs_dependent[2] = rhs[0];
+  rhs_dependent[2].add (2., rhs[1]);
+
+  deallog.push("Identity");
+  check (A, rhs, PreconditionIdentity());
+  check (A, rhs_dependent, PreconditionIdentity());
+  deallog.pop();
+
+  deallog.push("SSOR");
+  PreconditionSSOR<> ssor;
+  ssor.initialize (A, 1.2);
+  check (A, rhs, ssor);
+  check (A, rhs_dependent, ssor);
+  deallog.pop();
+}
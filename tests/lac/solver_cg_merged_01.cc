@@ -0,0 +1,200 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// checks SolverCG with merged vector operations against the standard
+// implementation for a tridiagonal matrix that offers a vmult with
+// operations before and after the product: the merged variant must only be
+// used when requested through AdditionalData, and the search directions
+// handed to print_vectors must agree between both variants
+
+#include "../tests.h"
+
+#include <deal.II/base/logstream.h>
+#include <deal.II/base/std_cxx11/function.h>
+#include <deal.II/lac/diagonal_matrix.h>
+#include <deal.II/lac/la_parallel_vector.h>
+#include <deal.II/lac/precondition.h>
+#include <deal.II/lac/solver_cg.h>
+#include <deal.II/lac/solver_control.h>
+
+#include <algorithm>
+#include <iostream>
+
+std::ofstream logfile("output");
+
+
+typedef LinearAlgebra::distributed::Vector<double> VectorType;
+
+
+// tridiagonal operator with the entries -1, diagonal[i], -1 that processes
+// the rows in chunks and calls the operations on the chunks, counting the
+// calls of the variant with operations
+class TridiagonalOperator : public Subscriptor
+{
+public:
+  TridiagonalOperator (const unsigned int size)
+    :
+    diagonal (size),
+    n_merged_vmults (0)
+  {
+    for (unsigned int i=0; i<size; ++i)
+      diagonal[i] = 4. + 0.1 * (i%7);
+  }
+
+  void vmult (VectorType &dst, const VectorType &src) const
+  {
+    for (unsigned int i=0; i<diagonal.size(); ++i)
+      compute_row(dst, src, i);
+  }
+
+  void vmult (VectorType       &dst,
+              const VectorType &src,
+              const std_cxx11::function<void(const unsigned int,const unsigned int)> &operation_before,
+              const std_cxx11::function<void(const unsigned int,const unsigned int)> &operation_after) const
+  {
+    ++n_merged_vmults;
+    const unsigned int size = diagonal.size();
+    const unsigned int chunk_size = 37;
+    operation_before(0, std::min(chunk_size, size));
+    for (unsigned int begin=0; begin<size; begin+=chunk_size)
+      {
+        const unsigned int end = std::min(begin+chunk_size, size);
+        // the last row of the chunk reads the first entry of the next chunk
+        if (end < size)
+          operation_before(end, std::min(end+chunk_size, size));
+        for (unsigned int i=begin; i<end; ++i)
+          compute_row(dst, src, i);
+        operation_after(begin, end);
+      }
+  }
+
+  std::vector<double> diagonal;
+  mutable unsigned int n_merged_vmults;
+
+private:
+  void compute_row (VectorType       &dst,
+                    const VectorType &src,
+                    const unsigned int i) const
+  {
+    double sum = diagonal[i] * src.local_element(i);
+    if (i > 0)
+      sum -= src.local_element(i-1);
+    if (i+1 < diagonal.size())
+      sum -= src.local_element(i+1);
+    dst.local_element(i) = sum;
+  }
+};
+
+
+
+// records the norms of the search directions handed to print_vectors
+class RecordingSolverCG : public SolverCG<VectorType>
+{
+public:
+  RecordingSolverCG (SolverControl        &control,
+                     const AdditionalData &data)
+    :
+    SolverCG<VectorType> (control, data)
+  {}
+
+  virtual void print_vectors(const unsigned int,
+                             const VectorType &,
+                             const VectorType &,
+                             const VectorType &d) const
+  {
+    search_direction_norms.push_back(d.l2_norm());
+  }
+
+  mutable std::vector<double> search_direction_norms;
+};
+
+
+
+template <typename PreconditionerType>
+void run (const TridiagonalOperator &matrix,
+          const PreconditionerType  &preconditioner,
+          const VectorType          &rhs)
+{
+  VectorType sol (rhs), sol_ref (rhs);
+
+  SolverControl control (1000, 1e-12*rhs.l2_norm());
+  SolverCG<VectorType>::AdditionalData data;
+  RecordingSolverCG solver_ref (control, data);
+  sol_ref = 0;
+  matrix.n_merged_vmults = 0;
+  solver_ref.solve (matrix, sol_ref, rhs, preconditioner);
+  const unsigned int n_iterations_ref = control.last_step();
+  deallog << "Merged products without request: " << matrix.n_merged_vmults
+          << std::endl;
+
+  data.merge_vector_operations = true;
+  RecordingSolverCG solver (control, data);
+  sol = 0;
+  solver.solve (matrix, sol, rhs, preconditioner);
+  deallog << "CG iterations merged/plain: " << control.last_step() << " "
+          << n_iterations_ref << std::endl;
+  deallog << "Merged products with request: " << matrix.n_merged_vmults
+          << std::endl;
+
+  double max_difference = 0;
+  for (unsigned int i=0; i<std::min(solver.search_direction_norms.size(),
+                                    solver_ref.search_direction_norms.size()); ++i)
+    max_difference = std::max(max_difference,
+                              std::abs(solver.search_direction_norms[i] -
+                                       solver_ref.search_direction_norms[i]) /
+                              solver_ref.search_direction_norms[i]);
+  deallog << "Error search directions: " << max_difference << std::endl;
+
+  sol -= sol_ref;
+  deallog << "Error solution: " << sol.linfty_norm()/sol_ref.linfty_norm()
+          << std::endl;
+}
+
+
+
+void test (const unsigned int size)
+{
+  deallog << "Size " << size << std::endl;
+  TridiagonalOperator matrix (size);
+  VectorType rhs (size);
+  for (unsigned int i=0; i<size; ++i)
+    rhs(i) = 1. + 0.01 * (i%13);
+
+  DiagonalMatrix<VectorType> jacobi;
+  jacobi.get_vector().reinit(size);
+  for (unsigned int i=0; i<size; ++i)
+    jacobi.get_vector()(i) = 1./matrix.diagonal[i];
+
+  deallog.push("Jacobi");
+  run (matrix, jacobi, rhs);
+  deallog.pop();
+  deallog.push("Identity");
+  run (matrix, PreconditionIdentity(), rhs);
+  deallog.pop();
+}
+
+
+
+int main ()
+{
+  deallog.attach(logfile);
+  deallog.depth_file(2);
+  deallog.threshold_double(1.e-10);
+
+  test (100);
+  test (20000);
+}
@@ -0,0 +1,91 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// checks that SolverFGMRES gives the same results with the modified and the
+// classical Gram-Schmidt orthogonalization
+
+#include "../tests.h"
+#include "../testmatrix.h"
+#include <deal.II/base/logstream.h>
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/dynamic_sparsity_pattern.h>
+#include <deal.II/lac/vector.h>
+#include <deal.II/lac/solver_control.h>
+#include <deal.II/lac/solver_gmres.h>
+#include <deal.II/lac/precondition.h>
+
+#include <fstream>
+#include <iomanip>
+
+
+template <typename PreconditionerType>
+void
+check (const SparseMatrix<double> &A,
+       const PreconditionerType   &preconditioner)
+{
+  Vector<double> rhs (A.m()), reference (A.m()), sol (A.m());
+  for (unsigned int i=0; i<rhs.size(); ++i)
+    rhs(i) = 1. + 0.01 * (i%13);
+
+  typedef SolverFGMRES<Vector<double> > SolverType;
+  SolverControl control (1000, 1e-10*rhs.l2_norm());
+  SolverType solver_mgs (control, SolverType::AdditionalData(20));
+  const unsigned int previous_depth = deallog.depth_file(0);
+  solver_mgs.solve (A, reference, rhs, preconditioner);
+  deallog.depth_file(previous_depth);
+  const unsigned int steps_mgs = control.last_step();
+
+  SolverType solver_cgs (control,
+                         SolverType::AdditionalData
+                         (20, true, SolverGMRES<Vector<double> >::AdditionalData::classical_gram_schmidt));
+  check_solver_within_range (solver_cgs.solve (A, sol, rhs, preconditioner),
+                             control.last_step(), steps_mgs-1, steps_mgs+1);
+  sol -= reference;
+  deallog << "Difference between modified and classical Gram-Schmidt: "
+          << (sol.linfty_norm() < 1e-8*reference.linfty_norm()) << std::endl;
+}
+
+
+
+int main()
+{
+  std::ofstream logfile("output");
+  deallog << std::setprecision(4);
+  deallog.attach(logfile);
+  deallog.threshold_double(1.e-10);
+
+  const unsigned int size = 33;
+  const unsigned int dim = (size-1)*(size-1);
+
+  FDMatrix testproblem(size, size);
+  DynamicSparsityPattern dsp (dim, dim);
+  testproblem.five_point_structure (dsp);
+  SparsityPattern structure;
+  structure.copy_from (dsp);
+  SparseMatrix<double> A (structure);
+  testproblem.five_point (A, true);
+
+  deallog.push("Identity");
+  check (A, PreconditionIdentity());
+  deallog.pop();
+
+  deallog.push("SSOR");
+  PreconditionSSOR<> ssor;
+  ssor.initialize (A, 1.2);
+  check (A, ssor);
+  deallog.pop();
+}
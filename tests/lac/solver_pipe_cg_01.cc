@@ -0,0 +1,114 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// tests the pipelined and the single-reduction variant of SolverPipeCG
+// against SolverCG on the five-point stencil with different preconditioners:
+// the number of iterations must agree up to a small difference due to
+// roundoff and the solutions must be close
+
+#include "../tests.h"
+#include "../testmatrix.h"
+#include <deal.II/base/logstream.h>
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/dynamic_sparsity_pattern.h>
+#include <deal.II/lac/vector.h>
+#include <deal.II/lac/solver_control.h>
+#include <deal.II/lac/solver_cg.h>
+#include <deal.II/lac/solver_pipe_cg.h>
+#include <deal.II/lac/precondition.h>
+
+#include <fstream>
+#include <iomanip>
+
+
+template <typename PreconditionerType>
+void
+check (const SparseMatrix<double> &A,
+       const PreconditionerType   &preconditioner)
+{
+  Vector<double> rhs (A.m()), reference (A.m()), sol (A.m());
+  rhs = 1.;
+
+  SolverControl control (1000, 1e-10*rhs.l2_norm());
+  SolverCG<> solver_cg (control);
+  const unsigned int previous_depth = deallog.depth_file(0);
+  solver_cg.solve (A, reference, rhs, preconditioner);
+  deallog.depth_file(previous_depth);
+  const unsigned int steps_cg = control.last_step();
+
+  const SolverPipeCG<>::AdditionalData::Variant variants[2] =
+  {
+    SolverPipeCG<>::AdditionalData::pipelined,
+    SolverPipeCG<>::AdditionalData::single_reduction
+  };
+  const char *names[2] = { "pipelined", "single reduction" };
+  for (unsigned int v=0; v<2; ++v)
+    {
+      sol = 0.;
+      SolverPipeCG<> solver (control,
+                             SolverPipeCG<>::AdditionalData(variants[v]));
+      check_solver_within_range (solver.solve (A, sol, rhs, preconditioner),
+                                 control.last_step(), steps_cg-2, steps_cg+2);
+      sol -= reference;
+      deallog << "Difference to CG solution " << names[v] << ": "
+              << (sol.linfty_norm() < 1e-8*reference.linfty_norm()) << std::endl;
+    }
+
+  // an initial guess that is already the solution
+  sol = reference;
+  SolverControl control_converged (1000, 1e-6*rhs.l2_norm());
+  SolverPipeCG<> solver (control_converged);
+  check_solver_within_range (solver.solve (A, sol, rhs, preconditioner),
+                             control_converged.last_step(), 0, 0);
+}
+
+
+
+int main()
+{
+  std::ofstream logfile("output");
+  deallog << std::setprecision(4);
+  deallog.attach(logfile);
+  deallog.threshold_double(1.e-10);
+
+  const unsigned int size = 33;
+  const unsigned int dim = (size-1)*(size-1);
+
+  FDMatrix testproblem(size, size);
+  DynamicSparsityPattern dsp (dim, dim);
+  testproblem.five_point_structure (dsp);
+  SparsityPattern structure;
+  structure.copy_from (dsp);
+  SparseMatrix<double> A (structure);
+  testproblem.five_point (A);
+
+  deallog.push("Identity");
+  check (A, PreconditionIdentity());
+  deallog.pop();
+
+  deallog.push("Jacobi");
+  PreconditionJacobi<> jacobi;
+  jacobi.initialize (A, 0.8);
+  check (A, jacobi);
+  deallog.pop();
+
+  deallog.push("SSOR");
+  PreconditionSSOR<> ssor;
+  ssor.initialize (A, 1.2);
+  check (A, ssor);
+  deallog.pop();
+}
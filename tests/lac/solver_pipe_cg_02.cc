@@ -0,0 +1,137 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// checks SolverPipeCG with LinearAlgebra::distributed::Vector, which merges
+// the vector updates and inner products into single sweeps, against SolverCG
+// for vectors short enough for a single sweep and long enough to be split
+// into several pieces
+
+#include "../tests.h"
+
+#include <deal.II/base/logstream.h>
+#include <deal.II/lac/la_parallel_vector.h>
+#include <deal.II/lac/diagonal_matrix.h>
+#include <deal.II/lac/precondition.h>
+#include <deal.II/lac/solver_control.h>
+#include <deal.II/lac/solver_cg.h>
+#include <deal.II/lac/solver_pipe_cg.h>
+
+#include <iostream>
+
+std::ofstream logfile("output");
+
+
+typedef LinearAlgebra::distributed::Vector<double> VectorType;
+
+
+// tridiagonal operator with the entries -1, diagonal[i], -1
+class TridiagonalOperator : public Subscriptor
+{
+public:
+  TridiagonalOperator (const unsigned int size)
+    :
+    diagonal (size)
+  {
+    for (unsigned int i=0; i<size; ++i)
+      diagonal[i] = 2.5 + 0.1 * (i%7);
+  }
+
+  void vmult (VectorType &dst, const VectorType &src) const
+  {
+    const unsigned int size = diagonal.size();
+    for (unsigned int i=0; i<size; ++i)
+      {
+        double sum = diagonal[i] * src.local_element(i);
+        if (i > 0)
+          sum -= src.local_element(i-1);
+        if (i+1 < size)
+          sum -= src.local_element(i+1);
+        dst.local_element(i) = sum;
+      }
+  }
+
+  std::vector<double> diagonal;
+};
+
+
+
+template <typename PreconditionerType>
+void
+check (const TridiagonalOperator &A,
+       const PreconditionerType  &preconditioner)
+{
+  VectorType rhs (A.diagonal.size()), reference (rhs), sol (rhs);
+  for (unsigned int i=0; i<rhs.size(); ++i)
+    rhs(i) = 1. + 0.01 * (i%13);
+
+  SolverControl control (1000, 1e-10*rhs.l2_norm());
+  SolverCG<VectorType> solver_cg (control);
+  const unsigned int previous_depth = deallog.depth_file(0);
+  solver_cg.solve (A, reference, rhs, preconditioner);
+  deallog.depth_file(previous_depth);
+  const unsigned int steps_cg = control.last_step();
+
+  const typename SolverPipeCG<VectorType>::AdditionalData::Variant variants[2] =
+  {
+    SolverPipeCG<VectorType>::AdditionalData::pipelined,
+    SolverPipeCG<VectorType>::AdditionalData::single_reduction
+  };
+  const char *names[2] = { "pipelined", "single reduction" };
+  for (unsigned int v=0; v<2; ++v)
+    {
+      sol = 0.;
+      SolverPipeCG<VectorType>
+      solver (control,
+              typename SolverPipeCG<VectorType>::AdditionalData(variants[v]));
+      check_solver_within_range (solver.solve (A, sol, rhs, preconditioner),
+                                 control.last_step(), steps_cg-2, steps_cg+2);
+      sol -= reference;
+      deallog << "Difference to CG solution " << names[v] << ": "
+              << (sol.linfty_norm() < 1e-8*reference.linfty_norm()) << std::endl;
+    }
+}
+
+
+
+void test (const unsigned int size)
+{
+  deallog << "Size " << size << std::endl;
+  TridiagonalOperator A (size);
+
+  deallog.push("Identity");
+  check (A, PreconditionIdentity());
+  deallog.pop();
+
+  deallog.push("Jacobi");
+  DiagonalMatrix<VectorType> jacobi;
+  jacobi.get_vector().reinit(size);
+  for (unsigned int i=0; i<size; ++i)
+    jacobi.get_vector()(i) = 1./A.diagonal[i];
+  check (A, jacobi);
+  deallog.pop();
+}
+
+
+
+int main()
+{
+  deallog.attach(logfile);
+  deallog.threshold_double(1.e-10);
+
+  test (100);
+  test (20000);
+}
@@ -0,0 +1,144 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// tests SolverGMRES with the classical Gram-Schmidt algorithm and
+// SolverSStepGMRES with different numbers of steps per block against
+// SolverGMRES with the modified Gram-Schmidt algorithm on a
+// convection-diffusion matrix with complex eigenvalues, with and without
+// restarts. the number of iterations is printed next to the one of the
+// reference such that a loss of stability for large s shows up, and the
+// solutions must agree
+
+#include "../tests.h"
+#include <deal.II/base/logstream.h>
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/dynamic_sparsity_pattern.h>
+#include <deal.II/lac/vector.h>
+#include <deal.II/lac/solver_control.h>
+#include <deal.II/lac/solver_gmres.h>
+#include <deal.II/lac/precondition.h>
+
+#include <fstream>
+#include <iomanip>
+
+
+template <typename PreconditionerType>
+void
+check (const SparseMatrix<double> &A,
+       const PreconditionerType   &preconditioner,
+       const unsigned int          basis_size)
+{
+  Vector<double> rhs (A.m()), reference (A.m()), sol (A.m());
+  for (unsigned int i=0; i<rhs.size(); ++i)
+    rhs(i) = 1. + 0.1 * (i%7);
+
+  SolverControl control (2000, 1e-10*rhs.l2_norm());
+  SolverGMRES<>::AdditionalData data (basis_size+2, true);
+  SolverGMRES<> solver_mgs (control, data);
+  const unsigned int previous_depth = deallog.depth_file(0);
+  solver_mgs.solve (A, reference, rhs, preconditioner);
+  deallog.depth_file(previous_depth);
+  const unsigned int steps_reference = control.last_step();
+
+  data.orthogonalization_strategy =
+    SolverGMRES<>::AdditionalData::classical_gram_schmidt;
+  SolverGMRES<> solver_cgs (control, data);
+  deallog.depth_file(0);
+  solver_cgs.solve (A, sol, rhs, preconditioner);
+  deallog.depth_file(previous_depth);
+  sol -= reference;
+  deallog << "CGS: " << control.last_step() << " iterations (MGS: "
+          << steps_reference << "), relative difference to MGS solution: "
+          << sol.linfty_norm() / reference.linfty_norm() << std::endl;
+
+  const unsigned int s_values[3] = { 1, 4, 8 };
+  for (unsigned int i=0; i<3; ++i)
+    {
+      sol = 0.;
+      SolverSStepGMRES<> solver
+      (control, SolverSStepGMRES<>::AdditionalData (basis_size, s_values[i]));
+      deallog.depth_file(0);
+      solver.solve (A, sol, rhs, preconditioner);
+      deallog.depth_file(previous_depth);
+      sol -= reference;
+      deallog << "s=" << s_values[i] << ": " << control.last_step()
+              << " iterations (MGS: " << steps_reference
+              << "), relative difference to MGS solution: "
+              << sol.linfty_norm() / reference.linfty_norm() << std::endl;
+    }
+}
+
+
+
+int main()
+{
+  std::ofstream logfile("output");
+  deallog << std::setprecision(4);
+  deallog.attach(logfile);
+  deallog.threshold_double(1.e-9);
+
+  // central differences for -Laplace u + beta . grad u on a grid with n x n
+  // interior points, where the cell Peclet number is larger than one such
+  // that the eigenvalues are complex
+  const unsigned int n = 24;
+  const double beta_x = 1.5, beta_y = 0.8;
+  DynamicSparsityPattern dsp (n*n, n*n);
+  for (unsigned int i=0; i<n*n; ++i)
+    {
+      dsp.add (i, i);
+      if (i%n > 0)
+        dsp.add (i, i-1);
+      if (i%n < n-1)
+        dsp.add (i, i+1);
+      if (i >= n)
+        dsp.add (i, i-n);
+      if (i+n < n*n)
+        dsp.add (i, i+n);
+    }
+  SparsityPattern structure;
+  structure.copy_from (dsp);
+  SparseMatrix<double> A (structure);
+  for (unsigned int i=0; i<n*n; ++i)
+    {
+      A.set (i, i, 4. + 0.25*(i%5));
+      if (i%n > 0)
+        A.set (i, i-1, -1.-beta_x);
+      if (i%n < n-1)
+        A.set (i, i+1, -1.+beta_x);
+      if (i >= n)
+        A.set (i, i-n, -1.-beta_y);
+      if (i+n < n*n)
+        A.set (i, i+n, -1.+beta_y);
+    }
+
+  deallog.push("Identity");
+  check (A, PreconditionIdentity(), 30);
+  check (A, PreconditionIdentity(), 12);
+  deallog.pop();
+
+  deallog.push("Jacobi");
+  PreconditionJacobi<> jacobi;
+  jacobi.initialize (A, 0.8);
+  check (A, jacobi, 30);
+  deallog.pop();
+
+  deallog.push("SSOR");
+  PreconditionSSOR<> ssor;
+  ssor.initialize (A, 1.2);
+  check (A, ssor, 30);
+  deallog.pop();
+}
@@ -0,0 +1,77 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// tests SolverSStepGMRES on a diagonal matrix with only a few distinct
+// eigenvalues, where the Krylov space becomes invariant within the first
+// block of the s-step method. the orthogonalization of the Newton basis
+// breaks down and the solver must fall back to the Arnoldi process and
+// terminate with the exact solution
+
+#include "../tests.h"
+#include <deal.II/base/logstream.h>
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/vector.h>
+#include <deal.II/lac/solver_control.h>
+#include <deal.II/lac/solver_gmres.h>
+#include <deal.II/lac/precondition.h>
+
+#include <fstream>
+#include <iomanip>
+
+
+void test (const unsigned int n_distinct,
+           const unsigned int s)
+{
+  const unsigned int n = 100;
+  SparsityPattern sp(n, n);
+  sp.compress();
+  SparseMatrix<double> matrix(sp);
+  for (unsigned int i=0; i<n; ++i)
+    matrix.diag_element(i) = 1. + (i%n_distinct);
+
+  Vector<double> rhs(n), sol(n);
+  for (unsigned int i=0; i<n; ++i)
+    rhs(i) = 1. + 0.01 * i;
+
+  SolverControl control(100, 1e-10*rhs.l2_norm());
+  SolverSStepGMRES<> solver(control,
+                            SolverSStepGMRES<>::AdditionalData(30, s));
+  check_solver_within_range (solver.solve(matrix, sol, rhs,
+                                          PreconditionIdentity()),
+                             control.last_step(), n_distinct, n_distinct+1);
+
+  Vector<double> residual(n);
+  matrix.vmult(residual, sol);
+  residual -= rhs;
+  deallog << "Residual: " << (residual.l2_norm() < 1e-8*rhs.l2_norm())
+          << std::endl;
+}
+
+
+
+int main()
+{
+  std::ofstream logfile("output");
+  deallog << std::setprecision(4);
+  deallog.attach(logfile);
+  deallog.threshold_double(1.e-10);
+
+  test(3, 2);
+  test(3, 8);
+  test(7, 4);
+  test(12, 5);
+}
@@ -0,0 +1,161 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// tests SparseAMG: checks that the hierarchy coarsens down to the requested
+// coarse size, that the coarse matrices are the Galerkin products P^T A P,
+// and that CG preconditioned by the AMG converges in few iterations for the
+// Laplacian and for a system of two coupled Laplacians with a
+// two-dimensional near null space
+
+#include "../tests.h"
+#include "../testmatrix.h"
+#include <deal.II/base/logstream.h>
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/sparse_amg.h>
+#include <deal.II/lac/dynamic_sparsity_pattern.h>
+#include <deal.II/lac/vector.h>
+#include <deal.II/lac/solver_control.h>
+#include <deal.II/lac/solver_cg.h>
+
+#include <fstream>
+#include <iomanip>
+
+
+void
+check (const SparseMatrix<double>               &A,
+       const SparseAMG<double>::AdditionalData &data,
+       const unsigned int                       min_iterations,
+       const unsigned int                       max_iterations)
+{
+  SparseAMG<double> amg;
+  amg.initialize (A, data);
+
+  deallog << "Number of levels: " << amg.n_levels() << ", sizes:";
+  for (unsigned int level=0; level<amg.n_levels(); ++level)
+    deallog << " " << amg.get_matrix(level).m();
+  deallog << std::endl;
+
+  // compare the coarse matrices with the product P^T A P applied to a
+  // vector
+  for (unsigned int level=0; level+1<amg.n_levels(); ++level)
+    {
+      const SparseMatrix<double> &P = amg.get_prolongation(level);
+      Vector<double> x (P.n()), Px (P.m()), APx (P.m()), result (P.n()),
+             reference (P.n());
+      for (unsigned int i=0; i<x.size(); ++i)
+        x(i) = (double)Testing::rand()/RAND_MAX;
+      P.vmult (Px, x);
+      amg.get_matrix(level).vmult (APx, Px);
+      P.Tvmult (reference, APx);
+      amg.get_matrix(level+1).vmult (result, x);
+      result -= reference;
+      deallog << "Galerkin error level " << level << ": "
+              << result.linfty_norm()/reference.linfty_norm() << std::endl;
+    }
+
+  Vector<double> rhs (A.m()), sol (A.m());
+  rhs = 1.;
+  SolverControl control (200, 1e-10*rhs.l2_norm());
+  SolverCG<> solver (control);
+  check_solver_within_range (solver.solve (A, sol, rhs, amg),
+                             control.last_step(), min_iterations,
+                             max_iterations);
+}
+
+
+
+int main()
+{
+  std::ofstream logfile("output");
+  deallog << std::setprecision(4);
+  deallog.attach(logfile);
+  deallog.threshold_double(1.e-12);
+
+  // the number of iterations must not grow by more than one per refinement
+  const unsigned int sizes[] = {33, 65, 129};
+  const unsigned int expected_iterations[] = {10, 11, 12};
+  for (unsigned int s=0; s<3; ++s)
+    {
+      const unsigned int size = sizes[s];
+      const unsigned int dim = (size-1)*(size-1);
+      deallog << "Laplacian of size " << dim << std::endl;
+
+      FDMatrix testproblem(size, size);
+      DynamicSparsityPattern dsp (dim, dim);
+      testproblem.five_point_structure (dsp);
+      SparsityPattern structure;
+      structure.copy_from (dsp);
+      SparseMatrix<double> A (structure);
+      testproblem.five_point (A);
+
+      SparseAMG<double>::AdditionalData data;
+      data.max_coarse_size = 50;
+      check (A, data, expected_iterations[s]-1, expected_iterations[s]+1);
+    }
+
+  // two Laplacians with interleaved unknowns, coupled by a weak symmetric
+  // term between the two components in each point. the near null space
+  // consists of the two vectors that are constant in one of the components
+  {
+    const unsigned int size = 65;
+    const unsigned int dim = (size-1)*(size-1);
+    deallog << "Coupled system of size " << 2*dim << std::endl;
+
+    FDMatrix testproblem(size, size);
+    DynamicSparsityPattern dsp_scalar (dim, dim);
+    testproblem.five_point_structure (dsp_scalar);
+    SparsityPattern structure_scalar;
+    structure_scalar.copy_from (dsp_scalar);
+    SparseMatrix<double> A_scalar (structure_scalar);
+    testproblem.five_point (A_scalar);
+
+    DynamicSparsityPattern dsp (2*dim, 2*dim);
+    for (unsigned int row=0; row<dim; ++row)
+      {
+        for (SparseMatrix<double>::const_iterator it=A_scalar.begin(row);
+             it!=A_scalar.end(row); ++it)
+          for (unsigned int c=0; c<2; ++c)
+            dsp.add (2*row+c, 2*it->column()+c);
+        dsp.add (2*row, 2*row+1);
+        dsp.add (2*row+1, 2*row);
+      }
+    SparsityPattern structure;
+    structure.copy_from (dsp);
+    SparseMatrix<double> A (structure);
+    for (unsigned int row=0; row<dim; ++row)
+      {
+        for (SparseMatrix<double>::const_iterator it=A_scalar.begin(row);
+             it!=A_scalar.end(row); ++it)
+          for (unsigned int c=0; c<2; ++c)
+            A.set (2*row+c, 2*it->column()+c, it->value());
+        A.set (2*row, 2*row+1, -0.1);
+        A.set (2*row+1, 2*row, -0.1);
+        A.add (2*row, 2*row, 0.1);
+        A.add (2*row+1, 2*row+1, 0.1);
+      }
+
+    SparseAMG<double>::AdditionalData data;
+    data.max_coarse_size = 100;
+    data.near_null_space.resize (2, Vector<double>(2*dim));
+    for (unsigned int i=0; i<dim; ++i)
+      {
+        data.near_null_space[0](2*i) = 1.;
+        data.near_null_space[1](2*i+1) = 1.;
+      }
+    check (A, data, 9, 11);
+  }
+}
@@ -0,0 +1,257 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// tests SparseLevelSchedule: checks that the rows within each level do not
+// depend on each other, that the level-scheduled SSOR, SOR, TSOR, ILU and
+// MIC preconditioners give the same result as the sequential ones, and that
+// CG with the multicolor SSOR preconditioner converges. Tested on a
+// five-point stencil and on a five-point stencil with additional random
+// entries
+
+#include "../tests.h"
+#include "../testmatrix.h"
+#include <deal.II/base/logstream.h>
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/sparse_level_schedule.h>
+#include <deal.II/lac/sparse_ilu.h>
+#include <deal.II/lac/sparse_mic.h>
+#include <deal.II/lac/dynamic_sparsity_pattern.h>
+#include <deal.II/lac/vector.h>
+#include <deal.II/lac/solver_control.h>
+#include <deal.II/lac/solver_cg.h>
+#include <deal.II/lac/precondition.h>
+
+#include <fstream>
+#include <iomanip>
+
+
+bool
+check_levels (const SparsityPattern     &sparsity,
+              const SparseLevelSchedule &schedule)
+{
+  // in each level of the forward (backward) sweep, no row may depend on
+  // another row of the same level or of a later level through the lower
+  // (upper) triangle
+  std::vector<unsigned int> forward_level (sparsity.n_rows()),
+      backward_level (sparsity.n_rows());
+  for (unsigned int l=0; l<schedule.n_forward_levels(); ++l)
+    {
+      const std::vector<types::global_dof_index> rows =
+        schedule.get_forward_level(l);
+      for (unsigned int i=0; i<rows.size(); ++i)
+        forward_level[rows[i]] = l;
+    }
+  for (unsigned int l=0; l<schedule.n_backward_levels(); ++l)
+    {
+      const std::vector<types::global_dof_index> rows =
+        schedule.get_backward_level(l);
+      for (unsigned int i=0; i<rows.size(); ++i)
+        backward_level[rows[i]] = l;
+    }
+
+  bool valid = true;
+  for (unsigned int row=0; row<sparsity.n_rows(); ++row)
+    for (SparsityPattern::iterator it=sparsity.begin(row); it!=sparsity.end(row);
+         ++it)
+      if (it->column() != row)
+        {
+          if (schedule.is_lower(row, it->column()) &&
+              forward_level[it->column()] >= forward_level[row])
+            valid = false;
+          if (!schedule.is_lower(row, it->column()) &&
+              backward_level[it->column()] >= backward_level[row])
+            valid = false;
+        }
+  return valid;
+}
+
+
+
+void
+check (const SparseMatrix<double> &A,
+       const bool                  print_levels)
+{
+  const SparsityPattern &sparsity = A.get_sparsity_pattern();
+  SparseLevelSchedule schedule (sparsity);
+  SparseLevelSchedule schedule_color (sparsity, SparseLevelSchedule::multicolor);
+  if (print_levels)
+    deallog << "Forward levels: " << schedule.n_forward_levels()
+            << ", backward levels: " << schedule.n_backward_levels()
+            << ", colors: " << schedule_color.n_forward_levels() << std::endl;
+  deallog << "Valid levels: " << check_levels (sparsity, schedule)
+          << " " << check_levels (sparsity, schedule_color) << std::endl;
+
+  Vector<double> src (A.m()), dst (A.m()), ref (A.m());
+  for (unsigned int i=0; i<A.m(); ++i)
+    src(i) = (double)Testing::rand()/RAND_MAX;
+
+  {
+    PreconditionSSOR<> ssor, ssor_level;
+    ssor.initialize (A, 1.2);
+    ssor_level.initialize (A, PreconditionSSOR<>::AdditionalData(1.2, true));
+    ssor.vmult (ref, src);
+    ssor_level.vmult (dst, src);
+    dst -= ref;
+    deallog << "Error SSOR: " << dst.linfty_norm() << std::endl;
+  }
+  {
+    PreconditionSOR<> sor, sor_level;
+    sor.initialize (A, 1.2);
+    sor_level.initialize (A, PreconditionSOR<>::AdditionalData(1.2, true));
+    sor.vmult (ref, src);
+    sor_level.vmult (dst, src);
+    dst -= ref;
+    deallog << "Error SOR: " << dst.linfty_norm() << std::endl;
+    sor.Tvmult (ref, src);
+    sor_level.Tvmult (dst, src);
+    dst -= ref;
+    deallog << "Error TSOR: " << dst.linfty_norm() << std::endl;
+  }
+  {
+    SparseILU<double> ilu, ilu_level;
+    ilu.initialize (A);
+    ilu_level.initialize (A, SparseILU<double>::AdditionalData(0, 0, false, 0,
+                                                                true));
+    ilu.vmult (ref, src);
+    ilu_level.vmult (dst, src);
+    dst -= ref;
+    deallog << "Error ILU: " << dst.linfty_norm() << std::endl;
+  }
+  {
+    SparseMIC<double> mic, mic_level;
+    mic.initialize (A);
+    mic_level.initialize (A, SparseMIC<double>::AdditionalData(0, 0, false, 0,
+                                                               true));
+    mic.vmult (ref, src);
+    mic_level.vmult (dst, src);
+    dst -= ref;
+    deallog << "Error MIC: " << dst.linfty_norm() << std::endl;
+  }
+
+  // the multicolor SSOR must be the sequential SSOR on the matrix with the
+  // rows renumbered by colors
+  {
+    std::vector<types::global_dof_index> new_index (A.m());
+    unsigned int index = 0;
+    for (unsigned int c=0; c<schedule_color.n_forward_levels(); ++c)
+      {
+        const std::vector<types::global_dof_index> rows =
+          schedule_color.get_forward_level(c);
+        for (unsigned int i=0; i<rows.size(); ++i)
+          new_index[rows[i]] = index++;
+      }
+    DynamicSparsityPattern dsp (A.m(), A.m());
+    for (unsigned int row=0; row<A.m(); ++row)
+      for (SparseMatrix<double>::const_iterator it=A.begin(row); it!=A.end(row); ++it)
+        dsp.add (new_index[row], new_index[it->column()]);
+    SparsityPattern sparsity_renumbered;
+    sparsity_renumbered.copy_from (dsp);
+    SparseMatrix<double> A_renumbered (sparsity_renumbered);
+    for (unsigned int row=0; row<A.m(); ++row)
+      for (SparseMatrix<double>::const_iterator it=A.begin(row); it!=A.end(row); ++it)
+        A_renumbered.set (new_index[row], new_index[it->column()], it->value());
+
+    Vector<double> src_renumbered (A.m()), dst_renumbered (A.m());
+    for (unsigned int i=0; i<A.m(); ++i)
+      src_renumbered(new_index[i]) = src(i);
+    PreconditionSSOR<> ssor_renumbered;
+    ssor_renumbered.initialize (A_renumbered, 1.2);
+    ssor_renumbered.vmult (dst_renumbered, src_renumbered);
+    A.precondition_SSOR (dst, src, 1.2, schedule_color);
+    for (unsigned int i=0; i<A.m(); ++i)
+      dst(i) -= dst_renumbered(new_index[i]);
+    deallog << "Error multicolor SSOR: "
+            << dst.linfty_norm()/dst_renumbered.linfty_norm() << std::endl;
+  }
+
+  {
+    Vector<double> rhs (A.m()), sol (A.m());
+    rhs = 1.;
+    SolverControl control (1000, 1e-10*rhs.l2_norm());
+    SolverCG<> solver (control);
+    PreconditionSSOR<> preconditioner;
+    preconditioner.initialize (A, PreconditionSSOR<>::AdditionalData
+                               (1.2, true, SparseLevelSchedule::multicolor));
+    check_solver_within_range (solver.solve (A, sol, rhs, preconditioner),
+                               control.last_step(), 10, 200);
+  }
+}
+
+
+
+int main()
+{
+  std::ofstream logfile("output");
+  deallog << std::setprecision(4);
+  deallog.attach(logfile);
+  deallog.threshold_double(1.e-14);
+
+  const unsigned int size = 33;
+  const unsigned int dim = (size-1)*(size-1);
+
+  FDMatrix testproblem(size, size);
+  {
+    DynamicSparsityPattern dsp (dim, dim);
+    testproblem.five_point_structure (dsp);
+    SparsityPattern structure;
+    structure.copy_from (dsp);
+    SparseMatrix<double> A (structure);
+    testproblem.five_point (A);
+
+    deallog.push("five-point");
+    check (A, true);
+    deallog.pop();
+  }
+
+  // five-point stencil plus a random number of additional entries per row,
+  // with the matrix kept symmetric and diagonally dominant
+  {
+    DynamicSparsityPattern dsp (dim, dim);
+    testproblem.five_point_structure (dsp);
+    std::vector<std::pair<unsigned int, unsigned int> > extra_entries;
+    for (unsigned int i=0; i<dim; ++i)
+      {
+        const unsigned int n_extra = Testing::rand() % 4;
+        for (unsigned int k=0; k<n_extra; ++k)
+          {
+            const unsigned int j = Testing::rand() % dim;
+            if (j != i)
+              {
+                dsp.add (i, j);
+                dsp.add (j, i);
+                extra_entries.push_back (std::make_pair(i, j));
+              }
+          }
+      }
+    SparsityPattern structure;
+    structure.copy_from (dsp);
+    SparseMatrix<double> A (structure);
+    testproblem.five_point (A);
+    for (unsigned int k=0; k<extra_entries.size(); ++k)
+      {
+        const unsigned int i = extra_entries[k].first, j = extra_entries[k].second;
+        A.add (i, j, -0.01);
+        A.add (j, i, -0.01);
+        A.add (i, i, 0.01);
+        A.add (j, j, 0.01);
+      }
+
+    deallog.push("random");
+    check (A, false);
+    deallog.pop();
+  }
+}
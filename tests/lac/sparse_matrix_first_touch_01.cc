@@ -0,0 +1,150 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+
+// checks that SparseMatrix, SparseMatrixSELL and Vector give the same results
+// whether their memory is first touched by a single thread or with the
+// partitioning of the compute loops, also for a matrix and a vector that
+// were moved from and then reinitialized
+
+#include "../tests.h"
+#include "../testmatrix.h"
+#include <deal.II/base/logstream.h>
+#include <deal.II/base/multithread_info.h>
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/sparse_matrix_sell.h>
+#include <deal.II/lac/sparsity_pattern.h>
+#include <deal.II/lac/vector.h>
+
+#include <fstream>
+
+
+struct Results
+{
+  Vector<double> vmult;
+  Vector<double> Tvmult;
+  Vector<double> residual;
+  Vector<double> sell_vmult;
+  Vector<double> add;
+  double         norm_square;
+  double         scalar_product;
+};
+
+
+
+void
+compute (const FDMatrix        &testproblem,
+         const SparsityPattern &sparsity,
+         const bool             serial_first_touch,
+         Results               &results)
+{
+  // set up the matrix and the vectors either with a single thread or with
+  // all threads, and compute with all threads
+  if (serial_first_touch)
+    MultithreadInfo::set_thread_limit (1);
+
+  // leave a moved-from matrix and a moved-from vector behind and
+  // reinitialize them
+  SparseMatrix<double> A (sparsity);
+  SparseMatrix<double> B (std::move(A));
+  A.reinit (sparsity);
+  testproblem.five_point (A, true);
+  SparseMatrixSELL<double> A_sell (A);
+
+  Vector<double> x (sparsity.n_rows());
+  Vector<double> y (std::move(x));
+  x.reinit (sparsity.n_rows(), true);
+  y.reinit (sparsity.n_rows(), true);
+  for (unsigned int i=0; i<x.size(); ++i)
+    {
+      x(i) = 1. + 0.01 * (i%13);
+      y(i) = 0.1 * (i%7);
+    }
+
+  if (serial_first_touch)
+    MultithreadInfo::set_thread_limit ();
+
+  results.vmult.reinit (x.size());
+  A.vmult (results.vmult, x);
+  results.Tvmult.reinit (x.size());
+  A.Tvmult (results.Tvmult, x);
+  results.residual.reinit (x.size());
+  A.residual (results.residual, x, y);
+  results.sell_vmult.reinit (x.size());
+  A_sell.vmult (results.sell_vmult, x);
+  results.add = x;
+  results.add.add (2., y);
+  results.norm_square = A.matrix_norm_square (x);
+  results.scalar_product = A.matrix_scalar_product (x, y);
+}
+
+
+
+void
+compare (const std::string    &name,
+         const Vector<double> &serial,
+         const Vector<double> &parallel)
+{
+  Vector<double> difference (serial);
+  difference -= parallel;
+  deallog << name << " equal: "
+          << (difference.linfty_norm() <= 1e-14 * serial.linfty_norm())
+          << std::endl;
+}
+
+
+
+void
+compare (const std::string &name,
+         const double       serial,
+         const double       parallel)
+{
+  deallog << name << " equal: "
+          << (std::abs(serial - parallel) <= 1e-14 * std::abs(serial))
+          << std::endl;
+}
+
+
+
+int main()
+{
+  std::ofstream logfile("output");
+  deallog.attach(logfile);
+  deallog.threshold_double(1.e-10);
+
+  const unsigned int size = 101;
+  const unsigned int dim = (size-1)*(size-1);
+
+  FDMatrix testproblem (size, size);
+  SparsityPattern sparsity (dim, dim, 5);
+  testproblem.five_point_structure (sparsity);
+  sparsity.compress ();
+
+  Results serial, parallel;
+  compute (testproblem, sparsity, true, serial);
+  compute (testproblem, sparsity, false, parallel);
+
+  compare ("vmult", serial.vmult, parallel.vmult);
+  compare ("Tvmult", serial.Tvmult, parallel.Tvmult);
+  compare ("residual", serial.residual, parallel.residual);
+  compare ("SELL vmult", serial.sell_vmult, parallel.sell_vmult);
+  compare ("vector add", serial.add, parallel.add);
+  compare ("matrix_norm_square", serial.norm_square, parallel.norm_square);
+  compare ("matrix_scalar_product", serial.scalar_product,
+           parallel.scalar_product);
+  compare ("vmult and SELL vmult", serial.vmult, serial.sell_vmult);
+}
@@ -0,0 +1,167 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// check SparseMatrix::mmult and SparseMatrix::Tmmult for sparse rectangular
+// matrices, first with rebuilding the sparsity pattern of the product and
+// then reusing it for a second product with changed matrix entries after
+// zeroing the product, and finally adding a product to the current entries
+
+#include "../tests.h"
+#include "../testmatrix.h"
+#include <fstream>
+#include <iomanip>
+
+#include <deal.II/base/logstream.h>
+#include <deal.II/lac/vector.h>
+#include <deal.II/lac/dynamic_sparsity_pattern.h>
+#include <deal.II/lac/sparsity_pattern.h>
+#include <deal.II/lac/sparse_matrix.h>
+
+
+void
+check_mmult (const SparseMatrix<double> &A,
+             const SparseMatrix<double> &B,
+             const SparseMatrix<double> &C,
+             const Vector<double>       &v)
+{
+  Vector<double> x(B.n()), y(C.m()), z(C.m()), tmp(B.m());
+  for (unsigned int j=0; j<x.size(); ++j)
+    x(j) = (double)Testing::rand()/RAND_MAX;
+
+  C.vmult (y, x);
+  B.vmult (tmp, x);
+  if (v.size() > 0)
+    tmp.scale (v);
+  A.vmult (z, tmp);
+
+  y -= z;
+  AssertThrow (y.l2_norm() <= 1e-12 * z.l2_norm(),
+               ExcInternalError());
+}
+
+
+
+void
+check_Tmmult (const SparseMatrix<double> &A,
+              const SparseMatrix<double> &B,
+              const SparseMatrix<double> &C,
+              const Vector<double>       &v)
+{
+  Vector<double> x(B.n()), y(C.m()), z(C.m()), tmp(B.m());
+  for (unsigned int j=0; j<x.size(); ++j)
+    x(j) = (double)Testing::rand()/RAND_MAX;
+
+  C.vmult (y, x);
+  B.vmult (tmp, x);
+  if (v.size() > 0)
+    tmp.scale (v);
+  A.Tvmult (z, tmp);
+
+  y -= z;
+  AssertThrow (y.l2_norm() <= 1e-12 * z.l2_norm(),
+               ExcInternalError());
+}
+
+
+
+void test (const unsigned int size)
+{
+  // a five-point stencil A and a random sparse rectangular matrix P with
+  // between one and three entries per row
+  const unsigned int n = (size-1)*(size-1), n_coarse = n/4;
+  FDMatrix testproblem(size, size);
+  DynamicSparsityPattern dsp (n, n);
+  testproblem.five_point_structure (dsp);
+  SparsityPattern sp_A;
+  sp_A.copy_from (dsp);
+  SparseMatrix<double> A (sp_A);
+  testproblem.five_point (A, true);
+
+  DynamicSparsityPattern dsp_P (n, n_coarse);
+  for (unsigned int i=0; i<n; ++i)
+    {
+      const unsigned int n_entries = 1 + Testing::rand() % 3;
+      for (unsigned int k=0; k<n_entries; ++k)
+        dsp_P.add (i, Testing::rand() % n_coarse);
+    }
+  SparsityPattern sp_P;
+  sp_P.copy_from (dsp_P);
+  SparseMatrix<double> P (sp_P);
+  for (unsigned int i=0; i<n; ++i)
+    for (SparseMatrix<double>::iterator it=P.begin(i); it!=P.end(i); ++it)
+      it->value() = (double)Testing::rand()/RAND_MAX;
+
+  Vector<double> v(n);
+  for (unsigned int j=0; j<n; ++j)
+    v(j) = (double)Testing::rand()/RAND_MAX;
+
+  SparsityPattern sp_AP, sp_PtAP;
+  SparseMatrix<double> AP (sp_AP), PtAP (sp_PtAP);
+  A.mmult (AP, P);
+  check_mmult (A, P, AP, Vector<double>());
+  P.Tmmult (PtAP, AP);
+  check_Tmmult (P, AP, PtAP, Vector<double>());
+  deallog << "Product patterns: " << sp_AP.n_nonzero_elements() << " "
+          << sp_PtAP.n_nonzero_elements() << std::endl;
+
+  // change the entries of the factors and recompute the products with the
+  // sparsity patterns kept
+  for (unsigned int i=0; i<n; ++i)
+    {
+      for (SparseMatrix<double>::iterator it=A.begin(i); it!=A.end(i); ++it)
+        it->value() *= 1. + (double)Testing::rand()/RAND_MAX;
+      for (SparseMatrix<double>::iterator it=P.begin(i); it!=P.end(i); ++it)
+        it->value() = (double)Testing::rand()/RAND_MAX;
+    }
+  AP = 0;
+  A.mmult (AP, P, v, false);
+  check_mmult (A, P, AP, v);
+  PtAP = 0;
+  P.Tmmult (PtAP, AP, v, false);
+  check_Tmmult (P, AP, PtAP, v);
+  deallog << "Product patterns: " << sp_AP.n_nonzero_elements() << " "
+          << sp_PtAP.n_nonzero_elements() << std::endl;
+
+  // without rebuilding the sparsity pattern, the products are added to the
+  // current entries, so computing them a second time doubles them
+  SparseMatrix<double> AP_twice (sp_AP), PtAP_twice (sp_PtAP);
+  AP_twice.copy_from (AP);
+  A.mmult (AP_twice, P, v, false);
+  AP_twice.add (-2., AP);
+  PtAP_twice.copy_from (PtAP);
+  P.Tmmult (PtAP_twice, AP, v, false);
+  PtAP_twice.add (-2., PtAP);
+  deallog << "Products added: "
+          << (AP_twice.frobenius_norm() <= 1e-12 * AP.frobenius_norm()) << " "
+          << (PtAP_twice.frobenius_norm() <= 1e-12 * PtAP.frobenius_norm())
+          << std::endl;
+
+  deallog << "OK" << std::endl;
+}
+
+
+int
+main ()
+{
+  const std::string logname = "output";
+  std::ofstream logfile(logname.c_str());
+  deallog.attach(logfile);
+  Testing::srand(3391466);
+
+  test(9);
+  test(33);
+}
@@ -0,0 +1,105 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+
+// check SparseMatrix::mmult and SparseMatrix::Tmmult with a given sparsity
+// pattern of the product that lacks some entries of the product: these
+// entries are dropped in release mode and trigger an assertion in debug
+// mode, while all entries of the pattern get the correct values
+
+#include "../tests.h"
+#include "../testmatrix.h"
+#include <fstream>
+#include <iomanip>
+
+#include <deal.II/base/logstream.h>
+#include <deal.II/lac/vector.h>
+#include <deal.II/lac/dynamic_sparsity_pattern.h>
+#include <deal.II/lac/sparsity_pattern.h>
+#include <deal.II/lac/sparse_matrix.h>
+
+
+// compare the entries of C with the ones of the product in the full
+// sparsity pattern
+void
+compare (const SparseMatrix<double> &C,
+         const SparseMatrix<double> &full_product)
+{
+  double error = 0;
+  for (unsigned int i=0; i<C.m(); ++i)
+    for (SparseMatrix<double>::const_iterator it=C.begin(i); it!=C.end(i); ++it)
+      error = std::max (error, std::abs (it->value() -
+                                         full_product.el(i, it->column())));
+  deallog << "Error on the entries of the pattern: "
+          << error / full_product.linfty_norm() << std::endl;
+}
+
+
+
+int
+main ()
+{
+  const std::string logname = "output";
+  std::ofstream logfile(logname.c_str());
+  deallog.attach(logfile);
+  deallog.threshold_double(1.e-12);
+  deal_II_exceptions::disable_abort_on_exception();
+
+  // the product of two five-point stencils is a thirteen-point stencil,
+  // which does not fit into the pattern of the five-point stencil
+  const unsigned int size = 17, n = (size-1)*(size-1);
+  FDMatrix testproblem(size, size);
+  DynamicSparsityPattern dsp (n, n);
+  testproblem.five_point_structure (dsp);
+  SparsityPattern sp_A;
+  sp_A.copy_from (dsp);
+  SparseMatrix<double> A (sp_A);
+  testproblem.five_point (A, true);
+
+  SparsityPattern sp_full;
+  SparseMatrix<double> full_product (sp_full);
+  A.mmult (full_product, A);
+  deallog << "Entries of the pattern: " << sp_A.n_nonzero_elements()
+          << ", of the product: " << sp_full.n_nonzero_elements() << std::endl;
+
+  SparseMatrix<double> C (sp_A);
+  try
+    {
+      A.mmult (C, A, Vector<double>(), false);
+      compare (C, full_product);
+    }
+  catch (std::exception &e)
+    {
+      deallog << "mmult: exception for entries outside of the pattern"
+              << std::endl;
+    }
+
+  SparsityPattern sp_full_T;
+  SparseMatrix<double> full_Tproduct (sp_full_T);
+  A.Tmmult (full_Tproduct, A);
+  C = 0;
+  try
+    {
+      A.Tmmult (C, A, Vector<double>(), false);
+      compare (C, full_Tproduct);
+    }
+  catch (std::exception &e)
+    {
+      deallog << "Tmmult: exception for entries outside of the pattern"
+              << std::endl;
+    }
+}
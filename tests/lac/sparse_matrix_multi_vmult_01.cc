@@ -0,0 +1,96 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// check SparseMatrix::multi_vmult against vmult for different numbers of
+// vectors, including more than are processed together in one sweep. The
+// results must be identical since the sums are computed in the same order
+
+#include "../tests.h"
+#include "../testmatrix.h"
+#include <deal.II/base/logstream.h>
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/dynamic_sparsity_pattern.h>
+#include <deal.II/lac/vector.h>
+
+#include <fstream>
+#include <iomanip>
+
+
+template <typename number>
+void
+check (const SparseMatrix<double> &A,
+       const unsigned int          n_vectors)
+{
+  std::vector<Vector<number> > src (n_vectors, Vector<number>(A.n())),
+      dst (n_vectors, Vector<number>(A.m()));
+  std::vector<const Vector<number> *> src_ptr (n_vectors);
+  std::vector<Vector<number> *> dst_ptr (n_vectors);
+  for (unsigned int v=0; v<n_vectors; ++v)
+    {
+      for (unsigned int i=0; i<A.n(); ++i)
+        src[v](i) = Testing::rand()/static_cast<double>(RAND_MAX) - 0.5;
+      dst[v] = 1.;
+      src_ptr[v] = &src[v];
+      dst_ptr[v] = &dst[v];
+    }
+
+  A.multi_vmult (dst_ptr, src_ptr);
+
+  bool identical = true;
+  Vector<number> reference (A.m());
+  for (unsigned int v=0; v<n_vectors; ++v)
+    {
+      A.vmult (reference, src[v]);
+      for (unsigned int i=0; i<A.m(); ++i)
+        if (reference(i) != dst[v](i))
+          identical = false;
+    }
+  deallog << "Vectors: " << n_vectors << " identical: " << identical
+          << std::endl;
+}
+
+
+
+int main()
+{
+  std::ofstream logfile("output");
+  deallog << std::setprecision(4);
+  deallog.attach(logfile);
+  deallog.threshold_double(1.e-10);
+
+  const unsigned int size = 101;
+  const unsigned int dim = (size-1)*(size-1);
+
+  FDMatrix testproblem(size, size);
+  DynamicSparsityPattern dsp (dim, dim);
+  testproblem.nine_point_structure (dsp);
+  SparsityPattern structure;
+  structure.copy_from (dsp);
+  SparseMatrix<double> A (structure);
+  testproblem.nine_point (A, true);
+
+  const unsigned int n_vectors[] = { 1, 3, 8, 13 };
+  deallog.push("double");
+  for (unsigned int i=0; i<4; ++i)
+    check<double> (A, n_vectors[i]);
+  deallog.pop();
+
+  deallog.push("float");
+  for (unsigned int i=0; i<4; ++i)
+    check<float> (A, n_vectors[i]);
+  deallog.pop();
+}
@@ -0,0 +1,171 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// compares the matrix-vector products, the Jacobi preconditioner and the
+// element access of SparseMatrixSELL against SparseMatrix for a five-point
+// stencil with additional random entries that give rows of varying length,
+// for several window sizes for the row sorting, and solves a linear system
+// with SolverCG on SparseMatrixSELL
+
+#include "../tests.h"
+#include "../testmatrix.h"
+#include <deal.II/base/logstream.h>
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/sparse_matrix_sell.h>
+#include <deal.II/lac/dynamic_sparsity_pattern.h>
+#include <deal.II/lac/vector.h>
+#include <deal.II/lac/solver_control.h>
+#include <deal.II/lac/solver_cg.h>
+#include <deal.II/lac/precondition.h>
+
+#include <fstream>
+#include <iomanip>
+
+
+template <typename number>
+void
+check (const SparseMatrix<double> &A,
+       const unsigned int          sigma)
+{
+  deallog << "Window size " << sigma << std::endl;
+  SparseMatrixSELL<number> B (A, sigma);
+
+  deallog << "Stored entries cover pattern: "
+          << (B.n_stored_elements() >= B.n_nonzero_elements() &&
+              B.n_nonzero_elements() == A.n_nonzero_elements())
+          << std::endl;
+
+  double error_el = 0;
+  for (unsigned int i=0; i<A.m(); ++i)
+    for (SparseMatrix<double>::const_iterator it=A.begin(i); it!=A.end(i); ++it)
+      error_el = std::max (error_el, std::abs(it->value() -
+                                              B.el(i, it->column())));
+  deallog << "Error el: " << error_el << std::endl;
+
+  Vector<double> src (A.n()), dst (A.m()), ref (A.m());
+  for (unsigned int i=0; i<A.n(); ++i)
+    src(i) = (double)Testing::rand()/RAND_MAX;
+
+  A.vmult (ref, src);
+  B.vmult (dst, src);
+  dst -= ref;
+  deallog << "Error vmult: " << dst.linfty_norm()/ref.linfty_norm()
+          << std::endl;
+
+  dst = 1.;
+  ref = 1.;
+  A.vmult_add (ref, src);
+  B.vmult_add (dst, src);
+  dst -= ref;
+  deallog << "Error vmult_add: " << dst.linfty_norm()/ref.linfty_norm()
+          << std::endl;
+
+  A.Tvmult (ref, src);
+  B.Tvmult (dst, src);
+  dst -= ref;
+  deallog << "Error Tvmult: " << dst.linfty_norm()/ref.linfty_norm()
+          << std::endl;
+
+  dst = 1.;
+  ref = 1.;
+  A.Tvmult_add (ref, src);
+  B.Tvmult_add (dst, src);
+  dst -= ref;
+  deallog << "Error Tvmult_add: " << dst.linfty_norm()/ref.linfty_norm()
+          << std::endl;
+
+  A.precondition_Jacobi (ref, src, 0.8);
+  B.precondition_Jacobi (dst, src, 0.8);
+  dst -= ref;
+  deallog << "Error precondition_Jacobi: "
+          << dst.linfty_norm()/ref.linfty_norm() << std::endl;
+}
+
+
+
+int main()
+{
+  std::ofstream logfile("output");
+  deallog << std::setprecision(4);
+  deallog.attach(logfile);
+
+  const unsigned int size = 33;
+  const unsigned int dim = (size-1)*(size-1);
+
+  // five-point stencil plus a random number of additional entries per row,
+  // with the matrix kept symmetric and diagonally dominant
+  FDMatrix testproblem(size, size);
+  DynamicSparsityPattern dsp (dim, dim);
+  testproblem.five_point_structure (dsp);
+  std::vector<std::pair<unsigned int, unsigned int> > extra_entries;
+  for (unsigned int i=0; i<dim; ++i)
+    {
+      const unsigned int n_extra = Testing::rand() % 8;
+      for (unsigned int k=0; k<n_extra; ++k)
+        {
+          const unsigned int j = Testing::rand() % dim;
+          if (j != i)
+            {
+              dsp.add (i, j);
+              dsp.add (j, i);
+              extra_entries.push_back (std::make_pair(i, j));
+            }
+        }
+    }
+  SparsityPattern structure;
+  structure.copy_from (dsp);
+  SparseMatrix<double> A (structure);
+  testproblem.five_point (A);
+  for (unsigned int k=0; k<extra_entries.size(); ++k)
+    {
+      const unsigned int i = extra_entries[k].first, j = extra_entries[k].second;
+      A.add (i, j, -0.01);
+      A.add (j, i, -0.01);
+      A.add (i, i, 0.01);
+      A.add (j, j, 0.01);
+    }
+
+  deallog.threshold_double(1.e-14);
+  deallog.push("double");
+  check<double> (A, 1);
+  check<double> (A, 32);
+  check<double> (A, 256);
+  deallog.pop();
+
+  deallog.threshold_double(1.e-6);
+  deallog.push("float");
+  check<float> (A, 1);
+  check<float> (A, 256);
+  deallog.pop();
+
+  // solve a linear system with the new matrix and check the residual with
+  // the original matrix
+  {
+    SparseMatrixSELL<double> B (A);
+    Vector<double> rhs (dim), sol (dim), residual (dim);
+    rhs = 1.;
+    SolverControl control (1000, 1e-10*rhs.l2_norm());
+    SolverCG<> solver (control);
+    PreconditionJacobi<SparseMatrixSELL<double> > preconditioner;
+    preconditioner.initialize (B);
+    check_solver_within_range (solver.solve (B, sol, rhs, preconditioner),
+                               control.last_step(), 40, 200);
+    A.residual (residual, sol, rhs);
+    deallog << "Residual below tolerance: "
+            << (residual.l2_norm() < 1e-9*rhs.l2_norm()) << std::endl;
+  }
+}
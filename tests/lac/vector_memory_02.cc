@@ -0,0 +1,118 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// check the statistics of GrowingVectorMemory and that alloc() returns a
+// vector of the size class of the one returned last, such that vectors of
+// different sizes do not replace each other
+
+#include "../tests.h"
+
+#include <deal.II/lac/vector_memory.h>
+#include <deal.II/lac/vector.h>
+
+#include <fstream>
+
+
+template<typename VectorType>
+void
+print_statistics()
+{
+  const typename GrowingVectorMemory<VectorType>::Statistics statistics =
+    GrowingVectorMemory<VectorType>::get_statistics();
+  deallog << "hits: " << statistics.n_hits
+          << " misses: " << statistics.n_misses
+          << " vectors: " << statistics.n_vectors
+          << " unused bytes nonzero: " << (statistics.unused_bytes > 0)
+          << " peak >= unused: "
+          << (statistics.peak_unused_bytes >= statistics.unused_bytes)
+          << std::endl;
+}
+
+
+
+template<typename VectorType>
+void
+test()
+{
+  GrowingVectorMemory<VectorType> mem;
+  print_statistics<VectorType>();
+
+  // allocate two large and three small vectors
+  std::vector<VectorType *> large(2), small(3);
+  for (unsigned int i=0; i<large.size(); ++i)
+    {
+      large[i] = mem.alloc();
+      large[i]->reinit(1000);
+    }
+  for (unsigned int i=0; i<small.size(); ++i)
+    {
+      small[i] = mem.alloc();
+      small[i]->reinit(10);
+    }
+  for (unsigned int i=0; i<large.size(); ++i)
+    mem.free(large[i]);
+  for (unsigned int i=0; i<small.size(); ++i)
+    mem.free(small[i]);
+  print_statistics<VectorType>();
+
+  // the small vectors were returned last, so the next three allocations
+  // get them, and the fourth one takes a large vector
+  for (unsigned int i=0; i<small.size(); ++i)
+    {
+      small[i] = mem.alloc();
+      deallog << "size " << small[i]->size() << std::endl;
+    }
+  VectorType *v = mem.alloc();
+  deallog << "size " << v->size() << std::endl;
+  mem.free(v);
+
+  // now a large vector was returned last
+  VectorType *w = mem.alloc();
+  deallog << "size " << w->size() << std::endl;
+  mem.free(w);
+  for (unsigned int i=0; i<small.size(); ++i)
+    mem.free(small[i]);
+  print_statistics<VectorType>();
+
+  // new vectors are created if none are available
+  large.resize(8);
+  for (unsigned int i=0; i<large.size(); ++i)
+    large[i] = mem.alloc();
+  for (unsigned int i=0; i<large.size(); ++i)
+    mem.free(large[i]);
+  print_statistics<VectorType>();
+
+  GrowingVectorMemory<VectorType>::release_unused_memory();
+  print_statistics<VectorType>();
+}
+
+
+int
+main()
+{
+  std::ofstream logfile("output");
+  deallog.attach(logfile);
+  deallog.threshold_double(1.e-10);
+
+  deallog.push("double");
+  test<Vector<double> >();
+  deallog.pop();
+
+  deallog.push("float");
+  test<Vector<float> >();
+  deallog.pop();
+}
@@ -0,0 +1,85 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+
+// check that GrowingVectorMemory reuses vectors that are allocated on one
+// thread and freed on another one, rather than creating a new vector for
+// every allocation
+
+#include "../tests.h"
+
+#include <deal.II/base/thread_management.h>
+#include <deal.II/lac/vector_memory.h>
+#include <deal.II/lac/vector.h>
+
+#include <fstream>
+
+
+template<typename VectorType>
+void
+free_vector (GrowingVectorMemory<VectorType> &mem,
+             VectorType                      *v)
+{
+  mem.free (v);
+}
+
+
+
+template<typename VectorType>
+void
+test()
+{
+  GrowingVectorMemory<VectorType> mem;
+
+  for (unsigned int i=0; i<10; ++i)
+    {
+      VectorType *v = mem.alloc();
+      v->reinit(100);
+      Threads::Thread<void> t = Threads::new_thread (&free_vector<VectorType>,
+                                                     mem, v);
+      t.join();
+    }
+
+  const typename GrowingVectorMemory<VectorType>::Statistics statistics =
+    GrowingVectorMemory<VectorType>::get_statistics();
+  deallog << "hits: " << statistics.n_hits
+          << " misses: " << statistics.n_misses
+          << " vectors: " << statistics.n_vectors
+          << std::endl;
+
+  GrowingVectorMemory<VectorType>::release_unused_memory();
+  deallog << "vectors after release: "
+          << GrowingVectorMemory<VectorType>::get_statistics().n_vectors
+          << std::endl;
+}
+
+
+int
+main()
+{
+  std::ofstream logfile("output");
+  deallog.attach(logfile);
+  deallog.threshold_double(1.e-10);
+
+  deallog.push("double");
+  test<Vector<double> >();
+  deallog.pop();
+
+  deallog.push("float");
+  test<Vector<float> >();
+  deallog.pop();
+}
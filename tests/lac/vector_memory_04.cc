@@ -0,0 +1,73 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+
+// check that GrowingVectorMemory detects vectors that are freed twice or
+// that were allocated by another memory object
+
+#include "../tests.h"
+
+#include <deal.II/base/exceptions.h>
+#include <deal.II/lac/vector_memory.h>
+#include <deal.II/lac/vector.h>
+
+#include <fstream>
+
+
+template<typename VectorType>
+void
+test()
+{
+  GrowingVectorMemory<VectorType> mem, other_mem;
+
+  VectorType *v = mem.alloc();
+  VectorType *w = mem.alloc();
+  mem.free (v);
+  try
+    {
+      mem.free (v);
+    }
+  catch (ExceptionBase &e)
+    {
+      deallog << "Exception: " << e.get_exc_name() << std::endl;
+    }
+
+  VectorType *u = other_mem.alloc();
+  try
+    {
+      mem.free (u);
+    }
+  catch (ExceptionBase &e)
+    {
+      deallog << "Exception: " << e.get_exc_name() << std::endl;
+    }
+  other_mem.free (u);
+  mem.free (w);
+  deallog << "OK" << std::endl;
+}
+
+
+int
+main()
+{
+  std::ofstream logfile("output");
+  deallog.attach(logfile);
+  deallog.threshold_double(1.e-10);
+  deal_II_exceptions::disable_abort_on_exception();
+
+  test<Vector<double> >();
+}
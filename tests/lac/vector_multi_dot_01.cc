@@ -0,0 +1,89 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2012 - 2015 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+// check that Vector::multi_dot gives the same results as the individual
+// inner products and that Vector::multi_add gives the same vector as
+// several calls to Vector::add, for vector sizes above and below the
+// thresholds for recursive summation and for parallelization
+
+#include "../tests.h"
+#include <deal.II/base/logstream.h>
+#include <deal.II/lac/vector.h>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+
+
+
+
+template <typename number>
+void check ()
+{
+  const unsigned int sizes[] = {17, 1118, 10007, 200003};
+  for (unsigned int test=0; test<4; ++test)
+    for (unsigned int n_vectors=1; n_vectors<8; n_vectors+=3)
+      {
+        const unsigned int size = sizes[test];
+        Vector<number> v (size);
+        for (unsigned int i=0; i<size; ++i)
+          v(i) = 0.1 + 0.005 * i;
+
+        std::vector<Vector<number> > w (n_vectors, Vector<number>(size));
+        std::vector<const Vector<number> *> w_ptr (n_vectors);
+        std::vector<number> factors (n_vectors);
+        for (unsigned int k=0; k<n_vectors; ++k)
+          {
+            for (unsigned int i=0; i<size; ++i)
+              w[k](i) = 3.14159 + 2.7183/(1.+i+k) - 0.01 * k;
+            w_ptr[k] = &w[k];
+            factors[k] = 0.01432 * (1.+k);
+          }
+
+        std::vector<number> products (n_vectors);
+        v.multi_dot (w_ptr, products);
+        bool identical = true;
+        for (unsigned int k=0; k<n_vectors; ++k)
+          if (products[k] != v * w[k])
+            identical = false;
+
+        Vector<number> check (v);
+        for (unsigned int k=0; k<n_vectors; ++k)
+          check.add (factors[k], w[k]);
+        v.multi_add (factors, w_ptr);
+        check -= v;
+
+        deallog << "Size " << size << ", " << n_vectors << " vectors: "
+                << "multi_dot identical: " << identical
+                << ", multi_add difference: "
+                << (check.linfty_norm() < 1e3 * std::numeric_limits<number>::epsilon()
+                    * v.linfty_norm())
+                << std::endl;
+      }
+}
+
+
+int main()
+{
+  std::ofstream logfile("output");
+  deallog << std::setprecision(2);
+  deallog.attach(logfile);
+  deallog.threshold_double(1.e-10);
+
+  check<float>();
+  check<double>();
+  deallog << "OK" << std::endl;
+}
@@ -0,0 +1,279 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// tests MatrixFreeOperators::Base::vmult with operations before and after
+// the cell loop (which uses the respective variant of MatrixFree::cell_loop)
+// on a mesh with hanging nodes and Dirichlet boundary conditions: checks that
+// each vector entry is visited exactly once by both operations in the right
+// order and that the result matches the plain vmult, and compares SolverCG
+// and PreconditionChebyshev, which merge their vector updates into the
+// matrix-vector product in that case, with the plain implementations
+
+#include "../tests.h"
+
+#include <deal.II/base/logstream.h>
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/function.h>
+#include <deal.II/grid/tria.h>
+#include <deal.II/grid/grid_generator.h>
+#include <deal.II/dofs/dof_tools.h>
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/lac/constraint_matrix.h>
+#include <deal.II/lac/la_parallel_vector.h>
+#include <deal.II/lac/precondition.h>
+#include <deal.II/lac/solver_cg.h>
+#include <deal.II/matrix_free/operators.h>
+#include <deal.II/fe/fe_q.h>
+#include <deal.II/numerics/vector_tools.h>
+
+#include <iostream>
+
+std::ofstream logfile("output");
+
+
+
+// wrapper around the matrix-free operator that only exposes the plain
+// vmult, which makes the solvers use their standard implementation
+template <typename OperatorType>
+class PlainOperator : public Subscriptor
+{
+public:
+  PlainOperator (const OperatorType &op)
+    :
+    op (op)
+  {}
+
+  template <typename VectorType>
+  void vmult (VectorType &dst, const VectorType &src) const
+  {
+    op.vmult(dst, src);
+  }
+
+  types::global_dof_index m () const
+  {
+    return op.m();
+  }
+
+  double el (const unsigned int row, const unsigned int col) const
+  {
+    return op.el(row, col);
+  }
+
+private:
+  const OperatorType &op;
+};
+
+
+
+class OperationCounter
+{
+public:
+  OperationCounter (const unsigned int size)
+    :
+    n_before (size, 0),
+    n_after (size, 0),
+    n_errors (0)
+  {}
+
+  void before (const unsigned int begin, const unsigned int end)
+  {
+    for (unsigned int i=begin; i<end; ++i)
+      {
+        if (n_after[i] != 0)
+          ++n_errors;
+        ++n_before[i];
+      }
+  }
+
+  void after (const unsigned int begin, const unsigned int end)
+  {
+    for (unsigned int i=begin; i<end; ++i)
+      {
+        if (n_before[i] != 1)
+          ++n_errors;
+        ++n_after[i];
+      }
+  }
+
+  unsigned int count_errors () const
+  {
+    unsigned int errors = n_errors;
+    for (unsigned int i=0; i<n_before.size(); ++i)
+      if (n_before[i] != 1 || n_after[i] != 1)
+        ++errors;
+    return errors;
+  }
+
+private:
+  std::vector<unsigned int> n_before;
+  std::vector<unsigned int> n_after;
+  unsigned int n_errors;
+};
+
+
+
+template <int dim, int fe_degree>
+void test (const unsigned int n_refinements)
+{
+  typedef double number;
+  typedef LinearAlgebra::distributed::Vector<number> VectorType;
+
+  Triangulation<dim> tria;
+  GridGenerator::hyper_cube (tria);
+  tria.refine_global(n_refinements);
+  typename Triangulation<dim>::active_cell_iterator
+  cell = tria.begin_active (),
+  endc = tria.end();
+  for (; cell!=endc; ++cell)
+    if (cell->center().norm()<0.3)
+      cell->set_refine_flag();
+  tria.execute_coarsening_and_refinement();
+
+  FE_Q<dim> fe (fe_degree);
+  DoFHandler<dim> dof (tria);
+  dof.distribute_dofs(fe);
+  ConstraintMatrix constraints;
+  DoFTools::make_hanging_node_constraints(dof, constraints);
+  VectorTools::interpolate_boundary_values (dof, 0, ZeroFunction<dim>(),
+                                            constraints);
+  constraints.close();
+
+  deallog << "Testing " << fe.get_name() << std::endl;
+
+  std_cxx11::shared_ptr<MatrixFree<dim,number> > mf_data(new MatrixFree<dim,number> ());
+  {
+    typename MatrixFree<dim,number>::AdditionalData data;
+    data.tasks_parallel_scheme = MatrixFree<dim,number>::AdditionalData::none;
+    mf_data->reinit (dof, constraints, QGauss<1>(fe_degree+1), data);
+  }
+
+  typedef MatrixFreeOperators::LaplaceOperator<dim,fe_degree,fe_degree+1,1,number> OperatorType;
+  OperatorType mf;
+  mf.initialize(mf_data);
+  mf.compute_diagonal();
+  PlainOperator<OperatorType> plain (mf);
+
+  VectorType in, out, ref;
+  mf_data->initialize_dof_vector (in);
+  out.reinit (in);
+  ref.reinit (in);
+  for (unsigned int i=0; i<in.local_size(); ++i)
+    if (!constraints.is_constrained(i))
+      in.local_element(i) = (double)Testing::rand()/RAND_MAX;
+
+  // matrix-vector product with operations
+  mf.vmult (ref, in);
+  out = 1.;
+  OperationCounter counter (in.local_size());
+  mf.vmult (out, in,
+            std_cxx11::bind(&OperationCounter::before, &counter,
+                            std_cxx11::_1, std_cxx11::_2),
+            std_cxx11::bind(&OperationCounter::after, &counter,
+                            std_cxx11::_1, std_cxx11::_2));
+  deallog << "Number of errors in operations: " << counter.count_errors()
+          << std::endl;
+  out -= ref;
+  deallog << "Error vmult with operations: " << out.linfty_norm()/ref.linfty_norm()
+          << std::endl;
+
+  // conjugate gradient with Jacobi preconditioner and without
+  // preconditioner
+  VectorType sol (in), sol_ref (in);
+  {
+    SolverControl control (2000, 1e-10*in.l2_norm());
+    typename SolverCG<VectorType>::AdditionalData solver_data;
+    solver_data.merge_vector_operations = true;
+    SolverCG<VectorType> solver (control, solver_data);
+    sol = 0;
+    solver.solve (mf, sol, in, *mf.get_matrix_diagonal_inverse());
+    const unsigned int n_iterations = control.last_step();
+    sol_ref = 0;
+    solver.solve (plain, sol_ref, in, *mf.get_matrix_diagonal_inverse());
+    deallog << "CG iterations Jacobi merged/plain: " << n_iterations << " "
+            << control.last_step() << std::endl;
+    sol -= sol_ref;
+    deallog << "Error CG Jacobi: " << sol.linfty_norm()/sol_ref.linfty_norm()
+            << std::endl;
+
+    sol = 0;
+    solver.solve (mf, sol, in, PreconditionIdentity());
+    const unsigned int n_iterations_id = control.last_step();
+    sol_ref = 0;
+    solver.solve (plain, sol_ref, in, PreconditionIdentity());
+    deallog << "CG iterations identity merged/plain: " << n_iterations_id
+            << " " << control.last_step() << std::endl;
+    sol -= sol_ref;
+    deallog << "Error CG identity: " << sol.linfty_norm()/sol_ref.linfty_norm()
+            << std::endl;
+  }
+
+  // Chebyshev iteration with the eigenvalue estimate given explicitly
+  {
+    typedef PreconditionChebyshev<OperatorType,VectorType> ChebyshevType;
+    typename ChebyshevType::AdditionalData data;
+    data.degree = 4;
+    data.smoothing_range = 20.;
+    data.eig_cg_n_iterations = 0;
+    data.max_eigenvalue = 2.;
+    data.preconditioner = mf.get_matrix_diagonal_inverse();
+    ChebyshevType chebyshev;
+    chebyshev.initialize (mf, data);
+
+    typedef PreconditionChebyshev<PlainOperator<OperatorType>,VectorType> ChebyshevRefType;
+    typename ChebyshevRefType::AdditionalData data_ref;
+    data_ref.degree = data.degree;
+    data_ref.smoothing_range = data.smoothing_range;
+    data_ref.eig_cg_n_iterations = data.eig_cg_n_iterations;
+    data_ref.max_eigenvalue = data.max_eigenvalue;
+    data_ref.preconditioner = data.preconditioner;
+    ChebyshevRefType chebyshev_ref;
+    chebyshev_ref.initialize (plain, data_ref);
+
+    chebyshev.vmult (sol, in);
+    chebyshev_ref.vmult (sol_ref, in);
+    sol -= sol_ref;
+    deallog << "Error Chebyshev vmult: " << sol.linfty_norm()/sol_ref.linfty_norm()
+            << std::endl;
+
+    sol = sol_ref;
+    chebyshev.step (sol, in);
+    chebyshev_ref.step (sol_ref, in);
+    sol -= sol_ref;
+    deallog << "Error Chebyshev step: " << sol.linfty_norm()/sol_ref.linfty_norm()
+            << std::endl << std::endl;
+  }
+}
+
+
+
+int main ()
+{
+  deallog.attach(logfile);
+  deallog.depth_file(2);
+  deallog.threshold_double(1.e-12);
+
+  {
+    deallog.push("2d");
+    test<2,1>(6);
+    test<2,3>(4);
+    deallog.pop();
+    deallog.push("3d");
+    test<3,1>(4);
+    test<3,2>(3);
+    deallog.pop();
+  }
+}
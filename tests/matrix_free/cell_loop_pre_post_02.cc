@@ -0,0 +1,194 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// tests MatrixFree::cell_loop with operations before and after the loop
+// after MatrixFree::renumber_dofs: the operation before the loop fills the
+// source vector and the operation after the loop copies the result, so the
+// result is only correct if the ranges of both operations are set up for
+// the renumbered indices
+
+#include "../tests.h"
+
+#include <deal.II/base/logstream.h>
+#include <deal.II/base/quadrature_lib.h>
+#include <deal.II/grid/tria.h>
+#include <deal.II/grid/grid_generator.h>
+#include <deal.II/dofs/dof_tools.h>
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/lac/constraint_matrix.h>
+#include <deal.II/lac/la_parallel_vector.h>
+#include <deal.II/matrix_free/matrix_free.h>
+#include <deal.II/matrix_free/fe_evaluation.h>
+#include <deal.II/fe/fe_q.h>
+
+#include <iostream>
+
+std::ofstream logfile("output");
+
+
+typedef LinearAlgebra::distributed::Vector<double> VectorType;
+
+
+template <int dim, int fe_degree>
+void
+cell_operation (const MatrixFree<dim,double>               &data,
+                VectorType                                 &dst,
+                const VectorType                           &src,
+                const std::pair<unsigned int,unsigned int> &cell_range)
+{
+  FEEvaluation<dim,fe_degree,fe_degree+1,1,double> phi (data);
+  for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+    {
+      phi.reinit (cell);
+      phi.read_dof_values (src);
+      phi.evaluate (false, true, false);
+      for (unsigned int q=0; q<phi.n_q_points; ++q)
+        phi.submit_gradient (phi.get_gradient(q), q);
+      phi.integrate (false, true);
+      phi.distribute_local_to_global (dst);
+    }
+}
+
+
+
+// fills the source vector before the loop and moves the result out of the
+// destination vector after the loop
+class PrePostOperations
+{
+public:
+  PrePostOperations (const VectorType &src_values,
+                     VectorType       &src,
+                     VectorType       &dst,
+                     VectorType       &result)
+    :
+    src_values (src_values),
+    src (src),
+    dst (dst),
+    result (result)
+  {}
+
+  void before (const unsigned int begin, const unsigned int end)
+  {
+    for (unsigned int i=begin; i<end; ++i)
+      src.local_element(i) = src_values.local_element(i);
+  }
+
+  void after (const unsigned int begin, const unsigned int end)
+  {
+    for (unsigned int i=begin; i<end; ++i)
+      {
+        result.local_element(i) = dst.local_element(i);
+        dst.local_element(i) = 0.;
+      }
+  }
+
+private:
+  const VectorType &src_values;
+  VectorType       &src;
+  VectorType       &dst;
+  VectorType       &result;
+};
+
+
+
+template <int dim, int fe_degree>
+void test (const unsigned int n_refinements)
+{
+  Triangulation<dim> tria;
+  GridGenerator::hyper_cube (tria);
+  tria.refine_global(n_refinements);
+  typename Triangulation<dim>::active_cell_iterator
+  cell = tria.begin_active (),
+  endc = tria.end();
+  for (; cell!=endc; ++cell)
+    if (cell->center().norm()<0.3)
+      cell->set_refine_flag();
+  tria.execute_coarsening_and_refinement();
+
+  FE_Q<dim> fe (fe_degree);
+  DoFHandler<dim> dof (tria);
+  dof.distribute_dofs(fe);
+  ConstraintMatrix constraints;
+  DoFTools::make_hanging_node_constraints(dof, constraints);
+  constraints.close();
+
+  deallog << "Testing " << fe.get_name() << std::endl;
+
+  MatrixFree<dim,double> mf_data;
+  {
+    typename MatrixFree<dim,double>::AdditionalData data;
+    data.tasks_parallel_scheme = MatrixFree<dim,double>::AdditionalData::none;
+    mf_data.reinit (dof, constraints, QGauss<1>(fe_degree+1), data);
+  }
+
+  VectorType src, ref;
+  mf_data.initialize_dof_vector (src);
+  ref.reinit (src);
+  for (unsigned int i=0; i<src.local_size(); ++i)
+    if (!constraints.is_constrained(i))
+      src.local_element(i) = (double)Testing::rand()/RAND_MAX;
+  mf_data.cell_loop (&cell_operation<dim,fe_degree>, ref, src);
+
+  std::vector<types::global_dof_index> renumbering;
+  mf_data.renumber_dofs (renumbering);
+
+  VectorType src_renumbered (src), src_work (src), dst (src), result (src);
+  for (unsigned int i=0; i<src.local_size(); ++i)
+    src_renumbered.local_element(renumbering[i]) = src.local_element(i);
+
+  // entries read before they are set or copied before they are final
+  // show up in the result
+  src_work = 1e10;
+  dst = 0.;
+  result = 0.;
+  PrePostOperations operations (src_renumbered, src_work, dst, result);
+  mf_data.cell_loop (&cell_operation<dim,fe_degree>, dst, src_work,
+                     std_cxx11::bind(&PrePostOperations::before, &operations,
+                                     std_cxx11::_1, std_cxx11::_2),
+                     std_cxx11::bind(&PrePostOperations::after, &operations,
+                                     std_cxx11::_1, std_cxx11::_2));
+
+  deallog << "Number of chunks in cell loop: "
+          << (mf_data.get_dof_info().cell_loop_chunks.size() > 2 ? "> 1" : "1")
+          << std::endl;
+  deallog << "Destination cleared by operation after loop: "
+          << (dst.linfty_norm() == 0.) << std::endl;
+  for (unsigned int i=0; i<src.local_size(); ++i)
+    dst.local_element(i) = result.local_element(renumbering[i]);
+  dst -= ref;
+  deallog << "Error after renumbering: " << dst.linfty_norm()/ref.linfty_norm()
+          << std::endl;
+}
+
+
+
+int main ()
+{
+  deallog.attach(logfile);
+  deallog.threshold_double(1.e-12);
+
+  {
+    deallog.push("2d");
+    test<2,1>(6);
+    test<2,2>(5);
+    deallog.pop();
+    deallog.push("3d");
+    test<3,1>(4);
+    test<3,2>(3);
+    deallog.pop();
+  }
+}
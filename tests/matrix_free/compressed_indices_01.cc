@@ -0,0 +1,165 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// tests the compressed storage of the indices in DoFInfo for FE_DGQ: With the
+// cell-wise numbering of DoFHandler, the indices of all full macro cells are
+// stored as contiguous ranges per lane, after MatrixFree::renumber_dofs in the
+// interleaved format. Compares the result of a mass plus Laplace operator
+// against the operator evaluated on the uncompressed indices
+
+#include "../tests.h"
+
+#include <deal.II/base/quadrature_lib.h>
+#include <deal.II/grid/tria.h>
+#include <deal.II/grid/grid_generator.h>
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/fe/fe_dgq.h>
+#include <deal.II/lac/constraint_matrix.h>
+#include <deal.II/lac/vector.h>
+#include <deal.II/matrix_free/matrix_free.h>
+#include <deal.II/matrix_free/fe_evaluation.h>
+
+#include <fstream>
+#include <iostream>
+
+
+std::ofstream logfile("output");
+
+template <int dim, int fe_degree, typename Number>
+void
+cell_operation (const MatrixFree<dim,Number>                &data,
+                Vector<Number>                              &dst,
+                const Vector<Number>                        &src,
+                const std::pair<unsigned int,unsigned int>  &cell_range)
+{
+  FEEvaluation<dim,fe_degree,fe_degree+1,1,Number> phi (data);
+  for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+    {
+      phi.reinit (cell);
+      phi.read_dof_values (src);
+      phi.evaluate (true, true, false);
+      for (unsigned int q=0; q<phi.n_q_points; ++q)
+        {
+          phi.submit_value (phi.get_value(q), q);
+          phi.submit_gradient (phi.get_gradient(q), q);
+        }
+      phi.integrate (true, true);
+      phi.distribute_local_to_global (dst);
+    }
+}
+
+
+
+template <int dim>
+unsigned int
+count_cells (const MatrixFree<dim,double> &mf_data,
+             const unsigned char           variant)
+{
+  const internal::MatrixFreeFunctions::DoFInfo &dof_info =
+    mf_data.get_dof_info();
+  unsigned int count = 0;
+  for (unsigned int cell=0; cell<mf_data.n_macro_cells(); ++cell)
+    if (dof_info.row_starts[cell][2] == 0 &&
+        dof_info.index_storage_variants[cell] == variant)
+      ++count;
+  return count;
+}
+
+
+
+template <int dim, int fe_degree>
+void test ()
+{
+  typedef internal::MatrixFreeFunctions::DoFInfo DoFInfo;
+
+  Triangulation<dim> tria;
+  GridGenerator::hyper_cube (tria);
+  tria.refine_global (5-dim);
+  tria.begin_active()->set_refine_flag();
+  tria.execute_coarsening_and_refinement();
+
+  FE_DGQ<dim> fe (fe_degree);
+  DoFHandler<dim> dof (tria);
+  dof.distribute_dofs (fe);
+  deallog << "Testing " << fe.get_name() << std::endl;
+
+  ConstraintMatrix constraints;
+  constraints.close ();
+
+  const QGauss<1> quad (fe_degree+1);
+  MatrixFree<dim,double> mf_data, mf_data_full;
+  mf_data.reinit (dof, constraints, quad);
+  mf_data_full.reinit (dof, constraints, quad);
+  const_cast<DoFInfo &>(mf_data_full.get_dof_info()).uncompress_indices();
+
+  unsigned int n_regular = 0;
+  for (unsigned int cell=0; cell<mf_data.n_macro_cells(); ++cell)
+    if (mf_data.get_dof_info().row_starts[cell][2] == 0)
+      ++n_regular;
+  deallog << "Full macro cells with compressed indices: "
+          << (count_cells (mf_data, DoFInfo::contiguous) +
+              count_cells (mf_data, DoFInfo::interleaved) == n_regular)
+          << std::endl;
+  deallog << "Compressed indices uncompressed: "
+          << (count_cells (mf_data_full, DoFInfo::full) == n_regular)
+          << std::endl;
+
+  Vector<double> src (dof.n_dofs()), dst (dof.n_dofs()), ref (dof.n_dofs());
+  for (unsigned int i=0; i<dof.n_dofs(); ++i)
+    src(i) = Testing::rand()/(double)RAND_MAX;
+
+  mf_data.cell_loop (&cell_operation<dim,fe_degree,double>, dst, src);
+  mf_data_full.cell_loop (&cell_operation<dim,fe_degree,double>, ref, src);
+  dst -= ref;
+  deallog << "Error compressed indices: " << dst.linfty_norm() << std::endl;
+
+  // renumber the degrees of freedom in the order they are accessed by the
+  // cell loop, which makes the indices of the full macro cells interleaved
+  std::vector<types::global_dof_index> renumbering;
+  mf_data.renumber_dofs (renumbering);
+  deallog << "Full macro cells interleaved after renumbering: "
+          << (count_cells (mf_data, DoFInfo::interleaved) == n_regular)
+          << std::endl;
+
+  Vector<double> src_renumbered (dof.n_dofs()), dst_renumbered (dof.n_dofs());
+  for (unsigned int i=0; i<dof.n_dofs(); ++i)
+    src_renumbered(renumbering[i]) = src(i);
+  mf_data.cell_loop (&cell_operation<dim,fe_degree,double>, dst_renumbered,
+                     src_renumbered);
+  for (unsigned int i=0; i<dof.n_dofs(); ++i)
+    dst(i) = dst_renumbered(renumbering[i]) - ref(i);
+  deallog << "Error interleaved indices: " << dst.linfty_norm() << std::endl;
+}
+
+
+
+int main ()
+{
+  deallog.attach(logfile);
+  deallog.threshold_double(1.e-12);
+
+  {
+    deallog.push("2d");
+    test<2,1>();
+    test<2,3>();
+    deallog.pop();
+    deallog.push("3d");
+    test<3,1>();
+    test<3,2>();
+    deallog.pop();
+  }
+}
@@ -0,0 +1,175 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// tests MatrixFreeTools::compute_diagonal and MatrixFreeTools::compute_matrix
+// for the Laplacian with a variable coefficient on a mesh with hanging nodes
+// and Dirichlet boundary conditions by comparing with a sparse matrix
+// assembled with FEValues
+
+#include "../tests.h"
+
+#include <deal.II/base/logstream.h>
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/function.h>
+#include <deal.II/grid/tria.h>
+#include <deal.II/grid/grid_generator.h>
+#include <deal.II/dofs/dof_tools.h>
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/lac/constraint_matrix.h>
+#include <deal.II/lac/dynamic_sparsity_pattern.h>
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/matrix_free/tools.h>
+#include <deal.II/fe/fe_q.h>
+#include <deal.II/fe/fe_values.h>
+#include <deal.II/numerics/vector_tools.h>
+
+#include <iostream>
+
+std::ofstream logfile("output");
+
+
+
+template <int dim, int fe_degree>
+void local_laplace (FEEvaluation<dim,fe_degree> &phi)
+{
+  phi.evaluate (false, true);
+  for (unsigned int q=0; q<phi.n_q_points; ++q)
+    {
+      const Point<dim,VectorizedArray<double> > p = phi.quadrature_point(q);
+      phi.submit_gradient ((make_vectorized_array(1.) + p[0]*p[0]) *
+                           phi.get_gradient(q), q);
+    }
+  phi.integrate (false, true);
+}
+
+
+
+template <int dim, int fe_degree>
+void test ()
+{
+  Triangulation<dim> tria;
+  GridGenerator::hyper_cube (tria);
+  tria.refine_global(1);
+  typename Triangulation<dim>::active_cell_iterator
+  cell = tria.begin_active (),
+  endc = tria.end();
+  for (; cell!=endc; ++cell)
+    if (cell->center().norm()<0.2)
+      cell->set_refine_flag();
+  tria.execute_coarsening_and_refinement();
+  tria.begin_active()->set_refine_flag();
+  tria.last()->set_refine_flag();
+  tria.execute_coarsening_and_refinement();
+
+  FE_Q<dim> fe (fe_degree);
+  DoFHandler<dim> dof (tria);
+  dof.distribute_dofs(fe);
+  ConstraintMatrix constraints;
+  DoFTools::make_hanging_node_constraints(dof, constraints);
+  VectorTools::interpolate_boundary_values (dof, 0, ZeroFunction<dim>(),
+                                            constraints);
+  constraints.close();
+
+  deallog << "Testing " << fe.get_name() << std::endl;
+
+  MatrixFree<dim,double> mf_data;
+  {
+    typename MatrixFree<dim,double>::AdditionalData data;
+    data.tasks_parallel_scheme = MatrixFree<dim,double>::AdditionalData::none;
+    data.mapping_update_flags = update_gradients | update_JxW_values |
+                                update_quadrature_points;
+    mf_data.reinit (dof, constraints, QGauss<1>(fe_degree+1), data);
+  }
+
+  SparsityPattern sparsity;
+  {
+    DynamicSparsityPattern dsp (dof.n_dofs(), dof.n_dofs());
+    DoFTools::make_sparsity_pattern (dof, dsp, constraints, false);
+    sparsity.copy_from (dsp);
+  }
+  SparseMatrix<double> ref_matrix (sparsity), matrix (sparsity);
+
+  {
+    const QGauss<dim> quadrature (fe_degree+1);
+    FEValues<dim> fe_values (fe, quadrature, update_gradients | update_JxW_values |
+                             update_quadrature_points);
+    const unsigned int dofs_per_cell = fe.dofs_per_cell;
+    FullMatrix<double> cell_matrix (dofs_per_cell, dofs_per_cell);
+    std::vector<types::global_dof_index> local_dof_indices (dofs_per_cell);
+    for (typename DoFHandler<dim>::active_cell_iterator cell=dof.begin_active();
+         cell != dof.end(); ++cell)
+      {
+        cell_matrix = 0;
+        fe_values.reinit (cell);
+        for (unsigned int q=0; q<quadrature.size(); ++q)
+          {
+            const double coefficient = 1. + fe_values.quadrature_point(q)[0] *
+                                       fe_values.quadrature_point(q)[0];
+            for (unsigned int i=0; i<dofs_per_cell; ++i)
+              for (unsigned int j=0; j<dofs_per_cell; ++j)
+                cell_matrix(i,j) += (coefficient * fe_values.shape_grad(i,q) *
+                                     fe_values.shape_grad(j,q) *
+                                     fe_values.JxW(q));
+          }
+        cell->get_dof_indices (local_dof_indices);
+        constraints.distribute_local_to_global (cell_matrix, local_dof_indices,
+                                                ref_matrix);
+      }
+  }
+
+  MatrixFreeTools::compute_matrix<dim,fe_degree,fe_degree+1,1,double>
+  (mf_data, constraints, matrix, &local_laplace<dim,fe_degree>);
+  const double ref_norm = ref_matrix.frobenius_norm();
+  matrix.add (-1., ref_matrix);
+  deallog << "Error matrix: " << matrix.frobenius_norm() / ref_norm
+          << std::endl;
+
+  LinearAlgebra::distributed::Vector<double> diagonal;
+  MatrixFreeTools::compute_diagonal<dim,fe_degree,fe_degree+1,1,double>
+  (mf_data, constraints, diagonal, &local_laplace<dim,fe_degree>);
+  double error = 0, error_constrained = 0;
+  for (unsigned int i=0; i<dof.n_dofs(); ++i)
+    if (constraints.is_constrained(i))
+      error_constrained = std::max(error_constrained,
+                                   std::abs(diagonal(i) - 1.));
+    else
+      error = std::max(error, std::abs(diagonal(i) - ref_matrix.diag_element(i)) /
+                       ref_matrix.diag_element(i));
+  deallog << "Error diagonal: " << error << std::endl;
+  deallog << "Error diagonal constrained entries: " << error_constrained
+          << std::endl << std::endl;
+}
+
+
+
+int main ()
+{
+  deallog.attach(logfile);
+  deallog.threshold_double(1.e-12);
+
+  {
+    deallog.push("2d");
+    test<2,1>();
+    test<2,2>();
+    test<2,4>();
+    deallog.pop();
+    deallog.push("3d");
+    test<3,1>();
+    test<3,2>();
+    deallog.pop();
+  }
+}
@@ -0,0 +1,184 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// tests DoFRenumbering::matrix_free_data_locality: after the renumbering, the
+// cell loop of MatrixFree must access the degrees of freedom in ascending
+// order when going through the batches of cells, and the result of a matrix-
+// vector product must be the same as with the original numbering (up to the
+// permutation). Tested for FE_Q with hanging node constraints and for FE_DGQ
+
+#include "../tests.h"
+
+#include <deal.II/base/quadrature_lib.h>
+#include <deal.II/grid/tria.h>
+#include <deal.II/grid/grid_generator.h>
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/dofs/dof_renumbering.h>
+#include <deal.II/dofs/dof_tools.h>
+#include <deal.II/fe/fe_q.h>
+#include <deal.II/fe/fe_dgq.h>
+#include <deal.II/lac/constraint_matrix.h>
+#include <deal.II/lac/vector.h>
+#include <deal.II/matrix_free/matrix_free.h>
+#include <deal.II/matrix_free/fe_evaluation.h>
+
+#include <fstream>
+#include <iostream>
+
+
+std::ofstream logfile("output");
+
+template <int dim, int fe_degree, typename Number>
+void
+cell_operation (const MatrixFree<dim,Number>                &data,
+                Vector<Number>                              &dst,
+                const Vector<Number>                        &src,
+                const std::pair<unsigned int,unsigned int>  &cell_range)
+{
+  FEEvaluation<dim,fe_degree,fe_degree+1,1,Number> phi (data);
+  for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+    {
+      phi.reinit (cell);
+      phi.read_dof_values (src);
+      phi.evaluate (true, true, false);
+      for (unsigned int q=0; q<phi.n_q_points; ++q)
+        {
+          phi.submit_value (phi.get_value(q), q);
+          phi.submit_gradient (phi.get_gradient(q), q);
+        }
+      phi.integrate (true, true);
+      phi.distribute_local_to_global (dst);
+    }
+}
+
+
+
+template <int dim, int fe_degree>
+void do_test (const FiniteElement<dim> &fe)
+{
+  deallog << "Testing " << fe.get_name() << std::endl;
+
+  Triangulation<dim> tria;
+  GridGenerator::hyper_ball (tria);
+  tria.refine_global (4-dim);
+  for (typename Triangulation<dim>::active_cell_iterator
+       cell=tria.begin_active(); cell != tria.end(); ++cell)
+    if (cell->center()[0] < 0)
+      cell->set_refine_flag();
+  tria.execute_coarsening_and_refinement();
+
+  DoFHandler<dim> dof (tria);
+  dof.distribute_dofs (fe);
+
+  const QGauss<1> quad (fe_degree+1);
+  Vector<double> src (dof.n_dofs()), dst (dof.n_dofs());
+  for (unsigned int i=0; i<dof.n_dofs(); ++i)
+    src(i) = Testing::rand()/(double)RAND_MAX;
+
+  std::vector<types::global_dof_index> renumbering (dof.n_dofs());
+  {
+    ConstraintMatrix constraints;
+    DoFTools::make_hanging_node_constraints (dof, constraints);
+    constraints.close ();
+    constraints.set_zero (src);
+
+    MatrixFree<dim,double> mf_data;
+    mf_data.reinit (dof, constraints, quad);
+    mf_data.cell_loop (&cell_operation<dim,fe_degree,double>, dst, src);
+
+    DoFRenumbering::compute_matrix_free_data_locality (renumbering, dof,
+                                                       mf_data);
+  }
+  dof.renumber_dofs (renumbering);
+
+  std::vector<bool> is_new_index (dof.n_dofs(), false);
+  for (unsigned int i=0; i<dof.n_dofs(); ++i)
+    is_new_index[renumbering[i]] = true;
+  deallog << "Renumbering is permutation: "
+          << (std::find (is_new_index.begin(), is_new_index.end(), false) ==
+              is_new_index.end())
+          << std::endl;
+
+  ConstraintMatrix constraints;
+  DoFTools::make_hanging_node_constraints (dof, constraints);
+  constraints.close ();
+  MatrixFree<dim,double> mf_data;
+  mf_data.reinit (dof, constraints, quad);
+
+  // go through the cells in the order of the cell loop and check that the
+  // indices are first accessed in ascending order
+  types::global_dof_index next_index = 0;
+  bool ascending = true;
+  std::vector<bool> touched (dof.n_dofs(), false);
+  std::vector<std::vector<types::global_dof_index> > dof_indices;
+  for (unsigned int cell=0; cell<mf_data.n_macro_cells(); ++cell)
+    {
+      const unsigned int n_filled = mf_data.n_components_filled(cell);
+      dof_indices.resize (n_filled);
+      for (unsigned int v=0; v<n_filled; ++v)
+        {
+          dof_indices[v].resize (fe.dofs_per_cell);
+          mf_data.get_cell_iterator(cell, v)->get_dof_indices (dof_indices[v]);
+        }
+      for (unsigned int i=0; i<fe.dofs_per_cell; ++i)
+        for (unsigned int v=0; v<n_filled; ++v)
+          if (touched[dof_indices[v][i]] == false)
+            {
+              touched[dof_indices[v][i]] = true;
+              if (dof_indices[v][i] != next_index++)
+                ascending = false;
+            }
+    }
+  deallog << "First access in ascending order: " << ascending << std::endl;
+
+  Vector<double> src_renumbered (dof.n_dofs()), dst_renumbered (dof.n_dofs());
+  for (unsigned int i=0; i<dof.n_dofs(); ++i)
+    src_renumbered(renumbering[i]) = src(i);
+  mf_data.cell_loop (&cell_operation<dim,fe_degree,double>, dst_renumbered,
+                     src_renumbered);
+  for (unsigned int i=0; i<dof.n_dofs(); ++i)
+    src(i) = dst_renumbered(renumbering[i]) - dst(i);
+  deallog << "Error after renumbering: " << src.linfty_norm() << std::endl;
+}
+
+
+
+template <int dim, int fe_degree>
+void test ()
+{
+  do_test<dim,fe_degree> (FE_Q<dim>(fe_degree));
+  do_test<dim,fe_degree> (FE_DGQ<dim>(fe_degree));
+}
+
+
+
+int main ()
+{
+  deallog.attach(logfile);
+  deallog.threshold_double(1.e-12);
+
+  {
+    deallog.push("2d");
+    test<2,1>();
+    test<2,2>();
+    deallog.pop();
+    deallog.push("3d");
+    test<3,1>();
+    test<3,2>();
+    deallog.pop();
+  }
+}
@@ -0,0 +1,185 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// Tests BlockJacobiFastDiagonalization on DG elements on a mesh of
+// anisotropic box cells by comparing its action on a random vector to the
+// inverse of the cell matrices of an interior penalty discretization of
+// the operator -Laplace + c assembled with FEValues and FEFaceValues
+
+#include "../tests.h"
+#include <deal.II/base/quadrature_lib.h>
+#include <deal.II/matrix_free/matrix_free.h>
+#include <deal.II/matrix_free/fe_evaluation.h>
+#include <deal.II/matrix_free/operators.h>
+#include <deal.II/grid/tria.h>
+#include <deal.II/grid/grid_generator.h>
+#include <deal.II/fe/mapping_q1.h>
+#include <deal.II/fe/fe_dgq.h>
+#include <deal.II/fe/fe_values.h>
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/lac/constraint_matrix.h>
+#include <deal.II/lac/full_matrix.h>
+#include <deal.II/lac/la_parallel_vector.h>
+
+
+std::ofstream logfile("output");
+
+
+
+template <int dim, int fe_degree>
+void test ()
+{
+  typedef double Number;
+
+  Triangulation<dim> tria;
+  std::vector<unsigned int> repetitions (dim, 2);
+  repetitions[dim-1] = 3;
+  Point<dim> p1, p2;
+  for (unsigned int d=0; d<dim; ++d)
+    p2[d] = 1. - 0.2*d;
+  GridGenerator::subdivided_hyper_rectangle (tria, repetitions, p1, p2);
+
+  FE_DGQ<dim> fe (fe_degree);
+  DoFHandler<dim> dof (tria);
+  dof.distribute_dofs(fe);
+  ConstraintMatrix constraints;
+  constraints.close();
+
+  deallog << "Testing " << fe.get_name() << std::endl;
+
+  std_cxx11::shared_ptr<MatrixFree<dim,Number> > mf_data (new MatrixFree<dim,Number>());
+  {
+    const QGauss<1> quad (fe_degree+1);
+    typename MatrixFree<dim,Number>::AdditionalData data;
+    data.tasks_parallel_scheme = MatrixFree<dim,Number>::AdditionalData::none;
+    mf_data->reinit (dof, constraints, quad, data);
+  }
+
+  MatrixFreeOperators::MassOperator<dim,fe_degree,fe_degree+1,1,Number> mass_operator;
+  mass_operator.initialize (mf_data);
+
+  const double relaxation = 0.7;
+  const double penalty_factor = 2.5*(fe_degree+1)*(fe_degree+1);
+  const double mass_coefficient = 0.5;
+  typedef MatrixFreeOperators::BlockJacobiFastDiagonalization<dim,fe_degree,1,Number> Smoother;
+  Smoother smoother;
+  smoother.initialize (mass_operator,
+                       typename Smoother::AdditionalData (relaxation,
+                                                          penalty_factor,
+                                                          mass_coefficient));
+
+  LinearAlgebra::distributed::Vector<Number> src, dst;
+  mf_data->initialize_dof_vector (src);
+  mf_data->initialize_dof_vector (dst);
+  for (unsigned int i=0; i<src.size(); ++i)
+    src(i) = Testing::rand()/(double)RAND_MAX;
+
+  smoother.vmult (dst, src);
+
+  // assemble the cell matrices of the interior penalty method with the
+  // contributions of the cell to the diagonal block on all of its faces and
+  // compare the action of their inverse
+  const QGauss<dim> quadrature (fe_degree+1);
+  const QGauss<dim-1> face_quadrature (fe_degree+1);
+  FEValues<dim> fe_values (fe, quadrature,
+                           update_values | update_gradients | update_JxW_values);
+  FEFaceValues<dim> fe_face_values (fe, face_quadrature,
+                                    update_values | update_gradients |
+                                    update_normal_vectors | update_JxW_values);
+  const unsigned int dofs_per_cell = fe.dofs_per_cell;
+  FullMatrix<double> cell_matrix (dofs_per_cell, dofs_per_cell);
+  Vector<double> cell_src (dofs_per_cell), cell_dst (dofs_per_cell);
+  std::vector<types::global_dof_index> dof_indices (dofs_per_cell);
+  double max_error = 0, max_value = 0;
+  for (typename DoFHandler<dim>::active_cell_iterator cell=dof.begin_active();
+       cell != dof.end(); ++cell)
+    {
+      cell_matrix = 0;
+      fe_values.reinit (cell);
+      for (unsigned int q=0; q<quadrature.size(); ++q)
+        for (unsigned int i=0; i<dofs_per_cell; ++i)
+          for (unsigned int j=0; j<dofs_per_cell; ++j)
+            cell_matrix(i,j) += (fe_values.shape_grad(i,q) *
+                                 fe_values.shape_grad(j,q) +
+                                 mass_coefficient *
+                                 fe_values.shape_value(i,q) *
+                                 fe_values.shape_value(j,q)) *
+                                fe_values.JxW(q);
+      for (unsigned int f=0; f<GeometryInfo<dim>::faces_per_cell; ++f)
+        {
+          fe_face_values.reinit (cell, f);
+          const double sigma = penalty_factor /
+                               cell->extent_in_direction(f/2);
+          for (unsigned int q=0; q<face_quadrature.size(); ++q)
+            for (unsigned int i=0; i<dofs_per_cell; ++i)
+              for (unsigned int j=0; j<dofs_per_cell; ++j)
+                cell_matrix(i,j) += (-0.5 * (fe_face_values.shape_grad(i,q) *
+                                             fe_face_values.normal_vector(q) *
+                                             fe_face_values.shape_value(j,q) +
+                                             fe_face_values.shape_value(i,q) *
+                                             fe_face_values.shape_grad(j,q) *
+                                             fe_face_values.normal_vector(q))
+                                     + sigma *
+                                     fe_face_values.shape_value(i,q) *
+                                     fe_face_values.shape_value(j,q)) *
+                                    fe_face_values.JxW(q);
+        }
+      cell_matrix.gauss_jordan();
+
+      cell->get_dof_indices (dof_indices);
+      for (unsigned int i=0; i<dofs_per_cell; ++i)
+        cell_src(i) = src(dof_indices[i]);
+      cell_matrix.vmult (cell_dst, cell_src);
+      for (unsigned int i=0; i<dofs_per_cell; ++i)
+        {
+          max_error = std::max (max_error, std::abs(relaxation * cell_dst(i) -
+                                                    dst(dof_indices[i])));
+          max_value = std::max (max_value, std::abs(dst(dof_indices[i])));
+        }
+    }
+
+  deallog << "Relative error block-Jacobi: " << max_error / max_value
+          << std::endl;
+
+  // the transpose gives the same result since the cell operators are
+  // symmetric
+  LinearAlgebra::distributed::Vector<Number> dst_transpose (dst);
+  smoother.Tvmult (dst_transpose, src);
+  dst_transpose -= dst;
+  deallog << "Difference Tvmult:           " << dst_transpose.linfty_norm()
+          << std::endl;
+}
+
+
+
+int main ()
+{
+  deallog.attach(logfile);
+  deallog.threshold_double(1.e-10);
+
+  {
+    deallog.push("2d");
+    test<2,1>();
+    test<2,2>();
+    test<2,5>();
+    deallog.pop();
+    deallog.push("3d");
+    test<3,1>();
+    test<3,3>();
+    deallog.pop();
+  }
+}
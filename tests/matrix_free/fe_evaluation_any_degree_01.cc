@@ -0,0 +1,170 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// tests that FEEvaluation with the polynomial degree selected at run time
+// (fe_degree=-1) gives the same values, gradients, Hessians, and integrals
+// as FEEvaluation with the degree given as template argument, both for the
+// precompiled kernels (degree+1 quadrature points) and the generic kernels
+// (other numbers of quadrature points or higher degrees), and for the
+// different element types supported by FEEvaluation
+
+#include "../tests.h"
+
+#include <deal.II/base/logstream.h>
+#include <deal.II/base/utilities.h>
+#include <deal.II/lac/vector.h>
+#include <deal.II/lac/constraint_matrix.h>
+#include <deal.II/grid/tria.h>
+#include <deal.II/grid/grid_generator.h>
+#include <deal.II/grid/tria_boundary_lib.h>
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/fe/fe_q.h>
+#include <deal.II/fe/fe_dgq.h>
+#include <deal.II/fe/fe_q_dg0.h>
+#include <deal.II/matrix_free/matrix_free.h>
+#include <deal.II/matrix_free/fe_evaluation.h>
+
+#include <iostream>
+
+std::ofstream logfile("output");
+
+
+
+template <int dim, int fe_degree, int n_q_points_1d>
+void test (const FiniteElement<dim> &fe)
+{
+  Triangulation<dim> tria;
+  GridGenerator::hyper_ball (tria);
+  static const HyperBallBoundary<dim> boundary;
+  tria.set_all_manifold_ids_on_boundary(0);
+  tria.set_manifold (0, boundary);
+  if (dim < 3 || fe_degree < 4)
+    tria.refine_global (1);
+
+  DoFHandler<dim> dof (tria);
+  dof.distribute_dofs (fe);
+  ConstraintMatrix constraints;
+  constraints.close();
+
+  MatrixFree<dim,double> mf_data;
+  {
+    typename MatrixFree<dim,double>::AdditionalData data;
+    data.tasks_parallel_scheme = MatrixFree<dim,double>::AdditionalData::none;
+    data.mapping_update_flags = update_gradients | update_hessians |
+                                update_JxW_values;
+    mf_data.reinit (dof, constraints, QGauss<1>(n_q_points_1d), data);
+  }
+
+  Vector<double> src (dof.n_dofs());
+  for (unsigned int i=0; i<dof.n_dofs(); ++i)
+    src(i) = Testing::rand()/(double)RAND_MAX;
+
+  FEEvaluation<dim,fe_degree,n_q_points_1d> phi_ref (mf_data);
+  FEEvaluation<dim,-1> phi (mf_data);
+  AssertDimension (phi.n_q_points, phi_ref.n_q_points);
+  AssertDimension (phi.tensor_dofs_per_cell, phi_ref.tensor_dofs_per_cell);
+  AssertDimension (phi.dofs_per_cell, phi_ref.dofs_per_cell);
+
+  double error_values = 0, error_gradients = 0, error_hessians = 0,
+         error_integrals = 0, size_integrals = 0;
+  for (unsigned int cell=0; cell<mf_data.n_macro_cells(); ++cell)
+    {
+      phi_ref.reinit (cell);
+      phi.reinit (cell);
+      phi_ref.read_dof_values (src);
+      phi.read_dof_values (src);
+      phi_ref.evaluate (true, true, true);
+      phi.evaluate (true, true, true);
+      for (unsigned int q=0; q<phi.n_q_points; ++q)
+        {
+          for (unsigned int v=0; v<VectorizedArray<double>::n_array_elements; ++v)
+            {
+              error_values = std::max(error_values,
+                                      std::abs(phi.get_value(q)[v] -
+                                               phi_ref.get_value(q)[v]) /
+                                      std::max(1., std::abs(phi_ref.get_value(q)[v])));
+              for (unsigned int d=0; d<dim; ++d)
+                error_gradients = std::max(error_gradients,
+                                           std::abs(phi.get_gradient(q)[d][v] -
+                                                    phi_ref.get_gradient(q)[d][v]) /
+                                           std::max(1., std::abs(phi_ref.get_gradient(q)[d][v])));
+              for (unsigned int d=0; d<dim; ++d)
+                for (unsigned int e=0; e<dim; ++e)
+                  error_hessians = std::max(error_hessians,
+                                            std::abs(phi.get_hessian(q)[d][e][v] -
+                                                     phi_ref.get_hessian(q)[d][e][v]) /
+                                            std::max(1., std::abs(phi_ref.get_hessian(q)[d][e][v])));
+            }
+
+          // test the same values and gradients on both objects
+          const VectorizedArray<double> value = phi_ref.get_value(q);
+          const Tensor<1,dim,VectorizedArray<double> > gradient = phi_ref.get_gradient(q);
+          phi_ref.submit_value (value, q);
+          phi.submit_value (value, q);
+          phi_ref.submit_gradient (gradient, q);
+          phi.submit_gradient (gradient, q);
+        }
+      phi_ref.integrate (true, true);
+      phi.integrate (true, true);
+      for (unsigned int i=0; i<phi.dofs_per_cell; ++i)
+        for (unsigned int v=0; v<VectorizedArray<double>::n_array_elements; ++v)
+          {
+            error_integrals = std::max(error_integrals,
+                                       std::abs(phi.begin_dof_values()[i][v] -
+                                                phi_ref.begin_dof_values()[i][v]));
+            size_integrals = std::max(size_integrals,
+                                      std::abs(phi_ref.begin_dof_values()[i][v]));
+          }
+    }
+
+  deallog << "Testing " << fe.get_name() << " with " << n_q_points_1d
+          << " quadrature points" << std::endl;
+  deallog << "Error values:    " << error_values << std::endl;
+  deallog << "Error gradients: " << error_gradients << std::endl;
+  deallog << "Error Hessians:  " << error_hessians << std::endl;
+  deallog << "Error integrals: " << error_integrals/size_integrals << std::endl;
+}
+
+
+
+int main ()
+{
+  deallog.attach(logfile);
+  deallog.threshold_double(1.e-10);
+
+  {
+    deallog.push("2d");
+    test<2,1,2>(FE_Q<2>(1));
+    test<2,2,3>(FE_Q<2>(2));
+    test<2,2,4>(FE_Q<2>(2));
+    test<2,4,5>(FE_Q<2>(4));
+    test<2,3,4>(FE_DGQ<2>(3));
+    test<2,3,4>(FE_DGQArbitraryNodes<2>(QGauss<1>(4)));
+    test<2,2,3>(FE_Q_DG0<2>(2));
+    test<2,2,4>(FE_Q_DG0<2>(2));
+    test<2,9,10>(FE_Q<2>(9));
+    deallog.pop();
+    deallog.push("3d");
+    test<3,1,2>(FE_Q<3>(1));
+    test<3,2,3>(FE_Q<3>(2));
+    test<3,2,4>(FE_Q<3>(2));
+    test<3,3,3>(FE_DGQ<3>(3));
+    test<3,2,3>(FE_Q_DG0<3>(2));
+    test<3,9,10>(FE_DGQ<3>(9));
+    deallog.pop();
+  }
+}
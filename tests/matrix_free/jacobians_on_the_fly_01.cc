@@ -0,0 +1,137 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// tests that computing the Jacobians on the fly from the support points of
+// the mapping (MatrixFree::AdditionalData::compute_jacobians_on_the_fly)
+// gives the same result for a Laplace plus mass operator on a curved mesh
+// with hanging nodes as storing the Jacobians, and that it uses less memory
+
+#include "../tests.h"
+
+#include <deal.II/base/logstream.h>
+#include <deal.II/base/utilities.h>
+#include <deal.II/lac/vector.h>
+#include <deal.II/lac/constraint_matrix.h>
+#include <deal.II/grid/tria.h>
+#include <deal.II/grid/grid_generator.h>
+#include <deal.II/grid/manifold_lib.h>
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/dofs/dof_tools.h>
+#include <deal.II/fe/fe_q.h>
+#include <deal.II/fe/mapping_q_generic.h>
+#include <deal.II/matrix_free/matrix_free.h>
+#include <deal.II/matrix_free/fe_evaluation.h>
+
+#include <iostream>
+
+std::ofstream logfile("output");
+
+
+
+template <int dim, int fe_degree, typename Number>
+void
+local_apply (const MatrixFree<dim,Number>                &data,
+             Vector<Number>                              &dst,
+             const Vector<Number>                        &src,
+             const std::pair<unsigned int,unsigned int>  &cell_range)
+{
+  FEEvaluation<dim,fe_degree,fe_degree+1,1,Number> phi (data);
+  for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+    {
+      phi.reinit (cell);
+      phi.read_dof_values (src);
+      phi.evaluate (true, true);
+      for (unsigned int q=0; q<phi.n_q_points; ++q)
+        {
+          phi.submit_value (phi.get_value(q), q);
+          phi.submit_gradient (phi.get_gradient(q), q);
+        }
+      phi.integrate (true, true);
+      phi.distribute_local_to_global (dst);
+    }
+}
+
+
+
+template <int dim, int fe_degree>
+void test (const unsigned int mapping_degree)
+{
+  typedef double Number;
+  const SphericalManifold<dim> manifold;
+  Triangulation<dim> tria;
+  GridGenerator::hyper_shell (tria, Point<dim>(), 0.5, 1., 2*dim);
+  tria.set_all_manifold_ids(0);
+  tria.set_manifold (0, manifold);
+  tria.begin_active()->set_refine_flag();
+  tria.execute_coarsening_and_refinement();
+  tria.refine_global (3-dim);
+
+  FE_Q<dim> fe (fe_degree);
+  DoFHandler<dim> dof (tria);
+  dof.distribute_dofs(fe);
+  ConstraintMatrix constraints;
+  DoFTools::make_hanging_node_constraints (dof, constraints);
+  constraints.close();
+
+  deallog << "Testing " << fe.get_name() << " with mapping degree "
+          << mapping_degree << std::endl;
+
+  const MappingQGeneric<dim> mapping (mapping_degree);
+  MatrixFree<dim,Number> mf_data, mf_data_fly;
+  {
+    typename MatrixFree<dim,Number>::AdditionalData data;
+    data.tasks_parallel_scheme = MatrixFree<dim,Number>::AdditionalData::none;
+    mf_data.reinit (mapping, dof, constraints, QGauss<1>(fe_degree+1), data);
+    data.compute_jacobians_on_the_fly = true;
+    mf_data_fly.reinit (mapping, dof, constraints, QGauss<1>(fe_degree+1), data);
+  }
+
+  Vector<Number> src (dof.n_dofs()), dst (dof.n_dofs()), dst_fly (dof.n_dofs());
+  for (unsigned int i=0; i<dof.n_dofs(); ++i)
+    if (constraints.is_constrained(i) == false)
+      src(i) = Testing::rand()/(double)RAND_MAX;
+
+  mf_data.cell_loop (&local_apply<dim,fe_degree,Number>, dst, src);
+  mf_data_fly.cell_loop (&local_apply<dim,fe_degree,Number>, dst_fly, src);
+
+  dst_fly -= dst;
+  deallog << "Relative difference:      " << dst_fly.l2_norm()/dst.l2_norm()
+          << std::endl;
+  deallog << "Less memory on the fly:   "
+          << (mf_data_fly.get_mapping_info().memory_consumption() <
+              mf_data.get_mapping_info().memory_consumption()) << std::endl;
+}
+
+
+
+int main ()
+{
+  deallog.attach(logfile);
+  deallog.threshold_double(1.e-10);
+
+  {
+    deallog.push("2d");
+    test<2,1>(1);
+    test<2,2>(3);
+    test<2,4>(4);
+    deallog.pop();
+    deallog.push("3d");
+    test<3,2>(3);
+    test<3,3>(4);
+    deallog.pop();
+  }
+}
@@ -0,0 +1,168 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// this tests the correctness of matrix free matrix-vector products when the
+// overlap of communication and computation is disabled through
+// MatrixFree::AdditionalData::overlap_communication_computation, for all
+// task-parallel schemes, by comparing with the default setting. Otherwise
+// same problem as matrix_vector_11.cc, but in serial.
+
+#include "../tests.h"
+
+#include "matrix_vector_mf.h"
+
+#include <deal.II/base/logstream.h>
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/function.h>
+#include <deal.II/lac/la_parallel_vector.h>
+#include <deal.II/grid/tria.h>
+#include <deal.II/grid/grid_generator.h>
+#include <deal.II/dofs/dof_tools.h>
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/lac/constraint_matrix.h>
+#include <deal.II/fe/fe_q.h>
+#include <deal.II/numerics/vector_tools.h>
+
+#include <iostream>
+
+std::ofstream logfile("output");
+
+
+
+template <int dim, int fe_degree>
+void test ()
+{
+  typedef double number;
+
+  Triangulation<dim> tria;
+  GridGenerator::hyper_cube (tria);
+  tria.refine_global(1);
+  typename Triangulation<dim>::active_cell_iterator
+  cell = tria.begin_active (),
+  endc = tria.end();
+  for (; cell!=endc; ++cell)
+    if (cell->center().norm()<0.2)
+      cell->set_refine_flag();
+  tria.execute_coarsening_and_refinement();
+  if (fe_degree < 2)
+    tria.refine_global(2);
+  else
+    tria.refine_global(1);
+  tria.begin(tria.n_levels()-1)->set_refine_flag();
+  tria.last()->set_refine_flag();
+  tria.execute_coarsening_and_refinement();
+
+  FE_Q<dim> fe (fe_degree);
+  DoFHandler<dim> dof (tria);
+  dof.distribute_dofs(fe);
+
+  ConstraintMatrix constraints;
+  DoFTools::make_hanging_node_constraints(dof, constraints);
+  VectorTools::interpolate_boundary_values (dof, 0, ZeroFunction<dim>(),
+                                            constraints);
+  constraints.close();
+
+  deallog << "Testing " << dof.get_fe().get_name() << std::endl;
+
+  MatrixFree<dim,number> mf_data;
+  {
+    const QGauss<1> quad (fe_degree+1);
+    typename MatrixFree<dim,number>::AdditionalData data;
+    data.tasks_parallel_scheme =
+      MatrixFree<dim,number>::AdditionalData::none;
+    mf_data.reinit (dof, constraints, quad, data);
+  }
+
+  MatrixFreeTest<dim,fe_degree,number,LinearAlgebra::distributed::Vector<number> > mf (mf_data);
+  LinearAlgebra::distributed::Vector<number> in, out, ref;
+  mf_data.initialize_dof_vector (in);
+  out.reinit (in);
+  ref.reinit (in);
+
+  for (unsigned int i=0; i<in.local_size(); ++i)
+    {
+      if (constraints.is_constrained(i))
+        continue;
+      in.local_element(i) = (double)Testing::rand()/RAND_MAX;
+    }
+
+  mf.vmult (ref, in);
+
+  for (unsigned int parallel_option = 0; parallel_option < 4; ++parallel_option)
+    {
+      const QGauss<1> quad (fe_degree+1);
+      typename MatrixFree<dim,number>::AdditionalData data;
+      if (parallel_option == 0)
+        {
+          data.tasks_parallel_scheme =
+            MatrixFree<dim,number>::AdditionalData::none;
+          deallog << "Parallel option: none" << std::endl;
+        }
+      else if (parallel_option == 1)
+        {
+          data.tasks_parallel_scheme =
+            MatrixFree<dim,number>::AdditionalData::partition_partition;
+          deallog << "Parallel option: partition partition" << std::endl;
+        }
+      else if (parallel_option == 2)
+        {
+          data.tasks_parallel_scheme =
+            MatrixFree<dim,number>::AdditionalData::partition_color;
+          deallog << "Parallel option: partition color" << std::endl;
+        }
+      else if (parallel_option == 3)
+        {
+          data.tasks_parallel_scheme =
+            MatrixFree<dim,number>::AdditionalData::color;
+          deallog << "Parallel option: color" << std::endl;
+        }
+
+      data.tasks_block_size = 3;
+      data.overlap_communication_computation = false;
+      mf_data.reinit (dof, constraints, quad, data);
+      MatrixFreeTest<dim, fe_degree, number,LinearAlgebra::distributed::Vector<number> > mf (mf_data);
+      deallog << "Norm of difference:";
+
+      for (unsigned int run=0; run<3; ++run)
+        {
+          mf.vmult (out, in);
+          out -= ref;
+          const double diff_norm = out.linfty_norm();
+          deallog << " " << diff_norm;
+        }
+      deallog << std::endl;
+    }
+  deallog << std::endl;
+}
+
+
+int main ()
+{
+  deallog.attach(logfile);
+  deallog << std::setprecision(4);
+  deallog.threshold_double(1.e-10);
+
+  deallog.push("2d");
+  test<2,1>();
+  test<2,2>();
+  deallog.pop();
+
+  deallog.push("3d");
+  test<3,1>();
+  test<3,2>();
+  deallog.pop();
+}
@@ -0,0 +1,158 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// tests the matrix-free evaluation of FE_DGP and FE_DGPMonomial, which are
+// both represented as truncated tensor products of 1D polynomials. Compares
+// evaluate() and integrate() of values and gradients against FEValues and
+// prints the detected element type
+
+#include "../tests.h"
+
+#include <deal.II/base/function.h>
+#include <deal.II/base/quadrature_lib.h>
+#include <deal.II/grid/tria.h>
+#include <deal.II/grid/grid_generator.h>
+#include <deal.II/grid/grid_tools.h>
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/fe/fe_dgp.h>
+#include <deal.II/fe/fe_dgp_monomial.h>
+#include <deal.II/fe/fe_values.h>
+#include <deal.II/lac/constraint_matrix.h>
+#include <deal.II/lac/vector.h>
+#include <deal.II/matrix_free/matrix_free.h>
+#include <deal.II/matrix_free/fe_evaluation.h>
+
+#include <fstream>
+#include <iostream>
+
+
+std::ofstream logfile("output");
+
+template <int dim, int fe_degree, typename Number>
+void
+cell_operation (const MatrixFree<dim,Number>                &data,
+                Vector<Number>                              &dst,
+                const Vector<Number>                        &src,
+                const std::pair<unsigned int,unsigned int>  &cell_range)
+{
+  FEEvaluation<dim,fe_degree,fe_degree+1,1,Number> phi (data);
+  for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+    {
+      phi.reinit (cell);
+      phi.read_dof_values (src);
+      phi.evaluate (true, true, false);
+      for (unsigned int q=0; q<phi.n_q_points; ++q)
+        {
+          phi.submit_value (phi.get_value(q), q);
+          phi.submit_gradient (phi.get_gradient(q), q);
+        }
+      phi.integrate (true, true);
+      phi.distribute_local_to_global (dst);
+    }
+}
+
+
+
+template <int dim, int fe_degree>
+void do_test (const FiniteElement<dim> &fe)
+{
+  deallog << "Testing " << fe.get_name() << std::endl;
+
+  Triangulation<dim> tria;
+  GridGenerator::hyper_ball (tria);
+  tria.refine_global (4-dim);
+  GridTools::distort_random (0.1, tria, true);
+
+  DoFHandler<dim> dof (tria);
+  dof.distribute_dofs (fe);
+  ConstraintMatrix constraints;
+  constraints.close ();
+
+  const QGauss<1> quad (fe_degree+1);
+  MatrixFree<dim,double> mf_data;
+  mf_data.reinit (dof, constraints, quad);
+
+  deallog << "Element type: "
+          << mf_data.get_shape_info().element_type
+          << ", supported: " << MatrixFree<dim,double>::is_supported(fe)
+          << std::endl;
+
+  Vector<double> src (dof.n_dofs()), dst (dof.n_dofs()), ref (dof.n_dofs());
+  for (unsigned int i=0; i<dof.n_dofs(); ++i)
+    src(i) = Testing::rand()/(double)RAND_MAX;
+
+  mf_data.cell_loop (&cell_operation<dim,fe_degree,double>, dst, src);
+
+  // reference: the mass plus Laplace matrix applied cell by cell with
+  // FEValues
+  FEValues<dim> fe_values (fe, Quadrature<dim>(quad),
+                           update_values | update_gradients | update_JxW_values);
+  std::vector<types::global_dof_index> dof_indices (fe.dofs_per_cell);
+  std::vector<double> values (fe_values.n_quadrature_points);
+  std::vector<Tensor<1,dim> > gradients (fe_values.n_quadrature_points);
+  for (typename DoFHandler<dim>::active_cell_iterator cell=dof.begin_active();
+       cell != dof.end(); ++cell)
+    {
+      fe_values.reinit (cell);
+      fe_values.get_function_values (src, values);
+      fe_values.get_function_gradients (src, gradients);
+      cell->get_dof_indices (dof_indices);
+      for (unsigned int i=0; i<fe.dofs_per_cell; ++i)
+        {
+          double sum = 0;
+          for (unsigned int q=0; q<fe_values.n_quadrature_points; ++q)
+            sum += (fe_values.shape_value(i,q) * values[q] +
+                    fe_values.shape_grad(i,q) * gradients[q]) *
+                   fe_values.JxW(q);
+          ref(dof_indices[i]) += sum;
+        }
+    }
+
+  dst -= ref;
+  deallog << "Relative error: " << dst.linfty_norm() / ref.linfty_norm()
+          << std::endl;
+}
+
+
+
+template <int dim, int fe_degree>
+void test ()
+{
+  do_test<dim,fe_degree> (FE_DGP<dim>(fe_degree));
+  do_test<dim,fe_degree> (FE_DGPMonomial<dim>(fe_degree));
+}
+
+
+
+int main ()
+{
+  deallog.attach(logfile);
+  deallog.threshold_double(1.e-12);
+
+  {
+    deallog.push("2d");
+    test<2,1>();
+    test<2,2>();
+    test<2,3>();
+    deallog.pop();
+    deallog.push("3d");
+    test<3,1>();
+    test<3,2>();
+    test<3,3>();
+    deallog.pop();
+  }
+}
@@ -0,0 +1,323 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// tests the correctness of matrix-free face integrals with FEFaceEvaluation
+// and MatrixFree::loop for the symmetric interior penalty discretization of
+// the Laplacian with FE_DGQ elements on a distorted mesh without hanging
+// nodes by comparing with a sparse matrix assembled with FEValues and
+// FEFaceValues
+
+#include "../tests.h"
+
+#include <deal.II/base/logstream.h>
+#include <deal.II/base/utilities.h>
+#include <deal.II/lac/vector.h>
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/dynamic_sparsity_pattern.h>
+#include <deal.II/grid/tria.h>
+#include <deal.II/grid/grid_generator.h>
+#include <deal.II/grid/grid_tools.h>
+#include <deal.II/dofs/dof_tools.h>
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/fe/fe_dgq.h>
+#include <deal.II/fe/fe_values.h>
+#include <deal.II/fe/mapping_q.h>
+#include <deal.II/matrix_free/matrix_free.h>
+#include <deal.II/matrix_free/fe_evaluation.h>
+
+#include <iostream>
+
+std::ofstream logfile("output");
+
+const double penalty = 5.;
+
+
+
+template <int dim, int fe_degree>
+class LaplaceOperatorDG
+{
+public:
+  LaplaceOperatorDG (const MatrixFree<dim,double> &data)
+    :
+    data (data)
+  {}
+
+  void vmult (Vector<double> &dst,
+              const Vector<double> &src) const
+  {
+    dst = 0;
+    data.loop (&LaplaceOperatorDG::local_apply,
+               &LaplaceOperatorDG::local_apply_face,
+               &LaplaceOperatorDG::local_apply_boundary,
+               this, dst, src);
+  }
+
+private:
+  void local_apply (const MatrixFree<dim,double>              &data,
+                    Vector<double>                            &dst,
+                    const Vector<double>                      &src,
+                    const std::pair<unsigned int,unsigned int> &cell_range) const
+  {
+    FEEvaluation<dim,fe_degree> phi (data);
+    for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+      {
+        phi.reinit (cell);
+        phi.read_dof_values (src);
+        phi.evaluate (false, true);
+        for (unsigned int q=0; q<phi.n_q_points; ++q)
+          phi.submit_gradient (phi.get_gradient(q), q);
+        phi.integrate (false, true);
+        phi.distribute_local_to_global (dst);
+      }
+  }
+
+  void local_apply_face (const MatrixFree<dim,double>              &data,
+                         Vector<double>                            &dst,
+                         const Vector<double>                      &src,
+                         const std::pair<unsigned int,unsigned int> &face_range) const
+  {
+    FEFaceEvaluation<dim,fe_degree> phi_m (data, true);
+    FEFaceEvaluation<dim,fe_degree> phi_p (data, false);
+    for (unsigned int face=face_range.first; face<face_range.second; ++face)
+      {
+        phi_m.reinit (face);
+        phi_p.reinit (face);
+        phi_m.read_dof_values (src);
+        phi_p.read_dof_values (src);
+        phi_m.evaluate (true, true);
+        phi_p.evaluate (true, true);
+        for (unsigned int q=0; q<phi_m.n_q_points; ++q)
+          {
+            const VectorizedArray<double> jump =
+              phi_m.get_value(q) - phi_p.get_value(q);
+            const VectorizedArray<double> average_normal_derivative =
+              0.5 * (phi_m.get_normal_derivative(q) +
+                     phi_p.get_normal_derivative(q));
+            const VectorizedArray<double> flux =
+              penalty * jump - average_normal_derivative;
+            phi_m.submit_value (flux, q);
+            phi_p.submit_value (-flux, q);
+            phi_m.submit_normal_derivative (-0.5 * jump, q);
+            phi_p.submit_normal_derivative (-0.5 * jump, q);
+          }
+        phi_m.integrate (true, true);
+        phi_p.integrate (true, true);
+        phi_m.distribute_local_to_global (dst);
+        phi_p.distribute_local_to_global (dst);
+      }
+  }
+
+  void local_apply_boundary (const MatrixFree<dim,double>              &data,
+                             Vector<double>                            &dst,
+                             const Vector<double>                      &src,
+                             const std::pair<unsigned int,unsigned int> &face_range) const
+  {
+    FEFaceEvaluation<dim,fe_degree> phi (data, true);
+    for (unsigned int face=face_range.first; face<face_range.second; ++face)
+      {
+        phi.reinit (face);
+        phi.read_dof_values (src);
+        phi.evaluate (true, true);
+        for (unsigned int q=0; q<phi.n_q_points; ++q)
+          {
+            const VectorizedArray<double> value = phi.get_value(q);
+            phi.submit_value (penalty * value - phi.get_normal_derivative(q), q);
+            phi.submit_normal_derivative (-value, q);
+          }
+        phi.integrate (true, true);
+        phi.distribute_local_to_global (dst);
+      }
+  }
+
+  const MatrixFree<dim,double> &data;
+};
+
+
+
+template <int dim>
+void assemble_matrix (const Mapping<dim>    &mapping,
+                      const DoFHandler<dim> &dof,
+                      SparseMatrix<double>  &matrix)
+{
+  const FiniteElement<dim> &fe = dof.get_fe();
+  const unsigned int dofs_per_cell = fe.dofs_per_cell;
+  const QGauss<dim>   quadrature (fe.degree+1);
+  const QGauss<dim-1> face_quadrature (fe.degree+1);
+  FEValues<dim> fe_values (mapping, fe, quadrature,
+                           update_gradients | update_JxW_values);
+  FEFaceValues<dim> fe_face_values (mapping, fe, face_quadrature,
+                                    update_values | update_gradients |
+                                    update_normal_vectors | update_JxW_values);
+  FEFaceValues<dim> fe_face_values_neighbor (mapping, fe, face_quadrature,
+                                             update_values | update_gradients);
+
+  FullMatrix<double> cell_matrix (dofs_per_cell, dofs_per_cell);
+  FullMatrix<double> face_matrix[2][2];
+  for (unsigned int i=0; i<2; ++i)
+    for (unsigned int j=0; j<2; ++j)
+      face_matrix[i][j].reinit (dofs_per_cell, dofs_per_cell);
+  std::vector<types::global_dof_index> dof_indices[2];
+  for (unsigned int i=0; i<2; ++i)
+    dof_indices[i].resize (dofs_per_cell);
+
+  for (typename DoFHandler<dim>::active_cell_iterator cell=dof.begin_active();
+       cell != dof.end(); ++cell)
+    {
+      cell->get_dof_indices (dof_indices[0]);
+      fe_values.reinit (cell);
+      cell_matrix = 0;
+      for (unsigned int q=0; q<quadrature.size(); ++q)
+        for (unsigned int i=0; i<dofs_per_cell; ++i)
+          for (unsigned int j=0; j<dofs_per_cell; ++j)
+            cell_matrix(i,j) += (fe_values.shape_grad(i,q) *
+                                 fe_values.shape_grad(j,q) *
+                                 fe_values.JxW(q));
+      matrix.add (dof_indices[0], cell_matrix);
+
+      for (unsigned int f=0; f<GeometryInfo<dim>::faces_per_cell; ++f)
+        {
+          fe_face_values.reinit (cell, f);
+          if (cell->at_boundary(f))
+            {
+              cell_matrix = 0;
+              for (unsigned int q=0; q<face_quadrature.size(); ++q)
+                for (unsigned int i=0; i<dofs_per_cell; ++i)
+                  for (unsigned int j=0; j<dofs_per_cell; ++j)
+                    cell_matrix(i,j) +=
+                      ((penalty * fe_face_values.shape_value(i,q) *
+                        fe_face_values.shape_value(j,q)
+                        -
+                        fe_face_values.shape_value(i,q) *
+                        (fe_face_values.shape_grad(j,q) *
+                         fe_face_values.normal_vector(q))
+                        -
+                        (fe_face_values.shape_grad(i,q) *
+                         fe_face_values.normal_vector(q)) *
+                        fe_face_values.shape_value(j,q)) *
+                       fe_face_values.JxW(q));
+              matrix.add (dof_indices[0], cell_matrix);
+              continue;
+            }
+
+          // assemble each interior face only once
+          const typename DoFHandler<dim>::active_cell_iterator
+          neighbor = cell->neighbor(f);
+          if (neighbor < cell)
+            continue;
+          neighbor->get_dof_indices (dof_indices[1]);
+          fe_face_values_neighbor.reinit (neighbor, cell->neighbor_of_neighbor(f));
+          const FEFaceValues<dim> *face_values[2] = {&fe_face_values,
+                                                     &fe_face_values_neighbor
+                                                    };
+          const double sign[2] = {1., -1.};
+          for (unsigned int s=0; s<2; ++s)
+            for (unsigned int t=0; t<2; ++t)
+              {
+                face_matrix[s][t] = 0;
+                for (unsigned int q=0; q<face_quadrature.size(); ++q)
+                  {
+                    const Tensor<1,dim> normal = fe_face_values.normal_vector(q);
+                    for (unsigned int i=0; i<dofs_per_cell; ++i)
+                      for (unsigned int j=0; j<dofs_per_cell; ++j)
+                        face_matrix[s][t](i,j) +=
+                          ((penalty * sign[s] * sign[t] *
+                            face_values[s]->shape_value(i,q) *
+                            face_values[t]->shape_value(j,q)
+                            -
+                            0.5 * sign[s] * face_values[s]->shape_value(i,q) *
+                            (face_values[t]->shape_grad(j,q) * normal)
+                            -
+                            0.5 * sign[t] * (face_values[s]->shape_grad(i,q) *
+                                             normal) *
+                            face_values[t]->shape_value(j,q)) *
+                           fe_face_values.JxW(q));
+                  }
+                matrix.add (dof_indices[s], dof_indices[t], face_matrix[s][t]);
+              }
+        }
+    }
+}
+
+
+
+template <int dim, int fe_degree>
+void test ()
+{
+  Triangulation<dim> tria;
+  GridGenerator::hyper_cube (tria);
+  tria.refine_global (5-dim);
+  GridTools::distort_random (0.2, tria);
+
+  FE_DGQ<dim> fe (fe_degree);
+  DoFHandler<dim> dof (tria);
+  dof.distribute_dofs (fe);
+  ConstraintMatrix constraints;
+  constraints.close();
+
+  deallog << "Testing " << fe.get_name() << std::endl;
+
+  MappingQGeneric<dim> mapping (1);
+  MatrixFree<dim,double> mf_data;
+  {
+    typename MatrixFree<dim,double>::AdditionalData data;
+    data.tasks_parallel_scheme = MatrixFree<dim,double>::AdditionalData::none;
+    data.mapping_update_flags_inner_faces = update_gradients | update_JxW_values;
+    data.mapping_update_flags_boundary_faces = update_gradients | update_JxW_values;
+    mf_data.reinit (mapping, dof, constraints, QGauss<1>(fe_degree+1), data);
+  }
+
+  Vector<double> in (dof.n_dofs()), out (dof.n_dofs()), ref (dof.n_dofs());
+  for (unsigned int i=0; i<dof.n_dofs(); ++i)
+    in(i) = Testing::rand()/(double)RAND_MAX;
+
+  LaplaceOperatorDG<dim,fe_degree> mf (mf_data);
+  mf.vmult (out, in);
+
+  SparsityPattern sparsity;
+  {
+    DynamicSparsityPattern dsp (dof.n_dofs(), dof.n_dofs());
+    DoFTools::make_flux_sparsity_pattern (dof, dsp);
+    sparsity.copy_from (dsp);
+  }
+  SparseMatrix<double> sparse_matrix (sparsity);
+  assemble_matrix (mapping, dof, sparse_matrix);
+  sparse_matrix.vmult (ref, in);
+
+  out -= ref;
+  const double diff_norm = out.linfty_norm() / ref.linfty_norm();
+  deallog << "Norm of difference: " << diff_norm << std::endl << std::endl;
+}
+
+
+
+int main ()
+{
+  deallog.attach(logfile);
+  deallog.threshold_double(1.e-12);
+
+  {
+    deallog.push("2d");
+    test<2,1>();
+    test<2,2>();
+    test<2,3>();
+    deallog.pop();
+    deallog.push("3d");
+    test<3,1>();
+    test<3,2>();
+    deallog.pop();
+  }
+}
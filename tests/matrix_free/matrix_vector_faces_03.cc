@@ -0,0 +1,409 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// same as matrix_vector_faces_02, but in parallel with
+// parallel::distributed::Triangulation and LinearAlgebra::distributed::Vector,
+// such that faces with hanging nodes also appear between cells owned by
+// different processors. The reference is a Trilinos matrix where each
+// processor assembles the rows of its locally owned cells
+
+#include "../tests.h"
+
+#include <deal.II/base/logstream.h>
+#include <deal.II/base/utilities.h>
+#include <deal.II/lac/la_parallel_vector.h>
+#include <deal.II/lac/dynamic_sparsity_pattern.h>
+#include <deal.II/lac/sparsity_tools.h>
+#include <deal.II/lac/trilinos_sparse_matrix.h>
+#include <deal.II/distributed/tria.h>
+#include <deal.II/grid/grid_generator.h>
+#include <deal.II/grid/grid_tools.h>
+#include <deal.II/dofs/dof_tools.h>
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/fe/fe_dgq.h>
+#include <deal.II/fe/fe_values.h>
+#include <deal.II/fe/mapping_q.h>
+#include <deal.II/matrix_free/matrix_free.h>
+#include <deal.II/matrix_free/fe_evaluation.h>
+
+#include <iostream>
+
+const double penalty = 5.;
+
+
+
+template <int dim, int fe_degree>
+class LaplaceOperatorDG
+{
+public:
+  LaplaceOperatorDG (const MatrixFree<dim,double> &data)
+    :
+    data (data)
+  {}
+
+  void vmult (LinearAlgebra::distributed::Vector<double> &dst,
+              const LinearAlgebra::distributed::Vector<double> &src) const
+  {
+    dst = 0;
+    data.loop (&LaplaceOperatorDG::local_apply,
+               &LaplaceOperatorDG::local_apply_face,
+               &LaplaceOperatorDG::local_apply_boundary,
+               this, dst, src);
+  }
+
+private:
+  void local_apply (const MatrixFree<dim,double>                     &data,
+                    LinearAlgebra::distributed::Vector<double>       &dst,
+                    const LinearAlgebra::distributed::Vector<double> &src,
+                    const std::pair<unsigned int,unsigned int>       &cell_range) const
+  {
+    FEEvaluation<dim,fe_degree> phi (data);
+    for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+      {
+        phi.reinit (cell);
+        phi.read_dof_values (src);
+        phi.evaluate (false, true);
+        for (unsigned int q=0; q<phi.n_q_points; ++q)
+          phi.submit_gradient (phi.get_gradient(q), q);
+        phi.integrate (false, true);
+        phi.distribute_local_to_global (dst);
+      }
+  }
+
+  void local_apply_face (const MatrixFree<dim,double>                     &data,
+                         LinearAlgebra::distributed::Vector<double>       &dst,
+                         const LinearAlgebra::distributed::Vector<double> &src,
+                         const std::pair<unsigned int,unsigned int>       &face_range) const
+  {
+    FEFaceEvaluation<dim,fe_degree> phi_m (data, true);
+    FEFaceEvaluation<dim,fe_degree> phi_p (data, false);
+    for (unsigned int face=face_range.first; face<face_range.second; ++face)
+      {
+        phi_m.reinit (face);
+        phi_p.reinit (face);
+        phi_m.read_dof_values (src);
+        phi_p.read_dof_values (src);
+        phi_m.evaluate (true, true);
+        phi_p.evaluate (true, true);
+        for (unsigned int q=0; q<phi_m.n_q_points; ++q)
+          {
+            const VectorizedArray<double> jump =
+              phi_m.get_value(q) - phi_p.get_value(q);
+            const VectorizedArray<double> average_normal_derivative =
+              0.5 * (phi_m.get_normal_derivative(q) +
+                     phi_p.get_normal_derivative(q));
+            const VectorizedArray<double> flux =
+              penalty * jump - average_normal_derivative;
+            phi_m.submit_value (flux, q);
+            phi_p.submit_value (-flux, q);
+            phi_m.submit_normal_derivative (-0.5 * jump, q);
+            phi_p.submit_normal_derivative (-0.5 * jump, q);
+          }
+        phi_m.integrate (true, true);
+        phi_p.integrate (true, true);
+        phi_m.distribute_local_to_global (dst);
+        phi_p.distribute_local_to_global (dst);
+      }
+  }
+
+  void local_apply_boundary (const MatrixFree<dim,double>                     &data,
+                             LinearAlgebra::distributed::Vector<double>       &dst,
+                             const LinearAlgebra::distributed::Vector<double> &src,
+                             const std::pair<unsigned int,unsigned int>       &face_range) const
+  {
+    FEFaceEvaluation<dim,fe_degree> phi (data, true);
+    for (unsigned int face=face_range.first; face<face_range.second; ++face)
+      {
+        phi.reinit (face);
+        phi.read_dof_values (src);
+        phi.evaluate (true, true);
+        for (unsigned int q=0; q<phi.n_q_points; ++q)
+          {
+            const VectorizedArray<double> value = phi.get_value(q);
+            phi.submit_value (penalty * value - phi.get_normal_derivative(q), q);
+            phi.submit_normal_derivative (-value, q);
+          }
+        phi.integrate (true, true);
+        phi.distribute_local_to_global (dst);
+      }
+  }
+
+  const MatrixFree<dim,double> &data;
+};
+
+
+
+// add the interior penalty terms of a face to the rows of the cell on the
+// side given by face_values[0], coupling to both sides of the face
+template <int dim>
+void add_face_terms (const FEFaceValuesBase<dim>                *face_values[2],
+                     const std::vector<types::global_dof_index> dof_indices[2],
+                     FullMatrix<double>                         &face_matrix,
+                     TrilinosWrappers::SparseMatrix             &matrix)
+{
+  const unsigned int dofs_per_cell = face_matrix.m();
+  const double sign[2] = {1., -1.};
+  for (unsigned int t=0; t<2; ++t)
+    {
+      face_matrix = 0;
+      for (unsigned int q=0; q<face_values[0]->n_quadrature_points; ++q)
+        {
+          const Tensor<1,dim> normal = face_values[0]->normal_vector(q);
+          for (unsigned int i=0; i<dofs_per_cell; ++i)
+            for (unsigned int j=0; j<dofs_per_cell; ++j)
+              face_matrix(i,j) +=
+                ((penalty * sign[t] *
+                  face_values[0]->shape_value(i,q) *
+                  face_values[t]->shape_value(j,q)
+                  -
+                  0.5 * face_values[0]->shape_value(i,q) *
+                  (face_values[t]->shape_grad(j,q) * normal)
+                  -
+                  0.5 * sign[t] * (face_values[0]->shape_grad(i,q) * normal) *
+                  face_values[t]->shape_value(j,q)) *
+                 face_values[0]->JxW(q));
+        }
+      matrix.add (dof_indices[0], dof_indices[t], face_matrix);
+    }
+}
+
+
+
+template <int dim>
+void assemble_matrix (const Mapping<dim>             &mapping,
+                      const DoFHandler<dim>          &dof,
+                      TrilinosWrappers::SparseMatrix &matrix)
+{
+  const FiniteElement<dim> &fe = dof.get_fe();
+  const unsigned int dofs_per_cell = fe.dofs_per_cell;
+  const QGauss<dim>   quadrature (fe.degree+1);
+  const QGauss<dim-1> face_quadrature (fe.degree+1);
+  const UpdateFlags face_flags = update_values | update_gradients |
+                                 update_normal_vectors | update_JxW_values;
+  FEValues<dim> fe_values (mapping, fe, quadrature,
+                           update_gradients | update_JxW_values);
+  FEFaceValues<dim> fe_face_values (mapping, fe, face_quadrature, face_flags);
+  FESubfaceValues<dim> fe_subface_values (mapping, fe, face_quadrature,
+                                          face_flags);
+  FEFaceValues<dim> fe_face_values_neighbor (mapping, fe, face_quadrature,
+                                             face_flags);
+  FESubfaceValues<dim> fe_subface_values_neighbor (mapping, fe, face_quadrature,
+                                                   face_flags);
+
+  FullMatrix<double> cell_matrix (dofs_per_cell, dofs_per_cell);
+  std::vector<types::global_dof_index> dof_indices[2];
+  for (unsigned int i=0; i<2; ++i)
+    dof_indices[i].resize (dofs_per_cell);
+
+  // each cell adds the rows of its own degrees of freedom, so every
+  // interior face is visited from both sides
+  for (typename DoFHandler<dim>::active_cell_iterator cell=dof.begin_active();
+       cell != dof.end(); ++cell)
+    {
+      if (cell->is_locally_owned() == false)
+        continue;
+
+      cell->get_dof_indices (dof_indices[0]);
+      fe_values.reinit (cell);
+      cell_matrix = 0;
+      for (unsigned int q=0; q<quadrature.size(); ++q)
+        for (unsigned int i=0; i<dofs_per_cell; ++i)
+          for (unsigned int j=0; j<dofs_per_cell; ++j)
+            cell_matrix(i,j) += (fe_values.shape_grad(i,q) *
+                                 fe_values.shape_grad(j,q) *
+                                 fe_values.JxW(q));
+      matrix.add (dof_indices[0], cell_matrix);
+
+      for (unsigned int f=0; f<GeometryInfo<dim>::faces_per_cell; ++f)
+        {
+          if (cell->at_boundary(f))
+            {
+              fe_face_values.reinit (cell, f);
+              cell_matrix = 0;
+              for (unsigned int q=0; q<face_quadrature.size(); ++q)
+                for (unsigned int i=0; i<dofs_per_cell; ++i)
+                  for (unsigned int j=0; j<dofs_per_cell; ++j)
+                    cell_matrix(i,j) +=
+                      ((penalty * fe_face_values.shape_value(i,q) *
+                        fe_face_values.shape_value(j,q)
+                        -
+                        fe_face_values.shape_value(i,q) *
+                        (fe_face_values.shape_grad(j,q) *
+                         fe_face_values.normal_vector(q))
+                        -
+                        (fe_face_values.shape_grad(i,q) *
+                         fe_face_values.normal_vector(q)) *
+                        fe_face_values.shape_value(j,q)) *
+                       fe_face_values.JxW(q));
+              matrix.add (dof_indices[0], cell_matrix);
+            }
+          else if (cell->neighbor(f)->has_children())
+            for (unsigned int sf=0; sf<cell->face(f)->n_children(); ++sf)
+              {
+                const typename DoFHandler<dim>::active_cell_iterator
+                neighbor = cell->neighbor_child_on_subface(f, sf);
+                neighbor->get_dof_indices (dof_indices[1]);
+                fe_subface_values.reinit (cell, f, sf);
+                fe_face_values_neighbor.reinit (neighbor,
+                                                cell->neighbor_of_neighbor(f));
+                const FEFaceValuesBase<dim> *face_values[2] =
+                {&fe_subface_values, &fe_face_values_neighbor};
+                add_face_terms (face_values, dof_indices, cell_matrix, matrix);
+              }
+          else if (cell->neighbor_is_coarser(f))
+            {
+              const typename DoFHandler<dim>::active_cell_iterator
+              neighbor = cell->neighbor(f);
+              neighbor->get_dof_indices (dof_indices[1]);
+              const std::pair<unsigned int,unsigned int> neighbor_face =
+                cell->neighbor_of_coarser_neighbor(f);
+              fe_face_values.reinit (cell, f);
+              fe_subface_values_neighbor.reinit (neighbor, neighbor_face.first,
+                                                 neighbor_face.second);
+              const FEFaceValuesBase<dim> *face_values[2] =
+              {&fe_face_values, &fe_subface_values_neighbor};
+              add_face_terms (face_values, dof_indices, cell_matrix, matrix);
+            }
+          else
+            {
+              const typename DoFHandler<dim>::active_cell_iterator
+              neighbor = cell->neighbor(f);
+              neighbor->get_dof_indices (dof_indices[1]);
+              fe_face_values.reinit (cell, f);
+              fe_face_values_neighbor.reinit (neighbor,
+                                              cell->neighbor_of_neighbor(f));
+              const FEFaceValuesBase<dim> *face_values[2] =
+              {&fe_face_values, &fe_face_values_neighbor};
+              add_face_terms (face_values, dof_indices, cell_matrix, matrix);
+            }
+        }
+    }
+}
+
+
+
+template <int dim>
+Point<dim> deform (const Point<dim> &p)
+{
+  Point<dim> q = p;
+  for (unsigned int d=0; d<dim; ++d)
+    q[d] += 0.05 * std::sin(numbers::PI * p[(d+1)%dim]);
+  return q;
+}
+
+
+
+template <int dim, int fe_degree>
+void test ()
+{
+  parallel::distributed::Triangulation<dim> tria (MPI_COMM_WORLD);
+  GridGenerator::subdivided_hyper_cube (tria, 3);
+  GridTools::transform (&deform<dim>, tria);
+  if (dim == 2)
+    tria.refine_global (1);
+  for (unsigned int cycle=0; cycle<2; ++cycle)
+    {
+      for (typename Triangulation<dim>::active_cell_iterator
+           cell=tria.begin_active(); cell != tria.end(); ++cell)
+        if (cell->is_locally_owned() &&
+            cell->center()[0] + 0.5*cell->center()[1] < 0.6 - 0.2*cycle)
+          cell->set_refine_flag();
+      tria.execute_coarsening_and_refinement();
+    }
+
+  FE_DGQ<dim> fe (fe_degree);
+  DoFHandler<dim> dof (tria);
+  dof.distribute_dofs (fe);
+  ConstraintMatrix constraints;
+  constraints.close();
+
+  deallog << "Testing " << fe.get_name() << std::endl;
+
+  MappingQGeneric<dim> mapping (1);
+  MatrixFree<dim,double> mf_data;
+  {
+    typename MatrixFree<dim,double>::AdditionalData data;
+    data.tasks_parallel_scheme = MatrixFree<dim,double>::AdditionalData::none;
+    data.mapping_update_flags_inner_faces = update_gradients | update_JxW_values;
+    data.mapping_update_flags_boundary_faces = update_gradients | update_JxW_values;
+    mf_data.reinit (mapping, dof, constraints, QGauss<1>(fe_degree+1), data);
+  }
+
+  LinearAlgebra::distributed::Vector<double> in, out, ref;
+  mf_data.initialize_dof_vector (in);
+  mf_data.initialize_dof_vector (out);
+  mf_data.initialize_dof_vector (ref);
+  for (unsigned int i=0; i<in.local_size(); ++i)
+    in.local_element(i) = Testing::rand()/(double)RAND_MAX;
+
+  LaplaceOperatorDG<dim,fe_degree> mf (mf_data);
+  mf.vmult (out, in);
+
+  const IndexSet &owned_set = dof.locally_owned_dofs();
+  IndexSet relevant_set;
+  DoFTools::extract_locally_relevant_dofs (dof, relevant_set);
+  DynamicSparsityPattern dsp (relevant_set);
+  DoFTools::make_flux_sparsity_pattern (dof, dsp);
+  SparsityTools::distribute_sparsity_pattern
+  (dsp, dof.n_locally_owned_dofs_per_processor(), MPI_COMM_WORLD,
+   relevant_set);
+  TrilinosWrappers::SparseMatrix sparse_matrix;
+  sparse_matrix.reinit (owned_set, owned_set, dsp, MPI_COMM_WORLD);
+  assemble_matrix (mapping, dof, sparse_matrix);
+  sparse_matrix.compress (VectorOperation::add);
+  sparse_matrix.vmult (ref, in);
+
+  out -= ref;
+  const double diff_norm = out.linfty_norm() / ref.linfty_norm();
+  deallog << "Norm of difference: " << diff_norm << std::endl << std::endl;
+}
+
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv, 1);
+
+  unsigned int myid = Utilities::MPI::this_mpi_process (MPI_COMM_WORLD);
+  deallog.push(Utilities::int_to_string(myid));
+
+  if (myid == 0)
+    {
+      std::ofstream logfile("output");
+      deallog.attach(logfile);
+      deallog.threshold_double(1.e-12);
+
+      deallog.push("2d");
+      test<2,1>();
+      test<2,2>();
+      test<2,3>();
+      deallog.pop();
+
+      deallog.push("3d");
+      test<3,1>();
+      test<3,2>();
+      deallog.pop();
+    }
+  else
+    {
+      test<2,1>();
+      test<2,2>();
+      test<2,3>();
+      test<3,1>();
+      test<3,2>();
+    }
+}
@@ -0,0 +1,174 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// tests MatrixFreeOperators::Base::multi_vmult for the mass and the Laplace
+// operator on an adaptively refined mesh with hanging nodes and Dirichlet
+// constraints against vmult applied to each vector
+
+#include "../tests.h"
+
+#include <deal.II/base/logstream.h>
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/function.h>
+#include <deal.II/distributed/tria.h>
+#include <deal.II/grid/grid_generator.h>
+#include <deal.II/dofs/dof_tools.h>
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/lac/constraint_matrix.h>
+#include <deal.II/matrix_free/operators.h>
+#include <deal.II/fe/fe_q.h>
+#include <deal.II/numerics/vector_tools.h>
+
+#include <iostream>
+
+
+
+template <typename OperatorType, typename VectorType>
+void check (const OperatorType            &mf,
+            const std::vector<VectorType> &src)
+{
+  const unsigned int n_vectors = src.size();
+  std::vector<VectorType> dst (n_vectors);
+  std::vector<VectorType *> dst_ptr (n_vectors);
+  std::vector<const VectorType *> src_ptr (n_vectors);
+  for (unsigned int v=0; v<n_vectors; ++v)
+    {
+      dst[v].reinit (src[v]);
+      dst_ptr[v] = &dst[v];
+      src_ptr[v] = &src[v];
+    }
+
+  mf.multi_vmult (dst_ptr, src_ptr);
+
+  VectorType reference (src[0]);
+  bool equal = true;
+  for (unsigned int v=0; v<n_vectors; ++v)
+    {
+      mf.vmult (reference, src[v]);
+      reference -= dst[v];
+      if (reference.linfty_norm() > 1e-12 * dst[v].linfty_norm())
+        equal = false;
+    }
+  deallog << "multi_vmult equal to vmult: " << equal << std::endl;
+}
+
+
+
+template <int dim, int fe_degree>
+void test ()
+{
+  typedef double number;
+
+  parallel::distributed::Triangulation<dim> tria (MPI_COMM_WORLD);
+  GridGenerator::hyper_cube (tria);
+  tria.refine_global(2);
+  typename Triangulation<dim>::active_cell_iterator
+  cell = tria.begin_active (),
+  endc = tria.end();
+  for (; cell!=endc; ++cell)
+    if (cell->is_locally_owned())
+      if (cell->center().norm()<0.3)
+        cell->set_refine_flag();
+  tria.execute_coarsening_and_refinement();
+
+  FE_Q<dim> fe (fe_degree);
+  DoFHandler<dim> dof (tria);
+  dof.distribute_dofs(fe);
+
+  IndexSet owned_set = dof.locally_owned_dofs();
+  IndexSet relevant_set;
+  DoFTools::extract_locally_relevant_dofs (dof, relevant_set);
+
+  ConstraintMatrix constraints (relevant_set);
+  DoFTools::make_hanging_node_constraints(dof, constraints);
+  VectorTools::interpolate_boundary_values (dof, 0, ZeroFunction<dim>(),
+                                            constraints);
+  constraints.close();
+
+  deallog << "Testing " << dof.get_fe().get_name() << std::endl;
+
+  std_cxx11::shared_ptr<MatrixFree<dim,number> > mf_data(new MatrixFree<dim,number> ());
+  {
+    const QGauss<1> quad (fe_degree+1);
+    typename MatrixFree<dim,number>::AdditionalData data;
+    data.tasks_parallel_scheme =
+      MatrixFree<dim,number>::AdditionalData::none;
+    mf_data->reinit (dof, constraints, quad, data);
+  }
+
+  // the vectors for several right hand sides, one with values also in the
+  // constrained entries
+  std::vector<LinearAlgebra::distributed::Vector<number> > src (5);
+  for (unsigned int v=0; v<src.size(); ++v)
+    {
+      mf_data->initialize_dof_vector (src[v]);
+      for (unsigned int i=0; i<src[v].local_size(); ++i)
+        {
+          const unsigned int glob_index =
+            owned_set.nth_index_in_set (i);
+          if (v > 0 && constraints.is_constrained(glob_index))
+            continue;
+          src[v].local_element(i) = (double)Testing::rand()/RAND_MAX;
+        }
+    }
+
+  deallog.push("Mass");
+  MatrixFreeOperators::MassOperator<dim,fe_degree,fe_degree+1,1,number> mass;
+  mass.initialize(mf_data);
+  check (mass, src);
+  deallog.pop();
+
+  deallog.push("Laplace");
+  MatrixFreeOperators::LaplaceOperator<dim,fe_degree,fe_degree+1,1,number> laplace;
+  laplace.initialize(mf_data);
+  check (laplace, src);
+  deallog.pop();
+}
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv, testing_max_num_threads());
+
+  unsigned int myid = Utilities::MPI::this_mpi_process (MPI_COMM_WORLD);
+  deallog.push(Utilities::int_to_string(myid));
+
+  if (myid == 0)
+    {
+      std::ofstream logfile("output");
+      deallog.attach(logfile);
+      deallog << std::setprecision(4);
+      deallog.threshold_double(1.e-10);
+
+      deallog.push("2d");
+      test<2,1>();
+      test<2,2>();
+      deallog.pop();
+
+      deallog.push("3d");
+      test<3,1>();
+      test<3,2>();
+      deallog.pop();
+    }
+  else
+    {
+      test<2,1>();
+      test<2,2>();
+      test<3,1>();
+      test<3,2>();
+    }
+}
@@ -0,0 +1,149 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// this function tests the correctness of the task graph scheme for thread
+// parallelization of the matrix-free class on adaptively refined meshes with
+// hanging nodes, and checks the consistency of the task graph
+
+#include "../tests.h"
+#include <deal.II/base/function.h>
+#include "create_mesh.h"
+
+std::ofstream logfile("output");
+
+#include "matrix_vector_common.h"
+
+
+template <int dim, int fe_degree, typename number>
+void sub_test()
+{
+  Triangulation<dim> tria;
+  create_mesh (tria);
+  tria.begin_active ()->set_refine_flag();
+  tria.execute_coarsening_and_refinement();
+  typename Triangulation<dim>::active_cell_iterator
+  cell = tria.begin_active (),
+  endc = tria.end();
+  for (; cell!=endc; ++cell)
+    if (cell->center().norm()<0.5)
+      cell->set_refine_flag();
+  tria.execute_coarsening_and_refinement();
+  if (dim < 3 || fe_degree < 2)
+    tria.refine_global(1);
+
+  FE_Q<dim> fe (fe_degree);
+  DoFHandler<dim> dof (tria);
+  deallog << "Testing " << fe.get_name() << std::endl;
+
+  // run test for several different meshes
+  for (unsigned int i=0; i<7-2*dim; ++i)
+    {
+      cell = tria.begin_active ();
+      endc = tria.end();
+      unsigned int counter = 0;
+      for (; cell!=endc; ++cell, ++counter)
+        if (counter % (9-i) == 0)
+          cell->set_refine_flag();
+      tria.execute_coarsening_and_refinement();
+
+      dof.distribute_dofs(fe);
+      ConstraintMatrix constraints;
+      DoFTools::make_hanging_node_constraints(dof, constraints);
+      VectorTools::interpolate_boundary_values (dof, 0, ZeroFunction<dim>(),
+                                                constraints);
+      constraints.close();
+
+      MatrixFree<dim,number> mf_data, mf_data_graph;
+      {
+        const QGauss<1> quad (fe_degree+1);
+        typename MatrixFree<dim,number>::AdditionalData data;
+        data.tasks_parallel_scheme =
+          MatrixFree<dim,number>::AdditionalData::none;
+        mf_data.reinit (dof, constraints, quad, data);
+
+        // choose block size of 3 which introduces some irregularity to the
+        // blocks
+        data.tasks_parallel_scheme =
+          MatrixFree<dim,number>::AdditionalData::task_graph;
+        data.tasks_block_size = 3;
+        mf_data_graph.reinit (dof, constraints, quad, data);
+      }
+
+      // check that all chunks appear once in the levels of the graph, that
+      // the dependencies point forward, and that the critical path is not
+      // longer than the whole loop
+      const internal::MatrixFreeFunctions::TaskInfo &task_info =
+        mf_data_graph.get_task_info();
+      if (task_info.use_multithreading)
+        {
+          unsigned int n_blocks = 0;
+          for (unsigned int l=0; l<task_info.task_graph_blocks_per_level.size(); ++l)
+            n_blocks += task_info.task_graph_blocks_per_level[l];
+          AssertThrow (n_blocks == task_info.n_blocks, ExcInternalError());
+          for (unsigned int b=0; b<task_info.n_blocks; ++b)
+            for (unsigned int j=task_info.task_graph_successors_row_index[b];
+                 j<task_info.task_graph_successors_row_index[b+1]; ++j)
+              AssertThrow (task_info.task_graph_successors[j] > b,
+                           ExcInternalError());
+          AssertThrow (task_info.task_graph_critical_path <=
+                       mf_data_graph.n_macro_cells(), ExcInternalError());
+          std::ostringstream statistics;
+          task_info.print_task_graph_statistics (statistics);
+          AssertThrow (statistics.str().size() > 0, ExcInternalError());
+        }
+      deallog << "Task graph consistent" << std::endl;
+
+      MatrixFreeTest<dim,fe_degree,number> mf_ref (mf_data);
+      MatrixFreeTest<dim,fe_degree,number> mf_graph (mf_data_graph);
+      Vector<number> in_dist (dof.n_dofs());
+      Vector<number> out_dist (in_dist), out_graph (in_dist);
+
+      for (unsigned int i=0; i<dof.n_dofs(); ++i)
+        {
+          if (constraints.is_constrained(i))
+            continue;
+          const double entry = Testing::rand()/(double)RAND_MAX;
+          in_dist(i) = entry;
+        }
+
+      mf_ref.vmult (out_dist, in_dist);
+
+      // make 5 sweeps in order to get in some variation to the threaded
+      // program
+      for (unsigned int sweep = 0; sweep < 5; ++sweep)
+        {
+          mf_graph.vmult (out_graph, in_dist);
+          out_graph -= out_dist;
+          deallog << "Sweep " << sweep
+                  << ", error in task graph: " << out_graph.linfty_norm()
+                  << std::endl;
+        }
+      deallog << std::endl;
+    }
+  deallog << std::endl;
+}
+
+
+template <int dim, int fe_degree>
+void test ()
+{
+  deallog << "Test doubles" << std::endl;
+  sub_test<dim,fe_degree,double>();
+  deallog.threshold_double(2.e-6);
+  deallog << "Test floats" << std::endl;
+  sub_test<dim,fe_degree,float>();
+}
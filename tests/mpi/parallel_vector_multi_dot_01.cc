@@ -0,0 +1,122 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2012 - 2016 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+// check LinearAlgebra::distributed::Vector::multi_dot and
+// LinearAlgebra::distributed::Vector::multi_add against the individual
+// operations, including the update of ghost values in multi_add
+
+#include "../tests.h"
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/index_set.h>
+#include <deal.II/lac/la_parallel_vector.h>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+
+void test ()
+{
+  const unsigned int myid = Utilities::MPI::this_mpi_process (MPI_COMM_WORLD);
+  const unsigned int numproc = Utilities::MPI::n_mpi_processes (MPI_COMM_WORLD);
+
+  if (myid==0) deallog << "numproc=" << numproc << std::endl;
+
+  const unsigned int local_size = 1003;
+  const unsigned int global_size = local_size * numproc;
+  IndexSet local_owned (global_size);
+  local_owned.add_range (myid*local_size, (myid+1)*local_size);
+  IndexSet local_relevant (global_size);
+  local_relevant = local_owned;
+  local_relevant.add_index ((myid*local_size + local_size + 7) % global_size);
+
+  LinearAlgebra::distributed::Vector<double> v (local_owned, local_relevant,
+                                                MPI_COMM_WORLD);
+  for (unsigned int i=0; i<local_size; ++i)
+    v.local_element(i) = 0.1 + 0.005 * (myid*local_size+i);
+
+  for (unsigned int n_vectors=1; n_vectors<7; n_vectors+=2)
+    {
+      std::vector<LinearAlgebra::distributed::Vector<double> > w (n_vectors);
+      std::vector<const LinearAlgebra::distributed::Vector<double> *> w_ptr (n_vectors);
+      std::vector<double> factors (n_vectors);
+      for (unsigned int k=0; k<n_vectors; ++k)
+        {
+          w[k].reinit (v);
+          for (unsigned int i=0; i<local_size; ++i)
+            w[k].local_element(i) = 3.14159 + 2.7183/(1.+myid*local_size+i+k);
+          w_ptr[k] = &w[k];
+          factors[k] = 0.01432 * (1.+k);
+        }
+
+      std::vector<double> products (n_vectors);
+      v.multi_dot (w_ptr, products);
+      bool identical = true;
+      for (unsigned int k=0; k<n_vectors; ++k)
+        if (products[k] != v * w[k])
+          identical = false;
+
+      LinearAlgebra::distributed::Vector<double> check (v);
+      for (unsigned int k=0; k<n_vectors; ++k)
+        check.add (factors[k], w[k]);
+
+      v.update_ghost_values ();
+      v.multi_add (factors, w_ptr);
+      check.update_ghost_values ();
+      bool ghosts_equal = true;
+      for (unsigned int i=0; i<local_relevant.n_elements(); ++i)
+        {
+          const types::global_dof_index index =
+            local_relevant.nth_index_in_set(i);
+          if (std::abs(check(index) - v(index)) > 1e-12 * std::abs(v(index)))
+            ghosts_equal = false;
+        }
+      v.zero_out_ghosts ();
+      check.zero_out_ghosts ();
+      check -= v;
+      const bool add_equal = check.linfty_norm() < 1e-12 * v.linfty_norm();
+      ghosts_equal = Utilities::MPI::min (static_cast<int>(ghosts_equal),
+                                          MPI_COMM_WORLD);
+
+      if (myid == 0)
+        deallog << n_vectors << " vectors: multi_dot identical: "
+                << identical << ", multi_add difference: "
+                << add_equal << ", ghosts equal: " << ghosts_equal
+                << std::endl;
+    }
+}
+
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv, testing_max_num_threads());
+
+  unsigned int myid = Utilities::MPI::this_mpi_process (MPI_COMM_WORLD);
+  deallog.push(Utilities::int_to_string(myid));
+
+  if (myid == 0)
+    {
+      std::ofstream logfile("output");
+      deallog.attach(logfile);
+      deallog << std::setprecision(4);
+      deallog.threshold_double(1.e-10);
+
+      test();
+    }
+  else
+    test();
+
+}
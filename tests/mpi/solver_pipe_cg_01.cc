@@ -0,0 +1,174 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// tests SolverPipeCG with LinearAlgebra::distributed::Vector, where the
+// vector updates and inner products are merged and the reduction is
+// non-blocking, on a five-point stencil distributed by rows of grid points,
+// compared to SolverCG. The iteration numbers may differ by roundoff between
+// different numbers of processors
+
+#include "../tests.h"
+#include <deal.II/base/utilities.h>
+#include <deal.II/base/index_set.h>
+#include <deal.II/lac/la_parallel_vector.h>
+#include <deal.II/lac/diagonal_matrix.h>
+#include <deal.II/lac/precondition.h>
+#include <deal.II/lac/solver_control.h>
+#include <deal.II/lac/solver_cg.h>
+#include <deal.II/lac/solver_pipe_cg.h>
+#include <fstream>
+#include <iostream>
+
+
+typedef LinearAlgebra::distributed::Vector<double> VectorType;
+
+
+// the five-point stencil on an n x n grid of interior points with the grid
+// points numbered row by row
+class Laplace2D
+{
+public:
+  Laplace2D (const unsigned int n,
+             const std_cxx11::shared_ptr<const Utilities::MPI::Partitioner> &partitioner)
+    :
+    n (n),
+    partitioner (partitioner)
+  {}
+
+  void vmult (VectorType       &dst,
+              const VectorType &src) const
+  {
+    src.update_ghost_values();
+    const std::pair<types::global_dof_index,types::global_dof_index> range =
+      partitioner->local_range();
+    for (types::global_dof_index i=range.first; i<range.second; ++i)
+      {
+        const unsigned int row = i / n, column = i % n;
+        double value = 4. * src(i);
+        if (row > 0)
+          value -= src(i-n);
+        if (row < n-1)
+          value -= src(i+n);
+        if (column > 0)
+          value -= src(i-1);
+        if (column < n-1)
+          value -= src(i+1);
+        dst(i) = value;
+      }
+    const_cast<VectorType &>(src).zero_out_ghosts();
+  }
+
+private:
+  const unsigned int n;
+  const std_cxx11::shared_ptr<const Utilities::MPI::Partitioner> partitioner;
+};
+
+
+
+template <typename PreconditionerType>
+void check (const Laplace2D          &A,
+            const VectorType         &rhs,
+            const PreconditionerType &preconditioner,
+            const unsigned int        min_iterations,
+            const unsigned int        max_iterations)
+{
+  VectorType reference (rhs), sol (rhs);
+  reference = 0.;
+
+  SolverControl control (1000, 1e-10*rhs.l2_norm());
+  SolverCG<VectorType> solver_cg (control);
+  check_solver_within_range (solver_cg.solve (A, reference, rhs, preconditioner),
+                             control.last_step(), min_iterations, max_iterations);
+
+  for (unsigned int v=0; v<2; ++v)
+    {
+      sol = 0.;
+      SolverPipeCG<VectorType> solver
+      (control, SolverPipeCG<VectorType>::AdditionalData
+       (v == 0 ? SolverPipeCG<VectorType>::AdditionalData::pipelined :
+        SolverPipeCG<VectorType>::AdditionalData::single_reduction));
+      check_solver_within_range (solver.solve (A, sol, rhs, preconditioner),
+                                 control.last_step(), min_iterations, max_iterations);
+      sol -= reference;
+      deallog << "Difference to CG solution "
+              << (v == 0 ? "pipelined" : "single reduction") << ": "
+              << (sol.linfty_norm() < 1e-8*reference.linfty_norm()) << std::endl;
+    }
+}
+
+
+
+void test ()
+{
+  const unsigned int myid = Utilities::MPI::this_mpi_process (MPI_COMM_WORLD);
+  const unsigned int numproc = Utilities::MPI::n_mpi_processes (MPI_COMM_WORLD);
+
+  // distribute the rows of the grid evenly, each processor needs the last
+  // row of the previous processor and the first row of the next one
+  const unsigned int n = 40;
+  const unsigned int rows_begin = myid*n/numproc, rows_end = (myid+1)*n/numproc;
+  IndexSet owned (n*n), ghosts (n*n);
+  owned.add_range (rows_begin*n, rows_end*n);
+  if (rows_begin > 0 && rows_end > rows_begin)
+    ghosts.add_range ((rows_begin-1)*n, rows_begin*n);
+  if (rows_end < n && rows_end > rows_begin)
+    ghosts.add_range (rows_end*n, (rows_end+1)*n);
+
+  std_cxx11::shared_ptr<const Utilities::MPI::Partitioner> partitioner
+  (new Utilities::MPI::Partitioner (owned, ghosts, MPI_COMM_WORLD));
+  Laplace2D A (n, partitioner);
+
+  VectorType rhs (partitioner);
+  for (unsigned int i=0; i<rhs.local_size(); ++i)
+    rhs.local_element(i) = 1. + 0.1 * (owned.nth_index_in_set(i) % 7);
+
+  deallog.push("Identity");
+  check (A, rhs, PreconditionIdentity(), 110, 125);
+  deallog.pop();
+
+  // a Jacobi preconditioner with varying weights
+  deallog.push("Diagonal");
+  DiagonalMatrix<VectorType> diagonal;
+  diagonal.get_vector().reinit (partitioner);
+  for (unsigned int i=0; i<diagonal.get_vector().local_size(); ++i)
+    diagonal.get_vector().local_element(i) =
+      0.25 / (1. + 0.5 * ((owned.nth_index_in_set(i)/n) % 3));
+  check (A, rhs, diagonal, 140, 160);
+  deallog.pop();
+}
+
+
+
+int main (int argc, char **argv)
+{
+  Utilities::MPI::MPI_InitFinalize mpi_initialization (argc, argv, testing_max_num_threads());
+
+  const unsigned int myid = Utilities::MPI::this_mpi_process (MPI_COMM_WORLD);
+  deallog.push(Utilities::int_to_string(myid));
+
+  if (myid == 0)
+    {
+      std::ofstream logfile("output");
+      deallog.attach(logfile);
+      deallog << std::setprecision(4);
+      deallog.threshold_double(1.e-10);
+
+      test();
+    }
+  else
+    test();
+}
@@ -0,0 +1,142 @@
+// ---------------------------------------------------------------------
+//
+// Copyright (C) 2017 by the deal.II authors
+//
+// This file is part of the deal.II library.
+//
+// The deal.II library is free software; you can use it, redistribute
+// it, and/or modify it under the terms of the GNU Lesser General
+// Public License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// The full text of the license can be found in the file LICENSE at
+// the top level of the deal.II distribution.
+//
+// ---------------------------------------------------------------------
+
+
+
+// Check MGTransferMatrixFree::interpolate_to_mg on adaptively refined meshes
+// by interpolating a polynomial that is exactly represented by the finite
+// element from a vector in double precision to level vectors in double and
+// single precision and comparing the level values to the function values at
+// the support points of the level cells
+
+#include "../tests.h"
+#include <deal.II/base/logstream.h>
+#include <deal.II/base/function.h>
+#include <deal.II/lac/la_parallel_vector.h>
+#include <deal.II/lac/constraint_matrix.h>
+#include <deal.II/dofs/dof_tools.h>
+#include <deal.II/grid/tria.h>
+#include <deal.II/grid/grid_generator.h>
+#include <deal.II/fe/fe_q.h>
+#include <deal.II/fe/fe_dgq.h>
+#include <deal.II/fe/mapping_q_generic.h>
+#include <deal.II/numerics/vector_tools.h>
+#include <deal.II/multigrid/mg_transfer_matrix_free.h>
+
+
+template <int dim>
+class Polynomial : public Function<dim>
+{
+public:
+  Polynomial (const unsigned int degree)
+    :
+    degree (degree)
+  {}
+
+  virtual double value (const Point<dim> &p,
+                        const unsigned int) const
+  {
+    double result = 0.3;
+    for (unsigned int d=0; d<dim; ++d)
+      result += std::pow(p[d], (int)degree) * (d+1);
+    result += 0.5 * p[0] * p[dim-1];
+    return result;
+  }
+
+private:
+  const unsigned int degree;
+};
+
+
+
+template <int dim, typename Number>
+void check(const FiniteElement<dim> &fe)
+{
+  deallog << "FE: " << fe.get_name() << ", level vectors of size "
+          << sizeof(Number) << std::endl;
+
+  Triangulation<dim> tr(Triangulation<dim>::limit_level_difference_at_vertices);
+  GridGenerator::hyper_cube(tr, -1, 1);
+  tr.refine_global(4-dim);
+  for (unsigned int cycle=0; cycle<2; ++cycle)
+    {
+      for (typename Triangulation<dim>::active_cell_iterator cell=tr.begin_active();
+           cell != tr.end(); ++cell)
+        if (cell->center()[0] < 0 && cell->center().norm() < 0.9/(cycle+1))
+          cell->set_refine_flag();
+      tr.execute_coarsening_and_refinement();
+    }
+  deallog << "no. cells: " << tr.n_active_cells() << std::endl;
+
+  DoFHandler<dim> mgdof(tr);
+  mgdof.distribute_dofs(fe);
+  mgdof.distribute_mg_dofs(fe);
+
+  ConstraintMatrix hanging_node_constraints;
+  DoFTools::make_hanging_node_constraints(mgdof, hanging_node_constraints);
+  hanging_node_constraints.close();
+
+  const Polynomial<dim> function(fe.degree);
+  LinearAlgebra::distributed::Vector<double> fine(mgdof.n_dofs());
+  VectorTools::interpolate(mgdof, function, fine);
+  hanging_node_constraints.distribute(fine);
+
+  MGTransferMatrixFree<dim,Number> transfer;
+  transfer.build(mgdof);
+
+  MGLevelObject<LinearAlgebra::distributed::Vector<Number> >
+  level_vectors(0, tr.n_global_levels()-1);
+  transfer.interpolate_to_mg(mgdof, level_vectors, fine);
+
+  const MappingQGeneric<dim> mapping(1);
+  const std::vector<Point<dim> > &unit_points = fe.get_unit_support_points();
+  std::vector<types::global_dof_index> dof_indices(fe.dofs_per_cell);
+  for (unsigned int level=0; level<tr.n_global_levels(); ++level)
+    {
+      double error = 0;
+      for (typename DoFHandler<dim>::cell_iterator cell=mgdof.begin(level);
+           cell != mgdof.end(level); ++cell)
+        {
+          cell->get_mg_dof_indices(dof_indices);
+          for (unsigned int i=0; i<fe.dofs_per_cell; ++i)
+            {
+              const Point<dim> p =
+                mapping.transform_unit_to_real_cell(cell, unit_points[i]);
+              error = std::max(error,
+                               std::abs(function.value(p, 0) -
+                                        (double)level_vectors[level](dof_indices[i])));
+            }
+        }
+      deallog << "Error level " << level << ": "
+              << (error < 10.*std::numeric_limits<Number>::epsilon() ?
+                  0. : error) << std::endl;
+    }
+  deallog << std::endl;
+}
+
+
+int main()
+{
+  initlog();
+
+  check<2,double>(FE_Q<2>(1));
+  check<2,float>(FE_Q<2>(1));
+  check<2,float>(FE_Q<2>(2));
+  check<2,float>(FE_Q<2>(3));
+  check<2,float>(FE_DGQ<2>(2));
+  check<3,double>(FE_Q<3>(1));
+  check<3,float>(FE_Q<3>(2));
+  check<3,float>(FE_DGQ<3>(1));
+}